@@ -15,14 +15,36 @@
 #include "modem.h"
 #ifdef ENABLE_LEVEL2
 #include "telnet.h"
+#include "passthru.h"
 #endif
 #include "datalog.h"
 #include "timestamp.h"
 #include "echo.h"
+#include "bufpool.h"
+#include "metrics.h"
+#include "latency.h"
+#include "timerwheel.h"
+#include "xfer.h"
+#include "rtsched.h"
 #include <pthread.h>
+#include <stdalign.h>
+#include <stdatomic.h>
 #include <time.h>
 
 
+/* PRECONNECT_ON_RING: close the early telnet session if no CONNECT follows
+ * (same limit modem_wait_for_ring_enhanced() allows between RING and CONNECT) */
+#define BRIDGE_PRECONNECT_TIMEOUT   30
+
+/* Per-line timers on the wheel of the thread serving the line */
+typedef enum {
+    BRIDGE_TIMER_SERIAL = 0,            /* Startup health check, S12 escape guard */
+    BRIDGE_TIMER_SERIAL_TX,             /* Serial driver FIFO refill */
+    BRIDGE_TIMER_TIMESTAMP,             /* Level 1 timestamps */
+    BRIDGE_TIMER_TELNET,                /* Connect progress, pre-connect hold, cork window */
+    BRIDGE_TIMER_COUNT
+} bridge_timer_id_t;
+
 /* ANSI escape sequence states */
 typedef enum {
     ANSI_STATE_NORMAL,          /* Normal text */
@@ -33,18 +55,41 @@ typedef enum {
 
 /* Circular buffer for data transfer */
 typedef struct {
-    unsigned char data[BUFFER_SIZE];
+    unsigned char *data;                /* Slab chunk (see bufpool.h) */
+    size_t size;                        /* Capacity in bytes */
     size_t read_pos;
     size_t write_pos;
     size_t count;
 } circular_buffer_t;
 
-/* Thread-safe circular buffer for multithread mode */
+/* Thread-safe ring for multithread mode (single producer / single consumer) */
+#define CACHE_LINE_SIZE     64
+
 typedef struct {
-    circular_buffer_t cbuf;             /* Underlying circular buffer */
-    pthread_mutex_t mutex;              /* Buffer access synchronization */
-    pthread_cond_t cond_not_empty;      /* Data available signal */
-    pthread_cond_t cond_not_full;       /* Space available signal */
+    /* Producer side (written by producer only) */
+    alignas(CACHE_LINE_SIZE) atomic_size_t head;   /* Free-running write index */
+    pthread_mutex_t producer_lock;      /* Serializes extra producers (uncontended in SPSC use) */
+
+    /* Consumer side (written by consumer only) */
+    alignas(CACHE_LINE_SIZE) atomic_size_t tail;   /* Free-running read index */
+    pthread_mutex_t consumer_lock;      /* Serializes extra consumers (uncontended in SPSC use) */
+
+    /* Wakeups */
+    alignas(CACHE_LINE_SIZE) atomic_int data_waiters;  /* Consumers/event loops waiting for data */
+    atomic_int space_waiters;           /* Producers waiting for space */
+    int data_fd;                        /* eventfd: data arrived in an empty ring */
+    int space_fd;                       /* eventfd: space freed in a full ring */
+
+    /* Storage (fixed between ts_cbuf_init() and ts_cbuf_destroy()) */
+    alignas(CACHE_LINE_SIZE) unsigned char *data;  /* Slab chunk (see bufpool.h) */
+    size_t capacity;                    /* Power of two */
+    size_t mask;                        /* capacity - 1 */
+    atomic_size_t limit;                /* Producer fill limit (<= capacity, follows line rate) */
+
+    /* Metrics (optional, see metrics.h) */
+    metrics_direction_t *metrics;       /* Counters updated on every read (NULL = off) */
+    atomic_uint_fast64_t burst_ns;      /* Arrival of the oldest unread burst (0 = none) */
+    latency_tags_t tags;                /* Ingress stamps of the queued chunks */
 } ts_circular_buffer_t;
 
 /* Bridge context structure */
@@ -59,6 +104,10 @@ typedef struct {
   #ifdef ENABLE_LEVEL2
     /* Telnet connection */
     telnet_t telnet;
+
+    /* PRECONNECT_ON_RING: telnet opened while the modem answers */
+    atomic_bool preconnect_hold;        /* Server data stays in the socket until CONNECT */
+    time_t preconnect_time;             /* RING that started the early connect */
 #endif
 
     /* State */
@@ -79,9 +128,8 @@ typedef struct {
     int serial_retry_interval;   /* Serial retry interval in seconds (default 10) */
     int serial_retry_count;      /* Number of serial retry attempts (for logging) */
 
-    /* Data buffers */
-    circular_buffer_t serial_to_telnet_buf;
-    circular_buffer_t telnet_to_serial_buf;
+    /* Data buffer size: BUFFER_SIZE from config, or sized for the serial rate */
+    size_t buffer_size;
 
     /* Thread handles (multithread mode) */
     pthread_t serial_thread;
@@ -91,6 +139,7 @@ typedef struct {
 #ifdef ENABLE_LEVEL3
     pthread_t level3_thread;
 #endif
+    rtsched_status_t thread_sched[RTSCHED_ROLE_COUNT];  /* Effective placement per thread role */
 
     /* Thread-safe buffers (will replace circular_buffer_t in multithread mode) */
     ts_circular_buffer_t ts_serial_to_telnet_buf;
@@ -103,6 +152,29 @@ typedef struct {
     /* Thread control */
     bool thread_running;                /* Thread execution flag */
 
+    /* Multi-line mode: I/O driven by a shared worker pool instead of own threads */
+    int line_id;                        /* [line.N] this bridge serves (0 = single line) */
+    bool use_worker_pool;               /* Skip serial/telnet thread creation */
+    int poll_timeout_ms;                /* Wait per poll pass (100 for threads, 0 for workers) */
+    bool serial_health_checked;         /* Startup serial health check performed */
+    bool serial_was_online;             /* Modem online at previous serial poll */
+
+    /* Event-driven mode (EVENT_LOOP=1): one thread blocks on every source */
+    pthread_t event_thread;
+    bool event_thread_started;
+    int event_epoll_fd;                 /* Serial fd, telnet socket, wake_fd and timer_fd */
+    int wake_fd;                        /* eventfd: shutdown, serial reopen, telnet connect */
+    int timer_fd;                       /* timerfd armed for event_wheel */
+    timerwheel_t event_wheel;           /* Timers of the event thread */
+    int event_serial_fd;                /* Serial fd registered with event_epoll_fd (-1 = none) */
+    int event_telnet_fd;                /* Telnet fd registered with event_epoll_fd (-1 = none) */
+    uint32_t event_telnet_events;       /* Events requested for event_telnet_fd */
+    bool event_queue_watched;           /* Waiting on ts_telnet_to_serial_buf eventfd */
+
+    /* Deadlines of this line (event thread or multi-line worker) */
+    timerwheel_t *timer_wheel;          /* Wheel of the serving thread (NULL = polled threads) */
+    timerwheel_timer_t timers[BRIDGE_TIMER_COUNT];
+
     /* Client connection status (Level 1) */
     bool client_data_received;          /* Flag: true after receiving first data from client */
 
@@ -112,16 +184,26 @@ typedef struct {
     /* Echo functionality control (Level 1) */
     echo_ctrl_t echo;
 
-    /* Multibyte character handling */
-    unsigned char mb_buffer[4];     /* Partial multibyte sequence */
-    size_t mb_len;                  /* Current partial length */
+    /* Character set transcoding (partial multibyte sequences live in the converters) */
+    charset_conv_t charset_to_serial;   /* Server -> terminal (telnet thread) */
+    charset_conv_t charset_to_telnet;   /* Terminal -> server (telnet thread, Level 3 thread) */
+
+    /* File transfers: raw mode while XMODEM/YMODEM/ZMODEM runs */
+    xfer_detect_t xfer;
+
+#ifdef ENABLE_LEVEL2
+    /* SPLICE_PASSTHROUGH: transparent directions moved by the kernel */
+    passthru_t passthru;
+#endif
 
     /* ANSI processing for modem -> telnet direction */
     ansi_state_t ansi_filter_state;
+    bool ansi_overflow_warned;          /* Truncation already logged for this line */
     char ansi_buffer[SMALL_BUFFER_SIZE];
     size_t ansi_buffer_len;
 
     /* Statistics */
+    metrics_line_t *metrics;            /* Exported per-line counters (NULL = metrics off) */
     uint64_t bytes_serial_to_telnet;
     uint64_t bytes_telnet_to_serial;
     time_t connection_start_time;
@@ -207,6 +289,14 @@ int bridge_handle_modem_connect(bridge_ctx_t *ctx);
 int bridge_handle_modem_disconnect(bridge_ctx_t *ctx);
 
 #ifdef ENABLE_LEVEL2
+/**
+ * Open the telnet session of a call (Level 2 only)
+ * @param ctx Bridge context
+ * @param target Dialing directory target (NULL = DIAL_DEFAULT, else TELNET_HOST)
+ * @return SUCCESS when the connect is running or done, error code otherwise
+ */
+int bridge_telnet_connect(bridge_ctx_t *ctx, dialdir_target_t *target);
+
 /**
  * Handle telnet connection establishment (Level 2 only)
  * @param ctx Bridge context
@@ -233,8 +323,16 @@ void bridge_print_stats(bridge_ctx_t *ctx);
 /**
  * Initialize circular buffer
  * @param buf Circular buffer structure
+ * @param size Capacity in bytes (rounded up to a bufpool size class)
+ * @return SUCCESS on success, ERROR_GENERAL if no buffer could be allocated
+ */
+int cbuf_init(circular_buffer_t *buf, size_t size);
+
+/**
+ * Release circular buffer storage
+ * @param buf Circular buffer structure
  */
-void cbuf_init(circular_buffer_t *buf);
+void cbuf_destroy(circular_buffer_t *buf);
 
 /**
  * Write data to circular buffer
@@ -282,6 +380,37 @@ bool cbuf_is_empty(circular_buffer_t *buf);
  */
 bool cbuf_is_full(circular_buffer_t *buf);
 
+/**
+ * Reserve contiguous free space for in-place writes
+ * @param buf Circular buffer structure
+ * @param len Maximum bytes wanted
+ * @param granted Output: bytes available at the returned pointer
+ * @return Pointer into buffer memory
+ */
+unsigned char *cbuf_reserve(circular_buffer_t *buf, size_t len, size_t *granted);
+
+/**
+ * Commit bytes written into a reserved span
+ * @param buf Circular buffer structure
+ * @param n Bytes to commit (<= granted)
+ */
+void cbuf_commit(circular_buffer_t *buf, size_t n);
+
+/**
+ * Peek at contiguous readable data without copying
+ * @param buf Circular buffer structure
+ * @param len Output: bytes readable at the returned pointer
+ * @return Pointer into buffer memory
+ */
+const unsigned char *cbuf_peek(circular_buffer_t *buf, size_t *len);
+
+/**
+ * Drop bytes from the front of the buffer
+ * @param buf Circular buffer structure
+ * @param n Bytes consumed
+ */
+void cbuf_consume(circular_buffer_t *buf, size_t n);
+
 /**
  * Clear circular buffer
  * @param buf Circular buffer structure
@@ -299,7 +428,7 @@ void cbuf_clear(circular_buffer_t *buf);
  * @param output_size Output buffer size
  * @param output_len Pointer to store actual output length
  * @param state ANSI parser state (maintained across calls)
- * @return SUCCESS on success, error code on failure
+ * @return SUCCESS, ERROR_BUFFER_FULL if output was truncated, error code on failure
  */
 int ansi_filter_modem_to_telnet(const unsigned char *input, size_t input_len,
                                 unsigned char *output, size_t output_size,
@@ -354,8 +483,10 @@ bool is_valid_utf8_sequence(const unsigned char *seq, size_t len);
 /**
  * Initialize thread-safe circular buffer
  * @param tsbuf Thread-safe circular buffer structure
+ * @param capacity Capacity in bytes (rounded up to a bufpool size class)
+ * @return SUCCESS on success, ERROR_GENERAL if no buffer could be allocated
  */
-void ts_cbuf_init(ts_circular_buffer_t *tsbuf);
+int ts_cbuf_init(ts_circular_buffer_t *tsbuf, size_t capacity);
 
 /**
  * Destroy thread-safe circular buffer (cleanup mutexes and condition variables)
@@ -372,6 +503,17 @@ void ts_cbuf_destroy(ts_circular_buffer_t *tsbuf);
  */
 size_t ts_cbuf_write(ts_circular_buffer_t *tsbuf, const unsigned char *data, size_t len);
 
+/**
+ * Write a chunk stamped with its ingress time (non-blocking, see latency.h)
+ * @param tsbuf Thread-safe circular buffer structure
+ * @param data Data to write
+ * @param len Data length
+ * @param ingress_ns latency_now_ns() when the chunk's read returned (0 = untagged)
+ * @return Number of bytes written (may be less than len if buffer is full)
+ */
+size_t ts_cbuf_write_stamped(ts_circular_buffer_t *tsbuf, const unsigned char *data, size_t len,
+                             uint64_t ingress_ns);
+
 /**
  * Read data from thread-safe circular buffer (non-blocking)
  * @param tsbuf Thread-safe circular buffer structure
@@ -417,8 +559,194 @@ bool ts_cbuf_is_empty(ts_circular_buffer_t *tsbuf);
  */
 size_t ts_cbuf_available(ts_circular_buffer_t *tsbuf);
 
+/**
+ * Reserve contiguous free space so data can be written in place (zero-copy)
+ * Must be followed by ts_cbuf_commit() on the same thread, even with n=0.
+ * The span ends at the ring boundary, so *granted may be less than free space.
+ * @param tsbuf Thread-safe circular buffer structure
+ * @param len Maximum bytes wanted
+ * @param granted Output: bytes available at the returned pointer (may be 0)
+ * @return Pointer into ring memory
+ */
+unsigned char *ts_cbuf_reserve(ts_circular_buffer_t *tsbuf, size_t len, size_t *granted);
+
+/**
+ * Publish bytes written into a reserved span and end the reservation
+ * @param tsbuf Thread-safe circular buffer structure
+ * @param n Bytes to publish (<= granted)
+ */
+void ts_cbuf_commit(ts_circular_buffer_t *tsbuf, size_t n);
+
+/**
+ * Publish a stamped chunk written into a reserved span and end the reservation
+ * @param tsbuf Thread-safe circular buffer structure
+ * @param n Bytes to publish (<= granted)
+ * @param ingress_ns latency_now_ns() when the chunk's read returned (0 = untagged)
+ */
+void ts_cbuf_commit_stamped(ts_circular_buffer_t *tsbuf, size_t n, uint64_t ingress_ns);
+
+/**
+ * Peek at contiguous readable data without copying
+ * Must be followed by ts_cbuf_consume() on the same thread, even with n=0.
+ * @param tsbuf Thread-safe circular buffer structure
+ * @param len Output: bytes readable at the returned pointer (may be 0)
+ * @return Pointer into ring memory
+ */
+const unsigned char *ts_cbuf_peek(ts_circular_buffer_t *tsbuf, size_t *len);
+
+/**
+ * Drop bytes from a peeked span and end the peek
+ * @param tsbuf Thread-safe circular buffer structure
+ * @param n Bytes consumed (<= peeked length)
+ */
+void ts_cbuf_consume(ts_circular_buffer_t *tsbuf, size_t n);
+
+/**
+ * Stamp for the bytes the consumer is about to take (consumer side)
+ * @param tsbuf Thread-safe circular buffer structure
+ * @param stamp Receives the oldest queued ingress and the hand-off time
+ */
+void ts_cbuf_stamp(ts_circular_buffer_t *tsbuf, latency_stamp_t *stamp);
+
+/**
+ * Get eventfd that becomes readable when data arrives in an empty buffer
+ * Only signalled while a waiter is registered (see ts_cbuf_watch()).
+ * @param tsbuf Thread-safe circular buffer structure
+ * @return eventfd, or -1 if unavailable
+ */
+int ts_cbuf_get_event_fd(ts_circular_buffer_t *tsbuf);
+
+/**
+ * Register or unregister an event loop waiting on ts_cbuf_get_event_fd()
+ * @param tsbuf Thread-safe circular buffer structure
+ * @param enable true to register, false to unregister
+ */
+void ts_cbuf_watch(ts_circular_buffer_t *tsbuf, bool enable);
+
+/**
+ * Limit how much the producer may queue (thread-safe)
+ * Data already queued above a lowered limit drains normally.
+ * @param tsbuf Thread-safe circular buffer structure
+ * @param limit Fill limit in bytes (0 or above capacity = capacity)
+ */
+void ts_cbuf_set_limit(ts_circular_buffer_t *tsbuf, size_t limit);
+
+/**
+ * Attach per-direction metrics (call before the ring is shared)
+ * Reads then update byte, backlog and queueing-latency counters, and
+ * stamped chunks feed the stage histograms.
+ * @param tsbuf Thread-safe circular buffer structure
+ * @param metrics Direction counters (NULL = off)
+ */
+void ts_cbuf_set_metrics(ts_circular_buffer_t *tsbuf, metrics_direction_t *metrics);
+
+/**
+ * Wake all threads blocked in the timeout functions (shutdown)
+ * @param tsbuf Thread-safe circular buffer structure
+ */
+void ts_cbuf_wake(ts_circular_buffer_t *tsbuf);
+
 /* Thread functions for multithread mode */
 
+#if !defined(ENABLE_LEVEL2) || defined(ENABLE_LEVEL3)
+#define BRIDGE_HAS_SERIAL_POLL 1        /* Serial/Modem pass built (Level 1 and Level 3) */
+
+/**
+ * Run one serial/modem pass (body of the serial/modem thread)
+ * Waits at most ctx->poll_timeout_ms for serial input.
+ * @param ctx Bridge context
+ * @return Suggested idle time in microseconds before the next pass (0 = run again now)
+ */
+useconds_t bridge_serial_poll(bridge_ctx_t *ctx);
+#endif
+
+#ifdef ENABLE_LEVEL2
+/**
+ * Run one telnet pass (body of the telnet thread)
+ * Waits at most ctx->poll_timeout_ms while a connect is in progress.
+ * @param ctx Bridge context
+ * @return Suggested idle time in microseconds before the next pass (0 = run again now)
+ */
+useconds_t bridge_telnet_poll(bridge_ctx_t *ctx);
+
+/**
+ * Epoll events an event loop should wait for on the telnet socket
+ * @param ctx Bridge context
+ * @return EPOLLIN, plus EPOLLOUT while connecting; none while a RING
+ *         pre-connect holds server data back
+ */
+uint32_t bridge_telnet_events(bridge_ctx_t *ctx);
+
+/**
+ * Send terminal data to the telnet server in raw mode (file transfers)
+ * Only escapes IAC (nothing for a TELNET_RAW peer); takes no more input than
+ * the output queue holds.
+ * @param ctx Bridge context
+ * @param data Data from the terminal
+ * @param len Data length
+ * @param stamp Ingress stamp of the data (NULL = untagged, see latency.h)
+ * @return Input bytes taken (the rest stays with the caller), -1 on send error
+ */
+ssize_t bridge_send_raw(bridge_ctx_t *ctx, const unsigned char *data, size_t len,
+                        const latency_stamp_t *stamp);
+#endif
+
+/**
+ * Event-driven bridge thread (EVENT_LOOP=1)
+ * Replaces the serial and telnet threads with one thread that blocks on an
+ * epoll set of the serial fd, telnet socket, wake eventfd and a timerfd.
+ * @param arg Pointer to bridge_ctx_t
+ * @return NULL
+ */
+void *bridge_event_thread_func(void *arg);
+
+/**
+ * Attach the line's timers to the wheel of the thread that serves it
+ * An expired timer calls service(arg), which should run the line's passes.
+ * @param ctx Bridge context
+ * @param wheel Timer wheel (owned by the calling thread)
+ * @param service Callback run on expiry
+ * @param arg Callback argument
+ */
+void bridge_timers_attach(bridge_ctx_t *ctx, timerwheel_t *wheel,
+                          timerwheel_callback_t service, void *arg);
+
+/**
+ * Cancel the line's timers and detach them from their wheel
+ * @param ctx Bridge context
+ */
+void bridge_timers_detach(bridge_ctx_t *ctx);
+
+/**
+ * Schedule the line's timers for its current deadlines (call after a pass)
+ * A pending timer that is due earlier is kept.
+ * @param ctx Bridge context
+ * @param now_ms Current CLOCK_MONOTONIC time in milliseconds
+ */
+void bridge_timers_update(bridge_ctx_t *ctx, long long now_ms);
+
+/**
+ * Check whether queued data is waiting to be moved to the other side
+ * Used by pollers to keep running passes until both directions are idle.
+ * @param ctx Bridge context
+ * @return true if another pass would move data
+ */
+bool bridge_has_pending_data(bridge_ctx_t *ctx);
+
+/**
+ * Wake the event-driven thread so it re-reads descriptors and timers
+ * No-op when the bridge does not run in event-driven mode.
+ * @param ctx Bridge context
+ */
+void bridge_wake(bridge_ctx_t *ctx);
+
+/**
+ * Retry opening the serial port if it is unavailable and the retry interval elapsed
+ * Called periodically from bridge_run() and the multi-line supervisor.
+ * @param ctx Bridge context
+ */
+void bridge_check_serial_retry(bridge_ctx_t *ctx);
+
 /**
  * Serial/Modem thread function (Level 1)
  * Handles serial I/O, modem processing, and Serial<->Telnet buffering
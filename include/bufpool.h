@@ -0,0 +1,69 @@
+/*
+ * bufpool.h - Shared buffer slab for ModemBridge
+ *
+ * Per-line data buffers (bridge rings, telnet I/O buffers, serial TX queues)
+ * are sized at runtime and drawn from one process-wide slab of
+ * power-of-two size classes, so every line in multi-line mode shares the
+ * same backing memory instead of embedding worst-case arrays.
+ */
+
+#ifndef MODEMBRIDGE_BUFPOOL_H
+#define MODEMBRIDGE_BUFPOOL_H
+
+#include "common.h"
+
+/* Size classes */
+#define BUFPOOL_MIN_SIZE        256             /* Smallest chunk */
+#define BUFPOOL_MAX_SIZE        65536           /* Largest chunk */
+#define BUFPOOL_CLASS_COUNT     9               /* 256, 512, ... 65536 */
+#define BUFPOOL_SLAB_SIZE       65536           /* Bytes carved per slab refill */
+#define BUFPOOL_ALIGN           64              /* Chunk alignment (cache line) */
+
+/* Slab statistics */
+typedef struct {
+    size_t slab_bytes;                          /* Memory obtained from the system */
+    size_t bytes_in_use;                        /* Chunk bytes currently handed out */
+    size_t chunks_in_use[BUFPOOL_CLASS_COUNT];  /* Outstanding chunks per class */
+    size_t chunks_free[BUFPOOL_CLASS_COUNT];    /* Cached free chunks per class */
+} bufpool_stats_t;
+
+/* Function prototypes */
+
+/**
+ * Round a request up to its size class
+ * @param size Requested size in bytes
+ * @return Chunk size (power of two, BUFPOOL_MIN_SIZE..BUFPOOL_MAX_SIZE)
+ */
+size_t bufpool_class_size(size_t size);
+
+/**
+ * Allocate a buffer from the shared slab
+ * Sizes above BUFPOOL_MAX_SIZE are clamped to it.
+ * @param size Requested size in bytes
+ * @param granted Pointer to store the usable chunk size (may be NULL)
+ * @return Cache-line aligned buffer, or NULL when out of memory
+ */
+void *bufpool_alloc(size_t size, size_t *granted);
+
+/**
+ * Return a buffer to the shared slab
+ * Chunks stay cached for reuse; slab memory is never returned to the system.
+ * @param ptr Buffer from bufpool_alloc() (NULL is ignored)
+ * @param size Size passed to bufpool_alloc() or the granted size
+ */
+void bufpool_free(void *ptr, size_t size);
+
+/**
+ * Fault in every slab allocated from now on (MEMLOCK)
+ * The line buffers are allocated at bridge start, so their pages are
+ * resident before any data moves.
+ */
+void bufpool_prefault(void);
+
+/**
+ * Get slab statistics
+ * @param stats Pointer to store statistics
+ */
+void bufpool_get_stats(bufpool_stats_t *stats);
+
+#endif /* MODEMBRIDGE_BUFPOOL_H */
@@ -0,0 +1,110 @@
+/*
+ * charset.h - Character set transcoding between terminal and server
+ *
+ * Old terminals speak CP437 or EUC-KR, modern BBS servers UTF-8. When
+ * TERMINAL_CHARSET and SERVER_CHARSET differ, each line converts its data
+ * between the telnet filter and the modem side: one converter per
+ * direction, owned by the thread that runs that direction.
+ *
+ * Runs of ASCII (all three sets agree on 0x00-0x7F) are found eight bytes
+ * at a time and copied as is. Other characters go through Unicode: table
+ * lookups to decode legacy codes, a lead-byte table to validate UTF-8, and
+ * a two-level Unicode table (built once) to encode. A sequence cut by the
+ * end of a chunk waits in the converter for the next one. Invalid input and
+ * characters the target set lacks become '?' (U+FFFD for UTF-8).
+ */
+
+#ifndef MODEMBRIDGE_CHARSET_H
+#define MODEMBRIDGE_CHARSET_H
+
+#include "common.h"
+
+#define CHARSET_MAX_PENDING     3       /* Longest incomplete sequence carried over */
+#define CHARSET_EUCKR_ROWS      94      /* KS X 1001: 94 x 94 codes from 0xA1A1 */
+
+/* Character sets */
+typedef enum {
+    CHARSET_UTF8 = 0,
+    CHARSET_CP437,
+    CHARSET_EUCKR,
+    CHARSET_COUNT
+} charset_t;
+
+/* Converter for one direction */
+typedef struct {
+    charset_t from;                     /* Input character set */
+    charset_t to;                       /* Output character set */
+    unsigned char pending[CHARSET_MAX_PENDING]; /* Incomplete sequence from the last chunk */
+    size_t pending_len;
+    uint64_t replaced;                  /* Characters replaced by '?' / U+FFFD */
+} charset_conv_t;
+
+/* Tables to Unicode (charset_table.c), 0 = unassigned */
+extern const uint16_t charset_cp437_table[128];
+extern const uint16_t charset_euckr_table[CHARSET_EUCKR_ROWS * CHARSET_EUCKR_ROWS];
+
+/* Function prototypes */
+
+/**
+ * Parse a character set name ("UTF-8", "CP437", "EUC-KR", case-insensitive)
+ * @param name Name from the configuration file
+ * @param charset Receives the character set
+ * @return SUCCESS, or ERROR_INVALID_ARG for an unknown name
+ */
+int charset_parse(const char *name, charset_t *charset);
+
+/**
+ * Name of a character set
+ */
+const char *charset_name(charset_t charset);
+
+/**
+ * Initialize a converter
+ * @param conv Converter
+ * @param from Input character set
+ * @param to Output character set
+ */
+void charset_conv_init(charset_conv_t *conv, charset_t from, charset_t to);
+
+/**
+ * Drop an incomplete sequence left from a previous session
+ */
+void charset_conv_reset(charset_conv_t *conv);
+
+/**
+ * Check whether a converter changes the data (from != to)
+ */
+bool charset_conv_active(const charset_conv_t *conv);
+
+/**
+ * Largest output charset_convert() can produce for len input bytes
+ * @param conv Converter
+ * @param len Input length
+ * @return Output bound in bytes
+ */
+size_t charset_conv_bound(const charset_conv_t *conv, size_t len);
+
+/**
+ * Most input whose converted output is sure to fit in out_size
+ * @param conv Converter
+ * @param out_size Output space
+ * @return Input bytes
+ */
+size_t charset_conv_fit(const charset_conv_t *conv, size_t out_size);
+
+/**
+ * Convert one chunk
+ * All input is taken; an incomplete sequence at its end is kept for the
+ * next call. Output beyond out_size is dropped, so out_size should be
+ * charset_conv_bound(conv, len).
+ * @param conv Converter
+ * @param in Input chunk
+ * @param len Input length
+ * @param out Output buffer (must not overlap in)
+ * @param out_size Output buffer size
+ * @return Bytes written to out
+ */
+size_t charset_convert(charset_conv_t *conv, const unsigned char *in, size_t len,
+                       unsigned char *out, size_t out_size);
+
+#endif /* MODEMBRIDGE_CHARSET_H */
@@ -37,7 +37,6 @@
 
 /* Transmission chunk settings (modem_sample pattern) */
 #define TX_CHUNK_SIZE       256     /* Max bytes per chunk */
-#define TX_CHUNK_DELAY_US   10000   /* 10ms delay between chunks */
 
 /* Configuration */
 #define DEFAULT_CONFIG_FILE "/etc/modembridge.conf"
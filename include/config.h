@@ -9,6 +9,8 @@
 #define MODEMBRIDGE_CONFIG_H
 
 #include "common.h"
+#include "datalog.h"
+#include "charset.h"
 #include <termios.h>
 
 /* Parity types */
@@ -26,8 +28,56 @@ typedef enum {
     FLOW_BOTH
 } flow_control_t;
 
-/* Configuration structure */
+/* Serial receive profiles (SERIAL_RX_PROFILE) */
+typedef enum {
+    RX_PROFILE_AUTO = 0,        /* Chosen from the line rate */
+    RX_PROFILE_LOW,             /* Up to 2400 bps */
+    RX_PROFILE_MEDIUM,          /* Up to 19200 bps */
+    RX_PROFILE_HIGH             /* Faster lines */
+} rx_profile_t;
+
+/* Multi-line mode limits */
+#define CONFIG_MAX_LINES        64      /* Maximum [line.N] sections */
+
+/* Modem init script limits */
+#define CONFIG_MAX_INIT_STEPS   16      /* Commands in MODEM_INIT_COMMAND */
+
+/* Dialing directory limits ([dial.NAME] sections) */
+#define CONFIG_MAX_DIAL_TARGETS 32      /* Maximum [dial.NAME] sections */
+#define CONFIG_MAX_BACKENDS     8       /* BACKEND lines per target */
+#define CONFIG_DIAL_NAME_SIZE   32      /* Target name, NUL included */
+
+/* Backend selection in a dialing directory target (POLICY) */
+typedef enum {
+    DIAL_POLICY_LEAST_CONN = 0,         /* Fewest open sessions */
+    DIAL_POLICY_WEIGHTED                /* Fewest open sessions per unit of weight */
+} dial_policy_t;
+
+/* One BACKEND of a target */
+typedef struct {
+    char host[SMALL_BUFFER_SIZE];
+    int port;
+    int weight;                         /* Relative capacity (1-100) */
+} dial_backend_config_t;
+
+/* One [dial.NAME] section */
 typedef struct {
+    char name[CONFIG_DIAL_NAME_SIZE];   /* NAME from the header (ATD<name> also dials it) */
+    char numbers[SMALL_BUFFER_SIZE];    /* NUMBER: comma-separated numbers that dial it */
+    dial_policy_t policy;               /* POLICY */
+    int backend_count;
+    dial_backend_config_t backends[CONFIG_MAX_BACKENDS];
+} dial_target_config_t;
+
+/* MODEM_INIT_COMMAND split once at load into AT-prefixed commands */
+typedef struct {
+    int count;                                  /* Number of commands */
+    uint16_t offset[CONFIG_MAX_INIT_STEPS];     /* Start of each command in text */
+    char text[LINE_BUFFER_SIZE + 2 * CONFIG_MAX_INIT_STEPS];   /* NUL-separated commands */
+} modem_script_t;
+
+/* Configuration structure */
+typedef struct config_s {
     /* Serial port settings */
     char serial_port[SMALL_BUFFER_SIZE];
     speed_t baudrate;           /* termios speed_t type */
@@ -36,7 +86,12 @@ typedef struct {
     int data_bits;
     int stop_bits;
     flow_control_t flow_control;
+    bool serial_low_latency;    /* SERIAL_LOW_LATENCY: set ASYNC_LOW_LATENCY on the port */
+    int serial_latency_timer;   /* SERIAL_LATENCY_TIMER: USB adapter latency_timer in ms (0 = leave) */
+    rx_profile_t serial_rx_profile; /* SERIAL_RX_PROFILE: receive profile (auto = from line rate) */
     char modem_init_command[LINE_BUFFER_SIZE];               /* Init commands (with H0) */
+    modem_script_t modem_init_script;                        /* modem_init_command, parsed */
+    int modem_init_timeout_ms;                               /* MODEM_INIT_TIMEOUT: wait per command for OK/ERROR */
     int modem_autoanswer_mode;                               /* 0=SOFTWARE (S0=0, manual ATA), 1=HARDWARE (S0>0, auto-answer) */
     char modem_autoanswer_software_command[LINE_BUFFER_SIZE]; /* SOFTWARE mode: "ATE0 S0=0" */
     char modem_autoanswer_hardware_command[LINE_BUFFER_SIZE]; /* HARDWARE mode: "ATE0 S0=2" */
@@ -45,15 +100,49 @@ typedef struct {
     /* Telnet settings */
     char telnet_host[SMALL_BUFFER_SIZE];
     int telnet_port;
+    int dns_cache_ttl;          /* DNS_CACHE_TTL: seconds a resolved TELNET_HOST is reused (0 = off) */
+    bool preconnect_on_ring;    /* PRECONNECT_ON_RING: open the telnet connection on RING */
+    bool telnet_compress;       /* TELNET_COMPRESS: accept MCCP2 compression from the server */
+    bool telnet_raw;            /* TELNET_RAW: plain TCP peer, no telnet protocol */
+    bool telnet_fast_start;     /* TELNET_FAST_START: send the server's cached negotiation on connect */
+    charset_t terminal_charset; /* TERMINAL_CHARSET: encoding on the modem side */
+    charset_t server_charset;   /* SERVER_CHARSET: encoding on the telnet side */
+    bool xfer_fastpath;         /* XFER_FASTPATH: raw mode during XMODEM/YMODEM/ZMODEM transfers */
+    bool xfer_telnet_binary;    /* XFER_TELNET_BINARY: raw mode while TELOPT_BINARY is on both ways */
+    bool splice_passthrough;    /* SPLICE_PASSTHROUGH: kernel splice() data plane for transparent lines */
+    int connect_timeout_ms;     /* TELNET_CONNECT_TIMEOUT: give up on one server after this long */
+    char dial_default[CONFIG_DIAL_NAME_SIZE];   /* DIAL_DEFAULT: target for answered calls ("" = TELNET_HOST) */
 
     /* Runtime options */
     bool daemon_mode;
     char pid_file[SMALL_BUFFER_SIZE];
     int log_level;
+    bool event_loop;            /* EVENT_LOOP: block on epoll/eventfd/timerfd instead of sleep polling */
+    bool health_check;          /* HEALTH_CHECK: probe ports, modems and telnet targets at startup */
+    int health_check_timeout_ms; /* HEALTH_CHECK_TIMEOUT: time limit for the whole startup check */
+    int buffer_size;            /* BUFFER_SIZE: per-line data buffer bytes (0 = auto from BAUDRATE) */
+    bool trace_enabled;         /* TRACE_ENABLED: start with tracepoints on (SIGUSR2 toggles) */
+    char trace_file[SMALL_BUFFER_SIZE]; /* TRACE_FILE: binary trace output (see --dump-trace) */
+    char metrics_shm[SMALL_BUFFER_SIZE];    /* METRICS_SHM: file backing the counters ("" = private) */
+    char metrics_address[SMALL_BUFFER_SIZE]; /* METRICS_ADDRESS: Prometheus listen address */
+    int metrics_port;                       /* METRICS_PORT: Prometheus TCP port (0 = off) */
+
+    /* Thread placement (see rtsched.h) */
+    char cpu_affinity_serial[64];   /* CPU_AFFINITY_SERIAL: CPU list for the serial/event-loop thread */
+    char cpu_affinity_telnet[64];   /* CPU_AFFINITY_TELNET: CPU list for the telnet thread */
+    char cpu_affinity_level3[64];   /* CPU_AFFINITY_LEVEL3: CPU list for the Level 3 threads */
+    char cpu_affinity_workers[64];  /* CPU_AFFINITY_WORKERS: CPUs the multi-line workers are spread over */
+    int serial_sched_policy;        /* SERIAL_SCHED_POLICY: SCHED_OTHER, SCHED_FIFO or SCHED_RR */
+    int serial_sched_priority;      /* SERIAL_SCHED_PRIORITY: 1-99 for SCHED_FIFO/RR */
+    bool memlock;                   /* MEMLOCK: lock memory, prefault stacks and buffers */
 
     /* Data logging options */
     bool data_log_enabled;
     char data_log_file[SMALL_BUFFER_SIZE];
+    datalog_format_t data_log_format;   /* DATA_LOG_FORMAT: text or binary */
+    datalog_flush_t data_log_flush;     /* DATA_LOG_FLUSH: record, time or size */
+    int data_log_flush_ms;              /* DATA_LOG_FLUSH_MS: interval for time policy */
+    int data_log_flush_bytes;           /* DATA_LOG_FLUSH_BYTES: threshold for size policy */
 
     /* Echo functionality options (Level 1) */
     bool echo_enabled;            /* Enable/disable echo functionality */
@@ -61,6 +150,16 @@ typedef struct {
     int echo_first_delay;         /* Delay before first echo (seconds) */
     int echo_min_interval;        /* Minimum interval between echoes (seconds) */
     char echo_prefix[64];         /* Prefix for echo messages */
+
+    /* Multi-line mode ([line.N] sections) */
+    int line_id;                  /* N from [line.N] (0 = global section) */
+    int line_workers;             /* LINE_WORKERS: epoll worker threads (0 = auto) */
+    int line_count;               /* Number of [line.N] sections */
+    struct config_s *lines;       /* Per-line configurations (line_count entries) */
+
+    /* Dialing directory ([dial.NAME] sections, global configuration only) */
+    int dial_count;               /* Number of [dial.NAME] sections */
+    dial_target_config_t *dial;   /* Targets (dial_count entries) */
 } config_t;
 
 /* Function prototypes */
@@ -79,6 +178,13 @@ void config_init(config_t *cfg);
  */
 int config_load(config_t *cfg, const char *config_file);
 
+/**
+ * Check whether configuration defines [line.N] sections (multi-line mode)
+ * @param cfg Configuration structure
+ * @return true if one or more lines are configured
+ */
+bool config_is_multiline(const config_t *cfg);
+
 /**
  * Validate configuration values
  * @param cfg Configuration structure to validate
@@ -86,6 +192,22 @@ int config_load(config_t *cfg, const char *config_file);
  */
 int config_validate(const config_t *cfg);
 
+/**
+ * Split a semicolon-separated command string into a modem script
+ * Commands are trimmed and get an "AT" prefix when they lack one.
+ * @param script Script to fill
+ * @param commands Command string (e.g. "ATZ; &F; E0 V1")
+ * @return SUCCESS, or ERROR_CONFIG if commands were dropped (too many or too long)
+ */
+int config_parse_modem_script(modem_script_t *script, const char *commands);
+
+/**
+ * Name of a backend selection policy
+ * @param policy Policy
+ * @return "least_conn" or "weighted"
+ */
+const char *config_dial_policy_name(dial_policy_t policy);
+
 /**
  * Print configuration to log
  * @param cfg Configuration structure to print
@@ -4,12 +4,31 @@
  * Provides hex dump logging functionality for debugging data flow
  * between modem and telnet connections. Log format is compatible
  * with otelnet.log format.
+ *
+ * Callers on the I/O threads only append raw records to a lock-free
+ * queue; a background writer thread formats them (text or compact
+ * binary) and writes in large batches according to the flush policy.
  */
 
 #ifndef MODEMBRIDGE_DATALOG_H
 #define MODEMBRIDGE_DATALOG_H
 
 #include "common.h"
+#include <pthread.h>
+#include <stdatomic.h>
+
+/* Queue and writer tuning */
+#define DATALOG_QUEUE_SLOTS     512     /* Records in flight (power of two) */
+#define DATALOG_SLOT_DATA       480     /* Bytes per record (multiple of 16); larger writes are split */
+#define DATALOG_LABEL_MAX       32      /* Custom label length including NUL */
+#define DATALOG_OUT_BUFFER      65536   /* Writer batch buffer */
+
+#define DATALOG_DEFAULT_FLUSH_MS    1000
+#define DATALOG_DEFAULT_FLUSH_BYTES 16384
+
+/* Binary log file magic (written once at the start of the file) */
+#define DATALOG_BINARY_MAGIC    "MBDLOG1\n"
+#define DATALOG_BINARY_MAGIC_LEN 8
 
 /* Data direction types */
 typedef enum {
@@ -20,12 +39,75 @@ typedef enum {
     DATALOG_DIR_INTERNAL        /* Internal protocol negotiation/processing */
 } datalog_direction_t;
 
+/* On-disk formats */
+typedef enum {
+    DATALOG_FORMAT_TEXT,        /* otelnet.log compatible hex dump */
+    DATALOG_FORMAT_BINARY       /* Compact records, see datalog_convert() */
+} datalog_format_t;
+
+/* When the writer thread issues write(2) */
+typedef enum {
+    DATALOG_FLUSH_RECORD,       /* After every record */
+    DATALOG_FLUSH_TIME,         /* Every flush_ms while data is pending */
+    DATALOG_FLUSH_SIZE          /* When flush_bytes are pending (and on close) */
+} datalog_flush_t;
+
+/* Record types */
+typedef enum {
+    DATALOG_REC_DATA,
+    DATALOG_REC_LABELED,
+    DATALOG_REC_SESSION_START,
+    DATALOG_REC_SESSION_END
+} datalog_record_type_t;
+
+/* Binary record header, followed by label_len label bytes and length data bytes
+ * (host byte order) */
+typedef struct {
+    uint64_t timestamp_us;      /* CLOCK_REALTIME in microseconds */
+    uint16_t length;            /* Data bytes */
+    uint8_t type;               /* datalog_record_type_t */
+    uint8_t direction;          /* datalog_direction_t */
+    uint8_t label_len;          /* Label bytes (no NUL) */
+    uint8_t reserved[3];
+} datalog_record_hdr_t;
+
+_Static_assert(sizeof(datalog_record_hdr_t) == 16, "datalog record header must stay 16 bytes");
+
+/* Queue slot (Vyukov bounded MPSC queue) */
+typedef struct {
+    atomic_size_t seq;          /* Slot sequence number */
+    datalog_record_hdr_t hdr;
+    char label[DATALOG_LABEL_MAX];
+    unsigned char data[DATALOG_SLOT_DATA];
+} datalog_slot_t;
+
 /* Data logger context */
 typedef struct {
-    FILE *fp;                   /* Log file handle */
+    int fd;                     /* Log file descriptor (-1 = closed) */
     char filename[256];         /* Log file path */
     bool enabled;               /* Logging enabled flag */
     bool session_started;       /* Session marker flag */
+
+    /* Output options (set before datalog_open) */
+    datalog_format_t format;
+    datalog_flush_t flush_policy;
+    int flush_ms;
+    size_t flush_bytes;
+
+    /* Record queue: any I/O thread produces, the writer consumes */
+    datalog_slot_t *slots;
+    atomic_size_t enqueue_pos;
+    atomic_size_t dequeue_pos;
+    atomic_uint_fast64_t dropped;       /* Records lost to a full queue */
+
+    /* Writer thread */
+    pthread_t writer;
+    bool writer_started;
+    atomic_bool writer_stop;
+    atomic_bool writer_waiting;         /* Writer is blocked on wake_fd */
+    int wake_fd;                        /* eventfd */
+    char *out;                          /* Batch buffer */
+    size_t out_len;
 } datalog_t;
 
 /* Function prototypes */
@@ -37,7 +119,18 @@ typedef struct {
 void datalog_init(datalog_t *log);
 
 /**
- * Open log file for writing
+ * Set output format and flush policy (call before datalog_open)
+ * @param log Logger context
+ * @param format Text hex dump or compact binary
+ * @param policy Flush policy
+ * @param flush_ms Interval for DATALOG_FLUSH_TIME (ms)
+ * @param flush_bytes Threshold for DATALOG_FLUSH_SIZE (bytes)
+ */
+void datalog_configure(datalog_t *log, datalog_format_t format,
+                       datalog_flush_t policy, int flush_ms, size_t flush_bytes);
+
+/**
+ * Open log file for writing and start the writer thread
  * @param log Logger context
  * @param filename Log file path (default: "modembridge.log")
  * @return SUCCESS on success, error code on failure
@@ -45,7 +138,7 @@ void datalog_init(datalog_t *log);
 int datalog_open(datalog_t *log, const char *filename);
 
 /**
- * Close log file
+ * Drain queued records, stop the writer thread and close the log file
  * @param log Logger context
  * @return SUCCESS on success, error code on failure
  */
@@ -80,6 +173,8 @@ void datalog_session_end(datalog_t *log);
 /**
  * Write data to log in hex dump format (otelnet.log compatible)
  * Format: [timestamp][direction] hex_bytes  | ascii_representation
+ * Only copies the bytes into the queue; never blocks. Records are
+ * dropped (and counted) when the writer falls behind.
  *
  * @param log Logger context
  * @param direction Data direction (from_modem, to_telnet, etc.)
@@ -99,4 +194,55 @@ void datalog_write(datalog_t *log, datalog_direction_t direction,
 void datalog_write_labeled(datalog_t *log, const char *label,
                            const void *data, size_t len);
 
+/**
+ * Open a binary data log for reading and verify its magic
+ * @param filename Binary log file (DATALOG_FORMAT_BINARY)
+ * @return Stream positioned at the first record, NULL on error (errno set)
+ */
+FILE *datalog_open_binary(const char *filename);
+
+/**
+ * Read the next record of a binary data log
+ * @param in Stream from datalog_open_binary()
+ * @param hdr Output: record header
+ * @param label Output: NUL-terminated label (DATALOG_LABEL_MAX bytes)
+ * @param data Output: record data (UINT16_MAX bytes)
+ * @return 1 if a record was read, 0 at end of file, error code on a truncated record
+ */
+int datalog_read_record(FILE *in, datalog_record_hdr_t *hdr, char *label, unsigned char *data);
+
+/**
+ * Convert a binary data log to the otelnet.log text layout
+ * @param filename Binary log file (DATALOG_FORMAT_BINARY)
+ * @param out Output stream
+ * @return SUCCESS on success, error code on failure
+ */
+int datalog_convert(const char *filename, FILE *out);
+
+/**
+ * Parse DATA_LOG_FORMAT value ("text" or "binary")
+ * @param value Configuration value
+ * @param format Output format
+ * @return SUCCESS on success, ERROR_INVALID_ARG if unknown
+ */
+int datalog_parse_format(const char *value, datalog_format_t *format);
+
+/**
+ * Parse DATA_LOG_FLUSH value ("record", "time" or "size")
+ * @param value Configuration value
+ * @param policy Output policy
+ * @return SUCCESS on success, ERROR_INVALID_ARG if unknown
+ */
+int datalog_parse_flush(const char *value, datalog_flush_t *policy);
+
+/**
+ * Get format name for display
+ */
+const char *datalog_format_name(datalog_format_t format);
+
+/**
+ * Get flush policy name for display
+ */
+const char *datalog_flush_name(datalog_flush_t policy);
+
 #endif /* MODEMBRIDGE_DATALOG_H */
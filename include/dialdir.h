@@ -0,0 +1,135 @@
+/*
+ * dialdir.h - Dialing directory with backend pools
+ *
+ * ATD<number> picks a [dial.NAME] target by one of its NUMBERs (or by
+ * name), and answered calls use DIAL_DEFAULT. A target is a pool of
+ * host:port backends shared by every line: each connect takes the backend
+ * with the fewest open sessions (POLICY=weighted divides by the weight),
+ * ties rotating, so lines spread over the pool on their own.
+ *
+ * Health is tracked passively. A backend whose connect fails or runs past
+ * TELNET_CONNECT_TIMEOUT is held down for DIALDIR_HOLDDOWN_SEC, doubling
+ * with each further failure, and the connect fails over to the next
+ * backend at once. When every backend is down, the one due back first is
+ * still tried, so a recovered pool is noticed on the next call.
+ */
+
+#ifndef MODEMBRIDGE_DIALDIR_H
+#define MODEMBRIDGE_DIALDIR_H
+
+#ifdef ENABLE_LEVEL2
+
+#include "common.h"
+#include "config.h"
+#include <stdatomic.h>
+
+#define DIALDIR_HOLDDOWN_SEC        10      /* Hold-down after the first failure */
+#define DIALDIR_HOLDDOWN_MAX_SEC    300     /* Longest hold-down */
+
+/* One backend of a target (shared by every line) */
+typedef struct {
+    char host[SMALL_BUFFER_SIZE];
+    int port;
+    int weight;
+    atomic_int active;                  /* Sessions connecting or open */
+    atomic_int failures;                /* Consecutive failed connects */
+    atomic_llong down_until_ms;         /* Held down until (CLOCK_MONOTONIC, 0 = healthy) */
+    atomic_uint_fast64_t connects;      /* Successful connects */
+    atomic_uint_fast64_t errors;        /* Failed or timed-out connects */
+} dialdir_backend_t;
+
+/* One target */
+typedef struct {
+    char name[CONFIG_DIAL_NAME_SIZE];
+    char numbers[SMALL_BUFFER_SIZE];    /* Comma-separated, as configured */
+    dial_policy_t policy;
+    int count;
+    dialdir_backend_t backends[CONFIG_MAX_BACKENDS];
+    atomic_uint rotor;                  /* Start of the next tie-break scan */
+} dialdir_target_t;
+
+/* A line's claim on one backend of a target */
+typedef struct {
+    dialdir_target_t *target;           /* NULL = not a directory connect */
+    int backend;                        /* Backend held (-1 = none) */
+    uint32_t tried;                     /* Backends tried by this connect (bit per index) */
+} dialdir_lease_t;
+
+/* Function prototypes */
+
+/**
+ * Build the directory from the [dial.NAME] sections
+ * @param cfg Global configuration
+ * @return SUCCESS on success, error code on failure
+ */
+int dialdir_init(const config_t *cfg);
+
+/**
+ * Drop the directory
+ */
+void dialdir_shutdown(void);
+
+/**
+ * Find a target by number or name
+ * Numbers match on their digits (and * #), so "555-1234" dials 5551234.
+ * @param dial Dial string from ATD (modifiers already removed)
+ * @return Target, or NULL if none matches
+ */
+dialdir_target_t *dialdir_find(const char *dial);
+
+/**
+ * Find a target by name
+ * @param name Target name (case-insensitive)
+ * @return Target, or NULL if none is configured
+ */
+dialdir_target_t *dialdir_find_name(const char *name);
+
+/**
+ * Start resolving every backend of a target in the background
+ * @param target Target
+ */
+void dialdir_prefetch(const dialdir_target_t *target);
+
+/**
+ * Check whether the backend the next connect would take is resolved
+ * @param target Target
+ * @return true if a connect would not wait on DNS
+ */
+bool dialdir_ready(dialdir_target_t *target);
+
+/**
+ * Begin a connect to a target
+ * @param lease Lease to initialize
+ * @param target Target
+ */
+void dialdir_lease_init(dialdir_lease_t *lease, dialdir_target_t *target);
+
+/**
+ * Take the best backend not yet tried by this connect
+ * @param lease Lease (must not hold a backend)
+ * @return Backend, or NULL when every backend was tried
+ */
+const dialdir_backend_t *dialdir_acquire(dialdir_lease_t *lease);
+
+/**
+ * Record the outcome of a connect to the held backend
+ * @param lease Lease holding a backend
+ * @param ok true if the connection came up
+ */
+void dialdir_report(dialdir_lease_t *lease, bool ok);
+
+/**
+ * Give the held backend back (session closed or connect abandoned)
+ * The target and the backends tried are kept for a failover.
+ * @param lease Lease
+ */
+void dialdir_release(dialdir_lease_t *lease);
+
+/**
+ * Log sessions and health of every backend
+ */
+void dialdir_log_status(void);
+
+#endif /* ENABLE_LEVEL2 */
+
+#endif /* MODEMBRIDGE_DIALDIR_H */
@@ -0,0 +1,186 @@
+/*
+ * hayes.h - Hayes AT command and result code tables
+ *
+ * One table of commands and one of result codes, shared by the software
+ * modem (modem_process_command, modem_filter_result_code) and the Level 3
+ * Hayes filter. Both are matched through a trie built from the tables, so
+ * classifying a command or result costs one step per character no matter
+ * how many rows the tables have. A new command is one HAYES_COMMANDS row
+ * (plus its action in modem_process_command).
+ *
+ * The +++ escape detector is shared the same way (modem_check_escape_sequence
+ * and the Level 3 filter's online mode).
+ */
+
+#ifndef MODEMBRIDGE_HAYES_H
+#define MODEMBRIDGE_HAYES_H
+
+#include "common.h"
+
+/* Hayes Command Types */
+typedef enum {
+    HAYES_CMD_BASIC = 0,                 /* Basic AT command (ATE, ATH, etc.) */
+    HAYES_CMD_EXTENDED,                  /* Extended AT& command */
+    HAYES_CMD_REGISTER,                  /* S-register command (ATS) */
+    HAYES_CMD_PROPRIETARY                /* Vendor-specific command */
+} hayes_command_type_t;
+
+/*
+ * Command table: ROW(id, command, type, has_parameter, min, max, default, description)
+ * The parameter is one digit after the command; default applies without it.
+ */
+#define HAYES_COMMANDS(ROW) \
+    ROW(A,     "ATA",   HAYES_CMD_BASIC,       false, 0, 0,   0, "Answer incoming call") \
+    ROW(B,     "ATB",   HAYES_CMD_BASIC,       true,  0, 1,   0, "Bell/CCITT mode") \
+    ROW(D,     "ATD",   HAYES_CMD_BASIC,       true,  0, 0,   0, "Dial number") \
+    ROW(E,     "ATE",   HAYES_CMD_BASIC,       true,  0, 1,   1, "Echo on/off") \
+    ROW(H,     "ATH",   HAYES_CMD_BASIC,       true,  0, 1,   0, "Hang up") \
+    ROW(I,     "ATI",   HAYES_CMD_BASIC,       true,  0, 9,   0, "Information/identification") \
+    ROW(L,     "ATL",   HAYES_CMD_BASIC,       true,  0, 3,   2, "Speaker volume") \
+    ROW(M,     "ATM",   HAYES_CMD_BASIC,       true,  0, 3,   1, "Speaker control") \
+    ROW(O,     "ATO",   HAYES_CMD_BASIC,       true,  0, 1,   0, "Return to online mode") \
+    ROW(Q,     "ATQ",   HAYES_CMD_BASIC,       true,  0, 1,   0, "Quiet mode") \
+    ROW(S,     "ATS",   HAYES_CMD_REGISTER,    true,  0, 255, 0, "S-register access") \
+    ROW(V,     "ATV",   HAYES_CMD_BASIC,       true,  0, 1,   1, "Verbose mode") \
+    ROW(X,     "ATX",   HAYES_CMD_BASIC,       true,  0, 4,   4, "Extended result codes") \
+    ROW(Z,     "ATZ",   HAYES_CMD_BASIC,       true,  0, 1,   0, "Reset modem") \
+    ROW(AMP_C, "AT&C",  HAYES_CMD_EXTENDED,    true,  0, 1,   1, "DCD control") \
+    ROW(AMP_D, "AT&D",  HAYES_CMD_EXTENDED,    true,  0, 3,   2, "DTR control") \
+    ROW(AMP_F, "AT&F",  HAYES_CMD_EXTENDED,    false, 0, 0,   0, "Factory defaults") \
+    ROW(AMP_V, "AT&V",  HAYES_CMD_EXTENDED,    false, 0, 0,   0, "View configuration") \
+    ROW(AMP_W, "AT&W",  HAYES_CMD_EXTENDED,    true,  0, 1,   0, "Write configuration") \
+    ROW(AMP_S, "AT&S",  HAYES_CMD_EXTENDED,    true,  0, 1,   0, "DSR override") \
+    ROW(BSL_N, "AT\\N", HAYES_CMD_PROPRIETARY, true,  0, 3,   3, "Error correction")
+
+/*
+ * Result code table: ROW(id, code, numeric, is_connection_result, ends_command_mode)
+ * numeric is the ATV0 code (-1 = none).
+ */
+#define HAYES_RESULTS(ROW) \
+    ROW(OK,          "OK",          0,  false, false) \
+    ROW(ERROR,       "ERROR",       4,  false, false) \
+    ROW(CONNECT,     "CONNECT",     1,  true,  true) \
+    ROW(NO_CARRIER,  "NO CARRIER",  3,  true,  false) \
+    ROW(NO_DIALTONE, "NO DIALTONE", 6,  true,  false) \
+    ROW(BUSY,        "BUSY",        7,  true,  false) \
+    ROW(NO_ANSWER,   "NO ANSWER",   8,  true,  false) \
+    ROW(RING,        "RING",        2,  false, false) \
+    ROW(DELAYED,     "DELAYED",     -1, false, false) \
+    ROW(BLACKLISTED, "BLACKLISTED", -1, false, false)
+
+/* Command identifiers (HAYES_AT_E, HAYES_AT_AMP_C, ...) */
+typedef enum {
+#define HAYES_COMMAND_ID(id, ...) HAYES_AT_##id,
+    HAYES_COMMANDS(HAYES_COMMAND_ID)
+#undef HAYES_COMMAND_ID
+    HAYES_AT_COUNT
+} hayes_command_id_t;
+
+/* Result code identifiers (HAYES_RESULT_OK, ...) */
+typedef enum {
+#define HAYES_RESULT_ID(id, ...) HAYES_RESULT_##id,
+    HAYES_RESULTS(HAYES_RESULT_ID)
+#undef HAYES_RESULT_ID
+    HAYES_RESULT_COUNT
+} hayes_result_id_t;
+
+/* Hayes Command Entry */
+typedef struct {
+    hayes_command_id_t id;               /* Command identifier */
+    const char *command;                 /* Command string (e.g., "ATE", "ATH") */
+    hayes_command_type_t type;           /* Command type */
+    bool has_parameter;                  /* Whether command accepts parameters */
+    int min_param;                       /* Minimum parameter value */
+    int max_param;                       /* Maximum parameter value */
+    int default_param;                   /* Value when the parameter is omitted */
+    const char *description;             /* Human-readable description */
+} hayes_command_entry_t;
+
+/* Hayes Result Codes */
+typedef struct {
+    hayes_result_id_t id;                /* Result identifier */
+    const char *code;                    /* Result code string */
+    int numeric;                         /* ATV0 numeric code (-1 = none) */
+    bool is_connection_result;           /* TRUE for CONNECT, NO CARRIER, etc. */
+    bool ends_command_mode;              /* TRUE if switches to online mode */
+} hayes_result_entry_t;
+
+/* Escape sequence (S2 character repeated HAYES_ESCAPE_LENGTH times) */
+#define HAYES_ESCAPE_LENGTH             3
+#define HAYES_ESCAPE_DEFAULT_GUARD_MS   1000    /* S12 default: 20 * 50 ms */
+
+/*
+ * Escape detector state. The first escape character must follow at least
+ * the guard time of silence and each further one must come within the
+ * guard time of the previous. Time is taken once per chunk: all bytes of
+ * one chunk count as arriving together.
+ */
+typedef struct {
+    int count;                           /* Escape characters pending (0-2) */
+    long long last_data_ms;              /* Ingress time of the last other byte */
+    long long last_escape_ms;            /* Ingress time of the last escape character */
+} hayes_escape_t;
+
+/* Tables, indexed by identifier */
+extern const hayes_command_entry_t hayes_commands[HAYES_AT_COUNT];
+extern const hayes_result_entry_t hayes_results[HAYES_RESULT_COUNT];
+
+/* Function prototypes */
+
+/**
+ * Match the longest table command at the start of a command string
+ * @param text Command text after the "AT" prefix (e.g. "&C1E0"), any case
+ * @param len Length of text
+ * @param matched Receives the length of the command name (may be NULL)
+ * @return Command entry, or NULL if text does not start with a known command
+ */
+const hayes_command_entry_t *hayes_match_command(const char *text, size_t len, size_t *matched);
+
+/**
+ * Match the longest result code that prefixes a line (e.g. "CONNECT 2400")
+ * @param text Line text
+ * @param len Length of text
+ * @param matched Receives the length of the result code (may be NULL)
+ * @return Result entry, or NULL if the line does not start with a result code
+ */
+const hayes_result_entry_t *hayes_match_result(const char *text, size_t len, size_t *matched);
+
+/**
+ * Look up a result code by its exact text
+ * @param code Result code string (e.g. MODEM_RESP_NO_CARRIER)
+ * @return Result entry, or NULL if code is not exactly a table result
+ */
+const hayes_result_entry_t *hayes_find_result(const char *code);
+
+/**
+ * Parse the optional one-digit parameter that follows a command name
+ * @param cmd Command entry
+ * @param p Position after the command name; advanced past the digit
+ * @return Parameter (default_param if absent), -1 if outside min..max
+ */
+int hayes_parse_parameter(const hayes_command_entry_t *cmd, const char **p);
+
+/**
+ * Reset the escape detector
+ * @param esc Detector state
+ * @param now_ms Time the line counts as last active (0 = long idle)
+ */
+void hayes_escape_reset(hayes_escape_t *esc, long long now_ms);
+
+/**
+ * Scan one chunk for the escape sequence
+ * Runs without the escape character are skipped with memchr().
+ * @param esc Detector state
+ * @param data Chunk
+ * @param len Chunk length
+ * @param escape_char Escape character (S2, above 127 disables detection)
+ * @param guard_ms Guard time in milliseconds (S12 * 50)
+ * @param now_ms Ingress time of the chunk (CLOCK_MONOTONIC milliseconds)
+ * @return Offset just past the completing escape character, 0 if the
+ *         sequence is not complete (the last esc->count escape characters
+ *         seen are then pending and end the data scanned so far)
+ */
+size_t hayes_escape_scan(hayes_escape_t *esc, const unsigned char *data, size_t len,
+                         int escape_char, int guard_ms, long long now_ms);
+
+#endif /* MODEMBRIDGE_HAYES_H */
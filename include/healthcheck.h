@@ -2,7 +2,9 @@
  * healthcheck.h - Health check module for ModemBridge
  *
  * Performs diagnostic checks on serial port, modem, and telnet server
- * at startup (one-time only, non-blocking).
+ * at startup. Every port and telnet target of every line is probed at
+ * once over one epoll instance, so the check takes as long as the slowest
+ * probe. Results are cached for the serial retry logic.
  */
 
 #ifndef MODEMBRIDGE_HEALTHCHECK_H
@@ -11,6 +13,11 @@
 #include "common.h"
 #include "config.h"
 
+#define HEALTHCHECK_PROBE_TIMEOUT_MS    2000    /* Wait for one modem response */
+#define HEALTHCHECK_CONNECT_TIMEOUT_MS  5000    /* Wait for one telnet connect */
+#define HEALTHCHECK_CACHE_TTL_SEC       10      /* Age at which a cached result is probed again */
+#define HEALTHCHECK_CACHE_SIZE          (CONFIG_MAX_LINES * 2)
+
 /* Health status codes */
 typedef enum {
     HEALTH_STATUS_OK,       /* Resource is available and working */
@@ -31,6 +38,7 @@ typedef struct {
     health_check_result_t serial_init;
     health_check_result_t modem_device;
     health_check_result_t telnet_server;
+    char health_responses[LINE_BUFFER_SIZE];    /* MODEM_HEALTH_COMMAND replies */
 } health_report_t;
 
 /* Function prototypes */
@@ -43,6 +51,31 @@ typedef struct {
  */
 int healthcheck_run(const config_t *cfg, health_report_t *report);
 
+/**
+ * Run the health check for several lines at once
+ * Probes open in turn; all waits (modem responses, telnet connects) overlap.
+ * @param cfgs Line configurations (count entries, e.g. config.lines)
+ * @param count Number of lines
+ * @param reports Output reports, one per line
+ * @param deadline_ms Time limit for the whole check
+ * @return SUCCESS on successful check execution, error code otherwise
+ */
+int healthcheck_run_lines(const config_t *cfgs, int count, health_report_t *reports, int deadline_ms);
+
+/**
+ * Check serial port availability, reusing a result younger than the cache TTL
+ * @param device Serial device path
+ * @param result Output result structure (can be NULL)
+ * @return Status of the port
+ */
+health_status_t healthcheck_serial_port_cached(const char *device, health_check_result_t *result);
+
+/**
+ * Forget the cached result of a serial port (e.g. after it failed to open)
+ * @param device Serial device path
+ */
+void healthcheck_cache_invalidate(const char *device);
+
 /**
  * Check serial port availability
  * @param device Serial device path (e.g., "/dev/ttyUSB0")
@@ -82,9 +115,9 @@ int healthcheck_telnet_server(const char *host, int port,
                               health_check_result_t *result);
 
 /**
- * Print health check report to stdout with MODEM_COMMAND execution
+ * Print health check report to stdout
  * @param report Health check report
- * @param cfg Configuration (for MODEM_COMMAND execution, can be NULL)
+ * @param cfg Line configuration (labels the report in multi-line mode, can be NULL)
  */
 void healthcheck_print_report(const health_report_t *report, const config_t *cfg);
 
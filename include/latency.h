@@ -0,0 +1,126 @@
+/*
+ * latency.h - Per-chunk latency tags from ingress to egress
+ *
+ * Every chunk read from the serial port or the socket is stamped with the
+ * CLOCK_MONOTONIC time its read() returned. The stamp travels with the
+ * bytes through each queue on the way to the other side, and each hand-off
+ * records how long the chunk spent in the stage it left:
+ *
+ *   rx       read() returned -> published in the line ring (telnet -> serial
+ *            includes IAC parsing and charset conversion)
+ *   queue    published -> taken by the thread on the other side
+ *   process  taken -> handed to the output queue (Level 3 line assembly,
+ *            Hayes filter and charset conversion)
+ *   output   output queue -> written to the socket or serial fd (coalescing,
+ *            pacing, full socket buffer or driver FIFO)
+ *   device   serial only: estimated time until the chunk's last byte leaves
+ *            the UART ((TIOCOUTQ + chunk) x character time)
+ *   total    read() returned -> written
+ *
+ * Time in the UART and the USB adapter before read() returns cannot be seen
+ * from userspace; the startup AT round trip (serial.h) bounds it.
+ *
+ * A queue keeps its stamps in a small ring of marks beside the bytes, each
+ * holding the stream position after the chunk's last byte. Bytes pushed
+ * without a stamp (echo, protocol replies) only move the position. When
+ * the mark ring is full the stamp is dropped and counted; its bytes are
+ * then reported with the next mark.
+ */
+
+#ifndef MODEMBRIDGE_LATENCY_H
+#define MODEMBRIDGE_LATENCY_H
+
+#include "common.h"
+#include "metrics.h"
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#define LATENCY_MARKS           64      /* Stamps one queue holds (power of two) */
+
+/* One stamped chunk in a queue */
+typedef struct {
+    uint64_t end;                       /* Stream position after the chunk */
+    uint64_t ingress_ns;                /* read() of the chunk returned */
+    uint64_t entered_ns;                /* Chunk entered this queue */
+} latency_mark_t;
+
+/* Stamps riding along one byte queue */
+typedef struct {
+    metrics_direction_t *metrics;       /* Stage histograms (NULL = off) */
+
+    /* Producer side (under the queue's producer lock) */
+    alignas(METRICS_ALIGN) uint64_t in_pos;     /* Bytes pushed */
+    atomic_size_t head;                 /* Marks pushed */
+    uint64_t dropped;                   /* Stamps lost to a full mark ring */
+
+    /* Consumer side (under the queue's consumer lock) */
+    alignas(METRICS_ALIGN) uint64_t out_pos;    /* Bytes popped */
+    atomic_size_t tail;                 /* Marks retired */
+
+    latency_mark_t marks[LATENCY_MARKS];
+} latency_tags_t;
+
+/* Stamp handed from a queue's consumer to the next queue */
+typedef struct {
+    uint64_t ingress_ns;                /* Oldest ingress in the chunk (0 = untagged) */
+    uint64_t handoff_ns;                /* Chunk left the previous queue */
+} latency_stamp_t;
+
+/**
+ * Monotonic clock in nanoseconds
+ */
+static inline uint64_t latency_now_ns(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+/* Function prototypes */
+
+/**
+ * Initialize the stamps of a queue
+ * @param tags Stamps
+ * @param metrics Direction whose stage histograms are fed (NULL = off)
+ */
+void latency_tags_init(latency_tags_t *tags, metrics_direction_t *metrics);
+
+/**
+ * Forget all stamps (queue emptied or discarded; both sides quiescent)
+ * @param tags Stamps
+ */
+void latency_tags_reset(latency_tags_t *tags);
+
+/**
+ * Account n bytes entering the queue (producer, before they are visible)
+ * @param tags Stamps
+ * @param n Bytes
+ * @param ingress_ns Ingress of the chunk (0 = untagged)
+ * @param stage Stage that ends here
+ * @param started_ns Start of that stage
+ */
+void latency_tags_push(latency_tags_t *tags, size_t n, uint64_t ingress_ns,
+                       metrics_stage_id_t stage, uint64_t started_ns);
+
+/**
+ * Account n bytes leaving the queue (consumer)
+ * Every chunk whose last byte left records the time it spent queued.
+ * @param tags Stamps
+ * @param n Bytes
+ * @param stage Stage that ends here
+ * @param final The bytes were written out of the bridge (also record total)
+ * @param device_ns Estimated time until the bytes leave the device (0 = none)
+ */
+void latency_tags_pop(latency_tags_t *tags, size_t n, metrics_stage_id_t stage,
+                      bool final, uint64_t device_ns);
+
+/**
+ * Stamp for the bytes at the front of the queue (consumer)
+ * @param tags Stamps
+ * @param stamp Receives the oldest unretired ingress and the current time
+ */
+void latency_tags_stamp(const latency_tags_t *tags, latency_stamp_t *stamp);
+
+#endif /* MODEMBRIDGE_LATENCY_H */
@@ -20,18 +20,22 @@
 #include "config.h"
 #include "serial.h"
 #include "modem.h"
+#include "hayes.h"
 #include "telnet.h"
 #include "bridge.h"
 #include "util.h"
 #include <pthread.h>
 #include <time.h>
 #include <stdbool.h>
+#include <stdalign.h>
+#include <stdatomic.h>
 
 /* Level 3 Pipeline Configuration - Using common utility constants */
 #define L3_PIPELINE_BUFFER_SIZE        UTIL_MAX_MESSAGE_LEN      /* Using common buffer size */
 #define L3_MAX_BURST_SIZE             UTIL_MAX_MESSAGE_LEN       /* Using common message size */
 #define L3_FAIRNESS_TIME_SLICE_MS     50                          /* Time slice per pipeline (ms) */
 #define L3_BACKPRESSURE_TIMEOUT_MS    5000                        /* Backpressure timeout (ms) */
+#define L3_BACKPRESSURE_WAIT_MS       10                          /* Longest sleep under backpressure (ms) */
 
 /* Level 3 State Machine Timeouts */
 #define LEVEL3_CONNECT_TIMEOUT        30                          /* Connection timeout (seconds) */
@@ -74,9 +78,46 @@ typedef enum {
     /* Shutdown/Termination States */
     L3_STATE_SHUTTING_DOWN,              /* Graceful shutdown in progress */
     L3_STATE_TERMINATED,                 /* System terminated */
-    L3_STATE_ERROR                       /* Error state requiring recovery */
+    L3_STATE_ERROR,                      /* Error state requiring recovery */
+    L3_STATE_COUNT
 } l3_system_state_t;
 
+/* State machine events: posted by any thread (DCD edges), or raised by the
+ * management thread from what it observes (telnet link, timeouts, flushed
+ * buffers). Only the management thread changes state. */
+typedef enum {
+    L3_EVENT_L1_READY = 0,               /* Serial port and modem ready */
+    L3_EVENT_DCD_RISING,                 /* Carrier up */
+    L3_EVENT_DCD_FALLING,                /* Carrier lost */
+    L3_EVENT_TELNET_CONNECTED,           /* Telnet session established */
+    L3_EVENT_TELNET_DISCONNECTED,        /* Telnet session lost */
+    L3_EVENT_NEGOTIATED,                 /* Option negotiation finished */
+    L3_EVENT_FLUSHED,                    /* Pipeline buffers empty */
+    L3_EVENT_STOPPED,                    /* Level 3 processing disabled */
+    L3_EVENT_TIMEOUT,                    /* State timeout expired */
+    L3_EVENT_RECOVER,                    /* Leave the error state */
+    L3_EVENT_COUNT
+} l3_event_t;
+
+#define L3_EVENT_QUEUE_SLOTS    16      /* Events in flight (power of two) */
+#define L3_EVENT_QUEUE_MASK     (L3_EVENT_QUEUE_SLOTS - 1)
+
+/* Event queue slot (Vyukov bounded MPSC queue, as the data logger's) */
+typedef struct {
+    atomic_size_t seq;                  /* Slot sequence number */
+    l3_event_t event;
+} l3_event_slot_t;
+
+/* Event queue: any thread posts, the management thread consumes */
+typedef struct {
+    alignas(CACHE_LINE_SIZE) atomic_size_t enqueue_pos;
+    alignas(CACHE_LINE_SIZE) atomic_size_t dequeue_pos;
+    atomic_bool overflowed;             /* An event was lost: resync from dcd_line */
+    atomic_uint_fast64_t dropped;       /* Events lost to a full queue */
+    int wake_fd;                        /* eventfd: events posted */
+    l3_event_slot_t slots[L3_EVENT_QUEUE_SLOTS];
+} l3_event_queue_t;
+
 /* Level 3 Result Codes - Compatible with util_result_t */
 typedef enum {
     L3_SUCCESS = 0,                     /* Success */
@@ -104,30 +145,7 @@ typedef enum {
     L3_PIPELINE_STATE_ERROR              /* Error condition */
 } l3_pipeline_state_t;
 
-/* Hayes Command Types */
-typedef enum {
-    HAYES_CMD_BASIC = 0,                 /* Basic AT command (ATE, ATH, etc.) */
-    HAYES_CMD_EXTENDED,                  /* Extended AT& command */
-    HAYES_CMD_REGISTER,                  /* S-register command (ATS) */
-    HAYES_CMD_PROPRIETARY                /* Vendor-specific command */
-} hayes_command_type_t;
-
-/* Hayes Command Entry */
-typedef struct {
-    const char *command;                 /* Command string (e.g., "ATE", "ATH") */
-    hayes_command_type_t type;           /* Command type */
-    bool has_parameter;                  /* Whether command accepts parameters */
-    int min_param;                       /* Minimum parameter value */
-    int max_param;                       /* Maximum parameter value */
-    const char *description;             /* Human-readable description */
-} hayes_command_entry_t;
-
-/* Hayes Result Codes */
-typedef struct {
-    const char *code;                    /* Result code string */
-    bool is_connection_result;           /* TRUE for CONNECT, NO CARRIER, etc. */
-    bool ends_command_mode;              /* TRUE if switches to online mode */
-} hayes_result_entry_t;
+/* Hayes command and result entries come from hayes.h */
 
 /* Hayes Command Dictionary */
 typedef struct {
@@ -159,11 +177,9 @@ typedef struct {
     /* Line buffering for complete commands */
     unsigned char line_buffer[256];      /* Line accumulation buffer */
     size_t line_len;                     /* Current line length */
-    long long line_start_time;           /* When line started */
+    bool line_passthrough;               /* Online line ruled out as AT command: copied through */
 
-    int plus_count;                      /* Count of '+' for escape detection */
-    long long plus_start_time;           /* Start time of +++ sequence */
-    long long last_char_time;            /* Time of last character */
+    hayes_escape_t escape;               /* +++ escape detector (online mode) */
     bool in_online_mode;                 /* TRUE when in data/online mode */
     const hayes_dictionary_t *dict;      /* Command dictionary reference */
 } hayes_filter_context_t;
@@ -180,25 +196,81 @@ typedef enum {
     TELNET_FILTER_STATE_SB_DATA          /* Suboption data */
 } telnet_filter_state_t;
 
-/* Double Buffer Structure for Each Pipeline */
+/* Memory pool block alignment (block_size is rounded up to a multiple) */
+#define L3_POOL_ALIGN                 CACHE_LINE_SIZE
+
+/* Memory Pool for Fragmentation Prevention
+ * Backs the pipeline double-buffer chunks (l3_double_buffer_t.pool).
+ * Fixed-size blocks on a lock-free free list (Treiber stack). The list head
+ * packs a 32-bit block index with a 32-bit generation tag so a pop racing
+ * with a pop/push of the same block (ABA) fails its CAS and retries. */
 typedef struct {
-    /* Main buffers - currently being processed */
-    unsigned char main_data[L3_PIPELINE_BUFFER_SIZE];
-    size_t main_len;
-    size_t main_pos;                     /* Current read position */
+    /* Pool management */
+    unsigned char *pool_memory;      /* Allocated memory pool (L3_POOL_ALIGN aligned) */
+    size_t pool_size;                /* Total pool size */
+    size_t block_size;               /* Size of each block (multiple of L3_POOL_ALIGN) */
+    size_t total_blocks;             /* Total number of blocks */
+
+    /* Free list */
+    _Atomic uint64_t free_head;      /* Tag << 32 | (index + 1), 0 index = empty */
+    _Atomic uint32_t *next_free;     /* Per-block link: index + 1 of the next free block */
+    atomic_uchar *in_use;            /* Per-block allocation flag (double-free check) */
 
-    /* Sub buffers - accumulating new data during processing */
-    unsigned char sub_data[L3_PIPELINE_BUFFER_SIZE];
-    size_t sub_len;
+    /* Allocation tracking */
+    atomic_size_t allocated_blocks;  /* Number of allocated blocks */
+    atomic_size_t high_water;        /* Peak allocated_blocks */
+    _Atomic uint64_t allocation_count;   /* Total allocations performed */
+    _Atomic uint64_t free_count;     /* Total frees performed */
+    _Atomic uint64_t alloc_failures; /* Allocations refused (pool exhausted) */
 
-    /* Buffer management */
-    pthread_mutex_t mutex;              /* Protect buffer switching */
-    bool main_active;                   /* True if main buffer is being processed */
+    /* Fragmentation metrics (refreshed by l3_memory_pool_update_metrics) */
+    size_t free_blocks;              /* Number of free blocks */
+    double fragmentation_ratio;      /* 1 - largest free run / free space */
+    size_t largest_free_block;       /* Size of largest contiguous free run */
+    size_t free_list_length;         /* Number of separate free runs */
 
-    /* Flow control */
-    size_t bytes_processed;             /* Total bytes processed */
+} l3_memory_pool_t;
+
+/* One fixed-size chunk of a pipeline double buffer (a block of its chunk pool) */
+typedef struct {
+    size_t len;                         /* Bytes filled by the producer */
+    unsigned char data[];               /* l3_double_buffer_t.capacity bytes */
+} l3_buffer_chunk_t;
+
+#define L3_DOUBLE_BUFFER_CHUNKS       3   /* Producer's, consumer's, and one in hand-off */
+
+/* Double Buffer Structure for Each Pipeline
+ * Single producer, single consumer. The producer fills its sub chunk while
+ * the consumer drains its main chunk; a filled chunk is handed over with
+ * one atomic exchange of the ready slot, and the drained one comes back the
+ * same way through the spare slot. Each side's fields sit on their own
+ * cache line. The mutex is only taken when the consumer runs dry while the
+ * producer is idle with a partly filled chunk, to take that chunk over. */
+typedef struct {
+    size_t capacity;                    /* Data bytes per chunk */
+    l3_memory_pool_t pool;              /* Chunk storage, L3_DOUBLE_BUFFER_CHUNKS blocks */
+
+    /* Consumer side: the chunk being drained */
+    alignas(CACHE_LINE_SIZE) l3_buffer_chunk_t *main_chunk;
+    size_t main_pos;                    /* Current read position */
+    atomic_size_t bytes_processed;      /* Total bytes processed */
+    size_t idle_mark;                   /* bytes_written seen by the last empty refill */
+    uint64_t takeovers;                 /* Partial chunks taken from an idle producer */
+
+    /* Producer side: the chunk being filled */
+    alignas(CACHE_LINE_SIZE) l3_buffer_chunk_t *sub_chunk;
+    atomic_bool producer_busy;          /* Producer is inside a write (or reserve/commit) */
+    atomic_size_t bytes_written;        /* Total bytes accepted */
     size_t bytes_dropped;               /* Bytes dropped due to overflow */
-    time_t last_activity;               /* Timestamp of last data transfer */
+    uint64_t handoffs;                  /* Chunks handed to the consumer */
+    time_t last_activity;               /* Timestamp of last write */
+
+    /* Hand-off slots (NULL = empty) */
+    alignas(CACHE_LINE_SIZE) _Atomic(l3_buffer_chunk_t *) ready;  /* Filled, for the consumer */
+    _Atomic(l3_buffer_chunk_t *) spare;                           /* Drained, for the producer */
+
+    /* Exceptional paths only (consumer taking over an idle partial chunk) */
+    pthread_mutex_t mutex;
 } l3_double_buffer_t;
 
 /* Level 3 Pipeline Context */
@@ -220,13 +292,13 @@ typedef struct {
     l3_pipeline_state_t state;         /* Current pipeline state */
 
     /* Fair scheduling */
-    time_t last_timeslice_start;        /* When our current timeslice started */
+    long long last_timeslice_start;     /* When our current timeslice started (l3_get_timestamp_ms) */
     int timeslice_duration_ms;           /* Current timeslice allocation */
     size_t bytes_in_timeslice;          /* Bytes processed in current timeslice */
 
     /* Backpressure management */
     bool backpressure_active;           /* True if downstream is blocked */
-    time_t backpressure_start;          /* When backpressure started */
+    long long backpressure_start;       /* When backpressure started (l3_get_timestamp_ms) */
 
     /* Statistics */
     uint64_t total_bytes_processed;
@@ -330,8 +402,10 @@ typedef struct {
     /* Bridge context reference */
     bridge_ctx_t *bridge;
 
-    /* Enhanced State Machine - LEVEL3_WORK_TODO.txt Compliant */
-    l3_system_state_t system_state;             /* Current system state */
+    /* Enhanced State Machine - LEVEL3_WORK_TODO.txt Compliant
+     * Written by the management thread only; other threads read system_state
+     * without locking (l3_get_system_state()) and post events to change it */
+    atomic_int system_state;                    /* Current system state (l3_system_state_t) */
     l3_system_state_t previous_state;           /* Previous system state */
     time_t state_change_time;                   /* When state changed */
     int state_timeout;                          /* Timeout for current state (seconds) */
@@ -399,16 +473,37 @@ typedef struct {
     } fair_queue;
 
     /* System state */
-    bool level3_active;                         /* True if Level 3 is enabled */
+    atomic_bool level3_active;                  /* True if Level 3 is enabled */
     bool level1_ready;                          /* Level 1 connection ready */
     bool level2_ready;                          /* Level 2 connection ready */
     bool dcd_rising_detected;                   /* DCD rising edge detected */
     bool negotiation_complete;                  /* Protocol negotiation complete */
 
     /* DCD State Management */
-    bool dcd_state;                             /* Current DCD signal state */
+    bool dcd_state;                             /* DCD as seen by the state machine */
+    atomic_bool dcd_line;                       /* DCD as last posted (any thread) */
     time_t dcd_change_time;                     /* Last DCD state change timestamp */
 
+    /* Serial→Telnet line and multibyte assembly (persists across chunks) */
+    struct {
+        unsigned char line_buffer[LINE_BUFFER_SIZE];    /* Partial line awaiting Hayes filter */
+        size_t line_len;                                /* Bytes in line_buffer */
+        time_t line_start_time;                         /* When the partial line started */
+        latency_stamp_t line_stamp;                     /* Ingress stamp of the line's first byte */
+        unsigned char multibyte_buffer[6];              /* Partial UTF-8 character */
+        size_t multibyte_len;                           /* Bytes in multibyte_buffer */
+        int multibyte_expected;                         /* Expected character length */
+        time_t multibyte_start_time;                    /* When the partial character started */
+    } s2t;
+
+    /* CONNECTING retries and once-per-session logging (reset on entering CONNECTING) */
+    bool connection_attempted;                  /* Telnet connect tried in this CONNECTING */
+    time_t last_attempt;                        /* Time of the last connect attempt */
+    bool transition_logged;                     /* "Level 2 connected" logged */
+    bool data_transfer_logged;                  /* Data transfer loop entry logged */
+    int wait_log_counter;                       /* Throttles "Waiting for Level 1/2" debug logs */
+    int statistics_counter;                     /* Data transfer passes since the last stats update */
+
     /* Performance monitoring */
     uint64_t total_pipeline_switches;
     double system_utilization_pct;              /* Overall system utilization */
@@ -427,8 +522,7 @@ typedef struct {
     bool shutdown_requested;                    /* Graceful shutdown requested */
 
     /* State Machine Control */
-    pthread_mutex_t state_mutex;               /* Protect state transitions */
-    pthread_cond_t state_condition;             /* Signal state changes */
+    l3_event_queue_t events;                    /* Transitions requested by other threads */
 
 } l3_context_t;
 
@@ -460,9 +554,20 @@ typedef struct {
     uint64_t underflow_events;       /* Times buffer was empty when read */
     uint64_t bytes_dropped;          /* Total bytes dropped due to overflow */
 
-    /* Memory fragmentation tracking */
-    size_t fragmentation_count;      /* Number of fragmented blocks */
-    size_t largest_fragment_size;    /* Size of largest contiguous block */
+    /* Chunk pool tracking (pipeline double buffers, see l3_double_buffer_get_metrics) */
+    size_t fragmentation_count;      /* Number of separate free runs in the pool */
+    size_t largest_fragment_size;    /* Size of largest contiguous free run */
+    size_t pool_blocks_in_use;       /* Pool blocks currently allocated */
+    size_t pool_high_water;          /* Most pool blocks ever allocated at once */
+    uint64_t pool_alloc_failures;    /* Allocations refused (pool exhausted) */
+
+    /* Resizing (copy-free remaps of the ring) */
+    uint64_t resize_events;          /* Completed resizes */
+    uint64_t resize_deferred;        /* Resizes that waited for queued data to move */
+    uint64_t resize_failures;        /* ftruncate()/mmap() failures */
+    double last_resize_latency_us;   /* Request to completion, last resize */
+    double max_resize_latency_us;    /* Request to completion, worst resize */
+    double last_remap_us;            /* Time spent in ftruncate() + mmap(), last resize */
 
     /* Performance metrics */
     double avg_fill_ratio;           /* Average buffer fill ratio */
@@ -497,44 +602,26 @@ typedef struct {
 
 } l3_buffer_config_t;
 
-/* Memory Pool for Fragmentation Prevention */
+/* Enhanced Double Buffer with Watermark Defense
+ * A ring over a memfd that is mapped twice, back to back, inside one
+ * reservation of twice the maximum size. Any span of up to buffer_size bytes
+ * starting inside the first copy is contiguous, so reads and writes are a
+ * single memcpy. Resizing is ftruncate() plus MAP_FIXED remaps at the same
+ * address: data keeps its file offset and is never copied. A resize that
+ * would cut through queued data (the data straddles the end of the smaller
+ * size) waits until the reader has moved past it. Sizes are whole pages. */
 typedef struct {
-    /* Pool management */
-    unsigned char *pool_memory;      /* Allocated memory pool */
-    size_t pool_size;                /* Total pool size */
-    size_t block_size;               /* Size of each block */
-    size_t total_blocks;             /* Total number of blocks */
-
-    /* Allocation tracking */
-    size_t free_blocks;              /* Number of free blocks */
-    size_t allocated_blocks;         /* Number of allocated blocks */
-    uint64_t allocation_count;       /* Total allocations performed */
-    uint64_t free_count;             /* Total frees performed */
-
-    /* Fragmentation metrics */
-    double fragmentation_ratio;      /* Current fragmentation ratio */
-    size_t largest_free_block;       /* Size of largest contiguous free block */
-    size_t free_list_length;         /* Number of free block entries */
-
-    /* Synchronization */
-    pthread_mutex_t pool_mutex;      /* Protect pool operations */
-
-} l3_memory_pool_t;
-
-/* Enhanced Double Buffer with Watermark Defense */
-typedef struct {
-    /* Basic buffer structure (existing) */
-    unsigned char *main_data;        /* Main buffer - dynamically allocated */
-    unsigned char *sub_data;         /* Sub buffer - dynamically allocated */
-    size_t main_len;
-    size_t main_pos;
-    size_t sub_len;
-    size_t buffer_size;              /* Current buffer size (dynamic) */
+    /* Ring storage */
+    unsigned char *data;             /* First copy of the double mapping */
+    int memfd;                       /* Backing file (-1 = not initialized) */
+    size_t reserved_size;            /* Bytes of address space reserved at data */
+    size_t read_pos;                 /* Offset of the oldest byte (< buffer_size) */
+    size_t used;                     /* Queued bytes */
+    size_t buffer_size;              /* Current ring size (pages, dynamic) */
 
     /* Enhanced buffer management */
     l3_buffer_config_t config;       /* Buffer configuration */
     l3_buffer_metrics_t metrics;     /* Buffer performance metrics */
-    l3_memory_pool_t memory_pool;    /* Memory pool for allocation */
 
     /* Watermark state management */
     l3_watermark_level_t current_watermark;
@@ -545,10 +632,11 @@ typedef struct {
     time_t last_resize_time;
     int consecutive_overflows;       /* Track repeated overflows for growth */
     int consecutive_underflows;      /* Track repeated underflows for shrink */
+    size_t pending_resize;           /* Size waiting for queued data to move (0 = none) */
+    long long pending_resize_since_us;   /* When the pending resize was requested */
 
-    /* Buffer switching (existing) */
+    /* Serializes readers, writers and resizes */
     pthread_mutex_t mutex;
-    bool main_active;
 
     /* Flow control (existing + enhanced) */
     size_t bytes_processed;
@@ -584,6 +672,36 @@ l3_result_t l3_on_dcd_falling(l3_context_t *l3_ctx);
  */
 bool l3_get_dcd_state(l3_context_t *l3_ctx);
 
+/**
+ * Post a state machine event (any thread, lock-free)
+ * The management thread is woken and applies it on its next pass.
+ * @param l3_ctx Level 3 context
+ * @param event Event
+ * @return L3_SUCCESS, or L3_ERROR_QUEUE_FULL if the event was dropped
+ */
+l3_result_t l3_post_event(l3_context_t *l3_ctx, l3_event_t event);
+
+/**
+ * Current system state (any thread, lock-free)
+ * @param l3_ctx Level 3 context
+ * @return State
+ */
+static inline l3_system_state_t l3_get_system_state(const l3_context_t *l3_ctx)
+{
+    return (l3_system_state_t)atomic_load_explicit(&l3_ctx->system_state, memory_order_acquire);
+}
+
+/**
+ * Check whether the data path belongs to Level 3 (any thread, lock-free)
+ * @param l3_ctx Level 3 context
+ * @return true while Level 3 is active and in DATA_TRANSFER
+ */
+static inline bool l3_data_transfer_active(const l3_context_t *l3_ctx)
+{
+    return atomic_load_explicit(&l3_ctx->level3_active, memory_order_acquire) &&
+           l3_get_system_state(l3_ctx) == L3_STATE_DATA_TRANSFER;
+}
+
 /**
  * Initialize DCD monitoring for Level 3
  * @param l3_ctx Level 3 context
@@ -600,8 +718,16 @@ l3_result_t l3_init_dcd_monitoring(l3_context_t *l3_ctx);
  */
 const char *l3_system_state_to_string(l3_system_state_t state);
 
+/**
+ * Get event name as human-readable string
+ * @param event Level 3 event
+ * @return String representation of event
+ */
+const char *l3_event_to_string(l3_event_t event);
+
 /**
  * Set system state with validation and logging
+ * Management thread only (or before it starts); other threads post events.
  * @param l3_ctx Level 3 context
  * @param new_state Target state
  * @param timeout_seconds Timeout for new state (0 = no timeout)
@@ -618,7 +744,8 @@ l3_result_t l3_set_system_state(l3_context_t *l3_ctx, l3_system_state_t new_stat
 bool l3_is_valid_state_transition(l3_system_state_t from_state, l3_system_state_t to_state);
 
 /**
- * Process current state and handle automatic transitions
+ * Apply posted events, then handle timeouts and automatic transitions
+ * Management thread only.
  * @param l3_ctx Level 3 context
  * @return L3_SUCCESS on success, l3_result_t error code on failure
  */
@@ -673,9 +800,11 @@ void l3_cleanup(l3_context_t *l3_ctx);
  * @param pipeline Pipeline structure to initialize
  * @param direction Pipeline direction (serial→telnet or telnet→serial)
  * @param name Human-readable pipeline name
+ * @param buffer_size Double buffer size in bytes (0 = L3_PIPELINE_BUFFER_SIZE)
  * @return L3_SUCCESS on success, l3_result_t error code on failure
  */
-l3_result_t l3_pipeline_init(l3_pipeline_t *pipeline, l3_pipeline_direction_t direction, const char *name);
+l3_result_t l3_pipeline_init(l3_pipeline_t *pipeline, l3_pipeline_direction_t direction, const char *name,
+                             size_t buffer_size);
 
 /**
  * Process data through a pipeline
@@ -690,7 +819,8 @@ l3_result_t l3_pipeline_process(l3_pipeline_t *pipeline, const unsigned char *in
                        unsigned char *output_data, size_t output_size, size_t *output_len);
 
 /**
- * Switch main/sub buffers in a pipeline
+ * Switch main/sub buffers in a pipeline: hand the producer's chunk to the
+ * consumer if the hand-off slot is free (producer thread only)
  * @param pipeline Pipeline context
  * @return L3_SUCCESS on success, l3_result_t error code on failure
  */
@@ -700,12 +830,20 @@ l3_result_t l3_pipeline_switch_buffers(l3_pipeline_t *pipeline);
 /**
  * Initialize double buffer structure
  * @param dbuf Double buffer to initialize
+ * @param capacity Size of each chunk in bytes (at least; chunks come from a bufpool size class)
  * @return L3_SUCCESS on success, l3_result_t error code on failure
  */
-l3_result_t l3_double_buffer_init(l3_double_buffer_t *dbuf);
+l3_result_t l3_double_buffer_init(l3_double_buffer_t *dbuf, size_t capacity);
 
 /**
- * Write data to active sub-buffer
+ * Release double buffer storage and mutex (no producer or consumer active)
+ * @param dbuf Double buffer to destroy
+ */
+void l3_double_buffer_destroy(l3_double_buffer_t *dbuf);
+
+/**
+ * Write data to the producer's chunk (producer thread only)
+ * Full chunks are handed to the consumer as soon as the hand-off slot is free.
  * @param dbuf Double buffer context
  * @param data Data to write
  * @param len Data length
@@ -714,7 +852,7 @@ l3_result_t l3_double_buffer_init(l3_double_buffer_t *dbuf);
 size_t l3_double_buffer_write(l3_double_buffer_t *dbuf, const unsigned char *data, size_t len);
 
 /**
- * Read data from active main buffer
+ * Read data from the consumer's chunk (consumer thread only)
  * @param dbuf Double buffer context
  * @param data Output buffer
  * @param len Maximum bytes to read
@@ -723,28 +861,71 @@ size_t l3_double_buffer_write(l3_double_buffer_t *dbuf, const unsigned char *dat
 size_t l3_double_buffer_read(l3_double_buffer_t *dbuf, unsigned char *data, size_t len);
 
 /**
- * Get available data in main buffer
+ * Reserve space at the end of the producer's chunk for in-place writes (zero-copy)
+ * The chunk stays claimed until l3_double_buffer_commit(); keep the window short.
+ * @param dbuf Double buffer context
+ * @param len Maximum bytes wanted
+ * @param granted Output: bytes available at the returned pointer (may be 0)
+ * @return Pointer into sub-buffer memory
+ */
+unsigned char *l3_double_buffer_reserve(l3_double_buffer_t *dbuf, size_t len, size_t *granted);
+
+/**
+ * Commit bytes written into a reserved span and release the chunk
+ * @param dbuf Double buffer context
+ * @param n Bytes written (<= granted)
+ */
+void l3_double_buffer_commit(l3_double_buffer_t *dbuf, size_t n);
+
+/**
+ * Peek at unread data in the consumer's chunk without copying (consumer thread only)
+ * @param dbuf Double buffer context
+ * @param len Output: bytes readable at the returned pointer (may be 0)
+ * @return Pointer into main buffer memory
+ */
+const unsigned char *l3_double_buffer_peek(l3_double_buffer_t *dbuf, size_t *len);
+
+/**
+ * Mark bytes of a peeked span as processed
+ * @param dbuf Double buffer context
+ * @param n Bytes consumed (<= peeked length)
+ */
+void l3_double_buffer_consume(l3_double_buffer_t *dbuf, size_t n);
+
+/**
+ * Get data written and not yet read (any thread)
  * @param dbuf Double buffer context
  * @return Number of bytes available
  */
 size_t l3_double_buffer_available(l3_double_buffer_t *dbuf);
 
 /**
- * Get free space in sub-buffer
+ * Get free space for the producer (any thread; approximate off the producer thread)
  * @param dbuf Double buffer context
  * @return Number of bytes free
  */
 size_t l3_double_buffer_free(l3_double_buffer_t *dbuf);
 
+/**
+ * Report queued bytes and chunk pool occupancy (any thread; monitoring only)
+ * Fills current_usage, bytes_dropped and the pool fields; the rest is zeroed.
+ * @param dbuf Double buffer context
+ * @param metrics Output structure for buffer metrics
+ * @return L3_SUCCESS on success, L3_ERROR_INVALID_PARAM on bad arguments
+ */
+l3_result_t l3_double_buffer_get_metrics(l3_double_buffer_t *dbuf, l3_buffer_metrics_t *metrics);
+
 /* Enhanced Buffer Management - LEVEL3_WORK_TODO.txt Compliant */
 
 /**
  * Initialize enhanced double buffer with watermark defense
+ * Sizes are rounded up to whole pages.
  * @param ebuf Enhanced double buffer to initialize
  * @param initial_size Initial buffer size
  * @param min_size Minimum buffer size
  * @param max_size Maximum buffer size
- * @return L3_SUCCESS on success, l3_result_t error code on failure
+ * @return L3_SUCCESS on success, L3_ERROR_MEMORY if the memfd ring cannot
+ *         be mapped, l3_result_t error code on failure
  */
 l3_result_t l3_enhanced_double_buffer_init(l3_enhanced_double_buffer_t *ebuf,
                                    size_t initial_size, size_t min_size, size_t max_size);
@@ -783,7 +964,9 @@ size_t l3_enhanced_double_buffer_read(l3_enhanced_double_buffer_t *ebuf,
 l3_watermark_level_t l3_get_watermark_level(l3_enhanced_double_buffer_t *ebuf);
 
 /**
- * Check if buffer needs dynamic resizing
+ * Check if buffer needs dynamic resizing (caller holds ebuf->mutex)
+ * Growth: fill above growth_threshold percent or repeated overflows.
+ * Shrink: fill below shrink_threshold percent and room above the minimum.
  * @param ebuf Enhanced double buffer context
  * @param should_grow Pointer to store if buffer should grow
  * @param should_shrink Pointer to store if buffer should shrink
@@ -792,10 +975,13 @@ l3_watermark_level_t l3_get_watermark_level(l3_enhanced_double_buffer_t *ebuf);
 l3_result_t l3_check_resize_needed(l3_enhanced_double_buffer_t *ebuf, bool *should_grow, bool *should_shrink);
 
 /**
- * Resize enhanced buffer dynamically
+ * Resize enhanced buffer dynamically (caller holds ebuf->mutex)
+ * Queued data is never copied or dropped: if it straddles the end of the
+ * smaller size, the resize is recorded and completed by a later read.
  * @param ebuf Enhanced double buffer context
- * @param new_size New buffer size
- * @return L3_SUCCESS on success, l3_result_t error code on failure
+ * @param new_size New buffer size (rounded up to whole pages)
+ * @return L3_SUCCESS on success (including a deferred resize),
+ *         l3_result_t error code on failure
  */
 l3_result_t l3_resize_buffer(l3_enhanced_double_buffer_t *ebuf, size_t new_size);
 
@@ -827,20 +1013,28 @@ l3_result_t l3_get_buffer_metrics(l3_enhanced_double_buffer_t *ebuf, l3_buffer_m
 l3_result_t l3_memory_pool_init(l3_memory_pool_t *pool, size_t pool_size, size_t block_size);
 
 /**
- * Allocate block from memory pool
+ * Allocate block from memory pool (lock-free, safe from any thread)
  * @param pool Memory pool context
- * @return Pointer to allocated block, NULL if failed
+ * @return Pointer to an L3_POOL_ALIGN aligned block, NULL if exhausted
  */
 unsigned char *l3_memory_pool_alloc(l3_memory_pool_t *pool);
 
 /**
- * Free block back to memory pool
+ * Free block back to memory pool (lock-free, safe from any thread)
  * @param pool Memory pool context
  * @param block Block to free (must be from this pool)
- * @return L3_SUCCESS on success, l3_result_t error code on failure
+ * @return L3_SUCCESS on success, L3_ERROR_INVALID_PARAM for a foreign,
+ *         misaligned or already free block
  */
 l3_result_t l3_memory_pool_free(l3_memory_pool_t *pool, unsigned char *block);
 
+/**
+ * Recompute fragmentation metrics (free runs, largest run, ratio)
+ * Scans the block flags; call from monitoring paths, not per allocation.
+ * @param pool Memory pool context
+ */
+void l3_memory_pool_update_metrics(l3_memory_pool_t *pool);
+
 /**
  * Cleanup memory pool and release all memory
  * @param pool Memory pool to cleanup
@@ -864,16 +1058,20 @@ const char *l3_watermark_level_to_string(l3_watermark_level_t level);
 /* Protocol Filtering */
 /**
  * Filter Hayes commands from serial data (Pipeline 1)
+ * Guard times are evaluated once per call against now_ms, and online-mode
+ * runs without '+', CR or LF are copied through in bulk.
  * @param ctx Hayes filter context (maintained across calls)
  * @param input Input data from serial port
  * @param input_len Input data length
  * @param output Output buffer for filtered data
  * @param output_size Output buffer size
  * @param output_len Pointer to store output length
+ * @param now_ms Ingress time of the input (CLOCK_MONOTONIC milliseconds)
  * @return L3_SUCCESS on success, l3_result_t error code on failure
  */
 l3_result_t l3_filter_hayes_commands(hayes_filter_context_t *ctx, const unsigned char *input, size_t input_len,
-                            unsigned char *output, size_t output_size, size_t *output_len);
+                            unsigned char *output, size_t output_size, size_t *output_len,
+                            long long now_ms);
 
 /**
  * Filter TELNET control codes from telnet data (Pipeline 2)
@@ -990,7 +1188,7 @@ void *l3_management_thread_func(void *arg);
 const char *l3_get_pipeline_name(l3_pipeline_direction_t direction);
 
 /**
- * Get current timestamp in milliseconds
+ * Get current timestamp in milliseconds (CLOCK_MONOTONIC)
  * @return Timestamp in milliseconds
  */
 long long l3_get_timestamp_ms(void);
@@ -0,0 +1,184 @@
+/*
+ * metrics.h - Per-line performance counters for ModemBridge
+ *
+ * Every line publishes byte/drop counters, ring backlog gauges, a
+ * queueing-latency histogram and per-stage latency histograms (see
+ * latency.h) per direction. The counters live in one
+ * mapping that is optionally backed by a file (METRICS_SHM, e.g. under
+ * /dev/shm) so external scrapers can mmap it read-only without locks, and
+ * can be served as Prometheus text (METRICS_PORT).
+ *
+ * Each counter has a single writer, so updates are plain relaxed
+ * load/store pairs on cache-line separated blocks; readers see each value
+ * atomically but not a consistent snapshot across values.
+ */
+
+#ifndef MODEMBRIDGE_METRICS_H
+#define MODEMBRIDGE_METRICS_H
+
+#include "common.h"
+#include <stdalign.h>
+#include <stdatomic.h>
+
+/* Shared mapping layout */
+#define METRICS_MAGIC           "MBMETRC1"
+#define METRICS_MAGIC_LEN       8
+#define METRICS_VERSION         2
+#define METRICS_LABEL_LEN       48
+#define METRICS_ALIGN           64
+
+/* Default Prometheus listen address */
+#define DEFAULT_METRICS_ADDRESS "127.0.0.1"
+
+/*
+ * Latency histogram (HDR-style log-linear buckets, microseconds)
+ * Values below METRICS_HIST_SUB get one bucket each; above that every
+ * power of two is split into METRICS_HIST_SUB linear sub-buckets, so the
+ * relative error stays below 25% from 1 us up to about 67 s.
+ */
+#define METRICS_HIST_SUB_BITS   2
+#define METRICS_HIST_SUB        (1 << METRICS_HIST_SUB_BITS)
+#define METRICS_HIST_MAX_BIT    26
+#define METRICS_HIST_BUCKETS    ((METRICS_HIST_MAX_BIT - METRICS_HIST_SUB_BITS + 1) * METRICS_HIST_SUB + METRICS_HIST_SUB)
+
+/* Directions (order matches the Prometheus "direction" label table) */
+typedef enum {
+    METRICS_SERIAL_TO_TELNET = 0,
+    METRICS_TELNET_TO_SERIAL,
+    METRICS_DIRECTION_COUNT
+} metrics_direction_id_t;
+
+/* Stages of a chunk's trip through the bridge (see latency.h) */
+typedef enum {
+    METRICS_STAGE_RX = 0,               /* Read -> published in the line ring */
+    METRICS_STAGE_QUEUE,                /* Line ring -> taken by the other thread */
+    METRICS_STAGE_PROCESS,              /* Taken -> handed to the output queue */
+    METRICS_STAGE_OUTPUT,               /* Output queue -> written to the socket or serial port */
+    METRICS_STAGE_DEVICE,               /* Written -> last byte on the wire (serial, estimated) */
+    METRICS_STAGE_TOTAL,                /* Read -> written */
+    METRICS_STAGE_COUNT
+} metrics_stage_id_t;
+
+/* Latency histogram, written by one thread at a time */
+typedef struct {
+    alignas(METRICS_ALIGN) atomic_uint_fast64_t count;      /* Samples */
+    atomic_uint_fast64_t sum_us;
+    atomic_uint_fast64_t max_us;
+    atomic_uint_fast64_t buckets[METRICS_HIST_BUCKETS];
+} metrics_hist_t;
+
+/* Counters for one direction of one line */
+typedef struct {
+    /* Producer side: written by the thread filling the ring */
+    alignas(METRICS_ALIGN) atomic_uint_fast64_t drops;      /* Bytes lost to a full ring */
+
+    /* Consumer side: written by the thread draining the ring */
+    alignas(METRICS_ALIGN) atomic_uint_fast64_t bytes;      /* Bytes forwarded */
+    atomic_uint_fast64_t chunks;                            /* Ring reads */
+    atomic_uint_fast64_t backlog_bytes;                     /* Bytes queued after the last read */
+    atomic_uint_fast64_t backlog_peak;                      /* Largest backlog seen */
+    metrics_hist_t latency;                                 /* Burst queueing latency */
+
+    /* Per-chunk stage latency: each stage has one writer (or its queue lock) */
+    metrics_hist_t stage[METRICS_STAGE_COUNT];
+} metrics_direction_t;
+
+/* One line (single-line mode uses slot 0) */
+typedef struct {
+    alignas(METRICS_ALIGN) atomic_int in_use;
+    int line_id;                                /* N from [line.N] (0 = single line) */
+    char label[METRICS_LABEL_LEN];              /* Serial port */
+    atomic_uint_fast64_t connect_bps;           /* CONNECT rate (0 = offline) */
+    metrics_direction_t dir[METRICS_DIRECTION_COUNT];
+} metrics_line_t;
+
+/* Mapping header, followed by line_capacity metrics_line_t slots */
+typedef struct {
+    alignas(METRICS_ALIGN) char magic[METRICS_MAGIC_LEN];
+    uint32_t version;
+    uint32_t line_capacity;
+    uint32_t line_size;                         /* sizeof(metrics_line_t) */
+    uint32_t header_size;                       /* Offset of the first line */
+    uint64_t start_time;                        /* time() at startup */
+    atomic_uint_fast64_t generation;            /* Bumped when a line is attached */
+} metrics_header_t;
+
+/**
+ * Add to a single-writer counter
+ */
+static inline void metrics_add(atomic_uint_fast64_t *counter, uint64_t n)
+{
+    atomic_store_explicit(counter,
+                          atomic_load_explicit(counter, memory_order_relaxed) + n,
+                          memory_order_relaxed);
+}
+
+/* Function prototypes */
+
+/**
+ * Create the metrics mapping and start the Prometheus endpoint
+ * @param shm_path File to back the mapping (NULL or "" = private memory)
+ * @param address Prometheus listen address (NULL = DEFAULT_METRICS_ADDRESS)
+ * @param port Prometheus TCP port (0 = no endpoint)
+ * @param line_capacity Number of line slots
+ * @return SUCCESS on success, error code on failure
+ */
+int metrics_init(const char *shm_path, const char *address, int port, int line_capacity);
+
+/**
+ * Stop the endpoint and unmap the counters (the backing file is kept)
+ */
+void metrics_shutdown(void);
+
+/**
+ * Get the counters for a line, attaching a free slot on first use
+ * @param line_id Line identifier
+ * @param label Human-readable label (serial port)
+ * @return Line counters, or NULL when metrics are not initialized or full
+ */
+metrics_line_t *metrics_line_attach(int line_id, const char *label);
+
+/**
+ * Record one latency sample
+ * @param hist Histogram (NULL is ignored)
+ * @param latency_us Latency in microseconds
+ */
+void metrics_hist_record(metrics_hist_t *hist, uint64_t latency_us);
+
+/**
+ * Count bytes dropped by a producer
+ * @param dir Direction counters (NULL is ignored)
+ * @param n Bytes dropped
+ */
+void metrics_count_drop(metrics_direction_t *dir, uint64_t n);
+
+/**
+ * Estimate a latency percentile from a histogram
+ * @param hist Histogram
+ * @param quantile Quantile in 0..1 (e.g. 0.99)
+ * @return Upper bound of the bucket holding the quantile (us), 0 without samples
+ */
+uint64_t metrics_hist_percentile_us(const metrics_hist_t *hist, double quantile);
+
+/**
+ * Name of a latency stage ("rx", "queue", ...)
+ */
+const char *metrics_stage_name(metrics_stage_id_t stage);
+
+/**
+ * Histogram bucket index for a value in microseconds
+ */
+int metrics_hist_index(uint64_t value_us);
+
+/**
+ * Smallest value (microseconds) that falls into a bucket
+ */
+uint64_t metrics_hist_lower(int index);
+
+/**
+ * Write every attached line in Prometheus text exposition format
+ * @param out Output stream
+ */
+void metrics_write_prometheus(FILE *out);
+
+#endif /* MODEMBRIDGE_METRICS_H */
@@ -10,6 +10,7 @@
 
 #include "common.h"
 #include "serial.h"
+#include "hayes.h"
 
 /* Modem state */
 typedef enum {
@@ -52,10 +53,14 @@ typedef struct {
 
     bool online;                /* Online status */
     bool carrier;               /* Carrier detect */
+    int connect_speed;          /* Rate from the last hardware CONNECT (0 = not reported) */
+
+    /* ATD: dial string waiting for the bridge (see modem_take_dial) */
+    char dial_number[SMALL_BUFFER_SIZE];
+    bool dial_pending;
 
     /* Escape sequence detection (+++ATH) */
-    int escape_count;           /* Number of '+' received */
-    time_t last_escape_time;    /* Time of last escape character */
+    hayes_escape_t escape;      /* S2/S12 escape detector */
 
     /* Hardware modem message buffer (for handling split messages) */
     char hw_msg_buffer[LINE_BUFFER_SIZE];  /* Buffer for accumulating hardware messages */
@@ -237,6 +242,16 @@ int modem_process_dcd_change(modem_t *modem, bool dcd_state);
  */
 modem_state_t modem_get_state(modem_t *modem);
 
+/**
+ * Take the dial string of an ATD command
+ * ATD sends no result code itself: the bridge answers CONNECT or NO CARRIER.
+ * @param modem Modem structure
+ * @param number Receives the dial string (T/P prefix removed, may be empty)
+ * @param size Size of number
+ * @return true if an ATD was waiting
+ */
+bool modem_take_dial(modem_t *modem, char *number, size_t size);
+
 /**
  * Check if modem is online
  * @param modem Modem structure
@@ -298,6 +313,47 @@ bool modem_process_hardware_message(modem_t *modem, const char *data, size_t len
 int modem_send_at_command(modem_t *modem, const char *command,
                           char *response, size_t resp_size, int timeout_sec);
 
+/**
+ * Send AT command and wait for its final result code
+ * Returns as soon as the modem answers; echoed command lines, information
+ * text and unsolicited RING are skipped.
+ * @param modem Modem structure
+ * @param command Command string (e.g., "ATZ" or "AT&F")
+ * @param response Buffer to store response (can be NULL)
+ * @param resp_size Size of response buffer
+ * @param timeout_ms Timeout in milliseconds
+ * @return SUCCESS on OK/CONNECT, ERROR_MODEM on ERROR/NO CARRIER/BUSY/...,
+ *         ERROR_TIMEOUT on timeout, ERROR_IO on serial failure
+ */
+int modem_send_at_command_ms(modem_t *modem, const char *command,
+                             char *response, size_t resp_size, int timeout_ms);
+
+/**
+ * Run a parsed init script (MODEM_INIT_COMMAND), one command at a time
+ * Each command is sent as soon as the previous one got its result code.
+ * A command answered with ERROR or not at all is logged and skipped.
+ * @param modem Modem structure
+ * @param script Commands from config_parse_modem_script()
+ * @param timeout_ms Wait per command
+ * @return SUCCESS if every command got OK, ERROR_IO on serial failure,
+ *         otherwise the last command error
+ */
+int modem_run_script(modem_t *modem, const modem_script_t *script, int timeout_ms);
+
+/**
+ * Measure the AT round trip through the serial port
+ * Sends a bare "AT" count times and keeps the fastest OK: the time the
+ * command and its answer spend in the tty layer, the USB adapter and the
+ * modem. Only for a modem in command mode.
+ * @param modem Modem structure
+ * @param count Round trips to measure
+ * @param timeout_ms Wait per command
+ * @param best_us Receives the fastest round trip in microseconds (-1 = none)
+ * @return SUCCESS if at least one OK came back, ERROR_TIMEOUT if none,
+ *         ERROR_IO on serial failure
+ */
+int modem_probe_round_trip(modem_t *modem, int count, int timeout_ms, int *best_us);
+
 /**
  * Send compound AT command string (semicolon-separated)
  * Based on modem_sample/modem_control.c:send_command_string()
@@ -372,10 +428,11 @@ size_t modem_filter_hayes_data(modem_t *modem, const char *data, size_t len, boo
 
 /**
  * Handle Hayes escape sequence detection with proper S2/S12 register support
+ * The chunk is scanned with one timestamp taken on entry.
  * @param modem Modem structure
  * @param data Incoming data buffer
  * @param len Data length
- * @param consumed Pointer to store number of bytes consumed
+ * @param consumed Pointer to store the bytes up to the end of the sequence (0 if none)
  * @return true if escape sequence detected, false otherwise
  */
 bool modem_check_escape_sequence(modem_t *modem, const char *data, size_t len, size_t *consumed);
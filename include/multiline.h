@@ -0,0 +1,102 @@
+/*
+ * multiline.h - Multi-line mode for ModemBridge
+ *
+ * Runs one bridge per [line.N] configuration section inside a single
+ * process. Serial and telnet I/O of all lines is multiplexed over a
+ * small pool of epoll worker threads instead of two threads per line.
+ */
+
+#ifndef MODEMBRIDGE_MULTILINE_H
+#define MODEMBRIDGE_MULTILINE_H
+
+#include "common.h"
+#include "config.h"
+#include "bridge.h"
+#include <pthread.h>
+
+/* Worker pool limits */
+#define ML_MAX_WORKERS          16      /* Upper bound for LINE_WORKERS */
+#define ML_MAX_EVENTS           64      /* epoll events per wakeup */
+#define ML_TICK_MS              100     /* Housekeeping sweep interval (serial retry, reconnects) */
+#define ML_MAX_BURST            8       /* Poll passes per line per wakeup */
+
+/* Epoll worker thread */
+typedef struct {
+    int index;                          /* Worker number */
+    struct multiline_ctx_s *owner;      /* Back-reference to multi-line context */
+    pthread_t thread;
+    int epoll_fd;                       /* Event set for all lines owned by this worker */
+    int timer_fd;                       /* timerfd armed for wheel (epoll data.ptr = NULL) */
+    timerwheel_t wheel;                 /* Timers of all lines owned by this worker */
+    timerwheel_timer_t sweep_timer;     /* Housekeeping sweep every ML_TICK_MS */
+    bool thread_started;
+
+    /* Statistics */
+    uint64_t wakeups;                   /* epoll_wait() returns */
+    uint64_t dispatches;                /* Line service passes */
+} ml_worker_t;
+
+/* One bridged line */
+typedef struct {
+    bridge_ctx_t bridge;                /* Per-line bridge (serial, modem, telnet, Level 3) */
+    int worker;                         /* Owning worker index */
+    ml_worker_t *home;                  /* Owning worker (timer callbacks) */
+    int serial_fd;                      /* Serial fd registered with worker epoll (-1 = none) */
+    int telnet_fd;                      /* Telnet fd registered with worker epoll (-1 = none) */
+    int start_result;                   /* bridge_start() result */
+} ml_line_t;
+
+/* Multi-line context */
+typedef struct multiline_ctx_s {
+    config_t *config;                   /* Global configuration (owns lines[]) */
+
+    ml_line_t *lines;
+    int line_count;
+
+    ml_worker_t workers[ML_MAX_WORKERS];
+    int worker_count;
+
+    volatile bool running;
+} multiline_ctx_t;
+
+/* Function prototypes */
+
+/**
+ * Initialize multi-line context from [line.N] sections
+ * @param ml Multi-line context
+ * @param cfg Global configuration (config_is_multiline() must be true)
+ * @return SUCCESS on success, error code on failure
+ */
+int multiline_init(multiline_ctx_t *ml, config_t *cfg);
+
+/**
+ * Start all lines and the epoll worker pool
+ * Lines are brought up in parallel; a line whose serial port is missing
+ * starts in DISCONNECTED state and is retried by multiline_run().
+ * @param ml Multi-line context
+ * @return SUCCESS on success, error code on failure
+ */
+int multiline_start(multiline_ctx_t *ml);
+
+/**
+ * Supervisor pass (call periodically from main loop)
+ * Sleeps briefly and retries unavailable serial ports.
+ * @param ml Multi-line context
+ * @return SUCCESS on success, error code on failure
+ */
+int multiline_run(multiline_ctx_t *ml);
+
+/**
+ * Stop workers and all lines, release resources
+ * @param ml Multi-line context
+ * @return SUCCESS on success, error code on failure
+ */
+int multiline_stop(multiline_ctx_t *ml);
+
+/**
+ * Print per-line and worker statistics
+ * @param ml Multi-line context
+ */
+void multiline_print_stats(multiline_ctx_t *ml);
+
+#endif /* MODEMBRIDGE_MULTILINE_H */
@@ -0,0 +1,120 @@
+/*
+ * passthru.h - Kernel splice() data plane for transparent lines
+ *
+ * When nothing between the serial port and the TCP peer has to look at
+ * the bytes (TELNET_RAW peer, no data log, transcoding, echo or Level 3
+ * pipelines), a direction can be moved by the kernel: splice() from the
+ * source fd into a pipe, then from the pipe into the destination fd. The
+ * data never enters userspace, so an idle or busy line costs a few
+ * syscalls per chunk and no copies.
+ *
+ * Each direction has its own pipe and belongs to the thread that drains
+ * its source (the serial thread for PASSTHRU_TO_TELNET, the telnet thread
+ * for PASSTHRU_TO_SERIAL). Bytes already in the pipe when the destination
+ * is full stay there and go first on the next pass.
+ */
+
+#ifndef MODEMBRIDGE_PASSTHRU_H
+#define MODEMBRIDGE_PASSTHRU_H
+
+#include "common.h"
+
+#define PASSTHRU_RETRY_MS       5       /* Pass interval while bytes wait in a pipe */
+
+/* Directions, named by the destination */
+typedef enum {
+    PASSTHRU_TO_TELNET = 0,             /* Serial fd -> socket */
+    PASSTHRU_TO_SERIAL,                 /* Socket -> serial fd */
+    PASSTHRU_DIR_COUNT
+} passthru_dir_id_t;
+
+/* One direction */
+typedef struct {
+    int pipe_fd[2];                     /* [0] read end, [1] write end (-1 = not created) */
+    size_t pending;                     /* Bytes in the pipe not yet written out */
+    bool engaged;                       /* Direction runs in the kernel */
+    bool unsupported;                   /* splice() refused an fd: stay in userspace */
+    uint64_t bytes;                     /* Bytes delivered by splice() */
+    uint64_t engagements;               /* Times the direction went to the kernel */
+} passthru_dir_t;
+
+/* Per-line data plane */
+typedef struct {
+    bool enabled;                       /* SPLICE_PASSTHROUGH */
+    passthru_dir_t dir[PASSTHRU_DIR_COUNT];
+} passthru_t;
+
+/* Function prototypes */
+
+/**
+ * Initialize a data plane (pipes are created on first engagement)
+ * @param pt Data plane
+ * @param enabled Use splice() when a direction is transparent (SPLICE_PASSTHROUGH)
+ */
+void passthru_init(passthru_t *pt, bool enabled);
+
+/**
+ * Close the pipes
+ * @param pt Data plane
+ */
+void passthru_close(passthru_t *pt);
+
+/**
+ * Move a direction to the kernel
+ * @param pt Data plane
+ * @param id Direction
+ * @return true if the direction is engaged (pipe ready, splice() not refused)
+ */
+bool passthru_engage(passthru_t *pt, passthru_dir_id_t id);
+
+/**
+ * Return a direction to userspace
+ * Bytes still in the pipe are read into buf for the userspace path.
+ * @param pt Data plane
+ * @param id Direction
+ * @param buf Receives the bytes left in the pipe
+ * @param size Size of buf (at least the largest fill)
+ * @return Bytes placed in buf
+ */
+size_t passthru_release(passthru_t *pt, passthru_dir_id_t id, unsigned char *buf, size_t size);
+
+/**
+ * Splice from a source fd into the direction's pipe
+ * Nothing is read while earlier bytes still wait in the pipe.
+ * @param pt Data plane
+ * @param id Direction
+ * @param in_fd Source (serial fd or socket)
+ * @param max Most bytes to take
+ * @return Bytes taken (0 = none available or pipe busy), ERROR_CONNECTION at
+ *         end of file, ERROR_SYSTEM if splice() is not supported for in_fd,
+ *         ERROR_IO on other errors
+ */
+ssize_t passthru_fill(passthru_t *pt, passthru_dir_id_t id, int in_fd, size_t max);
+
+/**
+ * Splice bytes waiting in the direction's pipe to a destination fd
+ * @param pt Data plane
+ * @param id Direction
+ * @param out_fd Destination (must not block for the pending bytes)
+ * @return SUCCESS (some bytes may still be pending), ERROR_SYSTEM if
+ *         splice() is not supported for out_fd, ERROR_IO on other errors
+ */
+int passthru_drain(passthru_t *pt, passthru_dir_id_t id, int out_fd);
+
+/**
+ * Account bytes written out of the pipe by another module
+ * (telnet_send_splice() owns the socket)
+ * @param pt Data plane
+ * @param id Direction
+ * @param n Bytes written
+ */
+void passthru_drained(passthru_t *pt, passthru_dir_id_t id, size_t n);
+
+/**
+ * Check for bytes waiting in any pipe
+ * @param pt Data plane
+ * @return true if a direction has pending bytes
+ */
+bool passthru_pending(const passthru_t *pt);
+
+#endif /* MODEMBRIDGE_PASSTHRU_H */
@@ -0,0 +1,113 @@
+/*
+ * resolver.h - Cached host name resolution for telnet connects
+ *
+ * Names are resolved with getaddrinfo() (IPv4 and IPv6) and cached for
+ * DNS_CACHE_TTL seconds in one table shared by every line. A background
+ * thread resolves prefetched names (e.g. on RING), refreshes expired
+ * entries and serves cache misses of telnet connects, which wait for the
+ * answer on an eventfd instead of blocking their I/O thread.
+ */
+
+#ifndef MODEMBRIDGE_RESOLVER_H
+#define MODEMBRIDGE_RESOLVER_H
+
+#ifdef ENABLE_LEVEL2
+
+#include "common.h"
+#include <sys/socket.h>
+#include <netdb.h>
+
+#define RESOLVER_MAX_ADDRS      8       /* Addresses kept per name */
+#define RESOLVER_CACHE_SIZE     16      /* Cached names (least recently used is evicted) */
+#define RESOLVER_NEGATIVE_TTL   5       /* Seconds a failed lookup is remembered */
+#define RESOLVER_SHARE_TTL      2       /* Seconds an answer is kept for its waiters when DNS_CACHE_TTL is 0 */
+#define RESOLVER_MAX_WAITERS    8       /* Eventfds woken per name (further waiters poll) */
+
+#define RESOLVER_PENDING        1       /* resolver_lookup_async(): answer not there yet */
+
+#define DEFAULT_DNS_CACHE_TTL   60
+
+/* Addresses of one name, families interleaved (RFC 8305 section 4) */
+typedef struct {
+    int count;
+    socklen_t addr_len[RESOLVER_MAX_ADDRS];
+    struct sockaddr_storage addrs[RESOLVER_MAX_ADDRS];
+} resolver_result_t;
+
+/* Function prototypes */
+
+/**
+ * Set the cache TTL and start the background resolver thread
+ * @param ttl_sec Seconds a lookup stays cached (0 = no cache: every connect
+ *                resolves, answers are shared for RESOLVER_SHARE_TTL seconds)
+ * @return SUCCESS on success, error code on failure
+ */
+int resolver_init(int ttl_sec);
+
+/**
+ * Stop the resolver thread and drop the cache
+ */
+void resolver_shutdown(void);
+
+/**
+ * Resolve a name in the background unless a fresh entry is cached
+ * Never blocks; ignored without a resolver thread.
+ * @param host Host name or numeric address
+ * @param port TCP port
+ */
+void resolver_prefetch(const char *host, int port);
+
+/**
+ * Check whether resolver_lookup() would return without waiting on DNS
+ * @param host Host name or numeric address
+ * @param port TCP port
+ * @return true for numeric addresses and names with cached addresses
+ */
+bool resolver_ready(const char *host, int port);
+
+/**
+ * Get the addresses of a name
+ * Served from the cache when fresh; an expired entry is returned once more
+ * while the resolver thread refreshes it. Otherwise resolves on the calling
+ * thread (or waits for a lookup the resolver thread already started).
+ * @param host Host name or numeric address
+ * @param port TCP port
+ * @param result Receives the addresses
+ * @return SUCCESS on success, ERROR_CONNECTION if the name does not resolve
+ */
+int resolver_lookup(const char *host, int port, resolver_result_t *result);
+
+/**
+ * Get the addresses of a name without waiting on DNS
+ * Numeric addresses and cached names (stale ones too, refreshed in the
+ * background) are returned at once. On a miss the name is queued to the
+ * resolver thread and notify_fd is signalled when the answer lands; call
+ * again then to collect it. Without a resolver thread this is
+ * resolver_lookup().
+ * @param host Host name or numeric address
+ * @param port TCP port
+ * @param result Receives the addresses
+ * @param notify_fd eventfd to signal on completion (-1 = none, poll instead)
+ * @return SUCCESS, RESOLVER_PENDING while the lookup runs, ERROR_CONNECTION
+ *         if the name does not resolve (or failed within RESOLVER_NEGATIVE_TTL)
+ */
+int resolver_lookup_async(const char *host, int port, resolver_result_t *result, int notify_fd);
+
+/**
+ * Stop signalling an eventfd passed to resolver_lookup_async() (call before closing it)
+ * @param notify_fd eventfd
+ */
+void resolver_cancel(int notify_fd);
+
+/**
+ * Format an address for logging ("192.0.2.1" or "[2001:db8::1]")
+ * @param addr Socket address
+ * @param buf Output buffer
+ * @param len Output buffer size
+ * @return buf
+ */
+const char *resolver_format_addr(const struct sockaddr_storage *addr, char *buf, size_t len);
+
+#endif /* ENABLE_LEVEL2 */
+
+#endif /* MODEMBRIDGE_RESOLVER_H */
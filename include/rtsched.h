@@ -0,0 +1,125 @@
+/*
+ * rtsched.h - Thread placement, real-time priority and memory locking
+ *
+ * UART FIFO overruns at 57600 bps and above come from the serial thread
+ * not running in time: scheduler jitter on a shared host, or a page fault
+ * on a stack or buffer page. The line threads can be pinned to CPUs
+ * (CPU_AFFINITY_*), the thread doing serial I/O can run SCHED_FIFO/RR
+ * (SERIAL_SCHED_POLICY/PRIORITY), and with MEMLOCK=1 the process memory is
+ * locked and the thread stacks and data buffers are faulted in up front.
+ *
+ * Settings the process lacks the privilege for (CAP_SYS_NICE,
+ * RLIMIT_MEMLOCK) are skipped with a warning; the thread still starts.
+ */
+
+#ifndef MODEMBRIDGE_RTSCHED_H
+#define MODEMBRIDGE_RTSCHED_H
+
+#include "common.h"
+#include "config.h"
+#include <pthread.h>
+#include <sched.h>
+
+#define RTSCHED_STACK_SIZE      (512 * 1024)    /* Thread stack with MEMLOCK (default is 8 MB) */
+#define RTSCHED_STACK_PREFAULT  (64 * 1024)     /* Stack faulted in at thread start */
+#define RTSCHED_DEFAULT_PRIORITY 10             /* SCHED_FIFO/RR priority if none is given */
+
+/* Threads with their own placement settings */
+typedef enum {
+    RTSCHED_SERIAL = 0,                 /* Serial thread, event-loop thread, multi-line workers */
+    RTSCHED_TELNET,                     /* Telnet thread */
+    RTSCHED_LEVEL3,                     /* Level 3 pipeline thread */
+    RTSCHED_ROLE_COUNT
+} rtsched_role_t;
+
+/* Requested placement of one thread */
+typedef struct {
+    cpu_set_t cpus;                     /* Allowed CPUs (empty = any) */
+    int policy;                         /* SCHED_OTHER, SCHED_FIFO or SCHED_RR */
+    int priority;                       /* Static priority for SCHED_FIFO/RR */
+    bool memlock;                       /* Small stack, faulted in at start */
+} rtsched_spec_t;
+
+/* Placement a thread actually got */
+typedef struct {
+    bool valid;                         /* Thread exists and was queried */
+    cpu_set_t cpus;
+    int policy;
+    int priority;
+} rtsched_status_t;
+
+/* Function prototypes */
+
+/**
+ * Parse a CPU list ("2", "0-1,3"; "" = any CPU)
+ * @param list CPU list
+ * @param cpus Receives the set (empty for "")
+ * @return SUCCESS, or ERROR_CONFIG if the list is malformed
+ */
+int rtsched_parse_cpus(const char *list, cpu_set_t *cpus);
+
+/**
+ * Parse a scheduling policy name (OTHER, FIFO, RR)
+ * @param name Policy name (case-insensitive, optional SCHED_ prefix)
+ * @param policy Receives SCHED_OTHER, SCHED_FIFO or SCHED_RR
+ * @return SUCCESS, or ERROR_CONFIG for an unknown name
+ */
+int rtsched_parse_policy(const char *name, int *policy);
+
+/**
+ * Name of a scheduling policy
+ */
+const char *rtsched_policy_name(int policy);
+
+/**
+ * Build the placement of a thread role from the configuration
+ * @param cfg Configuration (global or [line.N])
+ * @param role Thread role
+ * @param spec Receives the placement
+ */
+void rtsched_spec_from_config(const config_t *cfg, rtsched_role_t role, rtsched_spec_t *spec);
+
+/**
+ * Create a thread with a placement
+ * A placement the process may not use is dropped with a warning and the
+ * thread is created without it.
+ * @param thread Receives the thread handle
+ * @param spec Placement (NULL = defaults)
+ * @param name Thread name for log messages
+ * @param fn Thread function
+ * @param arg Thread argument
+ * @return 0 on success, or the pthread_create() error number
+ */
+int rtsched_thread_create(pthread_t *thread, const rtsched_spec_t *spec, const char *name,
+                          void *(*fn)(void *), void *arg);
+
+/**
+ * Read the placement a thread actually has
+ * @param thread Thread handle
+ * @param status Receives the effective CPUs, policy and priority
+ */
+void rtsched_query(pthread_t thread, rtsched_status_t *status);
+
+/**
+ * Format an effective placement ("CPUs 2-3, SCHED_FIFO 50")
+ * @param status Placement
+ * @param buf Output buffer
+ * @param size Output buffer size
+ */
+void rtsched_format(const rtsched_status_t *status, char *buf, size_t size);
+
+/**
+ * Lock the process memory (MEMLOCK)
+ * Pages are locked as they are faulted in, so only what the process
+ * touches is pinned; the buffer slab and line thread stacks are faulted
+ * in up front (bufpool_prefault(), rtsched_thread_create()).
+ * @return SUCCESS, or ERROR_SYSTEM if mlockall() failed
+ */
+int rtsched_lock_memory(void);
+
+/**
+ * Check whether rtsched_lock_memory() succeeded
+ */
+bool rtsched_memory_locked(void);
+
+#endif /* MODEMBRIDGE_RTSCHED_H */
@@ -9,7 +9,71 @@
 
 #include "common.h"
 #include "config.h"
+#include "latency.h"
 #include <termios.h>
+#include <pthread.h>
+
+/* Asynchronous TX pacing: keep this much line time queued in the driver
+ * (TIOCOUTQ) and hold the rest in the userspace TX queue */
+#define SERIAL_TX_FIFO_US       20000   /* 20ms of line time */
+#define SERIAL_TX_MIN_FILL      32      /* Floor for very slow lines */
+#define SERIAL_TX_MAX_FILL      (TX_CHUNK_SIZE * 4)
+
+/* Line-rate pacing: while a carrier rate is set, a token bucket (credit in
+ * nanoseconds of line time) releases bytes at that rate, so a modem whose
+ * DTE side is faster (locked DTE rate, USB adapters that ignore termios
+ * speed) is neither overrun nor starved */
+#define SERIAL_TX_PACE_BURST_US 20000   /* Burst allowance: 20ms of line time */
+#define SERIAL_TX_PACE_MIN_BURST 4      /* Burst floor in characters */
+#define SERIAL_TX_PACE_QUEUE_US 250000  /* serial_tx_space() window: 250ms of line time */
+
+/* Receive latency tuning */
+#define SERIAL_LATENCY_TIMER_DEFAULT 1  /* USB adapter latency_timer in ms (drivers default to 16) */
+#define SERIAL_PROBE_COUNT      3       /* AT round trips measured at startup (best is kept) */
+
+/* Receive profile: termios read settings and read size for a line rate */
+typedef struct {
+    const char *name;
+    int max_bps;                    /* Highest line rate the profile is chosen for */
+    cc_t vmin;                      /* VMIN */
+    cc_t vtime;                     /* VTIME (deciseconds) */
+    size_t read_size;               /* Bytes taken per serial read */
+} serial_rx_profile_t;
+
+/* Userspace TX queue (one per port, filled by serial_write) */
+typedef struct {
+    unsigned char *data;            /* Queue storage (bufpool chunk, NULL while closed) */
+    size_t capacity;                /* Power of two */
+    size_t head;                    /* Free-running write index */
+    size_t tail;                    /* Free-running read index */
+    size_t high_water;              /* Peak queued bytes */
+    uint64_t bytes_sent;            /* Bytes handed to the driver */
+    uint64_t full_events;           /* Writes cut short because the queue was full */
+
+    /* Line-rate pacer (serial_tx_set_line_rate) */
+    int pace_bps;                   /* Carrier rate (0 = unpaced, report against the DTE rate) */
+    int pace_bits;                  /* Bits per character: start + data + parity + stop */
+    uint64_t pace_char_ns;          /* Line time of one character */
+    uint64_t pace_burst_ns;         /* Bucket depth */
+    uint64_t pace_credit_ns;        /* Tokens */
+    uint64_t pace_last_ns;          /* Last refill (CLOCK_MONOTONIC) */
+    uint64_t pace_busy_ns;          /* Time with bytes waiting in the queue */
+    uint64_t pace_bytes_base;       /* bytes_sent when the rate was set */
+    latency_tags_t tags;            /* Ingress stamps of queued bytes (see latency.h) */
+    pthread_mutex_t lock;           /* Writers and pumps may be different threads */
+} serial_tx_queue_t;
+
+/* TX line utilization (serial_tx_get_pace_stats) */
+typedef struct {
+    int line_bps;                   /* Rate being reported (carrier, or DTE if unpaced) */
+    int bits_per_char;              /* Start + data + parity + stop bits */
+    bool paced;                     /* Token bucket active (carrier rate set) */
+    uint64_t bytes;                 /* Bytes sent since the rate was set */
+    double busy_sec;                /* Time with bytes waiting in the TX queue */
+    double theoretical_cps;         /* Characters per second the line can carry */
+    double achieved_cps;            /* Characters per second while bytes were waiting */
+    double utilization_pct;         /* achieved / theoretical */
+} serial_tx_pace_stats_t;
 
 /* Serial port configuration for Level 3 */
 typedef struct {
@@ -43,6 +107,24 @@ typedef struct {
     time_t last_xoff_time;          /* Last XOFF received time */
     size_t tx_flow_watermark;       /* TX flow control high watermark */
     size_t rx_flow_watermark;       /* RX flow control high watermark */
+
+    /* Asynchronous transmission */
+    serial_tx_queue_t txq;          /* Bytes waiting for room in the driver FIFO */
+
+    /* Receive latency (serial_tune_latency, serial_set_rx_profile) */
+    rx_profile_t rx_mode;           /* SERIAL_RX_PROFILE */
+    const serial_rx_profile_t *rx_profile;  /* Profile in effect */
+    bool low_latency;               /* ASYNC_LOW_LATENCY in effect */
+    bool low_latency_set;           /* ... and set by us (cleared on close) */
+    int latency_timer_ms;           /* USB adapter latency_timer (-1 = none) */
+    int latency_timer_orig;         /* Value before we changed it (-1 = untouched) */
+    char latency_timer_path[SMALL_BUFFER_SIZE];
+    int probe_rtt_us;               /* Best AT round trip at startup (-1 = not measured) */
+
+    /* serial_read_line() accumulator (per port, so lines can read in parallel) */
+    char line_buf[512];
+    size_t line_pos;
+    size_t line_len;
 } serial_port_t;
 
 /* Function prototypes */
@@ -100,23 +182,131 @@ int serial_set_baudrate(serial_port_t *port, speed_t baudrate);
 ssize_t serial_read(serial_port_t *port, void *buffer, size_t size);
 
 /**
- * Write data to serial port
+ * Read data from serial port with explicit timeout
+ * @param port Serial port structure
+ * @param buffer Buffer to store read data
+ * @param size Maximum bytes to read
+ * @param timeout_ms epoll_wait timeout in milliseconds (0 = poll only)
+ * @return Number of bytes read, 0 on timeout, or error code on failure
+ */
+ssize_t serial_read_timeout(serial_port_t *port, void *buffer, size_t size, int timeout_ms);
+
+/**
+ * Write data to serial port (non-blocking)
+ * Data is appended to the port's TX queue and handed to the driver as the
+ * driver FIFO drains (see serial_tx_pump); the call never waits for the UART.
+ * Bytes queued while TX is blocked by flow control are sent after XON/CTS.
  * @param port Serial port structure
  * @param buffer Data to write
  * @param size Number of bytes to write
- * @return Number of bytes written, or error code on failure
+ * @return Number of bytes accepted (less than size when the queue is full,
+ *         0 = backpressure), or error code on failure
  */
 ssize_t serial_write(serial_port_t *port, const void *buffer, size_t size);
 
 /**
- * Write data to serial port using epoll for write readiness
- * Uses EPOLLOUT to check if port is ready for writing before attempting write
- * Handles partial writes automatically with retry logic
+ * Write a chunk stamped with its ingress time (see latency.h)
  * @param port Serial port structure
  * @param buffer Data to write
  * @param size Number of bytes to write
- * @param timeout_ms Timeout in milliseconds for epoll_wait (0 = no wait, -1 = infinite)
- * @return Number of bytes written, or error code on failure
+ * @param stamp Stamp from the queue the data came from (NULL = untagged)
+ * @return Number of bytes accepted, or error code on failure (as serial_write())
+ */
+ssize_t serial_write_stamped(serial_port_t *port, const void *buffer, size_t size,
+                             const latency_stamp_t *stamp);
+
+/**
+ * Move queued TX bytes into the driver up to the target FIFO fill
+ * Called from serial_write() and serial_read_timeout(); event loops call it
+ * when serial_tx_next_timeout_ms() expires.
+ * @param port Serial port structure
+ * @return Bytes handed to the driver, or error code on write failure
+ */
+ssize_t serial_tx_pump(serial_port_t *port);
+
+/**
+ * Bytes accepted by serial_write() but not yet handed to the driver
+ * @param port Serial port structure
+ * @return Queued byte count
+ */
+size_t serial_tx_pending(serial_port_t *port);
+
+/**
+ * Free space in the TX queue (0 = serial_write() will apply backpressure)
+ * While paced, at most SERIAL_TX_PACE_QUEUE_US of line time is offered, so
+ * callers leave the rest in their own buffers instead of queueing seconds
+ * of slow-line data here.
+ * @param port Serial port structure
+ * @return Bytes serial_write() can accept now
+ */
+size_t serial_tx_space(serial_port_t *port);
+
+/**
+ * Bytes the driver can take now without a long blocking write
+ * The driver is kept at SERIAL_TX_FIFO_US of line time, like the TX queue
+ * pump does; for writers that bypass the queue (splice passthrough).
+ * @param port Serial port structure
+ * @return Free room below the driver fill target (0 = wait for the line)
+ */
+size_t serial_tx_driver_room(serial_port_t *port);
+
+/**
+ * Milliseconds until the TX queue needs another pump
+ * @param port Serial port structure
+ * @return 0 = pump now, -1 = nothing queued (or TX blocked until XON)
+ */
+int serial_tx_next_timeout_ms(serial_port_t *port);
+
+/**
+ * Pace the TX queue at the modem's carrier rate
+ * The bucket starts full and is reset on every call, as are the
+ * utilization figures.
+ * @param port Serial port structure
+ * @param bps Carrier rate from CONNECT (0 = none, report against the DTE rate)
+ */
+void serial_tx_set_line_rate(serial_port_t *port, int bps);
+
+/**
+ * Feed the process, output and device stages to a direction's histograms
+ * The device stage estimates when the last byte of a chunk leaves the UART
+ * from the driver FIFO fill (TIOCOUTQ) and the character time.
+ * @param port Serial port structure
+ * @param metrics Telnet -> serial direction counters (NULL = off)
+ */
+void serial_set_latency_metrics(serial_port_t *port, metrics_direction_t *metrics);
+
+/**
+ * Achieved vs. theoretical line utilization since the rate was set
+ * @param port Serial port structure
+ * @param stats Filled with the current figures
+ * @return SUCCESS on success, ERROR_INVALID_ARG on NULL arguments
+ */
+int serial_tx_get_pace_stats(serial_port_t *port, serial_tx_pace_stats_t *stats);
+
+/**
+ * Check whether all written data has left the UART
+ * @param port Serial port structure
+ * @return true if the TX queue and the driver FIFO are both empty
+ */
+bool serial_tx_complete(serial_port_t *port);
+
+/**
+ * Wait until all written data has left the UART (tcdrain for the TX queue)
+ * @param port Serial port structure
+ * @param timeout_ms Maximum wait in milliseconds (-1 = no limit)
+ * @return SUCCESS, ERROR_TIMEOUT if data is still queued, or error code
+ */
+int serial_tx_drain(serial_port_t *port, int timeout_ms);
+
+/**
+ * Write data to serial port, waiting for TX queue space
+ * Like serial_write(), but waits up to timeout_ms while the queue is full
+ * so the whole buffer is accepted (it does not wait for transmission)
+ * @param port Serial port structure
+ * @param buffer Data to write
+ * @param size Number of bytes to write
+ * @param timeout_ms Timeout in milliseconds (0 = no wait, -1 = infinite)
+ * @return Number of bytes accepted, or error code on failure
  */
 ssize_t serial_write_with_epoll(serial_port_t *port, const void *buffer, size_t size, int timeout_ms);
 
@@ -195,6 +385,26 @@ bool serial_is_open(serial_port_t *port);
  */
 ssize_t serial_read_line(serial_port_t *port, char *buffer, size_t size, int timeout_sec);
 
+/**
+ * Read a line from serial port with a millisecond timeout
+ * Waits on the port's epoll instance and keeps queued TX data moving.
+ * @param port Serial port structure
+ * @param buffer Buffer to store line
+ * @param size Maximum buffer size
+ * @param timeout_ms Timeout in milliseconds
+ * @return Number of bytes read (excluding line terminator), ERROR_TIMEOUT or ERROR_IO
+ */
+ssize_t serial_read_line_ms(serial_port_t *port, char *buffer, size_t size, int timeout_ms);
+
+/**
+ * Take the bytes serial_read_line() has buffered but not returned
+ * @param port Serial port structure
+ * @param buffer Receives the bytes (may be NULL to discard them)
+ * @param size Size of buffer
+ * @return Number of bytes taken
+ */
+size_t serial_line_flush(serial_port_t *port, char *buffer, size_t size);
+
 /**
  * Lock serial port using UUCP-style lock file
  * Creates /var/lock/LCK..ttyUSB0 style lock file
@@ -206,11 +416,18 @@ int serial_lock_port(const char *device);
 
 /**
  * Unlock serial port
- * Removes UUCP-style lock file
+ * Removes every UUCP-style lock file held by this process
  * Based on modem_sample/serial_port.c
  */
 void serial_unlock_port(void);
 
+/**
+ * Unlock a single serial port locked with serial_lock_port()
+ * Used in multi-line mode where several ports are locked at once
+ * @param device Device path (e.g., /dev/ttyUSB0)
+ */
+void serial_unlock_device(const char *device);
+
 /**
  * Enable carrier detect (DCD) monitoring
  * Clears CLOCAL flag to enable carrier detect
@@ -265,7 +482,8 @@ int serial_dtr_drop_hangup(serial_port_t *port);
 /**
  * Buffered serial transmission for large data
  * Based on modem_sample/serial_port.c:buffered_serial_send()
- * Splits large data into chunks (TX_CHUNK_SIZE) with delays (TX_CHUNK_DELAY_US)
+ * Feeds the TX queue (paced by driver FIFO fill instead of fixed delays),
+ * checks carrier between chunks and returns once the data has been sent
  * Prevents receiver buffer overflow with slow modems
  * @param port Serial port structure
  * @param buffer Data to transmit
@@ -363,6 +581,60 @@ int serial_send_xon(serial_port_t *port);
  */
 int serial_send_xoff(serial_port_t *port);
 
+/**
+ * Cut the receive latency of the port
+ * Sets ASYNC_LOW_LATENCY (TIOCSSERIAL) so the driver hands received bytes
+ * to the tty layer at once, and writes the latency_timer of USB adapters
+ * that have one (FTDI: 16 ms by default, the time a partly filled USB
+ * packet is held back). Both are put back by serial_close().
+ * Ports without these controls (PL2303, CDC-ACM, pty) are left as they are.
+ * @param port Open serial port
+ * @param low_latency Set ASYNC_LOW_LATENCY
+ * @param latency_timer_ms latency_timer to write (0 = leave as is)
+ * @return SUCCESS, or ERROR_IO if a setting the port has could not be changed
+ */
+int serial_tune_latency(serial_port_t *port, bool low_latency, int latency_timer_ms);
+
+/**
+ * Apply the receive profile for a line rate
+ * All profiles keep VMIN=1/VTIME=0: a VTIME batch holds the last bytes of
+ * every burst for at least 100 ms, and VMIN>1 without VTIME keeps epoll
+ * from reporting single keystrokes. Profiles differ in the read size.
+ * @param port Open serial port
+ * @param bps Line rate (carrier rate while online, else the DTE rate)
+ * @return SUCCESS, or ERROR_IO if the termios settings could not be applied
+ */
+int serial_set_rx_profile(serial_port_t *port, int bps);
+
+/**
+ * Bytes to read per pass under the current receive profile
+ * @param port Serial port
+ * @param buffer_size Size of the caller's buffer
+ * @return Read size, at most buffer_size
+ */
+size_t serial_rx_read_size(const serial_port_t *port, size_t buffer_size);
+
+/**
+ * Parse a SERIAL_RX_PROFILE name (auto, low, medium, high)
+ * @return SUCCESS, or ERROR_CONFIG for an unknown name
+ */
+int serial_parse_rx_profile(const char *name, rx_profile_t *profile);
+
+/**
+ * Name of a SERIAL_RX_PROFILE setting
+ */
+const char *serial_rx_profile_name(rx_profile_t profile);
+
+/**
+ * Buffer size for a line rate
+ * 512/1024/2048 bytes up to 1200/2400/9600 bps; faster lines get
+ * base_size or half a second of line data, whichever is larger.
+ * @param bps Line rate in bits per second (0 or less = unknown)
+ * @param base_size Size for unknown and high rates
+ * @return Buffer size in bytes
+ */
+size_t serial_buffer_size_for_speed(int bps, size_t base_size);
+
 /**
  * Get optimal buffer size for current speed and flow control
  * @param port Serial port structure
@@ -11,12 +11,17 @@
 #ifdef ENABLE_LEVEL2
 
 #include "common.h"
+#include "bufpool.h"
+#include "resolver.h"
+#include "dialdir.h"
+#include "latency.h"
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <netdb.h>
 #include <sys/epoll.h>
 #include <fcntl.h>
+#include <pthread.h>
 
 /* Telnet protocol constants (RFC 854) */
 #define TELNET_IAC          255     /* Interpret As Command */
@@ -49,6 +54,7 @@
 #define TELOPT_LFLOW        33      /* Remote flow control */
 #define TELOPT_LINEMODE     34      /* Linemode */
 #define TELOPT_ENVIRON      36      /* Environment variables */
+#define TELOPT_COMPRESS2    86      /* MCCP2: zlib stream from the server */
 
 /* TERMINAL-TYPE subnegotiation codes (RFC 1091) */
 #define TTYPE_IS            0       /* Terminal type IS */
@@ -66,6 +72,56 @@
 #define MODE_SOFT_TAB       0x08    /* Soft tab */
 #define MODE_LIT_ECHO       0x10    /* Literal echo */
 
+/* Connection attempt delay before racing the next address (RFC 8305) */
+#define TELNET_ATTEMPT_DELAY_MS 250
+
+/* Default TELNET_CONNECT_TIMEOUT: give up on a server before the kernel does (~2 min) */
+#define TELNET_CONNECT_TIMEOUT_MS 5000
+
+/* Negotiation fast start: per-server transcripts reused on the next connect */
+#define TELNET_NEGCACHE_SIZE    16      /* Servers remembered (least recently used is evicted) */
+
+/* Output queue: bufpool segments flushed with one sendmsg() (scatter/gather) */
+#define TELNET_OUTQ_SEGMENTS    16      /* Segments per connection (queue grows to this) */
+#define TELNET_CORK_CHARS       3       /* Coalescing window, in character times at the line rate */
+#define TELNET_CORK_MAX_US      20000   /* Longest coalescing window */
+#define TELNET_CORK_BYTES       1024    /* Queued bytes that end the window early */
+
+/* One output queue segment */
+typedef struct {
+    unsigned char *data;            /* Slab chunk (NULL = slot unused) */
+    size_t size;                    /* Chunk size */
+    size_t head;                    /* First unsent byte */
+    size_t tail;                    /* End of queued data */
+} telnet_segment_t;
+
+/* One bit per telnet option (32 bytes instead of bool[256]) */
+typedef struct {
+    uint32_t bits[256 / 32];
+} telnet_optset_t;
+
+/**
+ * Check whether an option is in a set
+ */
+static inline bool telnet_opt_test(const telnet_optset_t *set, unsigned char option)
+{
+    return (set->bits[option >> 5] >> (option & 31)) & 1u;
+}
+
+/**
+ * Add an option to a set or remove it
+ */
+static inline void telnet_opt_set(telnet_optset_t *set, unsigned char option, bool on)
+{
+    uint32_t mask = 1u << (option & 31);
+
+    if (on) {
+        set->bits[option >> 5] |= mask;
+    } else {
+        set->bits[option >> 5] &= ~mask;
+    }
+}
+
 /* Telnet state machine states */
 typedef enum {
     TELNET_STATE_DATA,          /* Normal data */
@@ -86,18 +142,36 @@ typedef struct {
     int port;                       /* Remote port */
     bool is_connected;              /* Connection status */
     bool is_connecting;             /* Connection in progress */
+    bool is_resolving;              /* Waiting for the resolver thread (fd is its wake-up eventfd) */
+
+    /* Connection attempts (happy eyeballs, RFC 8305) */
+    resolver_result_t candidates;   /* Resolved addresses, families interleaved */
+    int next_candidate;             /* Next address to try */
+    int race_fd;                    /* Attempt racing fd (-1 = none) */
+    long long attempt_ms;           /* Start of the newest attempt (CLOCK_MONOTONIC) */
+    long long connect_start_ms;     /* Start of the connect to this host (CLOCK_MONOTONIC) */
+    int connect_timeout_ms;         /* Give up (or fail over) after this long (0 = never) */
+    dialdir_lease_t lease;          /* Dialing directory backend held (target NULL = none) */
 
     /* Protocol state */
     telnet_state_t state;           /* Current protocol state */
     unsigned char option;           /* Current option being negotiated */
 
-    /* Subnegotiation buffer */
-    unsigned char sb_buffer[BUFFER_SIZE];
+    /* Subnegotiation buffer (TTYPE, NAWS, LINEMODE payloads; longer ones are truncated) */
+    unsigned char sb_buffer[SMALL_BUFFER_SIZE];
     size_t sb_len;
+    bool overflow_warned;           /* Input truncation already logged this session */
 
     /* Option tracking */
-    bool local_options[256];        /* Options we support locally */
-    bool remote_options[256];       /* Options remote supports */
+    telnet_optset_t local_options;  /* Options we support locally */
+    telnet_optset_t remote_options; /* Options remote supports */
+
+    /* Negotiation transcript: what the server agreed to this session */
+    bool fast_start;                /* Send the cached transcript on connect (TELNET_FAST_START) */
+    bool neg_seen;                  /* The server negotiated at all */
+    telnet_optset_t neg_local;      /* DO received for options we enable */
+    telnet_optset_t neg_remote;     /* WILL received for options we accept */
+    bool neg_ttype;                 /* Server asked for TERMINAL-TYPE */
 
     /* Mode flags (bidirectional - RFC 855 compliant) */
     bool binary_local;              /* We send binary */
@@ -130,14 +204,41 @@ typedef struct {
     bool can_write;                 /* Socket is writable */
     bool has_error;                 /* Socket has error */
 
-    /* Non-blocking I/O buffers */
-    unsigned char read_buf[BUFFER_SIZE];  /* Read buffer */
+    /* Non-blocking I/O buffers (slab chunks, allocated on first use) */
+    size_t buffer_size;             /* Read buffer size; write buffer is twice that */
+    unsigned char *read_buf;        /* Read buffer */
+    size_t read_buf_size;
     size_t read_pos;                /* Read buffer position */
     size_t read_len;                /* Read buffer length */
 
-    unsigned char write_buf[BUFFER_SIZE * 2]; /* Write buffer */
-    size_t write_pos;               /* Write buffer position */
-    size_t write_len;               /* Write buffer length */
+    /* TELNET_RAW: the peer speaks plain TCP. No options are negotiated, no
+     * IAC is interpreted or escaped and no keep-alive NOP is sent. */
+    bool raw_tcp;
+
+    /* MCCP2: bytes after IAC SB COMPRESS2 IAC SE are inflated by telnet_recv() */
+    bool compress_enabled;          /* Accept WILL COMPRESS2 (TELNET_COMPRESS) */
+    bool compress_active;           /* Server stream is compressed */
+    bool compress_out_full;         /* Last inflate filled the caller's buffer (more may follow) */
+    struct z_stream_s *zstream;     /* Inflate state (kept and reset between streams) */
+    unsigned char *zin_buf;         /* Received bytes not yet inflated (slab chunk) */
+    size_t zin_buf_size;
+    size_t zin_pos;                 /* First unread byte */
+    size_t zin_len;                 /* End of unread bytes */
+    uint64_t compress_bytes_in;     /* Compressed bytes received */
+    uint64_t compress_bytes_out;    /* Bytes they inflated to */
+
+
+    /* Output queue: the only writer of the socket (shared by all threads) */
+    pthread_mutex_t out_lock;       /* Protects the out_* fields */
+    telnet_segment_t out_seg[TELNET_OUTQ_SEGMENTS]; /* Ring of segments */
+    int out_first;                  /* Oldest segment in use */
+    int out_count;                  /* Segments in use */
+    size_t out_bytes;               /* Bytes queued */
+    long long out_since_us;         /* When the oldest queued byte arrived (CLOCK_MONOTONIC) */
+    bool out_urgent;                /* Protocol replies queued: send without coalescing */
+    bool out_blocked;               /* Socket buffer full: waiting for EPOLLOUT */
+    unsigned int cork_us;           /* Coalescing window for data (0 = send at once) */
+    latency_tags_t out_tags;        /* Ingress stamps of queued data (see latency.h) */
 
     /* Connection health monitoring */
     time_t last_activity;           /* Last data send/receive timestamp */
@@ -164,13 +265,31 @@ void telnet_init(telnet_t *tn);
 
 /**
  * Connect to telnet server
+ * Resolves through the DNS cache and connects without blocking: a name
+ * not cached is looked up on the resolver thread (is_resolving) and the
+ * connect goes on from telnet_process_events() when the answer lands.
+ * Every address (IPv4 and IPv6) is tried, the next one racing a slow
+ * attempt after TELNET_ATTEMPT_DELAY_MS. Completion is reported by
+ * telnet_process_events().
  * @param tn Telnet structure
- * @param host Remote host (IP or hostname)
+ * @param host Remote host (IPv4/IPv6 address or hostname)
  * @param port Remote port
  * @return SUCCESS on success, error code on failure
  */
 int telnet_connect(telnet_t *tn, const char *host, int port);
 
+/**
+ * Connect to a dialing directory target
+ * Takes the least-loaded healthy backend of the target. A backend that
+ * refuses, or is still connecting after connect_timeout_ms, is marked down
+ * and the next backend is tried from telnet_process_events(); the connect
+ * fails only when every backend was tried.
+ * @param tn Telnet structure
+ * @param target Target (see dialdir.h)
+ * @return SUCCESS when an attempt is running or connected, error code otherwise
+ */
+int telnet_connect_target(telnet_t *tn, dialdir_target_t *target);
+
 /**
  * Disconnect from telnet server
  * @param tn Telnet structure
@@ -181,6 +300,7 @@ int telnet_disconnect(telnet_t *tn);
 /**
  * Process incoming data from telnet server
  * Handles IAC sequences and returns clean data
+ * output may equal input to compact in place (e.g. inside a reserved ring span).
  * @param tn Telnet structure
  * @param input Input data buffer
  * @param input_len Input data length
@@ -206,17 +326,62 @@ int telnet_process_input(telnet_t *tn, const unsigned char *input, size_t input_
 int telnet_prepare_output(telnet_t *tn, const unsigned char *input, size_t input_len,
                           unsigned char *output, size_t output_size, size_t *output_len);
 
+/**
+ * Escape IAC bytes (0xFF -> 0xFF 0xFF) as far as the output allows
+ * Never splits an escaped pair.
+ * @param input Input data buffer
+ * @param input_len Input data length
+ * @param output Output buffer for escaped data
+ * @param output_size Size of output buffer
+ * @param output_len Receives the output length
+ * @return Input bytes taken
+ */
+size_t telnet_escape_iac(const unsigned char *input, size_t input_len,
+                         unsigned char *output, size_t output_size, size_t *output_len);
+
 /**
  * Send data to telnet server
+ * Appends to the output queue (as much as fits) and flushes it when the
+ * coalescing window allows.
  * @param tn Telnet structure
  * @param data Data to send
  * @param len Data length
- * @return Number of bytes sent, or error code on failure
+ * @return Number of bytes accepted (0 = queue full), or error code on failure
  */
 ssize_t telnet_send(telnet_t *tn, const void *data, size_t len);
 
+/**
+ * Send a chunk stamped with its ingress time (see latency.h)
+ * @param tn Telnet structure
+ * @param data Data to send
+ * @param len Data length
+ * @param stamp Stamp from the queue the data came from (NULL = untagged)
+ * @return Number of bytes accepted (0 = queue full), or error code on failure
+ */
+ssize_t telnet_send_stamped(telnet_t *tn, const void *data, size_t len, const latency_stamp_t *stamp);
+
+/**
+ * Bytes telnet_send() can accept right now
+ * A snapshot: other writers of the queue may take some of it first.
+ * @param tn Telnet structure
+ * @return Free space in the output queue
+ */
+size_t telnet_send_space(telnet_t *tn);
+
+/**
+ * Send bytes waiting in a pipe straight to the socket with splice()
+ * Only while the output queue is empty, so queued data keeps its order.
+ * @param tn Telnet structure
+ * @param pipe_fd Read end of the pipe
+ * @param len Bytes in the pipe
+ * @return Bytes sent (0 = queue busy or socket full), or error code on failure
+ */
+ssize_t telnet_send_splice(telnet_t *tn, int pipe_fd, size_t len);
+
 /**
  * Receive data from telnet server
+ * While MCCP2 is active the data is inflated first, so the result is always
+ * the plain telnet stream for telnet_process_input().
  * @param tn Telnet structure
  * @param buffer Buffer to store received data
  * @param size Maximum bytes to receive
@@ -257,6 +422,24 @@ int telnet_handle_negotiate(telnet_t *tn, unsigned char command, unsigned char o
  */
 int telnet_handle_subnegotiation(telnet_t *tn);
 
+/**
+ * Check whether telnet_recv() has input that is not in the socket
+ * Compressed (MCCP2) data already read, or inflated output larger than the
+ * last caller's buffer; pollers must not wait for the socket while true.
+ * @param tn Telnet structure
+ * @return true if telnet_recv() should be called again
+ */
+bool telnet_recv_pending(telnet_t *tn);
+
+/**
+ * Get MCCP2 compression counters
+ * @param tn Telnet structure
+ * @param compressed Receives compressed bytes received
+ * @param inflated Receives the bytes they inflated to
+ * @return SUCCESS on success, error code on failure
+ */
+int telnet_get_compress_stats(telnet_t *tn, uint64_t *compressed, uint64_t *inflated);
+
 /**
  * Get file descriptor for select/poll
  * @param tn Telnet structure
@@ -328,17 +511,57 @@ bool telnet_has_error(telnet_t *tn);
  * @param tn Telnet structure
  * @param data Data to write
  * @param len Data length
- * @return SUCCESS on success, error code on failure
+ * @return SUCCESS on success, ERROR_BUFFER_FULL if the queue cannot take all of it
  */
 int telnet_queue_write(telnet_t *tn, const void *data, size_t len);
 
 /**
- * Process pending write data for telnet connection
+ * Queue a chunk stamped with its ingress time for writing (non-blocking)
  * @param tn Telnet structure
- * @return SUCCESS on success, error code on failure
+ * @param data Data to write
+ * @param len Data length
+ * @param stamp Stamp from the queue the data came from (NULL = untagged)
+ * @return SUCCESS on success, ERROR_BUFFER_FULL if the queue cannot take all of it
+ */
+int telnet_queue_write_stamped(telnet_t *tn, const void *data, size_t len, const latency_stamp_t *stamp);
+
+/**
+ * Send queued data whose coalescing window has ended
+ * Small writes wait up to TELNET_CORK_CHARS character times so keystrokes
+ * share TCP segments; protocol replies and full windows go out at once.
+ * @param tn Telnet structure
+ * @return SUCCESS on success (data may stay queued), ERROR_IO on socket error
  */
 int telnet_flush_writes(telnet_t *tn);
 
+/**
+ * Milliseconds until telnet_flush_writes() has data to send
+ * @param tn Telnet structure
+ * @return 0 if due now, -1 if nothing is queued or the socket is full (wait for EPOLLOUT)
+ */
+int telnet_write_timeout_ms(telnet_t *tn);
+
+/**
+ * Check whether queued output waits for the socket to become writable
+ * @param tn Telnet structure
+ * @return true if an event loop should wait for EPOLLOUT
+ */
+bool telnet_write_blocked(telnet_t *tn);
+
+/**
+ * Size the output coalescing window for the line rate
+ * @param tn Telnet structure
+ * @param bps Serial line rate (0 = no coalescing)
+ */
+void telnet_set_line_rate(telnet_t *tn, int bps);
+
+/**
+ * Feed the process and output stages to a direction's histograms
+ * @param tn Telnet structure
+ * @param metrics Serial -> telnet direction counters (NULL = off)
+ */
+void telnet_set_latency_metrics(telnet_t *tn, metrics_direction_t *metrics);
+
 /**
  * Process pending read data for telnet connection
  * @param tn Telnet structure
@@ -362,6 +585,21 @@ int telnet_check_connection_health(telnet_t *tn);
  */
 void telnet_update_activity(telnet_t *tn);
 
+/**
+ * Set the size of the non-blocking I/O buffers
+ * Takes effect when the buffers are next allocated (empty buffers are
+ * released immediately so the new size applies on first use).
+ * @param tn Telnet structure
+ * @param size Read buffer and output segment size in bytes (0 = BUFFER_SIZE)
+ */
+void telnet_set_buffer_size(telnet_t *tn, size_t size);
+
+/**
+ * Release the non-blocking I/O buffers (pending data is discarded)
+ * @param tn Telnet structure
+ */
+void telnet_release_buffers(telnet_t *tn);
+
 /**
  * Enable/disable keep-alive functionality
  * @param tn Telnet structure
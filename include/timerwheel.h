@@ -0,0 +1,113 @@
+/*
+ * timerwheel.h - Hierarchical timer wheel for event-loop threads
+ *
+ * Each event-loop thread (the single-line event thread, every multi-line
+ * worker) owns one wheel and one timerfd. Timers are intrusive, so
+ * scheduling and cancelling never allocate, and both are O(1). Time is in
+ * CLOCK_MONOTONIC milliseconds.
+ *
+ * Level 0 has one slot per millisecond. Each higher level covers
+ * TIMERWHEEL_SLOTS times the span of the one below. A timer is placed on
+ * the level that fits its distance and moves down level by level as the
+ * wheel turns. Deadlines beyond the top level are parked there and placed
+ * again when that slot comes round.
+ *
+ * A wheel belongs to one thread: it has no lock, and callbacks run inside
+ * timerwheel_advance() on that thread.
+ */
+
+#ifndef MODEMBRIDGE_TIMERWHEEL_H
+#define MODEMBRIDGE_TIMERWHEEL_H
+
+#include "common.h"
+
+#define TIMERWHEEL_BITS         6
+#define TIMERWHEEL_SLOTS        (1 << TIMERWHEEL_BITS)
+#define TIMERWHEEL_LEVELS       4       /* Span: 64^4 ms, about 4.6 hours */
+
+typedef void (*timerwheel_callback_t)(void *arg);
+
+/* One timer, embedded in its owner */
+typedef struct timerwheel_timer_s {
+    struct timerwheel_timer_s *next;
+    struct timerwheel_timer_s **pprev;  /* NULL = not scheduled */
+    long long expires_ms;               /* Deadline */
+    int level;                          /* Slot holding the timer */
+    int slot;
+    timerwheel_callback_t callback;
+    void *arg;
+} timerwheel_timer_t;
+
+/* Wheel */
+typedef struct {
+    long long now_ms;                   /* Last millisecond processed */
+    int count;                          /* Scheduled timers */
+    uint64_t occupied[TIMERWHEEL_LEVELS];   /* Non-empty slots per level */
+    timerwheel_timer_t *slots[TIMERWHEEL_LEVELS][TIMERWHEEL_SLOTS];
+    long long armed_ms;                 /* Deadline programmed into the timerfd (0 = none) */
+} timerwheel_t;
+
+/* Function prototypes */
+
+/**
+ * Initialize an empty wheel
+ * @param tw Wheel
+ * @param now_ms Current CLOCK_MONOTONIC time in milliseconds
+ */
+void timerwheel_init(timerwheel_t *tw, long long now_ms);
+
+/**
+ * Initialize a timer (not scheduled)
+ * @param timer Timer
+ * @param callback Function run when the timer expires
+ * @param arg Callback argument
+ */
+void timerwheel_timer_init(timerwheel_timer_t *timer, timerwheel_callback_t callback, void *arg);
+
+/**
+ * Schedule a timer, or move it if it is already scheduled
+ * A deadline that has already passed fires on the next timerwheel_advance().
+ * @param tw Wheel
+ * @param timer Timer
+ * @param expires_ms Deadline (CLOCK_MONOTONIC milliseconds)
+ */
+void timerwheel_schedule(timerwheel_t *tw, timerwheel_timer_t *timer, long long expires_ms);
+
+/**
+ * Cancel a timer (no effect if it is not scheduled)
+ */
+void timerwheel_cancel(timerwheel_t *tw, timerwheel_timer_t *timer);
+
+/**
+ * Check whether a timer is scheduled
+ */
+bool timerwheel_pending(const timerwheel_timer_t *timer);
+
+/**
+ * Run every timer that expired up to now_ms
+ * Callbacks may schedule or cancel any timer, including their own.
+ * @param tw Wheel
+ * @param now_ms Current CLOCK_MONOTONIC time in milliseconds
+ * @return Number of callbacks run
+ */
+int timerwheel_advance(timerwheel_t *tw, long long now_ms);
+
+/**
+ * Earliest time the wheel needs to be advanced
+ * This is exact for level 0. For higher levels it is the moment their
+ * timers move down a level, which may come before the deadline itself.
+ * @param tw Wheel
+ * @return CLOCK_MONOTONIC milliseconds, -1 if no timer is scheduled
+ */
+long long timerwheel_next_ms(const timerwheel_t *tw);
+
+/**
+ * Program a timerfd (CLOCK_MONOTONIC, absolute) for timerwheel_next_ms()
+ * The timerfd is only reprogrammed when the deadline changes.
+ * @param tw Wheel
+ * @param timer_fd timerfd descriptor
+ * @return SUCCESS on success, ERROR_IO if timerfd_settime() fails
+ */
+int timerwheel_arm_timerfd(timerwheel_t *tw, int timer_fd);
+
+#endif /* MODEMBRIDGE_TIMERWHEEL_H */
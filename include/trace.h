@@ -0,0 +1,126 @@
+/*
+ * trace.h - Binary tracepoints for ModemBridge data paths
+ *
+ * Hot paths record fixed-size binary events instead of formatting text.
+ * Each thread appends to its own lock-free ring; a drain thread copies the
+ * rings to TRACE_FILE, which is decoded offline with --dump-trace.
+ *
+ * Tracing is off by default. A disabled tracepoint costs one load and one
+ * predicted-not-taken branch; its arguments are not evaluated. Toggle at
+ * runtime with SIGUSR2 (or TRACE_ENABLED=1 to start enabled).
+ */
+
+#ifndef MODEMBRIDGE_TRACE_H
+#define MODEMBRIDGE_TRACE_H
+
+#include "common.h"
+#include <stdatomic.h>
+
+/* Ring and record sizing */
+#define TRACE_RING_RECORDS      4096    /* Records per thread (power of two) */
+#define TRACE_DATA_MAX          32      /* Payload bytes captured per record */
+#define TRACE_DRAIN_MS          100     /* Drain interval while enabled */
+
+#define DEFAULT_TRACE_FILE      "modembridge.trace"
+
+/* Trace file magic (written once at the start of the file) */
+#define TRACE_FILE_MAGIC        "MBTRACE1"
+#define TRACE_FILE_MAGIC_LEN    8
+
+/* Static tracepoint IDs (stored on disk: append only) */
+typedef enum {
+    TRACE_SERIAL_RX = 0,        /* arg0 = bytes read, data = first bytes */
+    TRACE_SERIAL_TX,            /* arg0 = bytes accepted, arg1 = bytes queued, data = first bytes */
+    TRACE_SERIAL_READ,          /* arg0 = serial_read() result, arg1 = Level (1/2) */
+    TRACE_BRIDGE_FORWARD,       /* arg0 = datalog direction, arg1 = bytes */
+    TRACE_BRIDGE_DROP,          /* arg0 = datalog direction, arg1 = bytes dropped */
+    TRACE_MODEM_ONLINE_DATA,    /* arg0 = bytes consumed online, arg1 = Level (1/2) */
+    TRACE_TIMESTAMP_SEND,       /* arg0 = timestamp_result_t */
+    TRACE_L3_FORWARD,           /* arg0 = bytes written to the pipeline buffer */
+    TRACE_L3_INACTIVE,          /* arg0 = level3_active, arg1 = system_state */
+    TRACE_L3_STATE,             /* arg0 = system_state, arg1 = L1 ready | L2 ready << 1 | DCD << 2 */
+    TRACE_L3_DCD,               /* arg0 = 1 rising / 0 falling, arg1 = system_state */
+    TRACE_L3_LINE,              /* arg0 = line bytes, arg1 = bytes after Hayes filter, data = line */
+    TRACE_L3_ECHO,              /* arg0 = bytes echoed, arg1 = bytes requested, data = echo */
+    TRACE_MODEM_HW_MESSAGE,     /* arg0 = bytes scanned, arg1 = message buffer bytes, data = buffer */
+    TRACE_XFER_MODE,            /* arg0 = xfer_protocol_t (0 = raw mode off), arg1 = sending direction / ended protocol */
+    TRACE_POINT_COUNT
+} trace_point_t;
+
+/* On-disk record (host byte order) */
+typedef struct {
+    uint64_t timestamp_ns;      /* CLOCK_MONOTONIC */
+    uint16_t point;             /* trace_point_t */
+    uint16_t data_len;          /* Captured payload bytes */
+    uint32_t thread_id;         /* Kernel thread ID */
+    uint64_t arg0;
+    uint64_t arg1;
+    uint8_t data[TRACE_DATA_MAX];
+} trace_record_t;
+
+_Static_assert(sizeof(trace_record_t) == 64, "trace record must stay one cache line");
+
+/* Global enable flag (read by every tracepoint) */
+extern atomic_int g_trace_enabled;
+
+/**
+ * Record an event with two arguments
+ */
+#define MB_TRACE(point, a0, a1) do { \
+    if (__builtin_expect(atomic_load_explicit(&g_trace_enabled, memory_order_relaxed), 0)) { \
+        trace_emit((point), (uint64_t)(a0), (uint64_t)(a1), NULL, 0); \
+    } \
+} while (0)
+
+/**
+ * Record an event with two arguments and up to TRACE_DATA_MAX payload bytes
+ */
+#define MB_TRACE_DATA(point, a0, a1, buf, len) do { \
+    if (__builtin_expect(atomic_load_explicit(&g_trace_enabled, memory_order_relaxed), 0)) { \
+        trace_emit((point), (uint64_t)(a0), (uint64_t)(a1), (buf), (size_t)(len)); \
+    } \
+} while (0)
+
+/* Function prototypes */
+
+/**
+ * Start the drain thread
+ * @param path Trace file (appended to)
+ * @param enabled Start with tracing enabled
+ * @return SUCCESS on success, error code on failure
+ */
+int trace_init(const char *path, bool enabled);
+
+/**
+ * Drain remaining records, stop the drain thread and free the rings
+ */
+void trace_shutdown(void);
+
+/**
+ * Append a record to the calling thread's ring (use the MB_TRACE macros)
+ * Drops the record (and counts it) when the ring is full.
+ */
+void trace_emit(trace_point_t point, uint64_t arg0, uint64_t arg1,
+                const void *data, size_t len);
+
+/**
+ * Toggle tracing (async-signal-safe, used by the SIGUSR2 handler)
+ */
+void trace_toggle(void);
+
+/**
+ * Name of a tracepoint
+ * @param point Tracepoint ID
+ * @return Static string ("unknown" for IDs from newer builds)
+ */
+const char *trace_point_name(unsigned int point);
+
+/**
+ * Print a trace file as text (offline tool, --dump-trace)
+ * @param path Trace file written by the drain thread
+ * @param out Output stream
+ * @return SUCCESS on success, error code on failure
+ */
+int trace_dump(const char *path, FILE *out);
+
+#endif /* MODEMBRIDGE_TRACE_H */
@@ -110,6 +110,9 @@ void util_stats_init(util_stats_t *stats);
 void util_stats_update(util_stats_t *stats, bool success, size_t bytes, double latency_ms);
 void util_stats_print(util_stats_t *stats, const char *operation_name);
 
+/* Byte scanning (SSE2/AVX2/NEON when the target has them, memchr otherwise) */
+size_t util_find_byte(const unsigned char *data, size_t len, unsigned char byte);
+
 /* Common constants */
 #define UTIL_MAX_MESSAGE_LEN        512
 #define UTIL_DEFAULT_PREFIX         "[modembridge]"
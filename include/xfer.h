@@ -0,0 +1,116 @@
+/*
+ * xfer.h - File transfer detection for the binary fast path
+ *
+ * XMODEM, YMODEM and ZMODEM need every byte delivered as sent, and at full
+ * line rate. The producer of each direction scans its chunks for transfer
+ * starts: a ZRQINIT/ZRINIT hex header, or an XMODEM/YMODEM block header
+ * answering the other side's NAK/'C'. While a transfer runs the line is in
+ * raw mode: data is only IAC-escaped towards the server and copied in bulk,
+ * bypassing the ANSI and Hayes filters, charset transcoding, the Level 3
+ * line editor and the Level 3 time slices. Raw mode ends on the protocol's
+ * own end (ZFIN both ways, EOT answered by ACK), on a CAN abort, or after
+ * XFER_IDLE_MS without data.
+ *
+ * With XFER_TELNET_BINARY=1 the line is also raw for as long as
+ * TELOPT_BINARY is in effect both ways.
+ *
+ * The mode is shared by all threads of a line; each direction's scan state
+ * belongs to the thread that produces that direction.
+ */
+
+#ifndef MODEMBRIDGE_XFER_H
+#define MODEMBRIDGE_XFER_H
+
+#include "common.h"
+#include <stdatomic.h>
+
+#define XFER_TAIL               4       /* Bytes kept to find headers split across chunks */
+#define XFER_HANDSHAKE_MS       10000   /* XMODEM: NAK/'C' to first block (receiver retry time) */
+#define XFER_IDLE_MS            10000   /* Raw mode ends after this long without data */
+#define XFER_ZMODEM_ABORT       5       /* CAN run that aborts a ZMODEM session */
+
+/* Transfer in progress (raw mode unless XFER_NONE) */
+typedef enum {
+    XFER_NONE = 0,
+    XFER_XMODEM,                        /* XMODEM / YMODEM (SOH/STX blocks) */
+    XFER_ZMODEM,
+    XFER_TELNET_BINARY                  /* TELOPT_BINARY both ways */
+} xfer_protocol_t;
+
+/* Direction, named by the side that sends */
+typedef enum {
+    XFER_FROM_MODEM = 0,                /* Terminal -> server */
+    XFER_FROM_TELNET,                   /* Server -> terminal */
+    XFER_DIR_COUNT
+} xfer_dir_t;
+
+/* Scan state of one direction */
+typedef struct {
+    unsigned char tail[XFER_TAIL];      /* End of the previous chunk */
+    size_t tail_len;
+    size_t can_run;                     /* CAN bytes ending the previous chunk */
+    _Atomic long long handshake_ms;     /* Last chunk ending in NAK/'C'/ACK (0 = none) */
+    atomic_bool zfin;                   /* ZMODEM: ZFIN sent */
+    atomic_bool eot;                    /* XMODEM: EOT sent */
+} xfer_side_t;
+
+/* Per-line detector */
+typedef struct {
+    bool enabled;                       /* XFER_FASTPATH */
+    bool telnet_binary;                 /* XFER_TELNET_BINARY */
+    atomic_int protocol;                /* xfer_protocol_t */
+    atomic_int sender;                  /* XMODEM: xfer_dir_t sending blocks */
+    _Atomic long long last_ms;          /* Last data while raw */
+    xfer_side_t side[XFER_DIR_COUNT];
+    atomic_uint_fast64_t transfers;     /* Raw mode entries */
+} xfer_detect_t;
+
+/* Function prototypes */
+
+/**
+ * Initialize a detector
+ * @param xf Detector
+ * @param enabled Detect transfers (XFER_FASTPATH)
+ * @param telnet_binary Raw while TELOPT_BINARY is on both ways (XFER_TELNET_BINARY)
+ */
+void xfer_init(xfer_detect_t *xf, bool enabled, bool telnet_binary);
+
+/**
+ * Leave raw mode and forget handshakes of a previous session
+ * The carried chunk tails stay; they only help find split headers.
+ */
+void xfer_reset(xfer_detect_t *xf);
+
+/**
+ * Scan one chunk before it is queued for the other side
+ * @param xf Detector
+ * @param dir Direction of the chunk
+ * @param data Chunk (after telnet decoding for XFER_FROM_TELNET)
+ * @param len Chunk length
+ * @param now_ms Ingress time (CLOCK_MONOTONIC milliseconds)
+ * @return true if this chunk belongs to a transfer and must pass raw
+ */
+bool xfer_scan(xfer_detect_t *xf, xfer_dir_t dir, const unsigned char *data, size_t len,
+               long long now_ms);
+
+/**
+ * Follow the TELOPT_BINARY state (no-op unless XFER_TELNET_BINARY)
+ * @param xf Detector
+ * @param both Binary in effect in both directions
+ */
+void xfer_set_binary(xfer_detect_t *xf, bool both);
+
+/**
+ * Check for raw mode, ending it when the transfer went idle
+ * @param xf Detector
+ * @param now_ms Current time (CLOCK_MONOTONIC milliseconds)
+ * @return true while queued data must pass raw
+ */
+bool xfer_active(xfer_detect_t *xf, long long now_ms);
+
+/**
+ * Name of a transfer protocol
+ */
+const char *xfer_protocol_name(xfer_protocol_t protocol);
+
+#endif /* MODEMBRIDGE_XFER_H */
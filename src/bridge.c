@@ -3,12 +3,22 @@
  */
 
 #include "bridge.h"
+#include "util.h"
+#include "trace.h"
+#include "healthcheck.h"
+#ifdef ENABLE_LEVEL2
+#include "resolver.h"
+#endif
 #include <sys/select.h>
 #include <sys/time.h>
 #include <time.h>
 #include <unistd.h>
 #include <string.h>
 #include <errno.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <poll.h>
 
 #ifdef ENABLE_LEVEL3
 #include "level3.h"
@@ -19,20 +29,46 @@
 static int bridge_transfer_telnet_to_serial(bridge_ctx_t *ctx);
 static void bridge_sync_echo_mode(bridge_ctx_t *ctx);
 #endif
+static int bridge_start_event_thread(bridge_ctx_t *ctx);
+static void bridge_stop_event_thread(bridge_ctx_t *ctx);
+static void bridge_event_service(void *arg);
+static long long bridge_monotonic_ms(void);
 
 /**
  * Initialize circular buffer
  */
-void cbuf_init(circular_buffer_t *buf)
+int cbuf_init(circular_buffer_t *buf, size_t size)
 {
     if (buf == NULL) {
-        return;
+        return ERROR_INVALID_ARG;
     }
 
     memset(buf, 0, sizeof(circular_buffer_t));
+    buf->data = bufpool_alloc(size, &buf->size);
+    if (buf->data == NULL) {
+        buf->size = 0;
+        return ERROR_GENERAL;
+    }
     buf->read_pos = 0;
     buf->write_pos = 0;
     buf->count = 0;
+
+    return SUCCESS;
+}
+
+/**
+ * Release circular buffer storage
+ */
+void cbuf_destroy(circular_buffer_t *buf)
+{
+    if (buf == NULL) {
+        return;
+    }
+
+    bufpool_free(buf->data, buf->size);
+    buf->data = NULL;
+    buf->size = 0;
+    buf->count = 0;
 }
 
 /**
@@ -46,12 +82,15 @@ size_t cbuf_write(circular_buffer_t *buf, const unsigned char *data, size_t len)
         return 0;
     }
 
-    while (written < len && buf->count < BUFFER_SIZE) {
-        buf->data[buf->write_pos] = data[written];
-        buf->write_pos = (buf->write_pos + 1) % BUFFER_SIZE;
-        buf->count++;
-        written++;
-    }
+    written = MIN(len, buf->size - buf->count);
+
+    /* Two contiguous spans at most: up to the end, then from the start */
+    size_t first = MIN(written, buf->size - buf->write_pos);
+    memcpy(buf->data + buf->write_pos, data, first);
+    memcpy(buf->data, data + first, written - first);
+
+    buf->write_pos = (buf->write_pos + written) % buf->size;
+    buf->count += written;
 
     return written;
 }
@@ -67,16 +106,72 @@ size_t cbuf_read(circular_buffer_t *buf, unsigned char *data, size_t len)
         return 0;
     }
 
-    while (read_count < len && buf->count > 0) {
-        data[read_count] = buf->data[buf->read_pos];
-        buf->read_pos = (buf->read_pos + 1) % BUFFER_SIZE;
-        buf->count--;
-        read_count++;
-    }
+    read_count = MIN(len, buf->count);
+
+    size_t first = MIN(read_count, buf->size - buf->read_pos);
+    memcpy(data, buf->data + buf->read_pos, first);
+    memcpy(data + first, buf->data, read_count - first);
+
+    buf->read_pos = (buf->read_pos + read_count) % buf->size;
+    buf->count -= read_count;
 
     return read_count;
 }
 
+/**
+ * Reserve contiguous free space for in-place writes
+ */
+unsigned char *cbuf_reserve(circular_buffer_t *buf, size_t len, size_t *granted)
+{
+    if (buf == NULL || granted == NULL) {
+        return NULL;
+    }
+
+    size_t space = buf->size - buf->count;
+    *granted = MIN(len, MIN(space, buf->size - buf->write_pos));
+    return buf->data + buf->write_pos;
+}
+
+/**
+ * Commit n bytes written into the reserved span
+ */
+void cbuf_commit(circular_buffer_t *buf, size_t n)
+{
+    if (buf == NULL) {
+        return;
+    }
+
+    buf->write_pos = (buf->write_pos + n) % buf->size;
+    buf->count += n;
+}
+
+/**
+ * Peek at the contiguous readable span
+ */
+const unsigned char *cbuf_peek(circular_buffer_t *buf, size_t *len)
+{
+    if (buf == NULL || len == NULL) {
+        return NULL;
+    }
+
+    *len = MIN(buf->count, buf->size - buf->read_pos);
+    return buf->data + buf->read_pos;
+}
+
+/**
+ * Drop n bytes from the front of the buffer
+ */
+void cbuf_consume(circular_buffer_t *buf, size_t n)
+{
+    if (buf == NULL) {
+        return;
+    }
+
+    n = MIN(n, buf->count);
+    buf->read_pos = (buf->read_pos + n) % buf->size;
+    buf->count -= n;
+}
+
 /**
  * Get available data in buffer
  */
@@ -98,7 +193,7 @@ size_t cbuf_free(circular_buffer_t *buf)
         return 0;
     }
 
-    return BUFFER_SIZE - buf->count;
+    return buf->size - buf->count;
 }
 
 /**
@@ -122,7 +217,7 @@ bool cbuf_is_full(circular_buffer_t *buf)
         return false;
     }
 
-    return buf->count >= BUFFER_SIZE;
+    return buf->count >= buf->size;
 }
 
 /**
@@ -141,19 +236,91 @@ void cbuf_clear(circular_buffer_t *buf)
 
 /* ========== Thread-safe circular buffer functions ========== */
 
+/*
+ * ts_circular_buffer_t is a single-producer/single-consumer ring: head is
+ * only written by the producer, tail only by the consumer, and both are
+ * free-running indexes masked by the power-of-two capacity. Producer and
+ * consumer never share a lock. producer_lock/consumer_lock only serialize
+ * a second thread on the same side (Level 3 local echo and the pipeline
+ * take over telnet->serial) and are uncontended otherwise.
+ *
+ * Blocking waits use eventfds instead of condvars. A side only signals
+ * when a waiter is registered and its action ended an empty/full state:
+ * the seq_cst fences pair the index update with the waiter check so
+ * either the waiter sees the new index or the other side sees the waiter.
+ */
+
+/**
+ * Signal an eventfd (counter saturation/EAGAIN means one is pending)
+ */
+static void ts_cbuf_signal(int fd)
+{
+    if (fd >= 0) {
+        uint64_t one = 1;
+        ssize_t ret = write(fd, &one, sizeof(one));
+        (void)ret;
+    }
+}
+
+/**
+ * Clear a pending eventfd signal
+ */
+static void ts_cbuf_drain(int fd)
+{
+    if (fd >= 0) {
+        uint64_t count;
+        ssize_t ret = read(fd, &count, sizeof(count));
+        (void)ret;
+    }
+}
+
+/**
+ * Milliseconds left until an absolute CLOCK_MONOTONIC deadline
+ */
+static int ts_cbuf_remaining_ms(const struct timespec *deadline)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    long long ms = (long long)(deadline->tv_sec - now.tv_sec) * 1000 +
+                   (deadline->tv_nsec - now.tv_nsec) / 1000000;
+    return (ms > 0) ? (int)ms : 0;
+}
+
 /**
  * Initialize thread-safe circular buffer
  */
-void ts_cbuf_init(ts_circular_buffer_t *tsbuf)
+int ts_cbuf_init(ts_circular_buffer_t *tsbuf, size_t capacity)
 {
     if (tsbuf == NULL) {
-        return;
+        return ERROR_INVALID_ARG;
     }
 
-    cbuf_init(&tsbuf->cbuf);
-    pthread_mutex_init(&tsbuf->mutex, NULL);
-    pthread_cond_init(&tsbuf->cond_not_empty, NULL);
-    pthread_cond_init(&tsbuf->cond_not_full, NULL);
+    /* Size classes are powers of two, so the granted size can be masked */
+    tsbuf->data = bufpool_alloc(capacity, &tsbuf->capacity);
+    if (tsbuf->data == NULL) {
+        tsbuf->capacity = 0;
+    }
+    tsbuf->mask = tsbuf->capacity - 1;
+    atomic_init(&tsbuf->limit, tsbuf->capacity);
+    tsbuf->metrics = NULL;
+    atomic_init(&tsbuf->burst_ns, 0);
+    latency_tags_init(&tsbuf->tags, NULL);
+
+    atomic_init(&tsbuf->head, 0);
+    atomic_init(&tsbuf->tail, 0);
+    atomic_init(&tsbuf->data_waiters, 0);
+    atomic_init(&tsbuf->space_waiters, 0);
+    pthread_mutex_init(&tsbuf->producer_lock, NULL);
+    pthread_mutex_init(&tsbuf->consumer_lock, NULL);
+    tsbuf->data_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    tsbuf->space_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (tsbuf->data_fd < 0 || tsbuf->space_fd < 0) {
+        MB_LOG_WARNING("ts_cbuf: eventfd failed (%s), timed waits degrade to polling",
+                      strerror(errno));
+    }
+
+    return (tsbuf->data != NULL) ? SUCCESS : ERROR_GENERAL;
 }
 
 /**
@@ -165,31 +332,171 @@ void ts_cbuf_destroy(ts_circular_buffer_t *tsbuf)
         return;
     }
 
-    pthread_mutex_destroy(&tsbuf->mutex);
-    pthread_cond_destroy(&tsbuf->cond_not_empty);
-    pthread_cond_destroy(&tsbuf->cond_not_full);
+    pthread_mutex_destroy(&tsbuf->producer_lock);
+    pthread_mutex_destroy(&tsbuf->consumer_lock);
+    if (tsbuf->data_fd >= 0) {
+        close(tsbuf->data_fd);
+        tsbuf->data_fd = -1;
+    }
+    if (tsbuf->space_fd >= 0) {
+        close(tsbuf->space_fd);
+        tsbuf->space_fd = -1;
+    }
+
+    bufpool_free(tsbuf->data, tsbuf->capacity);
+    tsbuf->data = NULL;
+    tsbuf->capacity = 0;
+    atomic_store(&tsbuf->limit, 0);
 }
 
 /**
- * Write data to thread-safe circular buffer (non-blocking)
+ * Free space below the producer fill limit
  */
-size_t ts_cbuf_write(ts_circular_buffer_t *tsbuf, const unsigned char *data, size_t len)
+static size_t ts_cbuf_space(ts_circular_buffer_t *tsbuf, size_t head, size_t tail)
 {
-    if (tsbuf == NULL || data == NULL) {
+    size_t used = head - tail;
+    size_t limit = atomic_load_explicit(&tsbuf->limit, memory_order_relaxed);
+
+    return (used < limit) ? limit - used : 0;
+}
+
+/**
+ * Update read-side metrics after the consumer released n bytes
+ * Latency is sampled per burst: from the first write into a drained ring
+ * until the ring is empty again, which is the queueing delay a keystroke
+ * sees on an interactive line.
+ */
+static void ts_cbuf_account(ts_circular_buffer_t *tsbuf, size_t tail, size_t n)
+{
+    metrics_direction_t *m = tsbuf->metrics;
+    size_t backlog = atomic_load_explicit(&tsbuf->head, memory_order_acquire) - tail;
+
+    metrics_add(&m->bytes, n);
+    metrics_add(&m->chunks, 1);
+    atomic_store_explicit(&m->backlog_bytes, backlog, memory_order_relaxed);
+    if (backlog > atomic_load_explicit(&m->backlog_peak, memory_order_relaxed)) {
+        atomic_store_explicit(&m->backlog_peak, backlog, memory_order_relaxed);
+    }
+
+    if (backlog == 0) {
+        uint64_t start = atomic_exchange_explicit(&tsbuf->burst_ns, 0, memory_order_relaxed);
+        if (start != 0) {
+            metrics_hist_record(&m->latency, (latency_now_ns() - start) / 1000);
+        }
+    }
+}
+
+/**
+ * Make n bytes written at head visible to the consumer
+ */
+static void ts_cbuf_publish(ts_circular_buffer_t *tsbuf, size_t head, size_t n, uint64_t ingress_ns)
+{
+    /* Stamp the start of a burst and the chunk before the consumer can see its bytes */
+    if (tsbuf->metrics != NULL &&
+        atomic_load_explicit(&tsbuf->burst_ns, memory_order_relaxed) == 0) {
+        atomic_store_explicit(&tsbuf->burst_ns, latency_now_ns(), memory_order_relaxed);
+    }
+    latency_tags_push(&tsbuf->tags, n, ingress_ns, METRICS_STAGE_RX, ingress_ns);
+
+    atomic_store_explicit(&tsbuf->head, head + n, memory_order_release);
+
+    /* Wake a consumer that may be waiting on an empty ring */
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&tsbuf->data_waiters, memory_order_relaxed) > 0 &&
+        atomic_load_explicit(&tsbuf->tail, memory_order_relaxed) == head) {
+        ts_cbuf_signal(tsbuf->data_fd);
+    }
+}
+
+/**
+ * Return n bytes read at tail to the producer
+ */
+static void ts_cbuf_release(ts_circular_buffer_t *tsbuf, size_t tail, size_t n)
+{
+    atomic_store_explicit(&tsbuf->tail, tail + n, memory_order_release);
+
+    if (tsbuf->metrics != NULL) {
+        ts_cbuf_account(tsbuf, tail + n, n);
+    }
+    latency_tags_pop(&tsbuf->tags, n, METRICS_STAGE_QUEUE, false, 0);
+
+    /* Wake a producer that may be waiting on a full ring */
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&tsbuf->space_waiters, memory_order_relaxed) > 0 &&
+        atomic_load_explicit(&tsbuf->head, memory_order_relaxed) - tail >=
+        atomic_load_explicit(&tsbuf->limit, memory_order_relaxed)) {
+        ts_cbuf_signal(tsbuf->space_fd);
+    }
+}
+
+/**
+ * Copy into the ring and publish (caller holds producer side)
+ */
+static size_t ts_cbuf_copy_in(ts_circular_buffer_t *tsbuf, const unsigned char *data, size_t len,
+                              uint64_t ingress_ns)
+{
+    size_t head = atomic_load_explicit(&tsbuf->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&tsbuf->tail, memory_order_acquire);
+    size_t n = MIN(len, ts_cbuf_space(tsbuf, head, tail));
+
+    if (n == 0) {
+        return 0;
+    }
+
+    /* Up to two contiguous spans: [head..end) then [0..rest) */
+    size_t offset = head & tsbuf->mask;
+    size_t first = MIN(n, tsbuf->capacity - offset);
+    memcpy(tsbuf->data + offset, data, first);
+    memcpy(tsbuf->data, data + first, n - first);
+
+    ts_cbuf_publish(tsbuf, head, n, ingress_ns);
+    return n;
+}
+
+/**
+ * Copy out of the ring and release space (caller holds consumer side)
+ */
+static size_t ts_cbuf_copy_out(ts_circular_buffer_t *tsbuf, unsigned char *data, size_t len)
+{
+    size_t tail = atomic_load_explicit(&tsbuf->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&tsbuf->head, memory_order_acquire);
+    size_t n = MIN(len, head - tail);
+
+    if (n == 0) {
         return 0;
     }
 
-    pthread_mutex_lock(&tsbuf->mutex);
+    size_t offset = tail & tsbuf->mask;
+    size_t first = MIN(n, tsbuf->capacity - offset);
+    memcpy(data, tsbuf->data + offset, first);
+    memcpy(data + first, tsbuf->data, n - first);
+
+    ts_cbuf_release(tsbuf, tail, n);
+    return n;
+}
 
-    /* Non-blocking: write what we can */
-    size_t written = cbuf_write(&tsbuf->cbuf, data, len);
+/**
+ * Write data to thread-safe circular buffer (non-blocking)
+ */
+size_t ts_cbuf_write(ts_circular_buffer_t *tsbuf, const unsigned char *data, size_t len)
+{
+    return ts_cbuf_write_stamped(tsbuf, data, len, 0);
+}
 
-    /* Signal waiting readers if we wrote data */
-    if (written > 0) {
-        pthread_cond_signal(&tsbuf->cond_not_empty);
+/**
+ * Write a chunk stamped with its ingress time (non-blocking)
+ */
+size_t ts_cbuf_write_stamped(ts_circular_buffer_t *tsbuf, const unsigned char *data, size_t len,
+                             uint64_t ingress_ns)
+{
+    if (tsbuf == NULL || data == NULL) {
+        return 0;
     }
 
-    pthread_mutex_unlock(&tsbuf->mutex);
+    pthread_mutex_lock(&tsbuf->producer_lock);
+    size_t written = ts_cbuf_copy_in(tsbuf, data, len, ingress_ns);
+    pthread_mutex_unlock(&tsbuf->producer_lock);
+
     return written;
 }
 
@@ -202,17 +509,10 @@ size_t ts_cbuf_read(ts_circular_buffer_t *tsbuf, unsigned char *data, size_t len
         return 0;
     }
 
-    pthread_mutex_lock(&tsbuf->mutex);
+    pthread_mutex_lock(&tsbuf->consumer_lock);
+    size_t read = ts_cbuf_copy_out(tsbuf, data, len);
+    pthread_mutex_unlock(&tsbuf->consumer_lock);
 
-    /* Non-blocking: read what's available */
-    size_t read = cbuf_read(&tsbuf->cbuf, data, len);
-
-    /* Signal waiting writers if we freed space */
-    if (read > 0) {
-        pthread_cond_signal(&tsbuf->cond_not_full);
-    }
-
-    pthread_mutex_unlock(&tsbuf->mutex);
     return read;
 }
 
@@ -226,33 +526,41 @@ size_t ts_cbuf_write_timeout(ts_circular_buffer_t *tsbuf, const unsigned char *d
         return 0;
     }
 
-    struct timespec ts;
-    clock_gettime(CLOCK_REALTIME, &ts);
-    ts.tv_sec += timeout_ms / 1000;
-    ts.tv_nsec += (timeout_ms % 1000) * 1000000L;
-    if (ts.tv_nsec >= 1000000000L) {
-        ts.tv_sec++;
-        ts.tv_nsec -= 1000000000L;
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
     }
 
-    pthread_mutex_lock(&tsbuf->mutex);
-
-    /* Wait for space if buffer is full */
-    while (cbuf_free(&tsbuf->cbuf) == 0) {
-        int ret = pthread_cond_timedwait(&tsbuf->cond_not_full, &tsbuf->mutex, &ts);
-        if (ret == ETIMEDOUT) {
-            pthread_mutex_unlock(&tsbuf->mutex);
-            return 0; /* Timeout */
-        }
-    }
+    pthread_mutex_lock(&tsbuf->producer_lock);
+
+    size_t written = ts_cbuf_copy_in(tsbuf, data, len, 0);
+    if (written == 0 && len > 0) {
+        /* Ring full: register as waiter, re-check, then sleep on space_fd */
+        atomic_fetch_add(&tsbuf->space_waiters, 1);
+        for (;;) {
+            ts_cbuf_drain(tsbuf->space_fd);
+            atomic_thread_fence(memory_order_seq_cst);
+            written = ts_cbuf_copy_in(tsbuf, data, len, 0);
+            if (written > 0) {
+                break;
+            }
 
-    size_t written = cbuf_write(&tsbuf->cbuf, data, len);
+            int remaining = ts_cbuf_remaining_ms(&deadline);
+            if (remaining == 0) {
+                break;  /* Timeout */
+            }
 
-    if (written > 0) {
-        pthread_cond_signal(&tsbuf->cond_not_empty);
+            struct pollfd pfd = { .fd = tsbuf->space_fd, .events = POLLIN };
+            poll(&pfd, 1, (tsbuf->space_fd >= 0) ? remaining : MIN(remaining, 10));
+        }
+        atomic_fetch_sub(&tsbuf->space_waiters, 1);
     }
 
-    pthread_mutex_unlock(&tsbuf->mutex);
+    pthread_mutex_unlock(&tsbuf->producer_lock);
     return written;
 }
 
@@ -266,143 +574,318 @@ size_t ts_cbuf_read_timeout(ts_circular_buffer_t *tsbuf, unsigned char *data,
         return 0;
     }
 
-    struct timespec ts;
-    clock_gettime(CLOCK_REALTIME, &ts);
-    ts.tv_sec += timeout_ms / 1000;
-    ts.tv_nsec += (timeout_ms % 1000) * 1000000L;
-    if (ts.tv_nsec >= 1000000000L) {
-        ts.tv_sec++;
-        ts.tv_nsec -= 1000000000L;
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
     }
 
-    pthread_mutex_lock(&tsbuf->mutex);
+    pthread_mutex_lock(&tsbuf->consumer_lock);
+
+    size_t read = ts_cbuf_copy_out(tsbuf, data, len);
+    if (read == 0 && len > 0) {
+        /* Ring empty: register as waiter, re-check, then sleep on data_fd */
+        atomic_fetch_add(&tsbuf->data_waiters, 1);
+        for (;;) {
+            ts_cbuf_drain(tsbuf->data_fd);
+            atomic_thread_fence(memory_order_seq_cst);
+            read = ts_cbuf_copy_out(tsbuf, data, len);
+            if (read > 0) {
+                break;
+            }
+
+            int remaining = ts_cbuf_remaining_ms(&deadline);
+            if (remaining == 0) {
+                break;  /* Timeout */
+            }
 
-    /* Wait for data if buffer is empty */
-    while (cbuf_available(&tsbuf->cbuf) == 0) {
-        int ret = pthread_cond_timedwait(&tsbuf->cond_not_empty, &tsbuf->mutex, &ts);
-        if (ret == ETIMEDOUT) {
-            pthread_mutex_unlock(&tsbuf->mutex);
-            return 0; /* Timeout */
+            struct pollfd pfd = { .fd = tsbuf->data_fd, .events = POLLIN };
+            poll(&pfd, 1, (tsbuf->data_fd >= 0) ? remaining : MIN(remaining, 10));
         }
+        atomic_fetch_sub(&tsbuf->data_waiters, 1);
     }
 
-    size_t read = cbuf_read(&tsbuf->cbuf, data, len);
+    pthread_mutex_unlock(&tsbuf->consumer_lock);
+    return read;
+}
 
-    if (read > 0) {
-        pthread_cond_signal(&tsbuf->cond_not_full);
+/**
+ * Reserve contiguous free space for in-place writes (zero-copy)
+ */
+unsigned char *ts_cbuf_reserve(ts_circular_buffer_t *tsbuf, size_t len, size_t *granted)
+{
+    if (tsbuf == NULL || granted == NULL) {
+        return NULL;
     }
 
-    pthread_mutex_unlock(&tsbuf->mutex);
-    return read;
+    pthread_mutex_lock(&tsbuf->producer_lock);
+
+    size_t head = atomic_load_explicit(&tsbuf->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&tsbuf->tail, memory_order_acquire);
+    size_t offset = head & tsbuf->mask;
+    size_t space = ts_cbuf_space(tsbuf, head, tail);
+
+    /* Only the span up to the end of the ring is contiguous */
+    *granted = MIN(len, MIN(space, tsbuf->capacity - offset));
+    return tsbuf->data + offset;
 }
 
 /**
- * Check if buffer is empty (thread-safe)
+ * Publish n bytes written into the reserved span and end the reservation
  */
-bool ts_cbuf_is_empty(ts_circular_buffer_t *tsbuf)
+void ts_cbuf_commit(ts_circular_buffer_t *tsbuf, size_t n)
+{
+    ts_cbuf_commit_stamped(tsbuf, n, 0);
+}
+
+/**
+ * Publish a stamped chunk written into the reserved span and end the reservation
+ */
+void ts_cbuf_commit_stamped(ts_circular_buffer_t *tsbuf, size_t n, uint64_t ingress_ns)
 {
     if (tsbuf == NULL) {
-        return true;
+        return;
     }
 
-    pthread_mutex_lock(&tsbuf->mutex);
-    bool empty = cbuf_is_empty(&tsbuf->cbuf);
-    pthread_mutex_unlock(&tsbuf->mutex);
+    if (n > 0) {
+        size_t head = atomic_load_explicit(&tsbuf->head, memory_order_relaxed);
+        ts_cbuf_publish(tsbuf, head, n, ingress_ns);
+    }
 
-    return empty;
+    pthread_mutex_unlock(&tsbuf->producer_lock);
 }
 
 /**
- * Get available data (thread-safe)
+ * Peek at the contiguous readable span (zero-copy)
  */
-size_t ts_cbuf_available(ts_circular_buffer_t *tsbuf)
+const unsigned char *ts_cbuf_peek(ts_circular_buffer_t *tsbuf, size_t *len)
+{
+    if (tsbuf == NULL || len == NULL) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&tsbuf->consumer_lock);
+
+    size_t tail = atomic_load_explicit(&tsbuf->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&tsbuf->head, memory_order_acquire);
+    size_t offset = tail & tsbuf->mask;
+
+    *len = MIN(head - tail, tsbuf->capacity - offset);
+    return tsbuf->data + offset;
+}
+
+/**
+ * Drop n bytes from the peeked span and end the peek
+ */
+void ts_cbuf_consume(ts_circular_buffer_t *tsbuf, size_t n)
 {
     if (tsbuf == NULL) {
-        return 0;
+        return;
     }
 
-    pthread_mutex_lock(&tsbuf->mutex);
-    size_t available = cbuf_available(&tsbuf->cbuf);
-    pthread_mutex_unlock(&tsbuf->mutex);
+    if (n > 0) {
+        size_t tail = atomic_load_explicit(&tsbuf->tail, memory_order_relaxed);
+        ts_cbuf_release(tsbuf, tail, n);
+    }
 
-    return available;
+    pthread_mutex_unlock(&tsbuf->consumer_lock);
 }
 
-/* ========== End of thread-safe circular buffer functions ========== */
+/**
+ * Check if buffer is empty (thread-safe)
+ */
+bool ts_cbuf_is_empty(ts_circular_buffer_t *tsbuf)
+{
+    return ts_cbuf_available(tsbuf) == 0;
+}
 
 /**
- * Check if byte is start of multibyte UTF-8 sequence
+ * Get available data (thread-safe)
  */
-bool is_utf8_start(unsigned char byte)
+size_t ts_cbuf_available(ts_circular_buffer_t *tsbuf)
 {
-    /* UTF-8 start bytes: 11xxxxxx */
-    return (byte & 0xC0) == 0xC0 && (byte & 0xFE) != 0xFE;
+    if (tsbuf == NULL) {
+        return 0;
+    }
+
+    size_t tail = atomic_load_explicit(&tsbuf->tail, memory_order_acquire);
+    size_t head = atomic_load_explicit(&tsbuf->head, memory_order_acquire);
+    return head - tail;
 }
 
 /**
- * Check if byte is UTF-8 continuation byte
+ * Get eventfd signalled when data arrives
  */
-bool is_utf8_continuation(unsigned char byte)
+int ts_cbuf_get_event_fd(ts_circular_buffer_t *tsbuf)
 {
-    /* UTF-8 continuation bytes: 10xxxxxx */
-    return (byte & 0xC0) == 0x80;
+    return (tsbuf != NULL) ? tsbuf->data_fd : -1;
 }
 
 /**
- * Get expected length of UTF-8 sequence from first byte
+ * Register/unregister an external (event loop) data waiter
  */
-int utf8_sequence_length(unsigned char byte)
+void ts_cbuf_watch(ts_circular_buffer_t *tsbuf, bool enable)
 {
-    if ((byte & 0x80) == 0x00) {
-        /* 0xxxxxxx - 1 byte (ASCII) */
-        return 1;
-    } else if ((byte & 0xE0) == 0xC0) {
-        /* 110xxxxx - 2 bytes */
-        return 2;
-    } else if ((byte & 0xF0) == 0xE0) {
-        /* 1110xxxx - 3 bytes */
-        return 3;
-    } else if ((byte & 0xF8) == 0xF0) {
-        /* 11110xxx - 4 bytes */
-        return 4;
+    if (tsbuf == NULL) {
+        return;
     }
 
-    /* Invalid */
-    return 0;
+    if (enable) {
+        atomic_fetch_add(&tsbuf->data_waiters, 1);
+    } else {
+        atomic_fetch_sub(&tsbuf->data_waiters, 1);
+    }
 }
 
 /**
- * Validate complete UTF-8 sequence
+ * Limit how much the producer may queue (thread-safe)
  */
-bool is_valid_utf8_sequence(const unsigned char *seq, size_t len)
+void ts_cbuf_set_limit(ts_circular_buffer_t *tsbuf, size_t limit)
 {
-    if (seq == NULL || len == 0) {
-        return false;
+    if (tsbuf == NULL) {
+        return;
     }
 
-    int expected_len = utf8_sequence_length(seq[0]);
-    if (expected_len == 0 || (size_t)expected_len != len) {
-        return false;
+    if (limit == 0 || limit > tsbuf->capacity) {
+        limit = tsbuf->capacity;
     }
+    atomic_store_explicit(&tsbuf->limit, limit, memory_order_relaxed);
 
-    /* Check continuation bytes */
-    for (size_t i = 1; i < len; i++) {
-        if (!is_utf8_continuation(seq[i])) {
-            return false;
-        }
+    /* A raised limit may unblock a waiting producer */
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&tsbuf->space_waiters, memory_order_relaxed) > 0) {
+        ts_cbuf_signal(tsbuf->space_fd);
     }
-
-    return true;
 }
 
 /**
- * Filter ANSI escape sequences from modem input
+ * Attach per-direction metrics
+ */
+void ts_cbuf_set_metrics(ts_circular_buffer_t *tsbuf, metrics_direction_t *metrics)
+{
+    if (tsbuf == NULL) {
+        return;
+    }
+
+    tsbuf->metrics = metrics;
+    tsbuf->tags.metrics = metrics;
+}
+
+/**
+ * Stamp for the bytes the consumer is about to take
+ */
+void ts_cbuf_stamp(ts_circular_buffer_t *tsbuf, latency_stamp_t *stamp)
+{
+    latency_tags_stamp((tsbuf != NULL) ? &tsbuf->tags : NULL, stamp);
+}
+
+/**
+ * Wake all timed waiters (shutdown)
+ */
+void ts_cbuf_wake(ts_circular_buffer_t *tsbuf)
+{
+    if (tsbuf == NULL) {
+        return;
+    }
+
+    ts_cbuf_signal(tsbuf->data_fd);
+    ts_cbuf_signal(tsbuf->space_fd);
+}
+
+/* ========== End of thread-safe circular buffer functions ========== */
+
+/**
+ * Check if byte is start of multibyte UTF-8 sequence
+ */
+bool is_utf8_start(unsigned char byte)
+{
+    /* UTF-8 start bytes: 11xxxxxx */
+    return (byte & 0xC0) == 0xC0 && (byte & 0xFE) != 0xFE;
+}
+
+/**
+ * Check if byte is UTF-8 continuation byte
+ */
+bool is_utf8_continuation(unsigned char byte)
+{
+    /* UTF-8 continuation bytes: 10xxxxxx */
+    return (byte & 0xC0) == 0x80;
+}
+
+/**
+ * Get expected length of UTF-8 sequence from first byte
+ */
+int utf8_sequence_length(unsigned char byte)
+{
+    if ((byte & 0x80) == 0x00) {
+        /* 0xxxxxxx - 1 byte (ASCII) */
+        return 1;
+    } else if ((byte & 0xE0) == 0xC0) {
+        /* 110xxxxx - 2 bytes */
+        return 2;
+    } else if ((byte & 0xF0) == 0xE0) {
+        /* 1110xxxx - 3 bytes */
+        return 3;
+    } else if ((byte & 0xF8) == 0xF0) {
+        /* 11110xxx - 4 bytes */
+        return 4;
+    }
+
+    /* Invalid */
+    return 0;
+}
+
+/**
+ * Validate complete UTF-8 sequence
+ */
+bool is_valid_utf8_sequence(const unsigned char *seq, size_t len)
+{
+    if (seq == NULL || len == 0) {
+        return false;
+    }
+
+    int expected_len = utf8_sequence_length(seq[0]);
+    if (expected_len == 0 || (size_t)expected_len != len) {
+        return false;
+    }
+
+    /* Check continuation bytes */
+    for (size_t i = 1; i < len; i++) {
+        if (!is_utf8_continuation(seq[i])) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*
+ * ANSI filter transitions: next state for every (state, byte) pair.
+ * Bytes are only emitted in NORMAL; everything from ESC up to the byte
+ * that returns to NORMAL is dropped. Unlisted entries are ANSI_STATE_NORMAL.
+ */
+_Static_assert(ANSI_STATE_NORMAL == 0, "ansi_next_state relies on NORMAL == 0");
+
+static const unsigned char ansi_next_state[ANSI_STATE_CSI_PARAM + 1][256] = {
+    [ANSI_STATE_NORMAL]    = { [0x1B] = ANSI_STATE_ESC },
+    [ANSI_STATE_ESC]       = { ['['] = ANSI_STATE_CSI },                  /* ESC c and others: dropped */
+    [ANSI_STATE_CSI]       = { [0x30 ... 0x3F] = ANSI_STATE_CSI_PARAM },  /* Final/invalid: back to NORMAL */
+    [ANSI_STATE_CSI_PARAM] = { [0x30 ... 0x3F] = ANSI_STATE_CSI_PARAM }
+};
+
+/**
+ * Filter ANSI escape sequences from modem input
  */
 int ansi_filter_modem_to_telnet(const unsigned char *input, size_t input_len,
                                 unsigned char *output, size_t output_size,
                                 size_t *output_len, ansi_state_t *state)
 {
     size_t out_pos = 0;
+    size_t i = 0;
+    bool truncated = false;
     ansi_state_t current_state = state ? *state : ANSI_STATE_NORMAL;
 
     if (input == NULL || output == NULL || output_len == NULL) {
@@ -411,71 +894,34 @@ int ansi_filter_modem_to_telnet(const unsigned char *input, size_t input_len,
 
     *output_len = 0;
 
-    for (size_t i = 0; i < input_len; i++) {
-        unsigned char c = input[i];
+    if ((unsigned int)current_state > ANSI_STATE_CSI_PARAM && input_len > 0) {
+        /* Unknown state: drop one byte and resynchronize */
+        current_state = ANSI_STATE_NORMAL;
+        i = 1;
+    }
 
-        switch (current_state) {
-            case ANSI_STATE_NORMAL:
-                if (c == 0x1B) {  /* ESC */
-                    current_state = ANSI_STATE_ESC;
-                } else {
-                    /* Normal character - pass through */
-                    if (out_pos < output_size) {
-                        output[out_pos++] = c;
-                    } else {
-                        /* Buffer full - log warning once */
-                        static bool overflow_warned = false;
-                        if (!overflow_warned) {
-                            MB_LOG_WARNING("ANSI filter output buffer full - data truncated (multibyte chars may break)");
-                            overflow_warned = true;
-                        }
-                    }
-                }
-                break;
+    while (i < input_len) {
+        if (current_state != ANSI_STATE_NORMAL) {
+            current_state = ansi_next_state[current_state][input[i++]];
+            continue;
+        }
 
-            case ANSI_STATE_ESC:
-                if (c == '[') {
-                    /* CSI sequence */
-                    current_state = ANSI_STATE_CSI;
-                } else if (c == 'c') {
-                    /* Reset - filter out */
-                    current_state = ANSI_STATE_NORMAL;
-                } else {
-                    /* Other escape sequences - filter out for now */
-                    current_state = ANSI_STATE_NORMAL;
-                }
-                break;
+        /* Plain text: copy the whole run up to the next ESC */
+        size_t run = util_find_byte(input + i, input_len - i, 0x1B);
+        size_t room = output_size - out_pos;
+        size_t copy = run < room ? run : room;
 
-            case ANSI_STATE_CSI:
-                /* Check if this is a parameter or intermediate byte */
-                if (c >= 0x30 && c <= 0x3F) {
-                    /* Parameter bytes (0-9:;<=>?) */
-                    current_state = ANSI_STATE_CSI_PARAM;
-                } else if (c >= 0x40 && c <= 0x7E) {
-                    /* Final byte - end of CSI sequence */
-                    current_state = ANSI_STATE_NORMAL;
-                } else {
-                    /* Invalid - return to normal */
-                    current_state = ANSI_STATE_NORMAL;
-                }
-                break;
+        memmove(output + out_pos, input + i, copy);
+        out_pos += copy;
 
-            case ANSI_STATE_CSI_PARAM:
-                if (c >= 0x30 && c <= 0x3F) {
-                    /* More parameter bytes */
-                    /* Stay in CSI_PARAM state */
-                } else if (c >= 0x40 && c <= 0x7E) {
-                    /* Final byte - end of CSI sequence */
-                    current_state = ANSI_STATE_NORMAL;
-                } else {
-                    /* Invalid - return to normal */
-                    current_state = ANSI_STATE_NORMAL;
-                }
-                break;
+        if (copy < run) {
+            truncated = true;
+        }
 
-            default:
-                current_state = ANSI_STATE_NORMAL;
-                break;
+        i += run;
+        if (i < input_len) {
+            current_state = ANSI_STATE_ESC;
+            i++;
         }
     }
 
@@ -485,7 +931,7 @@ int ansi_filter_modem_to_telnet(const unsigned char *input, size_t input_len,
         *state = current_state;
     }
 
-    return SUCCESS;
+    return truncated ? ERROR_BUFFER_FULL : SUCCESS;
 }
 
 /**
@@ -499,14 +945,29 @@ int ansi_passthrough_telnet_to_modem(const unsigned char *input, size_t input_le
         return ERROR_INVALID_ARG;
     }
 
-    /* Simple passthrough - just copy data */
+    /* Simple passthrough - just copy data (nothing to move when in place) */
     size_t copy_len = MIN(input_len, output_size);
-    memcpy(output, input, copy_len);
+    if (output != input) {
+        memmove(output, input, copy_len);
+    }
     *output_len = copy_len;
 
     return SUCCESS;
 }
 
+/**
+ * Per-line buffer size: BUFFER_SIZE from the config, else derived from the DTE rate
+ */
+static size_t bridge_buffer_size(const config_t *cfg)
+{
+    if (cfg != NULL && cfg->buffer_size > 0) {
+        return bufpool_class_size((size_t)cfg->buffer_size);
+    }
+
+    return bufpool_class_size(serial_buffer_size_for_speed(cfg ? cfg->baudrate_value : 0,
+                                                           BUFFER_SIZE));
+}
+
 /**
  * Initialize bridge context
  */
@@ -527,27 +988,49 @@ void bridge_init(bridge_ctx_t *ctx, config_t *cfg)
     ctx->carrier_detected = false;
     ctx->ring_count = 0;
 
+    /* Per-line buffer size (rings, telnet I/O, Level 3 double buffers) */
+    ctx->buffer_size = bridge_buffer_size(cfg);
+
     /* Initialize components */
     serial_init(&ctx->serial);
 #ifdef ENABLE_LEVEL2
     telnet_init(&ctx->telnet);
+    telnet_set_buffer_size(&ctx->telnet, ctx->buffer_size);
+    telnet_set_line_rate(&ctx->telnet, cfg->baudrate_value);
 
     /* Link telnet to datalog for internal protocol logging */
     ctx->telnet.datalog = &ctx->datalog;
+    ctx->telnet.compress_enabled = cfg->telnet_compress;
+    ctx->telnet.raw_tcp = cfg->telnet_raw;
+    ctx->telnet.fast_start = cfg->telnet_fast_start;
+    ctx->telnet.connect_timeout_ms = cfg->connect_timeout_ms;
+
+    /* Kernel data plane for transparent lines (pipes created on first use) */
+    passthru_init(&ctx->passthru, cfg->splice_passthrough);
 #endif
 
-    /* Initialize buffers (legacy single-thread) */
+    /* Initialize thread-safe buffers (multithread mode) */
 #ifdef ENABLE_LEVEL2
-    cbuf_init(&ctx->serial_to_telnet_buf);
-    cbuf_init(&ctx->telnet_to_serial_buf);
-#else
-    /* Level 1: Telnet buffers not needed */
+    if (ts_cbuf_init(&ctx->ts_serial_to_telnet_buf, ctx->buffer_size) != SUCCESS ||
+        ts_cbuf_init(&ctx->ts_telnet_to_serial_buf, ctx->buffer_size) != SUCCESS) {
+        MB_LOG_ERROR("Failed to allocate %zu-byte bridge buffers", ctx->buffer_size);
+    } else {
+        MB_LOG_DEBUG("Bridge buffers: %zu bytes per direction", ctx->buffer_size);
+    }
 #endif
 
-    /* Initialize thread-safe buffers (multithread mode) */
+    /* Exported counters (NULL when metrics_init() was not called) */
+    ctx->metrics = metrics_line_attach(cfg != NULL ? cfg->line_id : 0,
+                                       cfg != NULL ? cfg->serial_port : NULL);
 #ifdef ENABLE_LEVEL2
-    ts_cbuf_init(&ctx->ts_serial_to_telnet_buf);
-    ts_cbuf_init(&ctx->ts_telnet_to_serial_buf);
+    if (ctx->metrics != NULL) {
+        ts_cbuf_set_metrics(&ctx->ts_serial_to_telnet_buf, &ctx->metrics->dir[METRICS_SERIAL_TO_TELNET]);
+        ts_cbuf_set_metrics(&ctx->ts_telnet_to_serial_buf, &ctx->metrics->dir[METRICS_TELNET_TO_SERIAL]);
+
+        /* Output queues carry the chunk stamps to the socket and the UART */
+        telnet_set_latency_metrics(&ctx->telnet, &ctx->metrics->dir[METRICS_SERIAL_TO_TELNET]);
+        serial_set_latency_metrics(&ctx->serial, &ctx->metrics->dir[METRICS_TELNET_TO_SERIAL]);
+    }
 #else
     /* Level 1: Telnet buffers not needed */
 #endif
@@ -559,9 +1042,28 @@ void bridge_init(bridge_ctx_t *ctx, config_t *cfg)
     /* Thread control */
     ctx->thread_running = false;
 
+    /* Own serial/telnet threads by default; multi-line mode switches to the worker pool */
+    ctx->line_id = (cfg != NULL) ? cfg->line_id : 0;
+    ctx->use_worker_pool = false;
+    ctx->poll_timeout_ms = 100;
+
+    /* Event-driven mode descriptors are created in bridge_start() */
+    ctx->event_epoll_fd = -1;
+    ctx->wake_fd = -1;
+    ctx->timer_fd = -1;
+    ctx->event_serial_fd = -1;
+    ctx->event_telnet_fd = -1;
+
     /* Initialize ANSI filter state */
     ctx->ansi_filter_state = ANSI_STATE_NORMAL;
 
+    /* Character set transcoding (no-op when both sides use the same set) */
+    charset_conv_init(&ctx->charset_to_serial, cfg->server_charset, cfg->terminal_charset);
+    charset_conv_init(&ctx->charset_to_telnet, cfg->terminal_charset, cfg->server_charset);
+
+    /* File transfer detection (raw mode) */
+    xfer_init(&ctx->xfer, cfg->xfer_fastpath, cfg->xfer_telnet_binary);
+
     /* Initialize statistics */
 #ifdef ENABLE_LEVEL2
     ctx->bytes_serial_to_telnet = 0;
@@ -603,269 +1105,355 @@ void bridge_init(bridge_ctx_t *ctx, config_t *cfg)
 }
 
 /**
- * Start bridge operation (non-blocking)
- * Returns SUCCESS even if serial port is not available
+ * Create a bridge thread with the placement configured for its role
+ * and record the placement it got
  */
-int bridge_start(bridge_ctx_t *ctx)
+static int bridge_thread_create(bridge_ctx_t *ctx, pthread_t *thread, rtsched_role_t role,
+                                const char *name, void *(*fn)(void *))
 {
-    if (ctx == NULL || ctx->config == NULL) {
-        return ERROR_INVALID_ARG;
-    }
+    rtsched_spec_t spec;
 
-    MB_LOG_INFO("Starting bridge");
-
-    /* Initialize retry state */
-    ctx->serial_ready = false;
-    ctx->modem_ready = false;
-    ctx->last_serial_retry = 0;
-    ctx->serial_retry_interval = 10;  /* 10 seconds */
-    ctx->serial_retry_count = 0;
+    rtsched_spec_from_config(ctx->config, role, &spec);
+    int ret = rtsched_thread_create(thread, &spec, name, fn, ctx);
+    if (ret == 0) {
+        rtsched_query(*thread, &ctx->thread_sched[role]);
+    }
+    return ret;
+}
 
-    /* Lock serial port using UUCP-style lock file (modem_sample approach) */
-    printf("[DEBUG] Attempting to lock serial port: %s\n", ctx->config->serial_port);
-    fflush(stdout);
-    int lock_ret = serial_lock_port(ctx->config->serial_port);
-    if (lock_ret != SUCCESS) {
-        printf("[WARNING] Failed to lock serial port (already in use?), continuing anyway\n");
-        fflush(stdout);
-        MB_LOG_WARNING("Failed to lock serial port %s (may already be in use)",
-                      ctx->config->serial_port);
-        /* Continue anyway - some systems don't support UUCP locking */
-    } else {
-        printf("[DEBUG] Serial port locked successfully\n");
-        fflush(stdout);
-        MB_LOG_INFO("Serial port locked: %s", ctx->config->serial_port);
+/**
+ * Create the per-bridge serial/telnet threads for the compiled level
+ */
+static int bridge_start_threads(bridge_ctx_t *ctx)
+{
+    if (ctx->config->event_loop) {
+        return bridge_start_event_thread(ctx);
     }
 
-    /* Try to open serial port (non-blocking) */
-    printf("[DEBUG] Attempting to open serial port: %s\n", ctx->config->serial_port);
-    fflush(stdout);
-    int ret = serial_open(&ctx->serial, ctx->config->serial_port, ctx->config);
-    printf("[DEBUG] serial_open() returned: %d (SUCCESS=%d)\n", ret, SUCCESS);
+#ifdef ENABLE_LEVEL3
+    /* === LEVEL 3 MODE: Create both Serial and Telnet threads === */
+    printf("[INFO] Creating Serial/Modem thread (Level 3 - Part 1)...\n");
     fflush(stdout);
+    MB_LOG_INFO("Creating Serial/Modem thread (Level 3 - Part 1)...");
 
-    if (ret == SUCCESS) {
-        printf("[DEBUG] Serial port opened successfully, will flush buffers and send MODEM_AUTOANSWER_COMMAND\n");
-        fflush(stdout);
-        ctx->serial_ready = true;
-
-        /* Flush any stale data in serial buffers */
-        printf("[INFO] Flushing serial port buffers to clear stale data\n");
+    int ret_serial = bridge_thread_create(ctx, &ctx->serial_thread, RTSCHED_SERIAL, "Serial",
+                                          serial_modem_thread_func);
+    if (ret_serial != 0) {
+        printf("[ERROR] Failed to create serial thread: %s\n", strerror(ret_serial));
         fflush(stdout);
-        serial_flush(&ctx->serial, TCIOFLUSH);
-        MB_LOG_INFO("Serial port buffers flushed");
+        MB_LOG_ERROR("Failed to create serial thread: %s", strerror(ret_serial));
+        ctx->thread_running = false;
+        ctx->running = false;
+        return ERROR_GENERAL;
+    }
+    printf("[INFO] Level 1 serial thread created successfully (pthread_id=%lu)\n", (unsigned long)ctx->serial_thread);
+    fflush(stdout);
+    MB_LOG_INFO("Level 1 serial thread created successfully");
 
-        /* Initialize modem */
-        modem_init(&ctx->modem, &ctx->serial);
+    printf("[INFO] Creating Telnet thread (Level 3 - Part 2)...\n");
+    fflush(stdout);
+    MB_LOG_INFO("Creating Telnet thread (Level 3 - Part 2)...");
 
-  #ifdef ENABLE_LEVEL3
-        /* Register DCD event callback for Level 3 integration */
-        /* This callback works in all levels (1, 2, 3) for DCD monitoring */
-        printf("[DEBUG] Registering DCD event callback with modem\n");
-        fflush(stdout);
-        int dcd_ret = modem_set_dcd_event_callback(&ctx->modem,
-                                                  (int (*)(void *, bool))bridge_handle_dcd_event,
-                                                  ctx);
-        if (dcd_ret == SUCCESS) {
-            printf("[DEBUG] DCD event callback registered successfully\n");
-            fflush(stdout);
-            MB_LOG_DEBUG("DCD event callback registered with modem");
-        } else {
-            printf("[WARNING] Failed to register DCD event callback: %d\n", dcd_ret);
-            fflush(stdout);
-            MB_LOG_WARNING("Failed to register DCD event callback: %d", dcd_ret);
-        }
-#else
-        /* Level 3 not available - DCD callback registration skipped */
-        printf("[DEBUG] Level 3 not enabled, DCD event callback registration skipped\n");
+    int ret_telnet = bridge_thread_create(ctx, &ctx->telnet_thread, RTSCHED_TELNET, "Telnet",
+                                          telnet_thread_func);
+    if (ret_telnet != 0) {
+        printf("[ERROR] Failed to create telnet thread: %s\n", strerror(ret_telnet));
         fflush(stdout);
-        MB_LOG_DEBUG("Level 3 not enabled, DCD event callback registration skipped");
-#endif
-
-        ctx->modem_ready = true;
-
-        /* === Execute MODEM_INIT_COMMAND first (hardware initialization) === */
-        if (ctx->config->modem_init_command[0] != '\0') {
-            char cmd_buf[LINE_BUFFER_SIZE * 2];
-            unsigned char response[SMALL_BUFFER_SIZE];
-
-            printf("[INFO] === Sending MODEM_INIT_COMMAND (hardware initialization) ===\n");
-            fflush(stdout);
-            MB_LOG_INFO("=== Sending MODEM_INIT_COMMAND (hardware initialization) ===");
-            printf("[INFO] Command: %s\n", ctx->config->modem_init_command);
-            fflush(stdout);
-            MB_LOG_INFO("Command: %s", ctx->config->modem_init_command);
-
-            /* Process commands separated by semicolons */
-            char *cmd_copy = strdup(ctx->config->modem_init_command);
-            char *token = strtok(cmd_copy, ";");
-
-            while (token != NULL) {
-                /* Skip leading/trailing spaces */
-                while (*token == ' ') token++;
-                char *end = token + strlen(token) - 1;
-                while (end > token && *end == ' ') *end-- = '\0';
-
-                if (*token != '\0') {
-                    /* Build command with AT prefix if needed and \r\n suffix */
-                    if (strncasecmp(token, "AT", 2) == 0) {
-                        snprintf(cmd_buf, sizeof(cmd_buf), "%s\r\n", token);
-                    } else {
-                        snprintf(cmd_buf, sizeof(cmd_buf), "AT%s\r\n", token);
-                    }
+        MB_LOG_ERROR("Failed to create telnet thread: %s", strerror(ret_telnet));
 
-                    /* Send command to hardware modem */
-                    printf("[DEBUG] Sending: [%s]\n", cmd_buf);
-                    fflush(stdout);
-                    ssize_t sent = serial_write(&ctx->serial,
-                                (const unsigned char *)cmd_buf,
-                                strlen(cmd_buf));
-                    printf("[INFO] Sent %zd bytes to hardware modem\n", sent);
-                    fflush(stdout);
+        /* Clean up serial thread since telnet failed */
+        pthread_cancel(ctx->serial_thread);
+        pthread_join(ctx->serial_thread, NULL);
 
-                    /* Wait for response */
-                    usleep(200000);  /* 200ms between commands */
-                    ssize_t resp_len = serial_read(&ctx->serial, response, sizeof(response));
+        ctx->thread_running = false;
+        ctx->running = false;
+        return ERROR_GENERAL;
+    }
+    printf("[INFO] Level 2 telnet thread created successfully (pthread_id=%lu)\n", (unsigned long)ctx->telnet_thread);
+    fflush(stdout);
+    MB_LOG_INFO("Level 2 telnet thread created successfully");
 
-                    if (resp_len > 0) {
-                        printf("[INFO] Response (%zd bytes): [%.*s]\n",
-                               resp_len, (int)resp_len, response);
-                        fflush(stdout);
-                        MB_LOG_INFO("Response: [%.*s]", (int)resp_len, response);
-                    }
+    printf("[INFO] Level 3: Both Level 1 (serial) and Level 2 (telnet) threads created successfully\n");
+    fflush(stdout);
+    MB_LOG_INFO("Level 3: Both Level 1 (serial) and Level 2 (telnet) threads created successfully");
 
-                    /* Update software modem state WITHOUT sending responses
-                     * (responses already sent by hardware modem) */
-                    /* DISABLED: modem_process_command() sends responses via serial_write()
-                     * which causes infinite loop of OK/ERROR messages
-                     * TODO: Implement state-only update without responses */
-                }
+#else /* ENABLE_LEVEL3 not defined */
 
-                token = strtok(NULL, ";");
-            }
+#ifdef ENABLE_LEVEL2
+    /* === LEVEL 2 MODE: Create Telnet thread only === */
+    printf("[INFO] Creating Telnet thread (Level 2)...\n");
+    fflush(stdout);
+    MB_LOG_INFO("Creating Telnet thread (Level 2)...");
+    int ret_thread = bridge_thread_create(ctx, &ctx->telnet_thread, RTSCHED_TELNET, "Telnet",
+                                          telnet_thread_func);
+    if (ret_thread != 0) {
+        printf("[ERROR] Failed to create telnet thread: %s\n", strerror(ret_thread));
+        fflush(stdout);
+        MB_LOG_ERROR("Failed to create telnet thread: %s", strerror(ret_thread));
+        ctx->thread_running = false;
+        ctx->running = false;
+        return ERROR_GENERAL;
+    }
+    printf("[INFO] Level 2 telnet thread created successfully (pthread_id=%lu)\n", (unsigned long)ctx->telnet_thread);
+    fflush(stdout);
+    MB_LOG_INFO("Level 2 telnet thread created successfully");
+#else
+    /* === LEVEL 1 MODE: Create Serial thread only === */
+    printf("[INFO] Creating Serial/Modem thread (Level 1)...\n");
+    fflush(stdout);
+    MB_LOG_INFO("Creating Serial/Modem thread (Level 1)...");
+    int ret_thread = bridge_thread_create(ctx, &ctx->serial_thread, RTSCHED_SERIAL, "Serial",
+                                          serial_modem_thread_func);
+    if (ret_thread != 0) {
+        printf("[ERROR] Failed to create serial thread: %s\n", strerror(ret_thread));
+        fflush(stdout);
+        MB_LOG_ERROR("Failed to create serial thread: %s", strerror(ret_thread));
+        ctx->thread_running = false;
+        ctx->running = false;
+        return ERROR_GENERAL;
+    }
+    printf("[INFO] Level 1 serial thread created successfully (pthread_id=%lu)\n", (unsigned long)ctx->serial_thread);
+    fflush(stdout);
+    MB_LOG_INFO("Level 1 serial thread created successfully");
+#endif /* ENABLE_LEVEL2 */
 
-            free(cmd_copy);
+#endif /* ENABLE_LEVEL3 */
 
-            printf("[INFO] === MODEM_INIT_COMMAND completed ===\n");
-            fflush(stdout);
-            MB_LOG_INFO("=== MODEM_INIT_COMMAND completed ===");
+    return SUCCESS;
+}
 
-            /* Small delay before auto-answer command */
-            usleep(500000);  /* 500ms */
-        } else {
-            printf("[DEBUG] MODEM_INIT_COMMAND is empty, skipping initialization\n");
-            fflush(stdout);
-        }
+/**
+ * Wait for the per-bridge serial/telnet threads to exit
+ */
+static void bridge_join_threads(bridge_ctx_t *ctx)
+{
+    if (ctx->event_epoll_fd >= 0) {
+        bridge_stop_event_thread(ctx);
+        return;
+    }
+
+  #ifdef ENABLE_LEVEL3
+    /* === LEVEL 3 MODE: Wait for both Serial and Telnet threads === */
+    MB_LOG_INFO("Waiting for Level 1 serial thread to exit...");
+    pthread_join(ctx->serial_thread, NULL);
+    MB_LOG_INFO("Serial/Modem thread (Level 1) exited");
 
-        /* Send auto-answer command to hardware modem (modem_sample MODE pattern) */
-        /* Select command based on MODEM_AUTOANSWER_MODE (0=SOFTWARE, 1=HARDWARE) */
-        const char *autoanswer_cmd = NULL;
-        const char *mode_name = NULL;
+    MB_LOG_INFO("Waiting for Level 2 telnet thread to exit...");
+    pthread_join(ctx->telnet_thread, NULL);
+    MB_LOG_INFO("Telnet thread (Level 2) exited");
+#else
 
-        if (ctx->config->modem_autoanswer_mode == 0) {
-            /* SOFTWARE mode: S0=0, manual ATA required */
-            autoanswer_cmd = ctx->config->modem_autoanswer_software_command;
-            mode_name = "SOFTWARE";
-        } else {
-            /* HARDWARE mode: S0>0, automatic answer */
-            autoanswer_cmd = ctx->config->modem_autoanswer_hardware_command;
-            mode_name = "HARDWARE";
-        }
+#ifdef ENABLE_LEVEL2
+    MB_LOG_INFO("Waiting for Level 2 telnet thread to exit...");
 
-        printf("[DEBUG] MODEM_AUTOANSWER_MODE=%d (%s), command=[%s] (len=%zu)\n",
-               ctx->config->modem_autoanswer_mode, mode_name,
-               autoanswer_cmd, strlen(autoanswer_cmd));
-        fflush(stdout);
-        MB_LOG_INFO("MODEM_AUTOANSWER_MODE=%d (%s), command=[%s]",
-                   ctx->config->modem_autoanswer_mode, mode_name, autoanswer_cmd);
+    /* Wait for Level 2 telnet thread to exit */
+    pthread_join(ctx->telnet_thread, NULL);
+    MB_LOG_INFO("Telnet thread (Level 2) exited");
+#else
+    MB_LOG_INFO("Waiting for Level 1 serial thread to exit...");
 
-        if (autoanswer_cmd[0] != '\0') {
-            char cmd_buf[LINE_BUFFER_SIZE * 2];  /* Extra space for AT prefix and \r\n */
-            unsigned char response[SMALL_BUFFER_SIZE];
-            size_t cmd_len;
+    /* Wait for Level 1 serial thread to exit */
+    pthread_join(ctx->serial_thread, NULL);
+    MB_LOG_INFO("Serial/Modem thread (Level 1) exited");
+#endif
 
-            printf("[INFO] === Sending MODEM_AUTOANSWER command (%s mode) ===\n", mode_name);
-            fflush(stdout);
-            MB_LOG_INFO("=== Sending MODEM_AUTOANSWER command (%s mode) ===", mode_name);
-            printf("[INFO] Command: %s\n", autoanswer_cmd);
-            fflush(stdout);
-            MB_LOG_INFO("Command: %s", autoanswer_cmd);
-
-            /* Build command with AT prefix and \r\n suffix */
-            if (strncasecmp(autoanswer_cmd, "AT", 2) == 0) {
-                /* Command already has AT prefix */
-                cmd_len = strlen(autoanswer_cmd);
-                if (cmd_len + 3 < sizeof(cmd_buf)) {  /* +3 for \r\n\0 */
-                    SAFE_STRNCPY(cmd_buf, autoanswer_cmd, sizeof(cmd_buf));
-                    strcat(cmd_buf, "\r\n");
-                }
-            } else {
-                /* Prepend AT */
-                cmd_len = strlen(autoanswer_cmd);
-                if (cmd_len + 5 < sizeof(cmd_buf)) {  /* +5 for AT\r\n\0 */
-                    strcpy(cmd_buf, "AT");
-                    strcat(cmd_buf, autoanswer_cmd);
-                    strcat(cmd_buf, "\r\n");
-                }
-            }
+#endif /* ENABLE_LEVEL3 */
+}
 
-            /* Send command to hardware modem */
-            printf("[DEBUG] About to call serial_write() with cmd_buf\n");
-            fflush(stdout);
-            ssize_t sent = serial_write(&ctx->serial,
-                        (const unsigned char *)cmd_buf,
-                        strlen(cmd_buf));
-            printf("[INFO] Sent %zd bytes to hardware modem\n", sent);
-            fflush(stdout);
-            MB_LOG_INFO("Sent %zd bytes to hardware modem", sent);
+/**
+ * Start bridge operation (non-blocking)
+ * Returns SUCCESS even if serial port is not available
+ */
+/**
+ * Time AT round trips to the modem and log them with the serial latency
+ * settings in effect
+ */
+static void bridge_probe_serial_latency(bridge_ctx_t *ctx)
+{
+    serial_port_t *port = &ctx->serial;
+    int rtt_us;
 
-            /* Wait for response (simple approach - just wait and read) */
-            printf("[DEBUG] Waiting 500ms for modem response...\n");
-            fflush(stdout);
-            usleep(500000);  /* 500ms */
-            ssize_t resp_len = serial_read(&ctx->serial, response, sizeof(response));
-            printf("[DEBUG] serial_read() returned %zd bytes\n", resp_len);
-            fflush(stdout);
+    if (modem_probe_round_trip(&ctx->modem, SERIAL_PROBE_COUNT, ctx->config->modem_init_timeout_ms,
+                               &rtt_us) != SUCCESS) {
+        MB_LOG_WARNING("Serial latency probe: modem did not answer AT");
+        return;
+    }
+    port->probe_rtt_us = rtt_us;
 
-            if (resp_len > 0) {
-                printf("[INFO] Modem response (%zd bytes): [%.*s]\n", resp_len, (int)resp_len, response);
-                fflush(stdout);
-                MB_LOG_INFO("Modem response (%zd bytes): [%.*s]", resp_len, (int)resp_len, response);
-
-                /* Update software modem state WITHOUT sending responses
-                 * Parse S0 value from command manually to avoid modem_process_command()
-                 * which would send OK via serial_write() causing infinite loop */
-                const char *s0_pos = strstr(autoanswer_cmd, "S0=");
-                if (s0_pos) {
-                    int s0_value = atoi(s0_pos + 3);
-                    ctx->modem.settings.s_registers[SREG_AUTO_ANSWER] = s0_value;
-                    printf("[INFO] Software modem S0 register set to %d (%s mode)\n", s0_value, mode_name);
-                    fflush(stdout);
-                    MB_LOG_INFO("Software modem S0 register set to %d (%s mode)", s0_value, mode_name);
-                } else {
-                    printf("[WARNING] S0= not found in autoanswer command\n");
-                    fflush(stdout);
-                    MB_LOG_WARNING("S0= not found in autoanswer command");
-                }
+    char timer[24];
+    if (port->latency_timer_ms >= 0) {
+        snprintf(timer, sizeof(timer), "%d ms", port->latency_timer_ms);
+    } else {
+        snprintf(timer, sizeof(timer), "none");
+    }
+    MB_LOG_INFO("Serial round trip %d.%d ms (AT -> OK): %s receive profile, %s, USB latency_timer %s",
+                rtt_us / 1000, (rtt_us % 1000) / 100,
+                port->rx_profile != NULL ? port->rx_profile->name : "none",
+                port->low_latency ? "ASYNC_LOW_LATENCY" : "driver default latency", timer);
+
+    /* A full USB poll interval on each way points at an untuned adapter */
+    if (port->latency_timer_ms > SERIAL_LATENCY_TIMER_DEFAULT && rtt_us > 2000 * port->latency_timer_ms) {
+        MB_LOG_WARNING("Serial round trip is dominated by the %d ms USB latency_timer of %s "
+                      "(see SERIAL_LATENCY_TIMER)", port->latency_timer_ms, port->device);
+    }
+}
+
+/**
+ * Send MODEM_INIT_COMMAND and the auto-answer command to the hardware modem
+ * Each command goes out as soon as the previous one is answered, so this
+ * takes as long as the modem needs instead of a fixed delay per command.
+ */
+static void bridge_initialize_modem(bridge_ctx_t *ctx)
+{
+    const config_t *cfg = ctx->config;
+    long long start = bridge_monotonic_ms();
+
+    if (cfg->modem_init_script.count > 0) {
+        MB_LOG_INFO("Sending MODEM_INIT_COMMAND (%d commands): %s",
+                   cfg->modem_init_script.count, cfg->modem_init_command);
+        int rc = modem_run_script(&ctx->modem, &cfg->modem_init_script, cfg->modem_init_timeout_ms);
+        if (rc != SUCCESS) {
+            MB_LOG_WARNING("MODEM_INIT_COMMAND did not complete cleanly: %d", rc);
+        }
+    }
+
+    /* Round trip with the latency settings in effect */
+    bridge_probe_serial_latency(ctx);
+
+    /* Select command based on MODEM_AUTOANSWER_MODE (0=SOFTWARE, 1=HARDWARE) */
+    const char *autoanswer_cmd = (cfg->modem_autoanswer_mode == 0) ?
+        cfg->modem_autoanswer_software_command : cfg->modem_autoanswer_hardware_command;
+    const char *mode_name = (cfg->modem_autoanswer_mode == 0) ? "SOFTWARE" : "HARDWARE";
+
+    if (autoanswer_cmd[0] != '\0') {
+        char cmd_buf[LINE_BUFFER_SIZE + 2];
+        char response[SMALL_BUFFER_SIZE];
+
+        snprintf(cmd_buf, sizeof(cmd_buf), "%s%s",
+                 strncasecmp(autoanswer_cmd, "AT", 2) == 0 ? "" : "AT", autoanswer_cmd);
+        MB_LOG_INFO("Setting auto-answer mode: %s (%s)", mode_name, cmd_buf);
+
+        int rc = modem_send_at_command_ms(&ctx->modem, cmd_buf, response, sizeof(response),
+                                          cfg->modem_init_timeout_ms);
+        if (rc == SUCCESS) {
+            /* Mirror S0 in the software modem without running
+             * modem_process_command(), which would answer on the serial port */
+            const char *s0_pos = strcasestr(autoanswer_cmd, "S0=");
+            if (s0_pos) {
+                int s0_value = atoi(s0_pos + 3);
+                ctx->modem.settings.s_registers[SREG_AUTO_ANSWER] = s0_value;
+                MB_LOG_INFO("Software modem S0 register set to %d (%s mode)", s0_value, mode_name);
             } else {
-                printf("[WARNING] No response from modem (or read error)\n");
-                fflush(stdout);
-                MB_LOG_WARNING("No response from modem (or read error)");
+                MB_LOG_WARNING("S0= not found in autoanswer command");
             }
+        } else {
+            MB_LOG_WARNING("Auto-answer command failed (%s mode): %d", mode_name, rc);
+        }
+    } else {
+        MB_LOG_WARNING("Autoanswer command IS EMPTY for %s mode", mode_name);
+    }
+
+    /* Bytes read past the last result code (e.g. RING) */
+    char rest[SMALL_BUFFER_SIZE];
+    size_t rest_len = serial_line_flush(&ctx->serial, rest, sizeof(rest));
+    if (rest_len > 0) {
+        modem_process_hardware_message(&ctx->modem, rest, rest_len);
+    }
+
+    MB_LOG_INFO("Modem initialized in %lld ms", bridge_monotonic_ms() - start);
+}
+
+int bridge_start(bridge_ctx_t *ctx)
+{
+    if (ctx == NULL || ctx->config == NULL) {
+        return ERROR_INVALID_ARG;
+    }
+
+    MB_LOG_INFO("Starting bridge");
+
+#ifdef ENABLE_LEVEL2
+    if (ctx->ts_serial_to_telnet_buf.data == NULL || ctx->ts_telnet_to_serial_buf.data == NULL) {
+        MB_LOG_ERROR("Bridge buffers not allocated");
+        return ERROR_GENERAL;
+    }
+#endif
 
-            printf("[INFO] === MODEM_AUTOANSWER command completed (%s mode) ===\n", mode_name);
+    /* Initialize retry state */
+    ctx->serial_ready = false;
+    ctx->modem_ready = false;
+    ctx->last_serial_retry = 0;
+    ctx->serial_retry_interval = 10;  /* 10 seconds */
+    ctx->serial_retry_count = 0;
+
+    /* Lock serial port using UUCP-style lock file (modem_sample approach) */
+    printf("[DEBUG] Attempting to lock serial port: %s\n", ctx->config->serial_port);
+    fflush(stdout);
+    int lock_ret = serial_lock_port(ctx->config->serial_port);
+    if (lock_ret != SUCCESS) {
+        printf("[WARNING] Failed to lock serial port (already in use?), continuing anyway\n");
+        fflush(stdout);
+        MB_LOG_WARNING("Failed to lock serial port %s (may already be in use)",
+                      ctx->config->serial_port);
+        /* Continue anyway - some systems don't support UUCP locking */
+    } else {
+        printf("[DEBUG] Serial port locked successfully\n");
+        fflush(stdout);
+        MB_LOG_INFO("Serial port locked: %s", ctx->config->serial_port);
+    }
+
+    /* Try to open serial port (non-blocking) */
+    printf("[DEBUG] Attempting to open serial port: %s\n", ctx->config->serial_port);
+    fflush(stdout);
+    int ret = serial_open(&ctx->serial, ctx->config->serial_port, ctx->config);
+    printf("[DEBUG] serial_open() returned: %d (SUCCESS=%d)\n", ret, SUCCESS);
+    fflush(stdout);
+
+    if (ret == SUCCESS) {
+        printf("[DEBUG] Serial port opened successfully, will flush buffers and send MODEM_AUTOANSWER_COMMAND\n");
+        fflush(stdout);
+        ctx->serial_ready = true;
+
+        /* Flush any stale data in serial buffers */
+        printf("[INFO] Flushing serial port buffers to clear stale data\n");
+        fflush(stdout);
+        serial_flush(&ctx->serial, TCIOFLUSH);
+        MB_LOG_INFO("Serial port buffers flushed");
+
+        /* Initialize modem */
+        modem_init(&ctx->modem, &ctx->serial);
+
+  #ifdef ENABLE_LEVEL3
+        /* Register DCD event callback for Level 3 integration */
+        /* This callback works in all levels (1, 2, 3) for DCD monitoring */
+        printf("[DEBUG] Registering DCD event callback with modem\n");
+        fflush(stdout);
+        int dcd_ret = modem_set_dcd_event_callback(&ctx->modem,
+                                                  (int (*)(void *, bool))bridge_handle_dcd_event,
+                                                  ctx);
+        if (dcd_ret == SUCCESS) {
+            printf("[DEBUG] DCD event callback registered successfully\n");
             fflush(stdout);
-            MB_LOG_INFO("=== MODEM_AUTOANSWER command completed (%s mode) ===", mode_name);
+            MB_LOG_DEBUG("DCD event callback registered with modem");
         } else {
-            printf("[DEBUG] Autoanswer command IS EMPTY for %s mode, skipping execution\n", mode_name);
+            printf("[WARNING] Failed to register DCD event callback: %d\n", dcd_ret);
             fflush(stdout);
-            MB_LOG_WARNING("Autoanswer command IS EMPTY for %s mode", mode_name);
+            MB_LOG_WARNING("Failed to register DCD event callback: %d", dcd_ret);
         }
+#else
+        /* Level 3 not available - DCD callback registration skipped */
+        printf("[DEBUG] Level 3 not enabled, DCD event callback registration skipped\n");
+        fflush(stdout);
+        MB_LOG_DEBUG("Level 3 not enabled, DCD event callback registration skipped");
+#endif
+
+        ctx->modem_ready = true;
 
-        /* Wait for all pending responses and flush buffers before starting threads */
-        printf("[INFO] Waiting for modem to settle (1 second)...\n");
+        /* === MODEM_INIT_COMMAND, then the auto-answer command === */
+        printf("[INFO] === Initializing hardware modem ===\n");
+        fflush(stdout);
+        bridge_initialize_modem(ctx);
+        printf("[INFO] === Hardware modem initialization completed ===\n");
         fflush(stdout);
-        usleep(1000000);  /* 1 second */
 
         /* Drain any remaining responses from initialization commands */
         /* IMPORTANT: Process ALL hardware messages during draining (modem_sample pattern) */
@@ -959,6 +1547,9 @@ int bridge_start(bridge_ctx_t *ctx)
 
     /* Open data log if enabled (independent of serial) */
     if (ctx->config->data_log_enabled) {
+        datalog_configure(&ctx->datalog, ctx->config->data_log_format,
+                          ctx->config->data_log_flush, ctx->config->data_log_flush_ms,
+                          (size_t)ctx->config->data_log_flush_bytes);
         int ret_log = datalog_open(&ctx->datalog, ctx->config->data_log_file);
         if (ret_log == SUCCESS) {
             datalog_session_start(&ctx->datalog);
@@ -990,140 +1581,62 @@ int bridge_start(bridge_ctx_t *ctx)
     /* Start threads (multithread mode) */
     ctx->thread_running = true;
 
+    if (ctx->use_worker_pool) {
+        /* Multi-line mode: serial/telnet passes run on the shared worker pool */
+        MB_LOG_INFO("[line.%d] Serial/Telnet I/O driven by multi-line worker pool", ctx->line_id);
+    } else if (bridge_start_threads(ctx) != SUCCESS) {
+        return ERROR_GENERAL;
+    }
+
 #ifdef ENABLE_LEVEL3
-    /* === LEVEL 3 MODE: Create both Serial and Telnet threads === */
-    printf("[INFO] Creating Serial/Modem thread (Level 3 - Part 1)...\n");
+    /* Initialize Level 3 system */
+    printf("[INFO] Initializing Level 3 system...\n");
     fflush(stdout);
-    MB_LOG_INFO("Creating Serial/Modem thread (Level 3 - Part 1)...");
+    int init_ret = bridge_init_level3(ctx);
+    if (init_ret != SUCCESS) {
+        printf("[WARNING] Failed to initialize Level 3 system: %d\n", init_ret);
+        fflush(stdout);
+        MB_LOG_WARNING("Failed to initialize Level 3 system: %d", init_ret);
+    } else {
+        printf("[INFO] Level 3 system initialized, level3_enabled=%d\n", ctx->level3_enabled);
+        fflush(stdout);
+    }
 
-    int ret_serial = pthread_create(&ctx->serial_thread, NULL, serial_modem_thread_func, ctx);
-    if (ret_serial != 0) {
-        printf("[ERROR] Failed to create serial thread: %s\n", strerror(ret_serial));
+    /* Start Level 3 system if enabled */
+    if (ctx->level3_enabled) {
+        printf("[INFO] Creating Level 3 management thread...\n");
+        fflush(stdout);
+        MB_LOG_INFO("Creating Level 3 management thread...");
+
+        int ret_l3 = bridge_start_level3(ctx);
+        if (ret_l3 != SUCCESS) {
+            printf("[WARNING] Failed to start Level 3 system: %d\n", ret_l3);
+            fflush(stdout);
+            MB_LOG_WARNING("Failed to start Level 3 system: %d", ret_l3);
+            /* Continue without Level 3 - not critical */
+        } else {
+            printf("[INFO] Level 3 management thread created successfully\n");
+            fflush(stdout);
+            MB_LOG_INFO("Level 3 management thread created successfully");
+        }
+    } else {
+        printf("[WARNING] Level 3 enabled flag is false, not starting Level 3 thread\n");
         fflush(stdout);
-        MB_LOG_ERROR("Failed to create serial thread: %s", strerror(ret_serial));
-        ctx->thread_running = false;
-        ctx->running = false;
-        return ERROR_GENERAL;
     }
-    printf("[INFO] Level 1 serial thread created successfully (pthread_id=%lu)\n", (unsigned long)ctx->serial_thread);
-    fflush(stdout);
-    MB_LOG_INFO("Level 1 serial thread created successfully");
+#endif
 
-    printf("[INFO] Creating Telnet thread (Level 3 - Part 2)...\n");
+    printf("[DEBUG] bridge_start() about to check serial_ready status: %d\n", ctx->serial_ready);
     fflush(stdout);
-    MB_LOG_INFO("Creating Telnet thread (Level 3 - Part 2)...");
 
-    int ret_telnet = pthread_create(&ctx->telnet_thread, NULL, telnet_thread_func, ctx);
-    if (ret_telnet != 0) {
-        printf("[ERROR] Failed to create telnet thread: %s\n", strerror(ret_telnet));
+    if (ctx->serial_ready) {
+        printf("[DEBUG] Serial IS ready\n");
         fflush(stdout);
-        MB_LOG_ERROR("Failed to create telnet thread: %s", strerror(ret_telnet));
-
-        /* Clean up serial thread since telnet failed */
-        pthread_cancel(ctx->serial_thread);
-        pthread_join(ctx->serial_thread, NULL);
-
-        ctx->thread_running = false;
-        ctx->running = false;
-        return ERROR_GENERAL;
-    }
-    printf("[INFO] Level 2 telnet thread created successfully (pthread_id=%lu)\n", (unsigned long)ctx->telnet_thread);
-    fflush(stdout);
-    MB_LOG_INFO("Level 2 telnet thread created successfully");
-
-    printf("[INFO] Level 3: Both Level 1 (serial) and Level 2 (telnet) threads created successfully\n");
-    fflush(stdout);
-    MB_LOG_INFO("Level 3: Both Level 1 (serial) and Level 2 (telnet) threads created successfully");
-
-#else /* ENABLE_LEVEL3 not defined */
-
-#ifdef ENABLE_LEVEL2
-    /* === LEVEL 2 MODE: Create Telnet thread only === */
-    printf("[INFO] Creating Telnet thread (Level 2)...\n");
-    fflush(stdout);
-    MB_LOG_INFO("Creating Telnet thread (Level 2)...");
-    int ret_thread = pthread_create(&ctx->telnet_thread, NULL, telnet_thread_func, ctx);
-    if (ret_thread != 0) {
-        printf("[ERROR] Failed to create telnet thread: %s\n", strerror(ret_thread));
-        fflush(stdout);
-        MB_LOG_ERROR("Failed to create telnet thread: %s", strerror(ret_thread));
-        ctx->thread_running = false;
-        ctx->running = false;
-        return ERROR_GENERAL;
-    }
-    printf("[INFO] Level 2 telnet thread created successfully (pthread_id=%lu)\n", (unsigned long)ctx->telnet_thread);
-    fflush(stdout);
-    MB_LOG_INFO("Level 2 telnet thread created successfully");
-#else
-    /* === LEVEL 1 MODE: Create Serial thread only === */
-    printf("[INFO] Creating Serial/Modem thread (Level 1)...\n");
-    fflush(stdout);
-    MB_LOG_INFO("Creating Serial/Modem thread (Level 1)...");
-    int ret_thread = pthread_create(&ctx->serial_thread, NULL, serial_modem_thread_func, ctx);
-    if (ret_thread != 0) {
-        printf("[ERROR] Failed to create serial thread: %s\n", strerror(ret_thread));
-        fflush(stdout);
-        MB_LOG_ERROR("Failed to create serial thread: %s", strerror(ret_thread));
-        ctx->thread_running = false;
-        ctx->running = false;
-        return ERROR_GENERAL;
-    }
-    printf("[INFO] Level 1 serial thread created successfully (pthread_id=%lu)\n", (unsigned long)ctx->serial_thread);
-    fflush(stdout);
-    MB_LOG_INFO("Level 1 serial thread created successfully");
-#endif /* ENABLE_LEVEL2 */
-
-#endif /* ENABLE_LEVEL3 */
-
-#ifdef ENABLE_LEVEL3
-    /* Initialize Level 3 system */
-    printf("[INFO] Initializing Level 3 system...\n");
-    fflush(stdout);
-    int init_ret = bridge_init_level3(ctx);
-    if (init_ret != SUCCESS) {
-        printf("[WARNING] Failed to initialize Level 3 system: %d\n", init_ret);
-        fflush(stdout);
-        MB_LOG_WARNING("Failed to initialize Level 3 system: %d", init_ret);
-    } else {
-        printf("[INFO] Level 3 system initialized, level3_enabled=%d\n", ctx->level3_enabled);
-        fflush(stdout);
-    }
-
-    /* Start Level 3 system if enabled */
-    if (ctx->level3_enabled) {
-        printf("[INFO] Creating Level 3 management thread...\n");
-        fflush(stdout);
-        MB_LOG_INFO("Creating Level 3 management thread...");
-
-        int ret_l3 = bridge_start_level3(ctx);
-        if (ret_l3 != SUCCESS) {
-            printf("[WARNING] Failed to start Level 3 system: %d\n", ret_l3);
-            fflush(stdout);
-            MB_LOG_WARNING("Failed to start Level 3 system: %d", ret_l3);
-            /* Continue without Level 3 - not critical */
-        } else {
-            printf("[INFO] Level 3 management thread created successfully\n");
-            fflush(stdout);
-            MB_LOG_INFO("Level 3 management thread created successfully");
-        }
-    } else {
-        printf("[WARNING] Level 3 enabled flag is false, not starting Level 3 thread\n");
-        fflush(stdout);
-    }
-#endif
-
-    printf("[DEBUG] bridge_start() about to check serial_ready status: %d\n", ctx->serial_ready);
-    fflush(stdout);
-
-    if (ctx->serial_ready) {
-        printf("[DEBUG] Serial IS ready\n");
-        fflush(stdout);
-        MB_LOG_INFO("Bridge started (READY state), waiting for modem commands");
-    } else {
-        printf("[DEBUG] Serial IS NOT ready\n");
-        fflush(stdout);
-        MB_LOG_INFO("Bridge started (DISCONNECTED state), waiting for serial port");
-    }
+        MB_LOG_INFO("Bridge started (READY state), waiting for modem commands");
+    } else {
+        printf("[DEBUG] Serial IS NOT ready\n");
+        fflush(stdout);
+        MB_LOG_INFO("Bridge started (DISCONNECTED state), waiting for serial port");
+    }
 
     printf("[DEBUG] bridge_start() returning SUCCESS\n");
     fflush(stdout);
@@ -1146,13 +1659,12 @@ int bridge_stop(bridge_ctx_t *ctx)
 
     /* Signal threads to stop */
     ctx->thread_running = false;
+    bridge_wake(ctx);
 
     /* Wake up any blocked threads */
 #ifdef ENABLE_LEVEL2
-    pthread_cond_broadcast(&ctx->ts_serial_to_telnet_buf.cond_not_empty);
-    pthread_cond_broadcast(&ctx->ts_serial_to_telnet_buf.cond_not_full);
-    pthread_cond_broadcast(&ctx->ts_telnet_to_serial_buf.cond_not_empty);
-    pthread_cond_broadcast(&ctx->ts_telnet_to_serial_buf.cond_not_full);
+    ts_cbuf_wake(&ctx->ts_serial_to_telnet_buf);
+    ts_cbuf_wake(&ctx->ts_telnet_to_serial_buf);
 #else
     /* Level 1: Telnet buffers not available */
 #endif
@@ -1163,43 +1675,17 @@ int bridge_stop(bridge_ctx_t *ctx)
     bridge_stop_level3(ctx);
 #endif
 
-  #ifdef ENABLE_LEVEL3
-    /* === LEVEL 3 MODE: Wait for both Serial and Telnet threads === */
-    MB_LOG_INFO("Waiting for Level 1 serial thread to exit...");
-    pthread_join(ctx->serial_thread, NULL);
-    MB_LOG_INFO("Serial/Modem thread (Level 1) exited");
-
-    MB_LOG_INFO("Waiting for Level 2 telnet thread to exit...");
-    pthread_join(ctx->telnet_thread, NULL);
-    MB_LOG_INFO("Telnet thread (Level 2) exited");
-
-    /* Disconnect telnet if connected */
-    if (telnet_is_connected(&ctx->telnet)) {
-        telnet_disconnect(&ctx->telnet);
+    if (!ctx->use_worker_pool) {
+        bridge_join_threads(ctx);
     }
-#else
 
 #ifdef ENABLE_LEVEL2
-    MB_LOG_INFO("Waiting for Level 2 telnet thread to exit...");
-
-    /* Wait for Level 2 telnet thread to exit */
-    pthread_join(ctx->telnet_thread, NULL);
-    MB_LOG_INFO("Telnet thread (Level 2) exited");
-
     /* Disconnect telnet if connected */
     if (telnet_is_connected(&ctx->telnet)) {
         telnet_disconnect(&ctx->telnet);
     }
-#else
-    MB_LOG_INFO("Waiting for Level 1 serial thread to exit...");
-
-    /* Wait for Level 1 serial thread to exit */
-    pthread_join(ctx->serial_thread, NULL);
-    MB_LOG_INFO("Serial/Modem thread (Level 1) exited");
 #endif
 
-#endif /* ENABLE_LEVEL3 */
-
     /* Hang up modem (if serial is ready) */
     if (ctx->modem_ready && modem_is_online(&ctx->modem)) {
         modem_hangup(&ctx->modem);
@@ -1211,7 +1697,7 @@ int bridge_stop(bridge_ctx_t *ctx)
     }
 
     /* Unlock serial port (modem_sample approach) */
-    serial_unlock_port();
+    serial_unlock_device(ctx->config->serial_port);
     MB_LOG_INFO("Serial port unlocked");
 
     /* Close data log */
@@ -1225,6 +1711,8 @@ int bridge_stop(bridge_ctx_t *ctx)
 #ifdef ENABLE_LEVEL2
     ts_cbuf_destroy(&ctx->ts_serial_to_telnet_buf);
     ts_cbuf_destroy(&ctx->ts_telnet_to_serial_buf);
+    telnet_release_buffers(&ctx->telnet);
+    passthru_close(&ctx->passthru);
 #endif
 
     /* Print statistics */
@@ -1235,7 +1723,156 @@ int bridge_stop(bridge_ctx_t *ctx)
     return SUCCESS;
 }
 
+/**
+ * Log how much of the line's TX capacity the call used
+ */
+static void bridge_log_line_utilization(bridge_ctx_t *ctx)
+{
+    serial_tx_pace_stats_t stats;
+
+    if (serial_tx_get_pace_stats(&ctx->serial, &stats) != SUCCESS || stats.bytes == 0) {
+        return;
+    }
+
+    MB_LOG_INFO("Serial TX line: %d bps (%d bits/char%s), %llu bytes, %.1f of %.1f cps while queued (%.1f%% utilization)",
+                stats.line_bps, stats.bits_per_char, stats.paced ? ", paced" : "",
+                (unsigned long long)stats.bytes, stats.achieved_cps, stats.theoretical_cps,
+                stats.utilization_pct);
+}
+
+#ifdef ENABLE_LEVEL2
+/**
+ * Cap how much each ring may hold to match the negotiated line rate
+ * (capacity itself is fixed at bridge_init; 0 = no cap)
+ */
+static void bridge_apply_line_rate(bridge_ctx_t *ctx, int bps)
+{
+    size_t limit = bps > 0 ? serial_buffer_size_for_speed(bps, ctx->buffer_size)
+                           : ctx->buffer_size;
+
+    ts_cbuf_set_limit(&ctx->ts_serial_to_telnet_buf, limit);
+    ts_cbuf_set_limit(&ctx->ts_telnet_to_serial_buf, limit);
 #ifdef ENABLE_LEVEL2
+    telnet_set_line_rate(&ctx->telnet, bps > 0 ? bps : ctx->config->baudrate_value);
+#endif
+    serial_tx_set_line_rate(&ctx->serial, bps);
+    serial_set_rx_profile(&ctx->serial, bps > 0 ? bps : ctx->config->baudrate_value);
+
+    if (ctx->metrics != NULL) {
+        atomic_store_explicit(&ctx->metrics->connect_bps, (uint64_t)MAX(bps, 0), memory_order_relaxed);
+    }
+
+    MB_LOG_DEBUG("Line rate %d bps: buffering %zu of %zu bytes per direction",
+                bps, MIN(limit, ctx->buffer_size), ctx->buffer_size);
+}
+
+/**
+ * Open the telnet session of a call
+ * A dialing directory target connects to the least-loaded healthy backend
+ * of its pool; without one, DIAL_DEFAULT is used, then TELNET_HOST.
+ */
+int bridge_telnet_connect(bridge_ctx_t *ctx, dialdir_target_t *target)
+{
+    int ret;
+
+    if (ctx == NULL) {
+        return ERROR_INVALID_ARG;
+    }
+
+    if (target == NULL) {
+        target = dialdir_find_name(ctx->config->dial_default);
+    }
+    if (target != NULL) {
+        ret = telnet_connect_target(&ctx->telnet, target);
+    } else {
+        MB_LOG_INFO("Connecting to telnet server %s:%d",
+                   ctx->config->telnet_host, ctx->config->telnet_port);
+        ret = telnet_connect(&ctx->telnet, ctx->config->telnet_host, ctx->config->telnet_port);
+    }
+
+    /* New socket: let an event-driven bridge register it */
+    bridge_wake(ctx);
+    return ret;
+}
+
+/**
+ * RING from the modem: resolve the server in the background and, with
+ * PRECONNECT_ON_RING, open the telnet connection while the modem answers.
+ * The early connect only starts once the address is cached, so the serial
+ * path never waits on DNS: the first RING of a call warms the cache.
+ */
+static void bridge_preconnect_on_ring(bridge_ctx_t *ctx)
+{
+    const char *host = ctx->config->telnet_host;
+    int port = ctx->config->telnet_port;
+    dialdir_target_t *target = dialdir_find_name(ctx->config->dial_default);
+
+    if (target != NULL) {
+        dialdir_prefetch(target);
+    } else {
+        resolver_prefetch(host, port);
+    }
+
+    if (!ctx->config->preconnect_on_ring || ctx->telnet.fd >= 0) {
+        return;
+    }
+    if (target != NULL ? !dialdir_ready(target) : !resolver_ready(host, port)) {
+        MB_LOG_DEBUG("Pre-connect deferred until the server resolves");
+        return;
+    }
+
+    MB_LOG_INFO("RING: pre-connecting to the telnet server");
+    ctx->preconnect_time = time(NULL);
+    atomic_store(&ctx->preconnect_hold, true);
+    if (bridge_telnet_connect(ctx, target) != SUCCESS) {
+        MB_LOG_WARNING("Pre-connect failed - will connect after CONNECT");
+        atomic_store(&ctx->preconnect_hold, false);
+    }
+}
+
+/**
+ * CONNECT: hand a pre-connected telnet session to the data path
+ * @return true if the telnet connection is already open or in progress
+ */
+static bool bridge_preconnect_claim(bridge_ctx_t *ctx)
+{
+    if (!atomic_exchange(&ctx->preconnect_hold, false)) {
+        return false;
+    }
+
+    /* Server data may flow now: event loops re-enable EPOLLIN */
+    bridge_wake(ctx);
+
+    if (ctx->telnet.fd < 0) {
+        return false;
+    }
+
+    MB_LOG_INFO("Using telnet connection opened on RING (%ld s before CONNECT)",
+               (long)(time(NULL) - ctx->preconnect_time));
+    return true;
+}
+
+/**
+ * Close a pre-connected telnet session whose call never came up
+ * @param force Close now (call ended) instead of after BRIDGE_PRECONNECT_TIMEOUT
+ */
+static void bridge_preconnect_expire(bridge_ctx_t *ctx, bool force)
+{
+    if (!atomic_load(&ctx->preconnect_hold)) {
+        return;
+    }
+    if (!force && time(NULL) - ctx->preconnect_time < BRIDGE_PRECONNECT_TIMEOUT) {
+        return;
+    }
+    if (!atomic_exchange(&ctx->preconnect_hold, false)) {
+        return;
+    }
+
+    MB_LOG_INFO("No CONNECT after RING - closing pre-connected telnet session");
+    telnet_disconnect(&ctx->telnet);
+    bridge_wake(ctx);
+}
+
 /**
  * Handle modem connection establishment and initiate telnet connection (Level 2 only)
  * Called when hardware modem is ONLINE (CONNECT message received)
@@ -1248,13 +1885,18 @@ int bridge_handle_modem_connect(bridge_ctx_t *ctx)
 
     MB_LOG_INFO("=== Hardware modem CONNECT received - starting telnet connection ===");
 
+    /* Size buffering to the carrier rate reported by CONNECT */
+    ctx->connected_baudrate = ctx->modem.connect_speed;
+    bridge_apply_line_rate(ctx, ctx->connected_baudrate);
+
     /* Hardware modem is already ONLINE at this point */
     /* modem->state should be MODEM_STATE_ONLINE, modem->online should be true */
 
-    /* Connect to telnet server */
-    MB_LOG_INFO("Connecting to telnet server %s:%d",
-               ctx->config->telnet_host, ctx->config->telnet_port);
-    int ret = telnet_connect(&ctx->telnet, ctx->config->telnet_host, ctx->config->telnet_port);
+    /* Connect to telnet server (unless already opened on RING) */
+    int ret = SUCCESS;
+    if (!bridge_preconnect_claim(ctx)) {
+        ret = bridge_telnet_connect(ctx, NULL);
+    }
     if (ret != SUCCESS) {
         MB_LOG_ERROR("Failed to connect to telnet server");
         /* Hardware modem is online but telnet failed - send NO CARRIER and hang up */
@@ -1302,7 +1944,7 @@ static void bridge_sync_echo_mode(bridge_ctx_t *ctx)
     }
 
     /* If server will echo, disable modem local echo to prevent double echo */
-    if (ctx->telnet.remote_options[TELOPT_ECHO]) {
+    if (telnet_opt_test(&ctx->telnet.remote_options, TELOPT_ECHO)) {
         if (ctx->modem.settings.echo) {
             MB_LOG_INFO("Server WILL ECHO - disabling modem local echo to prevent double echo");
             ctx->modem.settings.echo = false;
@@ -1332,99 +1974,8 @@ static int bridge_reinitialize_modem(bridge_ctx_t *ctx)
     /* Reinitialize modem structure */
     modem_init(&ctx->modem, &ctx->serial);
 
-    /* Execute MODEM_INIT_COMMAND if configured */
-    if (ctx->config->modem_init_command[0] != '\0') {
-        char cmd_buf[LINE_BUFFER_SIZE * 2];
-        unsigned char response[SMALL_BUFFER_SIZE];
-
-        MB_LOG_INFO("Executing MODEM_INIT_COMMAND for reinitialization");
-        MB_LOG_DEBUG("Command: %s", ctx->config->modem_init_command);
-
-        /* Process commands separated by semicolons */
-        char *cmd_copy = strdup(ctx->config->modem_init_command);
-        char *token = strtok(cmd_copy, ";");
-
-        while (token != NULL) {
-            /* Skip leading/trailing spaces */
-            while (*token == ' ') token++;
-            char *end = token + strlen(token) - 1;
-            while (end > token && *end == ' ') *end-- = '\0';
-
-            if (*token != '\0') {
-                /* Build command with AT prefix if needed and \r\n suffix */
-                if (strncasecmp(token, "AT", 2) == 0) {
-                    snprintf(cmd_buf, sizeof(cmd_buf), "%s\r\n", token);
-                } else {
-                    snprintf(cmd_buf, sizeof(cmd_buf), "AT%s\r\n", token);
-                }
-
-                /* Send command to modem */
-                MB_LOG_DEBUG("Sending reinit command: %s", token);
-                ssize_t sent = serial_write(&ctx->serial,
-                                (const unsigned char *)cmd_buf,
-                                strlen(cmd_buf));
-
-                if (sent > 0) {
-                    /* Wait for response */
-                    usleep(200000);  /* 200ms between commands */
-                    ssize_t resp_len = serial_read(&ctx->serial, response, sizeof(response) - 1);
-
-                    if (resp_len > 0) {
-                        response[resp_len] = '\0';
-                        MB_LOG_DEBUG("Reinit response: %.*s", (int)resp_len, response);
-                    }
-                }
-            }
-
-            token = strtok(NULL, ";");
-        }
-
-        free(cmd_copy);
-        MB_LOG_INFO("MODEM_INIT_COMMAND reinitialization completed");
-
-        /* Small delay after initialization */
-        usleep(500000);  /* 500ms */
-    }
-
-    /* Re-apply auto-answer settings */
-    const char *autoanswer_cmd = NULL;
-    const char *mode_name = NULL;
-
-    if (ctx->config->modem_autoanswer_mode == 0) {
-        /* SOFTWARE mode: S0=0, manual ATA required */
-        autoanswer_cmd = ctx->config->modem_autoanswer_software_command;
-        mode_name = "SOFTWARE";
-    } else {
-        /* HARDWARE mode: S0>0, automatic answer */
-        autoanswer_cmd = ctx->config->modem_autoanswer_hardware_command;
-        mode_name = "HARDWARE";
-    }
-
-    if (autoanswer_cmd && autoanswer_cmd[0] != '\0') {
-        char cmd_buf[LINE_BUFFER_SIZE * 2];  /* Double size to prevent truncation */
-
-        /* Build command with AT prefix if needed */
-        if (strncasecmp(autoanswer_cmd, "AT", 2) == 0) {
-            snprintf(cmd_buf, sizeof(cmd_buf), "%s\r\n", autoanswer_cmd);
-        } else {
-            snprintf(cmd_buf, sizeof(cmd_buf), "AT%s\r\n", autoanswer_cmd);
-        }
-
-        MB_LOG_INFO("Setting auto-answer mode: %s (%s)", mode_name, autoanswer_cmd);
-        ssize_t sent = serial_write(&ctx->serial,
-                        (const unsigned char *)cmd_buf,
-                        strlen(cmd_buf));
-
-        if (sent > 0) {
-            unsigned char response[SMALL_BUFFER_SIZE];
-            usleep(200000);  /* 200ms wait */
-            ssize_t resp_len = serial_read(&ctx->serial, response, sizeof(response) - 1);
-            if (resp_len > 0) {
-                response[resp_len] = '\0';
-                MB_LOG_DEBUG("Auto-answer response: %.*s", (int)resp_len, response);
-            }
-        }
-    }
+    /* MODEM_INIT_COMMAND and auto-answer settings, as at startup */
+    bridge_initialize_modem(ctx);
 
     MB_LOG_INFO("Modem reinitialization complete - ready for new connections");
     return SUCCESS;
@@ -1443,7 +1994,12 @@ int bridge_handle_modem_disconnect(bridge_ctx_t *ctx)
 
     MB_LOG_INFO("Modem disconnected - cleaning up connection");
 
-    /* Disconnect telnet if connected */
+    bridge_log_line_utilization(ctx);
+    ctx->connected_baudrate = 0;
+    bridge_apply_line_rate(ctx, 0);
+
+    /* Disconnect telnet if connected (or opened on RING for this call) */
+    bridge_preconnect_expire(ctx, true);
     if (telnet_is_connected(&ctx->telnet)) {
         telnet_disconnect(&ctx->telnet);
     }
@@ -1513,62 +2069,77 @@ int bridge_handle_telnet_disconnect(bridge_ctx_t *ctx)
 }
 #endif
 
-#ifndef ENABLE_LEVEL2
 /**
- * Process data from serial port - Level 1 exclusive implementation
- * Handles serial I/O errors and transitions to DISCONNECTED state
- * Focuses on direct modem-client communication without telnet
+ * ATD: connect to the dialed target and answer CONNECT or NO CARRIER
+ * An empty dial string (ATD alone) dials DIAL_DEFAULT, then TELNET_HOST.
  */
-int bridge_process_serial_data(bridge_ctx_t *ctx)
+static void bridge_dial_pending(bridge_ctx_t *ctx)
 {
-    unsigned char buf[BUFFER_SIZE];
-    ssize_t n;
+    char number[SMALL_BUFFER_SIZE];
+    bool connected = false;
 
-    if (ctx == NULL) {
-        return ERROR_INVALID_ARG;
+    pthread_mutex_lock(&ctx->modem_mutex);
+    bool dialed = modem_take_dial(&ctx->modem, number, sizeof(number));
+    pthread_mutex_unlock(&ctx->modem_mutex);
+    if (!dialed) {
+        return;
     }
 
-    /* Read from serial port */
-    struct timeval tv_before, tv_after;
-    gettimeofday(&tv_before, NULL);
+#ifdef ENABLE_LEVEL2
+    dialdir_target_t *target = NULL;
+    if (number[0] != '\0') {
+        target = dialdir_find(number);
+    }
 
-    printf("[DEBUG] [Level 1] bridge_process_serial_data: About to call serial_read()\n");
-    fflush(stdout);
-    n = serial_read(&ctx->serial, buf, sizeof(buf));
-
-    gettimeofday(&tv_after, NULL);
-    long elapsed_us = (tv_after.tv_sec - tv_before.tv_sec) * 1000000L +
-                      (tv_after.tv_usec - tv_before.tv_usec);
+    if (number[0] != '\0' && target == NULL) {
+        MB_LOG_INFO("ATD%s: not in the dialing directory", number);
+    } else if (bridge_telnet_connect(ctx, target) != SUCCESS) {
+        MB_LOG_ERROR("ATD%s: no telnet server could be reached", number);
+    } else {
+        connected = true;
+    }
+#else
+    /* Level 1 has no telnet side to dial */
+    MB_LOG_INFO("ATD%s: dialing needs a Level 2 build", number);
+#endif
 
-    printf("[DEBUG] [Level 1] bridge_process_serial_data: serial_read() returned %zd (took %ld us)\n", n, elapsed_us);
-    fflush(stdout);
+    pthread_mutex_lock(&ctx->modem_mutex);
+    if (connected) {
+        /* Like an answered call: CONNECT now, NO CARRIER if the connect fails later */
+        modem_go_online(&ctx->modem);
+        modem_send_connect(&ctx->modem, ctx->config->baudrate_value);
+    } else {
+        modem_send_no_carrier(&ctx->modem);
+    }
+    pthread_mutex_unlock(&ctx->modem_mutex);
 
-    if (n > 0) {
-        /* Log ALL serial data with hex dump for debugging */
-        time_t now = time(NULL);
-        struct tm *tm_info = localtime(&now);
-        char timestamp[64];
-        strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", tm_info);
+    if (connected) {
+        pthread_mutex_lock(&ctx->state_mutex);
+        ctx->state = STATE_CONNECTED;
+        ctx->connection_start_time = time(NULL);
+        pthread_mutex_unlock(&ctx->state_mutex);
+    }
+}
 
-        printf("[INFO] [%s] [Level 1] <<< Serial RX: %zd bytes >>>\n", timestamp, n);
-        fflush(stdout);
-        MB_LOG_INFO("[Level 1] <<< Serial RX: %zd bytes >>>", n);
-        MB_LOG_DEBUG("  HEX: %.*s", (int)n, buf);
+#ifndef ENABLE_LEVEL2
+/**
+ * Process data from serial port - Level 1 exclusive implementation
+ * Handles serial I/O errors and transitions to DISCONNECTED state
+ * Focuses on direct modem-client communication without telnet
+ */
+int bridge_process_serial_data(bridge_ctx_t *ctx)
+{
+    unsigned char buf[BUFFER_SIZE];
+    ssize_t n;
 
-        /* Print as hex for better visibility */
-        char hex_str[BUFFER_SIZE * 3 + 1];
-        for (ssize_t i = 0; i < n && i < 64; i++) {
-            snprintf(hex_str + i*3, 4, "%02X ", (unsigned char)buf[i]);
-        }
-        printf("[INFO] [%s] [Level 1]   DATA: [%s]\n", timestamp, hex_str);
-        fflush(stdout);
-        MB_LOG_INFO("[Level 1]  DATA: [%s]", hex_str);
-    } else if (n == 0) {
-        printf("[DEBUG] [Level 1] bridge_process_serial_data: serial_read() returned 0 (no data or EAGAIN)\n");
-        fflush(stdout);
-        MB_LOG_DEBUG("[Level 1] serial_read() returned 0 (no data available)");
+    if (ctx == NULL) {
+        return ERROR_INVALID_ARG;
     }
 
+    /* Read from serial port (payload is traced as TRACE_SERIAL_RX) */
+    n = serial_read(&ctx->serial, buf, sizeof(buf));
+    MB_TRACE(TRACE_SERIAL_READ, n, 1);
+
     if (n < 0) {
         /* Serial I/O error detected - transition to DISCONNECTED state */
         MB_LOG_ERROR("[Level 1] Serial I/O error detected: %s", strerror(errno));
@@ -1610,7 +2181,7 @@ int bridge_process_serial_data(bridge_ctx_t *ctx)
         return SUCCESS;
     } else if (current_state == MODEM_STATE_ONLINE) {
         /* === LEVEL 1: Direct modem<->client communication, no telnet === */
-        MB_LOG_INFO("[Level 1] Hardware modem ONLINE - direct modem<->client communication");
+        MB_TRACE(TRACE_MODEM_ONLINE_DATA, n, 1);
 
         /* Mark that client connection is established (ONLY after CONNECT) */
         if (!ctx->client_data_received) {
@@ -1658,6 +2229,7 @@ int bridge_process_serial_data(bridge_ctx_t *ctx)
     if (!hardware_msg_handled && !modem_is_online(&ctx->modem)) {
         /* In command mode - let modem process the input */
         modem_process_input(&ctx->modem, (char *)buf, n);
+        bridge_dial_pending(ctx);
         return SUCCESS;
     }
 
@@ -1675,7 +2247,7 @@ int bridge_process_serial_data(bridge_ctx_t *ctx)
 
     /* === LEVEL 1: Data is handled directly between modem and client === */
     /* No telnet forwarding needed - client data stays local */
-    MB_LOG_DEBUG("[Level 1] Processed %zd bytes from client (no telnet forward)", consumed);
+    MB_TRACE(TRACE_MODEM_ONLINE_DATA, consumed, 1);
 
     /* === ECHO FUNCTIONALITY (Level 1) === */
     /* Process client data for echo with timestamp formatting */
@@ -1730,46 +2302,12 @@ int bridge_process_serial_data_level2(bridge_ctx_t *ctx)
         return ERROR_INVALID_ARG;
     }
 
-    /* Read from serial port */
-    struct timeval tv_before, tv_after;
-    gettimeofday(&tv_before, NULL);
+    /* RING pre-connect without a CONNECT in time */
+    bridge_preconnect_expire(ctx, false);
 
-    printf("[DEBUG] [Level 2] bridge_process_serial_data: About to call serial_read()\n");
-    fflush(stdout);
+    /* Read from serial port (payload is traced as TRACE_SERIAL_RX) */
     n = serial_read(&ctx->serial, buf, sizeof(buf));
-
-    gettimeofday(&tv_after, NULL);
-    long elapsed_us = (tv_after.tv_sec - tv_before.tv_sec) * 1000000L +
-                      (tv_after.tv_usec - tv_before.tv_usec);
-
-    printf("[DEBUG] [Level 2] bridge_process_serial_data: serial_read() returned %zd (took %ld us)\n", n, elapsed_us);
-    fflush(stdout);
-
-    if (n > 0) {
-        /* Log ALL serial data with hex dump for debugging */
-        time_t now = time(NULL);
-        struct tm *tm_info = localtime(&now);
-        char timestamp[64];
-        strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", tm_info);
-
-        printf("[INFO] [%s] [Level 2] <<< Serial RX: %zd bytes >>>\n", timestamp, n);
-        fflush(stdout);
-        MB_LOG_INFO("[Level 2] <<< Serial RX: %zd bytes >>>", n);
-        MB_LOG_DEBUG("  HEX: %.*s", (int)n, buf);
-
-        /* Print as hex for better visibility */
-        char hex_str[BUFFER_SIZE * 3 + 1];
-        for (ssize_t i = 0; i < n && i < 64; i++) {
-            snprintf(hex_str + i*3, 4, "%02X ", (unsigned char)buf[i]);
-        }
-        printf("[INFO] [%s] [Level 2]   DATA: [%s]\n", timestamp, hex_str);
-        fflush(stdout);
-        MB_LOG_INFO("[Level 2]  DATA: [%s]", hex_str);
-    } else if (n == 0) {
-        printf("[DEBUG] [Level 2] bridge_process_serial_data: serial_read() returned 0 (no data or EAGAIN)\n");
-        fflush(stdout);
-        MB_LOG_DEBUG("[Level 2] serial_read() returned 0 (no data available)");
-    }
+    MB_TRACE(TRACE_SERIAL_READ, n, 2);
 
     if (n < 0) {
         /* Serial I/O error detected - transition to DISCONNECTED state */
@@ -1812,6 +2350,9 @@ int bridge_process_serial_data_level2(bridge_ctx_t *ctx)
     /* First, check for hardware modem unsolicited messages (RING, CONNECT, NO CARRIER) */
     /* This is critical for real hardware modems that send these messages */
     bool hardware_msg_handled = modem_process_hardware_message(&ctx->modem, (char *)buf, n);
+    if (memmem(buf, n, "RING", 4) != NULL) {
+        bridge_preconnect_on_ring(ctx);
+    }
 
     /* Check for state changes after hardware message processing */
     modem_state_t current_state = modem_get_state(&ctx->modem);
@@ -1823,7 +2364,7 @@ int bridge_process_serial_data_level2(bridge_ctx_t *ctx)
         return SUCCESS;
     } else if (current_state == MODEM_STATE_ONLINE) {
         /* === LEVEL 2: Hardware modem ONLINE - initiate telnet connection === */
-        MB_LOG_INFO("[Level 2] Hardware modem ONLINE - initiating telnet bridge");
+        MB_TRACE(TRACE_MODEM_ONLINE_DATA, n, 2);
 
         /* Call Level 2 specific modem connect handler */
         int ret = bridge_handle_modem_connect(ctx);
@@ -1847,6 +2388,7 @@ int bridge_process_serial_data_level2(bridge_ctx_t *ctx)
     if (!hardware_msg_handled && !modem_is_online(&ctx->modem)) {
         /* In command mode - let modem process the input */
         modem_process_input(&ctx->modem, (char *)buf, n);
+        bridge_dial_pending(ctx);
         return SUCCESS;
     }
 
@@ -1868,9 +2410,20 @@ int bridge_process_serial_data_level2(bridge_ctx_t *ctx)
         return SUCCESS;
     }
 
-    /* Filter ANSI sequences for telnet compatibility - DISABLED */
-    ansi_filter_modem_to_telnet(buf, consumed, filtered_buf, sizeof(filtered_buf),
-                                &filtered_len, &ctx->ansi_filter_state);
+    /* Filter ANSI sequences for telnet compatibility - DISABLED
+     * (file transfers pass unfiltered) */
+    if (xfer_scan(&ctx->xfer, XFER_FROM_MODEM, buf, (size_t)consumed, bridge_monotonic_ms())) {
+        memcpy(filtered_buf, buf, (size_t)consumed);
+        filtered_len = (size_t)consumed;
+    } else {
+        if (ansi_filter_modem_to_telnet(buf, consumed, filtered_buf, sizeof(filtered_buf),
+                                        &filtered_len, &ctx->ansi_filter_state) == ERROR_BUFFER_FULL &&
+            !ctx->ansi_overflow_warned) {
+            /* Warn once per line */
+            MB_LOG_WARNING("ANSI filter output buffer full - data truncated (multibyte chars may break)");
+            ctx->ansi_overflow_warned = true;
+        }
+    }
 
     if (filtered_len == 0) {
         MB_LOG_DEBUG("[Level 2] No data after ANSI filtering");
@@ -1893,7 +2446,11 @@ int bridge_process_serial_data_level2(bridge_ctx_t *ctx)
     ssize_t sent = telnet_send(&ctx->telnet, telnet_buf, telnet_len);
     if (sent > 0) {
         ctx->bytes_serial_to_telnet += sent;
-        MB_LOG_DEBUG("[Level 2] Sent %zd bytes to telnet", sent);
+        MB_TRACE(TRACE_BRIDGE_FORWARD, DATALOG_DIR_TO_TELNET, sent);
+        if ((size_t)sent < telnet_len) {
+            MB_LOG_WARNING("[Level 2] Telnet output queue full, dropped %zu bytes",
+                          telnet_len - (size_t)sent);
+        }
     } else if (sent < 0) {
         MB_LOG_ERROR("[Level 2] Failed to send data to telnet");
         bridge_handle_telnet_disconnect(ctx);
@@ -1928,8 +2485,6 @@ int bridge_process_telnet_data(bridge_ctx_t *ctx)
 static int bridge_transfer_telnet_to_serial(bridge_ctx_t *ctx)
 {
     unsigned char telnet_buf[BUFFER_SIZE];
-    unsigned char processed_buf[BUFFER_SIZE];
-    unsigned char output_buf[BUFFER_SIZE];
     size_t processed_len, output_len;
     ssize_t n;
 
@@ -1953,27 +2508,27 @@ static int bridge_transfer_telnet_to_serial(bridge_ctx_t *ctx)
     /* Log data from telnet (raw, before IAC processing) */
     datalog_write(&ctx->datalog, DATALOG_DIR_FROM_TELNET, telnet_buf, n);
 
-    /* Process telnet protocol (remove IAC sequences) */
+    /* Process telnet protocol (remove IAC sequences, in place) */
     telnet_process_input(&ctx->telnet, telnet_buf, n,
-                        processed_buf, sizeof(processed_buf), &processed_len);
+                        telnet_buf, sizeof(telnet_buf), &processed_len);
 
     if (processed_len == 0) {
         return SUCCESS;
     }
 
     /* Pass through ANSI sequences to modem client */
-    ansi_passthrough_telnet_to_modem(processed_buf, processed_len,
-                                    output_buf, sizeof(output_buf), &output_len);
+    ansi_passthrough_telnet_to_modem(telnet_buf, processed_len,
+                                    telnet_buf, sizeof(telnet_buf), &output_len);
 
     if (output_len == 0) {
         return SUCCESS;
     }
 
     /* Log data to modem (after IAC processing, ready to send) */
-    datalog_write(&ctx->datalog, DATALOG_DIR_TO_MODEM, output_buf, output_len);
+    datalog_write(&ctx->datalog, DATALOG_DIR_TO_MODEM, telnet_buf, output_len);
 
     /* Send to serial */
-    ssize_t sent = serial_write(&ctx->serial, output_buf, output_len);
+    ssize_t sent = serial_write(&ctx->serial, telnet_buf, output_len);
     if (sent > 0) {
         ctx->bytes_telnet_to_serial += sent;
     }
@@ -1983,25 +2538,14 @@ static int bridge_transfer_telnet_to_serial(bridge_ctx_t *ctx)
 #endif
 
 /**
- * Main bridge loop (multithread mode)
- * In multithread mode, this function just sleeps and allows signal handling.
- * The actual I/O is handled by serial_modem_thread_func() and telnet_thread_func().
+ * Retry serial port if unavailable (auto-reconnect)
  */
-int bridge_run(bridge_ctx_t *ctx)
+void bridge_check_serial_retry(bridge_ctx_t *ctx)
 {
-    if (ctx == NULL) {
-        return ERROR_INVALID_ARG;
-    }
-
-    if (!ctx->running) {
-        return ERROR_GENERAL;
+    if (ctx == NULL || ctx->config == NULL) {
+        return;
     }
 
-    /* In multithread mode, threads handle all I/O operations.
-     * Main loop just sleeps to allow signal handling and config reload. */
-    usleep(100000);  /* 100ms - allows responsive signal handling */
-
-    
     /* Check if serial port needs retry (for auto-reconnect) */
     if (!ctx->serial_ready) {
         time_t now = time(NULL);
@@ -2011,8 +2555,8 @@ int bridge_run(bridge_ctx_t *ctx)
             ctx->last_serial_retry = now;
             ctx->serial_retry_count++;
 
-            /* Check if device file exists */
-            if (access(ctx->config->serial_port, F_OK) == 0) {
+            /* Check if the device is usable (reuses a recent health check result) */
+            if (healthcheck_serial_port_cached(ctx->config->serial_port, NULL) != HEALTH_STATUS_ERROR) {
                 MB_LOG_INFO("Serial port device detected (attempt #%d): %s",
                            ctx->serial_retry_count, ctx->config->serial_port);
 
@@ -2048,9 +2592,14 @@ int bridge_run(bridge_ctx_t *ctx)
 
                     /* Reset retry counter */
                     ctx->serial_retry_count = 0;
+
+                    /* Event-driven thread must pick up the new descriptor */
+                    bridge_wake(ctx);
                 } else {
                     MB_LOG_DEBUG("Serial port open failed (attempt #%d): %s",
                                 ctx->serial_retry_count, strerror(errno));
+                    /* Probe the device afresh next time */
+                    healthcheck_cache_invalidate(ctx->config->serial_port);
                 }
             } else {
                 MB_LOG_DEBUG("Serial port device not found (attempt #%d): %s",
@@ -2058,6 +2607,28 @@ int bridge_run(bridge_ctx_t *ctx)
             }
         }
     }
+}
+
+/**
+ * Main bridge loop (multithread mode)
+ * In multithread mode, this function just sleeps and allows signal handling.
+ * The actual I/O is handled by serial_modem_thread_func() and telnet_thread_func().
+ */
+int bridge_run(bridge_ctx_t *ctx)
+{
+    if (ctx == NULL) {
+        return ERROR_INVALID_ARG;
+    }
+
+    if (!ctx->running) {
+        return ERROR_GENERAL;
+    }
+
+    /* In multithread mode, threads handle all I/O operations.
+     * Main loop just sleeps to allow signal handling and config reload. */
+    usleep(100000);  /* 100ms - allows responsive signal handling */
+
+    bridge_check_serial_retry(ctx);
 
     return SUCCESS;
 }
@@ -2077,6 +2648,19 @@ void bridge_print_stats(bridge_ctx_t *ctx)
                 (unsigned long long)ctx->bytes_serial_to_telnet);
     MB_LOG_INFO("Telnet -> Serial: %llu bytes",
                 (unsigned long long)ctx->bytes_telnet_to_serial);
+    if (ctx->passthru.dir[PASSTHRU_TO_TELNET].engagements > 0 ||
+        ctx->passthru.dir[PASSTHRU_TO_SERIAL].engagements > 0) {
+        MB_LOG_INFO("Spliced in the kernel: %llu bytes serial -> telnet, %llu bytes telnet -> serial",
+                    (unsigned long long)ctx->passthru.dir[PASSTHRU_TO_TELNET].bytes,
+                    (unsigned long long)ctx->passthru.dir[PASSTHRU_TO_SERIAL].bytes);
+    }
+
+    uint64_t compressed, inflated;
+    if (telnet_get_compress_stats(&ctx->telnet, &compressed, &inflated) == SUCCESS && compressed > 0) {
+        MB_LOG_INFO("Telnet MCCP2: %llu compressed -> %llu bytes (%.1fx)",
+                    (unsigned long long)compressed, (unsigned long long)inflated,
+                    (double)inflated / (double)compressed);
+    }
 #else
     MB_LOG_INFO("Level 1 mode: Telnet statistics not available");
 #endif
@@ -2085,6 +2669,59 @@ void bridge_print_stats(bridge_ctx_t *ctx)
         time_t duration = time(NULL) - ctx->connection_start_time;
         MB_LOG_INFO("Connection duration: %ld seconds", (long)duration);
     }
+    bridge_log_line_utilization(ctx);
+
+    if (ctx->serial.rx_profile != NULL) {
+        MB_LOG_INFO("Serial receive: %s profile, %s, USB latency_timer %d ms, AT round trip %d us",
+                    ctx->serial.rx_profile->name,
+                    ctx->serial.low_latency ? "ASYNC_LOW_LATENCY" : "driver default latency",
+                    ctx->serial.latency_timer_ms, ctx->serial.probe_rtt_us);
+    }
+
+    if (ctx->metrics != NULL) {
+        for (int d = 0; d < METRICS_DIRECTION_COUNT; d++) {
+            metrics_direction_t *m = &ctx->metrics->dir[d];
+            MB_LOG_INFO("%s: queue latency p50 %llu us, p99 %llu us, max %llu us (%llu samples), %llu bytes dropped",
+                        d == METRICS_SERIAL_TO_TELNET ? "Serial -> Telnet" : "Telnet -> Serial",
+                        (unsigned long long)metrics_hist_percentile_us(&m->latency, 0.50),
+                        (unsigned long long)metrics_hist_percentile_us(&m->latency, 0.99),
+                        (unsigned long long)atomic_load(&m->latency.max_us),
+                        (unsigned long long)atomic_load(&m->latency.count),
+                        (unsigned long long)atomic_load(&m->drops));
+
+            /* Where the p99 goes: one p50/p99 pair per stage that saw chunks */
+            char stages[256];
+            size_t used = 0;
+            stages[0] = '\0';
+            for (int st = 0; st < METRICS_STAGE_COUNT && used < sizeof(stages); st++) {
+                const metrics_hist_t *h = &m->stage[st];
+                if (atomic_load(&h->count) == 0) {
+                    continue;
+                }
+                used += (size_t)snprintf(stages + used, sizeof(stages) - used, "%s%s %llu/%llu",
+                                         used > 0 ? ", " : "", metrics_stage_name((metrics_stage_id_t)st),
+                                         (unsigned long long)metrics_hist_percentile_us(h, 0.50),
+                                         (unsigned long long)metrics_hist_percentile_us(h, 0.99));
+            }
+            if (used > 0) {
+                MB_LOG_INFO("%s: stage latency p50/p99 us: %s",
+                            d == METRICS_SERIAL_TO_TELNET ? "Serial -> Telnet" : "Telnet -> Serial",
+                            stages);
+            }
+        }
+    }
+
+    static const char *const role_names[RTSCHED_ROLE_COUNT] = {
+        [RTSCHED_SERIAL] = "Serial", [RTSCHED_TELNET] = "Telnet", [RTSCHED_LEVEL3] = "Level 3"
+    };
+    for (int r = 0; r < RTSCHED_ROLE_COUNT; r++) {
+        if (ctx->thread_sched[r].valid) {
+            char placement[128];
+            rtsched_format(&ctx->thread_sched[r], placement, sizeof(placement));
+            MB_LOG_INFO("%s thread: %s", role_names[r], placement);
+        }
+    }
+    MB_LOG_INFO("Memory locked: %s", rtsched_memory_locked() ? "yes" : "no");
 
 #ifdef ENABLE_LEVEL3
     if (ctx->level3_enabled && ctx->level3 != NULL) {
@@ -2097,593 +2734,1495 @@ void bridge_print_stats(bridge_ctx_t *ctx)
 }
 
 
+#ifdef ENABLE_LEVEL2
+/* ========== Splice Passthrough (SPLICE_PASSTHROUGH) ========== */
+
+/**
+ * Check whether a direction may run in the kernel
+ * Only towards a raw TCP peer, and only while nothing in userspace needs to
+ * see the bytes: no Level 3 pipelines, data log, transcoding, echo or
+ * timestamps. The line must be online with carrier on DCD; entering also
+ * needs the userspace queues of the direction to be empty, so bytes keep
+ * their order. Towards the serial port the token-bucket pacer is bypassed,
+ * so a carrier slower than the DTE rate needs RTS/CTS flow control.
+ */
+static bool bridge_passthru_ready(bridge_ctx_t *ctx, passthru_dir_id_t id)
+{
+    passthru_t *pt = &ctx->passthru;
+    const config_t *cfg = ctx->config;
+
+    if (!pt->enabled || pt->dir[id].unsupported || !ctx->telnet.raw_tcp) {
+        return false;
+    }
+#ifdef ENABLE_LEVEL3
+    if (ctx->level3_enabled) {
+        return false;
+    }
+#endif
+    if (datalog_is_enabled(&ctx->datalog) || cfg->echo_enabled || ctx->timestamp.enabled ||
+        charset_conv_active(&ctx->charset_to_serial) || charset_conv_active(&ctx->charset_to_telnet)) {
+        return false;
+    }
+
+    if (!ctx->serial_ready || !telnet_is_connected(&ctx->telnet)) {
+        return false;
+    }
+    pthread_mutex_lock(&ctx->modem_mutex);
+    bool online = modem_is_online(&ctx->modem);
+    pthread_mutex_unlock(&ctx->modem_mutex);
+    if (!online) {
+        return false;
+    }
+
+    /* Carrier loss must reach the userspace path (NO CARRIER handling) */
+    int dcd = serial_get_dcd(&ctx->serial);
+    if (dcd < 0) {
+        MB_LOG_WARNING("Splice passthrough off: carrier (DCD) of %s cannot be read", cfg->serial_port);
+        pt->dir[id].unsupported = true;
+        return false;
+    }
+    if (dcd == 0) {
+        return false;
+    }
+
+    if (pt->dir[id].engaged) {
+        return true;
+    }
+    if (id == PASSTHRU_TO_TELNET) {
+        return ts_cbuf_is_empty(&ctx->ts_serial_to_telnet_buf);
+    }
+
+    bool unpaced = ctx->connected_baudrate <= 0 || ctx->connected_baudrate >= cfg->baudrate_value ||
+                   cfg->flow_control == FLOW_RTSCTS || cfg->flow_control == FLOW_BOTH;
+    return unpaced && ts_cbuf_is_empty(&ctx->ts_telnet_to_serial_buf) &&
+           serial_tx_pending(&ctx->serial) == 0;
+}
+
+/**
+ * Return a direction to userspace; bytes left in its pipe continue through
+ * the direction's ring
+ */
+static void bridge_passthru_release(bridge_ctx_t *ctx, passthru_dir_id_t id)
+{
+    unsigned char left[BUFFER_SIZE];
+
+    size_t n = passthru_release(&ctx->passthru, id, left, sizeof(left));
+    if (n > 0) {
+        ts_cbuf_write(id == PASSTHRU_TO_TELNET ? &ctx->ts_serial_to_telnet_buf
+                                               : &ctx->ts_telnet_to_serial_buf, left, n);
+    }
+}
+
+/**
+ * Count bytes a pipe delivered
+ */
+static void bridge_passthru_count(bridge_ctx_t *ctx, metrics_direction_id_t dir, size_t n)
+{
+    if (n > 0 && ctx->metrics != NULL) {
+        metrics_add(&ctx->metrics->dir[dir].bytes, n);
+        metrics_add(&ctx->metrics->dir[dir].chunks, 1);
+    }
+}
+
+#ifdef BRIDGE_HAS_SERIAL_POLL
+/**
+ * Serial -> telnet in the kernel
+ * @param idle Receives the suggested idle time when handled
+ * @return true if this pass was handled here, false for the userspace path
+ */
+static bool bridge_passthru_to_telnet(bridge_ctx_t *ctx, useconds_t *idle)
+{
+    passthru_t *pt = &ctx->passthru;
+    passthru_dir_t *dir = &pt->dir[PASSTHRU_TO_TELNET];
+
+    if (!bridge_passthru_ready(ctx, PASSTHRU_TO_TELNET) || !passthru_engage(pt, PASSTHRU_TO_TELNET)) {
+        bridge_passthru_release(ctx, PASSTHRU_TO_TELNET);
+        return false;
+    }
+
+    /* Wait for the terminal, unless earlier bytes still wait for the socket */
+    ssize_t taken = 0;
+    if (dir->pending == 0) {
+        struct pollfd pfd = { .fd = serial_get_fd(&ctx->serial), .events = POLLIN };
+        int ready = poll(&pfd, 1, ctx->poll_timeout_ms);
+        if (ready < 0 && errno != EINTR) {
+            bridge_passthru_release(ctx, PASSTHRU_TO_TELNET);
+            return false;
+        }
+        if (ready > 0 && pfd.revents != POLLIN) {
+            /* Error or hangup: let serial_read_timeout() report it */
+            bridge_passthru_release(ctx, PASSTHRU_TO_TELNET);
+            return false;
+        }
+        /* A carrier drop during the wait: NO CARRIER must go to the modem layer */
+        if (ready > 0 && serial_get_dcd(&ctx->serial) != 1) {
+            bridge_passthru_release(ctx, PASSTHRU_TO_TELNET);
+            return false;
+        }
+        if (ready > 0) {
+            taken = passthru_fill(pt, PASSTHRU_TO_TELNET, pfd.fd, BUFFER_SIZE);
+        }
+    }
+
+    if (taken >= 0 && dir->pending > 0) {
+        ssize_t sent = telnet_send_splice(&ctx->telnet, dir->pipe_fd[0], dir->pending);
+        if (sent > 0) {
+            passthru_drained(pt, PASSTHRU_TO_TELNET, (size_t)sent);
+            bridge_passthru_count(ctx, METRICS_SERIAL_TO_TELNET, (size_t)sent);
+        } else if (sent < 0) {
+            taken = sent;
+        }
+    }
+    if (taken < 0) {
+        bridge_passthru_release(ctx, PASSTHRU_TO_TELNET);
+        return false;
+    }
+
+    *idle = (dir->pending > 0) ? PASSTHRU_RETRY_MS * 1000 : 0;
+    return true;
+}
+#endif
+
+/**
+ * Telnet -> serial in the kernel
+ * The serial fd blocks, so a pass never takes more than the driver has
+ * room for; a full driver (CTS low) leaves data in the socket.
+ * @param idle Receives the suggested idle time when handled
+ * @return true if this pass was handled here, false for the userspace path
+ */
+static bool bridge_passthru_to_serial(bridge_ctx_t *ctx, useconds_t *idle)
+{
+    passthru_t *pt = &ctx->passthru;
+    passthru_dir_t *dir = &pt->dir[PASSTHRU_TO_SERIAL];
+    int serial_fd = serial_get_fd(&ctx->serial);
+
+    if (!bridge_passthru_ready(ctx, PASSTHRU_TO_SERIAL) || !passthru_engage(pt, PASSTHRU_TO_SERIAL)) {
+        bridge_passthru_release(ctx, PASSTHRU_TO_SERIAL);
+        return false;
+    }
+
+    /* Earlier bytes first */
+    uint64_t before = dir->bytes;
+    int ret = passthru_drain(pt, PASSTHRU_TO_SERIAL, serial_fd);
+
+    size_t room = MIN((size_t)BUFFER_SIZE, serial_tx_driver_room(&ctx->serial));
+    if (ret == SUCCESS && dir->pending == 0 && room > 0) {
+        /* Don't sleep on the socket while serial -> telnet data waits in the ring */
+        int timeout = ts_cbuf_is_empty(&ctx->ts_serial_to_telnet_buf) ? ctx->poll_timeout_ms : 0;
+        struct pollfd pfd = { .fd = ctx->telnet.fd, .events = POLLIN };
+        int ready = poll(&pfd, 1, timeout);
+        if (ready > 0) {
+            ssize_t taken = passthru_fill(pt, PASSTHRU_TO_SERIAL, pfd.fd, room);
+            if (taken > 0) {
+                telnet_update_activity(&ctx->telnet);
+                ret = passthru_drain(pt, PASSTHRU_TO_SERIAL, serial_fd);
+            } else if (taken < 0) {
+                /* End of stream or error: the userspace path closes the session */
+                ret = (int)taken;
+            }
+        } else if (ready < 0 && errno != EINTR) {
+            ret = ERROR_IO;
+        }
+    }
+    bridge_passthru_count(ctx, METRICS_TELNET_TO_SERIAL, (size_t)(dir->bytes - before));
+
+    if (ret != SUCCESS) {
+        bridge_passthru_release(ctx, PASSTHRU_TO_SERIAL);
+        return false;
+    }
+
+    *idle = (dir->pending > 0 || room == 0) ? PASSTHRU_RETRY_MS * 1000 : 0;
+    return true;
+}
+#endif
+
 /* ========== Multithread Mode: Thread Functions ========== */
 
 #if !defined(ENABLE_LEVEL2) || defined(ENABLE_LEVEL3)
 /**
- * Serial/Modem thread function - Level 1
- * Handles:
- * - Serial health check (at startup)
- * - Modem initialization verification
- * - Serial I/O (reading from serial port)
- * - Modem command processing (AT commands)
- * - Timestamp transmission every 3 seconds when modem is online
- *
- * In Level 3 mode, this runs alongside the telnet thread for dual-pipeline operation
+ * Run one serial/modem pass
+ * Shared by serial_modem_thread_func() and the multi-line worker pool.
  */
-void *serial_modem_thread_func(void *arg)
+useconds_t bridge_serial_poll(bridge_ctx_t *ctx)
 {
-    bridge_ctx_t *ctx = (bridge_ctx_t *)arg;
     unsigned char serial_buf[BUFFER_SIZE];
+
+    /* Goal 1: Serial health check (once at startup) */
+    if (!ctx->serial_health_checked && ctx->serial_ready) {
+        printf("[INFO] [Thread 1] === Performing serial health check ===\n");
+        fflush(stdout);
+        MB_LOG_INFO("[Thread 1] === Performing serial health check ===");
+
+        /* Verify serial port is readable/writable */
+        int serial_fd = serial_get_fd(&ctx->serial);
+        if (serial_fd >= 0) {
+            MB_LOG_INFO("[Thread 1] Serial port health check: OK (fd=%d)", serial_fd);
+        } else {
+            MB_LOG_WARNING("[Thread 1] Serial port health check: FAILED (invalid fd)");
+        }
+
+        /* Goal 2: Verify modem initialization */
+        if (ctx->modem_ready) {
+            MB_LOG_INFO("[Thread 1] Modem initialization: OK");
+            MB_LOG_INFO("[Thread 1] Modem echo=%d, verbose=%d, quiet=%d",
+                       ctx->modem.settings.echo,
+                       ctx->modem.settings.verbose,
+                       ctx->modem.settings.quiet);
+        } else {
+            MB_LOG_WARNING("[Thread 1] Modem initialization: NOT READY");
+        }
+
+        MB_LOG_INFO("[Thread 1] === Health check completed ===");
+        ctx->serial_health_checked = true;
+
+        /* IMPORTANT: Check if modem is already ONLINE after draining phase */
+        /* This can happen if CONNECT was received during initialization */
+        pthread_mutex_lock(&ctx->modem_mutex);
+        bool already_online = modem_is_online(&ctx->modem);
+        pthread_mutex_unlock(&ctx->modem_mutex);
+
+        if (already_online) {
+            printf("[INFO] [Thread 1] Modem is ALREADY ONLINE (CONNECT received during init)\n");
+            printf("[INFO] [Thread 1] Enabling timestamp transmission\n");
+            fflush(stdout);
+            MB_LOG_INFO("[Thread 1] Modem is ALREADY ONLINE (CONNECT received during init)");
+            MB_LOG_INFO("[Thread 1] Enabling timestamp transmission");
+
+            /* Start timestamp transmission */
+            timestamp_set_online(&ctx->timestamp);
+
+            /* Set flag to enable timestamp transmission */
+            ctx->client_data_received = true;
+
+            /* Update connection state */
+            pthread_mutex_lock(&ctx->state_mutex);
+            ctx->state = STATE_CONNECTED;
+            ctx->connection_start_time = time(NULL);
+            pthread_mutex_unlock(&ctx->state_mutex);
+        }
+    }
+
+    /* Check if serial port is ready */
+    if (!ctx->serial_ready) {
+        return 100000;  /* 100ms */
+    }
+
 #ifdef ENABLE_LEVEL2
-    unsigned char tx_buf[BUFFER_SIZE];
+    /* RING pre-connect without a CONNECT in time */
+    bridge_preconnect_expire(ctx, false);
 #endif
 
-    bool health_check_done = false;
+    /* Goal 4: Send timestamp using modular timestamp system when modem is ONLINE */
+    pthread_mutex_lock(&ctx->modem_mutex);
+    bool is_online = modem_is_online(&ctx->modem);
+    pthread_mutex_unlock(&ctx->modem_mutex);
+
+    if (is_online && ctx->client_data_received) {
+        /* Check if timestamp should be sent using modular system (never
+         * into a file transfer) */
+        if (timestamp_should_send(&ctx->timestamp) &&
+            !xfer_active(&ctx->xfer, bridge_monotonic_ms())) {
+            /* Send timestamp using modular function (epoll-based write) */
+            timestamp_result_t result = timestamp_send(&ctx->serial, &ctx->timestamp);
+            MB_TRACE(TRACE_TIMESTAMP_SEND, result, 0);
+
+            switch (result) {
+                case TIMESTAMP_SUCCESS:
+                    break;
+
+                case TIMESTAMP_TIMEOUT:
+                    printf("[WARNING] [Thread 1] Timestamp send timeout\n");
+                    fflush(stdout);
+                    MB_LOG_WARNING("[Thread 1] Timestamp send timeout");
+                    break;
 
-    printf("[INFO] [Thread 1] Serial/Modem thread started\n");
-    fflush(stdout);
-    MB_LOG_INFO("[Thread 1] Serial/Modem thread started");
+                case TIMESTAMP_ERROR:
+                    printf("[ERROR] [Thread 1] Timestamp send failed - forcing modem OFFLINE\n");
+                    fflush(stdout);
+                    MB_LOG_ERROR("[Thread 1] Timestamp send failed - forcing modem OFFLINE");
 
-    while (ctx->thread_running) {
-        /* Goal 1: Serial health check (once at startup) */
-        if (!health_check_done && ctx->serial_ready) {
-            printf("[INFO] [Thread 1] === Performing serial health check ===\n");
-            fflush(stdout);
-            MB_LOG_INFO("[Thread 1] === Performing serial health check ===");
+                    /* Force modem to OFFLINE state on write error */
+                    pthread_mutex_lock(&ctx->modem_mutex);
+                    modem_hangup(&ctx->modem);
+                    pthread_mutex_unlock(&ctx->modem_mutex);
 
-            /* Verify serial port is readable/writable */
-            int serial_fd = serial_get_fd(&ctx->serial);
-            if (serial_fd >= 0) {
-                MB_LOG_INFO("[Thread 1] Serial port health check: OK (fd=%d)", serial_fd);
-            } else {
-                MB_LOG_WARNING("[Thread 1] Serial port health check: FAILED (invalid fd)");
-            }
+                    /* Reset timestamp state */
+                    timestamp_set_offline(&ctx->timestamp);
+                    ctx->client_data_received = false;
 
-            /* Goal 2: Verify modem initialization */
-            if (ctx->modem_ready) {
-                MB_LOG_INFO("[Thread 1] Modem initialization: OK");
-                MB_LOG_INFO("[Thread 1] Modem echo=%d, verbose=%d, quiet=%d",
-                           ctx->modem.settings.echo,
-                           ctx->modem.settings.verbose,
-                           ctx->modem.settings.quiet);
-            } else {
-                MB_LOG_WARNING("[Thread 1] Modem initialization: NOT READY");
-            }
+                    /* === ECHO FUNCTIONALITY: Mark client as OFFLINE === */
+                    echo_set_offline(&ctx->echo);
+                    MB_LOG_INFO("[Thread 1] Echo functionality deactivated - client is OFFLINE");
+                    break;
 
-            MB_LOG_INFO("[Thread 1] === Health check completed ===");
-            health_check_done = true;
+                case TIMESTAMP_DISABLED:
+                    /* Should not happen if enabled, but handle gracefully */
+                    break;
 
-            /* IMPORTANT: Check if modem is already ONLINE after draining phase */
-            /* This can happen if CONNECT was received during initialization */
-            pthread_mutex_lock(&ctx->modem_mutex);
-            bool already_online = modem_is_online(&ctx->modem);
-            pthread_mutex_unlock(&ctx->modem_mutex);
+                case TIMESTAMP_NOT_DUE:
+                    /* Should not happen since we checked timestamp_should_send */
+                    break;
+            }
+        }
+    } else {
+        /* Reset timestamp state when modem goes offline */
+        if (!is_online && ctx->serial_was_online) {
+            printf("[INFO] [Thread 1] Modem went OFFLINE, resetting timestamp state\n");
+            fflush(stdout);
+            MB_LOG_INFO("[Thread 1] Modem went OFFLINE, resetting timestamp state");
+            timestamp_set_offline(&ctx->timestamp);
+            ctx->client_data_received = false;  /* Reset for next connection */
 
-            if (already_online) {
-                printf("[INFO] [Thread 1] Modem is ALREADY ONLINE (CONNECT received during init)\n");
-                printf("[INFO] [Thread 1] Enabling timestamp transmission\n");
-                fflush(stdout);
-                MB_LOG_INFO("[Thread 1] Modem is ALREADY ONLINE (CONNECT received during init)");
-                MB_LOG_INFO("[Thread 1] Enabling timestamp transmission");
+            /* === ECHO FUNCTIONALITY: Mark client as OFFLINE === */
+            echo_set_offline(&ctx->echo);
+            MB_LOG_INFO("[Thread 1] Echo functionality deactivated - client is OFFLINE");
+        }
+        ctx->serial_was_online = is_online;
+    }
 
-                /* Start timestamp transmission */
+    /* Goal 3: Wait for modem signals (AT commands, etc.) */
+
+#ifdef ENABLE_LEVEL2
+    /* Transparent line: serial -> telnet moves in the kernel */
+    useconds_t spliced_idle;
+    if (bridge_passthru_to_telnet(ctx, &spliced_idle)) {
+        return spliced_idle;
+    }
+#endif
+
+    /* === Part 1: Serial → Telnet direction === */
+
+    /* Read from serial port */
+    ssize_t n = serial_read_timeout(&ctx->serial, serial_buf,
+                                    serial_rx_read_size(&ctx->serial, sizeof(serial_buf)),
+                                    ctx->poll_timeout_ms);
+
+    if (n < 0) {
+        /* I/O error - handle disconnection */
+        MB_LOG_ERROR("[Thread 1] Serial I/O error: %s", strerror(errno));
+        serial_close(&ctx->serial);
+        ctx->serial_ready = false;
+        ctx->modem_ready = false;
+        return 100000;
+    }
+
+    if (n > 0) {
+        /* Raw bytes are traced as TRACE_SERIAL_RX in serial_read_timeout() */
+#ifdef ENABLE_LEVEL2
+        uint64_t ingress_ns = latency_now_ns();     /* Stamp carried to the telnet side */
+#endif
+
+        /* Log data */
+        datalog_write(&ctx->datalog, DATALOG_DIR_FROM_MODEM, serial_buf, n);
+
+        /* === CRITICAL: Check for hardware modem messages first === */
+        /* Hardware modems send unsolicited messages like RING, CONNECT, NO CARRIER */
+        pthread_mutex_lock(&ctx->modem_mutex);
+        bool hardware_msg_handled = modem_process_hardware_message(&ctx->modem, (char *)serial_buf, n);
+        modem_state_t current_state = modem_get_state(&ctx->modem);
+
+        /* === ADDITIONAL RING DETECTION FOR STDOUT === */
+        /* Check if RING was in the received data for explicit stdout logging */
+        if (strstr((char *)serial_buf, "RING") != NULL) {
+            printf("[INFO] [Thread 1] *** RING SIGNAL DETECTED FROM HARDWARE MODEM ***\n");
+            fflush(stdout);
+            MB_LOG_INFO("[Thread 1] *** RING SIGNAL DETECTED FROM HARDWARE MODEM ***");
+
+            /* Get ring count for additional logging */
+            int ring_count = ctx->modem.settings.s_registers[SREG_RING_COUNT];
+            int auto_answer = ctx->modem.settings.s_registers[SREG_AUTO_ANSWER];
+            printf("[INFO] [Thread 1] Ring count: %d, Auto-answer setting (S0): %d\n",
+                   ring_count, auto_answer);
+            fflush(stdout);
+        }
+
+        pthread_mutex_unlock(&ctx->modem_mutex);
+
+#ifdef ENABLE_LEVEL2
+        if (memmem(serial_buf, n, "RING", 4) != NULL) {
+            bridge_preconnect_on_ring(ctx);
+        }
+#endif
+
+        /* Handle state transitions from hardware messages */
+        if (current_state == MODEM_STATE_CONNECTING) {
+            /* Modem is connecting (answered call, waiting for CONNECT) */
+            /* Check if this is software or hardware auto-answer mode */
+            int auto_answer = ctx->modem.settings.s_registers[SREG_AUTO_ANSWER];
+            if (auto_answer == 0) {
+                /* Software auto-answer mode (S0=0) */
+                printf("[INFO] [Thread 1] Modem state: CONNECTING - waiting for CONNECT response (software auto-answer mode)\n");
+                fflush(stdout);
+                MB_LOG_INFO("[Thread 1] Modem state: CONNECTING - waiting for CONNECT response (software auto-answer mode)");
+            } else {
+                /* Hardware auto-answer mode (S0 > 0) */
+                printf("[INFO] [Thread 1] Modem state: CONNECTING - waiting for CONNECT response (hardware auto-answer mode, S0=%d)\n", auto_answer);
+                fflush(stdout);
+                MB_LOG_INFO("[Thread 1] Modem state: CONNECTING - waiting for CONNECT response (hardware auto-answer mode, S0=%d)", auto_answer);
+            }
+            return 0;
+        } else if (current_state == MODEM_STATE_ONLINE && hardware_msg_handled) {
+            /* === ONLINE state transition: CONNECT message just received === */
+            /* This block runs ONCE when CONNECT is received, not for every data byte */
+            printf("[INFO] [Thread 1] Hardware modem ONLINE (CONNECT received)\n");
+            fflush(stdout);
+            MB_LOG_INFO("[Thread 1] Hardware modem ONLINE (CONNECT received)");
+
+            /* Mark that client connection is established (ONLY after CONNECT) */
+            if (!ctx->client_data_received) {
+                ctx->client_data_received = true;
+                printf("[INFO] [Thread 1] Client connected (CONNECT received) - timestamp transmission enabled\n");
+                fflush(stdout);
+                MB_LOG_INFO("[Thread 1] Client connected (CONNECT received) - timestamp transmission enabled");
+
+                /* IMPORTANT: Start timestamp transmission when modem goes ONLINE */
+                printf("[DEBUG] [Thread 1] Calling timestamp_set_online() to start timestamp tracking\n");
+                fflush(stdout);
                 timestamp_set_online(&ctx->timestamp);
+                MB_LOG_INFO("[Thread 1] Timestamp tracking started - first timestamp in 3 seconds");
+
+                /* === ECHO FUNCTIONALITY: Mark client as ONLINE for echo === */
+                printf("[DEBUG] [Thread 1] Checking echo configuration: echo_enabled=%d\n", ctx->config->echo_enabled);
+                fflush(stdout);
+                MB_LOG_DEBUG("[Thread 1] Echo configuration: echo_enabled=%d", ctx->config->echo_enabled);
+
+                if (ctx->config->echo_enabled) {
+                    printf("[DEBUG] [Thread 1] Activating echo functionality for ONLINE client\n");
+                    fflush(stdout);
+                    echo_set_online(&ctx->echo);
+                    MB_LOG_INFO("[Thread 1] Echo functionality activated - client is ONLINE");
+                } else {
+                    printf("[DEBUG] [Thread 1] Echo functionality disabled - not activating\n");
+                    fflush(stdout);
+                    MB_LOG_DEBUG("[Thread 1] Echo functionality disabled - not activating");
+                }
+            }
+
+#ifdef ENABLE_LEVEL2
+            /* A telnet session opened on RING now carries the call */
+            bridge_preconnect_claim(ctx);
+#endif
+
+            /* Update state to indicate connection is active */
+            pthread_mutex_lock(&ctx->state_mutex);
+            ctx->state = STATE_CONNECTED;
+            ctx->connection_start_time = time(NULL);
+            pthread_mutex_unlock(&ctx->state_mutex);
+
+            /* Note: This block runs only once when CONNECT message is received */
+            /* Normal data processing happens in the else block below (line 2304+) */
+            return 0;
+        } else if (current_state == MODEM_STATE_DISCONNECTED) {
+            printf("[INFO] [Thread 1] Modem DISCONNECTED\n");
+            fflush(stdout);
+            MB_LOG_INFO("[Thread 1] Modem DISCONNECTED");
+            pthread_mutex_lock(&ctx->state_mutex);
+#ifdef ENABLE_LEVEL2
+            bridge_preconnect_expire(ctx, true);
+            if (telnet_is_connected(&ctx->telnet)) {
+                MB_LOG_INFO("[Thread 1] Closing telnet due to modem disconnect");
+                telnet_disconnect(&ctx->telnet);
+            }
+#endif
+            ctx->state = STATE_IDLE;
+            pthread_mutex_unlock(&ctx->state_mutex);
+            return 0;
+        }
+
+        /* Process through modem layer */
+        pthread_mutex_lock(&ctx->modem_mutex);
+        bool modem_online = modem_is_online(&ctx->modem);
+
+        if (!modem_online) {
+            /* COMMAND mode: process AT commands ONLY if not a hardware message */
+            if (!hardware_msg_handled) {
+                modem_process_input(&ctx->modem, (char *)serial_buf, n);
+            }
+            pthread_mutex_unlock(&ctx->modem_mutex);
+            bridge_dial_pending(ctx);
+        } else {
+            /* ONLINE mode: Process escape sequences */
+            ssize_t consumed = modem_process_input(&ctx->modem, (char *)serial_buf, n);
+            pthread_mutex_unlock(&ctx->modem_mutex);
+
+            if (consumed > 0) {
+#ifdef ENABLE_LEVEL2
+                /* Transfer start/end markers (the consumer decides raw vs filtered) */
+                xfer_scan(&ctx->xfer, XFER_FROM_MODEM, serial_buf, (size_t)consumed,
+                          bridge_monotonic_ms());
+#endif
+
+#ifdef ENABLE_LEVEL3
+                /* === LEVEL 3 MODE: Forward data to pipeline === */
+                if (ctx->level3_enabled && ctx->level3 != NULL) {
+                    l3_context_t *l3_ctx = (l3_context_t*)ctx->level3;
+
+                    if (l3_data_transfer_active(l3_ctx)) {
+                        /* Level 3 active: Write data to pipeline buffer */
+                        size_t written = ts_cbuf_write_stamped(&ctx->ts_serial_to_telnet_buf,
+                                                               serial_buf, consumed, ingress_ns);
+                        MB_TRACE(TRACE_L3_FORWARD, written, 0);
+                        if ((size_t)consumed > written) {
+                            MB_TRACE(TRACE_BRIDGE_DROP, DATALOG_DIR_FROM_MODEM, (size_t)consumed - written);
+                            if (ctx->metrics != NULL) {
+                                metrics_count_drop(&ctx->metrics->dir[METRICS_SERIAL_TO_TELNET], (size_t)consumed - written);
+                            }
+                        }
+                        if (written == 0) {
+                            MB_LOG_WARNING("[Thread 1] Level 3: Buffer full, dropped %zd bytes", consumed);
+                        }
+                        return 0;  /* Skip Level 1 echo processing */
+                    }
+                    MB_TRACE(TRACE_L3_INACTIVE, atomic_load(&l3_ctx->level3_active), l3_get_system_state(l3_ctx));
+                }
+#endif
+
+#ifdef ENABLE_LEVEL2
+                /* === LEVEL 2 MODE: Forward data to telnet thread via buffer === */
+                size_t written = ts_cbuf_write_stamped(&ctx->ts_serial_to_telnet_buf,
+                                                       serial_buf, consumed, ingress_ns);
+                MB_TRACE(TRACE_BRIDGE_FORWARD, DATALOG_DIR_FROM_MODEM, written);
+                if ((size_t)consumed > written) {
+                    MB_TRACE(TRACE_BRIDGE_DROP, DATALOG_DIR_FROM_MODEM, (size_t)consumed - written);
+                    if (ctx->metrics != NULL) {
+                        metrics_count_drop(&ctx->metrics->dir[METRICS_SERIAL_TO_TELNET], (size_t)consumed - written);
+                    }
+                }
+                if (written == 0) {
+                    MB_LOG_WARNING("[Thread 1] Level 2: Buffer full, dropped %zd bytes", consumed);
+                }
+                return 0;  /* Skip Level 1 echo processing */
+#endif
+
+                /* === LEVEL 1: Data is handled directly between modem and client === */
+                /* No telnet forwarding needed - client data stays local */
+                MB_TRACE(TRACE_MODEM_ONLINE_DATA, consumed, 1);
+
+                /* === ECHO FUNCTIONALITY (Level 1) === */
+                /* Process client data for echo with timestamp formatting */
+                if (ctx->config->echo_enabled) {
+                    echo_result_t echo_result = echo_process_client_data(&ctx->echo, &ctx->serial,
+                                                                      serial_buf, consumed);
+                    switch (echo_result) {
+                        case ECHO_SUCCESS:
+                            MB_LOG_DEBUG("[Thread 1] Echo processed successfully");
+                            break;
+                        case ECHO_DISABLED:
+                            MB_LOG_DEBUG("[Thread 1] Echo functionality disabled");
+                            break;
+                        case ECHO_ERROR:
+                            MB_LOG_WARNING("[Thread 1] Echo processing failed");
+                            break;
+                        case ECHO_INVALID_PARAM:
+                            MB_LOG_WARNING("[Thread 1] Echo processing: invalid parameters");
+                            break;
+                        case ECHO_BUFFER_FULL:
+                            MB_LOG_WARNING("[Thread 1] Echo buffer full");
+                            break;
+                    }
+                }
+            }
+        }
+    }
+
+    /* === Part 2: Telnet → Serial direction === */
+#ifdef ENABLE_LEVEL2
+
+    /* Check if Level 3 is handling this direction */
+    bool level3_handles_telnet_to_serial = false;
+#ifdef ENABLE_LEVEL3
+    if (ctx->level3_enabled && ctx->level3 != NULL) {
+        l3_context_t *l3_ctx = (l3_context_t*)ctx->level3;
+        if (l3_data_transfer_active(l3_ctx)) {
+            /* Level 3 pipeline is handling data transfer - skip buffer reading */
+            level3_handles_telnet_to_serial = true;
+        }
+    }
+#endif
+
+    /* Level 2 mode: Read from telnet→serial buffer and write to serial (if Level 3 not active) */
+    if (!level3_handles_telnet_to_serial) {
+        /* Write straight from ring memory (zero-copy) */
+        size_t tx_len;
+        latency_stamp_t stamp;
+        const unsigned char *tx_data = ts_cbuf_peek(&ctx->ts_telnet_to_serial_buf, &tx_len);
+        ts_cbuf_stamp(&ctx->ts_telnet_to_serial_buf, &stamp);
+        size_t done = 0;
+        tx_len = MIN(tx_len, serial_tx_space(&ctx->serial));  /* Paced line: keep the rest in the ring */
+        if (tx_len > 0) {
+            /* Log data */
+            datalog_write(&ctx->datalog, DATALOG_DIR_TO_MODEM, tx_data, tx_len);
+
+            /* Write to serial port; whatever the TX queue cannot take stays
+             * in the ring (backpressure), a failed write drops the span */
+            ssize_t sent = serial_write_stamped(&ctx->serial, tx_data, tx_len, &stamp);
+            if (sent > 0) {
+                ctx->bytes_telnet_to_serial += sent;
+                done = (size_t)sent;
+            } else if (sent < 0) {
+                done = tx_len;
+            }
+        }
+        ts_cbuf_consume(&ctx->ts_telnet_to_serial_buf, done);
+    }
+#else
+    /* Level 1: No telnet to serial transfer needed */
+#endif
+
+    /* Queued serial TX: the next pass waits in serial_read_timeout() until the
+     * driver FIFO needs a refill instead of sleeping */
+    if (ctx->poll_timeout_ms > 0 && serial_tx_pending(&ctx->serial) > 0) {
+        return 0;
+    }
+
+    /* Sleep longer to reduce CPU usage and prevent timestamp flooding */
+    /* Check every 100ms instead of 10ms - still responsive but less busy */
+    return 100000;  /* 100ms - balanced between responsiveness and CPU usage */
+}
+
+/**
+ * Serial/Modem thread function - Level 1
+ * Handles:
+ * - Serial health check (at startup)
+ * - Modem initialization verification
+ * - Serial I/O (reading from serial port)
+ * - Modem command processing (AT commands)
+ * - Timestamp transmission every 3 seconds when modem is online
+ *
+ * In Level 3 mode, this runs alongside the telnet thread for dual-pipeline operation
+ */
+void *serial_modem_thread_func(void *arg)
+{
+    bridge_ctx_t *ctx = (bridge_ctx_t *)arg;
+
+    printf("[INFO] [Thread 1] Serial/Modem thread started\n");
+    fflush(stdout);
+    MB_LOG_INFO("[Thread 1] Serial/Modem thread started");
+
+    while (ctx->thread_running) {
+        useconds_t idle = bridge_serial_poll(ctx);
+        if (idle > 0) {
+            usleep(idle);
+        }
+    }
+
+    MB_LOG_INFO("[Thread 1] Serial/Modem thread exiting");
+    return NULL;
+}
+#endif
+
+#ifdef ENABLE_LEVEL2
+/**
+ * Epoll events wanted on the telnet socket
+ * EPOLLOUT only while a non-blocking connect is in flight or queued output
+ * waits for socket space; no EPOLLIN while
+ * a RING pre-connect holds server data back (it would fire continuously).
+ * While the name resolves the fd is the resolver's eventfd, which is
+ * always writable: only its EPOLLIN matters.
+ */
+uint32_t bridge_telnet_events(bridge_ctx_t *ctx)
+{
+    if (ctx->telnet.is_resolving) {
+        return EPOLLIN;
+    }
+    if (ctx->telnet.is_connecting) {
+        return EPOLLIN | EPOLLOUT;
+    }
+    if (atomic_load(&ctx->preconnect_hold)) {
+        return 0;
+    }
+    if (telnet_write_blocked(&ctx->telnet)) {
+        return EPOLLIN | EPOLLOUT;
+    }
+    return EPOLLIN;
+}
+
+/**
+ * Run one telnet pass
+ * Shared by telnet_thread_func() and the multi-line worker pool.
+ */
+/**
+ * Send terminal data to the telnet server in SERVER_CHARSET
+ * Takes no more input than the output queue holds once converted.
+ * @return Input bytes taken (the rest stays in the ring), -1 on send error
+ */
+static ssize_t bridge_send_transcoded(bridge_ctx_t *ctx, const unsigned char *data, size_t len,
+                                      const latency_stamp_t *stamp)
+{
+    unsigned char out[BUFFER_SIZE];
+    size_t room = MIN(sizeof(out), telnet_send_space(&ctx->telnet));
+    size_t take = MIN(len, charset_conv_fit(&ctx->charset_to_telnet, room));
+
+    if (take == 0) {
+        return 0;
+    }
+
+    size_t out_len = charset_convert(&ctx->charset_to_telnet, data, take, out, sizeof(out));
+    if (out_len > 0) {
+        ssize_t sent = telnet_send_stamped(&ctx->telnet, out, out_len, stamp);
+        if (sent < 0) {
+            return -1;
+        }
+        datalog_write(&ctx->datalog, DATALOG_DIR_TO_TELNET, out, (size_t)sent);
+        if ((size_t)sent < out_len) {
+            MB_LOG_WARNING("[Thread 2] Telnet output queue full, dropped %zu transcoded bytes",
+                          out_len - (size_t)sent);
+        }
+    }
+
+    return (ssize_t)take;
+}
+
+/**
+ * Send terminal data to the telnet server in raw mode (file transfers)
+ */
+ssize_t bridge_send_raw(bridge_ctx_t *ctx, const unsigned char *data, size_t len,
+                        const latency_stamp_t *stamp)
+{
+    unsigned char escaped[BUFFER_SIZE];
+    const unsigned char *out = escaped;
+    size_t room = MIN(sizeof(escaped), telnet_send_space(&ctx->telnet));
+    size_t out_len;
+    size_t take;
+
+    if (ctx->telnet.raw_tcp) {
+        /* Plain TCP peer: nothing to escape */
+        out = data;
+        out_len = take = MIN(len, room);
+    } else {
+        take = telnet_escape_iac(data, len, escaped, room, &out_len);
+    }
+
+    if (out_len == 0) {
+        return 0;
+    }
+
+    ssize_t sent = telnet_send_stamped(&ctx->telnet, out, out_len, stamp);
+    if (sent < 0) {
+        return -1;
+    }
+    datalog_write(&ctx->datalog, DATALOG_DIR_TO_TELNET, out, (size_t)sent);
+    if ((size_t)sent < out_len) {
+        MB_LOG_WARNING("[Thread 2] Telnet output queue full, dropped %zu raw bytes",
+                      out_len - (size_t)sent);
+    }
+
+    return (ssize_t)take;
+}
+
+/**
+ * Serial -> telnet: send what the serial side queued in the ring
+ * @return true if the data went out in raw mode (file transfer)
+ */
+static bool bridge_telnet_send_ring(bridge_ctx_t *ctx, long long now_ms)
+{
+#ifdef ENABLE_LEVEL3
+    /* If Level 3 is enabled at all, it handles the buffers */
+    if (ctx->level3_enabled) {
+        return false;
+    }
+#endif
+
+    /* Level 2 mode: send straight from ring memory (zero-copy) */
+    bool raw = false;
+    size_t tx_len;
+    latency_stamp_t stamp;
+    const unsigned char *tx_data = ts_cbuf_peek(&ctx->ts_serial_to_telnet_buf, &tx_len);
+    ts_cbuf_stamp(&ctx->ts_serial_to_telnet_buf, &stamp);
+    if (tx_len > 0 && xfer_active(&ctx->xfer, now_ms)) {
+        /* File transfer: IAC escaping only */
+        ssize_t taken = bridge_send_raw(ctx, tx_data, tx_len, &stamp);
+        ts_cbuf_consume(&ctx->ts_serial_to_telnet_buf, taken < 0 ? tx_len : (size_t)taken);
+        raw = true;
+    } else if (tx_len > 0 && charset_conv_active(&ctx->charset_to_telnet)) {
+        ssize_t taken = bridge_send_transcoded(ctx, tx_data, tx_len, &stamp);
+        ts_cbuf_consume(&ctx->ts_serial_to_telnet_buf, taken < 0 ? tx_len : (size_t)taken);
+    } else if (tx_len > 0) {
+        /* Queue for the telnet server; what does not fit stays in the ring */
+        ssize_t sent = telnet_send_stamped(&ctx->telnet, tx_data, tx_len, &stamp);
+        if (sent > 0) {
+            datalog_write(&ctx->datalog, DATALOG_DIR_TO_TELNET, tx_data, (size_t)sent);
+            ts_cbuf_consume(&ctx->ts_serial_to_telnet_buf, (size_t)sent);
+        } else if (sent < 0) {
+            ts_cbuf_consume(&ctx->ts_serial_to_telnet_buf, tx_len);
+        }
+    }
+
+    return raw;
+}
+
+useconds_t bridge_telnet_poll(bridge_ctx_t *ctx)
+{
+    /* Pre-connected on RING: server data (banner) waits in the socket until
+     * CONNECT; only notice the server closing while we wait */
+    if (atomic_load(&ctx->preconnect_hold) && telnet_is_connected(&ctx->telnet)) {
+        unsigned char probe;
+        ssize_t r = recv(ctx->telnet.fd, &probe, 1, MSG_PEEK | MSG_DONTWAIT);
+        if (r > 0 || (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))) {
+            return 100000;  /* 100ms */
+        }
+        /* Closed early: fall through to the normal disconnect handling */
+        MB_LOG_INFO("[Thread 2] Telnet server closed the pre-connected session");
+        atomic_store(&ctx->preconnect_hold, false);
+    }
+
+    /* Check if telnet is connected or connecting */
+    if (!telnet_is_connected(&ctx->telnet)) {
+        /* No session: nothing left half-converted for the next one */
+        charset_conv_reset(&ctx->charset_to_serial);
+        charset_conv_reset(&ctx->charset_to_telnet);
+        xfer_reset(&ctx->xfer);
+
+        /* Level 3 mode: Connection controlled by state machine, not by this thread */
+        /* But we need to process events for non-blocking connect completion */
+        if (ctx->telnet.is_connecting) {
+            /* Process epoll events to complete non-blocking connection */
+            int result = telnet_process_events(&ctx->telnet, ctx->poll_timeout_ms);
+            if (result != SUCCESS) {
+                MB_LOG_ERROR("[Thread 2] Failed to process connection events: %d", result);
+                telnet_disconnect(&ctx->telnet);
+
+                /* Every server (or backend) failed: end the call */
+                pthread_mutex_lock(&ctx->modem_mutex);
+                if (modem_is_online(&ctx->modem)) {
+                    modem_hangup(&ctx->modem);
+                    modem_send_no_carrier(&ctx->modem);
+                }
+                pthread_mutex_unlock(&ctx->modem_mutex);
+
+                pthread_mutex_lock(&ctx->state_mutex);
+                ctx->state = STATE_IDLE;
+                pthread_mutex_unlock(&ctx->state_mutex);
+            }
+            /* Check if connection completed */
+            if (telnet_is_connected(&ctx->telnet)) {
+                MB_LOG_INFO("[Thread 2] Telnet connection completed");
+            }
+        }
+        return 100000;  /* 100ms */
+    }
+
+    /* Transparent line: telnet -> serial moves in the kernel; only the ring
+     * (bytes queued before serial -> telnet went to the kernel) is left */
+    useconds_t spliced_idle;
+    if (bridge_passthru_to_serial(ctx, &spliced_idle)) {
+        bridge_telnet_send_ring(ctx, bridge_monotonic_ms());
+        telnet_flush_writes(&ctx->telnet);
+        return spliced_idle;
+    }
+
+    /* === Part 1: Telnet → Serial direction === */
+
+    /* Receive straight into telnet→serial ring memory and filter in place.
+     * A full ring leaves data in the socket (TCP backpressure) instead of
+     * dropping it. With transcoding, the filters run in a local buffer and
+     * the converter writes into the ring, taking no more input than the
+     * reservation holds once converted. During a file transfer (raw mode)
+     * only the telnet decoding runs. */
+    long long now_ms = bridge_monotonic_ms();
+    xfer_set_binary(&ctx->xfer, ctx->telnet.binary_local && ctx->telnet.binary_remote);
+    bool raw = xfer_active(&ctx->xfer, now_ms);
+
+    size_t granted;
+    unsigned char *telnet_buf = ts_cbuf_reserve(&ctx->ts_telnet_to_serial_buf,
+                                                BUFFER_SIZE, &granted);
+    unsigned char transcode_buf[BUFFER_SIZE];
+    bool transcode = charset_conv_active(&ctx->charset_to_serial) && !raw;
+    unsigned char *recv_buf = telnet_buf;
+    size_t recv_size = granted;
+    if (transcode) {
+        recv_buf = transcode_buf;
+        recv_size = MIN(sizeof(transcode_buf), charset_conv_fit(&ctx->charset_to_serial, granted));
+    }
+
+    ssize_t n = 0;
+    size_t output_len = 0;
+    uint64_t ingress_ns = 0;
+    if (recv_size > 0) {
+        n = telnet_recv(&ctx->telnet, recv_buf, recv_size);
+        if (n > 0) {
+            ingress_ns = latency_now_ns();
+        }
+    }
+
+    if (n > 0) {
+        /* Log data from telnet */
+        datalog_write(&ctx->datalog, DATALOG_DIR_FROM_TELNET, recv_buf, n);
+
+        /* Process telnet protocol (remove IAC) */
+        size_t processed_len;
+        telnet_process_input(&ctx->telnet, recv_buf, n,
+                            recv_buf, recv_size, &processed_len);
+
+        if (xfer_scan(&ctx->xfer, XFER_FROM_TELNET, recv_buf, processed_len, now_ms)) {
+            /* File transfer: the decoded bytes go to the terminal as they are */
+            raw = true;
+            output_len = processed_len;
+            if (transcode) {
+                memcpy(telnet_buf, recv_buf, output_len);
+            }
+        } else if (processed_len > 0) {
+            /* Pass through ANSI sequences to modem client */
+            ansi_passthrough_telnet_to_modem(recv_buf, processed_len,
+                                            recv_buf, recv_size, &output_len);
+        }
+
+        if (transcode && !raw && output_len > 0) {
+            /* SERVER_CHARSET to TERMINAL_CHARSET */
+            output_len = charset_convert(&ctx->charset_to_serial, recv_buf, output_len,
+                                         telnet_buf, granted);
+        }
+    }
+
+    /* Publish filtered bytes to the serial side (always ends the reservation) */
+    ts_cbuf_commit_stamped(&ctx->ts_telnet_to_serial_buf, output_len, ingress_ns);
+
+    if (n < 0) {
+        /* I/O error */
+        MB_LOG_ERROR("[Thread 2] Telnet connection error");
+        telnet_disconnect(&ctx->telnet);
+
+        /* Notify serial thread to hang up modem */
+        pthread_mutex_lock(&ctx->modem_mutex);
+        if (modem_is_online(&ctx->modem)) {
+            modem_hangup(&ctx->modem);
+            modem_send_no_carrier(&ctx->modem);
+        }
+        pthread_mutex_unlock(&ctx->modem_mutex);
+
+        pthread_mutex_lock(&ctx->state_mutex);
+        ctx->state = STATE_IDLE;
+        pthread_mutex_unlock(&ctx->state_mutex);
+
+        return 0;
+    }
+
+    if (n == 0 && recv_size > 0) {
+        /* Check if connection closed */
+        if (!telnet_is_connected(&ctx->telnet)) {
+            MB_LOG_INFO("[Thread 2] Telnet disconnected");
+            telnet_disconnect(&ctx->telnet);
+
+            pthread_mutex_lock(&ctx->modem_mutex);
+            if (modem_is_online(&ctx->modem)) {
+                modem_hangup(&ctx->modem);
+                modem_send_no_carrier(&ctx->modem);
+            }
+            pthread_mutex_unlock(&ctx->modem_mutex);
+
+            pthread_mutex_lock(&ctx->state_mutex);
+            ctx->state = STATE_IDLE;
+            pthread_mutex_unlock(&ctx->state_mutex);
+            return 1000;
+        }
+        /* Still connected: no telnet input, but serial data may be waiting */
+    }
+
+    /* === Part 2: Serial → Telnet direction === */
+    if (bridge_telnet_send_ring(ctx, now_ms)) {
+        raw = true;
+    }
+
+    /* Send coalesced output whose cork window has expired */
+    telnet_flush_writes(&ctx->telnet);
+
+    /* Short sleep to avoid busy-waiting */
+    if (n == 0) {
+        return 1000;   /* 1ms - idle telnet side */
+    }
+    if (raw) {
+        return 0;      /* File transfer: keep the line at full rate */
+    }
+    return 10000;  /* 10ms - reduced frequency to avoid excessive polling */
+}
+
+/**
+ * Telnet thread function - Level 2 only
+ * Handles:
+ * - Telnet I/O (reading from telnet server)
+ * - IAC protocol processing
+ * - Telnet → Serial data buffering
+ * - Serial → Telnet data transmission
+ */
+void *telnet_thread_func(void *arg)
+{
+    bridge_ctx_t *ctx = (bridge_ctx_t *)arg;
+
+    MB_LOG_INFO("[Thread 2] Telnet thread started");
+
+    while (ctx->thread_running) {
+        useconds_t idle = bridge_telnet_poll(ctx);
+        if (idle > 0) {
+            usleep(idle);
+        }
+    }
+
+    MB_LOG_INFO("[Thread 2] Telnet thread exiting");
+    return NULL;
+}
+#endif
+
+/* ========== Event-driven Mode ========== */
+
+/**
+ * Monotonic clock in milliseconds (timer_fd deadlines)
+ */
+static long long bridge_monotonic_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ * Wake the event-driven thread
+ */
+void bridge_wake(bridge_ctx_t *ctx)
+{
+    if (ctx == NULL || ctx->wake_fd < 0) {
+        return;
+    }
+
+    uint64_t one = 1;
+    ssize_t ret = write(ctx->wake_fd, &one, sizeof(one));
+    (void)ret;  /* EAGAIN means a wakeup is already pending */
+}
+
+/**
+ * Check whether queued data is waiting for the other direction
+ */
+bool bridge_has_pending_data(bridge_ctx_t *ctx)
+{
+#ifdef ENABLE_LEVEL2
+    /* Compressed server data already read from the socket (it will not wake us) */
+    if (telnet_recv_pending(&ctx->telnet)) {
+        return true;
+    }
+
+#ifdef ENABLE_LEVEL3
+    /* Level 3 drains the buffers from its own pipeline thread */
+    if (ctx->level3_enabled) {
+        return false;
+    }
+#endif
+
+#ifdef BRIDGE_HAS_SERIAL_POLL
+    if (ctx->serial_ready && !ts_cbuf_is_empty(&ctx->ts_telnet_to_serial_buf) &&
+        serial_tx_space(&ctx->serial) > 0) {
+        return true;
+    }
+#endif
+
+    if (telnet_is_connected(&ctx->telnet) && !ts_cbuf_is_empty(&ctx->ts_serial_to_telnet_buf)) {
+        return true;
+    }
+#else
+    (void)ctx;
+#endif
+
+    return false;
+}
+
+/**
+ * Point one epoll registration at the descriptor currently in use
+ * A closed descriptor leaves the epoll set on its own, so a reused number
+ * is detected by MOD failing with ENOENT and registered again.
+ */
+static void bridge_event_register(bridge_ctx_t *ctx, int *registered, int current,
+                                  uint32_t events, bool force)
+{
+    struct epoll_event ev;
+
+    if (*registered == current && !force) {
+        return;
+    }
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events = events;
+    ev.data.fd = current;
 
-                /* Set flag to enable timestamp transmission */
-                ctx->client_data_received = true;
+    if (*registered >= 0 && *registered != current) {
+        epoll_ctl(ctx->event_epoll_fd, EPOLL_CTL_DEL, *registered, NULL);
+        *registered = -1;
+    }
 
-                /* Update connection state */
-                pthread_mutex_lock(&ctx->state_mutex);
-                ctx->state = STATE_CONNECTED;
-                ctx->connection_start_time = time(NULL);
-                pthread_mutex_unlock(&ctx->state_mutex);
-            }
-        }
+    if (current < 0) {
+        return;
+    }
 
-        /* Check if serial port is ready */
-        if (!ctx->serial_ready) {
-            usleep(100000);  /* 100ms */
-            continue;
-        }
+    if (*registered == current &&
+        epoll_ctl(ctx->event_epoll_fd, EPOLL_CTL_MOD, current, &ev) == 0) {
+        return;
+    }
 
-        /* Goal 4: Send timestamp using modular timestamp system when modem is ONLINE */
-        pthread_mutex_lock(&ctx->modem_mutex);
-        bool is_online = modem_is_online(&ctx->modem);
-        pthread_mutex_unlock(&ctx->modem_mutex);
+    if (epoll_ctl(ctx->event_epoll_fd, EPOLL_CTL_ADD, current, &ev) == 0 || errno == EEXIST) {
+        *registered = current;
+    } else {
+        MB_LOG_WARNING("[Event] Failed to register fd %d: %s", current, strerror(errno));
+        *registered = -1;
+    }
+}
 
-        if (is_online && ctx->client_data_received) {
-            /* Check if timestamp should be sent using modular system */
-            if (timestamp_should_send(&ctx->timestamp)) {
-                printf("[INFO] [Thread 1] Sending timestamp via modular system\n");
-                fflush(stdout);
-                MB_LOG_INFO("[Thread 1] Sending timestamp via modular system");
-
-                /* Send timestamp using modular function (epoll-based write) */
-                timestamp_result_t result = timestamp_send(&ctx->serial, &ctx->timestamp);
-
-                switch (result) {
-                    case TIMESTAMP_SUCCESS:
-                        printf("[INFO] [Thread 1] Timestamp sent successfully via modular system\n");
-                        fflush(stdout);
-                        break;
-
-                    case TIMESTAMP_TIMEOUT:
-                        printf("[WARNING] [Thread 1] Timestamp send timeout\n");
-                        fflush(stdout);
-                        MB_LOG_WARNING("[Thread 1] Timestamp send timeout");
-                        break;
-
-                    case TIMESTAMP_ERROR:
-                        printf("[ERROR] [Thread 1] Timestamp send failed - forcing modem OFFLINE\n");
-                        fflush(stdout);
-                        MB_LOG_ERROR("[Thread 1] Timestamp send failed - forcing modem OFFLINE");
-
-                        /* Force modem to OFFLINE state on write error */
-                        pthread_mutex_lock(&ctx->modem_mutex);
-                        modem_hangup(&ctx->modem);
-                        pthread_mutex_unlock(&ctx->modem_mutex);
-
-                        /* Reset timestamp state */
-                        timestamp_set_offline(&ctx->timestamp);
-                        ctx->client_data_received = false;
-
-                        /* === ECHO FUNCTIONALITY: Mark client as OFFLINE === */
-                        echo_set_offline(&ctx->echo);
-                        MB_LOG_INFO("[Thread 1] Echo functionality deactivated - client is OFFLINE");
-                        break;
-
-                    case TIMESTAMP_DISABLED:
-                        /* Should not happen if enabled, but handle gracefully */
-                        printf("[DEBUG] [Thread 1] Timestamp transmission disabled\n");
-                        fflush(stdout);
-                        break;
-
-                    case TIMESTAMP_NOT_DUE:
-                        /* Should not happen since we checked timestamp_should_send */
-                        break;
-                }
-            }
-        } else {
-            /* Reset timestamp state when modem goes offline */
-            static bool was_online = false;
-            if (!is_online && was_online) {
-                printf("[INFO] [Thread 1] Modem went OFFLINE, resetting timestamp state\n");
-                fflush(stdout);
-                MB_LOG_INFO("[Thread 1] Modem went OFFLINE, resetting timestamp state");
-                timestamp_set_offline(&ctx->timestamp);
-                ctx->client_data_received = false;  /* Reset for next connection */
+/**
+ * Synchronize serial/telnet registrations with the bridge state
+ * @param force Re-check registrations even if descriptor numbers are unchanged
+ */
+static void bridge_event_sync(bridge_ctx_t *ctx, bool force)
+{
+#ifdef BRIDGE_HAS_SERIAL_POLL
+    int serial_fd = ctx->serial_ready ? serial_get_fd(&ctx->serial) : -1;
+    bridge_event_register(ctx, &ctx->event_serial_fd, serial_fd, EPOLLIN, force);
+#endif
 
-                /* === ECHO FUNCTIONALITY: Mark client as OFFLINE === */
-                echo_set_offline(&ctx->echo);
-                MB_LOG_INFO("[Thread 1] Echo functionality deactivated - client is OFFLINE");
-            }
-            was_online = is_online;
-        }
+#ifdef ENABLE_LEVEL2
+    uint32_t events = bridge_telnet_events(ctx);
+    bool changed = (events != ctx->event_telnet_events);
+    ctx->event_telnet_events = events;
+    bridge_event_register(ctx, &ctx->event_telnet_fd, ctx->telnet.fd, events, force || changed);
+#endif
+}
 
-        /* Goal 3: Wait for modem signals (AT commands, etc.) */
+/* ========== Line Timers ========== */
 
-        /* === Part 1: Serial → Telnet direction === */
+#ifdef ENABLE_LEVEL2
+/**
+ * Milliseconds until the telnet pass has time-driven work, -1 if none
+ */
+static int bridge_telnet_timeout_ms(bridge_ctx_t *ctx)
+{
+    /* Connect progress and connect timeout (same cadence as telnet thread) */
+    if (ctx->telnet.is_connecting) {
+        return 100;
+    }
+    /* RING pre-connect: server close and BRIDGE_PRECONNECT_TIMEOUT checks */
+    if (atomic_load(&ctx->preconnect_hold)) {
+        return 1000;
+    }
+    /* Inflated server data waiting for ring space */
+    if (telnet_recv_pending(&ctx->telnet)) {
+        return 1;
+    }
+    /* Spliced bytes waiting in a pipe for a full socket or serial driver */
+    if (passthru_pending(&ctx->passthru)) {
+        return PASSTHRU_RETRY_MS;
+    }
+    /* Cork window of coalesced keystrokes */
+    return telnet_write_timeout_ms(&ctx->telnet);
+}
+#endif
 
-        /* Read from serial port */
-        ssize_t n = serial_read(&ctx->serial, serial_buf, sizeof(serial_buf));
+#ifdef BRIDGE_HAS_SERIAL_POLL
+/**
+ * Milliseconds until the serial pass must run for the health check or the
+ * S12 escape guard, -1 if neither is pending
+ */
+static int bridge_serial_timeout_ms(bridge_ctx_t *ctx)
+{
+    if (!ctx->serial_health_checked) {
+        return 0;
+    }
 
-        if (n < 0) {
-            /* I/O error - handle disconnection */
-            MB_LOG_ERROR("[Thread 1] Serial I/O error: %s", strerror(errno));
-            serial_close(&ctx->serial);
-            ctx->serial_ready = false;
-            ctx->modem_ready = false;
-            usleep(100000);
-            continue;
-        }
+    pthread_mutex_lock(&ctx->modem_mutex);
+    int guard_ms = -1;
+    if (ctx->modem.escape.count > 0) {
+        /* S12 escape guard window */
+        guard_ms = modem_get_escape_guard_time(&ctx->modem) -
+                   (int)(bridge_monotonic_ms() - ctx->modem.escape.last_escape_ms);
+        guard_ms = MAX(guard_ms, 50);
+    }
+    pthread_mutex_unlock(&ctx->modem_mutex);
 
-        if (n > 0) {
-            /* Log raw data for debugging */
-            printf("[DEBUG] [Thread 1] Raw serial data (%zd bytes): ", n);
-            for (ssize_t i = 0; i < n && i < 32; i++) {
-                printf("%02X ", (unsigned char)serial_buf[i]);
-            }
-            printf("\n");
-            printf("[DEBUG] [Thread 1] ASCII: [%.*s]\n", (int)n, serial_buf);
-            fflush(stdout);
+    return guard_ms;
+}
 
-            /* Log data */
-            datalog_write(&ctx->datalog, DATALOG_DIR_FROM_MODEM, serial_buf, n);
+/**
+ * Milliseconds until the next Level 1 timestamp, -1 if none is scheduled
+ */
+static int bridge_timestamp_timeout_ms(bridge_ctx_t *ctx)
+{
+    pthread_mutex_lock(&ctx->modem_mutex);
+    bool online = modem_is_online(&ctx->modem);
+    pthread_mutex_unlock(&ctx->modem_mutex);
 
-            /* === CRITICAL: Check for hardware modem messages first === */
-            /* Hardware modems send unsolicited messages like RING, CONNECT, NO CARRIER */
-            pthread_mutex_lock(&ctx->modem_mutex);
-            bool hardware_msg_handled = modem_process_hardware_message(&ctx->modem, (char *)serial_buf, n);
-            modem_state_t current_state = modem_get_state(&ctx->modem);
+    if (!online || !ctx->client_data_received) {
+        return -1;
+    }
 
-            /* === ADDITIONAL RING DETECTION FOR STDOUT === */
-            /* Check if RING was in the received data for explicit stdout logging */
-            if (strstr((char *)serial_buf, "RING") != NULL) {
-                printf("[INFO] [Thread 1] *** RING SIGNAL DETECTED FROM HARDWARE MODEM ***\n");
-                fflush(stdout);
-                MB_LOG_INFO("[Thread 1] *** RING SIGNAL DETECTED FROM HARDWARE MODEM ***");
+    /* Disabled timestamps report -1; due now is re-checked every 100ms */
+    int due = timestamp_get_next_due(&ctx->timestamp);
+    if (due < 0) {
+        return -1;
+    }
+    return (due > 0) ? due * 1000 : 100;
+}
+#endif
 
-                /* Get ring count for additional logging */
-                int ring_count = ctx->modem.settings.s_registers[SREG_RING_COUNT];
-                int auto_answer = ctx->modem.settings.s_registers[SREG_AUTO_ANSWER];
-                printf("[INFO] [Thread 1] Ring count: %d, Auto-answer setting (S0): %d\n",
-                       ring_count, auto_answer);
-                fflush(stdout);
-            }
+/**
+ * Schedule one line timer timeout_ms from now (-1 = cancel)
+ */
+static void bridge_timer_set(bridge_ctx_t *ctx, bridge_timer_id_t id, long long now_ms,
+                             int timeout_ms)
+{
+    timerwheel_timer_t *timer = &ctx->timers[id];
 
-            pthread_mutex_unlock(&ctx->modem_mutex);
+    if (timeout_ms < 0) {
+        timerwheel_cancel(ctx->timer_wheel, timer);
+        return;
+    }
 
-            /* Handle state transitions from hardware messages */
-            if (current_state == MODEM_STATE_CONNECTING) {
-                /* Modem is connecting (answered call, waiting for CONNECT) */
-                /* Check if this is software or hardware auto-answer mode */
-                int auto_answer = ctx->modem.settings.s_registers[SREG_AUTO_ANSWER];
-                if (auto_answer == 0) {
-                    /* Software auto-answer mode (S0=0) */
-                    printf("[INFO] [Thread 1] Modem state: CONNECTING - waiting for CONNECT response (software auto-answer mode)\n");
-                    fflush(stdout);
-                    MB_LOG_INFO("[Thread 1] Modem state: CONNECTING - waiting for CONNECT response (software auto-answer mode)");
-                } else {
-                    /* Hardware auto-answer mode (S0 > 0) */
-                    printf("[INFO] [Thread 1] Modem state: CONNECTING - waiting for CONNECT response (hardware auto-answer mode, S0=%d)\n", auto_answer);
-                    fflush(stdout);
-                    MB_LOG_INFO("[Thread 1] Modem state: CONNECTING - waiting for CONNECT response (hardware auto-answer mode, S0=%d)", auto_answer);
-                }
-                continue;
-            } else if (current_state == MODEM_STATE_ONLINE && hardware_msg_handled) {
-                /* === ONLINE state transition: CONNECT message just received === */
-                /* This block runs ONCE when CONNECT is received, not for every data byte */
-                printf("[INFO] [Thread 1] Hardware modem ONLINE (CONNECT received)\n");
-                fflush(stdout);
-                MB_LOG_INFO("[Thread 1] Hardware modem ONLINE (CONNECT received)");
+    /* An earlier deadline only costs one extra pass: keep it */
+    long long deadline = now_ms + timeout_ms;
+    if (timerwheel_pending(timer) && timer->expires_ms <= deadline) {
+        return;
+    }
+    timerwheel_schedule(ctx->timer_wheel, timer, deadline);
+}
 
-                /* Mark that client connection is established (ONLY after CONNECT) */
-                if (!ctx->client_data_received) {
-                    ctx->client_data_received = true;
-                    printf("[INFO] [Thread 1] Client connected (CONNECT received) - timestamp transmission enabled\n");
-                    fflush(stdout);
-                    MB_LOG_INFO("[Thread 1] Client connected (CONNECT received) - timestamp transmission enabled");
+/**
+ * Attach the line's timers to the serving thread's wheel
+ */
+void bridge_timers_attach(bridge_ctx_t *ctx, timerwheel_t *wheel,
+                          timerwheel_callback_t service, void *arg)
+{
+    if (ctx == NULL || wheel == NULL || service == NULL) {
+        return;
+    }
 
-                    /* IMPORTANT: Start timestamp transmission when modem goes ONLINE */
-                    printf("[DEBUG] [Thread 1] Calling timestamp_set_online() to start timestamp tracking\n");
-                    fflush(stdout);
-                    timestamp_set_online(&ctx->timestamp);
-                    MB_LOG_INFO("[Thread 1] Timestamp tracking started - first timestamp in 3 seconds");
+    for (int i = 0; i < BRIDGE_TIMER_COUNT; i++) {
+        timerwheel_timer_init(&ctx->timers[i], service, arg);
+    }
+    ctx->timer_wheel = wheel;
+}
 
-                    /* === ECHO FUNCTIONALITY: Mark client as ONLINE for echo === */
-                    printf("[DEBUG] [Thread 1] Checking echo configuration: echo_enabled=%d\n", ctx->config->echo_enabled);
-                    fflush(stdout);
-                    MB_LOG_DEBUG("[Thread 1] Echo configuration: echo_enabled=%d", ctx->config->echo_enabled);
+/**
+ * Cancel the line's timers and detach them from their wheel
+ */
+void bridge_timers_detach(bridge_ctx_t *ctx)
+{
+    if (ctx == NULL || ctx->timer_wheel == NULL) {
+        return;
+    }
 
-                    if (ctx->config->echo_enabled) {
-                        printf("[DEBUG] [Thread 1] Activating echo functionality for ONLINE client\n");
-                        fflush(stdout);
-                        echo_set_online(&ctx->echo);
-                        MB_LOG_INFO("[Thread 1] Echo functionality activated - client is ONLINE");
-                    } else {
-                        printf("[DEBUG] [Thread 1] Echo functionality disabled - not activating\n");
-                        fflush(stdout);
-                        MB_LOG_DEBUG("[Thread 1] Echo functionality disabled - not activating");
-                    }
-                }
+    for (int i = 0; i < BRIDGE_TIMER_COUNT; i++) {
+        timerwheel_cancel(ctx->timer_wheel, &ctx->timers[i]);
+    }
+    ctx->timer_wheel = NULL;
+}
 
-                /* Update state to indicate connection is active */
-                pthread_mutex_lock(&ctx->state_mutex);
-                ctx->state = STATE_CONNECTED;
-                ctx->connection_start_time = time(NULL);
-                pthread_mutex_unlock(&ctx->state_mutex);
+/**
+ * Schedule the line's timers for its current deadlines
+ */
+void bridge_timers_update(bridge_ctx_t *ctx, long long now_ms)
+{
+    if (ctx == NULL || ctx->timer_wheel == NULL) {
+        return;
+    }
 
-                /* Note: This block runs only once when CONNECT message is received */
-                /* Normal data processing happens in the else block below (line 2304+) */
-                continue;
-            } else if (current_state == MODEM_STATE_DISCONNECTED) {
-                printf("[INFO] [Thread 1] Modem DISCONNECTED\n");
-                fflush(stdout);
-                MB_LOG_INFO("[Thread 1] Modem DISCONNECTED");
-                pthread_mutex_lock(&ctx->state_mutex);
 #ifdef ENABLE_LEVEL2
-                if (telnet_is_connected(&ctx->telnet)) {
-                    MB_LOG_INFO("[Thread 1] Closing telnet due to modem disconnect");
-                    telnet_disconnect(&ctx->telnet);
-                }
+    bridge_timer_set(ctx, BRIDGE_TIMER_TELNET, now_ms, bridge_telnet_timeout_ms(ctx));
 #endif
-                ctx->state = STATE_IDLE;
-                pthread_mutex_unlock(&ctx->state_mutex);
-                continue;
-            }
 
-            /* Process through modem layer */
-            pthread_mutex_lock(&ctx->modem_mutex);
-            bool modem_online = modem_is_online(&ctx->modem);
+#ifdef BRIDGE_HAS_SERIAL_POLL
+    if (ctx->serial_ready) {
+        bridge_timer_set(ctx, BRIDGE_TIMER_SERIAL, now_ms, bridge_serial_timeout_ms(ctx));
+        bridge_timer_set(ctx, BRIDGE_TIMER_SERIAL_TX, now_ms, serial_tx_next_timeout_ms(&ctx->serial));
+        bridge_timer_set(ctx, BRIDGE_TIMER_TIMESTAMP, now_ms, bridge_timestamp_timeout_ms(ctx));
+    } else {
+        bridge_timer_set(ctx, BRIDGE_TIMER_SERIAL, now_ms, -1);
+        bridge_timer_set(ctx, BRIDGE_TIMER_SERIAL_TX, now_ms, -1);
+        bridge_timer_set(ctx, BRIDGE_TIMER_TIMESTAMP, now_ms, -1);
+    }
+#endif
+}
 
-            if (!modem_online) {
-                /* COMMAND mode: process AT commands ONLY if not a hardware message */
-                if (!hardware_msg_handled) {
-                    modem_process_input(&ctx->modem, (char *)serial_buf, n);
-                }
-                pthread_mutex_unlock(&ctx->modem_mutex);
-            } else {
-                /* ONLINE mode: Process escape sequences */
-                ssize_t consumed = modem_process_input(&ctx->modem, (char *)serial_buf, n);
-                pthread_mutex_unlock(&ctx->modem_mutex);
+/**
+ * Create epoll set, wake eventfd and timerfd, then start the event thread
+ */
+static int bridge_start_event_thread(bridge_ctx_t *ctx)
+{
+    struct epoll_event ev;
+
+    ctx->event_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    ctx->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    ctx->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (ctx->event_epoll_fd < 0 || ctx->wake_fd < 0 || ctx->timer_fd < 0) {
+        MB_LOG_ERROR("Failed to create event loop descriptors: %s", strerror(errno));
+        goto error;
+    }
 
-                if (consumed > 0) {
-#ifdef ENABLE_LEVEL3
-                    /* === LEVEL 3 MODE: Forward data to pipeline === */
-                    if (ctx->level3_enabled && ctx->level3 != NULL) {
-                        l3_context_t *l3_ctx = (l3_context_t*)ctx->level3;
-
-                        /* Debug: Print Level 3 status */
-                        printf("[DEBUG-L3-STATUS] level3_active=%d, system_state=%d (DATA_TRANSFER=%d)\n",
-                               l3_ctx->level3_active, l3_ctx->system_state, L3_STATE_DATA_TRANSFER);
-                        fflush(stdout);
-
-                        if (l3_ctx->level3_active && l3_ctx->system_state == L3_STATE_DATA_TRANSFER) {
-                            /* Level 3 active: Write data to pipeline buffer */
-                            size_t written = ts_cbuf_write(&ctx->ts_serial_to_telnet_buf,
-                                                          serial_buf, consumed);
-                            if (written > 0) {
-                                printf("[DEBUG-L3-FORWARDED] Forwarded %zu bytes to pipeline\n", written);
-                                fflush(stdout);
-                                MB_LOG_DEBUG("[Thread 1] Level 3: Forwarded %zu bytes to pipeline", written);
-                            } else {
-                                printf("[WARNING-L3-BUFFER-FULL] Buffer full, dropped %zd bytes\n", consumed);
-                                fflush(stdout);
-                                MB_LOG_WARNING("[Thread 1] Level 3: Buffer full, dropped %zd bytes", consumed);
-                            }
-                            continue;  /* Skip Level 1 echo processing */
-                        } else {
-                            /* Debug: Why Level 3 not active? */
-                            printf("[DEBUG-L3-INACTIVE] Skipping Level 3: active=%d, state=%d\n",
-                                   l3_ctx->level3_active, l3_ctx->system_state);
-                            fflush(stdout);
-                        }
-                    } else {
-                        /* Debug: Level 3 not enabled or NULL */
-                        printf("[DEBUG-L3-DISABLED] level3_enabled=%d, level3=%p\n",
-                               ctx->level3_enabled, (void*)ctx->level3);
-                        fflush(stdout);
-                    }
-#endif
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = ctx->wake_fd;
+    if (epoll_ctl(ctx->event_epoll_fd, EPOLL_CTL_ADD, ctx->wake_fd, &ev) < 0) {
+        goto error;
+    }
+    ev.data.fd = ctx->timer_fd;
+    if (epoll_ctl(ctx->event_epoll_fd, EPOLL_CTL_ADD, ctx->timer_fd, &ev) < 0) {
+        goto error;
+    }
 
+#ifdef BRIDGE_HAS_SERIAL_POLL
 #ifdef ENABLE_LEVEL2
-                    /* === LEVEL 2 MODE: Forward data to telnet thread via buffer === */
-                    size_t written = ts_cbuf_write(&ctx->ts_serial_to_telnet_buf,
-                                                   serial_buf, consumed);
-                    if (written > 0) {
-                        MB_LOG_DEBUG("[Thread 1] Level 2: Forwarded %zu bytes to telnet thread", written);
-                    } else {
-                        MB_LOG_WARNING("[Thread 1] Level 2: Buffer full, dropped %zd bytes", consumed);
-                    }
-                    continue;  /* Skip Level 1 echo processing */
-#endif
-
-                    /* === LEVEL 1: Data is handled directly between modem and client === */
-                    /* No telnet forwarding needed - client data stays local */
-                    MB_LOG_DEBUG("[Thread 1] Level 1: Processed %zd bytes from client (no telnet forward)", consumed);
-
-                    /* === ECHO FUNCTIONALITY (Level 1) === */
-                    /* Process client data for echo with timestamp formatting */
-                    if (ctx->config->echo_enabled) {
-                        echo_result_t echo_result = echo_process_client_data(&ctx->echo, &ctx->serial,
-                                                                          serial_buf, consumed);
-                        switch (echo_result) {
-                            case ECHO_SUCCESS:
-                                MB_LOG_DEBUG("[Thread 1] Echo processed successfully");
-                                break;
-                            case ECHO_DISABLED:
-                                MB_LOG_DEBUG("[Thread 1] Echo functionality disabled");
-                                break;
-                            case ECHO_ERROR:
-                                MB_LOG_WARNING("[Thread 1] Echo processing failed");
-                                break;
-                            case ECHO_INVALID_PARAM:
-                                MB_LOG_WARNING("[Thread 1] Echo processing: invalid parameters");
-                                break;
-                            case ECHO_BUFFER_FULL:
-                                MB_LOG_WARNING("[Thread 1] Echo buffer full");
-                                break;
-                        }
-                    }
-                }
-            }
+    /* Other threads (Level 3 local echo) queue bytes for the serial pass */
+    int queue_fd = ts_cbuf_get_event_fd(&ctx->ts_telnet_to_serial_buf);
+    if (queue_fd >= 0) {
+        ev.data.fd = queue_fd;
+        if (epoll_ctl(ctx->event_epoll_fd, EPOLL_CTL_ADD, queue_fd, &ev) == 0) {
+            ts_cbuf_watch(&ctx->ts_telnet_to_serial_buf, true);
+            ctx->event_queue_watched = true;
         }
+    }
+#endif
+#endif
 
-        /* === Part 2: Telnet → Serial direction === */
-#ifdef ENABLE_LEVEL2
+    /* The event thread is the only poller, so passes never block */
+    ctx->poll_timeout_ms = 0;
+    timerwheel_init(&ctx->event_wheel, bridge_monotonic_ms());
+    bridge_timers_attach(ctx, &ctx->event_wheel, bridge_event_service, ctx);
 
-        /* Check if Level 3 is handling this direction */
-        bool level3_handles_telnet_to_serial = false;
-#ifdef ENABLE_LEVEL3
-        if (ctx->level3_enabled && ctx->level3 != NULL) {
-            l3_context_t *l3_ctx = (l3_context_t*)ctx->level3;
-            if (l3_ctx->level3_active && l3_ctx->system_state == L3_STATE_DATA_TRANSFER) {
-                /* Level 3 pipeline is handling data transfer - skip buffer reading */
-                level3_handles_telnet_to_serial = true;
-            }
-        }
-#endif
+    int ret = bridge_thread_create(ctx, &ctx->event_thread, RTSCHED_SERIAL, "Event",
+                                   bridge_event_thread_func);
+    if (ret != 0) {
+        MB_LOG_ERROR("Failed to create event thread: %s", strerror(ret));
+        goto error;
+    }
+    ctx->event_thread_started = true;
 
-        /* Level 2 mode: Read from telnet→serial buffer and write to serial (if Level 3 not active) */
-        if (!level3_handles_telnet_to_serial) {
-            size_t tx_len = ts_cbuf_read(&ctx->ts_telnet_to_serial_buf, tx_buf, sizeof(tx_buf));
-            if (tx_len > 0) {
-                /* Log data */
-                datalog_write(&ctx->datalog, DATALOG_DIR_TO_MODEM, tx_buf, tx_len);
+    MB_LOG_INFO("Event-driven bridge thread created (epoll fd=%d)", ctx->event_epoll_fd);
+    return SUCCESS;
 
-                /* Write to serial port */
-                ssize_t sent = serial_write(&ctx->serial, tx_buf, tx_len);
-                if (sent > 0) {
-                    ctx->bytes_telnet_to_serial += sent;
-                }
-            }
-        }
-#else
-        /* Level 1: No telnet to serial transfer needed */
-#endif
+error:
+    bridge_stop_event_thread(ctx);
+    ctx->thread_running = false;
+    ctx->running = false;
+    return ERROR_GENERAL;
+}
 
-        /* Sleep longer to reduce CPU usage and prevent timestamp flooding */
-        /* Check every 100ms instead of 10ms - still responsive but less busy */
-        usleep(100000);  /* 100ms - balanced between responsiveness and CPU usage */
+/**
+ * Join the event thread (if started) and release its descriptors
+ */
+static void bridge_stop_event_thread(bridge_ctx_t *ctx)
+{
+    if (ctx->event_thread_started) {
+        bridge_wake(ctx);
+        MB_LOG_INFO("Waiting for event-driven bridge thread to exit...");
+        pthread_join(ctx->event_thread, NULL);
+        ctx->event_thread_started = false;
+        MB_LOG_INFO("Event-driven bridge thread exited");
     }
 
-    MB_LOG_INFO("[Thread 1] Serial/Modem thread exiting");
-    return NULL;
-}
+    bridge_timers_detach(ctx);
+#ifdef ENABLE_LEVEL2
+    if (ctx->event_queue_watched) {
+        ts_cbuf_watch(&ctx->ts_telnet_to_serial_buf, false);
+        ctx->event_queue_watched = false;
+    }
 #endif
+    if (ctx->timer_fd >= 0) {
+        close(ctx->timer_fd);
+        ctx->timer_fd = -1;
+    }
+    if (ctx->wake_fd >= 0) {
+        close(ctx->wake_fd);
+        ctx->wake_fd = -1;
+    }
+    if (ctx->event_epoll_fd >= 0) {
+        close(ctx->event_epoll_fd);
+        ctx->event_epoll_fd = -1;
+    }
+    ctx->event_serial_fd = -1;
+    ctx->event_telnet_fd = -1;
+    ctx->poll_timeout_ms = 100;
+}
 
-#ifdef ENABLE_LEVEL2
 /**
- * Telnet thread function - Level 2 only
- * Handles:
- * - Telnet I/O (reading from telnet server)
- * - IAC protocol processing
- * - Telnet → Serial data buffering
- * - Serial → Telnet data transmission
+ * Move data until both directions are idle (bounded per wakeup)
+ * Also the callback of the line timers in event-driven mode.
  */
-void *telnet_thread_func(void *arg)
+static void bridge_event_service(void *arg)
 {
     bridge_ctx_t *ctx = (bridge_ctx_t *)arg;
-    unsigned char telnet_buf[BUFFER_SIZE];
-    unsigned char processed_buf[BUFFER_SIZE];
-    unsigned char output_buf[BUFFER_SIZE];
-    unsigned char tx_buf[BUFFER_SIZE];
-
-    MB_LOG_INFO("[Thread 2] Telnet thread started");
 
-    while (ctx->thread_running) {
-        /* Check if telnet is connected or connecting */
-        if (!telnet_is_connected(&ctx->telnet)) {
-            /* Level 3 mode: Connection controlled by state machine, not by this thread */
-            /* But we need to process events for non-blocking connect completion */
-            if (ctx->telnet.is_connecting) {
-                /* Process epoll events to complete non-blocking connection */
-                int result = telnet_process_events(&ctx->telnet, 100);
-                if (result != SUCCESS) {
-                    MB_LOG_ERROR("[Thread 2] Failed to process connection events: %d", result);
-                    telnet_disconnect(&ctx->telnet);
-                }
-                /* Check if connection completed */
-                if (telnet_is_connected(&ctx->telnet)) {
-                    MB_LOG_INFO("[Thread 2] Telnet connection completed");
-                }
-            }
-            usleep(100000);  /* 100ms */
-            continue;
+    for (int burst = 0; burst < 8; burst++) {
+        bool again = false;
+#ifdef BRIDGE_HAS_SERIAL_POLL
+        if (bridge_serial_poll(ctx) == 0) {
+            again = true;
+        }
+#endif
+#ifdef ENABLE_LEVEL2
+        if (bridge_telnet_poll(ctx) == 0) {
+            again = true;
+        }
+#endif
+        if (!again && !bridge_has_pending_data(ctx)) {
+            break;
         }
+    }
+}
 
-        /* === Part 1: Telnet → Serial direction === */
+/**
+ * Event-driven bridge thread
+ * Sleeps in epoll_wait() with no timeout; every wakeup runs serial and
+ * telnet passes until both report idle, then re-arms the line timers.
+ */
+void *bridge_event_thread_func(void *arg)
+{
+    bridge_ctx_t *ctx = (bridge_ctx_t *)arg;
+    struct epoll_event events[8];
+    bool force_sync = true;
 
-        /* Read from telnet */
-        ssize_t n = telnet_recv(&ctx->telnet, telnet_buf, sizeof(telnet_buf));
+    MB_LOG_INFO("[Event] Event-driven bridge thread started");
 
-        if (n < 0) {
-            /* I/O error */
-            MB_LOG_ERROR("[Thread 2] Telnet connection error");
-            telnet_disconnect(&ctx->telnet);
+    while (ctx->thread_running) {
+        bridge_event_sync(ctx, force_sync);
+        bridge_timers_update(ctx, bridge_monotonic_ms());
+        timerwheel_arm_timerfd(&ctx->event_wheel, ctx->timer_fd);
+        force_sync = false;
 
-            /* Notify serial thread to hang up modem */
-            pthread_mutex_lock(&ctx->modem_mutex);
-            if (modem_is_online(&ctx->modem)) {
-                modem_hangup(&ctx->modem);
-                modem_send_no_carrier(&ctx->modem);
+        int n = epoll_wait(ctx->event_epoll_fd, events, ARRAY_SIZE(events), -1);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
             }
-            pthread_mutex_unlock(&ctx->modem_mutex);
-
-            pthread_mutex_lock(&ctx->state_mutex);
-            ctx->state = STATE_IDLE;
-            pthread_mutex_unlock(&ctx->state_mutex);
-
-            continue;
+            MB_LOG_ERROR("[Event] epoll_wait failed: %s", strerror(errno));
+            break;
         }
 
-        if (n == 0) {
-            /* Check if connection closed */
-            if (!telnet_is_connected(&ctx->telnet)) {
-                MB_LOG_INFO("[Thread 2] Telnet disconnected");
-                telnet_disconnect(&ctx->telnet);
-
-                pthread_mutex_lock(&ctx->modem_mutex);
-                if (modem_is_online(&ctx->modem)) {
-                    modem_hangup(&ctx->modem);
-                    modem_send_no_carrier(&ctx->modem);
+        for (int i = 0; i < n; i++) {
+            uint64_t count;
+            if (events[i].data.fd == ctx->wake_fd) {
+                /* Descriptors may have been replaced by another thread */
+                if (read(ctx->wake_fd, &count, sizeof(count)) > 0) {
+                    force_sync = true;
                 }
-                pthread_mutex_unlock(&ctx->modem_mutex);
-
-                pthread_mutex_lock(&ctx->state_mutex);
-                ctx->state = STATE_IDLE;
-                pthread_mutex_unlock(&ctx->state_mutex);
-            }
-            usleep(1000);
-            continue;
-        }
-
-        if (n > 0) {
-            /* Log data from telnet */
-            datalog_write(&ctx->datalog, DATALOG_DIR_FROM_TELNET, telnet_buf, n);
-
-            /* Process telnet protocol (remove IAC) */
-            size_t processed_len;
-            telnet_process_input(&ctx->telnet, telnet_buf, n,
-                                processed_buf, sizeof(processed_buf), &processed_len);
-
-            if (processed_len > 0) {
-                /* Pass through ANSI sequences to modem client */
-                size_t output_len;
-                ansi_passthrough_telnet_to_modem(processed_buf, processed_len,
-                                                output_buf, sizeof(output_buf), &output_len);
-
-                if (output_len > 0) {
-                    /* Write to telnet→serial buffer */
-                    ts_cbuf_write(&ctx->ts_telnet_to_serial_buf,
-                                 output_buf, output_len);
+            } else if (events[i].data.fd == ctx->timer_fd) {
+                if (read(ctx->timer_fd, &count, sizeof(count)) > 0) {
+                    force_sync = true;
                 }
             }
-        }
-
-        /* === Part 2: Serial → Telnet direction === */
-
-        /* Check if Level 3 is handling this direction */
-        bool level3_handles_serial_to_telnet = false;
-#ifdef ENABLE_LEVEL3
-        if (ctx->level3_enabled) {
-            /* If Level 3 is enabled at all, it handles the buffers */
-            level3_handles_serial_to_telnet = true;
-
-            /* DEBUG: Log Level 3 handling status periodically */
-            static int log_count = 0;
-            if (++log_count % 1000 == 0) {
-                if (ctx->level3 != NULL) {
-                    l3_context_t *l3_ctx = (l3_context_t*)ctx->level3;
-                    printf("[DEBUG-TELNET-THREAD] Level 3 enabled: active=%d, state=%d\n",
-                           l3_ctx->level3_active, l3_ctx->system_state);
-                    fflush(stdout);
-                }
+#ifdef ENABLE_LEVEL2
+            else if (events[i].data.fd == ts_cbuf_get_event_fd(&ctx->ts_telnet_to_serial_buf)) {
+                ssize_t ret = read(events[i].data.fd, &count, sizeof(count));
+                (void)ret;
             }
-        }
 #endif
+        }
 
-        /* Level 2 mode: Read from serial→telnet buffer and send (ONLY if Level 3 not enabled) */
-        if (!level3_handles_serial_to_telnet) {
-            size_t tx_len = ts_cbuf_read(&ctx->ts_serial_to_telnet_buf, tx_buf, sizeof(tx_buf));
-            if (tx_len > 0) {
-                /* Log data to telnet */
-                datalog_write(&ctx->datalog, DATALOG_DIR_TO_TELNET, tx_buf, tx_len);
-
-                /* Send to telnet server */
-                telnet_send(&ctx->telnet, tx_buf, tx_len);
-            }
+        if (!ctx->thread_running) {
+            break;
         }
 
-        /* Short sleep to avoid busy-waiting */
-        usleep(10000);  /* 10ms - reduced frequency to avoid excessive polling */
+        /* Expired timers run the passes; otherwise the descriptors woke us */
+        if (timerwheel_advance(&ctx->event_wheel, bridge_monotonic_ms()) == 0) {
+            bridge_event_service(ctx);
+        }
     }
 
-    MB_LOG_INFO("[Thread 2] Telnet thread exiting");
+    MB_LOG_INFO("[Event] Event-driven bridge thread exiting");
     return NULL;
 }
-#endif
 
 /* ========== Level 3 Integration ========== */
 
@@ -2751,7 +4290,8 @@ int bridge_start_level3(bridge_ctx_t *ctx)
     }
 
     /* Create Level 3 management thread */
-    ret = pthread_create(&ctx->level3_thread, NULL, bridge_level3_thread_func, ctx);
+    ret = bridge_thread_create(ctx, &ctx->level3_thread, RTSCHED_LEVEL3, "Level 3",
+                               bridge_level3_thread_func);
     if (ret != 0) {
         MB_LOG_ERROR("Failed to create Level 3 management thread: %s", strerror(ret));
         l3_stop((l3_context_t*)ctx->level3);
@@ -2910,6 +4450,11 @@ int bridge_handle_dcd_event(bridge_ctx_t *ctx, bool dcd_state)
             printf("[INFO-BRIDGE-DCD] Forwarding DCD rising edge to Level 3 pipeline\n");
             fflush(stdout);
             MB_LOG_INFO("Forwarding DCD rising edge to Level 3 pipeline");
+
+            /* Level 3 connects on its own, so size and pace the line here */
+            ctx->connected_baudrate = ctx->modem.connect_speed;
+            bridge_apply_line_rate(ctx, ctx->connected_baudrate);
+
             int ret = l3_on_dcd_rising(l3_ctx);
             printf("[INFO-BRIDGE-DCD] l3_on_dcd_rising() returned: %d\n", ret);
             fflush(stdout);
@@ -2921,6 +4466,11 @@ int bridge_handle_dcd_event(bridge_ctx_t *ctx, bool dcd_state)
             printf("[INFO-BRIDGE-DCD] Forwarding DCD falling edge to Level 3 pipeline\n");
             fflush(stdout);
             MB_LOG_INFO("Forwarding DCD falling edge to Level 3 pipeline");
+
+            bridge_log_line_utilization(ctx);
+            ctx->connected_baudrate = 0;
+            bridge_apply_line_rate(ctx, 0);
+
             int ret = l3_on_dcd_falling(l3_ctx);
             printf("[INFO-BRIDGE-DCD] l3_on_dcd_falling() returned: %d\n", ret);
             fflush(stdout);
@@ -0,0 +1,142 @@
+/*
+ * bufpool.c - Shared buffer slab for ModemBridge
+ */
+
+#include "bufpool.h"
+#include <pthread.h>
+
+/* Free chunks are linked through their first bytes */
+typedef struct bufpool_chunk_s {
+    struct bufpool_chunk_s *next;
+} bufpool_chunk_t;
+
+static pthread_mutex_t bufpool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static bufpool_chunk_t *bufpool_free_list[BUFPOOL_CLASS_COUNT];
+static bufpool_stats_t bufpool_stats;
+static bool bufpool_touch = false;     /* Fault new slabs in (bufpool_prefault()) */
+
+/**
+ * Size class index for a chunk size
+ */
+static int bufpool_class_index(size_t size)
+{
+    int index = 0;
+    size_t class_size = BUFPOOL_MIN_SIZE;
+
+    while (class_size < size && index < BUFPOOL_CLASS_COUNT - 1) {
+        class_size <<= 1;
+        index++;
+    }
+    return index;
+}
+
+/**
+ * Carve a new slab into chunks of one class (caller holds bufpool_mutex)
+ */
+static int bufpool_refill(int index)
+{
+    size_t class_size = (size_t)BUFPOOL_MIN_SIZE << index;
+    size_t slab_size = MAX(class_size, (size_t)BUFPOOL_SLAB_SIZE);
+    unsigned char *slab = aligned_alloc(BUFPOOL_ALIGN, slab_size);
+
+    if (slab == NULL) {
+        return ERROR_GENERAL;
+    }
+    if (bufpool_touch) {
+        memset(slab, 0, slab_size);
+    }
+
+    for (size_t off = 0; off + class_size <= slab_size; off += class_size) {
+        bufpool_chunk_t *chunk = (bufpool_chunk_t *)(slab + off);
+        chunk->next = bufpool_free_list[index];
+        bufpool_free_list[index] = chunk;
+        bufpool_stats.chunks_free[index]++;
+    }
+    bufpool_stats.slab_bytes += slab_size;
+
+    return SUCCESS;
+}
+
+/**
+ * Round a request up to its size class
+ */
+size_t bufpool_class_size(size_t size)
+{
+    return (size_t)BUFPOOL_MIN_SIZE << bufpool_class_index(size);
+}
+
+/**
+ * Allocate a buffer from the shared slab
+ */
+void *bufpool_alloc(size_t size, size_t *granted)
+{
+    int index = bufpool_class_index(size);
+    bufpool_chunk_t *chunk = NULL;
+
+    pthread_mutex_lock(&bufpool_mutex);
+
+    if (bufpool_free_list[index] != NULL || bufpool_refill(index) == SUCCESS) {
+        chunk = bufpool_free_list[index];
+        bufpool_free_list[index] = chunk->next;
+        bufpool_stats.chunks_free[index]--;
+        bufpool_stats.chunks_in_use[index]++;
+        bufpool_stats.bytes_in_use += (size_t)BUFPOOL_MIN_SIZE << index;
+    }
+
+    pthread_mutex_unlock(&bufpool_mutex);
+
+    if (chunk == NULL) {
+        MB_LOG_ERROR("Buffer slab exhausted (%zu bytes requested)", size);
+        return NULL;
+    }
+
+    if (granted != NULL) {
+        *granted = (size_t)BUFPOOL_MIN_SIZE << index;
+    }
+    return chunk;
+}
+
+/**
+ * Return a buffer to the shared slab
+ */
+void bufpool_free(void *ptr, size_t size)
+{
+    if (ptr == NULL) {
+        return;
+    }
+
+    int index = bufpool_class_index(size);
+    bufpool_chunk_t *chunk = (bufpool_chunk_t *)ptr;
+
+    pthread_mutex_lock(&bufpool_mutex);
+    chunk->next = bufpool_free_list[index];
+    bufpool_free_list[index] = chunk;
+    bufpool_stats.chunks_free[index]++;
+    bufpool_stats.chunks_in_use[index]--;
+    bufpool_stats.bytes_in_use -= (size_t)BUFPOOL_MIN_SIZE << index;
+    pthread_mutex_unlock(&bufpool_mutex);
+}
+
+/**
+ * Fault in every slab allocated from now on
+ */
+void bufpool_prefault(void)
+{
+    pthread_mutex_lock(&bufpool_mutex);
+    bufpool_touch = true;
+    pthread_mutex_unlock(&bufpool_mutex);
+}
+
+/**
+ * Get slab statistics
+ */
+void bufpool_get_stats(bufpool_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&bufpool_mutex);
+    *stats = bufpool_stats;
+    pthread_mutex_unlock(&bufpool_mutex);
+}
@@ -0,0 +1,398 @@
+/*
+ * charset.c - Character set transcoding between terminal and server
+ */
+
+#include "charset.h"
+#include <ctype.h>
+#include <pthread.h>
+
+#define CHARSET_INVALID         0xFFFFFFFFu     /* Decoded: not a character */
+#define CHARSET_REPLACEMENT     0xFFFDu
+#define CHARSET_HIGH_BITS       0x8080808080808080ULL
+
+/* UTF-8 lead byte: sequence length and range of the first continuation byte
+ * (RFC 3629; excludes overlong forms and surrogates). len 0 = invalid. */
+typedef struct {
+    uint8_t len;
+    uint8_t lo;
+    uint8_t hi;
+} charset_utf8_lead_t;
+
+static const charset_utf8_lead_t charset_utf8_lead[256] = {
+    [0x00 ... 0x7F] = {1, 0x00, 0x00},
+    [0xC2 ... 0xDF] = {2, 0x80, 0xBF},
+    [0xE0]          = {3, 0xA0, 0xBF},
+    [0xE1 ... 0xEC] = {3, 0x80, 0xBF},
+    [0xED]          = {3, 0x80, 0x9F},
+    [0xEE ... 0xEF] = {3, 0x80, 0xBF},
+    [0xF0]          = {4, 0x90, 0xBF},
+    [0xF1 ... 0xF3] = {4, 0x80, 0xBF},
+    [0xF4]          = {4, 0x80, 0x8F}
+};
+
+static const char *const charset_names[CHARSET_COUNT] = {
+    [CHARSET_UTF8]  = "UTF-8",
+    [CHARSET_CP437] = "CP437",
+    [CHARSET_EUCKR] = "EUC-KR"
+};
+
+/* Unicode to legacy code: 256-entry pages by high byte (0 = none) */
+static uint16_t *charset_reverse[CHARSET_COUNT][256];
+static pthread_once_t charset_reverse_once = PTHREAD_ONCE_INIT;
+
+/**
+ * Enter one code into the Unicode-to-legacy pages
+ */
+static void charset_reverse_add(charset_t charset, uint16_t ucs, uint16_t code)
+{
+    uint16_t **page = &charset_reverse[charset][ucs >> 8];
+
+    if (*page == NULL) {
+        *page = calloc(256, sizeof(uint16_t));
+        if (*page == NULL) {
+            return;     /* Characters of this page encode as '?' */
+        }
+    }
+    (*page)[ucs & 0xFF] = code;
+}
+
+/**
+ * Build the Unicode-to-legacy pages from the decode tables (once)
+ */
+static void charset_reverse_build(void)
+{
+    for (int i = 0; i < 128; i++) {
+        charset_reverse_add(CHARSET_CP437, charset_cp437_table[i], (uint16_t)(0x80 + i));
+    }
+
+    for (int row = 0; row < CHARSET_EUCKR_ROWS; row++) {
+        for (int col = 0; col < CHARSET_EUCKR_ROWS; col++) {
+            uint16_t ucs = charset_euckr_table[row * CHARSET_EUCKR_ROWS + col];
+            if (ucs != 0) {
+                charset_reverse_add(CHARSET_EUCKR, ucs, (uint16_t)(((0xA1 + row) << 8) | (0xA1 + col)));
+            }
+        }
+    }
+}
+
+/**
+ * Length of the ASCII run at the start of data, eight bytes per step
+ */
+static size_t charset_ascii_run(const unsigned char *data, size_t len)
+{
+    size_t i = 0;
+
+    for (; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        if (word & CHARSET_HIGH_BITS) {
+            break;
+        }
+    }
+    while (i < len && data[i] < 0x80) {
+        i++;
+    }
+    return i;
+}
+
+/**
+ * Decode one character
+ * @return Bytes taken (ucs = CHARSET_INVALID for a bad sequence), 0 if the
+ *         data ends inside a sequence that is valid so far
+ */
+static size_t charset_decode(charset_t charset, const unsigned char *p, size_t len, uint32_t *ucs)
+{
+    unsigned char c = p[0];
+
+    if (c < 0x80) {
+        *ucs = c;
+        return 1;
+    }
+
+    switch (charset) {
+        case CHARSET_CP437:
+            *ucs = charset_cp437_table[c - 0x80];
+            return 1;
+
+        case CHARSET_EUCKR:
+            if (c < 0xA1 || c == 0xFF) {
+                *ucs = CHARSET_INVALID;
+                return 1;
+            }
+            if (len < 2) {
+                return 0;
+            }
+            if (p[1] < 0xA1 || p[1] == 0xFF) {
+                *ucs = CHARSET_INVALID;
+                return 1;   /* The second byte is looked at again */
+            }
+            *ucs = charset_euckr_table[(c - 0xA1) * CHARSET_EUCKR_ROWS + (p[1] - 0xA1)];
+            if (*ucs == 0) {
+                *ucs = CHARSET_INVALID;
+            }
+            return 2;
+
+        default: {
+            const charset_utf8_lead_t *lead = &charset_utf8_lead[c];
+            if (lead->len == 0) {
+                *ucs = CHARSET_INVALID;
+                return 1;
+            }
+
+            uint32_t value = c & (0x7F >> lead->len);
+            for (size_t i = 1; i < lead->len; i++) {
+                if (i >= len) {
+                    return 0;
+                }
+                unsigned char lo = (i == 1) ? lead->lo : 0x80;
+                unsigned char hi = (i == 1) ? lead->hi : 0xBF;
+                if (p[i] < lo || p[i] > hi) {
+                    /* The valid prefix is one bad character; p[i] starts the next */
+                    *ucs = CHARSET_INVALID;
+                    return i;
+                }
+                value = (value << 6) | (p[i] & 0x3F);
+            }
+            *ucs = value;
+            return lead->len;
+        }
+    }
+}
+
+/**
+ * Encode one character and append it to the output
+ */
+static size_t charset_put(charset_conv_t *conv, uint32_t ucs,
+                          unsigned char *out, size_t out_pos, size_t out_size)
+{
+    unsigned char code[4];
+    size_t n;
+
+    if (conv->to == CHARSET_UTF8) {
+        if (ucs == CHARSET_INVALID) {
+            ucs = CHARSET_REPLACEMENT;
+            conv->replaced++;
+        }
+        if (ucs < 0x80) {
+            code[0] = (unsigned char)ucs;
+            n = 1;
+        } else if (ucs < 0x800) {
+            code[0] = (unsigned char)(0xC0 | (ucs >> 6));
+            code[1] = (unsigned char)(0x80 | (ucs & 0x3F));
+            n = 2;
+        } else if (ucs < 0x10000) {
+            code[0] = (unsigned char)(0xE0 | (ucs >> 12));
+            code[1] = (unsigned char)(0x80 | ((ucs >> 6) & 0x3F));
+            code[2] = (unsigned char)(0x80 | (ucs & 0x3F));
+            n = 3;
+        } else {
+            code[0] = (unsigned char)(0xF0 | (ucs >> 18));
+            code[1] = (unsigned char)(0x80 | ((ucs >> 12) & 0x3F));
+            code[2] = (unsigned char)(0x80 | ((ucs >> 6) & 0x3F));
+            code[3] = (unsigned char)(0x80 | (ucs & 0x3F));
+            n = 4;
+        }
+    } else {
+        uint16_t legacy = 0;
+        if (ucs < 0x80) {
+            legacy = (uint16_t)ucs;
+        } else if (ucs < 0x10000 && charset_reverse[conv->to][ucs >> 8] != NULL) {
+            legacy = charset_reverse[conv->to][ucs >> 8][ucs & 0xFF];
+        }
+
+        if (legacy == 0 && ucs != 0) {
+            code[0] = '?';
+            n = 1;
+            conv->replaced++;
+        } else if (legacy > 0xFF) {
+            code[0] = (unsigned char)(legacy >> 8);
+            code[1] = (unsigned char)(legacy & 0xFF);
+            n = 2;
+        } else {
+            code[0] = (unsigned char)legacy;
+            n = 1;
+        }
+    }
+
+    if (n > out_size - out_pos) {
+        return out_pos;     /* No room: dropped */
+    }
+    memcpy(out + out_pos, code, n);
+    return out_pos + n;
+}
+
+/**
+ * Parse a character set name
+ */
+int charset_parse(const char *name, charset_t *charset)
+{
+    if (name == NULL || charset == NULL) {
+        return ERROR_INVALID_ARG;
+    }
+
+    /* Compare ignoring case and '-' / '_' ("utf8", "EUC_KR", ...) */
+    for (int cs = 0; cs < CHARSET_COUNT; cs++) {
+        const char *a = name;
+        const char *b = charset_names[cs];
+        for (;;) {
+            while (*a == '-' || *a == '_') {
+                a++;
+            }
+            while (*b == '-') {
+                b++;
+            }
+            if (*a == '\0' || *b == '\0' || toupper((unsigned char)*a) != *b) {
+                break;
+            }
+            a++;
+            b++;
+        }
+        if (*a == '\0' && *b == '\0') {
+            *charset = (charset_t)cs;
+            return SUCCESS;
+        }
+    }
+
+    return ERROR_INVALID_ARG;
+}
+
+/**
+ * Name of a character set
+ */
+const char *charset_name(charset_t charset)
+{
+    if (charset < 0 || charset >= CHARSET_COUNT) {
+        return "UNKNOWN";
+    }
+    return charset_names[charset];
+}
+
+/**
+ * Initialize a converter
+ */
+void charset_conv_init(charset_conv_t *conv, charset_t from, charset_t to)
+{
+    if (conv == NULL) {
+        return;
+    }
+
+    memset(conv, 0, sizeof(charset_conv_t));
+    conv->from = from;
+    conv->to = to;
+
+    if (from != to) {
+        pthread_once(&charset_reverse_once, charset_reverse_build);
+    }
+}
+
+/**
+ * Drop an incomplete sequence left from a previous session
+ */
+void charset_conv_reset(charset_conv_t *conv)
+{
+    if (conv != NULL) {
+        conv->pending_len = 0;
+    }
+}
+
+/**
+ * Check whether a converter changes the data
+ */
+bool charset_conv_active(const charset_conv_t *conv)
+{
+    return conv != NULL && conv->from != conv->to;
+}
+
+/**
+ * Output bytes per input byte at most
+ */
+static size_t charset_expansion(charset_t to)
+{
+    switch (to) {
+        case CHARSET_UTF8:
+            return 3;   /* One-byte code (or a bad byte) to U+0800..U+FFFF */
+        case CHARSET_EUCKR:
+            return 2;
+        default:
+            return 1;
+    }
+}
+
+/**
+ * Largest output for len input bytes
+ */
+size_t charset_conv_bound(const charset_conv_t *conv, size_t len)
+{
+    /* Every character takes at least one input byte */
+    return (len + conv->pending_len) * charset_expansion(conv->to);
+}
+
+/**
+ * Most input whose output is sure to fit in out_size
+ */
+size_t charset_conv_fit(const charset_conv_t *conv, size_t out_size)
+{
+    size_t chars = out_size / charset_expansion(conv->to);
+
+    return chars > conv->pending_len ? chars - conv->pending_len : 0;
+}
+
+/**
+ * Convert one chunk
+ */
+size_t charset_convert(charset_conv_t *conv, const unsigned char *in, size_t len,
+                       unsigned char *out, size_t out_size)
+{
+    size_t i = 0;
+    size_t o = 0;
+    uint32_t ucs;
+
+    if (conv == NULL || in == NULL || out == NULL) {
+        return 0;
+    }
+
+    /* Finish the sequence the last chunk ended in */
+    if (conv->pending_len > 0) {
+        unsigned char seq[CHARSET_MAX_PENDING + 1];
+        size_t have = conv->pending_len;
+        size_t used;
+
+        memcpy(seq, conv->pending, have);
+        while ((used = charset_decode(conv->from, seq, have, &ucs)) == 0 && i < len) {
+            seq[have++] = in[i++];
+        }
+        if (used == 0) {
+            memcpy(conv->pending, seq, have);
+            conv->pending_len = have;
+            return 0;
+        }
+
+        /* A bad sequence may end before the bytes taken from this chunk */
+        i -= have - used;
+        conv->pending_len = 0;
+        o = charset_put(conv, ucs, out, o, out_size);
+    }
+
+    while (i < len) {
+        size_t run = charset_ascii_run(in + i, len - i);
+        if (run > 0) {
+            size_t n = MIN(run, out_size - o);
+            memcpy(out + o, in + i, n);
+            o += n;
+            i += run;
+            continue;
+        }
+
+        size_t used = charset_decode(conv->from, in + i, len - i, &ucs);
+        if (used == 0) {
+            /* Cut by the end of the chunk: wait for the rest */
+            conv->pending_len = len - i;
+            memcpy(conv->pending, in + i, conv->pending_len);
+            break;
+        }
+        i += used;
+        o = charset_put(conv, ucs, out, o, out_size);
+    }
+
+    return o;
+}
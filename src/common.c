@@ -15,6 +15,12 @@ volatile sig_atomic_t g_reload_config = 0;
  */
 void hexdump(const char *label, const void *data, size_t len)
 {
+#ifndef DEBUG
+    /* Output goes through MB_LOG_DEBUG only; skip the formatting entirely */
+    (void)label;
+    (void)data;
+    (void)len;
+#else
     const unsigned char *bytes = (const unsigned char *)data;
     size_t i, j;
 
@@ -35,6 +41,7 @@ void hexdump(const char *label, const void *data, size_t len)
         sprintf(line_buf, "%08zx  %-48s  %s", i, hex_buf, ascii_buf);
         MB_LOG_DEBUG("%s", line_buf);
     }
+#endif
 }
 
 /**
@@ -3,6 +3,11 @@
  */
 
 #include "config.h"
+#include "bufpool.h"
+#include "trace.h"
+#include "metrics.h"
+#include "rtsched.h"
+#include "serial.h"
 #include <strings.h>
 
 /* Baudrate mapping table */
@@ -42,7 +47,12 @@ void config_init(config_t *cfg)
     cfg->data_bits = 8;
     cfg->stop_bits = 1;
     cfg->flow_control = FLOW_RTSCTS;
+    cfg->serial_low_latency = true;
+    cfg->serial_latency_timer = SERIAL_LATENCY_TIMER_DEFAULT;
+    cfg->serial_rx_profile = RX_PROFILE_AUTO;
     cfg->modem_init_command[0] = '\0';
+    cfg->modem_init_script.count = 0;
+    cfg->modem_init_timeout_ms = 2000;      /* Longer than ATZ takes on real modems */
     cfg->modem_autoanswer_mode = 0;  /* Default: SOFTWARE mode (S0=0, manual ATA) */
     cfg->modem_autoanswer_software_command[0] = '\0';
     cfg->modem_autoanswer_hardware_command[0] = '\0';
@@ -51,15 +61,49 @@ void config_init(config_t *cfg)
     /* Default telnet settings */
     SAFE_STRNCPY(cfg->telnet_host, "127.0.0.1", sizeof(cfg->telnet_host));
     cfg->telnet_port = 23;
+    cfg->dns_cache_ttl = 60;                /* DEFAULT_DNS_CACHE_TTL */
+    cfg->preconnect_on_ring = false;
+    cfg->telnet_compress = true;
+    cfg->telnet_fast_start = true;
+    cfg->telnet_raw = false;
+    cfg->terminal_charset = CHARSET_UTF8;   /* Same on both sides: no transcoding */
+    cfg->server_charset = CHARSET_UTF8;
+    cfg->xfer_fastpath = true;
+    cfg->xfer_telnet_binary = false;
+    cfg->splice_passthrough = false;
+    cfg->connect_timeout_ms = 5000;         /* Fail over well before the kernel gives up (~2 min) */
+    cfg->dial_default[0] = '\0';
 
     /* Default runtime options */
     cfg->daemon_mode = false;
     SAFE_STRNCPY(cfg->pid_file, DEFAULT_PID_FILE, sizeof(cfg->pid_file));
     cfg->log_level = LOG_INFO;
+    cfg->event_loop = false;                /* Classic per-direction polling threads */
+    cfg->health_check = false;              /* Startup health check off */
+    cfg->health_check_timeout_ms = 5000;
+    cfg->buffer_size = 0;                   /* Auto: sized from the DTE rate */
+    cfg->trace_enabled = false;
+    SAFE_STRNCPY(cfg->trace_file, DEFAULT_TRACE_FILE, sizeof(cfg->trace_file));
+    cfg->metrics_shm[0] = '\0';
+    SAFE_STRNCPY(cfg->metrics_address, DEFAULT_METRICS_ADDRESS, sizeof(cfg->metrics_address));
+    cfg->metrics_port = 0;
+
+    /* Default thread placement: any CPU, normal scheduling */
+    cfg->cpu_affinity_serial[0] = '\0';
+    cfg->cpu_affinity_telnet[0] = '\0';
+    cfg->cpu_affinity_level3[0] = '\0';
+    cfg->cpu_affinity_workers[0] = '\0';
+    cfg->serial_sched_policy = SCHED_OTHER;
+    cfg->serial_sched_priority = 0;
+    cfg->memlock = false;
 
     /* Default data logging options */
     cfg->data_log_enabled = false;
     SAFE_STRNCPY(cfg->data_log_file, DEFAULT_DATALOG_FILE, sizeof(cfg->data_log_file));
+    cfg->data_log_format = DATALOG_FORMAT_TEXT;
+    cfg->data_log_flush = DATALOG_FLUSH_TIME;   /* Batched, off the I/O threads */
+    cfg->data_log_flush_ms = DATALOG_DEFAULT_FLUSH_MS;
+    cfg->data_log_flush_bytes = DATALOG_DEFAULT_FLUSH_BYTES;
 
     /* Default echo functionality options (Level 1) */
     cfg->echo_enabled = false;              /* Disabled by default for easy on/off */
@@ -68,15 +112,41 @@ void config_init(config_t *cfg)
     cfg->echo_min_interval = 2;             /* Minimum 2 seconds between echoes */
     SAFE_STRNCPY(cfg->echo_prefix, "[from server]", sizeof(cfg->echo_prefix));
 
+    /* Default multi-line options (single line unless [line.N] sections exist) */
+    cfg->line_id = 0;
+    cfg->line_workers = 0;                  /* Auto: sized from line count and CPUs */
+    cfg->line_count = 0;
+    cfg->lines = NULL;
+
+    /* No dialing directory: every call goes to TELNET_HOST */
+    cfg->dial_count = 0;
+    cfg->dial = NULL;
+
     MB_LOG_DEBUG("Configuration initialized with defaults");
 }
 
 /**
- * Parse a single line from config file
+ * Store a CPU list setting, or clear it (any CPU) if it does not parse
  */
-static int parse_config_line(config_t *cfg, char *line)
+static void config_parse_cpu_list(const char *key, const char *value, char *dest, size_t size)
 {
-    char *key, *value, *equals;
+    cpu_set_t cpus;
+
+    if (rtsched_parse_cpus(value, &cpus) != SUCCESS || strlen(value) >= size) {
+        MB_LOG_WARNING("Invalid %s: %s (CPU list like 2 or 0-1,3), using any CPU", key, value);
+        dest[0] = '\0';
+        return;
+    }
+    SAFE_STRNCPY(dest, value, size);
+}
+
+/**
+ * Split a "KEY = value" line, dropping the comment, whitespace and quotes
+ * @return 1 with key and value set, 0 for a blank line, ERROR_CONFIG without '='
+ */
+static int config_split_line(char *line, char **key, char **value)
+{
+    char *equals;
 
     /* Remove comments */
     char *comment = strchr(line, '#');
@@ -89,7 +159,7 @@ static int parse_config_line(config_t *cfg, char *line)
 
     /* Skip empty lines */
     if (strlen(line) == 0) {
-        return SUCCESS;
+        return 0;
     }
 
     /* Find equals sign */
@@ -101,16 +171,31 @@ static int parse_config_line(config_t *cfg, char *line)
 
     /* Split into key and value */
     *equals = '\0';
-    key = trim_whitespace(line);
-    value = trim_whitespace(equals + 1);
+    *key = trim_whitespace(line);
+    *value = trim_whitespace(equals + 1);
 
     /* Remove quotes from value */
-    if (value[0] == '"' && value[strlen(value) - 1] == '"') {
-        value[strlen(value) - 1] = '\0';
-        value++;
+    size_t len = strlen(*value);
+    if (len >= 2 && (*value)[0] == '"' && (*value)[len - 1] == '"') {
+        (*value)[len - 1] = '\0';
+        (*value)++;
     }
 
-    MB_LOG_DEBUG("Config: %s = %s", key, value);
+    MB_LOG_DEBUG("Config: %s = %s", *key, *value);
+    return 1;
+}
+
+/**
+ * Parse a single line from config file
+ */
+static int parse_config_line(config_t *cfg, char *line)
+{
+    char *key, *value;
+
+    int split = config_split_line(line, &key, &value);
+    if (split <= 0) {
+        return split == 0 ? SUCCESS : split;
+    }
 
     /* Parse key-value pairs */
     if (strcasecmp(key, "SERIAL_PORT") == 0 || strcasecmp(key, "COMPORT") == 0) {
@@ -146,9 +231,36 @@ static int parse_config_line(config_t *cfg, char *line)
     else if (strcasecmp(key, "FLOW") == 0) {
         cfg->flow_control = config_str_to_flow(value);
     }
+    else if (strcasecmp(key, "SERIAL_LOW_LATENCY") == 0) {
+        cfg->serial_low_latency = (atoi(value) != 0);
+    }
+    else if (strcasecmp(key, "SERIAL_LATENCY_TIMER") == 0) {
+        cfg->serial_latency_timer = atoi(value);
+        if (cfg->serial_latency_timer < 0 || cfg->serial_latency_timer > 255) {
+            MB_LOG_WARNING("Invalid SERIAL_LATENCY_TIMER: %d (0-255 ms), using %d",
+                          cfg->serial_latency_timer, SERIAL_LATENCY_TIMER_DEFAULT);
+            cfg->serial_latency_timer = SERIAL_LATENCY_TIMER_DEFAULT;
+        }
+    }
+    else if (strcasecmp(key, "SERIAL_RX_PROFILE") == 0) {
+        if (serial_parse_rx_profile(value, &cfg->serial_rx_profile) != SUCCESS) {
+            MB_LOG_WARNING("Invalid SERIAL_RX_PROFILE: %s (must be auto, low, medium or high), using auto", value);
+            cfg->serial_rx_profile = RX_PROFILE_AUTO;
+        }
+    }
     else if (strcasecmp(key, "MODEM_INIT_COMMAND") == 0) {
         SAFE_STRNCPY(cfg->modem_init_command, value, sizeof(cfg->modem_init_command));
-        MB_LOG_DEBUG("Modem init command configured: %s", cfg->modem_init_command);
+        config_parse_modem_script(&cfg->modem_init_script, cfg->modem_init_command);
+        MB_LOG_DEBUG("Modem init command configured: %s (%d commands)",
+                    cfg->modem_init_command, cfg->modem_init_script.count);
+    }
+    else if (strcasecmp(key, "MODEM_INIT_TIMEOUT") == 0) {
+        cfg->modem_init_timeout_ms = atoi(value);
+        if (cfg->modem_init_timeout_ms < 100 || cfg->modem_init_timeout_ms > 60000) {
+            MB_LOG_WARNING("Invalid MODEM_INIT_TIMEOUT: %d (100-60000 ms), using 2000",
+                          cfg->modem_init_timeout_ms);
+            cfg->modem_init_timeout_ms = 2000;
+        }
     }
     else if (strcasecmp(key, "MODEM_AUTOANSWER_MODE") == 0) {
         cfg->modem_autoanswer_mode = atoi(value);
@@ -176,6 +288,7 @@ static int parse_config_line(config_t *cfg, char *line)
     /* Backward compatibility: MODEM_COMMAND maps to MODEM_INIT_COMMAND */
     else if (strcasecmp(key, "MODEM_COMMAND") == 0) {
         SAFE_STRNCPY(cfg->modem_init_command, value, sizeof(cfg->modem_init_command));
+        config_parse_modem_script(&cfg->modem_init_script, cfg->modem_init_command);
         MB_LOG_WARNING("MODEM_COMMAND is deprecated, use MODEM_INIT_COMMAND instead");
     }
     /* New health check commands */
@@ -189,12 +302,178 @@ static int parse_config_line(config_t *cfg, char *line)
     else if (strcasecmp(key, "TELNET_PORT") == 0) {
         cfg->telnet_port = atoi(value);
     }
+    else if (strcasecmp(key, "DNS_CACHE_TTL") == 0) {
+        cfg->dns_cache_ttl = atoi(value);
+        if (cfg->dns_cache_ttl < 0) {
+            MB_LOG_WARNING("Invalid DNS_CACHE_TTL: %d, DNS cache disabled", cfg->dns_cache_ttl);
+            cfg->dns_cache_ttl = 0;
+        }
+    }
+    else if (strcasecmp(key, "PRECONNECT_ON_RING") == 0) {
+        cfg->preconnect_on_ring = (atoi(value) != 0);
+    }
+    else if (strcasecmp(key, "TELNET_COMPRESS") == 0) {
+        cfg->telnet_compress = (atoi(value) != 0);
+    }
+    else if (strcasecmp(key, "TELNET_RAW") == 0) {
+        cfg->telnet_raw = (atoi(value) != 0);
+    }
+    else if (strcasecmp(key, "TELNET_FAST_START") == 0) {
+        cfg->telnet_fast_start = (atoi(value) != 0);
+    }
+    else if (strcasecmp(key, "TERMINAL_CHARSET") == 0) {
+        if (charset_parse(value, &cfg->terminal_charset) != SUCCESS) {
+            MB_LOG_WARNING("Invalid TERMINAL_CHARSET: %s (must be UTF-8, CP437 or EUC-KR), using UTF-8", value);
+            cfg->terminal_charset = CHARSET_UTF8;
+        }
+    }
+    else if (strcasecmp(key, "SERVER_CHARSET") == 0) {
+        if (charset_parse(value, &cfg->server_charset) != SUCCESS) {
+            MB_LOG_WARNING("Invalid SERVER_CHARSET: %s (must be UTF-8, CP437 or EUC-KR), using UTF-8", value);
+            cfg->server_charset = CHARSET_UTF8;
+        }
+    }
+    else if (strcasecmp(key, "XFER_FASTPATH") == 0) {
+        cfg->xfer_fastpath = (atoi(value) != 0);
+    }
+    else if (strcasecmp(key, "XFER_TELNET_BINARY") == 0) {
+        cfg->xfer_telnet_binary = (atoi(value) != 0);
+    }
+    else if (strcasecmp(key, "SPLICE_PASSTHROUGH") == 0) {
+        cfg->splice_passthrough = (atoi(value) != 0);
+    }
+    else if (strcasecmp(key, "TELNET_CONNECT_TIMEOUT") == 0) {
+        cfg->connect_timeout_ms = atoi(value);
+        if (cfg->connect_timeout_ms != 0 &&
+            (cfg->connect_timeout_ms < 500 || cfg->connect_timeout_ms > 120000)) {
+            MB_LOG_WARNING("Invalid TELNET_CONNECT_TIMEOUT: %d (0 or 500-120000 ms), using 5000",
+                          cfg->connect_timeout_ms);
+            cfg->connect_timeout_ms = 5000;
+        }
+    }
+    else if (strcasecmp(key, "DIAL_DEFAULT") == 0) {
+        if (strlen(value) >= sizeof(cfg->dial_default)) {
+            MB_LOG_WARNING("DIAL_DEFAULT name too long: %s, using TELNET_HOST", value);
+            cfg->dial_default[0] = '\0';
+        } else {
+            SAFE_STRNCPY(cfg->dial_default, value, sizeof(cfg->dial_default));
+        }
+    }
+    else if (strcasecmp(key, "EVENT_LOOP") == 0) {
+        cfg->event_loop = (atoi(value) != 0);
+    }
+    else if (strcasecmp(key, "HEALTH_CHECK") == 0) {
+        cfg->health_check = (atoi(value) != 0);
+    }
+    else if (strcasecmp(key, "HEALTH_CHECK_TIMEOUT") == 0) {
+        cfg->health_check_timeout_ms = atoi(value);
+        if (cfg->health_check_timeout_ms < 500 || cfg->health_check_timeout_ms > 60000) {
+            MB_LOG_WARNING("Invalid HEALTH_CHECK_TIMEOUT: %d (500-60000 ms), using 5000",
+                          cfg->health_check_timeout_ms);
+            cfg->health_check_timeout_ms = 5000;
+        }
+    }
+    else if (strcasecmp(key, "BUFFER_SIZE") == 0) {
+        cfg->buffer_size = atoi(value);
+        if (cfg->buffer_size != 0 &&
+            (cfg->buffer_size < BUFPOOL_MIN_SIZE || cfg->buffer_size > BUFPOOL_MAX_SIZE)) {
+            MB_LOG_WARNING("Invalid BUFFER_SIZE: %d (0 or %d-%d), using 0 (auto)",
+                          cfg->buffer_size, BUFPOOL_MIN_SIZE, BUFPOOL_MAX_SIZE);
+            cfg->buffer_size = 0;
+        }
+    }
+    else if (strcasecmp(key, "TRACE_ENABLED") == 0) {
+        cfg->trace_enabled = (atoi(value) != 0);
+    }
+    else if (strcasecmp(key, "TRACE_FILE") == 0) {
+        SAFE_STRNCPY(cfg->trace_file, value, sizeof(cfg->trace_file));
+    }
+    else if (strcasecmp(key, "METRICS_SHM") == 0) {
+        SAFE_STRNCPY(cfg->metrics_shm, value, sizeof(cfg->metrics_shm));
+    }
+    else if (strcasecmp(key, "METRICS_ADDRESS") == 0) {
+        SAFE_STRNCPY(cfg->metrics_address, value, sizeof(cfg->metrics_address));
+    }
+    else if (strcasecmp(key, "METRICS_PORT") == 0) {
+        cfg->metrics_port = atoi(value);
+        if (cfg->metrics_port < 0 || cfg->metrics_port > 65535) {
+            MB_LOG_WARNING("Invalid METRICS_PORT: %d, metrics endpoint disabled", cfg->metrics_port);
+            cfg->metrics_port = 0;
+        }
+    }
+    else if (strcasecmp(key, "CPU_AFFINITY_SERIAL") == 0) {
+        config_parse_cpu_list(key, value, cfg->cpu_affinity_serial, sizeof(cfg->cpu_affinity_serial));
+    }
+    else if (strcasecmp(key, "CPU_AFFINITY_TELNET") == 0) {
+        config_parse_cpu_list(key, value, cfg->cpu_affinity_telnet, sizeof(cfg->cpu_affinity_telnet));
+    }
+    else if (strcasecmp(key, "CPU_AFFINITY_LEVEL3") == 0) {
+        config_parse_cpu_list(key, value, cfg->cpu_affinity_level3, sizeof(cfg->cpu_affinity_level3));
+    }
+    else if (strcasecmp(key, "CPU_AFFINITY_WORKERS") == 0) {
+        if (cfg->line_id != 0) {
+            MB_LOG_WARNING("CPU_AFFINITY_WORKERS is only valid in the global section, ignored in [line.%d]",
+                          cfg->line_id);
+        } else {
+            config_parse_cpu_list(key, value, cfg->cpu_affinity_workers, sizeof(cfg->cpu_affinity_workers));
+        }
+    }
+    else if (strcasecmp(key, "SERIAL_SCHED_POLICY") == 0) {
+        if (rtsched_parse_policy(value, &cfg->serial_sched_policy) != SUCCESS) {
+            MB_LOG_WARNING("Invalid SERIAL_SCHED_POLICY: %s (must be OTHER, FIFO or RR), using OTHER", value);
+            cfg->serial_sched_policy = SCHED_OTHER;
+        }
+    }
+    else if (strcasecmp(key, "SERIAL_SCHED_PRIORITY") == 0) {
+        cfg->serial_sched_priority = atoi(value);
+        if (cfg->serial_sched_priority < 1 || cfg->serial_sched_priority > 99) {
+            MB_LOG_WARNING("Invalid SERIAL_SCHED_PRIORITY: %d (1-99), using %d",
+                          cfg->serial_sched_priority, RTSCHED_DEFAULT_PRIORITY);
+            cfg->serial_sched_priority = RTSCHED_DEFAULT_PRIORITY;
+        }
+    }
+    else if (strcasecmp(key, "MEMLOCK") == 0) {
+        if (cfg->line_id != 0) {
+            MB_LOG_WARNING("MEMLOCK is only valid in the global section, ignored in [line.%d]",
+                          cfg->line_id);
+        } else {
+            cfg->memlock = (atoi(value) != 0);
+        }
+    }
     else if (strcasecmp(key, "DATA_LOG_ENABLED") == 0) {
         cfg->data_log_enabled = (atoi(value) != 0);
     }
     else if (strcasecmp(key, "DATA_LOG_FILE") == 0) {
         SAFE_STRNCPY(cfg->data_log_file, value, sizeof(cfg->data_log_file));
     }
+    else if (strcasecmp(key, "DATA_LOG_FORMAT") == 0) {
+        if (datalog_parse_format(value, &cfg->data_log_format) != SUCCESS) {
+            MB_LOG_WARNING("Invalid DATA_LOG_FORMAT: %s (must be text or binary), using text", value);
+            cfg->data_log_format = DATALOG_FORMAT_TEXT;
+        }
+    }
+    else if (strcasecmp(key, "DATA_LOG_FLUSH") == 0) {
+        if (datalog_parse_flush(value, &cfg->data_log_flush) != SUCCESS) {
+            MB_LOG_WARNING("Invalid DATA_LOG_FLUSH: %s (must be record, time or size), using time", value);
+            cfg->data_log_flush = DATALOG_FLUSH_TIME;
+        }
+    }
+    else if (strcasecmp(key, "DATA_LOG_FLUSH_MS") == 0) {
+        cfg->data_log_flush_ms = atoi(value);
+        if (cfg->data_log_flush_ms <= 0) {
+            MB_LOG_WARNING("Invalid DATA_LOG_FLUSH_MS: %d, using %d",
+                          cfg->data_log_flush_ms, DATALOG_DEFAULT_FLUSH_MS);
+            cfg->data_log_flush_ms = DATALOG_DEFAULT_FLUSH_MS;
+        }
+    }
+    else if (strcasecmp(key, "DATA_LOG_FLUSH_BYTES") == 0) {
+        cfg->data_log_flush_bytes = atoi(value);
+        if (cfg->data_log_flush_bytes <= 0 || cfg->data_log_flush_bytes > DATALOG_OUT_BUFFER) {
+            MB_LOG_WARNING("Invalid DATA_LOG_FLUSH_BYTES: %d (1-%d), using %d",
+                          cfg->data_log_flush_bytes, DATALOG_OUT_BUFFER, DATALOG_DEFAULT_FLUSH_BYTES);
+            cfg->data_log_flush_bytes = DATALOG_DEFAULT_FLUSH_BYTES;
+        }
+    }
     /* Echo functionality options (Level 1) */
     else if (strcasecmp(key, "ECHO_ENABLED") == 0) {
         cfg->echo_enabled = (atoi(value) != 0);
@@ -224,6 +503,19 @@ static int parse_config_line(config_t *cfg, char *line)
         SAFE_STRNCPY(cfg->echo_prefix, value, sizeof(cfg->echo_prefix));
         MB_LOG_DEBUG("Echo prefix: '%s'", cfg->echo_prefix);
     }
+    /* Multi-line mode options (global section only) */
+    else if (strcasecmp(key, "LINE_WORKERS") == 0) {
+        if (cfg->line_id != 0) {
+            MB_LOG_WARNING("LINE_WORKERS is only valid in the global section, ignored in [line.%d]",
+                          cfg->line_id);
+        } else {
+            cfg->line_workers = atoi(value);
+            if (cfg->line_workers < 0) {
+                MB_LOG_WARNING("Invalid LINE_WORKERS: %d, using 0 (auto)", cfg->line_workers);
+                cfg->line_workers = 0;
+            }
+        }
+    }
     else {
         MB_LOG_WARNING("Unknown config key: %s", key);
     }
@@ -231,6 +523,233 @@ static int parse_config_line(config_t *cfg, char *line)
     return SUCCESS;
 }
 
+/**
+ * Parse a BACKEND value: "host:port [weight]" ("[2001:db8::1]:23" for IPv6)
+ */
+static int config_parse_backend(const char *value, dial_backend_config_t *backend)
+{
+    char buf[SMALL_BUFFER_SIZE];
+
+    size_t len = strlen(value);
+    if (len >= sizeof(buf)) {
+        return ERROR_CONFIG;
+    }
+    memcpy(buf, value, len + 1);
+
+    /* Optional weight after the address */
+    char *weight = buf + strcspn(buf, " \t");
+    if (*weight != '\0') {
+        *weight++ = '\0';
+        weight = trim_whitespace(weight);
+    }
+
+    char *host = buf;
+    char *colon;
+    if (*host == '[') {
+        char *close = strchr(host, ']');
+        if (close == NULL || close[1] != ':') {
+            return ERROR_CONFIG;
+        }
+        *close = '\0';
+        host++;
+        colon = close + 1;
+    } else {
+        colon = strchr(host, ':');
+        if (colon == NULL || strrchr(host, ':') != colon) {
+            return ERROR_CONFIG;
+        }
+    }
+    *colon = '\0';
+
+    char *end;
+    long port = strtol(colon + 1, &end, 10);
+    if (*host == '\0' || end == colon + 1 || *end != '\0' || port <= 0 || port > 65535) {
+        return ERROR_CONFIG;
+    }
+
+    long w = 1;
+    if (*weight != '\0') {
+        w = strtol(weight, &end, 10);
+        if (end == weight || *end != '\0' || w < 1 || w > 100) {
+            return ERROR_CONFIG;
+        }
+    }
+
+    /* Shorter than buf, which is no larger than backend->host */
+    memcpy(backend->host, host, strlen(host) + 1);
+    backend->port = (int)port;
+    backend->weight = (int)w;
+    return SUCCESS;
+}
+
+/**
+ * Parse a line of a [dial.NAME] section
+ */
+static int parse_dial_line(dial_target_config_t *target, char *line)
+{
+    char *key, *value;
+
+    int split = config_split_line(line, &key, &value);
+    if (split <= 0) {
+        return split == 0 ? SUCCESS : split;
+    }
+
+    if (strcasecmp(key, "NUMBER") == 0) {
+        /* Repeated NUMBER lines add numbers */
+        size_t used = strlen(target->numbers);
+        if (used + strlen(value) + 2 > sizeof(target->numbers)) {
+            MB_LOG_WARNING("[dial.%s]: too many numbers, %s ignored", target->name, value);
+        } else {
+            snprintf(target->numbers + used, sizeof(target->numbers) - used, "%s%s",
+                     used > 0 ? "," : "", value);
+        }
+    }
+    else if (strcasecmp(key, "BACKEND") == 0) {
+        if (target->backend_count >= CONFIG_MAX_BACKENDS) {
+            MB_LOG_WARNING("[dial.%s]: too many backends (max %d), %s ignored",
+                          target->name, CONFIG_MAX_BACKENDS, value);
+        } else if (config_parse_backend(value, &target->backends[target->backend_count]) != SUCCESS) {
+            MB_LOG_WARNING("[dial.%s]: invalid BACKEND %s (host:port [weight 1-100]), ignored",
+                          target->name, value);
+        } else {
+            target->backend_count++;
+        }
+    }
+    else if (strcasecmp(key, "POLICY") == 0) {
+        if (strcasecmp(value, "least_conn") == 0 || strcasecmp(value, "least_connections") == 0) {
+            target->policy = DIAL_POLICY_LEAST_CONN;
+        } else if (strcasecmp(value, "weighted") == 0) {
+            target->policy = DIAL_POLICY_WEIGHTED;
+        } else {
+            MB_LOG_WARNING("[dial.%s]: invalid POLICY %s (least_conn or weighted), using least_conn",
+                          target->name, value);
+            target->policy = DIAL_POLICY_LEAST_CONN;
+        }
+    }
+    else {
+        MB_LOG_WARNING("Unknown key in [dial.%s]: %s", target->name, key);
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * Handle a [dial.NAME] section header
+ * Returns the target that following keys apply to, or NULL to skip them.
+ */
+static dial_target_config_t *config_select_dial(config_t *cfg, const char *name, int line_num)
+{
+    if (name[0] == '\0' || strlen(name) >= CONFIG_DIAL_NAME_SIZE || strpbrk(name, " \t,") != NULL) {
+        MB_LOG_WARNING("Invalid dial target name in [dial.%s] at line %d, keys ignored", name, line_num);
+        return NULL;
+    }
+
+    /* Re-opening an existing section continues it */
+    for (int i = 0; i < cfg->dial_count; i++) {
+        if (strcasecmp(cfg->dial[i].name, name) == 0) {
+            return &cfg->dial[i];
+        }
+    }
+
+    if (cfg->dial_count >= CONFIG_MAX_DIAL_TARGETS) {
+        MB_LOG_WARNING("Too many [dial.NAME] sections (max %d), [dial.%s] ignored",
+                      CONFIG_MAX_DIAL_TARGETS, name);
+        return NULL;
+    }
+
+    dial_target_config_t *dial = realloc(cfg->dial, (cfg->dial_count + 1) * sizeof(*dial));
+    if (dial == NULL) {
+        MB_LOG_ERROR("Out of memory allocating [dial.%s]", name);
+        return NULL;
+    }
+    cfg->dial = dial;
+
+    dial_target_config_t *target = &cfg->dial[cfg->dial_count++];
+    memset(target, 0, sizeof(*target));
+    SAFE_STRNCPY(target->name, name, sizeof(target->name));
+    target->policy = DIAL_POLICY_LEAST_CONN;
+
+    MB_LOG_DEBUG("Config: entering section [dial.%s]", name);
+    return target;
+}
+
+/**
+ * Handle a section header line ("[line.N]" or "[dial.NAME]")
+ * Returns the configuration that following keys apply to, or NULL to skip them
+ * or for a dial section, which is returned in *dial instead.
+ * A new line starts as a copy of the global keys read so far.
+ */
+static config_t *config_select_section(config_t *cfg, char *header, int line_num,
+                                       dial_target_config_t **dial)
+{
+    *dial = NULL;
+
+    char *comment = strchr(header, '#');
+    if (comment) {
+        *comment = '\0';
+    }
+    header = trim_whitespace(header);
+
+    size_t len = strlen(header);
+    if (len < 2 || header[len - 1] != ']') {
+        MB_LOG_WARNING("Invalid section header at line %d: %s", line_num, header);
+        return NULL;
+    }
+    header[len - 1] = '\0';
+    char *name = trim_whitespace(header + 1);
+
+    if (strncasecmp(name, "dial.", 5) == 0) {
+        *dial = config_select_dial(cfg, name + 5, line_num);
+        return NULL;
+    }
+
+    if (strncasecmp(name, "line.", 5) != 0) {
+        MB_LOG_WARNING("Unknown section [%s] at line %d, keys ignored", name, line_num);
+        return NULL;
+    }
+
+    char *end;
+    long id = strtol(name + 5, &end, 10);
+    if (end == name + 5 || *end != '\0' || id <= 0 || id > 9999) {
+        MB_LOG_WARNING("Invalid line number in [%s] at line %d, keys ignored", name, line_num);
+        return NULL;
+    }
+
+    /* Re-opening an existing section continues it */
+    for (int i = 0; i < cfg->line_count; i++) {
+        if (cfg->lines[i].line_id == (int)id) {
+            return &cfg->lines[i];
+        }
+    }
+
+    if (cfg->line_count >= CONFIG_MAX_LINES) {
+        MB_LOG_WARNING("Too many [line.N] sections (max %d), [%s] ignored", CONFIG_MAX_LINES, name);
+        return NULL;
+    }
+
+    config_t *lines = realloc(cfg->lines, (cfg->line_count + 1) * sizeof(config_t));
+    if (lines == NULL) {
+        MB_LOG_ERROR("Out of memory allocating [%s]", name);
+        return NULL;
+    }
+    cfg->lines = lines;
+
+    config_t *line_cfg = &cfg->lines[cfg->line_count++];
+    memcpy(line_cfg, cfg, sizeof(config_t));
+    line_cfg->line_id = (int)id;
+    line_cfg->line_count = 0;
+    line_cfg->lines = NULL;
+    line_cfg->dial_count = 0;
+    line_cfg->dial = NULL;
+
+    /* Per-line data log by default, so lines never interleave in one file */
+    snprintf(line_cfg->data_log_file, sizeof(line_cfg->data_log_file),
+             "%.*s.line%d", (int)(sizeof(line_cfg->data_log_file) - 16), cfg->data_log_file, (int)id);
+
+    MB_LOG_DEBUG("Config: entering section [line.%d]", (int)id);
+    return line_cfg;
+}
+
 /**
  * Load configuration from file
  */
@@ -239,6 +758,9 @@ int config_load(config_t *cfg, const char *config_file)
     FILE *fp;
     char line[LINE_BUFFER_SIZE];
     int line_num = 0;
+    int section = -1;           /* Index into cfg->lines, -1 = global section */
+    int dial = -1;              /* Index into cfg->dial, -1 = not a dial section */
+    bool skip_section = false;  /* Inside an invalid/unknown section */
 
     if (cfg == NULL || config_file == NULL) {
         return ERROR_INVALID_ARG;
@@ -252,33 +774,76 @@ int config_load(config_t *cfg, const char *config_file)
         return ERROR_CONFIG;
     }
 
+    /* Reloading starts from empty line and dial tables */
+    free(cfg->lines);
+    cfg->lines = NULL;
+    cfg->line_count = 0;
+    free(cfg->dial);
+    cfg->dial = NULL;
+    cfg->dial_count = 0;
+
     while (fgets(line, sizeof(line), fp) != NULL) {
         line_num++;
 
         /* Remove newline */
         line[strcspn(line, "\r\n")] = '\0';
 
-        if (parse_config_line(cfg, line) != SUCCESS) {
+        /* Section header: subsequent keys apply to that line or dial target */
+        char *start = line + strspn(line, " \t");
+        if (*start == '[') {
+            dial_target_config_t *dial_target;
+            config_t *target = config_select_section(cfg, start, line_num, &dial_target);
+            skip_section = (target == NULL && dial_target == NULL);
+            section = target ? (int)(target - cfg->lines) : -1;
+            dial = dial_target ? (int)(dial_target - cfg->dial) : -1;
+            continue;
+        }
+
+        if (skip_section) {
+            continue;
+        }
+
+        if (dial >= 0) {
+            if (parse_dial_line(&cfg->dial[dial], line) != SUCCESS) {
+                MB_LOG_WARNING("Error parsing line %d: %s", line_num, line);
+            }
+            continue;
+        }
+
+        /* lines[] may move on realloc, so resolve the target each time */
+        config_t *target = (section >= 0) ? &cfg->lines[section] : cfg;
+        if (parse_config_line(target, line) != SUCCESS) {
             MB_LOG_WARNING("Error parsing line %d: %s", line_num, line);
         }
     }
 
     fclose(fp);
 
+    if (cfg->line_count > 0) {
+        MB_LOG_INFO("Multi-line mode: %d line(s) configured", cfg->line_count);
+    }
+    if (cfg->dial_count > 0) {
+        MB_LOG_INFO("Dialing directory: %d target(s) configured", cfg->dial_count);
+    }
+
     MB_LOG_INFO("Configuration loaded successfully");
 
     return SUCCESS;
 }
 
 /**
- * Validate configuration values
+ * Check whether configuration defines [line.N] sections
  */
-int config_validate(const config_t *cfg)
+bool config_is_multiline(const config_t *cfg)
 {
-    if (cfg == NULL) {
-        return ERROR_INVALID_ARG;
-    }
+    return cfg != NULL && cfg->line_count > 0;
+}
 
+/**
+ * Validate per-line (or single-line) settings
+ */
+static int config_validate_line(const config_t *cfg)
+{
     /* Validate serial port */
     if (strlen(cfg->serial_port) == 0) {
         MB_LOG_ERROR("Serial port not specified");
@@ -315,11 +880,131 @@ int config_validate(const config_t *cfg)
         return ERROR_CONFIG;
     }
 
+    return SUCCESS;
+}
+
+/**
+ * Find a dialing directory target by name
+ */
+static const dial_target_config_t *config_find_dial(const config_t *cfg, const char *name)
+{
+    for (int i = 0; i < cfg->dial_count; i++) {
+        if (strcasecmp(cfg->dial[i].name, name) == 0) {
+            return &cfg->dial[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Validate the dialing directory and the DIAL_DEFAULT of a line
+ */
+static int config_validate_dial(const config_t *cfg, const config_t *line)
+{
+    if (line->dial_default[0] != '\0' && config_find_dial(cfg, line->dial_default) == NULL) {
+        MB_LOG_ERROR("DIAL_DEFAULT names no [dial.%s] section", line->dial_default);
+        return ERROR_CONFIG;
+    }
+    return SUCCESS;
+}
+
+/**
+ * Validate configuration values
+ */
+int config_validate(const config_t *cfg)
+{
+    if (cfg == NULL) {
+        return ERROR_INVALID_ARG;
+    }
+
+    /* Every dialing directory target needs somewhere to connect */
+    for (int i = 0; i < cfg->dial_count; i++) {
+        if (cfg->dial[i].backend_count == 0) {
+            MB_LOG_ERROR("[dial.%s] has no valid BACKEND", cfg->dial[i].name);
+            return ERROR_CONFIG;
+        }
+    }
+    if (config_validate_dial(cfg, cfg) != SUCCESS) {
+        return ERROR_CONFIG;
+    }
+
+    if (cfg->line_count == 0) {
+        if (config_validate_line(cfg) != SUCCESS) {
+            return ERROR_CONFIG;
+        }
+    }
+
+    /* Multi-line mode: every line must be valid and own a distinct port */
+    for (int i = 0; i < cfg->line_count; i++) {
+        const config_t *line = &cfg->lines[i];
+
+        if (config_validate_line(line) != SUCCESS || config_validate_dial(cfg, line) != SUCCESS) {
+            MB_LOG_ERROR("Invalid settings in [line.%d]", line->line_id);
+            return ERROR_CONFIG;
+        }
+
+        for (int j = 0; j < i; j++) {
+            if (strcmp(cfg->lines[j].serial_port, line->serial_port) == 0) {
+                MB_LOG_ERROR("[line.%d] and [line.%d] use the same serial port %s",
+                            cfg->lines[j].line_id, line->line_id, line->serial_port);
+                return ERROR_CONFIG;
+            }
+        }
+    }
+
     MB_LOG_INFO("Configuration validated successfully");
 
     return SUCCESS;
 }
 
+/**
+ * Split a semicolon-separated command string into a modem script
+ */
+int config_parse_modem_script(modem_script_t *script, const char *commands)
+{
+    size_t used = 0;
+    int ret = SUCCESS;
+
+    if (script == NULL || commands == NULL) {
+        return ERROR_INVALID_ARG;
+    }
+
+    script->count = 0;
+
+    for (const char *p = commands; *p != '\0'; ) {
+        size_t len = strcspn(p, ";");
+        const char *next = p + len + (p[len] == ';');
+
+        /* Trim spaces around the command */
+        while (len > 0 && (*p == ' ' || *p == '\t')) {
+            p++;
+            len--;
+        }
+        while (len > 0 && (p[len - 1] == ' ' || p[len - 1] == '\t')) {
+            len--;
+        }
+
+        if (len > 0) {
+            bool has_at = (len >= 2 && strncasecmp(p, "AT", 2) == 0);
+            size_t need = len + (has_at ? 0 : 2) + 1;
+
+            if (script->count == CONFIG_MAX_INIT_STEPS || used + need > sizeof(script->text)) {
+                MB_LOG_WARNING("Modem init script too long, ignoring from: %s", p);
+                ret = ERROR_CONFIG;
+                break;
+            }
+
+            script->offset[script->count++] = (uint16_t)used;
+            snprintf(&script->text[used], need, "%s%.*s", has_at ? "" : "AT", (int)len, p);
+            used += need;
+        }
+
+        p = next;
+    }
+
+    return ret;
+}
+
 /**
  * Print configuration to log and stdout
  */
@@ -329,6 +1014,26 @@ void config_print(const config_t *cfg)
         return;
     }
 
+    /* Serial thread placement as requested (the effective one is in the stats) */
+    rtsched_spec_t spec;
+    char serial_sched[96];
+    rtsched_spec_from_config(cfg, RTSCHED_SERIAL, &spec);
+    if (spec.policy != SCHED_OTHER) {
+        snprintf(serial_sched, sizeof(serial_sched), "%s, %s %d",
+                 cfg->cpu_affinity_serial[0] ? cfg->cpu_affinity_serial : "any CPU",
+                 rtsched_policy_name(spec.policy), spec.priority);
+    } else {
+        snprintf(serial_sched, sizeof(serial_sched), "%s",
+                 cfg->cpu_affinity_serial[0] ? cfg->cpu_affinity_serial : "any CPU");
+    }
+
+    char latency_timer[16];
+    if (cfg->serial_latency_timer > 0) {
+        snprintf(latency_timer, sizeof(latency_timer), "%d ms", cfg->serial_latency_timer);
+    } else {
+        snprintf(latency_timer, sizeof(latency_timer), "unchanged");
+    }
+
     /* Print to stdout */
     printf("=== Configuration ===\n");
     printf("Serial Port:\n");
@@ -338,8 +1043,12 @@ void config_print(const config_t *cfg)
     printf("  Data bits:  %d\n", cfg->data_bits);
     printf("  Stop bits:  %d\n", cfg->stop_bits);
     printf("  Flow ctrl:  %s\n", config_flow_to_str(cfg->flow_control));
+    printf("  Latency:    %s, latency_timer %s, %s receive profile\n",
+           cfg->serial_low_latency ? "low-latency" : "driver default", latency_timer,
+           serial_rx_profile_name(cfg->serial_rx_profile));
     printf("Modem:\n");
     printf("  Init cmd:   %s\n", cfg->modem_init_command[0] ? cfg->modem_init_command : "(none)");
+    printf("  Init wait:  %d ms per command\n", cfg->modem_init_timeout_ms);
     printf("  AA mode:    %d (%s)\n", cfg->modem_autoanswer_mode,
            cfg->modem_autoanswer_mode == 0 ? "SOFTWARE" : "HARDWARE");
     printf("  AA SW cmd:  %s\n", cfg->modem_autoanswer_software_command[0] ? cfg->modem_autoanswer_software_command : "(none)");
@@ -347,15 +1056,81 @@ void config_print(const config_t *cfg)
     printf("Telnet:\n");
     printf("  Host:       %s\n", cfg->telnet_host);
     printf("  Port:       %d\n", cfg->telnet_port);
+    printf("  DNS cache:  %d s\n", cfg->dns_cache_ttl);
+    printf("  Pre-connect: %s\n", cfg->preconnect_on_ring ? "on RING" : "no");
+    printf("  Compress:   %s\n", cfg->telnet_compress ? "MCCP2 if offered" : "no");
+    printf("  Protocol:   %s\n", cfg->telnet_raw ? "raw TCP" :
+           cfg->telnet_fast_start ? "telnet (cached negotiation)" : "telnet");
+    if (cfg->terminal_charset != cfg->server_charset) {
+        printf("  Charset:    %s (terminal) <-> %s (server)\n",
+               charset_name(cfg->terminal_charset), charset_name(cfg->server_charset));
+    } else {
+        printf("  Charset:    %s (no transcoding)\n", charset_name(cfg->server_charset));
+    }
+    printf("  Transfers:  %s\n", !cfg->xfer_fastpath ? "filtered" :
+           cfg->xfer_telnet_binary ? "raw (also while binary)" : "raw");
+    printf("  Splice:     %s\n", cfg->splice_passthrough ? "when transparent" : "no");
+    if (cfg->connect_timeout_ms > 0) {
+        printf("  Connect:    %d ms per server\n", cfg->connect_timeout_ms);
+    } else {
+        printf("  Connect:    no time limit\n");
+    }
+    if (cfg->dial_count > 0) {
+        printf("Dialing Directory:\n");
+        printf("  Default:    %s\n", cfg->dial_default[0] ? cfg->dial_default : "(TELNET_HOST)");
+        for (int i = 0; i < cfg->dial_count; i++) {
+            const dial_target_config_t *dial = &cfg->dial[i];
+            printf("  [dial.%s]  %s -> %d backend(s), %s\n", dial->name,
+                   dial->numbers[0] ? dial->numbers : "(by name)", dial->backend_count,
+                   config_dial_policy_name(dial->policy));
+        }
+    }
+    printf("Event loop:   %s\n", cfg->event_loop ? "yes" : "no");
+    if (cfg->health_check) {
+        printf("Health check: on (%d ms limit)\n", cfg->health_check_timeout_ms);
+    } else {
+        printf("Health check: off\n");
+    }
+    if (cfg->buffer_size > 0) {
+        printf("Buffers:      %d bytes\n", cfg->buffer_size);
+    } else {
+        printf("Buffers:      auto\n");
+    }
+    printf("Tracing:      %s (%s)\n", cfg->trace_enabled ? "on" : "off", cfg->trace_file);
+    if (cfg->metrics_port > 0) {
+        printf("Metrics:      http://%s:%d/metrics\n", cfg->metrics_address, cfg->metrics_port);
+    }
+    if (cfg->metrics_shm[0] != '\0') {
+        printf("Metrics SHM:  %s\n", cfg->metrics_shm);
+    }
+    printf("Threads:\n");
+    printf("  Serial:     %s\n", serial_sched);
+    printf("  Telnet:     %s\n", cfg->cpu_affinity_telnet[0] ? cfg->cpu_affinity_telnet : "any CPU");
+    printf("  Level 3:    %s\n", cfg->cpu_affinity_level3[0] ? cfg->cpu_affinity_level3 : "any CPU");
+    printf("  Memlock:    %s\n", cfg->memlock ? "yes" : "no");
     printf("Data Logging:\n");
     printf("  Enabled:    %s\n", cfg->data_log_enabled ? "yes" : "no");
     printf("  File:       %s\n", cfg->data_log_file);
+    printf("  Format:     %s\n", datalog_format_name(cfg->data_log_format));
+    printf("  Flush:      %s (%d ms / %d bytes)\n", datalog_flush_name(cfg->data_log_flush),
+           cfg->data_log_flush_ms, cfg->data_log_flush_bytes);
     printf("Echo Functionality:\n");
     printf("  Enabled:    %s\n", cfg->echo_enabled ? "yes" : "no");
     printf("  Immediate:  %s\n", cfg->echo_immediate ? "yes" : "no");
     printf("  First delay: %d seconds\n", cfg->echo_first_delay);
     printf("  Min interval: %d seconds\n", cfg->echo_min_interval);
     printf("  Prefix:     '%s'\n", cfg->echo_prefix);
+    if (cfg->line_count > 0) {
+        printf("Multi-line Mode:\n");
+        printf("  Lines:      %d\n", cfg->line_count);
+        printf("  Workers:    %d%s on %s\n", cfg->line_workers, cfg->line_workers == 0 ? " (auto)" : "",
+               cfg->cpu_affinity_workers[0] ? cfg->cpu_affinity_workers : "any CPU");
+        for (int i = 0; i < cfg->line_count; i++) {
+            const config_t *line = &cfg->lines[i];
+            printf("  [line.%d]   %s @ %d -> %s:%d\n", line->line_id, line->serial_port,
+                   line->baudrate_value, line->telnet_host, line->telnet_port);
+        }
+    }
     printf("====================\n");
 
     /* Also log to syslog */
@@ -367,8 +1142,12 @@ void config_print(const config_t *cfg)
     MB_LOG_INFO("  Data bits:  %d", cfg->data_bits);
     MB_LOG_INFO("  Stop bits:  %d", cfg->stop_bits);
     MB_LOG_INFO("  Flow ctrl:  %s", config_flow_to_str(cfg->flow_control));
+    MB_LOG_INFO("  Latency:    %s, latency_timer %s, %s receive profile",
+                cfg->serial_low_latency ? "low-latency" : "driver default", latency_timer,
+                serial_rx_profile_name(cfg->serial_rx_profile));
     MB_LOG_INFO("Modem:");
     MB_LOG_INFO("  Init cmd:   %s", cfg->modem_init_command[0] ? cfg->modem_init_command : "(none)");
+    MB_LOG_INFO("  Init wait:  %d ms per command", cfg->modem_init_timeout_ms);
     MB_LOG_INFO("  AA mode:    %d (%s)", cfg->modem_autoanswer_mode,
                cfg->modem_autoanswer_mode == 0 ? "SOFTWARE" : "HARDWARE");
     MB_LOG_INFO("  AA SW cmd:  %s", cfg->modem_autoanswer_software_command[0] ? cfg->modem_autoanswer_software_command : "(none)");
@@ -376,15 +1155,81 @@ void config_print(const config_t *cfg)
     MB_LOG_INFO("Telnet:");
     MB_LOG_INFO("  Host:       %s", cfg->telnet_host);
     MB_LOG_INFO("  Port:       %d", cfg->telnet_port);
+    MB_LOG_INFO("  DNS cache:  %d s", cfg->dns_cache_ttl);
+    MB_LOG_INFO("  Pre-connect: %s", cfg->preconnect_on_ring ? "on RING" : "no");
+    MB_LOG_INFO("  Compress:   %s", cfg->telnet_compress ? "MCCP2 if offered" : "no");
+    MB_LOG_INFO("  Protocol:   %s", cfg->telnet_raw ? "raw TCP" :
+                cfg->telnet_fast_start ? "telnet (cached negotiation)" : "telnet");
+    if (cfg->terminal_charset != cfg->server_charset) {
+        MB_LOG_INFO("  Charset:    %s (terminal) <-> %s (server)",
+                   charset_name(cfg->terminal_charset), charset_name(cfg->server_charset));
+    } else {
+        MB_LOG_INFO("  Charset:    %s (no transcoding)", charset_name(cfg->server_charset));
+    }
+    MB_LOG_INFO("  Transfers:  %s", !cfg->xfer_fastpath ? "filtered" :
+                cfg->xfer_telnet_binary ? "raw (also while binary)" : "raw");
+    MB_LOG_INFO("  Splice:     %s", cfg->splice_passthrough ? "when transparent" : "no");
+    if (cfg->connect_timeout_ms > 0) {
+        MB_LOG_INFO("  Connect:    %d ms per server", cfg->connect_timeout_ms);
+    } else {
+        MB_LOG_INFO("  Connect:    no time limit");
+    }
+    if (cfg->dial_count > 0) {
+        MB_LOG_INFO("Dialing Directory:");
+        MB_LOG_INFO("  Default:    %s", cfg->dial_default[0] ? cfg->dial_default : "(TELNET_HOST)");
+        for (int i = 0; i < cfg->dial_count; i++) {
+            const dial_target_config_t *dial = &cfg->dial[i];
+            MB_LOG_INFO("  [dial.%s]  %s -> %d backend(s), %s", dial->name,
+                        dial->numbers[0] ? dial->numbers : "(by name)", dial->backend_count,
+                        config_dial_policy_name(dial->policy));
+        }
+    }
+    MB_LOG_INFO("Event loop:   %s", cfg->event_loop ? "yes" : "no");
+    if (cfg->health_check) {
+        MB_LOG_INFO("Health check: on (%d ms limit)", cfg->health_check_timeout_ms);
+    } else {
+        MB_LOG_INFO("Health check: off");
+    }
+    if (cfg->buffer_size > 0) {
+        MB_LOG_INFO("Buffers:      %d bytes", cfg->buffer_size);
+    } else {
+        MB_LOG_INFO("Buffers:      auto");
+    }
+    MB_LOG_INFO("Tracing:      %s (%s)", cfg->trace_enabled ? "on" : "off", cfg->trace_file);
+    if (cfg->metrics_port > 0) {
+        MB_LOG_INFO("Metrics:      http://%s:%d/metrics", cfg->metrics_address, cfg->metrics_port);
+    }
+    if (cfg->metrics_shm[0] != '\0') {
+        MB_LOG_INFO("Metrics SHM:  %s", cfg->metrics_shm);
+    }
+    MB_LOG_INFO("Threads:");
+    MB_LOG_INFO("  Serial:     %s", serial_sched);
+    MB_LOG_INFO("  Telnet:     %s", cfg->cpu_affinity_telnet[0] ? cfg->cpu_affinity_telnet : "any CPU");
+    MB_LOG_INFO("  Level 3:    %s", cfg->cpu_affinity_level3[0] ? cfg->cpu_affinity_level3 : "any CPU");
+    MB_LOG_INFO("  Memlock:    %s", cfg->memlock ? "yes" : "no");
     MB_LOG_INFO("Data Logging:");
     MB_LOG_INFO("  Enabled:    %s", cfg->data_log_enabled ? "yes" : "no");
     MB_LOG_INFO("  File:       %s", cfg->data_log_file);
+    MB_LOG_INFO("  Format:     %s", datalog_format_name(cfg->data_log_format));
+    MB_LOG_INFO("  Flush:      %s (%d ms / %d bytes)", datalog_flush_name(cfg->data_log_flush),
+                cfg->data_log_flush_ms, cfg->data_log_flush_bytes);
     MB_LOG_INFO("Echo Functionality:");
     MB_LOG_INFO("  Enabled:    %s", cfg->echo_enabled ? "yes" : "no");
     MB_LOG_INFO("  Immediate:  %s", cfg->echo_immediate ? "yes" : "no");
     MB_LOG_INFO("  First delay: %d seconds", cfg->echo_first_delay);
     MB_LOG_INFO("  Min interval: %d seconds", cfg->echo_min_interval);
     MB_LOG_INFO("  Prefix:     '%s'", cfg->echo_prefix);
+    if (cfg->line_count > 0) {
+        MB_LOG_INFO("Multi-line Mode:");
+        MB_LOG_INFO("  Lines:      %d", cfg->line_count);
+        MB_LOG_INFO("  Workers:    %d%s on %s", cfg->line_workers, cfg->line_workers == 0 ? " (auto)" : "",
+                    cfg->cpu_affinity_workers[0] ? cfg->cpu_affinity_workers : "any CPU");
+        for (int i = 0; i < cfg->line_count; i++) {
+            const config_t *line = &cfg->lines[i];
+            MB_LOG_INFO("  [line.%d]   %s @ %d -> %s:%d", line->line_id, line->serial_port,
+                       line->baudrate_value, line->telnet_host, line->telnet_port);
+        }
+    }
     MB_LOG_INFO("====================");
 }
 
@@ -397,7 +1242,23 @@ void config_free(config_t *cfg)
         return;
     }
 
-    /* Nothing to free for now, but provided for future use */
+    /* Per-line configurations ([line.N] sections) */
+    free(cfg->lines);
+    cfg->lines = NULL;
+    cfg->line_count = 0;
+
+    /* Dialing directory ([dial.NAME] sections) */
+    free(cfg->dial);
+    cfg->dial = NULL;
+    cfg->dial_count = 0;
+}
+
+/**
+ * Name of a backend selection policy
+ */
+const char *config_dial_policy_name(dial_policy_t policy)
+{
+    return policy == DIAL_POLICY_WEIGHTED ? "weighted" : "least_conn";
 }
 
 /**
@@ -5,6 +5,19 @@
 #include "datalog.h"
 #include <time.h>
 #include <ctype.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+
+#define DATALOG_QUEUE_MASK  (DATALOG_QUEUE_SLOTS - 1)
+
+_Static_assert((DATALOG_QUEUE_SLOTS & DATALOG_QUEUE_MASK) == 0,
+               "DATALOG_QUEUE_SLOTS must be a power of two");
+_Static_assert(DATALOG_SLOT_DATA % 16 == 0,
+               "DATALOG_SLOT_DATA must keep 16-byte hex dump lines intact");
+
+/* Worst case text size of one slot: 16 bytes per line, ~130 chars per line */
+#define DATALOG_TEXT_MAX    ((DATALOG_SLOT_DATA / 16) * 160 + 128)
 
 /* Direction label strings */
 static const char *direction_labels[] = {
@@ -15,18 +28,341 @@ static const char *direction_labels[] = {
     [DATALOG_DIR_INTERNAL]     = "internal"
 };
 
+static const char hex_digits[] = "0123456789abcdef";
+
+/* Timestamp string cache (one per formatter, seconds resolution) */
+typedef struct {
+    time_t second;
+    char text[64];
+} datalog_ts_cache_t;
+
 /**
- * Get current timestamp string
+ * Get timestamp string for a record (cached per second)
  */
-static void get_timestamp(char *buf, size_t size)
+static const char *get_timestamp(datalog_ts_cache_t *cache, uint64_t timestamp_us)
 {
-    time_t now;
-    struct tm *tm_info;
+    time_t now = (time_t)(timestamp_us / 1000000ULL);
+
+    if (cache->text[0] == '\0' || cache->second != now) {
+        struct tm tm_info;
+
+        localtime_r(&now, &tm_info);
+        strftime(cache->text, sizeof(cache->text), "%Y-%m-%d %H:%M:%S", &tm_info);
+        cache->second = now;
+    }
+
+    return cache->text;
+}
+
+/**
+ * Realtime clock in microseconds (record timestamps)
+ */
+static uint64_t datalog_now_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000;
+}
 
-    time(&now);
-    tm_info = localtime(&now);
+static long long datalog_monotonic_ms(void)
+{
+    struct timespec ts;
 
-    strftime(buf, size, "%Y-%m-%d %H:%M:%S", tm_info);
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ * Format one record in otelnet.log layout
+ * Format: [timestamp][label] hex_bytes  | ascii   (16 bytes per line)
+ * @return Bytes written to out (out must hold DATALOG_TEXT_MAX)
+ */
+static size_t datalog_format_text(datalog_ts_cache_t *cache, const datalog_record_hdr_t *hdr,
+                                  const char *label, const unsigned char *bytes, char *out)
+{
+    const char *timestamp = get_timestamp(cache, hdr->timestamp_us);
+    size_t pos = 0;
+
+    if (hdr->type == DATALOG_REC_SESSION_START) {
+        return (size_t)sprintf(out, "\n[%s] === Session started ===\n", timestamp);
+    }
+    if (hdr->type == DATALOG_REC_SESSION_END) {
+        return (size_t)sprintf(out, "[%s] === Session ended ===\n", timestamp);
+    }
+
+    if (hdr->type == DATALOG_REC_DATA) {
+        if (hdr->direction >= ARRAY_SIZE(direction_labels)) {
+            label = "unknown";
+        } else {
+            label = direction_labels[hdr->direction];
+        }
+    }
+
+    size_t prefix_len = (size_t)sprintf(out, "[%s][%s] ", timestamp, label);
+
+    for (size_t i = 0; i < hdr->length; i += 16) {
+        size_t chunk_len = MIN(16, hdr->length - i);
+
+        if (i > 0) {
+            memcpy(out + pos, out, prefix_len);
+        }
+        pos += prefix_len;
+
+        /* Hex column, padded to 48 characters (%-48s) */
+        char *hex = out + pos;
+        memset(hex, ' ', 48);
+        for (size_t j = 0; j < chunk_len; j++) {
+            unsigned char c = bytes[i + j];
+            hex[j * 3] = hex_digits[c >> 4];
+            hex[j * 3 + 1] = hex_digits[c & 0x0f];
+        }
+        pos += 48;
+
+        out[pos++] = ' ';
+        out[pos++] = '|';
+        out[pos++] = ' ';
+
+        /* ASCII column */
+        for (size_t j = 0; j < chunk_len; j++) {
+            unsigned char c = bytes[i + j];
+            out[pos++] = isprint(c) ? (char)c : '.';
+        }
+        out[pos++] = '\n';
+    }
+
+    return pos;
+}
+
+/* ========== Record Queue ========== */
+
+/**
+ * Append one record to the queue (any thread, lock-free)
+ * @return true if queued, false if the queue is full
+ */
+static bool datalog_enqueue(datalog_t *log, datalog_record_type_t type, uint8_t direction,
+                            const char *label, const unsigned char *data, size_t len,
+                            uint64_t timestamp_us)
+{
+    size_t pos = atomic_load_explicit(&log->enqueue_pos, memory_order_relaxed);
+    datalog_slot_t *slot;
+
+    for (;;) {
+        slot = &log->slots[pos & DATALOG_QUEUE_MASK];
+        size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&log->enqueue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = atomic_load_explicit(&log->enqueue_pos, memory_order_relaxed);
+        }
+    }
+
+    slot->hdr.timestamp_us = timestamp_us;
+    slot->hdr.length = (uint16_t)len;
+    slot->hdr.type = (uint8_t)type;
+    slot->hdr.direction = direction;
+    slot->hdr.label_len = 0;
+    if (label != NULL) {
+        size_t label_len = strnlen(label, DATALOG_LABEL_MAX - 1);
+        memcpy(slot->label, label, label_len);
+        slot->label[label_len] = '\0';
+        slot->hdr.label_len = (uint8_t)label_len;
+    }
+    if (len > 0) {
+        memcpy(slot->data, data, len);
+    }
+
+    atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+    return true;
+}
+
+/**
+ * Wake the writer if it is sleeping on an empty queue
+ */
+static void datalog_kick(datalog_t *log)
+{
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&log->writer_waiting, memory_order_relaxed)) {
+        uint64_t one = 1;
+        ssize_t ret = write(log->wake_fd, &one, sizeof(one));
+        (void)ret;
+    }
+}
+
+/**
+ * Queue a record, splitting data into slot-sized pieces
+ */
+static void datalog_submit(datalog_t *log, datalog_record_type_t type, uint8_t direction,
+                           const char *label, const unsigned char *data, size_t len)
+{
+    uint64_t now = datalog_now_us();
+
+    if (len == 0) {
+        if (!datalog_enqueue(log, type, direction, label, NULL, 0, now)) {
+            atomic_fetch_add_explicit(&log->dropped, 1, memory_order_relaxed);
+        }
+    }
+
+    for (size_t i = 0; i < len; i += DATALOG_SLOT_DATA) {
+        size_t chunk = MIN(DATALOG_SLOT_DATA, len - i);
+        if (!datalog_enqueue(log, type, direction, label, data + i, chunk, now)) {
+            atomic_fetch_add_explicit(&log->dropped, 1, memory_order_relaxed);
+        }
+    }
+
+    datalog_kick(log);
+}
+
+/**
+ * Get the oldest queued record (writer thread only)
+ */
+static datalog_slot_t *datalog_queue_front(datalog_t *log)
+{
+    size_t pos = atomic_load_explicit(&log->dequeue_pos, memory_order_relaxed);
+    datalog_slot_t *slot = &log->slots[pos & DATALOG_QUEUE_MASK];
+    size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+
+    return (seq == pos + 1) ? slot : NULL;
+}
+
+/**
+ * Release the record returned by datalog_queue_front()
+ */
+static void datalog_queue_pop(datalog_t *log, datalog_slot_t *slot)
+{
+    size_t pos = atomic_load_explicit(&log->dequeue_pos, memory_order_relaxed);
+
+    atomic_store_explicit(&slot->seq, pos + DATALOG_QUEUE_SLOTS, memory_order_release);
+    atomic_store_explicit(&log->dequeue_pos, pos + 1, memory_order_relaxed);
+}
+
+/* ========== Writer Thread ========== */
+
+/**
+ * Write out the batch buffer
+ */
+static void datalog_flush_out(datalog_t *log)
+{
+    size_t done = 0;
+
+    while (done < log->out_len) {
+        ssize_t n = write(log->fd, log->out + done, log->out_len - done);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            MB_LOG_ERROR("Data log write failed: %s: %s", log->filename, strerror(errno));
+            break;
+        }
+        done += (size_t)n;
+    }
+
+    log->out_len = 0;
+}
+
+/**
+ * Append one record to the batch buffer in the configured format
+ */
+static void datalog_emit(datalog_t *log, datalog_ts_cache_t *cache, const datalog_slot_t *slot)
+{
+    size_t need = (log->format == DATALOG_FORMAT_BINARY)
+                  ? sizeof(datalog_record_hdr_t) + DATALOG_LABEL_MAX + DATALOG_SLOT_DATA
+                  : DATALOG_TEXT_MAX;
+
+    if (log->out_len + need > DATALOG_OUT_BUFFER) {
+        datalog_flush_out(log);
+    }
+
+    char *out = log->out + log->out_len;
+    if (log->format == DATALOG_FORMAT_BINARY) {
+        memcpy(out, &slot->hdr, sizeof(slot->hdr));
+        memcpy(out + sizeof(slot->hdr), slot->label, slot->hdr.label_len);
+        memcpy(out + sizeof(slot->hdr) + slot->hdr.label_len, slot->data, slot->hdr.length);
+        log->out_len += sizeof(slot->hdr) + slot->hdr.label_len + slot->hdr.length;
+    } else {
+        log->out_len += datalog_format_text(cache, &slot->hdr, slot->label, slot->data, out);
+    }
+}
+
+/**
+ * Writer thread: drain queue, batch, flush per policy
+ */
+static void *datalog_writer_func(void *arg)
+{
+    datalog_t *log = (datalog_t *)arg;
+    datalog_ts_cache_t cache = {0};
+    long long last_flush = datalog_monotonic_ms();
+    uint64_t dropped_reported = 0;
+
+    for (;;) {
+        bool stopping = atomic_load_explicit(&log->writer_stop, memory_order_acquire);
+        bool marker = false;
+        datalog_slot_t *slot;
+
+        while ((slot = datalog_queue_front(log)) != NULL) {
+            datalog_emit(log, &cache, slot);
+            marker = marker || slot->hdr.type == DATALOG_REC_SESSION_START ||
+                     slot->hdr.type == DATALOG_REC_SESSION_END;
+            datalog_queue_pop(log, slot);
+
+            if (log->flush_policy == DATALOG_FLUSH_RECORD) {
+                datalog_flush_out(log);
+            }
+        }
+
+        uint64_t dropped = atomic_load_explicit(&log->dropped, memory_order_relaxed);
+        if (dropped != dropped_reported) {
+            MB_LOG_WARNING("Data log queue full: %llu records dropped",
+                           (unsigned long long)(dropped - dropped_reported));
+            dropped_reported = dropped;
+        }
+
+        /* Session markers are always written out immediately */
+        long long now = datalog_monotonic_ms();
+        if (log->out_len > 0 &&
+            (marker || stopping ||
+             (log->flush_policy == DATALOG_FLUSH_TIME && now - last_flush >= log->flush_ms) ||
+             (log->flush_policy == DATALOG_FLUSH_SIZE && log->out_len >= log->flush_bytes))) {
+            datalog_flush_out(log);
+        }
+        if (log->out_len == 0) {
+            last_flush = now;
+        }
+
+        if (stopping) {
+            break;
+        }
+
+        /* Sleep until a producer kicks us or the flush interval expires */
+        int timeout = -1;
+        if (log->out_len > 0 && log->flush_policy == DATALOG_FLUSH_TIME) {
+            long long remaining = last_flush + log->flush_ms - now;
+            timeout = remaining > 0 ? (int)remaining : 0;
+        }
+
+        atomic_store_explicit(&log->writer_waiting, true, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        if (datalog_queue_front(log) == NULL &&
+            !atomic_load_explicit(&log->writer_stop, memory_order_acquire)) {
+            struct pollfd pfd = { .fd = log->wake_fd, .events = POLLIN };
+            if (poll(&pfd, 1, timeout) > 0) {
+                uint64_t value;
+                ssize_t ret = read(log->wake_fd, &value, sizeof(value));
+                (void)ret;
+            }
+        }
+        atomic_store_explicit(&log->writer_waiting, false, memory_order_relaxed);
+    }
+
+    return NULL;
 }
 
 /**
@@ -39,9 +375,31 @@ void datalog_init(datalog_t *log)
     }
 
     memset(log, 0, sizeof(datalog_t));
-    log->fp = NULL;
+    log->fd = -1;
+    log->wake_fd = -1;
     log->enabled = false;
     log->session_started = false;
+    log->format = DATALOG_FORMAT_TEXT;
+    log->flush_policy = DATALOG_FLUSH_TIME;
+    log->flush_ms = DATALOG_DEFAULT_FLUSH_MS;
+    log->flush_bytes = DATALOG_DEFAULT_FLUSH_BYTES;
+}
+
+/**
+ * Set output format and flush policy
+ */
+void datalog_configure(datalog_t *log, datalog_format_t format,
+                       datalog_flush_t policy, int flush_ms, size_t flush_bytes)
+{
+    if (log == NULL) {
+        return;
+    }
+
+    log->format = format;
+    log->flush_policy = policy;
+    log->flush_ms = flush_ms > 0 ? flush_ms : DATALOG_DEFAULT_FLUSH_MS;
+    log->flush_bytes = MIN(flush_bytes > 0 ? flush_bytes : DATALOG_DEFAULT_FLUSH_BYTES,
+                           (size_t)DATALOG_OUT_BUFFER);
 }
 
 /**
@@ -54,7 +412,7 @@ int datalog_open(datalog_t *log, const char *filename)
     }
 
     /* Close existing file if open */
-    if (log->fp != NULL) {
+    if (log->fd >= 0) {
         datalog_close(log);
     }
 
@@ -64,8 +422,8 @@ int datalog_open(datalog_t *log, const char *filename)
     }
 
     /* Open log file in append mode */
-    log->fp = fopen(filename, "a");
-    if (log->fp == NULL) {
+    log->fd = open(filename, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+    if (log->fd < 0) {
         MB_LOG_ERROR("Failed to open data log file: %s: %s", filename, strerror(errno));
         return ERROR_IO;
     }
@@ -73,15 +431,58 @@ int datalog_open(datalog_t *log, const char *filename)
     /* Save filename */
     SAFE_STRNCPY(log->filename, filename, sizeof(log->filename));
 
-    /* Enable buffering for better performance */
-    setvbuf(log->fp, NULL, _IOFBF, 8192);
+    /* Binary logs start with a magic so datalog_convert() can verify them */
+    if (log->format == DATALOG_FORMAT_BINARY && lseek(log->fd, 0, SEEK_END) == 0) {
+        if (write(log->fd, DATALOG_BINARY_MAGIC, DATALOG_BINARY_MAGIC_LEN) !=
+            DATALOG_BINARY_MAGIC_LEN) {
+            MB_LOG_ERROR("Failed to write data log header: %s: %s", filename, strerror(errno));
+        }
+    }
+
+    log->slots = calloc(DATALOG_QUEUE_SLOTS, sizeof(datalog_slot_t));
+    log->out = malloc(DATALOG_OUT_BUFFER);
+    log->wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (log->slots == NULL || log->out == NULL || log->wake_fd < 0) {
+        MB_LOG_ERROR("Failed to allocate data log queue");
+        goto fail;
+    }
+
+    for (size_t i = 0; i < DATALOG_QUEUE_SLOTS; i++) {
+        atomic_init(&log->slots[i].seq, i);
+    }
+    atomic_init(&log->enqueue_pos, 0);
+    atomic_init(&log->dequeue_pos, 0);
+    atomic_init(&log->dropped, 0);
+    atomic_init(&log->writer_stop, false);
+    atomic_init(&log->writer_waiting, false);
+    log->out_len = 0;
+
+    if (pthread_create(&log->writer, NULL, datalog_writer_func, log) != 0) {
+        MB_LOG_ERROR("Failed to create data log writer thread");
+        goto fail;
+    }
+    log->writer_started = true;
 
     log->enabled = true;
     log->session_started = false;
 
-    MB_LOG_INFO("Data logging opened: %s", filename);
+    MB_LOG_INFO("Data logging opened: %s (%s, flush=%s)", filename,
+                datalog_format_name(log->format), datalog_flush_name(log->flush_policy));
 
     return SUCCESS;
+
+fail:
+    free(log->slots);
+    free(log->out);
+    log->slots = NULL;
+    log->out = NULL;
+    if (log->wake_fd >= 0) {
+        close(log->wake_fd);
+        log->wake_fd = -1;
+    }
+    close(log->fd);
+    log->fd = -1;
+    return ERROR_GENERAL;
 }
 
 /**
@@ -93,7 +494,7 @@ int datalog_close(datalog_t *log)
         return ERROR_INVALID_ARG;
     }
 
-    if (log->fp == NULL) {
+    if (log->fd < 0) {
         return SUCCESS;
     }
 
@@ -102,11 +503,27 @@ int datalog_close(datalog_t *log)
         datalog_session_end(log);
     }
 
-    fflush(log->fp);
-    fclose(log->fp);
-    log->fp = NULL;
     log->enabled = false;
 
+    /* Writer drains everything queued so far before exiting */
+    if (log->writer_started) {
+        atomic_store_explicit(&log->writer_stop, true, memory_order_release);
+        uint64_t one = 1;
+        ssize_t ret = write(log->wake_fd, &one, sizeof(one));
+        (void)ret;
+        pthread_join(log->writer, NULL);
+        log->writer_started = false;
+    }
+
+    close(log->wake_fd);
+    log->wake_fd = -1;
+    close(log->fd);
+    log->fd = -1;
+    free(log->slots);
+    free(log->out);
+    log->slots = NULL;
+    log->out = NULL;
+
     MB_LOG_INFO("Data logging closed: %s", log->filename);
 
     return SUCCESS;
@@ -133,7 +550,7 @@ bool datalog_is_enabled(datalog_t *log)
         return false;
     }
 
-    return log->enabled && log->fp != NULL;
+    return log->enabled && log->fd >= 0;
 }
 
 /**
@@ -141,15 +558,11 @@ bool datalog_is_enabled(datalog_t *log)
  */
 void datalog_session_start(datalog_t *log)
 {
-    char timestamp[64];
-
     if (!datalog_is_enabled(log)) {
         return;
     }
 
-    get_timestamp(timestamp, sizeof(timestamp));
-    fprintf(log->fp, "\n[%s] === Session started ===\n", timestamp);
-    fflush(log->fp);
+    datalog_submit(log, DATALOG_REC_SESSION_START, DATALOG_DIR_INTERNAL, NULL, NULL, 0);
 
     log->session_started = true;
 }
@@ -159,15 +572,11 @@ void datalog_session_start(datalog_t *log)
  */
 void datalog_session_end(datalog_t *log)
 {
-    char timestamp[64];
-
     if (!datalog_is_enabled(log)) {
         return;
     }
 
-    get_timestamp(timestamp, sizeof(timestamp));
-    fprintf(log->fp, "[%s] === Session ended ===\n", timestamp);
-    fflush(log->fp);
+    datalog_submit(log, DATALOG_REC_SESSION_END, DATALOG_DIR_INTERNAL, NULL, NULL, 0);
 
     log->session_started = false;
 }
@@ -179,90 +588,183 @@ void datalog_session_end(datalog_t *log)
 void datalog_write(datalog_t *log, datalog_direction_t direction,
                    const void *data, size_t len)
 {
-    const unsigned char *bytes = (const unsigned char *)data;
-    char timestamp[64];
-    const char *dir_label;
-
     if (!datalog_is_enabled(log) || data == NULL || len == 0) {
         return;
     }
 
-    /* Get direction label */
-    if (direction < 0 || direction >= ARRAY_SIZE(direction_labels)) {
-        dir_label = "unknown";
-    } else {
-        dir_label = direction_labels[direction];
+    datalog_submit(log, DATALOG_REC_DATA, (uint8_t)direction, NULL,
+                   (const unsigned char *)data, len);
+}
+
+/**
+ * Write data with custom label (for internal protocol details)
+ */
+void datalog_write_labeled(datalog_t *log, const char *label,
+                           const void *data, size_t len)
+{
+    if (!datalog_is_enabled(log) || label == NULL || data == NULL || len == 0) {
+        return;
     }
 
-    get_timestamp(timestamp, sizeof(timestamp));
+    datalog_submit(log, DATALOG_REC_LABELED, DATALOG_DIR_INTERNAL, label,
+                   (const unsigned char *)data, len);
+}
 
-    /* Write data in 16-byte chunks (otelnet.log format) */
-    for (size_t i = 0; i < len; i += 16) {
-        char hex_buf[64] = {0};
-        char ascii_buf[20] = {0};
-        size_t chunk_len = MIN(16, len - i);
-        size_t hex_pos = 0;
+/* ========== Offline Conversion ========== */
 
-        /* Build hex representation */
-        for (size_t j = 0; j < chunk_len; j++) {
-            hex_pos += sprintf(hex_buf + hex_pos, "%02x ", bytes[i + j]);
-        }
+/**
+ * Open a binary data log and verify its magic
+ */
+FILE *datalog_open_binary(const char *filename)
+{
+    char magic[DATALOG_BINARY_MAGIC_LEN];
 
-        /* Build ASCII representation */
-        for (size_t j = 0; j < chunk_len; j++) {
-            unsigned char c = bytes[i + j];
-            ascii_buf[j] = isprint(c) ? c : '.';
-        }
-        ascii_buf[chunk_len] = '\0';
+    if (filename == NULL) {
+        return NULL;
+    }
+
+    FILE *in = fopen(filename, "rb");
+    if (in == NULL) {
+        return NULL;
+    }
 
-        /* Write line in otelnet.log format */
-        /* Format: [timestamp][direction] hex_bytes  | ascii */
-        fprintf(log->fp, "[%s][%s] %-48s | %s\n",
-                timestamp, dir_label, hex_buf, ascii_buf);
+    if (fread(magic, 1, sizeof(magic), in) != sizeof(magic) ||
+        memcmp(magic, DATALOG_BINARY_MAGIC, DATALOG_BINARY_MAGIC_LEN) != 0) {
+        fclose(in);
+        errno = EINVAL;
+        return NULL;
     }
 
-    /* Flush after each write to ensure data is written immediately */
-    fflush(log->fp);
+    return in;
 }
 
 /**
- * Write data with custom label (for internal protocol details)
+ * Read the next record of a binary data log
  */
-void datalog_write_labeled(datalog_t *log, const char *label,
-                           const void *data, size_t len)
+int datalog_read_record(FILE *in, datalog_record_hdr_t *hdr, char *label, unsigned char *data)
 {
-    const unsigned char *bytes = (const unsigned char *)data;
-    char timestamp[64];
+    if (in == NULL || hdr == NULL || label == NULL || data == NULL) {
+        return ERROR_INVALID_ARG;
+    }
 
-    if (!datalog_is_enabled(log) || label == NULL || data == NULL || len == 0) {
-        return;
+    if (fread(hdr, sizeof(*hdr), 1, in) != 1) {
+        return feof(in) ? 0 : ERROR_IO;
     }
 
-    get_timestamp(timestamp, sizeof(timestamp));
+    if (hdr->label_len >= DATALOG_LABEL_MAX ||
+        fread(label, 1, hdr->label_len, in) != hdr->label_len ||
+        fread(data, 1, hdr->length, in) != hdr->length) {
+        return ERROR_IO;
+    }
+    label[hdr->label_len] = '\0';
 
-    /* Write data in 16-byte chunks with custom label */
-    for (size_t i = 0; i < len; i += 16) {
-        char hex_buf[64] = {0};
-        char ascii_buf[20] = {0};
-        size_t chunk_len = MIN(16, len - i);
-        size_t hex_pos = 0;
+    return 1;
+}
 
-        /* Build hex representation */
-        for (size_t j = 0; j < chunk_len; j++) {
-            hex_pos += sprintf(hex_buf + hex_pos, "%02x ", bytes[i + j]);
-        }
+/**
+ * Convert a binary data log to the otelnet.log text layout
+ */
+int datalog_convert(const char *filename, FILE *out)
+{
+    datalog_ts_cache_t cache = {0};
+    datalog_record_hdr_t hdr;
+    char label[DATALOG_LABEL_MAX];
+    unsigned char data[UINT16_MAX];
+    char *text;
+    int ret;
+
+    if (filename == NULL || out == NULL) {
+        return ERROR_INVALID_ARG;
+    }
 
-        /* Build ASCII representation */
-        for (size_t j = 0; j < chunk_len; j++) {
-            unsigned char c = bytes[i + j];
-            ascii_buf[j] = isprint(c) ? c : '.';
+    FILE *in = datalog_open_binary(filename);
+    if (in == NULL) {
+        fprintf(stderr, "Cannot open binary data log %s: %s\n", filename, strerror(errno));
+        return ERROR_IO;
+    }
+
+    /* Records may come from a different build, size the buffer for the header limit */
+    text = malloc((UINT16_MAX / 16 + 1) * 160 + 128);
+    if (text == NULL) {
+        fclose(in);
+        return ERROR_GENERAL;
+    }
+
+    while ((ret = datalog_read_record(in, &hdr, label, data)) > 0) {
+        size_t len = datalog_format_text(&cache, &hdr, label, data, text);
+        if (fwrite(text, 1, len, out) != len) {
+            ret = ERROR_IO;
+            break;
         }
-        ascii_buf[chunk_len] = '\0';
+    }
+
+    if (ret < 0) {
+        fprintf(stderr, "%s: truncated record\n", filename);
+    }
+
+    free(text);
+    fclose(in);
+    return ret < 0 ? ERROR_IO : SUCCESS;
+}
+
+/**
+ * Parse DATA_LOG_FORMAT value
+ */
+int datalog_parse_format(const char *value, datalog_format_t *format)
+{
+    if (value == NULL || format == NULL) {
+        return ERROR_INVALID_ARG;
+    }
 
-        /* Write line with custom label */
-        fprintf(log->fp, "[%s][%s] %-48s | %s\n",
-                timestamp, label, hex_buf, ascii_buf);
+    if (strcasecmp(value, "text") == 0) {
+        *format = DATALOG_FORMAT_TEXT;
+    } else if (strcasecmp(value, "binary") == 0) {
+        *format = DATALOG_FORMAT_BINARY;
+    } else {
+        return ERROR_INVALID_ARG;
     }
 
-    fflush(log->fp);
+    return SUCCESS;
+}
+
+/**
+ * Parse DATA_LOG_FLUSH value
+ */
+int datalog_parse_flush(const char *value, datalog_flush_t *policy)
+{
+    if (value == NULL || policy == NULL) {
+        return ERROR_INVALID_ARG;
+    }
+
+    if (strcasecmp(value, "record") == 0) {
+        *policy = DATALOG_FLUSH_RECORD;
+    } else if (strcasecmp(value, "time") == 0) {
+        *policy = DATALOG_FLUSH_TIME;
+    } else if (strcasecmp(value, "size") == 0) {
+        *policy = DATALOG_FLUSH_SIZE;
+    } else {
+        return ERROR_INVALID_ARG;
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * Get format name for display
+ */
+const char *datalog_format_name(datalog_format_t format)
+{
+    return format == DATALOG_FORMAT_BINARY ? "binary" : "text";
+}
+
+/**
+ * Get flush policy name for display
+ */
+const char *datalog_flush_name(datalog_flush_t policy)
+{
+    switch (policy) {
+        case DATALOG_FLUSH_RECORD: return "record";
+        case DATALOG_FLUSH_SIZE:   return "size";
+        default:                   return "time";
+    }
 }
@@ -0,0 +1,346 @@
+/*
+ * dialdir.c - Dialing directory with backend pools
+ */
+
+#include "dialdir.h"
+#include "resolver.h"
+#include <ctype.h>
+#include <strings.h>
+#include <time.h>
+
+static dialdir_target_t *dialdir_targets = NULL;
+static int dialdir_count = 0;
+
+/**
+ * Monotonic clock in milliseconds
+ */
+static long long dialdir_now_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ * Copy the digits of a number (and * #), dropping separators and dial modifiers
+ * @return Length of the normalized number
+ */
+static size_t dialdir_normalize(const char *number, size_t len, char *out, size_t size)
+{
+    size_t n = 0;
+
+    for (size_t i = 0; i < len && n + 1 < size; i++) {
+        char c = number[i];
+        if (isdigit((unsigned char)c) || c == '*' || c == '#') {
+            out[n++] = c;
+        }
+    }
+    out[n] = '\0';
+    return n;
+}
+
+/**
+ * Build the directory from the [dial.NAME] sections
+ */
+int dialdir_init(const config_t *cfg)
+{
+    if (cfg == NULL) {
+        return ERROR_INVALID_ARG;
+    }
+
+    dialdir_shutdown();
+    if (cfg->dial_count == 0) {
+        return SUCCESS;
+    }
+
+    dialdir_targets = calloc((size_t)cfg->dial_count, sizeof(dialdir_target_t));
+    if (dialdir_targets == NULL) {
+        MB_LOG_ERROR("Out of memory allocating the dialing directory");
+        return ERROR_GENERAL;
+    }
+
+    for (int i = 0; i < cfg->dial_count; i++) {
+        const dial_target_config_t *src = &cfg->dial[i];
+        dialdir_target_t *target = &dialdir_targets[i];
+
+        SAFE_STRNCPY(target->name, src->name, sizeof(target->name));
+        SAFE_STRNCPY(target->numbers, src->numbers, sizeof(target->numbers));
+        target->policy = src->policy;
+        target->count = src->backend_count;
+        atomic_init(&target->rotor, 0);
+
+        for (int b = 0; b < target->count; b++) {
+            dialdir_backend_t *backend = &target->backends[b];
+            SAFE_STRNCPY(backend->host, src->backends[b].host, sizeof(backend->host));
+            backend->port = src->backends[b].port;
+            backend->weight = src->backends[b].weight;
+            atomic_init(&backend->active, 0);
+            atomic_init(&backend->failures, 0);
+            atomic_init(&backend->down_until_ms, 0);
+            atomic_init(&backend->connects, 0);
+            atomic_init(&backend->errors, 0);
+        }
+
+        /* Warm the DNS cache before the first call */
+        dialdir_prefetch(target);
+    }
+    dialdir_count = cfg->dial_count;
+
+    MB_LOG_INFO("Dialing directory: %d target(s)", dialdir_count);
+    return SUCCESS;
+}
+
+/**
+ * Drop the directory
+ */
+void dialdir_shutdown(void)
+{
+    free(dialdir_targets);
+    dialdir_targets = NULL;
+    dialdir_count = 0;
+}
+
+/**
+ * Find a target by name
+ */
+dialdir_target_t *dialdir_find_name(const char *name)
+{
+    if (name == NULL || name[0] == '\0') {
+        return NULL;
+    }
+
+    for (int i = 0; i < dialdir_count; i++) {
+        if (strcasecmp(dialdir_targets[i].name, name) == 0) {
+            return &dialdir_targets[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Find a target by number or name
+ */
+dialdir_target_t *dialdir_find(const char *dial)
+{
+    char wanted[SMALL_BUFFER_SIZE];
+    char number[SMALL_BUFFER_SIZE];
+
+    if (dial == NULL) {
+        return NULL;
+    }
+
+    dialdir_target_t *target = dialdir_find_name(dial);
+    if (target != NULL) {
+        return target;
+    }
+
+    if (dialdir_normalize(dial, strlen(dial), wanted, sizeof(wanted)) == 0) {
+        return NULL;
+    }
+
+    for (int i = 0; i < dialdir_count; i++) {
+        const char *p = dialdir_targets[i].numbers;
+        while (*p != '\0') {
+            size_t len = strcspn(p, ",");
+            if (dialdir_normalize(p, len, number, sizeof(number)) > 0 && strcmp(number, wanted) == 0) {
+                return &dialdir_targets[i];
+            }
+            p += len + (p[len] == ',');
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Start resolving every backend of a target in the background
+ */
+void dialdir_prefetch(const dialdir_target_t *target)
+{
+    if (target == NULL) {
+        return;
+    }
+
+    for (int b = 0; b < target->count; b++) {
+        resolver_prefetch(target->backends[b].host, target->backends[b].port);
+    }
+}
+
+/**
+ * Pick the best backend not in the tried mask
+ * Healthy backends come first; among them the lowest load wins (sessions,
+ * or sessions per weight), scanning from a rotating start so equal loads
+ * take turns. If all are held down, the one due back first is chosen.
+ * @param start Backend the scan starts at (rotor value)
+ * @return Backend index, or -1 if every backend was tried
+ */
+static int dialdir_pick(const dialdir_target_t *target, uint32_t tried, unsigned int start)
+{
+    long long now = dialdir_now_ms();
+    int best = -1;
+    bool best_healthy = false;
+    long long best_active = 0;
+    long long best_weight = 1;
+    long long best_down = 0;
+
+    for (int i = 0; i < target->count; i++) {
+        int b = (int)((start + (unsigned int)i) % (unsigned int)target->count);
+        if (tried & (1u << b)) {
+            continue;
+        }
+
+        const dialdir_backend_t *backend = &target->backends[b];
+        long long down = atomic_load_explicit(&backend->down_until_ms, memory_order_relaxed);
+        bool healthy = (down <= now);
+        long long active = atomic_load_explicit(&backend->active, memory_order_relaxed);
+        long long weight = (target->policy == DIAL_POLICY_WEIGHTED) ? backend->weight : 1;
+
+        bool better;
+        if (best < 0 || healthy != best_healthy) {
+            better = (best < 0 || healthy);
+        } else if (healthy) {
+            /* active / weight < best_active / best_weight */
+            better = active * best_weight < best_active * weight;
+        } else {
+            better = down < best_down;
+        }
+
+        if (better) {
+            best = b;
+            best_healthy = healthy;
+            best_active = active;
+            best_weight = weight;
+            best_down = down;
+        }
+    }
+
+    return best;
+}
+
+/**
+ * Check whether the backend the next connect would take is resolved
+ */
+bool dialdir_ready(dialdir_target_t *target)
+{
+    if (target == NULL || target->count == 0) {
+        return false;
+    }
+
+    /* Peek: the rotor only moves for real connects */
+    int b = dialdir_pick(target, 0, atomic_load_explicit(&target->rotor, memory_order_relaxed));
+
+    return b >= 0 && resolver_ready(target->backends[b].host, target->backends[b].port);
+}
+
+/**
+ * Begin a connect to a target
+ */
+void dialdir_lease_init(dialdir_lease_t *lease, dialdir_target_t *target)
+{
+    if (lease == NULL) {
+        return;
+    }
+
+    lease->target = target;
+    lease->backend = -1;
+    lease->tried = 0;
+}
+
+/**
+ * Take the best backend not yet tried by this connect
+ */
+const dialdir_backend_t *dialdir_acquire(dialdir_lease_t *lease)
+{
+    if (lease == NULL || lease->target == NULL || lease->backend >= 0) {
+        return NULL;
+    }
+
+    unsigned int start = atomic_fetch_add_explicit(&lease->target->rotor, 1, memory_order_relaxed);
+    int b = dialdir_pick(lease->target, lease->tried, start);
+    if (b < 0) {
+        return NULL;
+    }
+
+    dialdir_backend_t *backend = &lease->target->backends[b];
+    lease->backend = b;
+    lease->tried |= 1u << b;
+    atomic_fetch_add_explicit(&backend->active, 1, memory_order_relaxed);
+
+    long long down = atomic_load_explicit(&backend->down_until_ms, memory_order_relaxed);
+    if (down > dialdir_now_ms()) {
+        MB_LOG_WARNING("[dial.%s] every backend is down, trying %s:%d (due back first)",
+                      lease->target->name, backend->host, backend->port);
+    } else {
+        MB_LOG_INFO("[dial.%s] backend %s:%d (%d session(s))", lease->target->name,
+                   backend->host, backend->port,
+                   atomic_load_explicit(&backend->active, memory_order_relaxed));
+    }
+    return backend;
+}
+
+/**
+ * Record the outcome of a connect to the held backend
+ */
+void dialdir_report(dialdir_lease_t *lease, bool ok)
+{
+    if (lease == NULL || lease->target == NULL || lease->backend < 0) {
+        return;
+    }
+
+    dialdir_backend_t *backend = &lease->target->backends[lease->backend];
+
+    if (ok) {
+        atomic_fetch_add_explicit(&backend->connects, 1, memory_order_relaxed);
+        if (atomic_exchange_explicit(&backend->failures, 0, memory_order_relaxed) > 0) {
+            MB_LOG_INFO("[dial.%s] backend %s:%d is back up", lease->target->name,
+                       backend->host, backend->port);
+        }
+        atomic_store_explicit(&backend->down_until_ms, 0, memory_order_relaxed);
+        return;
+    }
+
+    atomic_fetch_add_explicit(&backend->errors, 1, memory_order_relaxed);
+    int failures = atomic_fetch_add_explicit(&backend->failures, 1, memory_order_relaxed) + 1;
+    int holddown = DIALDIR_HOLDDOWN_SEC << MIN(failures - 1, 5);
+    holddown = MIN(holddown, DIALDIR_HOLDDOWN_MAX_SEC);
+    atomic_store_explicit(&backend->down_until_ms, dialdir_now_ms() + holddown * 1000LL,
+                          memory_order_relaxed);
+
+    MB_LOG_WARNING("[dial.%s] backend %s:%d down for %d s (%d failure(s) in a row)",
+                  lease->target->name, backend->host, backend->port, holddown, failures);
+}
+
+/**
+ * Give the held backend back
+ */
+void dialdir_release(dialdir_lease_t *lease)
+{
+    if (lease == NULL || lease->target == NULL || lease->backend < 0) {
+        return;
+    }
+
+    atomic_fetch_sub_explicit(&lease->target->backends[lease->backend].active, 1,
+                              memory_order_relaxed);
+    lease->backend = -1;
+}
+
+/**
+ * Log sessions and health of every backend
+ */
+void dialdir_log_status(void)
+{
+    long long now = dialdir_now_ms();
+
+    for (int i = 0; i < dialdir_count; i++) {
+        const dialdir_target_t *target = &dialdir_targets[i];
+        for (int b = 0; b < target->count; b++) {
+            const dialdir_backend_t *backend = &target->backends[b];
+            long long down = atomic_load(&backend->down_until_ms);
+            MB_LOG_INFO("[dial.%s] %s:%d: %d session(s), %llu connect(s), %llu failure(s), %s",
+                       target->name, backend->host, backend->port, atomic_load(&backend->active),
+                       (unsigned long long)atomic_load(&backend->connects),
+                       (unsigned long long)atomic_load(&backend->errors),
+                       down > now ? "down" : "up");
+        }
+    }
+}
@@ -0,0 +1,281 @@
+/*
+ * hayes.c - Hayes AT command and result code tables
+ */
+
+#include "hayes.h"
+#include <pthread.h>
+
+/* Trie over the table strings: A-Z, space, '&' and '\' */
+#define HAYES_TRIE_SYMBOLS      30
+#define HAYES_TRIE_MAX_NODES    128
+#define HAYES_TRIE_COMMAND_ROOT 0
+#define HAYES_TRIE_RESULT_ROOT  1
+
+typedef struct {
+    uint8_t child[HAYES_TRIE_SYMBOLS];  /* Node index, 0 = none (roots are never children) */
+    int8_t command;                     /* Command ending here, -1 = none */
+    int8_t result;                      /* Result code ending here, -1 = none */
+} hayes_trie_node_t;
+
+const hayes_command_entry_t hayes_commands[HAYES_AT_COUNT] = {
+#define HAYES_COMMAND_ENTRY(id, cmd, type, has_param, min, max, def, desc) \
+    [HAYES_AT_##id] = {HAYES_AT_##id, cmd, type, has_param, min, max, def, desc},
+    HAYES_COMMANDS(HAYES_COMMAND_ENTRY)
+#undef HAYES_COMMAND_ENTRY
+};
+
+const hayes_result_entry_t hayes_results[HAYES_RESULT_COUNT] = {
+#define HAYES_RESULT_ENTRY(id, code, numeric, connection, ends_command) \
+    [HAYES_RESULT_##id] = {HAYES_RESULT_##id, code, numeric, connection, ends_command},
+    HAYES_RESULTS(HAYES_RESULT_ENTRY)
+#undef HAYES_RESULT_ENTRY
+};
+
+static hayes_trie_node_t hayes_trie[HAYES_TRIE_MAX_NODES];
+static int hayes_trie_nodes;
+static pthread_once_t hayes_trie_once = PTHREAD_ONCE_INIT;
+
+/**
+ * Trie symbol for a character (0 = not in any table string)
+ */
+static int hayes_symbol(unsigned char c)
+{
+    if (c >= 'A' && c <= 'Z') {
+        return c - 'A' + 1;
+    }
+    switch (c) {
+        case ' ':  return 27;
+        case '&':  return 28;
+        case '\\': return 29;
+        default:   return 0;
+    }
+}
+
+/**
+ * Add one string below a root, returning its final node (-1 if the trie is full)
+ */
+static int hayes_trie_insert(int root, const char *text)
+{
+    int node = root;
+
+    for (const char *p = text; *p; p++) {
+        int sym = hayes_symbol((unsigned char)*p);
+        if (hayes_trie[node].child[sym] == 0) {
+            if (hayes_trie_nodes == HAYES_TRIE_MAX_NODES) {
+                return -1;
+            }
+            int next = hayes_trie_nodes++;
+            hayes_trie[next].command = -1;
+            hayes_trie[next].result = -1;
+            hayes_trie[node].child[sym] = (uint8_t)next;
+        }
+        node = hayes_trie[node].child[sym];
+    }
+
+    return node;
+}
+
+/**
+ * Build the trie from both tables (once)
+ */
+static void hayes_trie_build(void)
+{
+    memset(hayes_trie, 0, sizeof(hayes_trie));
+    hayes_trie[HAYES_TRIE_COMMAND_ROOT].command = -1;
+    hayes_trie[HAYES_TRIE_COMMAND_ROOT].result = -1;
+    hayes_trie[HAYES_TRIE_RESULT_ROOT].command = -1;
+    hayes_trie[HAYES_TRIE_RESULT_ROOT].result = -1;
+    hayes_trie_nodes = 2;
+
+    for (int i = 0; i < HAYES_AT_COUNT; i++) {
+        /* Commands are keyed without the "AT" prefix */
+        int node = hayes_trie_insert(HAYES_TRIE_COMMAND_ROOT, hayes_commands[i].command + 2);
+        if (node < 0) {
+            MB_LOG_ERROR("Hayes trie full at command %s", hayes_commands[i].command);
+            return;
+        }
+        hayes_trie[node].command = (int8_t)i;
+    }
+
+    for (int i = 0; i < HAYES_RESULT_COUNT; i++) {
+        int node = hayes_trie_insert(HAYES_TRIE_RESULT_ROOT, hayes_results[i].code);
+        if (node < 0) {
+            MB_LOG_ERROR("Hayes trie full at result %s", hayes_results[i].code);
+            return;
+        }
+        hayes_trie[node].result = (int8_t)i;
+    }
+
+    MB_LOG_DEBUG("Hayes trie: %d commands, %d results, %d nodes",
+                HAYES_AT_COUNT, HAYES_RESULT_COUNT, hayes_trie_nodes);
+}
+
+/**
+ * Walk the trie from a root, returning the deepest node that ends a string
+ */
+static const hayes_trie_node_t *hayes_trie_walk(int root, const char *text, size_t len,
+                                                bool fold_case, bool want_command,
+                                                size_t *matched)
+{
+    const hayes_trie_node_t *best = NULL;
+    size_t best_len = 0;
+    int node = root;
+
+    pthread_once(&hayes_trie_once, hayes_trie_build);
+
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)text[i];
+        if (fold_case && c >= 'a' && c <= 'z') {
+            c -= 'a' - 'A';
+        }
+        int sym = hayes_symbol(c);
+        if (sym == 0 || hayes_trie[node].child[sym] == 0) {
+            break;
+        }
+        node = hayes_trie[node].child[sym];
+        if ((want_command ? hayes_trie[node].command : hayes_trie[node].result) >= 0) {
+            best = &hayes_trie[node];
+            best_len = i + 1;
+        }
+    }
+
+    if (matched != NULL) {
+        *matched = best_len;
+    }
+    return best;
+}
+
+/**
+ * Match the longest table command at the start of a command string
+ */
+const hayes_command_entry_t *hayes_match_command(const char *text, size_t len, size_t *matched)
+{
+    if (text == NULL) {
+        return NULL;
+    }
+
+    const hayes_trie_node_t *node =
+        hayes_trie_walk(HAYES_TRIE_COMMAND_ROOT, text, len, true, true, matched);
+    return node != NULL ? &hayes_commands[node->command] : NULL;
+}
+
+/**
+ * Match the longest result code that prefixes a line
+ */
+const hayes_result_entry_t *hayes_match_result(const char *text, size_t len, size_t *matched)
+{
+    if (text == NULL) {
+        return NULL;
+    }
+
+    const hayes_trie_node_t *node =
+        hayes_trie_walk(HAYES_TRIE_RESULT_ROOT, text, len, false, false, matched);
+    return node != NULL ? &hayes_results[node->result] : NULL;
+}
+
+/**
+ * Look up a result code by its exact text
+ */
+const hayes_result_entry_t *hayes_find_result(const char *code)
+{
+    size_t matched;
+
+    if (code == NULL) {
+        return NULL;
+    }
+
+    size_t len = strlen(code);
+    const hayes_result_entry_t *result = hayes_match_result(code, len, &matched);
+    return (result != NULL && matched == len) ? result : NULL;
+}
+
+/**
+ * Parse the optional one-digit parameter that follows a command name
+ */
+int hayes_parse_parameter(const hayes_command_entry_t *cmd, const char **p)
+{
+    int value = cmd->default_param;
+
+    if (cmd->has_parameter && **p >= '0' && **p <= '9') {
+        value = **p - '0';
+        (*p)++;
+    }
+
+    if (value < cmd->min_param || value > cmd->max_param) {
+        return -1;
+    }
+    return value;
+}
+
+/**
+ * Reset the escape detector
+ */
+void hayes_escape_reset(hayes_escape_t *esc, long long now_ms)
+{
+    if (esc == NULL) {
+        return;
+    }
+
+    esc->count = 0;
+    esc->last_data_ms = now_ms;
+    esc->last_escape_ms = 0;
+}
+
+/**
+ * Scan one chunk for the escape sequence
+ */
+size_t hayes_escape_scan(hayes_escape_t *esc, const unsigned char *data, size_t len,
+                         int escape_char, int guard_ms, long long now_ms)
+{
+    size_t i = 0;
+
+    if (esc == NULL || data == NULL || len == 0) {
+        return 0;
+    }
+
+    if (escape_char < 0 || escape_char > 127) {
+        esc->count = 0;
+        esc->last_data_ms = now_ms;
+        return 0;
+    }
+
+    while (i < len) {
+        if (esc->count > 0) {
+            if (data[i] == escape_char && now_ms - esc->last_escape_ms < guard_ms) {
+                esc->last_escape_ms = now_ms;
+                i++;
+                if (++esc->count == HAYES_ESCAPE_LENGTH) {
+                    esc->count = 0;
+                    esc->last_data_ms = now_ms;
+                    return i;
+                }
+                continue;
+            }
+            /* Run broken: the pending escape characters were data */
+            esc->count = 0;
+            esc->last_data_ms = now_ms;
+        }
+
+        const unsigned char *p = memchr(data + i, escape_char, len - i);
+        if (p == NULL) {
+            esc->last_data_ms = now_ms;
+            return 0;
+        }
+
+        size_t at = (size_t)(p - data);
+        if (at > i) {
+            esc->last_data_ms = now_ms;
+        }
+        i = at + 1;
+
+        if (now_ms - esc->last_data_ms >= guard_ms) {
+            esc->count = 1;
+            esc->last_escape_ms = now_ms;
+        } else {
+            /* No guard time before it: an escape character inside data */
+            esc->last_data_ms = now_ms;
+        }
+    }
+
+    return 0;
+}
@@ -4,7 +4,12 @@
 
 #include "healthcheck.h"
 #include "serial.h"
+#include "hayes.h"
+#ifdef ENABLE_LEVEL2
+#include "resolver.h"
+#endif
 #include <sys/stat.h>
+#include <sys/epoll.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <netdb.h>
@@ -12,502 +17,697 @@
 #include <unistd.h>
 #include <errno.h>
 #include <string.h>
-
-/* Forward declarations */
-static int healthcheck_modem_device_with_port(serial_port_t *port, const config_t *cfg,
-                                               health_check_result_t *result);
-static int healthcheck_execute_init_commands(serial_port_t *port, const config_t *cfg,
-                                              health_report_t *report);
-static int healthcheck_execute_health_commands(serial_port_t *port, const config_t *cfg,
-                                                health_report_t *report);
+#include <stdarg.h>
+#include <pthread.h>
+#include <time.h>
+
+/* One probe: a serial port (plus its modem) or a telnet target */
+typedef enum {
+    HEALTH_PROBE_SERIAL,
+    HEALTH_PROBE_TELNET
+} health_probe_kind_t;
+
+typedef struct {
+    health_probe_kind_t kind;
+    const config_t *cfg;                /* Line that owns the port / first line using the target */
+    health_report_t *report;            /* Serial probes: that line's report */
+    int fd;
+    bool done;
+    long long step_deadline_ms;         /* Current command or connect attempt */
+
+    /* Serial: "AT", then MODEM_HEALTH_COMMAND */
+    struct termios oldtio;
+    modem_script_t script;
+    int step;
+    char rx[SMALL_BUFFER_SIZE];
+    size_t rx_len;
+
+    /* Telnet: addresses tried in turn */
+    health_check_result_t result;
+#ifdef ENABLE_LEVEL2
+    resolver_result_t addrs;
+    int addr_index;
+#endif
+} health_probe_t;
+
+/* Cached result of one resource (device path or "host:port") */
+typedef struct {
+    char key[SMALL_BUFFER_SIZE + 16];   /* "" = free slot */
+    health_check_result_t result;
+    long long checked_ms;
+} health_cache_entry_t;
+
+static health_cache_entry_t health_cache[HEALTHCHECK_CACHE_SIZE];
+static pthread_mutex_t health_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 /**
- * Run complete health check
+ * Monotonic clock in milliseconds
  */
-int healthcheck_run(const config_t *cfg, health_report_t *report)
+static long long healthcheck_monotonic_ms(void)
 {
-    serial_port_t port;
-    bool port_opened = false;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
 
-    if (cfg == NULL || report == NULL) {
-        return ERROR_INVALID_ARG;
-    }
+/**
+ * Set a result's status and message
+ */
+static void healthcheck_set(health_check_result_t *result, health_status_t status,
+                            const char *fmt, ...)
+{
+    va_list ap;
 
-    memset(report, 0, sizeof(health_report_t));
+    result->status = status;
+    va_start(ap, fmt);
+    vsnprintf(result->message, sizeof(result->message), fmt, ap);
+    va_end(ap);
+}
 
-    /* Check serial port (file existence and permissions only) */
-    healthcheck_serial_port(cfg->serial_port, &report->serial_port);
+/**
+ * Remember a result (caller holds health_cache_mutex)
+ */
+static void healthcheck_cache_store_locked(const char *key, const health_check_result_t *result)
+{
+    health_cache_entry_t *slot = &health_cache[0];
 
-    /* Open serial port once for the entire health check */
-    if (report->serial_port.status == HEALTH_STATUS_OK) {
-        serial_init(&port);
-        if (serial_open(&port, cfg->serial_port, cfg) == SUCCESS) {
-            port_opened = true;
-            report->serial_init.status = HEALTH_STATUS_OK;
-            snprintf(report->serial_init.message, sizeof(report->serial_init.message),
-                    "Serial port initialized: %d baud, %d%c%d, flow=%s",
-                    cfg->baudrate_value,
-                    cfg->data_bits,
-                    cfg->parity == PARITY_NONE ? 'N' :
-                    cfg->parity == PARITY_EVEN ? 'E' : 'O',
-                    cfg->stop_bits,
-                    config_flow_to_str(cfg->flow_control));
-        } else {
-            report->serial_init.status = HEALTH_STATUS_ERROR;
-            SAFE_STRNCPY(report->serial_init.message,
-                        "Failed to initialize serial port",
-                        sizeof(report->serial_init.message));
+    for (int i = 0; i < HEALTHCHECK_CACHE_SIZE; i++) {
+        health_cache_entry_t *e = &health_cache[i];
+        if (strcmp(e->key, key) == 0 || e->key[0] == '\0') {
+            slot = e;
+            break;
+        }
+        if (e->checked_ms < slot->checked_ms) {
+            slot = e;       /* Oldest entry is replaced */
         }
-    } else {
-        report->serial_init.status = HEALTH_STATUS_ERROR;
-        SAFE_STRNCPY(report->serial_init.message,
-                    "Cannot initialize (serial port not available)",
-                    sizeof(report->serial_init.message));
     }
 
-    /* Check modem device (use already-open port) */
-    if (port_opened) {
-        healthcheck_modem_device_with_port(&port, cfg, &report->modem_device);
-    } else {
-        report->modem_device.status = HEALTH_STATUS_ERROR;
-        SAFE_STRNCPY(report->modem_device.message,
-                    "Cannot check modem (serial not initialized)",
-                    sizeof(report->modem_device.message));
-    }
+    SAFE_STRNCPY(slot->key, key, sizeof(slot->key));
+    slot->result = *result;
+    slot->checked_ms = healthcheck_monotonic_ms();
+}
 
-    /* Execute MODEM_INIT_COMMAND if port is open and modem is accessible
-     * NOTE: This executes and prints immediately, appearing in output
-     * before the full report is printed by healthcheck_print_report() */
-    if (port_opened && cfg->modem_init_command[0] != '\0' &&
-        (report->modem_device.status == HEALTH_STATUS_OK ||
-         report->modem_device.status == HEALTH_STATUS_WARNING)) {
-        healthcheck_execute_init_commands(&port, cfg, report);
-    }
+/**
+ * Remember a result
+ */
+static void healthcheck_cache_store(const char *key, const health_check_result_t *result)
+{
+    pthread_mutex_lock(&health_cache_mutex);
+    healthcheck_cache_store_locked(key, result);
+    pthread_mutex_unlock(&health_cache_mutex);
+}
 
-    /* Execute MODEM_HEALTH_COMMAND if configured and port is open */
-    if (port_opened && cfg->modem_command[0] != '\0' &&
-        (report->modem_device.status == HEALTH_STATUS_OK ||
-         report->modem_device.status == HEALTH_STATUS_WARNING)) {
-        healthcheck_execute_health_commands(&port, cfg, report);
-    }
+/**
+ * Serial: send the command of the current step
+ */
+static void healthcheck_serial_send(health_probe_t *probe, long long now_ms)
+{
+    char cmd_buf[LINE_BUFFER_SIZE + 2];
+    const char *command = &probe->script.text[probe->script.offset[probe->step]];
+    int len = snprintf(cmd_buf, sizeof(cmd_buf), "%s\r", command);
 
-    /* Close serial port once at the end */
-    if (port_opened) {
-        serial_close(&port);
+    /* A short write only loses the command: the step then times out */
+    if (write(probe->fd, cmd_buf, len) != len) {
+        MB_LOG_DEBUG("Health check: short write of %s to %s", command, probe->cfg->serial_port);
     }
+    probe->rx_len = 0;
+    probe->step_deadline_ms = now_ms + HEALTHCHECK_PROBE_TIMEOUT_MS;
 
-    /* === LEVEL 1: Telnet check DISABLED === */
-    /* Level 1 only uses serial/modem, telnet check not needed */
-    /* healthcheck_telnet_server(cfg->telnet_host, cfg->telnet_port,
-                             &report->telnet_server); */
-
-    /* Set telnet status to UNKNOWN since we're not checking it */
-    report->telnet_server.status = HEALTH_STATUS_UNKNOWN;
-    SAFE_STRNCPY(report->telnet_server.message,
-                "Telnet check skipped (Level 1 mode)",
-                sizeof(report->telnet_server.message));
-
-    return SUCCESS;
+    if (probe->step > 0) {
+        size_t used = strlen(probe->report->health_responses);
+        snprintf(probe->report->health_responses + used,
+                 sizeof(probe->report->health_responses) - used,
+                 "%s%s:", used > 0 ? "\n" : "", command);
+    }
 }
 
 /**
- * Check serial port availability
+ * Serial: the current step ended (result code, timeout or error)
  */
-int healthcheck_serial_port(const char *device, health_check_result_t *result)
+static void healthcheck_serial_step_done(health_probe_t *probe, const char *outcome, long long now_ms)
 {
-    struct stat st;
-    int fd;
+    health_report_t *report = probe->report;
 
-    if (device == NULL || result == NULL) {
-        return ERROR_INVALID_ARG;
+    if (probe->step == 0) {
+        if (outcome == NULL) {
+            healthcheck_set(&report->modem_device, HEALTH_STATUS_OK, "Modem responded to AT command");
+        } else {
+            /* No modem to run MODEM_HEALTH_COMMAND against */
+            healthcheck_set(&report->modem_device, HEALTH_STATUS_WARNING, "%s", outcome);
+            probe->done = true;
+            return;
+        }
+    } else if (outcome != NULL) {
+        size_t used = strlen(report->health_responses);
+        snprintf(report->health_responses + used, sizeof(report->health_responses) - used,
+                 " (%s)", outcome);
     }
 
-    result->status = HEALTH_STATUS_UNKNOWN;
-    memset(result->message, 0, sizeof(result->message));
-
-    /* 1. Check if device file exists */
-    if (access(device, F_OK) != 0) {
-        result->status = HEALTH_STATUS_ERROR;
-        snprintf(result->message, sizeof(result->message),
-                "Device does not exist: %s", device);
-        return SUCCESS;
+    if (++probe->step < probe->script.count) {
+        healthcheck_serial_send(probe, now_ms);
+    } else {
+        probe->done = true;
     }
+}
 
-    /* 2. Check if it's a character device */
-    if (stat(device, &st) != 0) {
-        result->status = HEALTH_STATUS_ERROR;
-        snprintf(result->message, sizeof(result->message),
-                "Cannot stat device: %s (%s)", device, strerror(errno));
-        return SUCCESS;
-    }
+/**
+ * Serial: open and configure the port, then send "AT"
+ */
+static void healthcheck_serial_start(health_probe_t *probe, int epfd, long long now_ms)
+{
+    const config_t *cfg = probe->cfg;
+    health_report_t *report = probe->report;
+    serial_port_t port;
 
-    if (!S_ISCHR(st.st_mode)) {
-        result->status = HEALTH_STATUS_ERROR;
-        snprintf(result->message, sizeof(result->message),
-                "Not a character device: %s", device);
-        return SUCCESS;
+    healthcheck_serial_port(cfg->serial_port, &report->serial_port);
+    healthcheck_cache_store(cfg->serial_port, &report->serial_port);
+    if (report->serial_port.status != HEALTH_STATUS_OK) {
+        healthcheck_set(&report->serial_init, HEALTH_STATUS_ERROR,
+                        "Cannot initialize (serial port not available)");
+        healthcheck_set(&report->modem_device, HEALTH_STATUS_ERROR,
+                        "Cannot check modem (serial not initialized)");
+        probe->done = true;
+        return;
     }
 
-    /* 3. Check read/write permissions */
-    if (access(device, R_OK | W_OK) != 0) {
-        result->status = HEALTH_STATUS_WARNING;
-        snprintf(result->message, sizeof(result->message),
-                "Permission denied: %s (try: sudo usermod -a -G dialout $USER)",
-                device);
-        return SUCCESS;
+    /* Non-blocking for the whole probe, so every port shares one epoll */
+    serial_init(&port);
+    port.fd = open(cfg->serial_port, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (port.fd < 0 || tcgetattr(port.fd, &port.oldtio) < 0 ||
+        serial_configure(&port, cfg->baudrate, cfg->parity, cfg->data_bits,
+                         cfg->stop_bits, cfg->flow_control) != SUCCESS) {
+        if (port.fd >= 0) {
+            close(port.fd);
+        }
+        healthcheck_set(&report->serial_init, HEALTH_STATUS_ERROR, "Failed to initialize serial port");
+        healthcheck_set(&report->modem_device, HEALTH_STATUS_ERROR,
+                        "Cannot check modem (serial not initialized)");
+        probe->done = true;
+        return;
     }
+    probe->fd = port.fd;
+    probe->oldtio = port.oldtio;
 
-    /* 4. Try to open the device */
-    fd = open(device, O_RDWR | O_NOCTTY | O_NONBLOCK);
-    if (fd < 0) {
-        result->status = HEALTH_STATUS_WARNING;
-        snprintf(result->message, sizeof(result->message),
-                "Failed to open: %s (%s)", device, strerror(errno));
-        return SUCCESS;
+    healthcheck_set(&report->serial_init, HEALTH_STATUS_OK,
+                    "Serial port initialized: %d baud, %d%c%d, flow=%s",
+                    cfg->baudrate_value, cfg->data_bits,
+                    cfg->parity == PARITY_NONE ? 'N' : cfg->parity == PARITY_EVEN ? 'E' : 'O',
+                    cfg->stop_bits, config_flow_to_str(cfg->flow_control));
+
+    /* Step 0 is a plain "AT"; MODEM_HEALTH_COMMAND follows */
+    char commands[LINE_BUFFER_SIZE + 4];
+    snprintf(commands, sizeof(commands), "AT;%s", cfg->modem_command);
+    config_parse_modem_script(&probe->script, commands);
+
+    struct epoll_event ev = { .events = EPOLLIN, .data.ptr = probe };
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, probe->fd, &ev) < 0) {
+        healthcheck_set(&report->modem_device, HEALTH_STATUS_WARNING,
+                        "Cannot wait for modem: %s", strerror(errno));
+        probe->done = true;
+        return;
     }
 
-    close(fd);
-
-    /* Success */
-    result->status = HEALTH_STATUS_OK;
-    snprintf(result->message, sizeof(result->message),
-            "Device exists and accessible: %s", device);
-
-    return SUCCESS;
+    healthcheck_serial_send(probe, now_ms);
 }
 
 /**
- * Helper: Send command to modem and read response with timeout
- * Reads all available data from modem by continuously reading until no more data
- * Returns total bytes read, or -1 on error, 0 on timeout
+ * Serial: collect response lines until a result code ends the step
  */
-static ssize_t send_at_command_and_wait(serial_port_t *port,
-                                         const char *command,
-                                         unsigned char *response,
-                                         size_t response_size,
-                                         int timeout_sec)
+static void healthcheck_serial_input(health_probe_t *probe, long long now_ms)
 {
-    char cmd_buf[SMALL_BUFFER_SIZE];
-    fd_set readfds;
-    struct timeval tv;
-    int ret;
-    ssize_t total_read = 0;
-    unsigned char temp_buf[SMALL_BUFFER_SIZE];
-
-    /* Format command with CR+LF */
-    snprintf(cmd_buf, sizeof(cmd_buf), "%s\r\n", command);
-
-    /* Send command */
-    ssize_t written = serial_write(port, (const unsigned char *)cmd_buf,
-                                   strlen(cmd_buf));
-    if (written < 0) {
-        return -1;
-    }
-
-    /* Read response until no more data or timeout */
-    while (1) {
-        FD_ZERO(&readfds);
-        FD_SET(port->fd, &readfds);
-        tv.tv_sec = timeout_sec;
-        tv.tv_usec = 0;
-
-        ret = select(port->fd + 1, &readfds, NULL, NULL, &tv);
-
-        if (ret > 0) {
-            /* Data available - read it */
-            ssize_t n = serial_read(port, temp_buf, sizeof(temp_buf));
-            if (n > 0) {
-                /* Append to response buffer if space available */
-                if (total_read + n < (ssize_t)response_size - 1) {
-                    memcpy(response + total_read, temp_buf, n);
-                    total_read += n;
-                } else {
-                    /* Buffer full - copy what fits */
-                    ssize_t space_left = response_size - 1 - total_read;
-                    if (space_left > 0) {
-                        memcpy(response + total_read, temp_buf, space_left);
-                        total_read += space_left;
-                    }
-                    break;
-                }
-
-                /* Continue reading with shorter timeout (100ms) to catch remaining data */
-                tv.tv_sec = 0;
-                tv.tv_usec = 100000;
-            } else if (n < 0) {
-                /* Read error */
-                if (total_read > 0) {
-                    /* Return what we've read so far */
-                    break;
-                }
-                return -1;
-            } else {
-                /* n == 0, no data available */
-                break;
+    ssize_t n = 0;
+
+    while (!probe->done &&
+           (n = read(probe->fd, probe->rx + probe->rx_len, sizeof(probe->rx) - 1 - probe->rx_len)) > 0) {
+        probe->rx_len += (size_t)n;
+
+        size_t start = 0;
+        for (size_t i = 0; i < probe->rx_len && !probe->done; i++) {
+            if (probe->rx[i] != '\r' && probe->rx[i] != '\n') {
+                continue;
             }
-        } else if (ret == 0) {
-            /* Timeout */
-            if (total_read > 0) {
-                /* We got some data before timeout */
-                break;
+            size_t len = i - start;
+            const char *line = probe->rx + start;
+            start = i + 1;
+            if (len == 0) {
+                continue;
             }
-            return 0;
-        } else {
-            /* Select error */
-            if (total_read > 0) {
-                /* Return what we've read so far */
-                break;
+
+            /* Echo of the command itself */
+            if (len >= 2 && strncasecmp(line, "AT", 2) == 0) {
+                continue;
+            }
+
+            const hayes_result_entry_t *result = hayes_match_result(line, len, NULL);
+            if (result != NULL && result->id == HAYES_RESULT_RING) {
+                continue;
             }
-            return -1;
+            if (result != NULL && result->id == HAYES_RESULT_OK) {
+                healthcheck_serial_step_done(probe, NULL, now_ms);
+            } else if (result != NULL) {
+                char outcome[SMALL_BUFFER_SIZE];
+                snprintf(outcome, sizeof(outcome), "Modem answered %s", result->code);
+                healthcheck_serial_step_done(probe, outcome, now_ms);
+            } else if (probe->step > 0) {
+                /* Information text of a MODEM_HEALTH_COMMAND */
+                size_t used = strlen(probe->report->health_responses);
+                snprintf(probe->report->health_responses + used,
+                         sizeof(probe->report->health_responses) - used,
+                         " %.*s", (int)len, line);
+            }
+        }
+
+        if (probe->rx_len - start >= sizeof(probe->rx) - 1) {
+            start = probe->rx_len;      /* Line too long to be a result code */
+        }
+        if (probe->done || start >= probe->rx_len) {
+            probe->rx_len = 0;
+        } else if (start > 0) {
+            memmove(probe->rx, probe->rx + start, probe->rx_len - start);
+            probe->rx_len -= start;
         }
     }
 
-    if (total_read > 0) {
-        response[total_read] = '\0';  /* Null-terminate */
+    /* Hangup or I/O error: nothing more will come */
+    if (!probe->done && (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR))) {
+        if (probe->step == 0) {
+            healthcheck_set(&probe->report->modem_device, HEALTH_STATUS_WARNING,
+                            "Read error from modem");
+        }
+        probe->done = true;
     }
+}
 
-    return total_read;
+/**
+ * Serial: restore the port and close it
+ */
+static void healthcheck_serial_finish(health_probe_t *probe)
+{
+    if (probe->fd >= 0) {
+        tcsetattr(probe->fd, TCSANOW, &probe->oldtio);
+        close(probe->fd);
+        probe->fd = -1;
+    }
 }
 
+#ifdef ENABLE_LEVEL2
 /**
- * Helper: Parse semicolon-separated commands
- * Modifies input string in place
- * Returns number of commands parsed
+ * Telnet: connect to the next address (marks the probe done when none is left)
  */
-static int parse_modem_commands(char *modem_command_str,
-                                char **commands,
-                                int max_commands)
+static void healthcheck_telnet_connect_next(health_probe_t *probe, int epfd, long long now_ms)
 {
-    int count = 0;
-    char *token;
-    char *saveptr;
+    const config_t *cfg = probe->cfg;
 
-    if (modem_command_str == NULL || modem_command_str[0] == '\0') {
-        return 0;
-    }
+    while (probe->addr_index < probe->addrs.count) {
+        int i = probe->addr_index++;
+        const struct sockaddr_storage *addr = &probe->addrs.addrs[i];
 
-    /* Split by semicolon */
-    token = strtok_r(modem_command_str, ";", &saveptr);
-    while (token != NULL && count < max_commands) {
-        /* Trim whitespace */
-        token = trim_whitespace(token);
+        probe->fd = socket(addr->ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (probe->fd < 0) {
+            healthcheck_set(&probe->result, HEALTH_STATUS_ERROR,
+                            "Failed to create socket: %s", strerror(errno));
+            continue;
+        }
 
-        if (strlen(token) > 0) {
-            commands[count++] = token;
+        if (connect(probe->fd, (const struct sockaddr *)addr, probe->addrs.addr_len[i]) == 0) {
+            healthcheck_set(&probe->result, HEALTH_STATUS_OK,
+                            "Connected: %s:%d", cfg->telnet_host, cfg->telnet_port);
+            probe->done = true;
+            return;
         }
 
-        token = strtok_r(NULL, ";", &saveptr);
+        struct epoll_event ev = { .events = EPOLLOUT, .data.ptr = probe };
+        if (errno == EINPROGRESS && epoll_ctl(epfd, EPOLL_CTL_ADD, probe->fd, &ev) == 0) {
+            probe->step_deadline_ms = now_ms + HEALTHCHECK_CONNECT_TIMEOUT_MS;
+            return;
+        }
+
+        healthcheck_set(&probe->result, HEALTH_STATUS_ERROR, "Connection failed: %s:%d (%s)",
+                        cfg->telnet_host, cfg->telnet_port, strerror(errno));
+        close(probe->fd);
+        probe->fd = -1;
     }
 
-    return count;
+    probe->done = true;
 }
 
 /**
- * Check modem device responsiveness using an already-open port
- * Sends AT command and waits for response (2 second timeout)
+ * Telnet: resolve the target and start connecting
  */
-static int healthcheck_modem_device_with_port(serial_port_t *port, const config_t *cfg,
-                                               health_check_result_t *result)
+static void healthcheck_telnet_start(health_probe_t *probe, int epfd, long long now_ms)
 {
-    unsigned char response[SMALL_BUFFER_SIZE];
+    const config_t *cfg = probe->cfg;
 
-    if (port == NULL || cfg == NULL || result == NULL) {
-        return ERROR_INVALID_ARG;
+    if (resolver_lookup(cfg->telnet_host, cfg->telnet_port, &probe->addrs) != SUCCESS) {
+        healthcheck_set(&probe->result, HEALTH_STATUS_ERROR,
+                        "Failed to resolve hostname: %s", cfg->telnet_host);
+        probe->done = true;
+        return;
     }
 
-    result->status = HEALTH_STATUS_UNKNOWN;
-    memset(result->message, 0, sizeof(result->message));
-
-    /* Send AT command and check response (silent check) */
-    ssize_t n = send_at_command_and_wait(port, "AT", response,
-                                         sizeof(response), 2);
+    healthcheck_telnet_connect_next(probe, epfd, now_ms);
+}
 
-    if (n > 0) {
-        result->status = HEALTH_STATUS_OK;
-        snprintf(result->message, sizeof(result->message),
-                "Modem responded to AT command");
-    } else if (n == 0) {
-        result->status = HEALTH_STATUS_WARNING;
-        snprintf(result->message, sizeof(result->message),
-                "No response from modem (timeout 2s) - modem may be offline");
-    } else {
-        result->status = HEALTH_STATUS_WARNING;
-        snprintf(result->message, sizeof(result->message),
-                "Read error from modem");
+/**
+ * Telnet: the pending connect completed or failed
+ */
+static void healthcheck_telnet_output(health_probe_t *probe, int epfd, long long now_ms)
+{
+    const config_t *cfg = probe->cfg;
+    int error = 0;
+    socklen_t len = sizeof(error);
+
+    getsockopt(probe->fd, SOL_SOCKET, SO_ERROR, &error, &len);
+    close(probe->fd);
+    probe->fd = -1;
+
+    if (error == 0) {
+        healthcheck_set(&probe->result, HEALTH_STATUS_OK,
+                        "Connected: %s:%d", cfg->telnet_host, cfg->telnet_port);
+        probe->done = true;
+        return;
     }
 
-    return SUCCESS;
+    healthcheck_set(&probe->result, HEALTH_STATUS_ERROR, "Connection failed: %s:%d (%s)",
+                    cfg->telnet_host, cfg->telnet_port, strerror(error));
+    healthcheck_telnet_connect_next(probe, epfd, now_ms);
 }
+#endif
 
 /**
- * Execute MODEM_INIT_COMMAND on an already-open port
- * Prints output directly (called during health check while port is open)
+ * A probe ran out of time (its step, or the whole health check)
  */
-static int healthcheck_execute_init_commands(serial_port_t *port, const config_t *cfg,
-                                              health_report_t *report)
+static void healthcheck_probe_timeout(health_probe_t *probe, int epfd, long long now_ms, bool overall)
 {
-    unsigned char response[SMALL_BUFFER_SIZE];
-    char modem_cmd_copy[LINE_BUFFER_SIZE];
-    char *commands[32];
-    int cmd_count = 0;
+    if (probe->kind == HEALTH_PROBE_SERIAL) {
+        if (overall) {
+            if (probe->step == 0) {
+                healthcheck_set(&probe->report->modem_device, HEALTH_STATUS_WARNING,
+                                "No response from modem before the health check deadline");
+            }
+            probe->done = true;
+        } else {
+            char outcome[SMALL_BUFFER_SIZE];
+            snprintf(outcome, sizeof(outcome), "No response from modem (timeout %ds)%s",
+                     HEALTHCHECK_PROBE_TIMEOUT_MS / 1000,
+                     probe->step == 0 ? " - modem may be offline" : "");
+            healthcheck_serial_step_done(probe, outcome, now_ms);
+        }
+        return;
+    }
 
-    (void)report;  /* Not used in this implementation */
+#ifdef ENABLE_LEVEL2
+    if (overall) {
+        healthcheck_set(&probe->result, HEALTH_STATUS_WARNING,
+                        "Connection timeout (health check deadline): %s:%d",
+                        probe->cfg->telnet_host, probe->cfg->telnet_port);
+    } else {
+        healthcheck_set(&probe->result, HEALTH_STATUS_WARNING, "Connection timeout (%ds): %s:%d",
+                        HEALTHCHECK_CONNECT_TIMEOUT_MS / 1000,
+                        probe->cfg->telnet_host, probe->cfg->telnet_port);
+    }
+    if (probe->fd >= 0) {
+        close(probe->fd);
+        probe->fd = -1;
+    }
+    if (overall) {
+        probe->done = true;
+    } else {
+        healthcheck_telnet_connect_next(probe, epfd, now_ms);
+    }
+#else
+    (void)epfd;
+#endif
+}
 
-    if (port == NULL || cfg == NULL) {
+/**
+ * Run complete health check
+ */
+int healthcheck_run(const config_t *cfg, health_report_t *report)
+{
+    if (cfg == NULL) {
         return ERROR_INVALID_ARG;
     }
 
-    printf("\n  === Modem Init Command Execution ===\n");
-    printf("  Sending: AT\n");
+    return healthcheck_run_lines(cfg, 1, report, cfg->health_check_timeout_ms);
+}
 
-    ssize_t n = send_at_command_and_wait(port, "AT", response,
-                                         sizeof(response), 2);
+/**
+ * Run the health check for several lines at once
+ */
+int healthcheck_run_lines(const config_t *cfgs, int count, health_report_t *reports, int deadline_ms)
+{
+    health_probe_t *probes;
+    int probe_count = 0;
+
+    if (cfgs == NULL || reports == NULL || count <= 0) {
+        return ERROR_INVALID_ARG;
+    }
 
-    if (n > 0) {
-        printf("  Response (%zd bytes): ", n);
-        printf("[HEX: ");
-        for (ssize_t i = 0; i < n; i++) {
-            printf("%02X ", response[i]);
+    memset(reports, 0, (size_t)count * sizeof(health_report_t));
+
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    probes = calloc((size_t)count * 2, sizeof(health_probe_t));
+    if (epfd < 0 || probes == NULL) {
+        if (epfd >= 0) {
+            close(epfd);
         }
-        printf("] [ASCII: ");
-        int printed = 0;
-        for (ssize_t i = 0; i < n; i++) {
-            if (response[i] >= 0x20 && response[i] <= 0x7E) {
-                putchar(response[i]);
-                printed = 1;
+        free(probes);
+        return ERROR_GENERAL;
+    }
+
+    long long now = healthcheck_monotonic_ms();
+    long long deadline = now + deadline_ms;
+
+    /* Start every probe; lines sharing a telnet target share its probe */
+    for (int i = 0; i < count; i++) {
+        health_probe_t *probe = &probes[probe_count++];
+        probe->kind = HEALTH_PROBE_SERIAL;
+        probe->cfg = &cfgs[i];
+        probe->report = &reports[i];
+        probe->fd = -1;
+        healthcheck_serial_start(probe, epfd, now);
+
+#ifdef ENABLE_LEVEL2
+        bool shared = false;
+        for (int j = 0; j < probe_count; j++) {
+            if (probes[j].kind == HEALTH_PROBE_TELNET &&
+                probes[j].cfg->telnet_port == cfgs[i].telnet_port &&
+                strcmp(probes[j].cfg->telnet_host, cfgs[i].telnet_host) == 0) {
+                shared = true;
+                break;
             }
         }
-        if (!printed) printf("(only control chars)");
-        printf("]\n");
-    } else if (n == 0) {
-        printf("  Response: (timeout)\n");
-    } else {
-        printf("  Response: (error)\n");
+        if (!shared) {
+            probe = &probes[probe_count++];
+            probe->kind = HEALTH_PROBE_TELNET;
+            probe->cfg = &cfgs[i];
+            probe->fd = -1;
+            healthcheck_telnet_start(probe, epfd, now);
+        }
+#endif
     }
 
-    /* Execute MODEM_INIT_COMMAND if configured */
-    if (cfg->modem_init_command[0] != '\0') {
-        printf("\n  --- Executing MODEM_INIT_COMMAND ---\n");
-        printf("  Raw MODEM_INIT_COMMAND: %s\n\n", cfg->modem_init_command);
+    /* One wait for all of them */
+    for (;;) {
+        long long next = deadline;
+        int pending = 0;
 
-        SAFE_STRNCPY(modem_cmd_copy, cfg->modem_init_command,
-                   sizeof(modem_cmd_copy));
-        cmd_count = parse_modem_commands(modem_cmd_copy, commands, 32);
+        for (int i = 0; i < probe_count; i++) {
+            if (!probes[i].done) {
+                pending++;
+                next = MIN(next, probes[i].step_deadline_ms);
+            }
+        }
+        if (pending == 0) {
+            break;
+        }
+
+        struct epoll_event events[16];
+        int timeout = (int)MAX(next - healthcheck_monotonic_ms(), 0);
+        int n = epoll_wait(epfd, events, 16, timeout);
+        if (n < 0 && errno != EINTR) {
+            MB_LOG_WARNING("Health check epoll_wait failed: %s", strerror(errno));
+            break;
+        }
 
-        for (int i = 0; i < cmd_count; i++) {
-            /* Add 2-second delay between commands (except before first command) */
-            if (i > 0) {
-                sleep(2);
+        now = healthcheck_monotonic_ms();
+        for (int i = 0; i < n; i++) {
+            health_probe_t *probe = events[i].data.ptr;
+            if (probe->done) {
+                continue;
             }
+            if (probe->kind == HEALTH_PROBE_SERIAL) {
+                healthcheck_serial_input(probe, now);
+            }
+#ifdef ENABLE_LEVEL2
+            else {
+                healthcheck_telnet_output(probe, epfd, now);
+            }
+#endif
+        }
 
-            printf("  Command %d/%d: %s\n", i + 1, cmd_count, commands[i]);
-
-            memset(response, 0, sizeof(response));
-            n = send_at_command_and_wait(port, commands[i], response,
-                                         sizeof(response), 2);
-
-            if (n > 0) {
-                printf("  Response (%zd bytes): ", n);
-                printf("[HEX: ");
-                for (ssize_t j = 0; j < n; j++) {
-                    printf("%02X ", response[j]);
-                }
-                printf("] [ASCII: ");
-                int printed = 0;
-                for (ssize_t j = 0; j < n; j++) {
-                    if (response[j] >= 0x20 && response[j] <= 0x7E) {
-                        putchar(response[j]);
-                        printed = 1;
-                    }
-                }
-                if (!printed) printf("(only control chars)");
-                printf("]\n\n");
-            } else if (n == 0) {
-                printf("  Response: (timeout)\n\n");
-            } else {
-                printf("  Response: (error)\n\n");
+        bool overall = (now >= deadline);
+        for (int i = 0; i < probe_count; i++) {
+            if (!probes[i].done && (overall || now >= probes[i].step_deadline_ms)) {
+                healthcheck_probe_timeout(&probes[i], epfd, now, overall);
             }
         }
+    }
 
-        printf("  Total commands sent: %d\n", cmd_count);
-    } else {
-        printf("\n  MODEM_INIT_COMMAND: (not configured)\n");
+    /* Close ports, hand telnet results to every line using the target */
+    for (int i = 0; i < probe_count; i++) {
+        health_probe_t *probe = &probes[i];
+
+        if (probe->kind == HEALTH_PROBE_SERIAL) {
+            healthcheck_serial_finish(probe);
+            continue;
+        }
+
+        char key[SMALL_BUFFER_SIZE + 16];
+        snprintf(key, sizeof(key), "%s:%d", probe->cfg->telnet_host, probe->cfg->telnet_port);
+        healthcheck_cache_store(key, &probe->result);
+
+        for (int j = 0; j < count; j++) {
+            if (cfgs[j].telnet_port == probe->cfg->telnet_port &&
+                strcmp(cfgs[j].telnet_host, probe->cfg->telnet_host) == 0) {
+                reports[j].telnet_server = probe->result;
+            }
+        }
+        if (probe->fd >= 0) {
+            close(probe->fd);
+        }
     }
 
-    printf("  ================================\n");
+#ifndef ENABLE_LEVEL2
+    /* Level 1 only uses serial/modem, telnet check not needed */
+    for (int i = 0; i < count; i++) {
+        healthcheck_set(&reports[i].telnet_server, HEALTH_STATUS_UNKNOWN,
+                        "Telnet check skipped (Level 1 mode)");
+    }
+#endif
+
+    MB_LOG_INFO("Health check: %d probe(s) for %d line(s) in %lld ms",
+               probe_count, count, healthcheck_monotonic_ms() - (deadline - deadline_ms));
 
+    close(epfd);
+    free(probes);
     return SUCCESS;
 }
 
 /**
- * Execute MODEM_HEALTH_COMMAND on an already-open port
- * Prints output directly (called during health check while port is open)
+ * Serial port availability, reusing a recent result
  */
-static int healthcheck_execute_health_commands(serial_port_t *port, const config_t *cfg,
-                                                health_report_t *report)
+health_status_t healthcheck_serial_port_cached(const char *device, health_check_result_t *result)
 {
-    unsigned char response[SMALL_BUFFER_SIZE];
-    char modem_cmd_copy[LINE_BUFFER_SIZE];
-    char *commands[32];
-    int cmd_count = 0;
+    health_check_result_t local;
+
+    if (device == NULL) {
+        return HEALTH_STATUS_UNKNOWN;
+    }
+    if (result == NULL) {
+        result = &local;
+    }
+
+    long long now = healthcheck_monotonic_ms();
+
+    pthread_mutex_lock(&health_cache_mutex);
+    for (int i = 0; i < HEALTHCHECK_CACHE_SIZE; i++) {
+        health_cache_entry_t *e = &health_cache[i];
+        if (e->key[0] != '\0' && strcmp(e->key, device) == 0 &&
+            now - e->checked_ms < HEALTHCHECK_CACHE_TTL_SEC * 1000LL) {
+            *result = e->result;
+            pthread_mutex_unlock(&health_cache_mutex);
+            return result->status;
+        }
+    }
+    pthread_mutex_unlock(&health_cache_mutex);
+
+    healthcheck_serial_port(device, result);
+    healthcheck_cache_store(device, result);
+    return result->status;
+}
+
+/**
+ * Forget the cached result of a serial port
+ */
+void healthcheck_cache_invalidate(const char *device)
+{
+    if (device == NULL) {
+        return;
+    }
 
-    (void)report;  /* Not used in this implementation */
+    pthread_mutex_lock(&health_cache_mutex);
+    for (int i = 0; i < HEALTHCHECK_CACHE_SIZE; i++) {
+        if (strcmp(health_cache[i].key, device) == 0) {
+            health_cache[i].key[0] = '\0';
+        }
+    }
+    pthread_mutex_unlock(&health_cache_mutex);
+}
 
-    if (port == NULL || cfg == NULL) {
+/**
+ * Check serial port availability
+ */
+int healthcheck_serial_port(const char *device, health_check_result_t *result)
+{
+    struct stat st;
+    int fd;
+
+    if (device == NULL || result == NULL) {
         return ERROR_INVALID_ARG;
     }
 
-    printf("\n  === Modem Health Command Execution ===\n");
+    result->status = HEALTH_STATUS_UNKNOWN;
+    memset(result->message, 0, sizeof(result->message));
 
-    /* Execute MODEM_HEALTH_COMMAND if configured */
-    if (cfg->modem_command[0] != '\0') {
-        printf("  Raw MODEM_HEALTH_COMMAND: %s\n\n", cfg->modem_command);
+    /* 1. Check if device file exists */
+    if (access(device, F_OK) != 0) {
+        result->status = HEALTH_STATUS_ERROR;
+        snprintf(result->message, sizeof(result->message),
+                "Device does not exist: %s", device);
+        return SUCCESS;
+    }
 
-        SAFE_STRNCPY(modem_cmd_copy, cfg->modem_command,
-                   sizeof(modem_cmd_copy));
-        cmd_count = parse_modem_commands(modem_cmd_copy, commands, 32);
+    /* 2. Check if it's a character device */
+    if (stat(device, &st) != 0) {
+        result->status = HEALTH_STATUS_ERROR;
+        snprintf(result->message, sizeof(result->message),
+                "Cannot stat device: %s (%s)", device, strerror(errno));
+        return SUCCESS;
+    }
 
-        for (int i = 0; i < cmd_count; i++) {
-            /* Add 1-second delay between commands (except before first command) */
-            if (i > 0) {
-                sleep(1);
-            }
+    if (!S_ISCHR(st.st_mode)) {
+        result->status = HEALTH_STATUS_ERROR;
+        snprintf(result->message, sizeof(result->message),
+                "Not a character device: %s", device);
+        return SUCCESS;
+    }
 
-            printf("  Command %d/%d: %s\n", i + 1, cmd_count, commands[i]);
-
-            memset(response, 0, sizeof(response));
-            ssize_t n = send_at_command_and_wait(port, commands[i], response,
-                                         sizeof(response), 2);
-
-            if (n > 0) {
-                printf("  Response (%zd bytes): ", n);
-                printf("[HEX: ");
-                for (ssize_t j = 0; j < n; j++) {
-                    printf("%02X ", response[j]);
-                }
-                printf("] [ASCII: ");
-                int printed = 0;
-                for (ssize_t j = 0; j < n; j++) {
-                    if (response[j] >= 0x20 && response[j] <= 0x7E) {
-                        putchar(response[j]);
-                        printed = 1;
-                    }
-                }
-                if (!printed) printf("(only control chars)");
-                printf("]\n\n");
-            } else if (n == 0) {
-                printf("  Response: (timeout)\n\n");
-            } else {
-                printf("  Response: (error)\n\n");
-            }
-        }
+    /* 3. Check read/write permissions */
+    if (access(device, R_OK | W_OK) != 0) {
+        result->status = HEALTH_STATUS_WARNING;
+        snprintf(result->message, sizeof(result->message),
+                "Permission denied: %s (try: sudo usermod -a -G dialout $USER)",
+                device);
+        return SUCCESS;
+    }
 
-        printf("  Total health commands sent: %d\n", cmd_count);
-    } else {
-        printf("  MODEM_HEALTH_COMMAND: (not configured)\n");
+    /* 4. Try to open the device */
+    fd = open(device, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (fd < 0) {
+        result->status = HEALTH_STATUS_WARNING;
+        snprintf(result->message, sizeof(result->message),
+                "Failed to open: %s (%s)", device, strerror(errno));
+        return SUCCESS;
     }
 
-    printf("  ====================================\n");
+    close(fd);
+
+    /* Success */
+    result->status = HEALTH_STATUS_OK;
+    snprintf(result->message, sizeof(result->message),
+            "Device exists and accessible: %s", device);
 
     return SUCCESS;
 }
@@ -641,13 +841,15 @@ const char *healthcheck_status_to_str(health_status_t status)
  */
 void healthcheck_print_report(const health_report_t *report, const config_t *cfg)
 {
-    (void)cfg;  /* cfg parameter no longer used - kept for API compatibility */
-
     if (report == NULL) {
         return;
     }
 
-    printf("=== Health Check ===\n");
+    if (cfg != NULL && cfg->line_id > 0) {
+        printf("=== Health Check [line.%d] ===\n", cfg->line_id);
+    } else {
+        printf("=== Health Check ===\n");
+    }
     printf("\n");
 
     printf("Serial Port:\n");
@@ -663,17 +865,22 @@ void healthcheck_print_report(const health_report_t *report, const config_t *cfg
     printf("Modem Device:\n");
     printf("  Status: %s\n", healthcheck_status_to_str(report->modem_device.status));
     printf("  %s\n", report->modem_device.message);
-
-    /* MODEM_INIT_COMMAND execution has already been done in healthcheck_run()
-     * while the serial port was open - no need to reopen here */
-
+    if (report->health_responses[0] != '\0') {
+        printf("  MODEM_HEALTH_COMMAND:\n");
+        for (const char *p = report->health_responses; *p; ) {
+            size_t len = strcspn(p, "\n");
+            printf("    %.*s\n", (int)len, p);
+            p += len + (p[len] == '\n');
+        }
+    }
     printf("\n");
 
-    /* === LEVEL 1: Telnet output DISABLED === */
-    /* printf("Telnet Server:\n");
+#ifdef ENABLE_LEVEL2
+    printf("Telnet Server:\n");
     printf("  Status: %s\n", healthcheck_status_to_str(report->telnet_server.status));
     printf("  %s\n", report->telnet_server.message);
-    printf("\n"); */
+    printf("\n");
+#endif
 
     printf("====================\n");
 }
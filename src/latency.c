@@ -0,0 +1,142 @@
+/*
+ * latency.c - Per-chunk latency tags from ingress to egress
+ */
+
+#include "latency.h"
+
+/**
+ * Record one stage sample
+ */
+static void latency_record(latency_tags_t *tags, metrics_stage_id_t stage,
+                           uint64_t now_ns, uint64_t since_ns)
+{
+    if (since_ns == 0 || now_ns < since_ns) {
+        return;
+    }
+    metrics_hist_record(&tags->metrics->stage[stage], (now_ns - since_ns) / 1000);
+}
+
+/**
+ * Initialize the stamps of a queue
+ */
+void latency_tags_init(latency_tags_t *tags, metrics_direction_t *metrics)
+{
+    if (tags == NULL) {
+        return;
+    }
+
+    memset(tags, 0, sizeof(*tags));
+    tags->metrics = metrics;
+    atomic_init(&tags->head, 0);
+    atomic_init(&tags->tail, 0);
+}
+
+/**
+ * Forget all stamps
+ */
+void latency_tags_reset(latency_tags_t *tags)
+{
+    if (tags == NULL) {
+        return;
+    }
+
+    tags->in_pos = 0;
+    tags->out_pos = 0;
+    atomic_store_explicit(&tags->head, 0, memory_order_relaxed);
+    atomic_store_explicit(&tags->tail, 0, memory_order_relaxed);
+}
+
+/**
+ * Account n bytes entering the queue
+ */
+void latency_tags_push(latency_tags_t *tags, size_t n, uint64_t ingress_ns,
+                       metrics_stage_id_t stage, uint64_t started_ns)
+{
+    if (tags == NULL || n == 0) {
+        return;
+    }
+
+    tags->in_pos += n;
+    if (tags->metrics == NULL || ingress_ns == 0) {
+        return;
+    }
+
+    uint64_t now = latency_now_ns();
+    latency_record(tags, stage, now, started_ns);
+
+    size_t head = atomic_load_explicit(&tags->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&tags->tail, memory_order_acquire);
+    if (head - tail >= LATENCY_MARKS) {
+        tags->dropped++;
+        return;
+    }
+
+    latency_mark_t *mark = &tags->marks[head & (LATENCY_MARKS - 1)];
+    mark->end = tags->in_pos;
+    mark->ingress_ns = ingress_ns;
+    mark->entered_ns = now;
+    atomic_store_explicit(&tags->head, head + 1, memory_order_release);
+}
+
+/**
+ * Account n bytes leaving the queue
+ */
+void latency_tags_pop(latency_tags_t *tags, size_t n, metrics_stage_id_t stage,
+                      bool final, uint64_t device_ns)
+{
+    if (tags == NULL || n == 0) {
+        return;
+    }
+
+    tags->out_pos += n;
+    if (tags->metrics == NULL) {
+        return;
+    }
+
+    size_t tail = atomic_load_explicit(&tags->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&tags->head, memory_order_acquire);
+    if (tail == head || tags->marks[tail & (LATENCY_MARKS - 1)].end > tags->out_pos) {
+        return;
+    }
+
+    uint64_t now = latency_now_ns();
+    while (tail != head) {
+        const latency_mark_t *mark = &tags->marks[tail & (LATENCY_MARKS - 1)];
+        if (mark->end > tags->out_pos) {
+            break;
+        }
+
+        latency_record(tags, stage, now, mark->entered_ns);
+        if (final) {
+            latency_record(tags, METRICS_STAGE_TOTAL, now, mark->ingress_ns);
+            if (device_ns > 0) {
+                metrics_hist_record(&tags->metrics->stage[METRICS_STAGE_DEVICE], device_ns / 1000);
+            }
+        }
+        tail++;
+    }
+    atomic_store_explicit(&tags->tail, tail, memory_order_release);
+}
+
+/**
+ * Stamp for the bytes at the front of the queue
+ */
+void latency_tags_stamp(const latency_tags_t *tags, latency_stamp_t *stamp)
+{
+    if (stamp == NULL) {
+        return;
+    }
+
+    stamp->ingress_ns = 0;
+    stamp->handoff_ns = 0;
+    if (tags == NULL || tags->metrics == NULL) {
+        return;
+    }
+
+    size_t tail = atomic_load_explicit(&tags->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&tags->head, memory_order_acquire);
+    if (tail != head) {
+        stamp->ingress_ns = tags->marks[tail & (LATENCY_MARKS - 1)].ingress_ns;
+        stamp->handoff_ns = latency_now_ns();
+    }
+}
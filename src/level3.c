@@ -7,22 +7,24 @@
  */
 
 #include "level3.h"
+#include "trace.h"
 #include <sys/time.h>
 #include <time.h>
 #include <string.h>
 #include <stdio.h>
 #include <errno.h>
 #include <unistd.h>
-
-/* Global state for telnet connection attempts in CONNECTING state */
-bool g_level3_connection_attempted = false;
-time_t g_level3_last_attempt = 0;
-bool g_level3_transition_logged = false;
+#include <sys/mman.h>
+#include <sched.h>
+#include <poll.h>
+#include <sys/eventfd.h>
 
 /* Forward declaration of Hayes dictionary */
 static const hayes_dictionary_t hayes_dictionary;
 
 /* Internal helper functions - Forward declarations */
+static void l3_double_buffer_claim(l3_double_buffer_t *dbuf);
+static bool l3_double_buffer_publish(l3_double_buffer_t *dbuf);
 static void l3_update_pipeline_stats(l3_pipeline_t *pipeline, size_t bytes_processed, double processing_time);
 static int l3_init_enhanced_scheduling(l3_context_t *l3_ctx);
 static int l3_process_pipeline_with_quantum(l3_context_t *l3_ctx, l3_pipeline_direction_t direction);
@@ -34,6 +36,7 @@ static int l3_get_scheduling_statistics(l3_context_t *l3_ctx, l3_scheduling_stat
 static const char *l3_get_direction_name(l3_pipeline_direction_t direction);
 static int l3_process_serial_to_telnet_chunk(l3_context_t *l3_ctx);
 static int l3_process_telnet_to_serial_chunk(l3_context_t *l3_ctx);
+static bool l3_xfer_raw(l3_context_t *l3_ctx);
 
 /* Enhanced scheduling with latency bound guarantee */
 static int l3_enforce_latency_boundaries(l3_context_t *l3_ctx);
@@ -125,135 +128,309 @@ static size_t l3_echo_to_modem(l3_context_t *l3_ctx, const unsigned char *data,
     /* Write to telnet-to-serial buffer for echo */
     size_t written = ts_cbuf_write(&l3_ctx->bridge->ts_telnet_to_serial_buf, data, len);
 
-    if (written > 0) {
-        MB_LOG_DEBUG("Echo to modem: %zu bytes", written);
-
-        /* Debug output for echo content */
-        if (written <= 10) {
-            char hex_str[32];
-            size_t pos = 0;
-            for (size_t i = 0; i < written && pos < sizeof(hex_str)-3; i++) {
-                pos += snprintf(hex_str + pos, sizeof(hex_str) - pos, "%02X ", data[i]);
-            }
-            MB_LOG_DEBUG("Echo bytes: %s", hex_str);
-        }
-    }
+    MB_TRACE_DATA(TRACE_L3_ECHO, written, len, data, written);
 
     return written;
 }
 
 /* ========== Level 3 Context Management ========== */
 
-/* ========== DCD Event Bridge Functions ========== */
+/* ========== State Transition Table ========== */
+
+/* Legal transitions out of each state (bit per target state) */
+#define L3_BIT(state)   (1u << (state))
+#define L3_ALLOWED_UNINITIALIZED    (L3_BIT(L3_STATE_INITIALIZING))
+#define L3_ALLOWED_INITIALIZING     (L3_BIT(L3_STATE_READY) | L3_BIT(L3_STATE_ERROR))
+#define L3_ALLOWED_READY            (L3_BIT(L3_STATE_CONNECTING) | L3_BIT(L3_STATE_SHUTTING_DOWN) | \
+                                     L3_BIT(L3_STATE_ERROR))
+#define L3_ALLOWED_CONNECTING       (L3_BIT(L3_STATE_NEGOTIATING) | L3_BIT(L3_STATE_DATA_TRANSFER) | \
+                                     L3_BIT(L3_STATE_READY) | L3_BIT(L3_STATE_ERROR))
+#define L3_ALLOWED_NEGOTIATING      (L3_BIT(L3_STATE_DATA_TRANSFER) | L3_BIT(L3_STATE_CONNECTING) | \
+                                     L3_BIT(L3_STATE_READY) | L3_BIT(L3_STATE_ERROR))
+#define L3_ALLOWED_DATA_TRANSFER    (L3_BIT(L3_STATE_FLUSHING) | L3_BIT(L3_STATE_SHUTTING_DOWN) | \
+                                     L3_BIT(L3_STATE_ERROR))
+#define L3_ALLOWED_FLUSHING         (L3_BIT(L3_STATE_TERMINATED) | L3_BIT(L3_STATE_SHUTTING_DOWN) | \
+                                     L3_BIT(L3_STATE_ERROR))
+#define L3_ALLOWED_SHUTTING_DOWN    (L3_BIT(L3_STATE_TERMINATED) | L3_BIT(L3_STATE_ERROR))
+#define L3_ALLOWED_TERMINATED       0u
+#define L3_ALLOWED_ERROR            (L3_BIT(L3_STATE_READY) | L3_BIT(L3_STATE_SHUTTING_DOWN) | \
+                                     L3_BIT(L3_STATE_TERMINATED))
+
+/* Event-driven transitions: X(from, event, to) */
+#define L3_TRANSITIONS(X) \
+    X(INITIALIZING,  L1_READY,            READY) \
+    X(INITIALIZING,  TIMEOUT,             READY) \
+    X(READY,         DCD_RISING,          CONNECTING) \
+    X(CONNECTING,    TELNET_CONNECTED,    DATA_TRANSFER) \
+    X(CONNECTING,    DCD_FALLING,         READY) \
+    X(CONNECTING,    TIMEOUT,             READY) \
+    X(NEGOTIATING,   NEGOTIATED,          DATA_TRANSFER) \
+    X(NEGOTIATING,   TIMEOUT,             DATA_TRANSFER) \
+    X(NEGOTIATING,   DCD_FALLING,         READY) \
+    X(DATA_TRANSFER, DCD_FALLING,         FLUSHING) \
+    X(DATA_TRANSFER, TELNET_DISCONNECTED, FLUSHING) \
+    X(FLUSHING,      FLUSHED,             SHUTTING_DOWN) \
+    X(FLUSHING,      TIMEOUT,             SHUTTING_DOWN) \
+    X(SHUTTING_DOWN, STOPPED,             TERMINATED) \
+    X(SHUTTING_DOWN, TIMEOUT,             TERMINATED) \
+    X(ERROR,         RECOVER,             READY)
+
+/* Every entry must be a legal transition (checked by the compiler) */
+#define L3_CHECK_TRANSITION(from, event, to) \
+    _Static_assert(L3_ALLOWED_##from & L3_BIT(L3_STATE_##to), \
+                   "Level 3: " #from " -> " #to " on " #event " is not a legal transition");
+L3_TRANSITIONS(L3_CHECK_TRANSITION)
+
+/* UNINITIALIZED is never a target, so a zero entry means "no transition" */
+#define L3_NO_TRANSITION    L3_STATE_UNINITIALIZED
+_Static_assert(L3_NO_TRANSITION == 0, "unlisted table entries must read as no transition");
+_Static_assert(L3_STATE_COUNT <= 32, "allowed-transition masks hold one bit per state");
+
+#define L3_TRANSITION_ENTRY(from, event, to) \
+    [L3_STATE_##from][L3_EVENT_##event] = L3_STATE_##to,
+static const unsigned char l3_transition_table[L3_STATE_COUNT][L3_EVENT_COUNT] = {
+    L3_TRANSITIONS(L3_TRANSITION_ENTRY)
+};
+
+static const unsigned int l3_allowed_transitions[L3_STATE_COUNT] = {
+    [L3_STATE_UNINITIALIZED] = L3_ALLOWED_UNINITIALIZED,
+    [L3_STATE_INITIALIZING]  = L3_ALLOWED_INITIALIZING,
+    [L3_STATE_READY]         = L3_ALLOWED_READY,
+    [L3_STATE_CONNECTING]    = L3_ALLOWED_CONNECTING,
+    [L3_STATE_NEGOTIATING]   = L3_ALLOWED_NEGOTIATING,
+    [L3_STATE_DATA_TRANSFER] = L3_ALLOWED_DATA_TRANSFER,
+    [L3_STATE_FLUSHING]      = L3_ALLOWED_FLUSHING,
+    [L3_STATE_SHUTTING_DOWN] = L3_ALLOWED_SHUTTING_DOWN,
+    [L3_STATE_TERMINATED]    = L3_ALLOWED_TERMINATED,
+    [L3_STATE_ERROR]         = L3_ALLOWED_ERROR,
+};
+
+/* Timeout armed on entering a state (seconds, 0 = none) */
+static const int l3_state_timeouts[L3_STATE_COUNT] = {
+    [L3_STATE_INITIALIZING]  = LEVEL3_INIT_TIMEOUT,
+    [L3_STATE_CONNECTING]    = LEVEL3_CONNECT_TIMEOUT,
+    [L3_STATE_FLUSHING]      = LEVEL3_SHUTDOWN_TIMEOUT,
+    [L3_STATE_SHUTTING_DOWN] = 5,
+};
+
+/* ========== Event Queue ========== */
 
 /**
- * Handle DCD rising edge event - activates pipeline when ready
- * @param l3_ctx Level 3 context
- * @return SUCCESS on success, error code on failure
+ * Post a state machine event (any thread, lock-free)
  */
-int l3_on_dcd_rising(l3_context_t *l3_ctx)
+int l3_post_event(l3_context_t *l3_ctx, l3_event_t event)
 {
-    printf("[DEBUG-L3] l3_on_dcd_rising() ENTRY: l3_ctx=%p\n", (void*)l3_ctx);
-    fflush(stdout);
-
-    if (l3_ctx == NULL) {
-        printf("[ERROR-L3] l3_ctx is NULL!\n");
-        fflush(stdout);
+    if (l3_ctx == NULL || (unsigned int)event >= L3_EVENT_COUNT) {
         return L3_ERROR_INVALID_PARAM;
     }
 
-    printf("[DEBUG-L3] About to try locking state_mutex (non-blocking)\n");
-    fflush(stdout);
+    l3_event_queue_t *q = &l3_ctx->events;
+    size_t pos = atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed);
+    l3_event_slot_t *slot;
+    int ret = L3_SUCCESS;
 
-    /* Use trylock to avoid deadlock with l3_process_state_machine() */
-    int lock_ret = pthread_mutex_trylock(&l3_ctx->state_mutex);
-    if (lock_ret != 0) {
-        /* Mutex is already locked by state machine - just set flags and return */
-        printf("[DEBUG-L3] state_mutex is busy (held by state machine), setting flags atomically\n");
-        fflush(stdout);
+    for (;;) {
+        slot = &q->slots[pos & L3_EVENT_QUEUE_MASK];
+        size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
 
-        /* These flag updates are atomic enough for our purposes */
-        l3_ctx->dcd_state = true;
-        l3_ctx->dcd_rising_detected = true;
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&q->enqueue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            slot = NULL;
+            break;
+        } else {
+            pos = atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed);
+        }
+    }
 
-        printf("[INFO-L3] DCD rising edge flags set, state machine will process on next cycle\n");
-        fflush(stdout);
-        MB_LOG_INFO("DCD rising edge detected - flags set for state machine processing");
+    if (slot != NULL) {
+        slot->event = event;
+        atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+    } else {
+        atomic_fetch_add_explicit(&q->dropped, 1, memory_order_relaxed);
+        atomic_store_explicit(&q->overflowed, true, memory_order_release);
+        ret = L3_ERROR_QUEUE_FULL;
+    }
 
-        return L3_SUCCESS;
+    if (q->wake_fd >= 0) {
+        uint64_t one = 1;
+        ssize_t n = write(q->wake_fd, &one, sizeof(one));
+        (void)n;
     }
+    return ret;
+}
 
-    printf("[DEBUG-L3] state_mutex locked successfully\n");
-    fflush(stdout);
+/**
+ * Take the oldest posted event (management thread only)
+ * @return true if an event was taken
+ */
+static bool l3_take_event(l3_context_t *l3_ctx, l3_event_t *event)
+{
+    l3_event_queue_t *q = &l3_ctx->events;
+    size_t pos = atomic_load_explicit(&q->dequeue_pos, memory_order_relaxed);
+    l3_event_slot_t *slot = &q->slots[pos & L3_EVENT_QUEUE_MASK];
 
-    printf("[DEBUG-L3] system_state=%d, level1_ready=%d, level2_ready=%d\n",
-           l3_ctx->system_state, l3_ctx->level1_ready, l3_ctx->level2_ready);
-    fflush(stdout);
+    if (atomic_load_explicit(&slot->seq, memory_order_acquire) != pos + 1) {
+        return false;
+    }
 
-    /* Set DCD state */
-    l3_ctx->dcd_state = true;
-    l3_ctx->dcd_rising_detected = true;
+    *event = slot->event;
+    atomic_store_explicit(&slot->seq, pos + L3_EVENT_QUEUE_SLOTS, memory_order_release);
+    atomic_store_explicit(&q->dequeue_pos, pos + 1, memory_order_relaxed);
+    return true;
+}
 
-    /* Process DCD rising - state machine will handle L2 connection wait */
-    if (l3_ctx->system_state == L3_STATE_READY) {
-        printf("[INFO-L3] DCD rising edge detected in READY state - triggering connection\n");
-        fflush(stdout);
-        MB_LOG_INFO("DCD rising edge detected in READY state - triggering connection");
+/**
+ * Sleep until an event is posted or timeout_ms passes (management thread only)
+ */
+static void l3_wait_event(l3_context_t *l3_ctx, int timeout_ms)
+{
+    l3_event_queue_t *q = &l3_ctx->events;
 
-        /* Signal state machine to process the transition */
-        printf("[DEBUG-L3] Broadcasting state_condition\n");
-        fflush(stdout);
-        pthread_cond_broadcast(&l3_ctx->state_condition);
-    } else {
-        printf("[DEBUG-L3] DCD rising edge detected in state=%s, L1=%d, L2=%d\n",
-               l3_system_state_to_string(l3_ctx->system_state),
-               l3_ctx->level1_ready, l3_ctx->level2_ready);
-        fflush(stdout);
-        MB_LOG_DEBUG("DCD rising edge detected in state: %s (L1=%s, L2=%s)",
-                    l3_system_state_to_string(l3_ctx->system_state),
-                    l3_ctx->level1_ready ? "Ready" : "Not Ready",
-                    l3_ctx->level2_ready ? "Ready" : "Not Ready");
+    if (q->wake_fd < 0) {
+        usleep((useconds_t)timeout_ms * 1000);
+        return;
     }
 
-    printf("[DEBUG-L3] About to unlock state_mutex\n");
-    fflush(stdout);
-    pthread_mutex_unlock(&l3_ctx->state_mutex);
-    printf("[DEBUG-L3] l3_on_dcd_rising() returning L3_SUCCESS\n");
-    fflush(stdout);
-    return L3_SUCCESS;
+    struct pollfd pfd = { .fd = q->wake_fd, .events = POLLIN, .revents = 0 };
+    if (poll(&pfd, 1, timeout_ms) > 0) {
+        uint64_t count;
+        ssize_t n = read(q->wake_fd, &count, sizeof(count));
+        (void)n;
+    }
 }
 
 /**
- * Handle DCD falling edge event - triggers graceful shutdown
+ * Apply one event: transition if the table has an entry for the current state
+ * (management thread only)
+ */
+static int l3_dispatch_event(l3_context_t *l3_ctx, l3_event_t event)
+{
+    l3_system_state_t state = l3_get_system_state(l3_ctx);
+    l3_system_state_t to = (l3_system_state_t)l3_transition_table[state][event];
+
+    if (to == L3_NO_TRANSITION) {
+        MB_LOG_DEBUG("Level 3 event %s ignored in state %s",
+                    l3_event_to_string(event), l3_system_state_to_string(state));
+        return L3_SUCCESS;
+    }
+
+    MB_LOG_INFO("Level 3 event %s in state %s", l3_event_to_string(event),
+                l3_system_state_to_string(state));
+
+    /* Entry actions that must be visible before the new state is */
+    switch (to) {
+        case L3_STATE_CONNECTING:
+            l3_ctx->connection_attempted = false;
+            l3_ctx->transition_logged = false;
+            l3_ctx->data_transfer_logged = false;
+            l3_ctx->wait_log_counter = 0;
+            break;
+        case L3_STATE_DATA_TRANSFER:
+            l3_ctx->negotiation_complete = true;
+            /* Enable Level 3 processing BEFORE state transition */
+            atomic_store_explicit(&l3_ctx->level3_active, true, memory_order_release);
+            break;
+        case L3_STATE_TERMINATED:
+            /* Graceful shutdown - disable Level 3 processing */
+            atomic_store_explicit(&l3_ctx->level3_active, false, memory_order_release);
+            break;
+        default:
+            break;
+    }
+
+    return l3_set_system_state(l3_ctx, to, l3_state_timeouts[to]);
+}
+
+/**
+ * Apply the events other threads posted (management thread only)
+ */
+static void l3_drain_events(l3_context_t *l3_ctx)
+{
+    l3_event_t event;
+
+    while (l3_take_event(l3_ctx, &event)) {
+        switch (event) {
+            case L3_EVENT_DCD_RISING:
+                l3_ctx->dcd_state = true;
+                l3_ctx->dcd_rising_detected = true;
+                l3_ctx->dcd_change_time = time(NULL);
+                break;
+            case L3_EVENT_DCD_FALLING:
+                l3_ctx->dcd_state = false;
+                l3_ctx->dcd_rising_detected = false;
+                l3_ctx->dcd_change_time = time(NULL);
+                break;
+            default:
+                break;
+        }
+        if (event == L3_EVENT_DCD_RISING && l3_get_system_state(l3_ctx) != L3_STATE_READY) {
+            /* Kept pending until READY (see l3_process_state_machine) */
+            MB_LOG_DEBUG("DCD rising edge detected in state: %s (L1=%s, L2=%s)",
+                        l3_system_state_to_string(l3_get_system_state(l3_ctx)),
+                        l3_ctx->level1_ready ? "Ready" : "Not Ready",
+                        l3_ctx->level2_ready ? "Ready" : "Not Ready");
+            continue;
+        }
+        if (event == L3_EVENT_DCD_RISING) {
+            l3_ctx->dcd_rising_detected = false;
+        }
+        l3_dispatch_event(l3_ctx, event);
+    }
+
+    /* A full queue lost an event: the line level says which DCD edge is due */
+    if (atomic_exchange_explicit(&l3_ctx->events.overflowed, false, memory_order_acquire)) {
+        bool line = atomic_load_explicit(&l3_ctx->dcd_line, memory_order_acquire);
+        MB_LOG_WARNING("Level 3 event queue overflowed (%llu events dropped), DCD is %s",
+                      (unsigned long long)atomic_load(&l3_ctx->events.dropped),
+                      line ? "high" : "low");
+        if (line != l3_ctx->dcd_state) {
+            l3_post_event(l3_ctx, line ? L3_EVENT_DCD_RISING : L3_EVENT_DCD_FALLING);
+        }
+    }
+}
+
+/* ========== DCD Event Bridge Functions ========== */
+
+/**
+ * Handle DCD rising edge event - activates pipeline when ready
  * @param l3_ctx Level 3 context
  * @return SUCCESS on success, error code on failure
  */
-int l3_on_dcd_falling(l3_context_t *l3_ctx)
+int l3_on_dcd_rising(l3_context_t *l3_ctx)
 {
     if (l3_ctx == NULL) {
         return L3_ERROR_INVALID_PARAM;
     }
 
-    pthread_mutex_lock(&l3_ctx->state_mutex);
+    atomic_store_explicit(&l3_ctx->dcd_line, true, memory_order_release);
+    MB_TRACE(TRACE_L3_DCD, 1, l3_get_system_state(l3_ctx));
+    MB_LOG_INFO("DCD rising edge detected - queued for the state machine");
 
-    l3_ctx->dcd_state = false;
-    l3_ctx->dcd_rising_detected = false;
+    return l3_post_event(l3_ctx, L3_EVENT_DCD_RISING);
+}
 
-    /* If we're in data transfer mode, initiate graceful shutdown */
-    if (l3_ctx->system_state == L3_STATE_DATA_TRANSFER) {
-        MB_LOG_INFO("DCD falling edge detected during data transfer - initiating shutdown");
-        l3_set_system_state(l3_ctx, L3_STATE_FLUSHING, LEVEL3_SHUTDOWN_TIMEOUT);
-    } else if (l3_ctx->system_state == L3_STATE_CONNECTING ||
-               l3_ctx->system_state == L3_STATE_NEGOTIATING) {
-        MB_LOG_INFO("DCD falling edge detected during connection - aborting to READY");
-        l3_set_system_state(l3_ctx, L3_STATE_READY, 0);
-    } else {
-        MB_LOG_DEBUG("DCD falling edge detected in state: %s",
-                    l3_system_state_to_string(l3_ctx->system_state));
+/**
+ * Handle DCD falling edge event - triggers graceful shutdown
+ * @param l3_ctx Level 3 context
+ * @return SUCCESS on success, error code on failure
+ */
+int l3_on_dcd_falling(l3_context_t *l3_ctx)
+{
+    if (l3_ctx == NULL) {
+        return L3_ERROR_INVALID_PARAM;
     }
 
-    pthread_mutex_unlock(&l3_ctx->state_mutex);
-    return L3_SUCCESS;
+    atomic_store_explicit(&l3_ctx->dcd_line, false, memory_order_release);
+    MB_TRACE(TRACE_L3_DCD, 0, l3_get_system_state(l3_ctx));
+    MB_LOG_INFO("DCD falling edge detected - queued for the state machine");
+
+    return l3_post_event(l3_ctx, L3_EVENT_DCD_FALLING);
 }
 
 /**
@@ -267,11 +444,7 @@ bool l3_get_dcd_state(l3_context_t *l3_ctx)
         return false;
     }
 
-    pthread_mutex_lock(&l3_ctx->state_mutex);
-    bool dcd_state = l3_ctx->dcd_state;
-    pthread_mutex_unlock(&l3_ctx->state_mutex);
-
-    return dcd_state;
+    return atomic_load_explicit(&l3_ctx->dcd_line, memory_order_acquire);
 }
 
 /**
@@ -285,16 +458,13 @@ int l3_init_dcd_monitoring(l3_context_t *l3_ctx)
         return L3_ERROR_INVALID_PARAM;
     }
 
-    pthread_mutex_lock(&l3_ctx->state_mutex);
-
-    /* Initialize DCD state */
+    /* Initialize DCD state (before the management thread runs) */
     l3_ctx->dcd_state = false;
     l3_ctx->dcd_rising_detected = false;
+    atomic_store(&l3_ctx->dcd_line, false);
     l3_ctx->dcd_change_time = time(NULL);
 
     MB_LOG_INFO("DCD monitoring initialized for Level 3");
-
-    pthread_mutex_unlock(&l3_ctx->state_mutex);
     return L3_SUCCESS;
 }
 
@@ -317,40 +487,49 @@ const char *l3_system_state_to_string(l3_system_state_t state)
     }
 }
 
+const char *l3_event_to_string(l3_event_t event)
+{
+    switch (event) {
+        case L3_EVENT_L1_READY:             return "L1_READY";
+        case L3_EVENT_DCD_RISING:           return "DCD_RISING";
+        case L3_EVENT_DCD_FALLING:          return "DCD_FALLING";
+        case L3_EVENT_TELNET_CONNECTED:     return "TELNET_CONNECTED";
+        case L3_EVENT_TELNET_DISCONNECTED:  return "TELNET_DISCONNECTED";
+        case L3_EVENT_NEGOTIATED:           return "NEGOTIATED";
+        case L3_EVENT_FLUSHED:              return "FLUSHED";
+        case L3_EVENT_STOPPED:              return "STOPPED";
+        case L3_EVENT_TIMEOUT:              return "TIMEOUT";
+        case L3_EVENT_RECOVER:              return "RECOVER";
+        default:                            return "UNKNOWN";
+    }
+}
+
 int l3_set_system_state(l3_context_t *l3_ctx, l3_system_state_t new_state, int timeout_seconds)
 {
     if (l3_ctx == NULL) {
         return L3_ERROR_INVALID_PARAM;
     }
 
-    pthread_mutex_lock(&l3_ctx->state_mutex);
+    l3_system_state_t old_state = l3_get_system_state(l3_ctx);
 
     /* Check if transition is valid */
-    if (!l3_is_valid_state_transition(l3_ctx->system_state, new_state)) {
+    if (!l3_is_valid_state_transition(old_state, new_state)) {
         MB_LOG_ERROR("Invalid state transition: %s -> %s",
-                    l3_system_state_to_string(l3_ctx->system_state),
+                    l3_system_state_to_string(old_state),
                     l3_system_state_to_string(new_state));
-        pthread_mutex_unlock(&l3_ctx->state_mutex);
         return L3_ERROR_INVALID_STATE;
     }
 
-    /* Update state */
-    l3_system_state_t old_state = l3_ctx->system_state;
-    l3_ctx->previous_state = old_state;
-    l3_ctx->system_state = new_state;
-    l3_ctx->state_change_time = time(NULL);
-    l3_ctx->state_timeout = timeout_seconds;
-    l3_ctx->state_transitions++;
-
-    MB_LOG_INFO("Level 3 state transition: %s -> %s (timeout: %ds)",
-                l3_system_state_to_string(old_state),
-                l3_system_state_to_string(new_state),
-                timeout_seconds);
-
-    /* Special handling for DATA_TRANSFER state */
+    /* Special handling for DATA_TRANSFER state (filters belong to this thread) */
     if (new_state == L3_STATE_DATA_TRANSFER) {
         /* Set Hayes filter to online mode when entering data transfer */
-        l3_ctx->pipeline_serial_to_telnet.filter_state.hayes_ctx.in_online_mode = true;
+        hayes_filter_context_t *hayes_ctx = &l3_ctx->pipeline_serial_to_telnet.filter_state.hayes_ctx;
+        hayes_ctx->in_online_mode = true;
+        hayes_ctx->line_passthrough = false;
+        hayes_escape_reset(&hayes_ctx->escape, l3_get_timestamp_ms());
+#ifdef ENABLE_LEVEL2
+        charset_conv_reset(&l3_ctx->bridge->charset_to_telnet);
+#endif
         MB_LOG_INFO("Hayes filter set to ONLINE mode for data transfer");
     } else if (old_state == L3_STATE_DATA_TRANSFER &&
                (new_state == L3_STATE_FLUSHING || new_state == L3_STATE_SHUTTING_DOWN)) {
@@ -359,56 +538,31 @@ int l3_set_system_state(l3_context_t *l3_ctx, l3_system_state_t new_state, int t
         MB_LOG_INFO("Hayes filter set to COMMAND mode");
     }
 
-    /* Signal state change */
-    pthread_cond_broadcast(&l3_ctx->state_condition);
+    /* Update state: bookkeeping first, then publish the state word */
+    l3_ctx->previous_state = old_state;
+    l3_ctx->state_change_time = time(NULL);
+    l3_ctx->state_timeout = timeout_seconds;
+    l3_ctx->state_transitions++;
+    atomic_store_explicit(&l3_ctx->system_state, new_state, memory_order_release);
 
-    pthread_mutex_unlock(&l3_ctx->state_mutex);
+    MB_LOG_INFO("Level 3 state transition: %s -> %s (timeout: %ds)",
+                l3_system_state_to_string(old_state),
+                l3_system_state_to_string(new_state),
+                timeout_seconds);
+
+    /* Data-path threads poll the state word; an event loop may need a kick */
+    bridge_wake(l3_ctx->bridge);
     return L3_SUCCESS;
 }
 
 bool l3_is_valid_state_transition(l3_system_state_t from_state, l3_system_state_t to_state)
 {
-    /* Same state - no transition */
-    if (from_state == to_state) {
+    if ((unsigned int)from_state >= L3_STATE_COUNT || (unsigned int)to_state >= L3_STATE_COUNT) {
         return false;
     }
 
-    switch (from_state) {
-        case L3_STATE_UNINITIALIZED:
-            return (to_state == L3_STATE_INITIALIZING);
-
-        case L3_STATE_INITIALIZING:
-            return (to_state == L3_STATE_READY || to_state == L3_STATE_ERROR);
-
-        case L3_STATE_READY:
-            return (to_state == L3_STATE_CONNECTING || to_state == L3_STATE_SHUTTING_DOWN || to_state == L3_STATE_ERROR);
-
-        case L3_STATE_CONNECTING:
-            return (to_state == L3_STATE_NEGOTIATING || to_state == L3_STATE_DATA_TRANSFER || to_state == L3_STATE_READY || to_state == L3_STATE_ERROR);
-
-        case L3_STATE_NEGOTIATING:
-            return (to_state == L3_STATE_DATA_TRANSFER || to_state == L3_STATE_CONNECTING || to_state == L3_STATE_ERROR);
-
-        case L3_STATE_DATA_TRANSFER:
-            return (to_state == L3_STATE_FLUSHING || to_state == L3_STATE_SHUTTING_DOWN || to_state == L3_STATE_ERROR);
-
-        case L3_STATE_FLUSHING:
-            return (to_state == L3_STATE_TERMINATED || to_state == L3_STATE_SHUTTING_DOWN || to_state == L3_STATE_ERROR);
-
-        case L3_STATE_SHUTTING_DOWN:
-            return (to_state == L3_STATE_TERMINATED || to_state == L3_STATE_ERROR);
-
-        case L3_STATE_TERMINATED:
-            /* Terminal state - no further transitions */
-            return false;
-
-        case L3_STATE_ERROR:
-            /* From error, can attempt recovery or shutdown */
-            return (to_state == L3_STATE_READY || to_state == L3_STATE_SHUTTING_DOWN || to_state == L3_STATE_TERMINATED);
-
-        default:
-            return false;
-    }
+    /* Same state is never in the masks - no transition */
+    return (l3_allowed_transitions[from_state] & L3_BIT(to_state)) != 0;
 }
 
 int l3_process_state_machine(l3_context_t *l3_ctx)
@@ -417,22 +571,25 @@ int l3_process_state_machine(l3_context_t *l3_ctx)
         return L3_ERROR_INVALID_PARAM;
     }
 
-    pthread_mutex_lock(&l3_ctx->state_mutex);
-
     int ret = L3_SUCCESS;
-    l3_system_state_t current_state = l3_ctx->system_state;
+
+    /* Events from other threads first (DCD edges) */
+    l3_drain_events(l3_ctx);
 
     /* Check for timeout */
     if (l3_is_state_timed_out(l3_ctx)) {
         ret = l3_handle_state_timeout(l3_ctx);
         if (ret != L3_SUCCESS) {
             MB_LOG_ERROR("State timeout handling failed");
-            pthread_mutex_unlock(&l3_ctx->state_mutex);
             return ret;
         }
     }
 
-    /* Process current state */
+    l3_system_state_t current_state = l3_get_system_state(l3_ctx);
+    MB_TRACE(TRACE_L3_STATE, current_state,
+             l3_ctx->level1_ready | (l3_ctx->level2_ready << 1) | (l3_ctx->dcd_state << 2));
+
+    /* Raise the events this thread observes */
     switch (current_state) {
         case L3_STATE_INITIALIZING:
             /* Check if initialization is complete */
@@ -443,10 +600,6 @@ int l3_process_state_machine(l3_context_t *l3_ctx)
             l3_ctx->level2_ready = false;
 #endif
 
-            printf("[DEBUG-STATE-MACHINE] INITIALIZING: L1_ready=%d, L2_ready=%d, DCD_detected=%d\n",
-                   l3_ctx->level1_ready, l3_ctx->level2_ready, l3_ctx->dcd_rising_detected);
-            fflush(stdout);
-
             /* Level 3 strategy: L1 ready is sufficient to enter READY state
              * L2 (telnet) will be connected when DCD rising edge occurs */
             if (l3_ctx->level1_ready) {
@@ -455,33 +608,20 @@ int l3_process_state_machine(l3_context_t *l3_ctx)
                 fflush(stdout);
                 MB_LOG_INFO("Level 1 ready - entering READY state (L2=%s)",
                            l3_ctx->level2_ready ? "connected" : "will connect on DCD");
-                pthread_mutex_unlock(&l3_ctx->state_mutex);
-                ret = l3_set_system_state(l3_ctx, L3_STATE_READY, 0);
-                pthread_mutex_lock(&l3_ctx->state_mutex);
+                ret = l3_dispatch_event(l3_ctx, L3_EVENT_L1_READY);
             } else {
                 /* Level 1 not ready - wait */
-                static int log_counter_l1 = 0;
-                if (++log_counter_l1 % 10 == 1) {  /* Log every 10 cycles */
-                    printf("[DEBUG-STATE-MACHINE] Waiting for Level 1 (serial/modem) connection\n");
-                    fflush(stdout);
+                if (++l3_ctx->wait_log_counter % 10 == 1) {  /* Log every 10 cycles */
                     MB_LOG_DEBUG("Waiting for Level 1 (serial/modem) connection");
                 }
             }
             break;
 
         case L3_STATE_READY:
-            /* Wait for DCD rising edge to trigger connection */
             /* Update L2 status in case it connects while waiting */
             l3_ctx->level2_ready = telnet_is_connected(&l3_ctx->bridge->telnet);
 
-            /* Reduce log spam - only log periodically (every 5 seconds) */
-            static int log_counter_ready = 0;
-            if (++log_counter_ready % 10 == 1) {
-                printf("[DEBUG-STATE-MACHINE] READY: DCD_rising_detected=%d, L2_ready=%d\n",
-                       l3_ctx->dcd_rising_detected, l3_ctx->level2_ready);
-                fflush(stdout);
-            }
-
+            /* A DCD rising edge that arrived before READY is still pending */
             if (l3_ctx->dcd_rising_detected) {
                 printf("[INFO-STATE-MACHINE] DCD rising edge detected in READY - starting connection (L2=%s)\n",
                        l3_ctx->level2_ready ? "connected" : "not connected yet");
@@ -489,44 +629,29 @@ int l3_process_state_machine(l3_context_t *l3_ctx)
                 MB_LOG_INFO("DCD rising edge detected - starting connection (L2=%s)",
                            l3_ctx->level2_ready ? "connected" : "will wait for connection");
                 l3_ctx->dcd_rising_detected = false;  /* Reset flag */
-
-                /* Reset connection attempt flag for CONNECTING state */
-                extern bool g_level3_connection_attempted;
-                g_level3_connection_attempted = false;
-
-                /* Reset transition log flag for next connection */
-                extern bool g_level3_transition_logged;
-                g_level3_transition_logged = false;
-
-                pthread_mutex_unlock(&l3_ctx->state_mutex);
-                ret = l3_set_system_state(l3_ctx, L3_STATE_CONNECTING, LEVEL3_CONNECT_TIMEOUT);
-                pthread_mutex_lock(&l3_ctx->state_mutex);
+                ret = l3_dispatch_event(l3_ctx, L3_EVENT_DCD_RISING);
             }
             break;
 
         case L3_STATE_CONNECTING:
-            /* Attempt telnet connection if not already connected */
-            if (!telnet_is_connected(&l3_ctx->bridge->telnet)) {
+            /* Attempt telnet connection if not already connected or connecting
+             * (a connect opened on RING, or one still trying addresses) */
+            if (!telnet_is_connected(&l3_ctx->bridge->telnet) &&
+                !l3_ctx->bridge->telnet.is_connecting) {
                 /* Check if we should attempt connection (first time or after error) */
                 time_t now = time(NULL);
 
                 /* Attempt connection: first time entering CONNECTING, or retry after 2 seconds */
-                if (!g_level3_connection_attempted || (now - g_level3_last_attempt) >= 2) {
-                    printf("[INFO-STATE-MACHINE] Attempting telnet connection to %s:%d\n",
-                           l3_ctx->bridge->config->telnet_host, l3_ctx->bridge->config->telnet_port);
+                if (!l3_ctx->connection_attempted || (now - l3_ctx->last_attempt) >= 2) {
+                    printf("[INFO-STATE-MACHINE] Attempting telnet connection\n");
                     fflush(stdout);
-                    MB_LOG_INFO("Attempting telnet connection to %s:%d",
-                               l3_ctx->bridge->config->telnet_host, l3_ctx->bridge->config->telnet_port);
+                    MB_LOG_INFO("Attempting telnet connection");
 
-                    /* Temporarily unlock mutex for telnet_connect() */
-                    pthread_mutex_unlock(&l3_ctx->state_mutex);
-                    int connect_result = telnet_connect(&l3_ctx->bridge->telnet,
-                                                        l3_ctx->bridge->config->telnet_host,
-                                                        l3_ctx->bridge->config->telnet_port);
-                    pthread_mutex_lock(&l3_ctx->state_mutex);
+                    /* DIAL_DEFAULT pool, or TELNET_HOST */
+                    int connect_result = bridge_telnet_connect(l3_ctx->bridge, NULL);
 
-                    g_level3_connection_attempted = true;
-                    g_level3_last_attempt = now;
+                    l3_ctx->connection_attempted = true;
+                    l3_ctx->last_attempt = now;
 
                     if (connect_result == SUCCESS) {
                         printf("[INFO-STATE-MACHINE] Telnet connection successful\n");
@@ -545,7 +670,7 @@ int l3_process_state_machine(l3_context_t *l3_ctx)
 
             if (l3_ctx->level2_ready) {
                 /* Level 2 connected - proceed to data transfer */
-                if (!g_level3_transition_logged) {
+                if (!l3_ctx->transition_logged) {
                     time_t now = time(NULL);
                     struct tm *tm_info = localtime(&now);
                     char timestamp[32];
@@ -554,25 +679,13 @@ int l3_process_state_machine(l3_context_t *l3_ctx)
                     printf("[%s][INFO-STATE-MACHINE] Level 2 connected - proceeding to data transfer\n", timestamp);
                     fflush(stdout);
                     MB_LOG_INFO("Level 2 telnet connected - entering data transfer mode");
-                    g_level3_transition_logged = true;
+                    l3_ctx->transition_logged = true;
                 }
 
-                l3_ctx->negotiation_complete = true;  /* Mark as complete */
-                l3_ctx->level3_active = true;  /* Enable Level 3 processing BEFORE state transition */
-                pthread_mutex_unlock(&l3_ctx->state_mutex);
-                ret = l3_set_system_state(l3_ctx, L3_STATE_DATA_TRANSFER, 0);
-                pthread_mutex_lock(&l3_ctx->state_mutex);
+                ret = l3_dispatch_event(l3_ctx, L3_EVENT_TELNET_CONNECTED);
             } else {
                 /* Still waiting for Level 2 connection */
-                static int log_counter_connecting = 0;
-                if (++log_counter_connecting % 5 == 1) {  /* Log every 5 cycles */
-                    time_t now = time(NULL);
-                    struct tm *tm_info = localtime(&now);
-                    char timestamp[32];
-                    strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", tm_info);
-
-                    printf("[%s][DEBUG-STATE-MACHINE] Waiting for Level 2 telnet connection...\n", timestamp);
-                    fflush(stdout);
+                if (++l3_ctx->wait_log_counter % 5 == 1) {  /* Log every 5 cycles */
                     MB_LOG_DEBUG("Waiting for Level 2 telnet connection");
                 }
             }
@@ -582,44 +695,34 @@ int l3_process_state_machine(l3_context_t *l3_ctx)
             /* Check if negotiation is complete */
             if (l3_ctx->negotiation_complete) {
                 MB_LOG_INFO("Protocol negotiation complete - entering data transfer mode");
-                l3_ctx->level3_active = true;  /* Enable Level 3 processing BEFORE state transition */
-                pthread_mutex_unlock(&l3_ctx->state_mutex);
-                ret = l3_set_system_state(l3_ctx, L3_STATE_DATA_TRANSFER, 0);
-                pthread_mutex_lock(&l3_ctx->state_mutex);
+                ret = l3_dispatch_event(l3_ctx, L3_EVENT_NEGOTIATED);
             }
             break;
 
         case L3_STATE_DATA_TRANSFER:
-            /* Active data processing - handled by main thread */
-            /* Check for DCD falling edge to trigger shutdown */
-            /* IMPORTANT: Check dcd_state (persistent), not dcd_rising_detected (one-shot event) */
-            if (!l3_ctx->dcd_state) {
-                MB_LOG_INFO("DCD lost - initiating graceful shutdown");
-                pthread_mutex_unlock(&l3_ctx->state_mutex);
-                ret = l3_set_system_state(l3_ctx, L3_STATE_FLUSHING, LEVEL3_SHUTDOWN_TIMEOUT);
-                pthread_mutex_lock(&l3_ctx->state_mutex);
+            /* Active data processing - handled by this thread after the state
+             * machine; DCD loss arrives as an event, a dropped session is seen here */
+            l3_ctx->level2_ready = telnet_is_connected(&l3_ctx->bridge->telnet);
+            if (!l3_ctx->level2_ready) {
+                MB_LOG_INFO("Telnet session lost - initiating graceful shutdown");
+                ret = l3_dispatch_event(l3_ctx, L3_EVENT_TELNET_DISCONNECTED);
             }
             break;
 
-        case L3_STATE_FLUSHING:
+        case L3_STATE_FLUSHING: {
             /* Check if buffers are empty and ready to shutdown */
             bool serial_empty = (l3_double_buffer_available(&l3_ctx->pipeline_serial_to_telnet.buffers) == 0);
             bool telnet_empty = (l3_double_buffer_available(&l3_ctx->pipeline_telnet_to_serial.buffers) == 0);
 
             if (serial_empty && telnet_empty) {
                 MB_LOG_INFO("Buffers flushed - shutting down");
-                pthread_mutex_unlock(&l3_ctx->state_mutex);
-                ret = l3_set_system_state(l3_ctx, L3_STATE_SHUTTING_DOWN, 5);
-                pthread_mutex_lock(&l3_ctx->state_mutex);
+                ret = l3_dispatch_event(l3_ctx, L3_EVENT_FLUSHED);
             }
             break;
+        }
 
         case L3_STATE_SHUTTING_DOWN:
-            /* Graceful shutdown - disable Level 3 processing */
-            l3_ctx->level3_active = false;
-            pthread_mutex_unlock(&l3_ctx->state_mutex);
-            ret = l3_set_system_state(l3_ctx, L3_STATE_TERMINATED, 0);
-            pthread_mutex_lock(&l3_ctx->state_mutex);
+            ret = l3_dispatch_event(l3_ctx, L3_EVENT_STOPPED);
             break;
 
         case L3_STATE_TERMINATED:
@@ -633,20 +736,15 @@ int l3_process_state_machine(l3_context_t *l3_ctx)
         case L3_STATE_ERROR:
             /* Error recovery - attempt to return to READY state */
             MB_LOG_WARNING("In error state - attempting recovery");
-            pthread_mutex_unlock(&l3_ctx->state_mutex);
-            ret = l3_set_system_state(l3_ctx, L3_STATE_READY, 0);
-            pthread_mutex_lock(&l3_ctx->state_mutex);
+            ret = l3_dispatch_event(l3_ctx, L3_EVENT_RECOVER);
             break;
 
         default:
             MB_LOG_ERROR("Unknown state: %d", current_state);
-            pthread_mutex_unlock(&l3_ctx->state_mutex);
             ret = l3_set_system_state(l3_ctx, L3_STATE_ERROR, 0);
-            pthread_mutex_lock(&l3_ctx->state_mutex);
             break;
     }
 
-    pthread_mutex_unlock(&l3_ctx->state_mutex);
     return ret;
 }
 
@@ -656,7 +754,7 @@ int l3_handle_state_timeout(l3_context_t *l3_ctx)
         return L3_ERROR_INVALID_PARAM;
     }
 
-    l3_system_state_t current_state = l3_ctx->system_state;
+    l3_system_state_t current_state = l3_get_system_state(l3_ctx);
     time_t now = time(NULL);
     time_t time_in_state = now - l3_ctx->state_change_time;
 
@@ -665,38 +763,17 @@ int l3_handle_state_timeout(l3_context_t *l3_ctx)
                 (long)time_in_state,
                 l3_ctx->state_timeout);
 
-    switch (current_state) {
-        case L3_STATE_INITIALIZING:
-            /* Initialization timeout - try to start anyway */
-            MB_LOG_WARNING("Initialization timeout - proceeding with partial initialization");
-            return l3_set_system_state(l3_ctx, L3_STATE_READY, 0);
-
-        case L3_STATE_CONNECTING:
-            /* Connection timeout - return to ready state */
-            MB_LOG_WARNING("Connection timeout - returning to ready state");
-            return l3_set_system_state(l3_ctx, L3_STATE_READY, 0);
-
-        case L3_STATE_NEGOTIATING:
-            /* Negotiation timeout - proceed anyway */
-            MB_LOG_WARNING("Negotiation timeout - proceeding with default settings");
-            l3_ctx->negotiation_complete = true;
-            return l3_set_system_state(l3_ctx, L3_STATE_DATA_TRANSFER, 0);
-
-        case L3_STATE_FLUSHING:
-            /* Flush timeout - force shutdown */
-            MB_LOG_WARNING("Flush timeout - forcing shutdown");
-            return l3_set_system_state(l3_ctx, L3_STATE_SHUTTING_DOWN, 5);
-
-        case L3_STATE_SHUTTING_DOWN:
-            /* Shutdown timeout - force termination */
-            MB_LOG_ERROR("Shutdown timeout - forcing termination");
-            return l3_set_system_state(l3_ctx, L3_STATE_TERMINATED, 0);
+    if (l3_transition_table[current_state][L3_EVENT_TIMEOUT] == L3_NO_TRANSITION) {
+        /* Other states - transition to error */
+        MB_LOG_ERROR("Unhandled timeout in state %s", l3_system_state_to_string(current_state));
+        return l3_set_system_state(l3_ctx, L3_STATE_ERROR, 0);
+    }
 
-        default:
-            /* Other states - transition to error */
-            MB_LOG_ERROR("Unhandled timeout in state %s", l3_system_state_to_string(current_state));
-            return l3_set_system_state(l3_ctx, L3_STATE_ERROR, 0);
+    if (current_state == L3_STATE_NEGOTIATING) {
+        /* Negotiation timeout - proceed with default settings */
+        l3_ctx->negotiation_complete = true;
     }
+    return l3_dispatch_event(l3_ctx, L3_EVENT_TIMEOUT);
 }
 
 bool l3_is_state_timed_out(l3_context_t *l3_ctx)
@@ -723,36 +800,43 @@ int l3_init(l3_context_t *l3_ctx, bridge_ctx_t *bridge_ctx)
     l3_ctx->bridge = bridge_ctx;
 
     /* Initialize state machine */
-    l3_ctx->system_state = L3_STATE_UNINITIALIZED;
+    atomic_init(&l3_ctx->system_state, L3_STATE_UNINITIALIZED);
+    atomic_init(&l3_ctx->level3_active, false);
+    atomic_init(&l3_ctx->dcd_line, false);
     l3_ctx->previous_state = L3_STATE_UNINITIALIZED;
     l3_ctx->state_change_time = time(NULL);
     l3_ctx->state_timeout = 0;
     l3_ctx->state_transitions = 0;
 
-    /* Initialize state machine synchronization */
-    if (pthread_mutex_init(&l3_ctx->state_mutex, NULL) != 0) {
-        MB_LOG_ERROR("Failed to initialize state mutex");
-        return L3_ERROR_THREAD;
+    /* Initialize the event queue */
+    for (size_t i = 0; i < L3_EVENT_QUEUE_SLOTS; i++) {
+        atomic_init(&l3_ctx->events.slots[i].seq, i);
     }
-    if (pthread_cond_init(&l3_ctx->state_condition, NULL) != 0) {
-        MB_LOG_ERROR("Failed to initialize state condition");
-        pthread_mutex_destroy(&l3_ctx->state_mutex);
-        return L3_ERROR_THREAD;
+    atomic_init(&l3_ctx->events.enqueue_pos, 0);
+    atomic_init(&l3_ctx->events.dequeue_pos, 0);
+    atomic_init(&l3_ctx->events.overflowed, false);
+    atomic_init(&l3_ctx->events.dropped, 0);
+    l3_ctx->events.wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (l3_ctx->events.wake_fd < 0) {
+        /* Not fatal: the management thread falls back to timed sleeps */
+        MB_LOG_WARNING("Failed to create Level 3 event fd: %s", strerror(errno));
     }
 
     /* Set initial state */
     int ret = l3_set_system_state(l3_ctx, L3_STATE_INITIALIZING, LEVEL3_INIT_TIMEOUT);
     if (ret != L3_SUCCESS) {
         MB_LOG_ERROR("Failed to set initial state");
-        pthread_mutex_destroy(&l3_ctx->state_mutex);
-        pthread_cond_destroy(&l3_ctx->state_condition);
+        if (l3_ctx->events.wake_fd >= 0) {
+            close(l3_ctx->events.wake_fd);
+            l3_ctx->events.wake_fd = -1;
+        }
         return ret;
     }
 
     /* Initialize pipelines */
     ret = l3_pipeline_init(&l3_ctx->pipeline_serial_to_telnet,
                            L3_PIPELINE_SERIAL_TO_TELNET,
-                           "Serial→Telnet");
+                           "Serial→Telnet", bridge_ctx->buffer_size);
     if (ret != L3_SUCCESS) {
         MB_LOG_ERROR("Failed to initialize Serial→Telnet pipeline");
         return ret;
@@ -760,7 +844,7 @@ int l3_init(l3_context_t *l3_ctx, bridge_ctx_t *bridge_ctx)
 
     ret = l3_pipeline_init(&l3_ctx->pipeline_telnet_to_serial,
                           L3_PIPELINE_TELNET_TO_SERIAL,
-                          "Telnet→Serial");
+                          "Telnet→Serial", bridge_ctx->buffer_size);
     if (ret != L3_SUCCESS) {
         MB_LOG_ERROR("Failed to initialize Telnet→Serial pipeline");
         return ret;
@@ -784,7 +868,6 @@ int l3_init(l3_context_t *l3_ctx, bridge_ctx_t *bridge_ctx)
     l3_ctx->last_pipeline_switch = time(NULL);
 
     /* Initialize system state */
-    l3_ctx->level3_active = false;
     l3_ctx->level1_ready = false;
     l3_ctx->level2_ready = false;
 
@@ -828,13 +911,16 @@ int l3_start(l3_context_t *l3_ctx)
 
     /* Start Level 3 management thread */
     l3_ctx->thread_running = true;
-    l3_ctx->level3_active = true;
+    atomic_store(&l3_ctx->level3_active, true);
 
-    int ret = pthread_create(&l3_ctx->level3_thread, NULL, l3_management_thread_func, l3_ctx);
+    rtsched_spec_t spec;
+    rtsched_spec_from_config(l3_ctx->bridge->config, RTSCHED_LEVEL3, &spec);
+    int ret = rtsched_thread_create(&l3_ctx->level3_thread, &spec, "Level 3 pipeline",
+                                    l3_management_thread_func, l3_ctx);
     if (ret != 0) {
         MB_LOG_ERROR("Failed to create Level 3 management thread: %s", strerror(ret));
         l3_ctx->thread_running = false;
-        l3_ctx->level3_active = false;
+        atomic_store(&l3_ctx->level3_active, false);
         return L3_ERROR_THREAD;
     }
 
@@ -850,9 +936,14 @@ int l3_stop(l3_context_t *l3_ctx)
 
     MB_LOG_INFO("Stopping Level 3 pipeline management");
 
-    /* Signal thread to stop */
+    /* Signal thread to stop, and wake it if it waits for an event */
     l3_ctx->thread_running = false;
-    l3_ctx->level3_active = false;
+    atomic_store(&l3_ctx->level3_active, false);
+    if (l3_ctx->events.wake_fd >= 0) {
+        uint64_t one = 1;
+        ssize_t n = write(l3_ctx->events.wake_fd, &one, sizeof(one));
+        (void)n;
+    }
 
     /* Wait for thread to exit */
     if (pthread_join(l3_ctx->level3_thread, NULL) != 0) {
@@ -873,19 +964,24 @@ void l3_cleanup(l3_context_t *l3_ctx)
     }
 
     /* Cleanup pipelines */
-    pthread_mutex_destroy(&l3_ctx->pipeline_serial_to_telnet.buffers.mutex);
-    pthread_mutex_destroy(&l3_ctx->pipeline_telnet_to_serial.buffers.mutex);
+    l3_double_buffer_destroy(&l3_ctx->pipeline_serial_to_telnet.buffers);
+    l3_double_buffer_destroy(&l3_ctx->pipeline_telnet_to_serial.buffers);
 
     /* Cleanup scheduling */
     pthread_mutex_destroy(&l3_ctx->scheduling_mutex);
 
+    if (l3_ctx->events.wake_fd >= 0) {
+        close(l3_ctx->events.wake_fd);
+    }
+
     memset(l3_ctx, 0, sizeof(l3_context_t));
     MB_LOG_INFO("Level 3 context cleaned up");
 }
 
 /* ========== Pipeline Management ========== */
 
-int l3_pipeline_init(l3_pipeline_t *pipeline, l3_pipeline_direction_t direction, const char *name)
+int l3_pipeline_init(l3_pipeline_t *pipeline, l3_pipeline_direction_t direction, const char *name,
+                     size_t buffer_size)
 {
     if (pipeline == NULL || name == NULL) {
         return L3_ERROR_INVALID_PARAM;
@@ -897,7 +993,8 @@ int l3_pipeline_init(l3_pipeline_t *pipeline, l3_pipeline_direction_t direction,
     pipeline->name[sizeof(pipeline->name) - 1] = '\0';
 
     /* Initialize double buffer */
-    int ret = l3_double_buffer_init(&pipeline->buffers);
+    int ret = l3_double_buffer_init(&pipeline->buffers,
+                                    buffer_size > 0 ? buffer_size : L3_PIPELINE_BUFFER_SIZE);
     if (ret != L3_SUCCESS) {
         return ret;
     }
@@ -909,13 +1006,13 @@ int l3_pipeline_init(l3_pipeline_t *pipeline, l3_pipeline_direction_t direction,
         pipeline->filter_state.hayes_ctx.state = HAYES_STATE_NORMAL;
         pipeline->filter_state.hayes_ctx.dict = &hayes_dictionary;
         pipeline->filter_state.hayes_ctx.in_online_mode = false;  /* Start in command mode */
-        pipeline->filter_state.hayes_ctx.last_char_time = l3_get_timestamp_ms();
+        hayes_escape_reset(&pipeline->filter_state.hayes_ctx.escape, l3_get_timestamp_ms());
     } else {
         pipeline->filter_state.telnet_state = TELNET_FILTER_STATE_DATA;
     }
 
     /* Initialize fair scheduling */
-    pipeline->last_timeslice_start = time(NULL);
+    pipeline->last_timeslice_start = l3_get_timestamp_ms();
     pipeline->timeslice_duration_ms = L3_FAIRNESS_TIME_SLICE_MS;
     pipeline->bytes_in_timeslice = 0;
 
@@ -956,7 +1053,8 @@ int l3_pipeline_process(l3_pipeline_t *pipeline, const unsigned char *input_data
         /* Pipeline 1: Filter Hayes commands with enhanced dictionary support */
         ret = l3_filter_hayes_commands(&pipeline->filter_state.hayes_ctx,
                                        input_data, input_len,
-                                       output_data, output_size, &filtered_len);
+                                       output_data, output_size, &filtered_len,
+                                       l3_get_timestamp_ms());
     } else {
         /* Pipeline 2: Filter TELNET control codes */
         ret = l3_filter_telnet_controls(&pipeline->filter_state.telnet_state,
@@ -983,41 +1081,26 @@ int l3_pipeline_process(l3_pipeline_t *pipeline, const unsigned char *input_data
 
 int l3_pipeline_switch_buffers(l3_pipeline_t *pipeline)
 {
-    if (pipeline == NULL) {
+    if (pipeline == NULL || pipeline->buffers.sub_chunk == NULL) {
         return L3_ERROR_INVALID_PARAM;
     }
 
-    pthread_mutex_lock(&pipeline->buffers.mutex);
-
-    /* Switch active buffers */
-    pipeline->buffers.main_active = !pipeline->buffers.main_active;
-
-    /* Reset the new main buffer's read position */
-    if (!pipeline->buffers.main_active) {
-        pipeline->buffers.main_pos = 0;
-    } else {
-        pipeline->buffers.main_pos = 0;
-    }
+    /* Hand the producer's chunk over with one pointer swap (no copy, no lock) */
+    l3_double_buffer_claim(&pipeline->buffers);
+    bool switched = l3_double_buffer_publish(&pipeline->buffers);
+    atomic_store_explicit(&pipeline->buffers.producer_busy, false, memory_order_release);
 
-    /* Clear the new sub buffer */
-    if (pipeline->buffers.main_active) {
-        pipeline->buffers.sub_len = 0;
-    } else {
-        pipeline->buffers.sub_len = 0;
+    if (switched) {
+        pipeline->pipeline_switches++;
+        MB_LOG_DEBUG("Pipeline %s: Switched buffers (switch #%llu)",
+                    pipeline->name, (unsigned long long)pipeline->pipeline_switches);
     }
-
-    pipeline->pipeline_switches++;
-
-    pthread_mutex_unlock(&pipeline->buffers.mutex);
-
-    MB_LOG_DEBUG("Pipeline %s: Switched buffers (switch #%llu)",
-                pipeline->name, (unsigned long long)pipeline->pipeline_switches);
     return L3_SUCCESS;
 }
 
 /* ========== Double Buffer Management ========== */
 
-int l3_double_buffer_init(l3_double_buffer_t *dbuf)
+int l3_double_buffer_init(l3_double_buffer_t *dbuf, size_t capacity)
 {
     if (dbuf == NULL) {
         return L3_ERROR_INVALID_PARAM;
@@ -1025,69 +1108,295 @@ int l3_double_buffer_init(l3_double_buffer_t *dbuf)
 
     memset(dbuf, 0, sizeof(l3_double_buffer_t));
 
-    /* Initialize buffer state */
-    dbuf->main_active = true;
-    dbuf->main_len = 0;
+    /* Fixed-size chunks from the buffer's own pool: length header plus
+     * capacity data bytes, rounded up to the pool alignment */
+    size_t block_size = (sizeof(l3_buffer_chunk_t) + capacity + L3_POOL_ALIGN - 1) &
+                        ~((size_t)L3_POOL_ALIGN - 1);
+    int ret = l3_memory_pool_init(&dbuf->pool, block_size * L3_DOUBLE_BUFFER_CHUNKS, block_size);
+    if (ret != L3_SUCCESS) {
+        return ret;
+    }
+    dbuf->capacity = dbuf->pool.block_size - sizeof(l3_buffer_chunk_t);
+
+    l3_buffer_chunk_t *chunks[L3_DOUBLE_BUFFER_CHUNKS];
+    for (int i = 0; i < L3_DOUBLE_BUFFER_CHUNKS; i++) {
+        chunks[i] = (l3_buffer_chunk_t *)l3_memory_pool_alloc(&dbuf->pool);
+        chunks[i]->len = 0;
+    }
+
+    /* Consumer drains chunk 0, producer fills chunk 1, chunk 2 waits as spare */
+    dbuf->main_chunk = chunks[0];
     dbuf->main_pos = 0;
-    dbuf->sub_len = 0;
+    dbuf->sub_chunk = chunks[1];
+    atomic_init(&dbuf->ready, NULL);
+    atomic_init(&dbuf->spare, chunks[2]);
+    atomic_init(&dbuf->producer_busy, false);
+    atomic_init(&dbuf->bytes_written, 0);
+    atomic_init(&dbuf->bytes_processed, 0);
 
     /* Initialize synchronization */
-    int ret = pthread_mutex_init(&dbuf->mutex, NULL);
+    ret = pthread_mutex_init(&dbuf->mutex, NULL);
     if (ret != 0) {
         MB_LOG_ERROR("Failed to initialize double buffer mutex: %s", strerror(ret));
+        for (int i = 0; i < L3_DOUBLE_BUFFER_CHUNKS; i++) {
+            l3_memory_pool_free(&dbuf->pool, (unsigned char *)chunks[i]);
+        }
+        l3_memory_pool_cleanup(&dbuf->pool);
+        memset(dbuf, 0, sizeof(l3_double_buffer_t));
         return L3_ERROR_THREAD;
     }
 
     return L3_SUCCESS;
 }
 
-size_t l3_double_buffer_write(l3_double_buffer_t *dbuf, const unsigned char *data, size_t len)
+void l3_double_buffer_destroy(l3_double_buffer_t *dbuf)
+{
+    if (dbuf == NULL || dbuf->main_chunk == NULL) {
+        return;
+    }
+
+    pthread_mutex_destroy(&dbuf->mutex);
+
+    /* Every chunk sits in exactly one of the four places; the pool
+     * rejects (and logs) a chunk that turns up twice */
+    l3_buffer_chunk_t *held[] = {
+        dbuf->main_chunk,
+        dbuf->sub_chunk,
+        atomic_exchange(&dbuf->ready, NULL),
+        atomic_exchange(&dbuf->spare, NULL),
+    };
+    for (size_t i = 0; i < sizeof(held) / sizeof(held[0]); i++) {
+        if (held[i] != NULL) {
+            l3_memory_pool_free(&dbuf->pool, (unsigned char *)held[i]);
+        }
+    }
+    l3_memory_pool_cleanup(&dbuf->pool);
+
+    dbuf->main_chunk = NULL;
+    dbuf->sub_chunk = NULL;
+    dbuf->capacity = 0;
+}
+
+/**
+ * Claim the producer's chunk (only contended while the consumer takes it over)
+ */
+static void l3_double_buffer_claim(l3_double_buffer_t *dbuf)
 {
-    if (dbuf == NULL || data == NULL || len == 0) {
+    bool idle = false;
+    while (!atomic_compare_exchange_weak_explicit(&dbuf->producer_busy, &idle, true,
+                                                  memory_order_acquire, memory_order_relaxed)) {
+        idle = false;
+        sched_yield();
+    }
+}
+
+/**
+ * Hand the producer's chunk to the consumer if the ready slot is free
+ * (producer holds the claim). The spare slot always holds a drained chunk
+ * while ready is empty, so the producer never waits for one.
+ */
+static bool l3_double_buffer_publish(l3_double_buffer_t *dbuf)
+{
+    l3_buffer_chunk_t *filled = dbuf->sub_chunk;
+
+    if (filled->len == 0 ||
+        atomic_load_explicit(&dbuf->ready, memory_order_acquire) != NULL) {
+        return false;
+    }
+
+    l3_buffer_chunk_t *empty = atomic_exchange_explicit(&dbuf->spare, NULL, memory_order_acquire);
+    if (empty == NULL) {
+        return false;
+    }
+
+    atomic_store_explicit(&dbuf->ready, filled, memory_order_release);
+    dbuf->sub_chunk = empty;
+    dbuf->handoffs++;
+    return true;
+}
+
+/**
+ * Make sure the consumer's chunk has unread data (consumer thread)
+ * Takes the ready chunk when the current one is drained. If nothing is
+ * ready but the idle producer holds a partial chunk, takes that one over
+ * under the mutex (the exceptional path) and gives the producer the
+ * drained chunk instead.
+ */
+static size_t l3_double_buffer_refill(l3_double_buffer_t *dbuf)
+{
+    l3_buffer_chunk_t *drained = dbuf->main_chunk;
+
+    if (dbuf->main_pos < drained->len) {
+        return drained->len - dbuf->main_pos;
+    }
+
+    l3_buffer_chunk_t *next = atomic_exchange_explicit(&dbuf->ready, NULL, memory_order_acq_rel);
+    if (next != NULL) {
+        drained->len = 0;
+        atomic_store_explicit(&dbuf->spare, drained, memory_order_release);
+        dbuf->main_chunk = next;
+        dbuf->main_pos = 0;
+        return next->len;
+    }
+
+    size_t written = atomic_load_explicit(&dbuf->bytes_written, memory_order_acquire);
+    if (written == atomic_load_explicit(&dbuf->bytes_processed, memory_order_relaxed)) {
+        return 0;
+    }
+
+    /* Bytes are waiting in the producer's chunk. Take it over only once
+     * the producer has added nothing since the previous empty refill: an
+     * active producer publishes on its own when the chunk fills. */
+    if (written != dbuf->idle_mark) {
+        dbuf->idle_mark = written;
         return 0;
     }
 
+    size_t available = 0;
     pthread_mutex_lock(&dbuf->mutex);
+    bool idle = false;
+    if (atomic_compare_exchange_strong_explicit(&dbuf->producer_busy, &idle, true,
+                                                memory_order_acquire, memory_order_relaxed)) {
+        next = atomic_exchange_explicit(&dbuf->ready, NULL, memory_order_acq_rel);
+        if (next != NULL) {
+            /* Published meanwhile: regular hand-off */
+            drained->len = 0;
+            atomic_store_explicit(&dbuf->spare, drained, memory_order_release);
+        } else if (dbuf->sub_chunk->len > 0) {
+            next = dbuf->sub_chunk;
+            drained->len = 0;
+            dbuf->sub_chunk = drained;
+            dbuf->takeovers++;
+        }
+        if (next != NULL) {
+            dbuf->main_chunk = next;
+            dbuf->main_pos = 0;
+            available = next->len;
+        }
+        atomic_store_explicit(&dbuf->producer_busy, false, memory_order_release);
+    }
+    pthread_mutex_unlock(&dbuf->mutex);
 
-    /* Check if sub-buffer has space */
-    size_t available_space = L3_PIPELINE_BUFFER_SIZE - dbuf->sub_len;
-    size_t to_write = len < available_space ? len : available_space;
+    return available;
+}
 
-    if (to_write > 0) {
-        memcpy(dbuf->sub_data + dbuf->sub_len, data, to_write);
-        dbuf->sub_len += to_write;
+size_t l3_double_buffer_write(l3_double_buffer_t *dbuf, const unsigned char *data, size_t len)
+{
+    if (dbuf == NULL || data == NULL || len == 0 || dbuf->sub_chunk == NULL) {
+        return 0;
+    }
+
+    l3_double_buffer_claim(dbuf);
+
+    /* Fill the current chunk, hand it over, and go on with the fresh one */
+    size_t written = 0;
+    while (written < len) {
+        l3_buffer_chunk_t *chunk = dbuf->sub_chunk;
+        size_t to_write = MIN(len - written, dbuf->capacity - chunk->len);
+        if (to_write == 0) {
+            if (!l3_double_buffer_publish(dbuf)) {
+                break;
+            }
+            continue;
+        }
+        memcpy(chunk->data + chunk->len, data + written, to_write);
+        chunk->len += to_write;
+        written += to_write;
+    }
+
+    if (written > 0) {
+        atomic_fetch_add_explicit(&dbuf->bytes_written, written, memory_order_release);
         dbuf->last_activity = time(NULL);
+        l3_double_buffer_publish(dbuf);
     } else {
         /* Buffer overflow - drop data */
         dbuf->bytes_dropped += len;
         MB_LOG_WARNING("Double buffer overflow: dropped %zu bytes", len);
     }
 
-    pthread_mutex_unlock(&dbuf->mutex);
-    return to_write;
+    atomic_store_explicit(&dbuf->producer_busy, false, memory_order_release);
+    return written;
 }
 
 size_t l3_double_buffer_read(l3_double_buffer_t *dbuf, unsigned char *data, size_t len)
 {
-    if (dbuf == NULL || data == NULL || len == 0) {
+    if (dbuf == NULL || data == NULL || len == 0 || dbuf->main_chunk == NULL) {
         return 0;
     }
 
-    pthread_mutex_lock(&dbuf->mutex);
+    size_t total = 0;
+    while (total < len) {
+        size_t available = l3_double_buffer_refill(dbuf);
+        if (available == 0) {
+            break;
+        }
+        size_t to_read = MIN(len - total, available);
+        memcpy(data + total, dbuf->main_chunk->data + dbuf->main_pos, to_read);
+        dbuf->main_pos += to_read;
+        total += to_read;
+    }
 
-    /* Read from main buffer */
-    size_t available = dbuf->main_len - dbuf->main_pos;
-    size_t to_read = len < available ? len : available;
+    if (total > 0) {
+        atomic_fetch_add_explicit(&dbuf->bytes_processed, total, memory_order_release);
+    }
+    return total;
+}
 
-    if (to_read > 0) {
-        memcpy(data, dbuf->main_data + dbuf->main_pos, to_read);
-        dbuf->main_pos += to_read;
-        dbuf->bytes_processed += to_read;
+unsigned char *l3_double_buffer_reserve(l3_double_buffer_t *dbuf, size_t len, size_t *granted)
+{
+    if (dbuf == NULL || granted == NULL || dbuf->sub_chunk == NULL) {
+        return NULL;
+    }
+
+    /* Claimed until l3_double_buffer_commit() */
+    l3_double_buffer_claim(dbuf);
+
+    if (dbuf->sub_chunk->len == dbuf->capacity) {
+        l3_double_buffer_publish(dbuf);
+    }
+
+    l3_buffer_chunk_t *chunk = dbuf->sub_chunk;
+    size_t available_space = dbuf->capacity - chunk->len;
+    *granted = len < available_space ? len : available_space;
+    return chunk->data + chunk->len;
+}
+
+void l3_double_buffer_commit(l3_double_buffer_t *dbuf, size_t n)
+{
+    if (dbuf == NULL || dbuf->sub_chunk == NULL) {
+        return;
+    }
+
+    if (n > 0) {
+        dbuf->sub_chunk->len += n;
+        atomic_fetch_add_explicit(&dbuf->bytes_written, n, memory_order_release);
         dbuf->last_activity = time(NULL);
+        l3_double_buffer_publish(dbuf);
     }
 
-    pthread_mutex_unlock(&dbuf->mutex);
-    return to_read;
+    atomic_store_explicit(&dbuf->producer_busy, false, memory_order_release);
+}
+
+const unsigned char *l3_double_buffer_peek(l3_double_buffer_t *dbuf, size_t *len)
+{
+    if (dbuf == NULL || len == NULL || dbuf->main_chunk == NULL) {
+        return NULL;
+    }
+
+    *len = l3_double_buffer_refill(dbuf);
+    return dbuf->main_chunk->data + dbuf->main_pos;
+}
+
+void l3_double_buffer_consume(l3_double_buffer_t *dbuf, size_t n)
+{
+    if (dbuf == NULL || dbuf->main_chunk == NULL) {
+        return;
+    }
+
+    if (n > 0) {
+        dbuf->main_pos += n;
+        atomic_fetch_add_explicit(&dbuf->bytes_processed, n, memory_order_release);
+    }
 }
 
 size_t l3_double_buffer_available(l3_double_buffer_t *dbuf)
@@ -1096,11 +1405,11 @@ size_t l3_double_buffer_available(l3_double_buffer_t *dbuf)
         return 0;
     }
 
-    pthread_mutex_lock(&dbuf->mutex);
-    size_t available = dbuf->main_len - dbuf->main_pos;
-    pthread_mutex_unlock(&dbuf->mutex);
+    /* Read the consumer's count first so the difference never underflows */
+    size_t processed = atomic_load_explicit(&dbuf->bytes_processed, memory_order_acquire);
+    size_t written = atomic_load_explicit(&dbuf->bytes_written, memory_order_acquire);
 
-    return available;
+    return written - processed;
 }
 
 size_t l3_double_buffer_free(l3_double_buffer_t *dbuf)
@@ -1109,102 +1418,67 @@ size_t l3_double_buffer_free(l3_double_buffer_t *dbuf)
         return 0;
     }
 
-    pthread_mutex_lock(&dbuf->mutex);
-    size_t free_space = L3_PIPELINE_BUFFER_SIZE - dbuf->sub_len;
-    pthread_mutex_unlock(&dbuf->mutex);
+    /* Room left in the producer's chunk, plus a whole chunk when the ready
+     * slot is empty and a drained chunk is waiting to replace this one */
+    l3_buffer_chunk_t *chunk = dbuf->sub_chunk;
+    if (chunk == NULL) {
+        return 0;
+    }
 
-    return free_space;
+    size_t space = dbuf->capacity - chunk->len;
+    if (atomic_load_explicit(&dbuf->ready, memory_order_acquire) == NULL &&
+        atomic_load_explicit(&dbuf->spare, memory_order_acquire) != NULL) {
+        space += dbuf->capacity;
+    }
+    return space;
 }
 
-/* ========== Protocol Filtering ========== */
+int l3_double_buffer_get_metrics(l3_double_buffer_t *dbuf, l3_buffer_metrics_t *metrics)
+{
+    if (dbuf == NULL || metrics == NULL || dbuf->pool.pool_memory == NULL) {
+        return L3_ERROR_INVALID_PARAM;
+    }
 
-/* Hayes Command Dictionary - Based on modem.c implementation */
-static const hayes_command_entry_t hayes_commands[] = {
-    /* Basic AT Commands */
-    {"ATA",  HAYES_CMD_BASIC, false, 0, 0, "Answer incoming call"},
-    {"ATB",  HAYES_CMD_BASIC, true,  0, 1, "Bell/CCITT mode"},
-    {"ATD",  HAYES_CMD_BASIC, true,  0, 0, "Dial number"},
-    {"ATE",  HAYES_CMD_BASIC, true,  0, 1, "Echo on/off"},
-    {"ATH",  HAYES_CMD_BASIC, true,  0, 1, "Hang up"},
-    {"ATI",  HAYES_CMD_BASIC, true,  0, 9, "Information/identification"},
-    {"ATL",  HAYES_CMD_BASIC, true,  0, 3, "Speaker volume"},
-    {"ATM",  HAYES_CMD_BASIC, true,  0, 3, "Speaker control"},
-    {"ATO",  HAYES_CMD_BASIC, true,  0, 0, "Return to online mode"},
-    {"ATQ",  HAYES_CMD_BASIC, true,  0, 1, "Quiet mode"},
-    {"ATS",  HAYES_CMD_REGISTER, true, 0, 255, "S-register access"},
-    {"ATV",  HAYES_CMD_BASIC, true,  0, 1, "Verbose mode"},
-    {"ATX",  HAYES_CMD_BASIC, true,  0, 4, "Extended result codes"},
-    {"ATZ",  HAYES_CMD_BASIC, true,  0, 1, "Reset modem"},
-
-    /* Extended AT& Commands */
-    {"AT&C", HAYES_CMD_EXTENDED, true, 0, 1, "DCD control"},
-    {"AT&D", HAYES_CMD_EXTENDED, true, 0, 3, "DTR control"},
-    {"AT&F", HAYES_CMD_EXTENDED, false, 0, 0, "Factory defaults"},
-    {"AT&V", HAYES_CMD_EXTENDED, false, 0, 0, "View configuration"},
-    {"AT&W", HAYES_CMD_EXTENDED, true, 0, 1, "Write configuration"},
-    {"AT&S", HAYES_CMD_EXTENDED, true, 0, 1, "DSR override"},
-
-    /* Escape sequence */
-    {"+++",  HAYES_CMD_BASIC, false, 0, 0, "Escape to command mode"}
-};
+    memset(metrics, 0, sizeof(l3_buffer_metrics_t));
+    metrics->current_usage = l3_double_buffer_available(dbuf);
+    metrics->bytes_dropped = dbuf->bytes_dropped;
 
-/* Hayes Result Codes */
-static const hayes_result_entry_t hayes_results[] = {
-    {"OK",           false, false},
-    {"ERROR",        false, false},
-    {"CONNECT",      true,  true},
-    {"NO CARRIER",   true,  false},
-    {"NO DIALTONE",  true,  false},
-    {"BUSY",         true,  false},
-    {"NO ANSWER",    true,  false},
-    {"RING",         false, false},
-    {"DELAYED",      false, false},
-    {"BLACKLISTED",  false, false}
-};
+    /* Pool occupancy and fragmentation */
+    l3_memory_pool_t *pool = &dbuf->pool;
+    l3_memory_pool_update_metrics(pool);
+    metrics->fragmentation_count = pool->free_list_length;
+    metrics->largest_fragment_size = pool->largest_free_block;
+    metrics->pool_blocks_in_use = atomic_load_explicit(&pool->allocated_blocks, memory_order_relaxed);
+    metrics->pool_high_water = atomic_load_explicit(&pool->high_water, memory_order_relaxed);
+    metrics->pool_alloc_failures = atomic_load_explicit(&pool->alloc_failures, memory_order_relaxed);
+
+    return L3_SUCCESS;
+}
 
-/* Global Hayes Dictionary */
+/* ========== Protocol Filtering ========== */
+
+/* Global Hayes Dictionary (tables shared with the software modem) */
 static const hayes_dictionary_t hayes_dictionary = {
     .commands = hayes_commands,
-    .num_commands = sizeof(hayes_commands) / sizeof(hayes_commands[0]),
+    .num_commands = HAYES_AT_COUNT,
     .results = hayes_results,
-    .num_results = sizeof(hayes_results) / sizeof(hayes_results[0])
+    .num_results = HAYES_RESULT_COUNT
 };
 
 /**
  * Check if buffer contains a Hayes command
  */
-static bool l3_is_hayes_command(const unsigned char *buffer, size_t len, const hayes_dictionary_t *dict)
+static bool l3_is_hayes_command(const unsigned char *buffer, size_t len)
 {
-    if (len < 2 || dict == NULL) return false;
+    if (len < 2) return false;
 
-    /* Check for "AT" prefix (case insensitive) */
+    /* "AT" prefix (case insensitive) followed by a table command */
     if ((buffer[0] == 'A' || buffer[0] == 'a') &&
         (buffer[1] == 'T' || buffer[1] == 't')) {
-
-        /* For each known command */
-        for (size_t i = 0; i < dict->num_commands; i++) {
-            const char *cmd = dict->commands[i].command;
-            size_t cmd_len = strlen(cmd);
-
-            /* Check if buffer starts with this command (case insensitive) */
-            if (len >= cmd_len) {
-                bool match = true;
-                for (size_t j = 0; j < cmd_len; j++) {
-                    char b = buffer[j];
-                    char c = cmd[j];
-                    /* Case insensitive comparison */
-                    if (b >= 'a' && b <= 'z') b -= 32;
-                    if (c >= 'a' && c <= 'z') c -= 32;
-                    if (b != c) {
-                        match = false;
-                        break;
-                    }
-                }
-                if (match) {
-                    MB_LOG_DEBUG("Detected Hayes command: %s", cmd);
-                    return true;
-                }
-            }
+        const hayes_command_entry_t *cmd = hayes_match_command((const char *)buffer + 2, len - 2, NULL);
+        if (cmd != NULL) {
+            MB_LOG_DEBUG("Detected Hayes command: %s", cmd->command);
+            return true;
         }
     }
 
@@ -1218,34 +1492,134 @@ static bool l3_is_hayes_command(const unsigned char *buffer, size_t len, const h
 }
 
 /**
- * Check if buffer contains a Hayes result code
+ * Check if buffer starts with a Hayes result code
+ */
+static const hayes_result_entry_t *l3_match_hayes_result(const unsigned char *buffer, size_t len)
+{
+    if (len < 2) return NULL;
+
+    const hayes_result_entry_t *result = hayes_match_result((const char *)buffer, len, NULL);
+    if (result != NULL) {
+        MB_LOG_DEBUG("Detected Hayes result: %s", result->code);
+    }
+    return result;
+}
+
+/* Word-at-a-time byte test: some byte of x is zero */
+#define L3_WORD_HAS_ZERO(x)     (((x) - 0x0101010101010101ULL) & ~(x) & 0x8080808080808080ULL)
+#define L3_WORD_BYTES(c)        (0x0101010101010101ULL * (unsigned char)(c))
+
+/**
+ * Offset of the first CR or LF (len if none), eight bytes per step
+ */
+static size_t l3_find_eol(const unsigned char *data, size_t len)
+{
+    size_t i = 0;
+
+    for (; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        if (L3_WORD_HAS_ZERO(word ^ L3_WORD_BYTES('\r')) |
+            L3_WORD_HAS_ZERO(word ^ L3_WORD_BYTES('\n'))) {
+            break;
+        }
+    }
+    for (; i < len; i++) {
+        if (data[i] == '\r' || data[i] == '\n') {
+            break;
+        }
+    }
+    return i;
+}
+
+/**
+ * Check whether the start of an unterminated line can still be an AT command
+ */
+static bool l3_hayes_at_prefix(const unsigned char *line, size_t len)
+{
+    if (len >= 1 && line[0] != 'A' && line[0] != 'a') {
+        return false;
+    }
+    if (len >= 2 && line[1] != 'T' && line[1] != 't') {
+        return false;
+    }
+    if (len >= 3) {
+        /* AT is followed by a command letter, a digit or an extended prefix */
+        unsigned char next_char = line[2];
+        return (next_char >= 'A' && next_char <= 'Z') ||
+               (next_char >= '0' && next_char <= '9') ||
+               next_char == '+' || next_char == '&' ||
+               next_char == '%' || next_char == '\\' ||
+               next_char == '*' || next_char == '#';
+    }
+    return true;
+}
+
+/**
+ * Append to the output, dropping what does not fit
  */
-static bool l3_is_hayes_result(const unsigned char *buffer, size_t len, const hayes_dictionary_t *dict)
+static size_t l3_hayes_emit(const unsigned char *data, size_t len,
+                            unsigned char *output, size_t out_pos, size_t output_size)
 {
-    if (len < 2 || dict == NULL) return false;
+    size_t n = MIN(len, output_size - out_pos);
 
-    /* For each known result code */
-    for (size_t i = 0; i < dict->num_results; i++) {
-        const char *result = dict->results[i].code;
-        size_t result_len = strlen(result);
+    memcpy(output + out_pos, data, n);
+    return out_pos + n;
+}
 
-        /* Check if buffer contains this result code */
-        if (len >= result_len) {
-            if (memcmp(buffer, result, result_len) == 0) {
-                MB_LOG_DEBUG("Detected Hayes result: %s", result);
-                return true;
+/**
+ * ONLINE MODE data: a line is held back only while it can still be an AT
+ * command (blocked at CR/LF). Once its start rules that out, the held bytes
+ * and the rest of the line up to CR/LF are copied through in bulk.
+ */
+static size_t l3_hayes_online_data(hayes_filter_context_t *ctx, const unsigned char *data, size_t len,
+                                   unsigned char *output, size_t out_pos, size_t output_size)
+{
+    size_t i = 0;
+
+    while (i < len && out_pos < output_size) {
+        if (ctx->line_passthrough) {
+            size_t rest = len - i;
+            size_t eol = l3_find_eol(data + i, rest);
+            size_t run = (eol < rest) ? eol + 1 : rest;
+
+            out_pos = l3_hayes_emit(data + i, run, output, out_pos, output_size);
+            i += run;
+            if (eol < rest) {
+                ctx->line_passthrough = false;
             }
+            continue;
+        }
+
+        unsigned char c = data[i++];
+        ctx->line_buffer[ctx->line_len++] = c;
+        ctx->line_buffer[ctx->line_len] = '\0';
+
+        if (c == '\r' || c == '\n') {
+            /* "AT" plus line ending at least; the prefix was checked on the way */
+            if (ctx->line_len >= 3) {
+                MB_LOG_WARNING("Hayes filter: AT command BLOCKED in ONLINE mode: %.30s", ctx->line_buffer);
+            } else {
+                out_pos = l3_hayes_emit(ctx->line_buffer, ctx->line_len, output, out_pos, output_size);
+            }
+            ctx->line_len = 0;
+        } else if (!l3_hayes_at_prefix(ctx->line_buffer, ctx->line_len) ||
+                   ctx->line_len >= sizeof(ctx->line_buffer) - 1) {
+            out_pos = l3_hayes_emit(ctx->line_buffer, ctx->line_len, output, out_pos, output_size);
+            ctx->line_len = 0;
+            ctx->line_passthrough = true;
         }
     }
 
-    return false;
+    return out_pos;
 }
 
 /**
  * Enhanced Hayes filter with dictionary support and line buffering
  */
 int l3_filter_hayes_commands(hayes_filter_context_t *ctx, const unsigned char *input, size_t input_len,
-                            unsigned char *output, size_t output_size, size_t *output_len)
+                            unsigned char *output, size_t output_size, size_t *output_len,
+                            long long now_ms)
 {
     if (ctx == NULL || input == NULL || output == NULL || output_len == NULL) {
         return L3_ERROR_INVALID_PARAM;
@@ -1258,128 +1632,44 @@ int l3_filter_hayes_commands(hayes_filter_context_t *ctx, const unsigned char *i
 
     size_t out_pos = 0;
     *output_len = 0;
-    long long current_time = l3_get_timestamp_ms();
-
-    /* Process input data */
-    for (size_t i = 0; i < input_len && out_pos < output_size; i++) {
-        unsigned char c = input[i];
-
-        /* ONLINE MODE: Line buffering with AT command filtering */
-        if (ctx->in_online_mode) {
-            /* Special case: +++ escape sequence detection */
-            if (c == '+') {
-                /* Check for +++ escape sequence with guard time */
-                if (ctx->plus_count == 0) {
-                    long long elapsed = current_time - ctx->last_char_time;
-                    if (elapsed >= 1000) { /* 1 second guard time before first + */
-                        ctx->plus_start_time = current_time;
-                        ctx->plus_count = 1;
-                        ctx->last_char_time = current_time;
-                        continue; /* Don't output yet */
-                    }
-                } else if (ctx->plus_count == 1 || ctx->plus_count == 2) {
-                    ctx->plus_count++;
-                    if (ctx->plus_count == 3) {
-                        /* +++ detected - switch to command mode */
-                        MB_LOG_INFO("Hayes filter: +++ escape detected, switching to COMMAND mode");
-                        ctx->in_online_mode = false;
-                        ctx->state = HAYES_STATE_NORMAL;
-                        ctx->plus_count = 0;
-                        ctx->line_len = 0;
-                        continue; /* Don't output the +++ */
-                    }
-                    ctx->last_char_time = current_time;
-                    continue; /* Don't output yet */
-                }
-            } else if (ctx->plus_count > 0) {
-                /* Not a + - flush buffered + characters */
-                for (int j = 0; j < ctx->plus_count; j++) {
-                    if (out_pos < output_size) output[out_pos++] = '+';
-                }
-                ctx->plus_count = 0;
-            }
-
-            /* Line buffering for AT command detection */
-            /* Track start time for new line */
-            if (ctx->line_len == 0) {
-                ctx->line_start_time = current_time;
-            }
-
-            /* Add to line buffer */
-            if (ctx->line_len < sizeof(ctx->line_buffer) - 1) {
-                ctx->line_buffer[ctx->line_len++] = c;
-                ctx->line_buffer[ctx->line_len] = '\0';
-            }
-
-            /* Check if we have a complete line */
-            if (c == '\r' || c == '\n') {
-                /* Process complete line */
-                bool is_at_command = false;
-
-                /* Check for AT command (minimum 3 chars: "AT\r") */
-                if (ctx->line_len >= 3) {
-                    /* Check if line starts with AT (all 4 combinations: AT, At, aT, at) */
-                    if ((ctx->line_buffer[0] == 'A' || ctx->line_buffer[0] == 'a') &&
-                        (ctx->line_buffer[1] == 'T' || ctx->line_buffer[1] == 't')) {
-                        /* Check what comes after AT - must be a command character or line ending */
-                        if (ctx->line_len == 3) {
-                            /* Just "AT\r" or "AT\n" */
-                            is_at_command = true;
-                        } else {
-                            unsigned char next_char = ctx->line_buffer[2];
-                            /* AT commands can be followed by:
-                             * - Uppercase letter (ATH, ATZ, ATE, etc.)
-                             * - Digit (AT0, AT1, etc.)
-                             * - Special chars (+, &, %, etc. for extended commands)
-                             * - CR/LF
-                             */
-                            if ((next_char >= 'A' && next_char <= 'Z') ||
-                                (next_char >= '0' && next_char <= '9') ||
-                                next_char == '+' || next_char == '&' ||
-                                next_char == '%' || next_char == '\\' ||
-                                next_char == '*' || next_char == '#' ||
-                                next_char == '\r' || next_char == '\n') {
-                                is_at_command = true;
-                            }
-                        }
-
-                        if (is_at_command) {
-                            MB_LOG_WARNING("Hayes filter: AT command BLOCKED in ONLINE mode: %.30s", ctx->line_buffer);
-                        }
-                    }
-                }
 
-                if (!is_at_command) {
-                    /* Not an AT command - output the entire line */
-                    for (size_t j = 0; j < ctx->line_len; j++) {
-                        if (out_pos < output_size) {
-                            output[out_pos++] = ctx->line_buffer[j];
-                        }
-                    }
-                }
-                /* Clear line buffer for next line */
+    /* Process input data */
+    size_t i = 0;
+    while (i < input_len && out_pos < output_size) {
+        /* ONLINE MODE: the rest of the input in one pass */
+        if (ctx->in_online_mode) {
+            const unsigned char *rest = input + i;
+            size_t rest_len = input_len - i;
+            int held = ctx->escape.count;
+
+            size_t escape_end = hayes_escape_scan(&ctx->escape, rest, rest_len, '+',
+                                                  HAYES_ESCAPE_DEFAULT_GUARD_MS, now_ms);
+            if (escape_end > 0) {
+                /* +++ detected - switch to command mode (the +++ is not output) */
+                MB_LOG_INFO("Hayes filter: +++ escape detected, switching to COMMAND mode");
+                ctx->in_online_mode = false;
+                ctx->state = HAYES_STATE_NORMAL;
                 ctx->line_len = 0;
-                memset(ctx->line_buffer, 0, sizeof(ctx->line_buffer));
-            } else {
-                /* Not end of line - check for buffer overflow */
-                if (ctx->line_len >= sizeof(ctx->line_buffer) - 1) {
-                    /* Buffer full - flush it as it's probably not an AT command */
-                    for (size_t j = 0; j < ctx->line_len; j++) {
-                        if (out_pos < output_size) {
-                            output[out_pos++] = ctx->line_buffer[j];
-                        }
-                    }
-                    ctx->line_len = 0;
-                    /* Add current character */
-                    ctx->line_buffer[0] = c;
-                    ctx->line_len = 1;
-                }
+                ctx->line_passthrough = false;
+                i += escape_end;
+                continue;
             }
 
-            ctx->last_char_time = current_time;
-            continue;
+            /* Pending '+' stay held back; earlier ones that turned out to be
+             * data go out ahead of this input */
+            size_t pending = (size_t)ctx->escape.count;
+            bool still_held = held > 0 && pending == (size_t)held + rest_len;
+            if (held > 0 && !still_held) {
+                static const unsigned char plus[HAYES_ESCAPE_LENGTH] = {'+', '+', '+'};
+                out_pos = l3_hayes_online_data(ctx, plus, (size_t)held, output, out_pos, output_size);
+            }
+            size_t data_len = still_held ? 0 : rest_len - pending;
+            out_pos = l3_hayes_online_data(ctx, rest, data_len, output, out_pos, output_size);
+            break;
         }
 
+        unsigned char c = input[i++];
+
         /* COMMAND MODE - Original state machine for command processing */
         switch (ctx->state) {
             case HAYES_STATE_NORMAL:
@@ -1407,7 +1697,7 @@ int l3_filter_hayes_commands(hayes_filter_context_t *ctx, const unsigned char *i
                                 MB_LOG_DEBUG("Hayes filter: AT command detected in line: %.20s", ctx->line_buffer);
 
                                 /* Check if it's a known command */
-                                if (l3_is_hayes_command(ctx->command_buffer, ctx->command_len, ctx->dict)) {
+                                if (l3_is_hayes_command(ctx->command_buffer, ctx->command_len)) {
                                     /* Known command - filter it, wait for result */
                                     ctx->state = HAYES_STATE_CR_WAIT;
                                     MB_LOG_DEBUG("Hayes filter: Known command, waiting for result");
@@ -1477,17 +1767,15 @@ int l3_filter_hayes_commands(hayes_filter_context_t *ctx, const unsigned char *i
                 /* Accumulate result code */
                 if (c == '\r' || c == '\n') {
                     /* Check if it's a known result */
-                    if (l3_is_hayes_result(ctx->result_buffer, ctx->result_len, ctx->dict)) {
+                    const hayes_result_entry_t *result =
+                        l3_match_hayes_result(ctx->result_buffer, ctx->result_len);
+                    if (result != NULL) {
                         /* Check if this result switches to online mode */
-                        for (size_t j = 0; j < ctx->dict->num_results; j++) {
-                            if (memcmp(ctx->result_buffer, ctx->dict->results[j].code,
-                                      strlen(ctx->dict->results[j].code)) == 0) {
-                                if (ctx->dict->results[j].ends_command_mode) {
-                                    ctx->in_online_mode = true;
-                                    MB_LOG_INFO("Hayes filter: CONNECT detected, switching to ONLINE mode");
-                                }
-                                break;
-                            }
+                        if (result->ends_command_mode) {
+                            ctx->in_online_mode = true;
+                            ctx->line_passthrough = false;
+                            hayes_escape_reset(&ctx->escape, now_ms);
+                            MB_LOG_INFO("Hayes filter: CONNECT detected, switching to ONLINE mode");
                         }
                     } else {
                         /* Unknown result - pass through */
@@ -1510,8 +1798,6 @@ int l3_filter_hayes_commands(hayes_filter_context_t *ctx, const unsigned char *i
                 output[out_pos++] = c;
                 break;
         }
-
-        ctx->last_char_time = current_time;
     }
 
     /* Note: No need to flush in ONLINE mode since we output immediately */
@@ -1533,6 +1819,22 @@ int l3_filter_telnet_controls(telnet_filter_state_t *state, const unsigned char
     *output_len = 0;
 
     for (size_t i = 0; i < input_len && out_pos < output_size; i++) {
+        if (current_state == TELNET_FILTER_STATE_DATA) {
+            /* Pass the run up to the next IAC through in one move */
+            size_t span = input_len - i;
+            size_t room = output_size - out_pos;
+            size_t run = util_find_byte(input + i, span < room ? span : room, 0xFF);
+
+            if (run > 0) {
+                memmove(output + out_pos, input + i, run);
+                out_pos += run;
+                i += run;
+                if (i == input_len || out_pos == output_size) {
+                    break;
+                }
+            }
+        }
+
         unsigned char c = input[i];
 
         switch (current_state) {
@@ -1699,7 +2001,7 @@ l3_pipeline_direction_t l3_schedule_next_pipeline(l3_context_t *l3_ctx)
                              &l3_ctx->pipeline_serial_to_telnet :
                              &l3_ctx->pipeline_telnet_to_serial;
         next->bytes_in_timeslice = 0;
-        next->last_timeslice_start = time(NULL);
+        next->last_timeslice_start = l3_get_timestamp_ms();
 
         l3_ctx->round_robin_counter++;
         MB_LOG_DEBUG("Fair scheduling: switched to pipeline %s (round #%d)",
@@ -1733,28 +2035,6 @@ static int l3_process_pipeline_with_quantum(l3_context_t *l3_ctx, l3_pipeline_di
     // Check if quantum has expired
     long long quantum_elapsed = current_time - l3_ctx->quantum_state.start_time;
 
-    /* DEBUG: Log quantum timer status */
-    static int quantum_debug_counter = 0;
-    if (++quantum_debug_counter % 100 == 0) {
-        /* printf("[DEBUG-QUANTUM-TIMER] elapsed=%lldms, quantum=%dms, will_expire=%d, start_time=%lld\n",
-               quantum_elapsed, l3_ctx->quantum_state.current_quantum_ms,
-               quantum_elapsed >= l3_ctx->quantum_state.current_quantum_ms,
-               l3_ctx->quantum_state.start_time);
-        fflush(stdout); */
-    }
-
-    /* DEBUG: Log when approaching quantum expiry */
-    if (quantum_elapsed >= 45 && quantum_elapsed < l3_ctx->quantum_state.current_quantum_ms) {
-        static int near_expiry_counter = 0;
-        if (++near_expiry_counter % 50 == 0) {
-            /* Commented out to reduce log noise
-            printf("[DEBUG-NEAR-EXPIRY] elapsed=%lldms, quantum=%dms, current_time=%lld\n",
-                   quantum_elapsed, l3_ctx->quantum_state.current_quantum_ms, current_time);
-            fflush(stdout);
-            */
-        }
-    }
-
     bool quantum_just_expired = false;
     if (quantum_elapsed >= l3_ctx->quantum_state.current_quantum_ms) {
         // Quantum expired - switch direction
@@ -1819,17 +2099,6 @@ static int l3_process_pipeline_with_quantum(l3_context_t *l3_ctx, l3_pipeline_di
     /* NOW read the final direction to process */
     current_direction = l3_ctx->sched_state.current_direction;
 
-    /* DEBUG: Log which direction is being processed */
-    static int debug_counter = 0;
-    if (++debug_counter % 10 == 0) {  /* Log every 10th iteration to reduce spam */
-        /* Commented out to reduce log noise
-        printf("[DEBUG-QUANTUM] Processing direction: %s (serial=%d, telnet=%d)\n",
-               current_direction == L3_PIPELINE_SERIAL_TO_TELNET ? "SERIAL→TELNET" : "TELNET→SERIAL",
-               L3_PIPELINE_SERIAL_TO_TELNET, L3_PIPELINE_TELNET_TO_SERIAL);
-        fflush(stdout);
-        */
-    }
-
     if (current_direction == L3_PIPELINE_SERIAL_TO_TELNET) {
         // Process serial to telnet pipeline
         ret = l3_process_serial_to_telnet_chunk(l3_ctx);
@@ -2371,6 +2640,133 @@ static bool l3_should_force_direction_switch(l3_context_t *l3_ctx, l3_pipeline_d
 
 /* ========== Enhanced Buffer Management - LEVEL3_WORK_TODO.txt Compliant ========== */
 
+/**
+ * Monotonic clock in microseconds (resize latency)
+ */
+static long long l3_ring_now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/**
+ * Round a ring size up to whole pages (the unit of the double mapping)
+ */
+static size_t l3_ring_round(size_t size)
+{
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    return (size + page - 1) / page * page;
+}
+
+/**
+ * Map both copies of the first size bytes of the memfd at ebuf->data
+ * MAP_FIXED replaces whatever the reservation held there, so the address
+ * never changes and the bytes keep their file offsets.
+ */
+static int l3_ring_map(l3_enhanced_double_buffer_t *ebuf, size_t size)
+{
+    for (int copy = 0; copy < 2; copy++) {
+        void *want = ebuf->data + (size_t)copy * size;
+        void *got = mmap(want, size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_FIXED, ebuf->memfd, 0);
+        if (got != want) {
+            MB_LOG_ERROR("Failed to map ring copy %d (%zu bytes): %s", copy, size, strerror(errno));
+            return L3_ERROR_MEMORY;
+        }
+    }
+
+    return L3_SUCCESS;
+}
+
+/**
+ * Give reservation pages beyond both copies back (PROT_NONE, no file pages)
+ */
+static void l3_ring_unmap_tail(l3_enhanced_double_buffer_t *ebuf, size_t from, size_t to)
+{
+    if (to > from) {
+        mmap(ebuf->data + from, to - from, PROT_NONE,
+             MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_NORESERVE, -1, 0);
+    }
+}
+
+/**
+ * Apply ebuf->pending_resize if queued data allows it (caller holds mutex)
+ * The data occupies [read_pos, read_pos + used) of the mapping; it can only
+ * stay put if that span lies inside the first copy of both sizes.
+ */
+static int l3_ring_try_resize(l3_enhanced_double_buffer_t *ebuf)
+{
+    size_t old_size = ebuf->buffer_size;
+    size_t new_size = ebuf->pending_resize;
+
+    if (new_size == 0) {
+        return L3_SUCCESS;
+    }
+
+    if (ebuf->used == 0) {
+        ebuf->read_pos = 0;
+    }
+    if (ebuf->read_pos + ebuf->used > MIN(old_size, new_size)) {
+        return L3_SUCCESS;  /* Straddles the end: wait for the reader */
+    }
+
+    long long start = l3_ring_now_us();
+    int ret = L3_SUCCESS;
+
+    if (new_size > old_size) {
+        /* Grow the file first, then extend both copies */
+        if (ftruncate(ebuf->memfd, (off_t)new_size) < 0) {
+            MB_LOG_ERROR("Failed to grow ring to %zu bytes: %s", new_size, strerror(errno));
+            ret = L3_ERROR_MEMORY;
+        } else if ((ret = l3_ring_map(ebuf, new_size)) != L3_SUCCESS) {
+            l3_ring_map(ebuf, old_size);
+        }
+    } else {
+        /* Stop mapping the pages, then drop them from the file */
+        ret = l3_ring_map(ebuf, new_size);
+        if (ret == L3_SUCCESS) {
+            l3_ring_unmap_tail(ebuf, 2 * new_size, 2 * old_size);
+            if (ftruncate(ebuf->memfd, (off_t)new_size) < 0) {
+                MB_LOG_WARNING("Failed to release ring pages: %s", strerror(errno));
+            }
+        } else {
+            l3_ring_map(ebuf, old_size);
+        }
+    }
+
+    long long done = l3_ring_now_us();
+    ebuf->pending_resize = 0;
+
+    if (ret != L3_SUCCESS) {
+        ebuf->metrics.resize_failures++;
+        return ret;
+    }
+
+    ebuf->buffer_size = new_size;
+    ebuf->config.current_buffer_size = new_size;
+
+    /* Update watermark thresholds based on new size */
+    ebuf->config.critical_watermark = (size_t)(new_size * 0.95);
+    ebuf->config.high_watermark = (size_t)(new_size * 0.80);
+    ebuf->config.low_watermark = (size_t)(new_size * 0.20);
+    ebuf->config.empty_watermark = (size_t)(new_size * 0.05);
+
+    double latency_us = (double)(done - ebuf->pending_resize_since_us);
+    ebuf->metrics.resize_events++;
+    ebuf->metrics.last_remap_us = (double)(done - start);
+    ebuf->metrics.last_resize_latency_us = latency_us;
+    if (latency_us > ebuf->metrics.max_resize_latency_us) {
+        ebuf->metrics.max_resize_latency_us = latency_us;
+    }
+
+    MB_LOG_INFO("Buffer resize completed: %zu -> %zu bytes in %.0f us (remap %.0f us), watermarks updated (critical: %zu, high: %zu, low: %zu)",
+                old_size, new_size, latency_us, ebuf->metrics.last_remap_us,
+                ebuf->config.critical_watermark, ebuf->config.high_watermark, ebuf->config.low_watermark);
+
+    return L3_SUCCESS;
+}
+
 /**
  * Initialize enhanced double buffer with watermark defense
  * @param ebuf Enhanced double buffer to initialize
@@ -2393,15 +2789,38 @@ int l3_enhanced_double_buffer_init(l3_enhanced_double_buffer_t *ebuf,
     }
 
     memset(ebuf, 0, sizeof(l3_enhanced_double_buffer_t));
+    ebuf->memfd = -1;
+
+    /* The double mapping works in whole pages */
+    initial_size = l3_ring_round(initial_size);
+    min_size = l3_ring_round(min_size);
+    max_size = l3_ring_round(max_size);
+
+    /* Reserve room for two copies of the largest ring, then map the file */
+    ebuf->memfd = memfd_create("modembridge-l3-ring", MFD_CLOEXEC);
+    if (ebuf->memfd < 0) {
+        MB_LOG_ERROR("Failed to create enhanced buffer memfd: %s", strerror(errno));
+        return L3_ERROR_MEMORY;
+    }
 
-    /* Allocate buffers dynamically */
-    ebuf->main_data = malloc(initial_size);
-    ebuf->sub_data = malloc(initial_size);
+    void *reserve = mmap(NULL, 2 * max_size, PROT_NONE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (reserve == MAP_FAILED) {
+        MB_LOG_ERROR("Failed to reserve enhanced buffer address space: %s", strerror(errno));
+        close(ebuf->memfd);
+        ebuf->memfd = -1;
+        return L3_ERROR_MEMORY;
+    }
+    ebuf->data = reserve;
+    ebuf->reserved_size = 2 * max_size;
 
-    if (!ebuf->main_data || !ebuf->sub_data) {
+    if (ftruncate(ebuf->memfd, (off_t)initial_size) < 0 ||
+        l3_ring_map(ebuf, initial_size) != L3_SUCCESS) {
         MB_LOG_ERROR("Failed to allocate enhanced buffer memory");
-        free(ebuf->main_data);
-        free(ebuf->sub_data);
+        munmap(ebuf->data, ebuf->reserved_size);
+        close(ebuf->memfd);
+        ebuf->data = NULL;
+        ebuf->memfd = -1;
         return L3_ERROR_MEMORY;
     }
 
@@ -2422,7 +2841,7 @@ int l3_enhanced_double_buffer_init(l3_enhanced_double_buffer_t *ebuf,
     ebuf->config.backpressure_enabled = true;
     ebuf->config.flow_control_enabled = true;
 
-    /* Set adaptive sizing parameters */
+    /* Set adaptive sizing parameters (steps below a page act as one page) */
     ebuf->config.growth_threshold = 85;      /* Grow when >85% full */
     ebuf->config.shrink_threshold = 15;      /* Shrink when <15% full */
     ebuf->config.growth_step_size = 1024;    /* Grow in 1KB steps */
@@ -2445,30 +2864,23 @@ int l3_enhanced_double_buffer_init(l3_enhanced_double_buffer_t *ebuf,
     ebuf->last_resize_time = time(NULL);
     ebuf->consecutive_overflows = 0;
     ebuf->consecutive_underflows = 0;
+    ebuf->pending_resize = 0;
 
-    /* Initialize buffer switching */
-    ebuf->main_active = true;
-    ebuf->main_len = 0;
-    ebuf->main_pos = 0;
-    ebuf->sub_len = 0;
+    /* Initialize ring position */
+    ebuf->read_pos = 0;
+    ebuf->used = 0;
 
     /* Initialize mutex */
     if (pthread_mutex_init(&ebuf->mutex, NULL) != 0) {
         MB_LOG_ERROR("Failed to initialize enhanced buffer mutex");
-        free(ebuf->main_data);
-        free(ebuf->sub_data);
+        munmap(ebuf->data, ebuf->reserved_size);
+        close(ebuf->memfd);
+        ebuf->data = NULL;
+        ebuf->memfd = -1;
         return L3_ERROR_THREAD;
     }
 
-    /* Initialize memory pool */
-    int ret = l3_memory_pool_init(&ebuf->memory_pool,
-                                  max_size * 2,  /* Pool size = 2x max buffer */
-                                  512);         /* Block size = 512 bytes */
-    if (ret != L3_SUCCESS) {
-        MB_LOG_WARNING("Failed to initialize memory pool, continuing without it");
-    }
-
-    MB_LOG_INFO("Enhanced buffer initialized: size=%zu, min=%zu, max=%zu",
+    MB_LOG_INFO("Enhanced buffer initialized: size=%zu, min=%zu, max=%zu (memfd ring)",
                 initial_size, min_size, max_size);
 
     return L3_SUCCESS;
@@ -2480,21 +2892,19 @@ int l3_enhanced_double_buffer_init(l3_enhanced_double_buffer_t *ebuf,
  */
 void l3_enhanced_double_buffer_cleanup(l3_enhanced_double_buffer_t *ebuf)
 {
-    if (!ebuf) {
+    if (!ebuf || !ebuf->data) {
         return;
     }
 
-    /* Cleanup memory pool */
-    l3_memory_pool_cleanup(&ebuf->memory_pool);
-
-    /* Free allocated buffers */
-    free(ebuf->main_data);
-    free(ebuf->sub_data);
+    /* Release the mapping and its file */
+    munmap(ebuf->data, ebuf->reserved_size);
+    close(ebuf->memfd);
 
     /* Cleanup mutex */
     pthread_mutex_destroy(&ebuf->mutex);
 
     memset(ebuf, 0, sizeof(l3_enhanced_double_buffer_t));
+    ebuf->memfd = -1;
 
     MB_LOG_DEBUG("Enhanced buffer cleaned up");
 }
@@ -2506,12 +2916,11 @@ void l3_enhanced_double_buffer_cleanup(l3_enhanced_double_buffer_t *ebuf)
  */
 l3_watermark_level_t l3_get_watermark_level(l3_enhanced_double_buffer_t *ebuf)
 {
-    if (!ebuf) {
+    if (!ebuf || ebuf->buffer_size == 0) {
         return L3_WATERMARK_EMPTY;
     }
 
-    size_t total_usage = ebuf->main_len + ebuf->sub_len;
-    double fill_ratio = (double)total_usage / (ebuf->buffer_size * 2);
+    double fill_ratio = (double)ebuf->used / ebuf->buffer_size;
 
     if (fill_ratio > 0.95) {
         return L3_WATERMARK_CRITICAL;
@@ -2537,7 +2946,7 @@ l3_watermark_level_t l3_get_watermark_level(l3_enhanced_double_buffer_t *ebuf)
 size_t l3_enhanced_double_buffer_write(l3_enhanced_double_buffer_t *ebuf,
                                        const unsigned char *data, size_t len)
 {
-    if (!ebuf || !data || len == 0) {
+    if (!ebuf || !ebuf->data || !data || len == 0) {
         return 0;
     }
 
@@ -2564,13 +2973,13 @@ size_t l3_enhanced_double_buffer_write(l3_enhanced_double_buffer_t *ebuf,
         }
     }
 
-    /* Check available space in sub-buffer */
-    size_t available_space = ebuf->buffer_size - ebuf->sub_len;
+    /* Free space follows the queued bytes; the second copy makes it one span */
+    size_t available_space = ebuf->buffer_size - ebuf->used;
     size_t to_write = len < available_space ? len : available_space;
 
     if (to_write > 0) {
-        memcpy(ebuf->sub_data + ebuf->sub_len, data, to_write);
-        ebuf->sub_len += to_write;
+        memcpy(ebuf->data + ebuf->read_pos + ebuf->used, data, to_write);
+        ebuf->used += to_write;
         ebuf->last_activity = time(NULL);
 
         /* Reset consecutive overflows on successful write */
@@ -2615,19 +3024,22 @@ size_t l3_enhanced_double_buffer_write(l3_enhanced_double_buffer_t *ebuf,
 size_t l3_enhanced_double_buffer_read(l3_enhanced_double_buffer_t *ebuf,
                                       unsigned char *data, size_t len)
 {
-    if (!ebuf || !data || len == 0) {
+    if (!ebuf || !ebuf->data || !data || len == 0) {
         return 0;
     }
 
     pthread_mutex_lock(&ebuf->mutex);
 
-    /* Read from main buffer */
-    size_t available = ebuf->main_len - ebuf->main_pos;
-    size_t to_read = len < available ? len : available;
+    /* Queued bytes are one span, even across the end of the ring */
+    size_t to_read = len < ebuf->used ? len : ebuf->used;
 
     if (to_read > 0) {
-        memcpy(data, ebuf->main_data + ebuf->main_pos, to_read);
-        ebuf->main_pos += to_read;
+        memcpy(data, ebuf->data + ebuf->read_pos, to_read);
+        ebuf->read_pos += to_read;
+        if (ebuf->read_pos >= ebuf->buffer_size) {
+            ebuf->read_pos -= ebuf->buffer_size;
+        }
+        ebuf->used -= to_read;
         ebuf->bytes_processed += to_read;
         ebuf->last_activity = time(NULL);
 
@@ -2641,7 +3053,7 @@ size_t l3_enhanced_double_buffer_read(l3_enhanced_double_buffer_t *ebuf,
         MB_LOG_DEBUG("Buffer empty - underflow #%d", ebuf->consecutive_underflows);
     }
 
-    /* Update metrics */
+    /* Update metrics (completes a deferred resize once the data has moved) */
     l3_update_buffer_metrics(ebuf, 0, to_read);
 
     pthread_mutex_unlock(&ebuf->mutex);
@@ -2717,6 +3129,36 @@ const char *l3_watermark_level_to_string(l3_watermark_level_t level)
     }
 }
 
+/**
+ * Check if buffer needs dynamic resizing
+ * @param ebuf Enhanced double buffer context
+ * @param should_grow Pointer to store if buffer should grow
+ * @param should_shrink Pointer to store if buffer should shrink
+ * @return SUCCESS on success, error code on failure
+ */
+int l3_check_resize_needed(l3_enhanced_double_buffer_t *ebuf, bool *should_grow, bool *should_shrink)
+{
+    if (!ebuf || !should_grow || !should_shrink || ebuf->buffer_size == 0) {
+        return L3_ERROR_INVALID_PARAM;
+    }
+
+    size_t fill_pct = ebuf->used * 100 / ebuf->buffer_size;
+    l3_watermark_level_t level = l3_get_watermark_level(ebuf);
+
+    /* Growth condition: high usage, critical watermark or frequent overflows */
+    *should_grow = (fill_pct > ebuf->config.growth_threshold ||
+                    level == L3_WATERMARK_CRITICAL ||
+                    ebuf->consecutive_overflows >= 3) &&
+                   ebuf->buffer_size < ebuf->config.max_buffer_size;
+
+    /* Shrink condition: consistent low usage */
+    *should_shrink = !*should_grow &&
+                     fill_pct < ebuf->config.shrink_threshold &&
+                     ebuf->buffer_size > ebuf->config.min_buffer_size;
+
+    return L3_SUCCESS;
+}
+
 /**
  * Resize enhanced buffer dynamically - BACKPRESSURE.txt compliant
  * @param ebuf Enhanced double buffer context
@@ -2725,10 +3167,12 @@ const char *l3_watermark_level_to_string(l3_watermark_level_t level)
  */
 int l3_resize_buffer(l3_enhanced_double_buffer_t *ebuf, size_t new_size)
 {
-    if (!ebuf || new_size == 0) {
+    if (!ebuf || !ebuf->data || new_size == 0) {
         return L3_ERROR_INVALID_PARAM;
     }
 
+    new_size = l3_ring_round(new_size);
+
     /* Validate new size against configured bounds */
     if (new_size < ebuf->config.min_buffer_size || new_size > ebuf->config.max_buffer_size) {
         MB_LOG_ERROR("Invalid resize target: %zu bytes (min: %zu, max: %zu)",
@@ -2739,68 +3183,25 @@ int l3_resize_buffer(l3_enhanced_double_buffer_t *ebuf, size_t new_size)
     /* No resize needed */
     if (new_size == ebuf->buffer_size) {
         MB_LOG_DEBUG("Resize not needed: already %zu bytes", new_size);
+        ebuf->pending_resize = 0;
         return L3_SUCCESS;
     }
 
     MB_LOG_INFO("Resizing enhanced buffer: %zu -> %zu bytes", ebuf->buffer_size, new_size);
 
-    /* Allocate new buffers */
-    unsigned char *new_main_data = malloc(new_size);
-    unsigned char *new_sub_data = malloc(new_size);
-
-    if (!new_main_data || !new_sub_data) {
-        MB_LOG_ERROR("Failed to allocate memory for buffer resize");
-        free(new_main_data);
-        free(new_sub_data);
-        return L3_ERROR_MEMORY;
-    }
-
-    /* Copy existing data to new buffers */
-    size_t main_copy_len = ebuf->main_len < new_size ? ebuf->main_len : new_size;
-    size_t sub_copy_len = ebuf->sub_len < new_size ? ebuf->sub_len : new_size;
-
-    if (main_copy_len > 0) {
-        memcpy(new_main_data, ebuf->main_data, main_copy_len);
-    }
-    if (sub_copy_len > 0) {
-        memcpy(new_sub_data, ebuf->sub_data, sub_copy_len);
+    if (ebuf->pending_resize == 0) {
+        ebuf->pending_resize_since_us = l3_ring_now_us();
     }
+    ebuf->pending_resize = new_size;
 
-    /* Handle data truncation if shrinking */
-    if (new_size < ebuf->buffer_size) {
-        if (ebuf->main_len > new_size) {
-            ebuf->main_len = new_size;
-            MB_LOG_WARNING("Main buffer truncated: %zu -> %zu bytes", ebuf->main_len, new_size);
-        }
-        if (ebuf->sub_len > new_size) {
-            ebuf->sub_len = new_size;
-            MB_LOG_WARNING("Sub buffer truncated: %zu -> %zu bytes", ebuf->sub_len, new_size);
-        }
-        /* Adjust read position if beyond new buffer size */
-        if (ebuf->main_pos >= new_size) {
-            ebuf->main_pos = 0;  /* Reset to beginning if truncated past current position */
-        }
+    int ret = l3_ring_try_resize(ebuf);
+    if (ret == L3_SUCCESS && ebuf->pending_resize != 0) {
+        ebuf->metrics.resize_deferred++;
+        MB_LOG_DEBUG("Resize to %zu bytes deferred: %zu queued bytes straddle the end",
+                    new_size, ebuf->used);
     }
 
-    /* Free old buffers and update pointers */
-    free(ebuf->main_data);
-    free(ebuf->sub_data);
-
-    ebuf->main_data = new_main_data;
-    ebuf->sub_data = new_sub_data;
-    ebuf->buffer_size = new_size;
-    ebuf->config.current_buffer_size = new_size;
-
-    /* Update watermark thresholds based on new size */
-    ebuf->config.critical_watermark = (size_t)(new_size * 0.95);
-    ebuf->config.high_watermark = (size_t)(new_size * 0.80);
-    ebuf->config.low_watermark = (size_t)(new_size * 0.20);
-    ebuf->config.empty_watermark = (size_t)(new_size * 0.05);
-
-    MB_LOG_INFO("Buffer resize completed: %zu bytes, watermarks updated (critical: %zu, high: %zu, low: %zu)",
-                new_size, ebuf->config.critical_watermark, ebuf->config.high_watermark, ebuf->config.low_watermark);
-
-    return L3_SUCCESS;
+    return ret;
 }
 
 /**
@@ -2819,10 +3220,14 @@ int l3_update_buffer_metrics(l3_enhanced_double_buffer_t *ebuf,
 
     /* Suppress unused parameter warnings */
     (void)bytes_written;
-    (void)bytes_read;
+
+    /* A read may have moved queued data out of the way of a deferred resize */
+    if (bytes_read > 0 && ebuf->pending_resize != 0) {
+        l3_ring_try_resize(ebuf);
+    }
 
     /* Update current usage */
-    ebuf->metrics.current_usage = ebuf->main_len + ebuf->sub_len;
+    ebuf->metrics.current_usage = ebuf->used;
 
     /* Update peak usage */
     if (ebuf->metrics.current_usage > ebuf->metrics.peak_usage) {
@@ -2830,7 +3235,7 @@ int l3_update_buffer_metrics(l3_enhanced_double_buffer_t *ebuf,
     }
 
     /* Update minimum free space */
-    size_t total_capacity = ebuf->buffer_size * 2;
+    size_t total_capacity = ebuf->buffer_size;
     size_t current_free = total_capacity - ebuf->metrics.current_usage;
     if (current_free < ebuf->metrics.min_free_space) {
         ebuf->metrics.min_free_space = current_free;
@@ -2857,52 +3262,46 @@ int l3_update_buffer_metrics(l3_enhanced_double_buffer_t *ebuf,
     ebuf->metrics.last_activity = time(NULL);
 
     /* BACKPRESSURE.txt compliant dynamic resizing */
-    if (ebuf->config.adaptive_sizing_enabled) {
+    if (ebuf->config.adaptive_sizing_enabled && ebuf->pending_resize == 0) {
         /* Check if resizing is needed (rate-limited to prevent thrashing) */
         time_t now = time(NULL);
-        if (now - ebuf->last_resize_time > 30) {  /* Minimum 30 seconds between resizes */
-            bool should_grow = false;
-            bool should_shrink = false;
-
-            /* Growth condition: consistent high usage or frequent overflows */
-            if (current_fill_ratio > 0.85 || ebuf->consecutive_overflows >= 3) {
-                should_grow = true;
-            }
-            /* Shrink condition: consistent low usage */
-            else if (current_fill_ratio < 0.15 && ebuf->buffer_size > ebuf->config.min_buffer_size) {
-                should_shrink = true;
-            }
-
-            if (should_grow || should_shrink) {
-                size_t new_size = ebuf->buffer_size;
-
-                if (should_grow) {
-                    /* Grow by configured step size, but don't exceed maximum */
-                    new_size = ebuf->buffer_size + ebuf->config.growth_step_size;
-                    if (new_size > ebuf->config.max_buffer_size) {
-                        new_size = ebuf->config.max_buffer_size;
-                    }
-                    MB_LOG_INFO("Growing buffer: %zu -> %zu bytes (fill_ratio: %.2f, overflows: %d)",
-                                ebuf->buffer_size, new_size, current_fill_ratio, ebuf->consecutive_overflows);
-                } else if (should_shrink) {
-                    /* Shrink by configured step size, but don't go below minimum */
-                    new_size = ebuf->buffer_size - ebuf->config.shrink_step_size;
-                    if (new_size < ebuf->config.min_buffer_size) {
-                        new_size = ebuf->config.min_buffer_size;
-                    }
-                    MB_LOG_INFO("Shrinking buffer: %zu -> %zu bytes (fill_ratio: %.2f)",
-                                ebuf->buffer_size, new_size, current_fill_ratio);
+        bool should_grow = false;
+        bool should_shrink = false;
+
+        if (now - ebuf->last_resize_time > 30 &&  /* Minimum 30 seconds between resizes */
+            l3_check_resize_needed(ebuf, &should_grow, &should_shrink) == L3_SUCCESS &&
+            (should_grow || should_shrink)) {
+            size_t page = l3_ring_round(1);
+            size_t new_size = ebuf->buffer_size;
+
+            if (should_grow) {
+                /* Grow by configured step size, but don't exceed maximum */
+                new_size = ebuf->buffer_size + MAX(ebuf->config.growth_step_size, page);
+                if (new_size > ebuf->config.max_buffer_size) {
+                    new_size = ebuf->config.max_buffer_size;
+                }
+                MB_LOG_INFO("Growing buffer: %zu -> %zu bytes (fill_ratio: %.2f, overflows: %d)",
+                            ebuf->buffer_size, new_size, current_fill_ratio, ebuf->consecutive_overflows);
+            } else {
+                /* Shrink by configured step size, but don't go below minimum */
+                size_t step = MAX(ebuf->config.shrink_step_size, page);
+                new_size = (ebuf->buffer_size > step) ? ebuf->buffer_size - step : 0;
+                new_size = new_size / page * page;
+                if (new_size < ebuf->config.min_buffer_size) {
+                    new_size = ebuf->config.min_buffer_size;
                 }
+                MB_LOG_INFO("Shrinking buffer: %zu -> %zu bytes (fill_ratio: %.2f)",
+                            ebuf->buffer_size, new_size, current_fill_ratio);
+            }
 
-                /* Apply resize if different */
-                if (new_size != ebuf->buffer_size) {
-                    int ret = l3_resize_buffer(ebuf, new_size);
-                    if (ret == L3_SUCCESS) {
-                        ebuf->last_resize_time = now;
-                        /* Reset overflow/underflow counters after successful resize */
-                        ebuf->consecutive_overflows = 0;
-                        ebuf->consecutive_underflows = 0;
-                    }
+            /* Apply resize if different (also counts a deferred one) */
+            if (new_size != ebuf->buffer_size) {
+                int ret = l3_resize_buffer(ebuf, new_size);
+                if (ret == L3_SUCCESS) {
+                    ebuf->last_resize_time = now;
+                    /* Reset overflow/underflow counters after successful resize */
+                    ebuf->consecutive_overflows = 0;
+                    ebuf->consecutive_underflows = 0;
                 }
             }
         }
@@ -2929,7 +3328,7 @@ int l3_get_buffer_metrics(l3_enhanced_double_buffer_t *ebuf, l3_buffer_metrics_t
     *metrics = ebuf->metrics;
 
     /* Update current values */
-    metrics->current_usage = ebuf->main_len + ebuf->sub_len;
+    metrics->current_usage = ebuf->used;
     metrics->current_level = ebuf->current_watermark;
 
     pthread_mutex_unlock(&ebuf->mutex);
@@ -2952,32 +3351,47 @@ int l3_memory_pool_init(l3_memory_pool_t *pool, size_t pool_size, size_t block_s
 
     memset(pool, 0, sizeof(l3_memory_pool_t));
 
-    /* Allocate memory pool */
-    pool->pool_memory = malloc(pool_size);
-    if (!pool->pool_memory) {
+    /* Round blocks up so every block starts on an L3_POOL_ALIGN boundary */
+    block_size = (block_size + L3_POOL_ALIGN - 1) & ~((size_t)L3_POOL_ALIGN - 1);
+    size_t total_blocks = pool_size / block_size;
+    if (total_blocks == 0 || total_blocks >= UINT32_MAX) {
+        MB_LOG_ERROR("Invalid memory pool geometry: %zu bytes, %zu-byte blocks",
+                     pool_size, block_size);
+        return L3_ERROR_INVALID_PARAM;
+    }
+
+    /* Allocate memory pool and per-block bookkeeping */
+    pool->pool_memory = aligned_alloc(L3_POOL_ALIGN, total_blocks * block_size);
+    pool->next_free = calloc(total_blocks, sizeof(*pool->next_free));
+    pool->in_use = calloc(total_blocks, sizeof(*pool->in_use));
+    if (!pool->pool_memory || !pool->next_free || !pool->in_use) {
         MB_LOG_ERROR("Failed to allocate memory pool of %zu bytes", pool_size);
+        l3_memory_pool_cleanup(pool);
         return L3_ERROR_MEMORY;
     }
 
     /* Initialize pool parameters */
-    pool->pool_size = pool_size;
+    pool->pool_size = total_blocks * block_size;
     pool->block_size = block_size;
-    pool->total_blocks = pool_size / block_size;
-    pool->free_blocks = pool->total_blocks;
+    pool->total_blocks = total_blocks;
 
-    /* Initialize mutex */
-    if (pthread_mutex_init(&pool->pool_mutex, NULL) != 0) {
-        MB_LOG_ERROR("Failed to initialize memory pool mutex");
-        free(pool->pool_memory);
-        return L3_ERROR_THREAD;
+    /* Thread every block onto the free list in address order */
+    for (size_t i = 0; i < total_blocks; i++) {
+        atomic_init(&pool->next_free[i], (i + 1 < total_blocks) ? (uint32_t)(i + 2) : 0);
+        atomic_init(&pool->in_use[i], 0);
     }
+    atomic_init(&pool->free_head, 1);
+    atomic_init(&pool->allocated_blocks, 0);
+    atomic_init(&pool->high_water, 0);
+    atomic_init(&pool->allocation_count, 0);
+    atomic_init(&pool->free_count, 0);
+    atomic_init(&pool->alloc_failures, 0);
 
     /* Initially all blocks are free */
-    pool->fragmentation_ratio = 0.0;
-    pool->largest_free_block = pool_size;
+    l3_memory_pool_update_metrics(pool);
 
     MB_LOG_DEBUG("Memory pool initialized: %zu bytes, %zu blocks of %zu bytes",
-                pool_size, pool->total_blocks, block_size);
+                pool->pool_size, pool->total_blocks, block_size);
 
     return L3_SUCCESS;
 }
@@ -2993,33 +3407,37 @@ unsigned char *l3_memory_pool_alloc(l3_memory_pool_t *pool)
         return NULL;
     }
 
-    pthread_mutex_lock(&pool->pool_mutex);
+    /* Pop the free list head; the tag makes a stale head fail the CAS */
+    uint64_t head = atomic_load_explicit(&pool->free_head, memory_order_acquire);
+    uint32_t index;
+    for (;;) {
+        index = (uint32_t)head;
+        if (index == 0) {
+            atomic_fetch_add_explicit(&pool->alloc_failures, 1, memory_order_relaxed);
+            return NULL;
+        }
 
-    if (pool->free_blocks == 0) {
-        MB_LOG_DEBUG("Memory pool exhausted - no free blocks");
-        pthread_mutex_unlock(&pool->pool_mutex);
-        return NULL;
+        uint32_t next = atomic_load_explicit(&pool->next_free[index - 1], memory_order_relaxed);
+        uint64_t new_head = (((head >> 32) + 1) << 32) | next;
+        if (atomic_compare_exchange_weak_explicit(&pool->free_head, &head, new_head,
+                                                  memory_order_acquire, memory_order_acquire)) {
+            break;
+        }
     }
+    index--;
 
-    /* Simple allocation - return next free block */
-    /* In a real implementation, this would use a free list */
-    unsigned char *block = pool->pool_memory +
-                          (pool->allocated_blocks * pool->block_size);
+    atomic_store_explicit(&pool->in_use[index], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&pool->allocation_count, 1, memory_order_relaxed);
 
-    if (pool->allocated_blocks < pool->total_blocks) {
-        pool->allocated_blocks++;
-        pool->free_blocks--;
-        pool->allocation_count++;
-
-        /* Update fragmentation metrics */
-        pool->fragmentation_ratio = (double)(pool->total_blocks - pool->free_blocks) / pool->total_blocks;
-        pool->largest_free_block = pool->free_blocks * pool->block_size;
-    } else {
-        block = NULL;
+    /* Track the high-water mark */
+    size_t in_use = atomic_fetch_add_explicit(&pool->allocated_blocks, 1, memory_order_relaxed) + 1;
+    size_t peak = atomic_load_explicit(&pool->high_water, memory_order_relaxed);
+    while (in_use > peak &&
+           !atomic_compare_exchange_weak_explicit(&pool->high_water, &peak, in_use,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
     }
 
-    pthread_mutex_unlock(&pool->pool_mutex);
-    return block;
+    return pool->pool_memory + (size_t)index * pool->block_size;
 }
 
 /**
@@ -3030,27 +3448,72 @@ unsigned char *l3_memory_pool_alloc(l3_memory_pool_t *pool)
  */
 int l3_memory_pool_free(l3_memory_pool_t *pool, unsigned char *block)
 {
-    if (!pool || !block) {
+    if (!pool || !block || !pool->pool_memory) {
         return L3_ERROR_INVALID_PARAM;
     }
 
-    pthread_mutex_lock(&pool->pool_mutex);
-
-    /* Simple free - in a real implementation, this would add to free list */
-    if (pool->allocated_blocks > 0) {
-        pool->allocated_blocks--;
-        pool->free_blocks++;
-        pool->free_count++;
+    /* Reject foreign, interior and already-free pointers */
+    if (block < pool->pool_memory || block >= pool->pool_memory + pool->pool_size ||
+        (size_t)(block - pool->pool_memory) % pool->block_size != 0) {
+        MB_LOG_ERROR("Memory pool free of foreign block %p", (void *)block);
+        return L3_ERROR_INVALID_PARAM;
+    }
 
-        /* Update fragmentation metrics */
-        pool->fragmentation_ratio = (double)(pool->total_blocks - pool->free_blocks) / pool->total_blocks;
-        pool->largest_free_block = pool->free_blocks * pool->block_size;
+    uint32_t index = (uint32_t)((size_t)(block - pool->pool_memory) / pool->block_size);
+    if (atomic_exchange_explicit(&pool->in_use[index], 0, memory_order_relaxed) == 0) {
+        MB_LOG_ERROR("Memory pool double free of block %u", index);
+        return L3_ERROR_INVALID_PARAM;
     }
 
-    pthread_mutex_unlock(&pool->pool_mutex);
+    atomic_fetch_sub_explicit(&pool->allocated_blocks, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&pool->free_count, 1, memory_order_relaxed);
+
+    /* Push onto the free list head */
+    uint64_t head = atomic_load_explicit(&pool->free_head, memory_order_relaxed);
+    uint64_t new_head;
+    do {
+        atomic_store_explicit(&pool->next_free[index], (uint32_t)head, memory_order_relaxed);
+        new_head = (((head >> 32) + 1) << 32) | (index + 1);
+    } while (!atomic_compare_exchange_weak_explicit(&pool->free_head, &head, new_head,
+                                                    memory_order_release, memory_order_relaxed));
+
     return L3_SUCCESS;
 }
 
+/**
+ * Recompute fragmentation metrics from the block flags
+ * @param pool Memory pool context
+ */
+void l3_memory_pool_update_metrics(l3_memory_pool_t *pool)
+{
+    if (!pool || !pool->in_use) {
+        return;
+    }
+
+    size_t free_blocks = 0;
+    size_t runs = 0;
+    size_t run = 0;
+    size_t largest_run = 0;
+
+    for (size_t i = 0; i < pool->total_blocks; i++) {
+        if (atomic_load_explicit(&pool->in_use[i], memory_order_relaxed)) {
+            run = 0;
+            continue;
+        }
+        free_blocks++;
+        if (run++ == 0) {
+            runs++;
+        }
+        largest_run = MAX(largest_run, run);
+    }
+
+    pool->free_blocks = free_blocks;
+    pool->free_list_length = runs;
+    pool->largest_free_block = largest_run * pool->block_size;
+    pool->fragmentation_ratio = free_blocks > 0 ?
+        1.0 - (double)largest_run / (double)free_blocks : 0.0;
+}
+
 /**
  * Cleanup memory pool and release all memory
  * @param pool Memory pool to cleanup
@@ -3061,8 +3524,15 @@ void l3_memory_pool_cleanup(l3_memory_pool_t *pool)
         return;
     }
 
+    size_t leaked = pool->in_use ?
+        atomic_load_explicit(&pool->allocated_blocks, memory_order_relaxed) : 0;
+    if (leaked > 0) {
+        MB_LOG_WARNING("Memory pool released with %zu blocks still allocated", leaked);
+    }
+
     free(pool->pool_memory);
-    pthread_mutex_destroy(&pool->pool_mutex);
+    free((void *)pool->next_free);
+    free((void *)pool->in_use);
     memset(pool, 0, sizeof(l3_memory_pool_t));
 
     MB_LOG_DEBUG("Memory pool cleaned up");
@@ -3078,12 +3548,12 @@ bool l3_should_apply_backpressure(l3_pipeline_t *pipeline)
 
     /* Check if output buffer is getting full (high watermark) */
     size_t available = l3_double_buffer_available(&pipeline->buffers);
-    bool buffer_high = available > L3_HIGH_WATERMARK;
+    bool buffer_high = available > pipeline->buffers.capacity * 4 / 5;  /* 80%, as L3_HIGH_WATERMARK */
 
     /* Check if backpressure has been active too long */
     if (pipeline->backpressure_active) {
-        time_t now = time(NULL);
-        if (now - pipeline->backpressure_start > L3_BACKPRESSURE_TIMEOUT_MS / 1000) {
+        long long now = l3_get_timestamp_ms();
+        if (now - pipeline->backpressure_start > L3_BACKPRESSURE_TIMEOUT_MS) {
             MB_LOG_WARNING("Pipeline %s: Backpressure timeout, forcing release", pipeline->name);
             return false;
         }
@@ -3100,7 +3570,7 @@ int l3_apply_backpressure(l3_pipeline_t *pipeline)
 
     if (!pipeline->backpressure_active) {
         pipeline->backpressure_active = true;
-        pipeline->backpressure_start = time(NULL);
+        pipeline->backpressure_start = l3_get_timestamp_ms();
         pipeline->state = L3_PIPELINE_STATE_BLOCKED;
         MB_LOG_INFO("Pipeline %s: Backpressure applied", pipeline->name);
     }
@@ -3214,10 +3684,20 @@ void l3_print_pipeline_stats(l3_pipeline_t *pipeline)
     MB_LOG_INFO("  Bytes Processed: %llu", (unsigned long long)pipeline->total_bytes_processed);
     MB_LOG_INFO("  Bytes Dropped: %llu", (unsigned long long)pipeline->total_bytes_dropped);
     MB_LOG_INFO("  Buffer Switches: %llu", (unsigned long long)pipeline->pipeline_switches);
+    MB_LOG_INFO("  Buffer Handoffs: %llu (%llu idle takeovers)",
+                (unsigned long long)pipeline->buffers.handoffs,
+                (unsigned long long)pipeline->buffers.takeovers);
     MB_LOG_INFO("  Avg Processing Time: %.2f ms", pipeline->avg_processing_time_ms);
     MB_LOG_INFO("  Backpressure Active: %s", pipeline->backpressure_active ? "Yes" : "No");
     MB_LOG_INFO("  Main Buffer Available: %zu bytes", l3_double_buffer_available(&pipeline->buffers));
     MB_LOG_INFO("  Sub Buffer Free: %zu bytes", l3_double_buffer_free(&pipeline->buffers));
+
+    l3_buffer_metrics_t metrics;
+    if (l3_double_buffer_get_metrics(&pipeline->buffers, &metrics) == L3_SUCCESS) {
+        MB_LOG_INFO("  Chunk Pool: %zu in use, peak %zu, %llu refused",
+                    metrics.pool_blocks_in_use, metrics.pool_high_water,
+                    (unsigned long long)metrics.pool_alloc_failures);
+    }
 }
 
 double l3_get_system_utilization(l3_context_t *l3_ctx)
@@ -3247,6 +3727,27 @@ double l3_get_system_utilization(l3_context_t *l3_ctx)
 
 /* ========== Thread Functions ========== */
 
+/**
+ * Sleep while a pipeline is under backpressure
+ * Telnet→serial waits only until the serial TX pacer has tokens or FIFO
+ * room again, so a slow line is refilled on time; other cases back off 10ms.
+ */
+static void l3_backpressure_wait(l3_context_t *l3_ctx, l3_pipeline_direction_t direction)
+{
+    int wait_ms = L3_BACKPRESSURE_WAIT_MS;
+
+    if (direction == L3_PIPELINE_TELNET_TO_SERIAL && l3_ctx->bridge != NULL) {
+        int tx_ms = serial_tx_next_timeout_ms(&l3_ctx->bridge->serial);
+        if (tx_ms >= 0) {
+            wait_ms = MIN(tx_ms, L3_BACKPRESSURE_WAIT_MS);
+        }
+    }
+
+    if (wait_ms > 0) {
+        usleep((useconds_t)wait_ms * 1000);
+    }
+}
+
 void *l3_management_thread_func(void *arg)
 {
     l3_context_t *l3_ctx = (l3_context_t *)arg;
@@ -3262,17 +3763,24 @@ void *l3_management_thread_func(void *arg)
         }
 
         /* Only process data if in DATA_TRANSFER state */
-        if (l3_ctx->system_state == L3_STATE_DATA_TRANSFER && l3_ctx->level3_active) {
+        if (l3_data_transfer_active(l3_ctx)) {
             /* DEBUG: Log entry into data processing (only once at start) */
-            static bool entered_data_transfer = false;
-            if (!entered_data_transfer) {
+            if (!l3_ctx->data_transfer_logged) {
                 printf("[DEBUG-MGMT-THREAD] Entered DATA_TRANSFER processing loop\n");
                 fflush(stdout);
-                entered_data_transfer = true;
+                l3_ctx->data_transfer_logged = true;
             }
 
-            /* Use enhanced quantum-based scheduling instead of basic round-robin */
-            int ret = l3_process_pipeline_with_quantum(l3_ctx, l3_ctx->active_pipeline);
+            /* File transfer: no time slices, both directions move every pass
+             * so the sending side gets the full line rate */
+            int ret = L3_SUCCESS;
+            if (l3_xfer_raw(l3_ctx)) {
+                l3_process_serial_to_telnet_chunk(l3_ctx);
+                l3_process_telnet_to_serial_chunk(l3_ctx);
+            } else {
+                /* Use enhanced quantum-based scheduling instead of basic round-robin */
+                ret = l3_process_pipeline_with_quantum(l3_ctx, l3_ctx->active_pipeline);
+            }
 
             if (ret != L3_SUCCESS) {
                 MB_LOG_WARNING("Quantum-based pipeline processing failed: %d", ret);
@@ -3295,7 +3803,7 @@ void *l3_management_thread_func(void *arg)
                 /* Check for backpressure */
                 if (l3_should_apply_backpressure(active)) {
                     l3_apply_backpressure(active);
-                    usleep(10000);  /* 10ms delay under backpressure */
+                    l3_backpressure_wait(l3_ctx, l3_ctx->active_pipeline);
                     continue;
                 } else {
                     l3_release_backpressure(active);
@@ -3310,8 +3818,7 @@ void *l3_management_thread_func(void *arg)
             }
 
             /* Periodically update scheduling statistics and fair queue weights */
-            static int statistics_counter = 0;
-            if (++statistics_counter >= 100) {  /* Every 100 iterations */
+            if (++l3_ctx->statistics_counter >= 100) {  /* Every 100 iterations */
                 l3_scheduling_stats_t stats;
                 if (l3_get_scheduling_statistics(l3_ctx, &stats) == L3_SUCCESS) {
                     MB_LOG_DEBUG("Scheduling stats - utilization: %.2f%%, fairness: %.2f, cycles: %d",
@@ -3323,24 +3830,31 @@ void *l3_management_thread_func(void *arg)
                 /* Periodic latency boundary enforcement for continuous monitoring */
                 l3_enforce_latency_boundaries(l3_ctx);
 
-                statistics_counter = 0;
+                l3_ctx->statistics_counter = 0;
             }
         } else {
-            /* Not in data transfer state - wait for state changes */
-            if (l3_ctx->system_state == L3_STATE_INITIALIZING) {
-                usleep(100000);  /* 100ms during initialization */
-            } else if (l3_ctx->system_state == L3_STATE_READY) {
-                usleep(500000);  /* 500ms in ready state (DCD waiting) */
-            } else if (l3_ctx->system_state == L3_STATE_CONNECTING ||
-                      l3_ctx->system_state == L3_STATE_NEGOTIATING) {
-                usleep(200000);  /* 200ms during connection/negotiation */
-            } else if (l3_ctx->system_state == L3_STATE_FLUSHING) {
-                usleep(50000);   /* 50ms during flushing (more frequent checks) */
-            } else if (l3_ctx->system_state == L3_STATE_SHUTTING_DOWN ||
-                      l3_ctx->system_state == L3_STATE_TERMINATED) {
-                usleep(1000000); /* 1s during shutdown/termination */
-            } else {
-                usleep(L3_FAIRNESS_TIME_SLICE_MS * 1000);  /* Default timeslice */
+            /* Not in data transfer state - wait for an event or the poll interval */
+            switch (l3_get_system_state(l3_ctx)) {
+                case L3_STATE_INITIALIZING:
+                    l3_wait_event(l3_ctx, 100);     /* L1 readiness is polled */
+                    break;
+                case L3_STATE_READY:
+                    l3_wait_event(l3_ctx, 500);     /* DCD rising arrives as an event */
+                    break;
+                case L3_STATE_CONNECTING:
+                case L3_STATE_NEGOTIATING:
+                    l3_wait_event(l3_ctx, 200);     /* Connection progress is polled */
+                    break;
+                case L3_STATE_FLUSHING:
+                    l3_wait_event(l3_ctx, 50);      /* Frequent checks while draining */
+                    break;
+                case L3_STATE_SHUTTING_DOWN:
+                case L3_STATE_TERMINATED:
+                    l3_wait_event(l3_ctx, 1000);
+                    break;
+                default:
+                    l3_wait_event(l3_ctx, L3_FAIRNESS_TIME_SLICE_MS);
+                    break;
             }
         }
 
@@ -3368,9 +3882,9 @@ const char *l3_get_pipeline_name(l3_pipeline_direction_t direction)
 
 long long l3_get_timestamp_ms(void)
 {
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    return (long long)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
 }
 
 const char *l3_pipeline_state_to_string(l3_pipeline_state_t state)
@@ -3408,6 +3922,55 @@ static const char *l3_get_direction_name(l3_pipeline_direction_t direction)
     }
 }
 
+/**
+ * Check whether a file transfer has the line in raw mode
+ */
+static bool l3_xfer_raw(l3_context_t *l3_ctx)
+{
+    return l3_ctx->bridge != NULL && xfer_active(&l3_ctx->bridge->xfer, l3_get_timestamp_ms());
+}
+
+#ifdef ENABLE_LEVEL2
+/**
+ * Send serial→telnet data during a file transfer
+ * Skips line assembly, echo, the Hayes filter and transcoding: data goes
+ * from ring memory to the telnet queue with IAC escaping only.
+ * @param l3_ctx Level 3 context
+ * @return SUCCESS on success, error code on failure
+ */
+static int l3_process_raw_serial_to_telnet(l3_context_t *l3_ctx)
+{
+    ts_circular_buffer_t *ring = &l3_ctx->bridge->ts_serial_to_telnet_buf;
+    size_t len;
+    latency_stamp_t stamp;
+    const unsigned char *data = ts_cbuf_peek(ring, &len);
+
+    if (len == 0) {
+        return L3_SUCCESS;
+    }
+    ts_cbuf_stamp(ring, &stamp);
+
+    /* A line typed before the transfer started is stale now */
+    l3_ctx->s2t.line_len = 0;
+    l3_ctx->s2t.multibyte_len = 0;
+    l3_ctx->s2t.multibyte_expected = 0;
+
+    ssize_t taken = bridge_send_raw(l3_ctx->bridge, data, len, &stamp);
+    if (taken < 0) {
+        ts_cbuf_consume(ring, len);
+        MB_LOG_WARNING("Failed to send transfer data to telnet");
+        return L3_ERROR_IO;
+    }
+    ts_cbuf_consume(ring, (size_t)taken);
+
+    telnet_flush_writes(&l3_ctx->bridge->telnet);
+    MB_TRACE(TRACE_BRIDGE_FORWARD, DATALOG_DIR_TO_TELNET, (size_t)taken);
+    l3_update_pipeline_stats(&l3_ctx->pipeline_serial_to_telnet, (size_t)taken, 0.0);
+
+    return L3_SUCCESS;
+}
+#endif
+
 /**
  * Process a chunk of data from serial to telnet
  * Implements line buffering based on Level 1 modem buffer logic:
@@ -3423,89 +3986,81 @@ static int l3_process_serial_to_telnet_chunk(l3_context_t *l3_ctx)
         return L3_ERROR_INVALID_PARAM;
     }
 
-    /* Static line buffer (persists across calls) */
-    static unsigned char line_buffer[LINE_BUFFER_SIZE];
-    static size_t line_len = 0;
-    static time_t line_start_time = 0;
+#ifdef ENABLE_LEVEL2
+    if (l3_xfer_raw(l3_ctx)) {
+        return l3_process_raw_serial_to_telnet(l3_ctx);
+    }
+#endif
 
-    /* Static multibyte buffer for character assembly */
-    static unsigned char multibyte_buffer[6];  /* Max UTF-8 is 4 bytes, but safety margin */
-    static size_t multibyte_len = 0;
-    static int multibyte_expected = 0;
-    static time_t multibyte_start_time = 0;
+    /* Line and multibyte assembly state lives in l3_ctx->s2t (one per line) */
 
     /* Read from serial→telnet buffer (populated by modem thread) */
     unsigned char serial_buf[L3_MAX_BURST_SIZE];
+    latency_stamp_t stamp;
+    ts_cbuf_stamp(&l3_ctx->bridge->ts_serial_to_telnet_buf, &stamp);
     size_t serial_len = ts_cbuf_read(&l3_ctx->bridge->ts_serial_to_telnet_buf,
                                      serial_buf, sizeof(serial_buf));
 
-    /* DEBUG: Log read result */
-    static int read_counter = 0;
-    if (++read_counter % 50 == 0 || serial_len > 0) {  /* Log periodically or when data found */
-        /* Commented out to reduce log noise
-        printf("[DEBUG-CHUNK-READ] Serial→Telnet buffer read: %zu bytes\n", serial_len);
-        fflush(stdout);
-        */
-    }
-
     if (serial_len > 0) {
         time_t now = time(NULL);
+        long long now_ms = l3_get_timestamp_ms();   /* Ingress time of the chunk */
 
         /* Check for line buffer timeout (20 seconds) */
-        if (line_len > 0 && (now - line_start_time) > 20) {
+        if (l3_ctx->s2t.line_len > 0 && (now - l3_ctx->s2t.line_start_time) > 20) {
             MB_LOG_DEBUG("Line buffer timeout - clearing old data");
-            line_len = 0;
-            memset(line_buffer, 0, sizeof(line_buffer));
+            l3_ctx->s2t.line_len = 0;
+            memset(l3_ctx->s2t.line_buffer, 0, sizeof(l3_ctx->s2t.line_buffer));
         }
 
         /* Check for multibyte timeout (1 second) */
-        if (multibyte_len > 0 && (now - multibyte_start_time) > 1) {
-            MB_LOG_DEBUG("Multibyte timeout - echoing incomplete sequence: %zu bytes", multibyte_len);
+        if (l3_ctx->s2t.multibyte_len > 0 && (now - l3_ctx->s2t.multibyte_start_time) > 1) {
+            MB_LOG_DEBUG("Multibyte timeout - echoing incomplete sequence: %zu bytes", l3_ctx->s2t.multibyte_len);
             /* Echo incomplete multibyte as-is */
-            l3_echo_to_modem(l3_ctx, multibyte_buffer, multibyte_len);
+            l3_echo_to_modem(l3_ctx, l3_ctx->s2t.multibyte_buffer, l3_ctx->s2t.multibyte_len);
 
             /* Reset multibyte state */
-            multibyte_len = 0;
-            multibyte_expected = 0;
-            memset(multibyte_buffer, 0, sizeof(multibyte_buffer));
+            l3_ctx->s2t.multibyte_len = 0;
+            l3_ctx->s2t.multibyte_expected = 0;
+            memset(l3_ctx->s2t.multibyte_buffer, 0, sizeof(l3_ctx->s2t.multibyte_buffer));
         }
 
         /* Process input data byte by byte for line buffering and echo */
         for (size_t i = 0; i < serial_len; i++) {
             unsigned char c = serial_buf[i];
 
-            /* Track start time for new line */
-            if (line_len == 0) {
-                line_start_time = now;
+            /* Track start time (and ingress stamp) for new line */
+            if (l3_ctx->s2t.line_len == 0) {
+                l3_ctx->s2t.line_start_time = now;
+                l3_ctx->s2t.line_stamp = stamp;
             }
 
             /* === Echo handling (immediate for single-byte, after assembly for multibyte) === */
 
             /* Check if we're in the middle of multibyte assembly */
-            if (multibyte_len > 0) {
+            if (l3_ctx->s2t.multibyte_len > 0) {
                 /* Add to multibyte buffer */
-                if (multibyte_len < sizeof(multibyte_buffer)) {
-                    multibyte_buffer[multibyte_len++] = c;
+                if (l3_ctx->s2t.multibyte_len < sizeof(l3_ctx->s2t.multibyte_buffer)) {
+                    l3_ctx->s2t.multibyte_buffer[l3_ctx->s2t.multibyte_len++] = c;
                 }
 
                 /* Check if multibyte sequence is complete */
-                if (l3_is_multibyte_complete(multibyte_buffer, multibyte_len, multibyte_expected)) {
+                if (l3_is_multibyte_complete(l3_ctx->s2t.multibyte_buffer, l3_ctx->s2t.multibyte_len, l3_ctx->s2t.multibyte_expected)) {
                     /* Echo the complete multibyte character */
-                    l3_echo_to_modem(l3_ctx, multibyte_buffer, multibyte_len);
-                    MB_LOG_DEBUG("Echoed multibyte character: %d bytes", multibyte_len);
+                    l3_echo_to_modem(l3_ctx, l3_ctx->s2t.multibyte_buffer, l3_ctx->s2t.multibyte_len);
+                    MB_LOG_DEBUG("Echoed multibyte character: %d bytes", l3_ctx->s2t.multibyte_len);
 
                     /* Reset multibyte buffer */
-                    multibyte_len = 0;
-                    multibyte_expected = 0;
-                    memset(multibyte_buffer, 0, sizeof(multibyte_buffer));
+                    l3_ctx->s2t.multibyte_len = 0;
+                    l3_ctx->s2t.multibyte_expected = 0;
+                    memset(l3_ctx->s2t.multibyte_buffer, 0, sizeof(l3_ctx->s2t.multibyte_buffer));
                 }
             } else if (l3_is_multibyte_start(c)) {
                 /* Start of new multibyte sequence */
-                multibyte_buffer[0] = c;
-                multibyte_len = 1;
-                multibyte_expected = l3_get_multibyte_length(c);
-                multibyte_start_time = now;  /* Track when multibyte started */
-                MB_LOG_DEBUG("Started multibyte sequence, expecting %d bytes", multibyte_expected);
+                l3_ctx->s2t.multibyte_buffer[0] = c;
+                l3_ctx->s2t.multibyte_len = 1;
+                l3_ctx->s2t.multibyte_expected = l3_get_multibyte_length(c);
+                l3_ctx->s2t.multibyte_start_time = now;  /* Track when multibyte started */
+                MB_LOG_DEBUG("Started multibyte sequence, expecting %d bytes", l3_ctx->s2t.multibyte_expected);
             } else {
                 /* Single-byte character - echo immediately */
                 l3_echo_to_modem(l3_ctx, &c, 1);
@@ -3517,9 +4072,9 @@ static int l3_process_serial_to_telnet_chunk(l3_context_t *l3_ctx)
             /* === Line buffer handling (for telnet transmission) === */
 
             /* Add character to line buffer */
-            if (line_len < sizeof(line_buffer) - 1) {
-                line_buffer[line_len++] = c;
-                line_buffer[line_len] = '\0';
+            if (l3_ctx->s2t.line_len < sizeof(l3_ctx->s2t.line_buffer) - 1) {
+                l3_ctx->s2t.line_buffer[l3_ctx->s2t.line_len++] = c;
+                l3_ctx->s2t.line_buffer[l3_ctx->s2t.line_len] = '\0';
             }
 
             /* Check if we have a complete line */
@@ -3528,19 +4083,12 @@ static int l3_process_serial_to_telnet_chunk(l3_context_t *l3_ctx)
 
             if (c == '\r' || c == '\n') {
                 line_complete = true;
-                printf("[DEBUG-LINE] Line complete (CR/LF): %zu bytes\n", line_len);
-            } else if (line_len >= sizeof(line_buffer) - 1) {
+            } else if (l3_ctx->s2t.line_len >= sizeof(l3_ctx->s2t.line_buffer) - 1) {
                 buffer_full = true;
-                printf("[DEBUG-LINE] Line buffer full: %zu bytes\n", line_len);
             }
 
             /* Process complete line or full buffer */
             if (line_complete || buffer_full) {
-                /* Debug log the line content */
-                printf("[DEBUG-LINE] Processing line: [%.*s]\n",
-                       (int)(line_len > 50 ? 50 : line_len), line_buffer);
-                fflush(stdout);
-
                 /* Process through Hayes filter */
                 unsigned char filtered_buf[L3_MAX_BURST_SIZE];
                 size_t filtered_len = 0;
@@ -3548,62 +4096,56 @@ static int l3_process_serial_to_telnet_chunk(l3_context_t *l3_ctx)
                 /* Apply Hayes filter to the complete line */
                 hayes_filter_context_t *hayes_ctx = &l3_ctx->pipeline_serial_to_telnet.filter_state.hayes_ctx;
                 int filter_ret = l3_filter_hayes_commands(hayes_ctx,
-                                                         line_buffer, line_len,
+                                                         l3_ctx->s2t.line_buffer, l3_ctx->s2t.line_len,
                                                          filtered_buf, sizeof(filtered_buf),
-                                                         &filtered_len);
-
-                /* DEBUG: Log filter result */
-                printf("[DEBUG-FILTER] Hayes filter: in=%zu, out=%zu, ret=%d\n",
-                       line_len, filtered_len, filter_ret);
-                if (filtered_len > 0 && filtered_len <= 20) {
-                    printf("[DEBUG-FILTER] Output: ");
-                    for (size_t j = 0; j < filtered_len; j++) {
-                        printf("%02x ", filtered_buf[j]);
-                    }
-                    printf("(%.*s)\n", (int)filtered_len, filtered_buf);
-                }
-                fflush(stdout);
+                                                         &filtered_len, now_ms);
+
+                MB_TRACE_DATA(TRACE_L3_LINE, l3_ctx->s2t.line_len, filtered_len,
+                              l3_ctx->s2t.line_buffer, l3_ctx->s2t.line_len);
 
                 /* Send filtered data to telnet */
                 if (filter_ret == L3_SUCCESS && filtered_len > 0) {
 #ifdef ENABLE_LEVEL2
-                    int send_ret = telnet_queue_write(&l3_ctx->bridge->telnet,
-                                                     filtered_buf, filtered_len);
+                    /* TERMINAL_CHARSET to SERVER_CHARSET (bound: 3 bytes per input byte) */
+                    unsigned char transcoded[L3_MAX_BURST_SIZE * 3];
+                    unsigned char *send_buf = filtered_buf;
+                    charset_conv_t *conv = &l3_ctx->bridge->charset_to_telnet;
+                    if (charset_conv_active(conv)) {
+                        filtered_len = charset_convert(conv, filtered_buf, filtered_len,
+                                                       transcoded, sizeof(transcoded));
+                        send_buf = transcoded;
+                    }
+
+                    int send_ret = filtered_len == 0 ? SUCCESS :
+                                   telnet_queue_write_stamped(&l3_ctx->bridge->telnet,
+                                                              send_buf, filtered_len,
+                                                              &l3_ctx->s2t.line_stamp);
                     if (send_ret != SUCCESS) {
                         MB_LOG_WARNING("Failed to queue data to telnet: %d", send_ret);
-                        printf("[ERROR] telnet_queue_write failed: %d\n", send_ret);
-                        fflush(stdout);
                         /* Don't return error - continue processing */
                     } else {
-                        printf("[DEBUG-TELNET-SEND] Queued %zu bytes to telnet buffer\n", filtered_len);
-                        fflush(stdout);
-
                         /* Flush the write buffer to actually send data to telnet server */
                         int flush_ret = telnet_flush_writes(&l3_ctx->bridge->telnet);
                         if (flush_ret != SUCCESS) {
                             MB_LOG_WARNING("Failed to flush telnet write buffer: %d", flush_ret);
-                            printf("[ERROR] telnet_flush_writes failed: %d\n", flush_ret);
-                            fflush(stdout);
                         } else {
-                            printf("[DEBUG-TELNET-FLUSH] Flushed telnet write buffer successfully\n");
-                            fflush(stdout);
-                            MB_LOG_DEBUG("Line processed and sent: %zu → %zu bytes to telnet",
-                                       line_len, filtered_len);
+                            MB_TRACE(TRACE_BRIDGE_FORWARD, DATALOG_DIR_TO_TELNET, filtered_len);
                         }
                     }
 #endif
                 }
 
                 /* Clear line buffer for next line */
-                line_len = 0;
-                memset(line_buffer, 0, sizeof(line_buffer));
+                l3_ctx->s2t.line_len = 0;
+                memset(l3_ctx->s2t.line_buffer, 0, sizeof(l3_ctx->s2t.line_buffer));
 
                 /* If buffer was full and not line complete,
                    start new line with current character */
                 if (buffer_full && !line_complete) {
-                    line_buffer[0] = c;
-                    line_len = 1;
-                    line_start_time = now;
+                    l3_ctx->s2t.line_buffer[0] = c;
+                    l3_ctx->s2t.line_len = 1;
+                    l3_ctx->s2t.line_start_time = now;
+                    l3_ctx->s2t.line_stamp = stamp;
                 }
             }
         }
@@ -3628,24 +4170,41 @@ static int l3_process_telnet_to_serial_chunk(l3_context_t *l3_ctx)
     }
 
 #ifdef ENABLE_LEVEL2
-    /* Read from telnet buffer */
+    /* Read from telnet buffer, no more than the serial TX queue can take
+     * (filtering never grows telnet→serial data) */
     unsigned char telnet_buf[L3_MAX_BURST_SIZE];
+    serial_tx_pump(&l3_ctx->bridge->serial);    /* Spend tokens the pacer earned since the last pass */
+    size_t budget = MIN(sizeof(telnet_buf), serial_tx_space(&l3_ctx->bridge->serial));
+    if (budget == 0) {
+        return L3_SUCCESS;  /* Serial TX backpressure: leave data in the ring */
+    }
+    latency_stamp_t stamp;
+    ts_cbuf_stamp(&l3_ctx->bridge->ts_telnet_to_serial_buf, &stamp);
     size_t telnet_len = ts_cbuf_read(&l3_ctx->bridge->ts_telnet_to_serial_buf,
-                                    telnet_buf, sizeof(telnet_buf));
+                                    telnet_buf, budget);
 
     if (telnet_len > 0) {
-        /* Process through pipeline */
+        /* Process through pipeline; during a file transfer the data (already
+         * telnet-decoded) skips the control filter */
         unsigned char filtered_buf[L3_MAX_BURST_SIZE];
+        unsigned char *out_buf = filtered_buf;
         size_t filtered_len;
+        int ret = L3_SUCCESS;
 
-        int ret = l3_pipeline_process(&l3_ctx->pipeline_telnet_to_serial,
-                                     telnet_buf, telnet_len,
-                                     filtered_buf, sizeof(filtered_buf), &filtered_len);
+        if (l3_xfer_raw(l3_ctx)) {
+            out_buf = telnet_buf;
+            filtered_len = telnet_len;
+            l3_update_pipeline_stats(&l3_ctx->pipeline_telnet_to_serial, telnet_len, 0.0);
+        } else {
+            ret = l3_pipeline_process(&l3_ctx->pipeline_telnet_to_serial,
+                                      telnet_buf, telnet_len,
+                                      filtered_buf, sizeof(filtered_buf), &filtered_len);
+        }
 
         if (ret == L3_SUCCESS && filtered_len > 0) {
             /* Write to serial port */
-            ssize_t sent = serial_write(&l3_ctx->bridge->serial,
-                                       filtered_buf, filtered_len);
+            ssize_t sent = serial_write_stamped(&l3_ctx->bridge->serial,
+                                               out_buf, filtered_len, &stamp);
             if (sent > 0) {
                 MB_LOG_DEBUG("Processed telnet→serial chunk: %zu → %zd bytes", telnet_len, sent);
                 return L3_SUCCESS;
@@ -9,6 +9,16 @@
 #include "telnet.h"
 #include "bridge.h"
 #include "healthcheck.h"
+#include "multiline.h"
+#include "datalog.h"
+#include "trace.h"
+#include "metrics.h"
+#include "rtsched.h"
+#include "bufpool.h"
+#ifdef ENABLE_LEVEL2
+#include "resolver.h"
+#include "dialdir.h"
+#endif
 #include <getopt.h>
 
 /* Signal handler */
@@ -20,6 +30,8 @@ static void signal_handler(int signo)
     } else if (signo == SIGHUP) {
         MB_LOG_INFO("Received SIGHUP, reloading configuration...");
         g_reload_config = 1;
+    } else if (signo == SIGUSR2) {
+        trace_toggle();
     }
 }
 
@@ -48,12 +60,55 @@ static int setup_signals(void)
         return ERROR_GENERAL;
     }
 
+    /* SIGUSR2 toggles data-path tracepoints */
+    if (sigaction(SIGUSR2, &sa, NULL) < 0) {
+        MB_LOG_ERROR("Failed to setup SIGUSR2 handler: %s", strerror(errno));
+        return ERROR_GENERAL;
+    }
+
     /* Ignore SIGPIPE */
     signal(SIGPIPE, SIG_IGN);
 
     return SUCCESS;
 }
 
+/* Run all [line.N] sections until shutdown (multi-line mode) */
+static int run_multiline(config_t *config)
+{
+    multiline_ctx_t ml;
+    int ret = SUCCESS;
+
+    MB_LOG_INFO("Starting multi-line mode (%d lines)", config->line_count);
+
+    if (multiline_init(&ml, config) != SUCCESS) {
+        MB_LOG_ERROR("Failed to initialize multi-line mode");
+        return ERROR_GENERAL;
+    }
+
+    if (multiline_start(&ml) != SUCCESS) {
+        MB_LOG_ERROR("Failed to start multi-line mode");
+        multiline_stop(&ml);
+        return ERROR_GENERAL;
+    }
+
+    while (g_running) {
+        if (multiline_run(&ml) != SUCCESS) {
+            MB_LOG_ERROR("Multi-line error, exiting...");
+            ret = ERROR_GENERAL;
+            break;
+        }
+
+        if (g_reload_config) {
+            /* Running bridges reference the per-line configs directly */
+            MB_LOG_WARNING("Configuration reload is not supported in multi-line mode, restart to apply changes");
+            g_reload_config = 0;
+        }
+    }
+
+    multiline_stop(&ml);
+    return ret;
+}
+
 /* Print usage information */
 static void print_usage(const char *prog_name)
 {
@@ -66,6 +121,8 @@ static void print_usage(const char *prog_name)
     printf("  -d, --daemon         Run as daemon\n");
     printf("  -p, --pid-file FILE  PID file (default: %s)\n", DEFAULT_PID_FILE);
     printf("  -v, --verbose        Verbose logging\n");
+    printf("  -L, --convert-log FILE  Print a binary data log as text and exit\n");
+    printf("  -T, --dump-trace FILE   Print a binary trace file as text and exit\n");
     printf("  -h, --help           Show this help message\n");
     printf("  -V, --version        Show version information\n");
     printf("\n");
@@ -88,13 +145,15 @@ int main(int argc, char *argv[])
         {"verbose",  no_argument,       0, 'v'},
         {"help",     no_argument,       0, 'h'},
         {"version",  no_argument,       0, 'V'},
+        {"convert-log", required_argument, 0, 'L'},
+        {"dump-trace", required_argument, 0, 'T'},
         {0, 0, 0, 0}
     };
 
     int option_index = 0;
     int c;
 
-    while ((c = getopt_long(argc, argv, "c:dp:vhV", long_options, &option_index)) != -1) {
+    while ((c = getopt_long(argc, argv, "c:dp:vhVL:T:", long_options, &option_index)) != -1) {
         switch (c) {
             case 'c':
                 SAFE_STRNCPY(config_file, optarg, sizeof(config_file));
@@ -114,6 +173,12 @@ int main(int argc, char *argv[])
             case 'V':
                 printf("ModemBridge v%s\n", MODEMBRIDGE_VERSION);
                 return SUCCESS;
+            case 'L':
+                /* Offline converter: binary DATA_LOG_FORMAT -> otelnet.log text */
+                return datalog_convert(optarg, stdout) == SUCCESS ? 0 : 1;
+            case 'T':
+                /* Offline decoder for TRACE_FILE */
+                return trace_dump(optarg, stdout) == SUCCESS ? 0 : 1;
             default:
                 print_usage(argv[0]);
                 return ERROR_INVALID_ARG;
@@ -153,12 +218,31 @@ int main(int argc, char *argv[])
     config_print(&config);
 
     /* === Health Check (one-time, at startup) === */
-    /* TEMPORARILY DISABLED - Health check may pollute serial buffers */
-    printf("\n");
-    printf("[INFO] Health check DISABLED for testing\n");
-    printf("[INFO] Starting server without health check...\n");
-    fflush(stdout);
-    MB_LOG_INFO("Starting server (health check DISABLED)...");
+    /* Off by default: its AT probe leaves modem responses behind. bridge_start
+     * flushes the port and runs MODEM_INIT_COMMAND afterwards. */
+    if (config.health_check) {
+        bool multiline = config_is_multiline(&config);
+        const config_t *lines = multiline ? config.lines : &config;
+        int line_count = multiline ? config.line_count : 1;
+        health_report_t *reports = calloc(line_count, sizeof(health_report_t));
+
+        printf("\n");
+        if (reports != NULL &&
+            healthcheck_run_lines(lines, line_count, reports, config.health_check_timeout_ms) == SUCCESS) {
+            for (int i = 0; i < line_count; i++) {
+                healthcheck_print_report(&reports[i], &lines[i]);
+            }
+        } else {
+            MB_LOG_WARNING("Health check could not run");
+        }
+        free(reports);
+        fflush(stdout);
+    } else {
+        printf("\n");
+        printf("[INFO] Health check disabled (HEALTH_CHECK=0)\n");
+        fflush(stdout);
+        MB_LOG_INFO("Starting server (health check disabled)...");
+    }
     /* === Health Check End === */
 
     /* Setup signal handlers */
@@ -188,6 +272,44 @@ int main(int argc, char *argv[])
         /* Continue anyway */
     }
 
+    /* Memory locks are not inherited across fork, so lock after daemonize */
+    if (config.memlock) {
+        rtsched_lock_memory();      /* Warns and continues without locking */
+        bufpool_prefault();
+    }
+
+    /* Tracepoint drain thread (after daemonize: threads do not survive fork) */
+    if (trace_init(config.trace_file, config.trace_enabled) != SUCCESS) {
+        MB_LOG_WARNING("Tracepoints unavailable");
+        /* Continue anyway */
+    }
+
+    /* Per-line counters (before bridge_init, which attaches each line) */
+    if (metrics_init(config.metrics_shm, config.metrics_address, config.metrics_port,
+                     config_is_multiline(&config) ? config.line_count : 1) != SUCCESS) {
+        MB_LOG_WARNING("Metrics unavailable");
+        /* Continue anyway */
+    }
+
+#ifdef ENABLE_LEVEL2
+    /* DNS cache and background resolver shared by every line */
+    if (resolver_init(config.dns_cache_ttl) != SUCCESS) {
+        MB_LOG_WARNING("Background DNS resolution unavailable");
+        /* Continue anyway: lookups resolve on the connecting thread */
+    }
+
+    /* Backend pools of the [dial.NAME] sections (kept across reloads) */
+    if (dialdir_init(&config) != SUCCESS) {
+        MB_LOG_WARNING("Dialing directory unavailable");
+    }
+#endif
+
+    /* Multi-line mode: one bridge per [line.N] section */
+    if (config_is_multiline(&config)) {
+        ret = run_multiline(&config);
+        goto cleanup;
+    }
+
     /* Initialize and run bridge */
     printf("[DEBUG] Initializing bridge context...\n");
     fflush(stdout);
@@ -227,6 +349,13 @@ cleanup_bridge:
 
 cleanup:
     /* Cleanup */
+#ifdef ENABLE_LEVEL2
+    dialdir_log_status();
+    dialdir_shutdown();
+    resolver_shutdown();
+#endif
+    metrics_shutdown();
+    trace_shutdown();
     config_free(&config);
     remove_pid_file(config.pid_file);
 
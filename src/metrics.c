@@ -0,0 +1,527 @@
+/*
+ * metrics.c - Per-line performance counters for ModemBridge
+ */
+
+#include "metrics.h"
+#include <stddef.h>
+#include <pthread.h>
+#include <time.h>
+#include <poll.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/eventfd.h>
+
+#define METRICS_LISTEN_BACKLOG  8
+#define METRICS_REQUEST_MAX     1024
+
+static const char *metrics_direction_names[METRICS_DIRECTION_COUNT] = {
+    [METRICS_SERIAL_TO_TELNET] = "serial_to_telnet",
+    [METRICS_TELNET_TO_SERIAL] = "telnet_to_serial",
+};
+
+static const char *metrics_stage_names[METRICS_STAGE_COUNT] = {
+    [METRICS_STAGE_RX]      = "rx",
+    [METRICS_STAGE_QUEUE]   = "queue",
+    [METRICS_STAGE_PROCESS] = "process",
+    [METRICS_STAGE_OUTPUT]  = "output",
+    [METRICS_STAGE_DEVICE]  = "device",
+    [METRICS_STAGE_TOTAL]   = "total",
+};
+
+static metrics_header_t *metrics_map = NULL;
+static size_t metrics_map_size = 0;
+static pthread_mutex_t metrics_attach_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_t metrics_thread;
+static bool metrics_thread_started = false;
+static int metrics_listen_fd = -1;
+static int metrics_wake_fd = -1;
+
+/**
+ * Line slot by index
+ */
+static metrics_line_t *metrics_slot(uint32_t index)
+{
+    return (metrics_line_t *)((unsigned char *)metrics_map + metrics_map->header_size) + index;
+}
+
+/**
+ * Histogram bucket index for a value in microseconds
+ */
+int metrics_hist_index(uint64_t value_us)
+{
+    if (value_us < METRICS_HIST_SUB) {
+        return (int)value_us;
+    }
+
+    int msb = 63 - __builtin_clzll(value_us);
+    if (msb > METRICS_HIST_MAX_BIT) {
+        return METRICS_HIST_BUCKETS - 1;
+    }
+
+    return (msb - METRICS_HIST_SUB_BITS + 1) * METRICS_HIST_SUB +
+           (int)((value_us >> (msb - METRICS_HIST_SUB_BITS)) & (METRICS_HIST_SUB - 1));
+}
+
+/**
+ * Smallest value (microseconds) that falls into a bucket
+ */
+uint64_t metrics_hist_lower(int index)
+{
+    if (index < METRICS_HIST_SUB) {
+        return (uint64_t)index;
+    }
+
+    int msb = index / METRICS_HIST_SUB + METRICS_HIST_SUB_BITS - 1;
+    uint64_t sub = (uint64_t)(index % METRICS_HIST_SUB);
+
+    return (METRICS_HIST_SUB + sub) << (msb - METRICS_HIST_SUB_BITS);
+}
+
+/**
+ * Estimate a latency percentile from a histogram
+ */
+uint64_t metrics_hist_percentile_us(const metrics_hist_t *hist, double quantile)
+{
+    uint64_t total = 0;
+    uint64_t counts[METRICS_HIST_BUCKETS];
+
+    if (hist == NULL) {
+        return 0;
+    }
+
+    for (int b = 0; b < METRICS_HIST_BUCKETS; b++) {
+        counts[b] = atomic_load_explicit(&hist->buckets[b], memory_order_relaxed);
+        total += counts[b];
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    uint64_t rank = (uint64_t)(quantile * (double)total);
+    uint64_t seen = 0;
+    for (int b = 0; b < METRICS_HIST_BUCKETS - 1; b++) {
+        seen += counts[b];
+        if (seen > rank) {
+            return metrics_hist_lower(b + 1);
+        }
+    }
+    return atomic_load_explicit(&hist->max_us, memory_order_relaxed);
+}
+
+/**
+ * Record one latency sample (the histogram's writer)
+ */
+void metrics_hist_record(metrics_hist_t *hist, uint64_t latency_us)
+{
+    if (hist == NULL) {
+        return;
+    }
+
+    metrics_add(&hist->buckets[metrics_hist_index(latency_us)], 1);
+    metrics_add(&hist->count, 1);
+    metrics_add(&hist->sum_us, latency_us);
+    if (latency_us > atomic_load_explicit(&hist->max_us, memory_order_relaxed)) {
+        atomic_store_explicit(&hist->max_us, latency_us, memory_order_relaxed);
+    }
+}
+
+/**
+ * Name of a latency stage
+ */
+const char *metrics_stage_name(metrics_stage_id_t stage)
+{
+    if ((unsigned int)stage >= METRICS_STAGE_COUNT) {
+        return "unknown";
+    }
+    return metrics_stage_names[stage];
+}
+
+/**
+ * Count bytes dropped by a producer
+ */
+void metrics_count_drop(metrics_direction_t *dir, uint64_t n)
+{
+    if (dir == NULL || n == 0) {
+        return;
+    }
+
+    /* Drops are rare; fetch_add keeps extra producers (Level 3 echo) exact */
+    atomic_fetch_add_explicit(&dir->drops, n, memory_order_relaxed);
+}
+
+/**
+ * Get the counters for a line, attaching a free slot on first use
+ */
+metrics_line_t *metrics_line_attach(int line_id, const char *label)
+{
+    metrics_line_t *found = NULL;
+
+    if (metrics_map == NULL) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&metrics_attach_mutex);
+
+    for (uint32_t i = 0; i < metrics_map->line_capacity && found == NULL; i++) {
+        metrics_line_t *line = metrics_slot(i);
+        if (atomic_load(&line->in_use) && line->line_id == line_id) {
+            found = line;
+        }
+    }
+
+    for (uint32_t i = 0; i < metrics_map->line_capacity && found == NULL; i++) {
+        metrics_line_t *line = metrics_slot(i);
+        if (!atomic_load(&line->in_use)) {
+            line->line_id = line_id;
+            SAFE_STRNCPY(line->label, label != NULL ? label : "", sizeof(line->label));
+            atomic_store_explicit(&line->in_use, 1, memory_order_release);
+            atomic_fetch_add(&metrics_map->generation, 1);
+            found = line;
+        }
+    }
+
+    pthread_mutex_unlock(&metrics_attach_mutex);
+
+    if (found == NULL) {
+        MB_LOG_WARNING("Metrics: no free slot for line %d", line_id);
+    }
+    return found;
+}
+
+/**
+ * Write one counter or gauge family header
+ */
+static void metrics_write_family(FILE *out, const char *name, const char *type, const char *help)
+{
+    fprintf(out, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+/**
+ * Write a per-direction value for every attached line
+ */
+static void metrics_write_direction_values(FILE *out, const char *name, size_t offset)
+{
+    for (uint32_t i = 0; i < metrics_map->line_capacity; i++) {
+        metrics_line_t *line = metrics_slot(i);
+        if (!atomic_load_explicit(&line->in_use, memory_order_acquire)) {
+            continue;
+        }
+        for (int d = 0; d < METRICS_DIRECTION_COUNT; d++) {
+            atomic_uint_fast64_t *value = (atomic_uint_fast64_t *)((unsigned char *)&line->dir[d] + offset);
+            fprintf(out, "%s{line=\"%d\",port=\"%s\",direction=\"%s\"} %llu\n",
+                    name, line->line_id, line->label, metrics_direction_names[d],
+                    (unsigned long long)atomic_load_explicit(value, memory_order_relaxed));
+        }
+    }
+}
+
+/**
+ * Write one histogram series (one "le" per power of two keeps the series
+ * count manageable)
+ */
+static void metrics_write_hist(FILE *out, const char *name, const char *labels,
+                               const metrics_hist_t *hist)
+{
+    uint64_t cumulative = 0;
+
+    for (int b = 0; b < METRICS_HIST_BUCKETS; b++) {
+        cumulative += atomic_load_explicit(&hist->buckets[b], memory_order_relaxed);
+        if ((b + 1) % METRICS_HIST_SUB == 0 && b + 1 < METRICS_HIST_BUCKETS) {
+            fprintf(out, "%s_bucket{%s,le=\"%.9g\"} %llu\n", name, labels,
+                    (double)metrics_hist_lower(b + 1) / 1e6, (unsigned long long)cumulative);
+        }
+    }
+    fprintf(out, "%s_bucket{%s,le=\"+Inf\"} %llu\n", name, labels, (unsigned long long)cumulative);
+    fprintf(out, "%s_sum{%s} %g\n", name, labels,
+            (double)atomic_load_explicit(&hist->sum_us, memory_order_relaxed) / 1e6);
+    fprintf(out, "%s_count{%s} %llu\n", name, labels,
+            (unsigned long long)atomic_load_explicit(&hist->count, memory_order_relaxed));
+}
+
+/**
+ * Write every attached line in Prometheus text exposition format
+ */
+void metrics_write_prometheus(FILE *out)
+{
+    if (metrics_map == NULL || out == NULL) {
+        return;
+    }
+
+    metrics_write_family(out, "modembridge_bytes_total", "counter", "Bytes forwarded through the line buffer");
+    metrics_write_direction_values(out, "modembridge_bytes_total", offsetof(metrics_direction_t, bytes));
+    metrics_write_family(out, "modembridge_reads_total", "counter", "Reads from the line buffer");
+    metrics_write_direction_values(out, "modembridge_reads_total", offsetof(metrics_direction_t, chunks));
+    metrics_write_family(out, "modembridge_dropped_bytes_total", "counter", "Bytes dropped because the line buffer was full");
+    metrics_write_direction_values(out, "modembridge_dropped_bytes_total", offsetof(metrics_direction_t, drops));
+    metrics_write_family(out, "modembridge_backlog_bytes", "gauge", "Bytes waiting in the line buffer");
+    metrics_write_direction_values(out, "modembridge_backlog_bytes", offsetof(metrics_direction_t, backlog_bytes));
+    metrics_write_family(out, "modembridge_backlog_peak_bytes", "gauge", "Largest line buffer backlog seen");
+    metrics_write_direction_values(out, "modembridge_backlog_peak_bytes", offsetof(metrics_direction_t, backlog_peak));
+
+    metrics_write_family(out, "modembridge_connect_bps", "gauge", "Modem CONNECT rate (0 = offline)");
+    for (uint32_t i = 0; i < metrics_map->line_capacity; i++) {
+        metrics_line_t *line = metrics_slot(i);
+        if (atomic_load_explicit(&line->in_use, memory_order_acquire)) {
+            fprintf(out, "modembridge_connect_bps{line=\"%d\",port=\"%s\"} %llu\n",
+                    line->line_id, line->label,
+                    (unsigned long long)atomic_load_explicit(&line->connect_bps, memory_order_relaxed));
+        }
+    }
+
+    metrics_write_family(out, "modembridge_queue_latency_seconds", "histogram",
+                         "Time from a burst entering the line buffer until the buffer drained");
+    for (uint32_t i = 0; i < metrics_map->line_capacity; i++) {
+        metrics_line_t *line = metrics_slot(i);
+        if (!atomic_load_explicit(&line->in_use, memory_order_acquire)) {
+            continue;
+        }
+        for (int d = 0; d < METRICS_DIRECTION_COUNT; d++) {
+            char labels[160];
+            snprintf(labels, sizeof(labels), "line=\"%d\",port=\"%s\",direction=\"%s\"",
+                     line->line_id, line->label, metrics_direction_names[d]);
+            metrics_write_hist(out, "modembridge_queue_latency_seconds", labels, &line->dir[d].latency);
+        }
+    }
+
+    metrics_write_family(out, "modembridge_stage_latency_seconds", "histogram",
+                         "Time a chunk spent in each stage, from its read to its write on the other side");
+    for (uint32_t i = 0; i < metrics_map->line_capacity; i++) {
+        metrics_line_t *line = metrics_slot(i);
+        if (!atomic_load_explicit(&line->in_use, memory_order_acquire)) {
+            continue;
+        }
+        for (int d = 0; d < METRICS_DIRECTION_COUNT; d++) {
+            for (int st = 0; st < METRICS_STAGE_COUNT; st++) {
+                metrics_hist_t *hist = &line->dir[d].stage[st];
+                if (atomic_load_explicit(&hist->count, memory_order_relaxed) == 0) {
+                    continue;
+                }
+                char labels[192];
+                snprintf(labels, sizeof(labels), "line=\"%d\",port=\"%s\",direction=\"%s\",stage=\"%s\"",
+                         line->line_id, line->label, metrics_direction_names[d], metrics_stage_names[st]);
+                metrics_write_hist(out, "modembridge_stage_latency_seconds", labels, hist);
+            }
+        }
+    }
+}
+
+/**
+ * Answer one scrape: any request gets the full text exposition
+ */
+static void metrics_serve_client(int fd)
+{
+    char request[METRICS_REQUEST_MAX];
+    struct pollfd pfd = { .fd = fd, .events = POLLIN, .revents = 0 };
+    char *body = NULL;
+    size_t body_len = 0;
+
+    /* Scrapers send the request first; do not wait long for slow clients */
+    if (poll(&pfd, 1, 1000) > 0) {
+        ssize_t n = recv(fd, request, sizeof(request), 0);
+        (void)n;
+    }
+
+    FILE *out = open_memstream(&body, &body_len);
+    if (out == NULL) {
+        return;
+    }
+    metrics_write_prometheus(out);
+    fclose(out);
+
+    char header[128];
+    int header_len = snprintf(header, sizeof(header),
+                              "HTTP/1.0 200 OK\r\n"
+                              "Content-Type: text/plain; version=0.0.4\r\n"
+                              "Content-Length: %zu\r\n\r\n", body_len);
+
+    if (send(fd, header, (size_t)header_len, MSG_NOSIGNAL) == header_len) {
+        size_t sent = 0;
+        while (sent < body_len) {
+            ssize_t n = send(fd, body + sent, body_len - sent, MSG_NOSIGNAL);
+            if (n <= 0) {
+                break;
+            }
+            sent += (size_t)n;
+        }
+    }
+    free(body);
+}
+
+/**
+ * Prometheus endpoint thread
+ */
+static void *metrics_thread_func(void *arg)
+{
+    struct pollfd pfds[2] = {
+        { .fd = metrics_listen_fd, .events = POLLIN, .revents = 0 },
+        { .fd = metrics_wake_fd, .events = POLLIN, .revents = 0 },
+    };
+
+    (void)arg;
+
+    for (;;) {
+        if (poll(pfds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            MB_LOG_ERROR("Metrics endpoint poll failed: %s", strerror(errno));
+            break;
+        }
+        if (pfds[1].revents & POLLIN) {
+            break;
+        }
+        if (pfds[0].revents & POLLIN) {
+            int client = accept4(metrics_listen_fd, NULL, NULL, SOCK_CLOEXEC);
+            if (client >= 0) {
+                metrics_serve_client(client);
+                close(client);
+            }
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Open the Prometheus listening socket and start its thread
+ */
+static int metrics_start_endpoint(const char *address, int port)
+{
+    struct sockaddr_in addr;
+    int one = 1;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    if (inet_pton(AF_INET, address, &addr.sin_addr) != 1) {
+        MB_LOG_ERROR("Invalid METRICS_ADDRESS: %s", address);
+        return ERROR_CONFIG;
+    }
+
+    metrics_listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (metrics_listen_fd < 0) {
+        MB_LOG_ERROR("Metrics socket failed: %s", strerror(errno));
+        return ERROR_SYSTEM;
+    }
+    setsockopt(metrics_listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    if (bind(metrics_listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(metrics_listen_fd, METRICS_LISTEN_BACKLOG) < 0) {
+        MB_LOG_ERROR("Metrics endpoint %s:%d unavailable: %s", address, port, strerror(errno));
+        close(metrics_listen_fd);
+        metrics_listen_fd = -1;
+        return ERROR_SYSTEM;
+    }
+
+    metrics_wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (metrics_wake_fd < 0 ||
+        pthread_create(&metrics_thread, NULL, metrics_thread_func, NULL) != 0) {
+        MB_LOG_ERROR("Failed to start metrics endpoint thread");
+        if (metrics_wake_fd >= 0) {
+            close(metrics_wake_fd);
+            metrics_wake_fd = -1;
+        }
+        close(metrics_listen_fd);
+        metrics_listen_fd = -1;
+        return ERROR_THREAD;
+    }
+    metrics_thread_started = true;
+
+    MB_LOG_INFO("Metrics endpoint: http://%s:%d/metrics", address, port);
+    return SUCCESS;
+}
+
+/**
+ * Create the metrics mapping and start the Prometheus endpoint
+ */
+int metrics_init(const char *shm_path, const char *address, int port, int line_capacity)
+{
+    size_t header_size = (sizeof(metrics_header_t) + METRICS_ALIGN - 1) & ~(size_t)(METRICS_ALIGN - 1);
+    void *map;
+
+    if (metrics_map != NULL) {
+        return SUCCESS;
+    }
+    if (line_capacity <= 0) {
+        return ERROR_INVALID_ARG;
+    }
+
+    metrics_map_size = header_size + (size_t)line_capacity * sizeof(metrics_line_t);
+
+    if (shm_path != NULL && shm_path[0] != '\0') {
+        int fd = open(shm_path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            MB_LOG_ERROR("Failed to open METRICS_SHM %s: %s", shm_path, strerror(errno));
+            return ERROR_IO;
+        }
+        /* Truncate first so stale counters from a previous run start at zero */
+        if (ftruncate(fd, 0) < 0 || ftruncate(fd, (off_t)metrics_map_size) < 0) {
+            MB_LOG_ERROR("Failed to size METRICS_SHM %s: %s", shm_path, strerror(errno));
+            close(fd);
+            return ERROR_IO;
+        }
+        map = mmap(NULL, metrics_map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+    } else {
+        map = mmap(NULL, metrics_map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    }
+
+    if (map == MAP_FAILED) {
+        MB_LOG_ERROR("Failed to map metrics: %s", strerror(errno));
+        return ERROR_SYSTEM;
+    }
+
+    /* Fresh mappings are zero-filled: only the header needs values */
+    metrics_map = map;
+    metrics_map->version = METRICS_VERSION;
+    metrics_map->line_capacity = (uint32_t)line_capacity;
+    metrics_map->line_size = sizeof(metrics_line_t);
+    metrics_map->header_size = (uint32_t)header_size;
+    metrics_map->start_time = (uint64_t)time(NULL);
+    atomic_store(&metrics_map->generation, 0);
+    /* Magic last: a scraper that sees it can trust the header */
+    atomic_thread_fence(memory_order_release);
+    memcpy(metrics_map->magic, METRICS_MAGIC, METRICS_MAGIC_LEN);
+
+    if (port > 0 &&
+        metrics_start_endpoint(address != NULL ? address : DEFAULT_METRICS_ADDRESS, port) != SUCCESS) {
+        MB_LOG_WARNING("Continuing without the metrics endpoint");
+    }
+
+    MB_LOG_INFO("Metrics: %d line slots%s%s", line_capacity,
+               (shm_path != NULL && shm_path[0] != '\0') ? " in " : "",
+               (shm_path != NULL && shm_path[0] != '\0') ? shm_path : "");
+    return SUCCESS;
+}
+
+/**
+ * Stop the endpoint and unmap the counters
+ */
+void metrics_shutdown(void)
+{
+    if (metrics_thread_started) {
+        uint64_t one = 1;
+        if (write(metrics_wake_fd, &one, sizeof(one)) < 0) {
+            MB_LOG_DEBUG("Metrics wakeup failed: %s", strerror(errno));
+        }
+        pthread_join(metrics_thread, NULL);
+        metrics_thread_started = false;
+    }
+    if (metrics_wake_fd >= 0) {
+        close(metrics_wake_fd);
+        metrics_wake_fd = -1;
+    }
+    if (metrics_listen_fd >= 0) {
+        close(metrics_listen_fd);
+        metrics_listen_fd = -1;
+    }
+
+    if (metrics_map != NULL) {
+        munmap(metrics_map, metrics_map_size);
+        metrics_map = NULL;
+        metrics_map_size = 0;
+    }
+}
@@ -3,6 +3,7 @@
  */
 
 #include "modem.h"
+#include "trace.h"
 #include <ctype.h>
 #include <time.h>
 #include <stdarg.h>
@@ -10,6 +11,16 @@
 /* Escape sequence timing (milliseconds) */
 #define ESCAPE_GUARD_TIME 1000
 
+/**
+ * Monotonic clock in milliseconds
+ */
+static long long modem_monotonic_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
 /**
  * Initialize modem structure
  */
@@ -76,8 +87,7 @@ void modem_reset(modem_t *modem)
     modem->cmd_len = 0;
 
     /* Reset escape sequence detection */
-    modem->escape_count = 0;
-    modem->last_escape_time = 0;
+    hayes_escape_reset(&modem->escape, 0);
 
     /* Reset hardware message buffer */
     memset(modem->hw_msg_buffer, 0, sizeof(modem->hw_msg_buffer));
@@ -237,8 +247,7 @@ int modem_go_online(modem_t *modem)
     modem->state = MODEM_STATE_ONLINE;
     modem->online = true;
     modem->carrier = true;
-    modem->escape_count = 0;
-    modem->last_escape_time = 0;
+    hayes_escape_reset(&modem->escape, modem_monotonic_ms());
 
     /* Set DTR and RTS */
     serial_set_dtr(modem->serial, true);
@@ -247,6 +256,22 @@ int modem_go_online(modem_t *modem)
     return SUCCESS;
 }
 
+/**
+ * Take the dial string of an ATD command
+ */
+bool modem_take_dial(modem_t *modem, char *number, size_t size)
+{
+    if (modem == NULL || !modem->dial_pending) {
+        return false;
+    }
+
+    modem->dial_pending = false;
+    if (number != NULL && size > 0) {
+        SAFE_STRNCPY(number, modem->dial_number, size);
+    }
+    return true;
+}
+
 /**
  * Go offline (command mode)
  */
@@ -260,8 +285,7 @@ int modem_go_offline(modem_t *modem)
 
     modem->state = MODEM_STATE_COMMAND;
     modem->online = false;
-    modem->escape_count = 0;
-    modem->last_escape_time = 0;
+    hayes_escape_reset(&modem->escape, 0);
 
     /* Clear command buffer */
     modem->cmd_len = 0;
@@ -452,299 +476,202 @@ int modem_process_command(modem_t *modem, const char *command)
 
         if (*p == '\0') break;
 
-        /* ATA - Answer */
-        if (*p == 'A' && *(p + 1) != 'T') {
-            MB_LOG_INFO("AT command: ATA (Answer)");
-            ret = modem_answer(modem);
-            /* ATA command sends OK first, then connection will be handled by bridge */
-            p++;
+        size_t name_len = 0;
+        const hayes_command_entry_t *cmd = hayes_match_command(p, strlen(p), &name_len);
+        /* A repeated "AT" inside the line is not ATA */
+        if (cmd != NULL && cmd->id == HAYES_AT_A && p[1] == 'T') {
+            cmd = NULL;
         }
-        /* ATB - Bell/CCITT mode */
-        else if (*p == 'B') {
-            p++;
-            int val = 0;
-            if (isdigit(*p)) {
-                val = *p - '0';
+
+        if (cmd == NULL) {
+            if (*p == '&' || *p == '\\') {
+                /* Skip unsupported & or \ command */
                 p++;
-            }
-            if (val >= 0 && val <= 1) {
-                modem->settings.bell_mode = val;
-                MB_LOG_INFO("AT command: ATB%d (Bell mode %s)",
-                           val, val ? "Bell 212A" : "CCITT");
+                if (*p) p++;
+                if (isdigit(*p)) p++;
             } else {
-                return modem_send_response(modem, MODEM_RESP_ERROR);
-            }
-        }
-        /* ATD - Dial (not implemented, just return OK) */
-        else if (*p == 'D') {
-            MB_LOG_INFO("AT command: ATD (Dial) - not implemented");
-            p++;
-            /* Skip dial string */
-            while (*p && *p != ' ' && *p != ';') p++;
-            return modem_send_response(modem, MODEM_RESP_OK);
-        }
-        /* ATE - Echo */
-        else if (*p == 'E') {
-            p++;
-            int val = 1;
-            if (isdigit(*p)) {
-                val = *p - '0';
-                p++;
-            }
-            modem->settings.echo = (val != 0);
-            MB_LOG_INFO("AT command: ATE%d (Echo %s)", val, modem->settings.echo ? "ON" : "OFF");
-        }
-        /* ATH - Hang up */
-        else if (*p == 'H') {
-            MB_LOG_INFO("AT command: ATH (Hang up)");
-            p++;
-            /* Skip optional parameter */
-            if (isdigit(*p)) p++;
-            ret = modem_hangup(modem);
-            if (ret == SUCCESS) {
-                return modem_send_response(modem, MODEM_RESP_OK);
-            }
-        }
-        /* ATI - Information */
-        else if (*p == 'I') {
-            p++;
-            int val = 0;
-            if (isdigit(*p)) {
-                val = *p - '0';
+                /* Unknown command - skip */
+                MB_LOG_WARNING("Unknown AT command character: %c", *p);
                 p++;
             }
-            MB_LOG_INFO("AT command: ATI%d (Information)", val);
-            /* Return product information */
-            modem_send_response_fmt(modem, "ModemBridge v%s", MODEMBRIDGE_VERSION);
-            return modem_send_response(modem, MODEM_RESP_OK);
-        }
-        /* ATL - Speaker volume */
-        else if (*p == 'L') {
-            p++;
-            int val = 2;
-            if (isdigit(*p)) {
-                val = *p - '0';
-                p++;
-            }
-            if (val >= 0 && val <= 3) {
-                modem->settings.speaker_volume = val;
-                MB_LOG_INFO("AT command: ATL%d (Speaker volume)", val);
-            } else {
-                return modem_send_response(modem, MODEM_RESP_ERROR);
-            }
+            continue;
         }
-        /* ATM - Speaker control */
-        else if (*p == 'M') {
-            p++;
-            int val = 1;
-            if (isdigit(*p)) {
-                val = *p - '0';
-                p++;
-            }
-            if (val >= 0 && val <= 3) {
-                modem->settings.speaker_control = val;
-                MB_LOG_INFO("AT command: ATM%d (Speaker control)", val);
-            } else {
+
+        p += name_len;
+        int val = 0;
+        if (cmd->id != HAYES_AT_D && cmd->id != HAYES_AT_S) {
+            val = hayes_parse_parameter(cmd, &p);
+            if (val < 0) {
+                MB_LOG_INFO("AT command: %s parameter out of range (%d-%d)",
+                           cmd->command, cmd->min_param, cmd->max_param);
                 return modem_send_response(modem, MODEM_RESP_ERROR);
             }
         }
-        /* ATO - Return to online mode */
-        else if (*p == 'O') {
-            MB_LOG_INFO("AT command: ATO (Online)");
-            p++;
-            /* Skip optional parameter */
-            if (isdigit(*p)) p++;
-            if (modem->carrier) {
-                ret = modem_go_online(modem);
-                if (ret == SUCCESS) {
-                    return modem_send_connect(modem, 0);
-                }
-            } else {
-                return modem_send_response(modem, MODEM_RESP_NO_CARRIER);
-            }
-        }
-        /* ATQ - Quiet mode */
-        else if (*p == 'Q') {
-            p++;
-            int val = 0;
-            if (isdigit(*p)) {
-                val = *p - '0';
-                p++;
-            }
-            modem->settings.quiet = (val != 0);
-            MB_LOG_INFO("AT command: ATQ%d (Quiet %s)", val, modem->settings.quiet ? "ON" : "OFF");
-        }
-        /* ATS - S-register */
-        else if (*p == 'S') {
-            p++;
-            int reg = 0;
-            /* Parse register number */
-            while (isdigit(*p)) {
-                reg = reg * 10 + (*p - '0');
-                p++;
-            }
-            /* Check for = (set) or ? (query) */
-            if (*p == '=') {
-                p++;
-                int val = 0;
-                while (isdigit(*p)) {
-                    val = val * 10 + (*p - '0');
+
+        switch (cmd->id) {
+            case HAYES_AT_A:
+                MB_LOG_INFO("AT command: ATA (Answer)");
+                ret = modem_answer(modem);
+                /* ATA command sends OK first, then connection will be handled by bridge */
+                break;
+
+            case HAYES_AT_B:
+                modem->settings.bell_mode = val;
+                MB_LOG_INFO("AT command: ATB%d (Bell mode %s)",
+                           val, val ? "Bell 212A" : "CCITT");
+                break;
+
+            case HAYES_AT_D: {
+                /* Dial: the rest of the line is the dial string */
+                size_t len = strcspn(p, ";");
+                while (len > 0 && (*p == ' ' || *p == '\t')) {
                     p++;
+                    len--;
                 }
-                MB_LOG_INFO("AT command: ATS%d=%d", reg, val);
-                modem_set_sreg(modem, reg, val);
-            } else if (*p == '?') {
-                p++;
-                int val = modem_get_sreg(modem, reg);
-                MB_LOG_INFO("AT command: ATS%d? = %d", reg, val);
-                modem_send_response_fmt(modem, "%d", val);
-                return modem_send_response(modem, MODEM_RESP_OK);
-            }
-        }
-        /* ATV - Verbose mode */
-        else if (*p == 'V') {
-            p++;
-            int val = 1;
-            if (isdigit(*p)) {
-                val = *p - '0';
-                p++;
-            }
-            modem->settings.verbose = (val != 0);
-            MB_LOG_INFO("AT command: ATV%d (Verbose %s)", val, modem->settings.verbose ? "ON" : "OFF");
-        }
-        /* ATX - Extended result codes */
-        else if (*p == 'X') {
-            p++;
-            int val = 4;
-            if (isdigit(*p)) {
-                val = *p - '0';
-                p++;
-            }
-            if (val >= 0 && val <= 4) {
-                modem->settings.result_mode = val;
-                MB_LOG_INFO("AT command: ATX%d (Result code mode)", val);
-            } else {
-                return modem_send_response(modem, MODEM_RESP_ERROR);
-            }
-        }
-        /* ATZ - Reset */
-        else if (*p == 'Z') {
-            MB_LOG_INFO("AT command: ATZ (Reset)");
-            p++;
-            /* Skip optional profile number */
-            if (isdigit(*p)) p++;
-            modem_reset(modem);
-            return modem_send_response(modem, MODEM_RESP_OK);
-        }
-        /* AT& commands */
-        else if (*p == '&') {
-            p++;
-            /* AT&C - DCD control */
-            if (*p == 'C') {
-                p++;
-                int val = 1;  /* Default &C1 */
-                if (isdigit(*p)) {
-                    val = *p - '0';
+                /* Tone/pulse prefix, unless it starts a directory name */
+                if (len > 0 && (*p == 'T' || *p == 'P') && !isalpha((unsigned char)p[1])) {
                     p++;
+                    len--;
                 }
-                if (val >= 0 && val <= 1) {
-                    modem->settings.dcd_mode = val;
-                    MB_LOG_INFO("AT command: AT&C%d (DCD mode)", val);
-                } else {
-                    return modem_send_response(modem, MODEM_RESP_ERROR);
-                }
-            }
-            /* AT&D - DTR control */
-            else if (*p == 'D') {
-                p++;
-                int val = 2;  /* Default &D2 */
-                if (isdigit(*p)) {
-                    val = *p - '0';
+                while (len > 0 && (*p == ' ' || *p == '\t')) {
                     p++;
+                    len--;
                 }
-                if (val >= 0 && val <= 3) {
-                    modem->settings.dtr_mode = val;
-                    MB_LOG_INFO("AT command: AT&D%d (DTR mode)", val);
-                } else {
-                    return modem_send_response(modem, MODEM_RESP_ERROR);
+                while (len > 0 && (p[len - 1] == ' ' || p[len - 1] == '\t')) {
+                    len--;
                 }
+                len = MIN(len, sizeof(modem->dial_number) - 1);
+                memcpy(modem->dial_number, p, len);
+                modem->dial_number[len] = '\0';
+                modem->dial_pending = true;
+                MB_LOG_INFO("AT command: ATD%s (Dial)", modem->dial_number);
+                /* CONNECT or NO CARRIER follows from the bridge */
+                return SUCCESS;
             }
-            /* AT&F - Factory defaults */
-            else if (*p == 'F') {
-                MB_LOG_INFO("AT command: AT&F (Factory defaults)");
-                p++;
-                modem_reset(modem);
-            }
-            /* AT&V - View configuration */
-            else if (*p == 'V') {
-                p++;
-                MB_LOG_INFO("AT command: AT&V (View configuration)");
-                return modem_show_configuration(modem);
-            }
-            /* AT&W - Write configuration */
-            else if (*p == 'W') {
-                p++;
-                int profile = 0;
-                if (isdigit(*p)) {
-                    profile = *p - '0';
-                    p++;
+
+            case HAYES_AT_E:
+                modem->settings.echo = (val != 0);
+                MB_LOG_INFO("AT command: ATE%d (Echo %s)", val, modem->settings.echo ? "ON" : "OFF");
+                break;
+
+            case HAYES_AT_H:
+                MB_LOG_INFO("AT command: ATH (Hang up)");
+                ret = modem_hangup(modem);
+                if (ret == SUCCESS) {
+                    return modem_send_response(modem, MODEM_RESP_OK);
                 }
-                if (profile >= 0 && profile <= 1) {
-                    modem->settings.profile_saved[profile] = true;
-                    MB_LOG_INFO("AT command: AT&W%d (Save profile)", profile);
+                break;
+
+            case HAYES_AT_I:
+                MB_LOG_INFO("AT command: ATI%d (Information)", val);
+                /* Return product information */
+                modem_send_response_fmt(modem, "ModemBridge v%s", MODEMBRIDGE_VERSION);
+                return modem_send_response(modem, MODEM_RESP_OK);
+
+            case HAYES_AT_L:
+                modem->settings.speaker_volume = val;
+                MB_LOG_INFO("AT command: ATL%d (Speaker volume)", val);
+                break;
+
+            case HAYES_AT_M:
+                modem->settings.speaker_control = val;
+                MB_LOG_INFO("AT command: ATM%d (Speaker control)", val);
+                break;
+
+            case HAYES_AT_O:
+                MB_LOG_INFO("AT command: ATO (Online)");
+                if (modem->carrier) {
+                    ret = modem_go_online(modem);
+                    if (ret == SUCCESS) {
+                        return modem_send_connect(modem, 0);
+                    }
                 } else {
-                    return modem_send_response(modem, MODEM_RESP_ERROR);
+                    return modem_send_response(modem, MODEM_RESP_NO_CARRIER);
                 }
-            }
-            /* AT&S - DSR override */
-            else if (*p == 'S') {
-                p++;
-                int val = 0;
-                if (isdigit(*p)) {
-                    val = *p - '0';
+                break;
+
+            case HAYES_AT_Q:
+                modem->settings.quiet = (val != 0);
+                MB_LOG_INFO("AT command: ATQ%d (Quiet %s)", val, modem->settings.quiet ? "ON" : "OFF");
+                break;
+
+            case HAYES_AT_S: {
+                int reg = 0;
+                /* Parse register number */
+                while (isdigit(*p)) {
+                    reg = reg * 10 + (*p - '0');
                     p++;
                 }
-                if (val >= 0 && val <= 1) {
-                    modem->settings.dsr_mode = val;
-                    MB_LOG_INFO("AT command: AT&S%d (DSR mode)", val);
-                } else {
-                    return modem_send_response(modem, MODEM_RESP_ERROR);
-                }
-            }
-            else {
-                /* Skip unsupported & command */
-                p++;
-                if (isdigit(*p)) p++;
-            }
-        }
-        /* AT\ commands */
-        else if (*p == '\\') {
-            p++;
-            /* AT\N - Error correction */
-            if (*p == 'N') {
-                p++;
-                int val = 3;
-                if (isdigit(*p)) {
-                    val = *p - '0';
+                /* Check for = (set) or ? (query) */
+                if (*p == '=') {
                     p++;
+                    while (isdigit(*p)) {
+                        val = val * 10 + (*p - '0');
+                        p++;
+                    }
+                    MB_LOG_INFO("AT command: ATS%d=%d", reg, val);
+                    modem_set_sreg(modem, reg, val);
+                } else if (*p == '?') {
+                    p++;
+                    val = modem_get_sreg(modem, reg);
+                    MB_LOG_INFO("AT command: ATS%d? = %d", reg, val);
+                    modem_send_response_fmt(modem, "%d", val);
+                    return modem_send_response(modem, MODEM_RESP_OK);
                 }
-                if (val >= 0 && val <= 3) {
-                    modem->settings.error_correction = val;
-                    MB_LOG_INFO("AT command: AT\\N%d (Error correction)", val);
-                } else {
-                    return modem_send_response(modem, MODEM_RESP_ERROR);
-                }
-            }
-            else {
-                /* Unknown \ command */
-                p++;
-                if (isdigit(*p)) p++;
+                break;
             }
-        }
-        /* Unknown command - skip */
-        else {
-            MB_LOG_WARNING("Unknown AT command character: %c", *p);
-            p++;
+
+            case HAYES_AT_V:
+                modem->settings.verbose = (val != 0);
+                MB_LOG_INFO("AT command: ATV%d (Verbose %s)", val, modem->settings.verbose ? "ON" : "OFF");
+                break;
+
+            case HAYES_AT_X:
+                modem->settings.result_mode = val;
+                MB_LOG_INFO("AT command: ATX%d (Result code mode)", val);
+                break;
+
+            case HAYES_AT_Z:
+                MB_LOG_INFO("AT command: ATZ (Reset)");
+                modem_reset(modem);
+                return modem_send_response(modem, MODEM_RESP_OK);
+
+            case HAYES_AT_AMP_C:
+                modem->settings.dcd_mode = val;
+                MB_LOG_INFO("AT command: AT&C%d (DCD mode)", val);
+                break;
+
+            case HAYES_AT_AMP_D:
+                modem->settings.dtr_mode = val;
+                MB_LOG_INFO("AT command: AT&D%d (DTR mode)", val);
+                break;
+
+            case HAYES_AT_AMP_F:
+                MB_LOG_INFO("AT command: AT&F (Factory defaults)");
+                modem_reset(modem);
+                break;
+
+            case HAYES_AT_AMP_V:
+                MB_LOG_INFO("AT command: AT&V (View configuration)");
+                return modem_show_configuration(modem);
+
+            case HAYES_AT_AMP_W:
+                modem->settings.profile_saved[val] = true;
+                MB_LOG_INFO("AT command: AT&W%d (Save profile)", val);
+                break;
+
+            case HAYES_AT_AMP_S:
+                modem->settings.dsr_mode = val;
+                MB_LOG_INFO("AT command: AT&S%d (DSR mode)", val);
+                break;
+
+            case HAYES_AT_BSL_N:
+                modem->settings.error_correction = val;
+                MB_LOG_INFO("AT command: AT\\N%d (Error correction)", val);
+                break;
+
+            default:
+                break;
         }
     }
 
@@ -823,15 +750,6 @@ bool modem_process_hardware_message(modem_t *modem, const char *data, size_t len
         return false;
     }
 
-    /* Debug output with hex dump for better visibility */
-    printf("[DEBUG] Hardware modem data (%zu bytes): ", len);
-    for (size_t i = 0; i < len && i < 32; i++) {
-        printf("%02X ", (unsigned char)data[i]);
-    }
-    printf("\n");
-    printf("[DEBUG] Hardware modem ASCII: [%.*s]\n", (int)len, data);
-    fflush(stdout);
-
     MB_LOG_DEBUG("Hardware modem data (%zu bytes): [%.*s]", len, (int)len, data);
 
     /* === ONLINE STATE: Maintain small buffer for disconnection detection === */
@@ -906,9 +824,8 @@ bool modem_process_hardware_message(modem_t *modem, const char *data, size_t len
         modem->hw_msg_last_time = now;
     }
 
-    printf("[DEBUG] Hardware message buffer (%zu bytes): [%s]\n",
-           modem->hw_msg_len, modem->hw_msg_buffer);
-    fflush(stdout);
+    MB_TRACE_DATA(TRACE_MODEM_HW_MESSAGE, len, modem->hw_msg_len,
+                  modem->hw_msg_buffer, modem->hw_msg_len);
 
     /* Process complete messages from the buffer */
     char *buffer = modem->hw_msg_buffer;
@@ -1002,8 +919,10 @@ bool modem_process_hardware_message(modem_t *modem, const char *data, size_t len
                 /* Extract baudrate if present (e.g., "CONNECT 1200" or "CONNECT 1200/ARQ") */
                 int baudrate = 0;
                 char *space = strchr(connect_pos, ' ');
+                modem->connect_speed = 0;
                 if (space) {
                     baudrate = atoi(space + 1);
+                    modem->connect_speed = MAX(baudrate, 0);
                     printf("[INFO] Connection speed: %d baud\n", baudrate);
                     fflush(stdout);
                     MB_LOG_INFO("Connection speed: %d baud", baudrate);
@@ -1324,13 +1243,20 @@ int modem_parse_connect_speed(const char *connect_str)
  */
 int modem_send_at_command(modem_t *modem, const char *command,
                           char *response, size_t resp_size, int timeout_sec)
+{
+    return modem_send_at_command_ms(modem, command, response, resp_size, timeout_sec * 1000);
+}
+
+/**
+ * Send AT command and wait for its final result code
+ */
+int modem_send_at_command_ms(modem_t *modem, const char *command,
+                             char *response, size_t resp_size, int timeout_ms)
 {
     char cmd_buf[LINE_BUFFER_SIZE];
     char line_buf[LINE_BUFFER_SIZE];
     int len;
     ssize_t rc;
-    time_t start_time, current_time;
-    int remaining_timeout;
 
     if (modem == NULL || command == NULL) {
         return ERROR_INVALID_ARG;
@@ -1348,6 +1274,7 @@ int modem_send_at_command(modem_t *modem, const char *command,
 
     /* Flush input buffer before sending command */
     serial_flush(modem->serial, TCIFLUSH);
+    serial_line_flush(modem->serial, NULL, 0);
 
     /* Prepare command with CR terminator */
     snprintf(cmd_buf, sizeof(cmd_buf), "%s\r", command);
@@ -1362,22 +1289,18 @@ int modem_send_at_command(modem_t *modem, const char *command,
         return ERROR_IO;
     }
 
-    /* Small delay after sending */
-    usleep(100000); /* 100ms */
-
-    /* Read response lines until OK or ERROR or timeout */
-    start_time = time(NULL);
+    /* Read response lines until a final result code or timeout */
+    long long deadline = modem_monotonic_ms() + timeout_ms;
 
     while (1) {
-        current_time = time(NULL);
-        remaining_timeout = timeout_sec - (current_time - start_time);
+        int remaining = (int)(deadline - modem_monotonic_ms());
 
-        if (remaining_timeout <= 0) {
+        if (remaining <= 0) {
             MB_LOG_ERROR("Timeout waiting for modem response");
             return ERROR_TIMEOUT;
         }
 
-        rc = serial_read_line(modem->serial, line_buf, sizeof(line_buf), remaining_timeout);
+        rc = serial_read_line_ms(modem->serial, line_buf, sizeof(line_buf), remaining);
 
         if (rc == ERROR_TIMEOUT) {
             MB_LOG_ERROR("Timeout reading modem response");
@@ -1402,40 +1325,35 @@ int modem_send_at_command(modem_t *modem, const char *command,
                 }
             }
 
-            /* Check for CONNECT (successful connection) */
-            if (strstr(line_buf, "CONNECT") != NULL) {
-                MB_LOG_INFO("Modem connected: %s", line_buf);
-                return SUCCESS;
+            /* Echoed commands and information text are not result codes */
+            const hayes_result_entry_t *result = hayes_match_result(line_buf, (size_t)rc, NULL);
+            if (result == NULL) {
+                continue;
             }
 
-            /* Check for connection errors */
-            if (strstr(line_buf, "NO CARRIER") != NULL) {
-                MB_LOG_ERROR("Connection failed: NO CARRIER");
-                return ERROR_MODEM;
-            }
-            if (strstr(line_buf, "BUSY") != NULL) {
-                MB_LOG_ERROR("Connection failed: BUSY");
-                return ERROR_MODEM;
-            }
-            if (strstr(line_buf, "NO DIALTONE") != NULL) {
-                MB_LOG_ERROR("Connection failed: NO DIALTONE");
-                return ERROR_MODEM;
-            }
-            if (strstr(line_buf, "NO ANSWER") != NULL) {
-                MB_LOG_ERROR("Connection failed: NO ANSWER");
-                return ERROR_MODEM;
-            }
+            switch (result->id) {
+                case HAYES_RESULT_OK:
+                    MB_LOG_DEBUG("Modem responded: OK");
+                    return SUCCESS;
 
-            /* Check for OK */
-            if (strstr(line_buf, "OK") != NULL) {
-                MB_LOG_DEBUG("Modem responded: OK");
-                return SUCCESS;
-            }
+                case HAYES_RESULT_CONNECT:
+                    MB_LOG_INFO("Modem connected: %s", line_buf);
+                    return SUCCESS;
 
-            /* Check for ERROR */
-            if (strstr(line_buf, "ERROR") != NULL) {
-                MB_LOG_ERROR("Modem returned ERROR");
-                return ERROR_MODEM;
+                case HAYES_RESULT_ERROR:
+                    MB_LOG_ERROR("Modem returned ERROR");
+                    return ERROR_MODEM;
+
+                case HAYES_RESULT_NO_CARRIER:
+                case HAYES_RESULT_BUSY:
+                case HAYES_RESULT_NO_DIALTONE:
+                case HAYES_RESULT_NO_ANSWER:
+                    MB_LOG_ERROR("Connection failed: %s", result->code);
+                    return ERROR_MODEM;
+
+                default:
+                    /* RING and the like are unsolicited, keep waiting */
+                    break;
             }
         }
     }
@@ -1443,13 +1361,77 @@ int modem_send_at_command(modem_t *modem, const char *command,
     return SUCCESS;
 }
 
+/**
+ * Run a parsed init script, one command at a time
+ */
+int modem_run_script(modem_t *modem, const modem_script_t *script, int timeout_ms)
+{
+    int ret = SUCCESS;
+
+    if (modem == NULL || script == NULL) {
+        return ERROR_INVALID_ARG;
+    }
+
+    for (int i = 0; i < script->count; i++) {
+        const char *command = &script->text[script->offset[i]];
+
+        int rc = modem_send_at_command_ms(modem, command, NULL, 0, timeout_ms);
+        if (rc == ERROR_IO) {
+            return rc;
+        }
+        if (rc != SUCCESS) {
+            /* A rejected or unanswered command does not stop the others */
+            MB_LOG_WARNING("Init command %s: %s", command,
+                          rc == ERROR_TIMEOUT ? "no response" : "rejected");
+            ret = rc;
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * Measure the AT round trip through the serial port
+ */
+int modem_probe_round_trip(modem_t *modem, int count, int timeout_ms, int *best_us)
+{
+    int ret = ERROR_TIMEOUT;
+
+    if (modem == NULL || best_us == NULL || count <= 0) {
+        return ERROR_INVALID_ARG;
+    }
+
+    *best_us = -1;
+    for (int i = 0; i < count; i++) {
+        struct timespec t0, t1;
+
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        int rc = modem_send_at_command_ms(modem, "AT", NULL, 0, timeout_ms);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        if (rc != SUCCESS) {
+            if (rc == ERROR_IO) {
+                return rc;
+            }
+            continue;
+        }
+
+        int us = (int)((t1.tv_sec - t0.tv_sec) * 1000000 + (t1.tv_nsec - t0.tv_nsec) / 1000);
+        if (*best_us < 0 || us < *best_us) {
+            *best_us = us;
+        }
+        ret = SUCCESS;
+    }
+
+    return ret;
+}
+
 /**
  * Send compound AT command string (semicolon-separated)
  * Based on modem_sample/modem_control.c:send_command_string()
  */
 int modem_send_command_string(modem_t *modem, const char *cmd_string, int timeout_sec)
 {
-    char *commands, *cmd, *saveptr;
+    modem_script_t script;
     char response[BUFFER_SIZE];
     int rc;
 
@@ -1463,37 +1445,19 @@ int modem_send_command_string(modem_t *modem, const char *cmd_string, int timeou
 
     MB_LOG_INFO("Sending compound command: %s", cmd_string);
 
-    /* Make a copy of the command string for parsing */
-    commands = strdup(cmd_string);
-    if (!commands) {
-        return ERROR_GENERAL;
-    }
-
     /* Parse commands separated by semicolon */
-    cmd = strtok_r(commands, ";", &saveptr);
+    config_parse_modem_script(&script, cmd_string);
 
-    while (cmd != NULL) {
-        /* Trim leading spaces */
-        while (*cmd == ' ' || *cmd == '\t') {
-            cmd++;
-        }
+    for (int i = 0; i < script.count; i++) {
+        const char *cmd = &script.text[script.offset[i]];
 
-        if (strlen(cmd) > 0) {
-            rc = modem_send_at_command(modem, cmd, response, sizeof(response), timeout_sec);
-            if (rc != SUCCESS) {
-                MB_LOG_ERROR("Command failed: %s", cmd);
-                free(commands);
-                return rc;
-            }
-
-            /* Small delay between commands */
-            usleep(200000); /* 200ms */
+        rc = modem_send_at_command(modem, cmd, response, sizeof(response), timeout_sec);
+        if (rc != SUCCESS) {
+            MB_LOG_ERROR("Command failed: %s", cmd);
+            return rc;
         }
-
-        cmd = strtok_r(NULL, ";", &saveptr);
     }
 
-    free(commands);
     MB_LOG_INFO("Compound command completed successfully");
     return SUCCESS;
 }
@@ -2020,56 +1984,25 @@ size_t modem_filter_hayes_data(modem_t *modem, const char *data, size_t len, boo
  */
 bool modem_check_escape_sequence(modem_t *modem, const char *data, size_t len, size_t *consumed)
 {
-    char escape_char = modem_get_escape_character(modem);
-    int guard_time_ms = modem_get_escape_guard_time(modem);
-    time_t now = time(NULL);
-    size_t i;
-
     if (modem == NULL || data == NULL || len == 0 || consumed == NULL) {
-        *consumed = 0;
+        if (consumed != NULL) {
+            *consumed = 0;
+        }
         return false;
     }
 
-    *consumed = 0;
+    int escape_char = modem_get_sreg(modem, SREG_ESCAPE_CODE);
+    int guard_time_ms = modem_get_escape_guard_time(modem);
 
-    for (i = 0; i < len; i++) {
-        if (data[i] == escape_char) {
-            /* Check guard time - S12 register value * 50ms */
-            int time_diff_ms = (now - modem->last_escape_time) * 1000;
-            
-            if (modem->escape_count == 0 || time_diff_ms < guard_time_ms) {
-                /* Within guard time - count this character */
-                modem->escape_count++;
-                modem->last_escape_time = now;
-                MB_LOG_DEBUG("Escape sequence: character %d/%d (time diff: %dms)", 
-                           modem->escape_count, 3, time_diff_ms);
-
-                if (modem->escape_count >= 3) {
-                    /* Complete escape sequence detected */
-                    MB_LOG_INFO("Hayes escape sequence detected (char='%c', guard=%dms)", 
-                               escape_char, guard_time_ms);
-                    *consumed = i + 1;
-                    modem->escape_count = 0;  /* Reset for next detection */
-                    return true;
-                }
-            } else {
-                /* Guard time violated - restart counting */
-                MB_LOG_DEBUG("Guard time violated (%dms >= %dms), restarting escape count", 
-                           time_diff_ms, guard_time_ms);
-                modem->escape_count = 1;
-                modem->last_escape_time = now;
-            }
-            *consumed = i + 1;  /* Consume the escape character */
-        } else {
-            /* Non-escape character - reset escape count */
-            if (modem->escape_count > 0) {
-                MB_LOG_DEBUG("Non-escape character '%c' detected, resetting escape count", data[i]);
-                modem->escape_count = 0;
-            }
-        }
+    *consumed = hayes_escape_scan(&modem->escape, (const unsigned char *)data, len,
+                                  escape_char, guard_time_ms, modem_monotonic_ms());
+    if (*consumed == 0) {
+        return false;
     }
 
-    return false;
+    MB_LOG_INFO("Hayes escape sequence detected (char='%c', guard=%dms)",
+               escape_char, guard_time_ms);
+    return true;
 }
 
 /**
@@ -2162,16 +2095,9 @@ int modem_filter_result_code(modem_t *modem, const char *response,
     }
 
     /* V0: Numeric mode - convert responses to numeric codes */
+    const hayes_result_entry_t *result = hayes_find_result(response);
     if (!modem->settings.verbose) {
-        int code = 0;
-        if (strcmp(response, MODEM_RESP_OK) == 0) code = 0;
-        else if (strcmp(response, MODEM_RESP_CONNECT) == 0) code = 1;
-        else if (strcmp(response, MODEM_RESP_RING) == 0) code = 2;
-        else if (strcmp(response, MODEM_RESP_NO_CARRIER) == 0) code = 3;
-        else if (strcmp(response, MODEM_RESP_ERROR) == 0) code = 4;
-        else if (strcmp(response, MODEM_RESP_NO_DIALTONE) == 0) code = 6;
-        else if (strcmp(response, MODEM_RESP_BUSY) == 0) code = 7;
-        else if (strcmp(response, MODEM_RESP_NO_ANSWER) == 0) code = 8;
+        int code = (result != NULL && result->numeric >= 0) ? result->numeric : 0;
 
         snprintf(filtered_response, resp_size, "%d", code);
         return SUCCESS;
@@ -2179,43 +2105,34 @@ int modem_filter_result_code(modem_t *modem, const char *response,
 
     /* X mode filtering - based on ATX setting */
     int x_mode = modem->settings.result_mode;
-    if (x_mode < 4) {
+    if (x_mode < 4 && result != NULL) {
         /* X0-X3: Filter some responses based on mode */
         bool should_filter = false;
-        
+        hayes_result_id_t id = result->id;
+
         switch (x_mode) {
             case 0: /* Basic codes only */
-                if (strcmp(response, MODEM_RESP_NO_DIALTONE) == 0 ||
-                    strcmp(response, MODEM_RESP_BUSY) == 0 ||
-                    strcmp(response, MODEM_RESP_NO_ANSWER) == 0) {
-                    should_filter = true;
-                    strcpy(filtered_response, MODEM_RESP_NO_CARRIER);
-                }
+                should_filter = (id == HAYES_RESULT_NO_DIALTONE ||
+                                 id == HAYES_RESULT_BUSY ||
+                                 id == HAYES_RESULT_NO_ANSWER);
                 break;
-                
+
             case 1: /* X0 + connection speed */
                 /* No filtering needed - default behavior */
                 break;
-                
+
             case 2: /* X1 + NO DIALTONE */
-                if (strcmp(response, MODEM_RESP_BUSY) == 0 ||
-                    strcmp(response, MODEM_RESP_NO_ANSWER) == 0) {
-                    should_filter = true;
-                    strcpy(filtered_response, MODEM_RESP_NO_CARRIER);
-                }
+                should_filter = (id == HAYES_RESULT_BUSY || id == HAYES_RESULT_NO_ANSWER);
                 break;
-                
+
             case 3: /* X1 + BUSY */
-                if (strcmp(response, MODEM_RESP_NO_DIALTONE) == 0 ||
-                    strcmp(response, MODEM_RESP_NO_ANSWER) == 0) {
-                    should_filter = true;
-                    strcpy(filtered_response, MODEM_RESP_NO_CARRIER);
-                }
+                should_filter = (id == HAYES_RESULT_NO_DIALTONE || id == HAYES_RESULT_NO_ANSWER);
                 break;
         }
 
         if (should_filter) {
-            MB_LOG_DEBUG("Filtered response based on X%d mode: %s -> %s", 
+            snprintf(filtered_response, resp_size, "%s", MODEM_RESP_NO_CARRIER);
+            MB_LOG_DEBUG("Filtered response based on X%d mode: %s -> %s",
                         x_mode, response, filtered_response);
         }
     }
@@ -2323,8 +2240,7 @@ int modem_handle_no_carrier_termination(modem_t *modem)
         modem->carrier = false;
         
         /* Clear any pending escape sequences */
-        modem->escape_count = 0;
-        modem->last_escape_time = 0;
+        hayes_escape_reset(&modem->escape, 0);
         
         /* Clear command buffer */
         modem->cmd_len = 0;
@@ -2390,8 +2306,7 @@ int modem_handle_dcd_falling_cleanup(modem_t *modem)
             /* Clear all communication buffers */
             modem->cmd_len = 0;
             memset(modem->cmd_buffer, 0, sizeof(modem->cmd_buffer));
-            modem->escape_count = 0;
-            modem->last_escape_time = 0;
+            hayes_escape_reset(&modem->escape, 0);
             
             /* Clear ring counter */
             modem->settings.s_registers[SREG_RING_COUNT] = 0;
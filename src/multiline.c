@@ -0,0 +1,507 @@
+/*
+ * multiline.c - Multi-line mode implementation
+ *
+ * Each [line.N] section gets its own bridge_ctx_t. Instead of the per-bridge
+ * serial and telnet threads, a fixed pool of worker threads waits on epoll
+ * for all serial/telnet descriptors and runs bridge_serial_poll() and
+ * bridge_telnet_poll() for the line that became ready. Time-driven work
+ * (timestamps, escape guard, connect completion, serial TX refill, telnet
+ * cork windows) runs from per-line timers on the worker's timer wheel. A
+ * periodic sweep re-synchronizes descriptor registrations after reconnects.
+ */
+
+#include "multiline.h"
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/sysinfo.h>
+
+/**
+ * Monotonic clock in milliseconds
+ */
+static long long ml_now_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/* ========== Descriptor Registration ========== */
+
+/**
+ * Bring one registered descriptor in line with the line's current fd
+ * A closed descriptor drops out of epoll silently, so an unchanged number
+ * may refer to a new file: MOD falls back to ADD on ENOENT.
+ */
+static void ml_sync_fd(ml_worker_t *worker, ml_line_t *line, int *registered,
+                       int current, uint32_t events)
+{
+    struct epoll_event ev;
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events = events;
+    ev.data.ptr = line;
+
+    if (*registered >= 0 && *registered != current) {
+        epoll_ctl(worker->epoll_fd, EPOLL_CTL_DEL, *registered, NULL);
+        *registered = -1;
+    }
+
+    if (current < 0) {
+        return;
+    }
+
+    if (*registered == current &&
+        epoll_ctl(worker->epoll_fd, EPOLL_CTL_MOD, current, &ev) == 0) {
+        return;
+    }
+
+    if (epoll_ctl(worker->epoll_fd, EPOLL_CTL_ADD, current, &ev) == 0 || errno == EEXIST) {
+        *registered = current;
+    } else {
+        MB_LOG_WARNING("[line.%d] Failed to register fd %d with worker %d: %s",
+                      line->bridge.line_id, current, worker->index, strerror(errno));
+        *registered = -1;
+    }
+}
+
+/**
+ * Synchronize serial/telnet registrations of a line
+ */
+static void ml_sync_line(ml_worker_t *worker, ml_line_t *line)
+{
+    bridge_ctx_t *bridge = &line->bridge;
+
+#ifdef BRIDGE_HAS_SERIAL_POLL
+    int serial_fd = bridge->serial_ready ? serial_get_fd(&bridge->serial) : -1;
+    ml_sync_fd(worker, line, &line->serial_fd, serial_fd, EPOLLIN);
+#endif
+
+#ifdef ENABLE_LEVEL2
+    int telnet_fd = bridge->telnet.fd;
+    uint32_t events = bridge_telnet_events(bridge);
+    ml_sync_fd(worker, line, &line->telnet_fd, telnet_fd, events);
+#else
+    (void)bridge;
+#endif
+}
+
+/* ========== Line Service ========== */
+
+/**
+ * Run serial/telnet passes for one line until it goes idle (bounded burst)
+ */
+static void ml_service_line(ml_worker_t *worker, ml_line_t *line)
+{
+    bridge_ctx_t *bridge = &line->bridge;
+
+    worker->dispatches++;
+
+    for (int burst = 0; burst < ML_MAX_BURST; burst++) {
+        bool again = false;
+
+#ifdef BRIDGE_HAS_SERIAL_POLL
+        if (bridge_serial_poll(bridge) == 0) {
+            again = true;
+        }
+#endif
+#ifdef ENABLE_LEVEL2
+        if (bridge_telnet_poll(bridge) == 0) {
+            again = true;
+        }
+#endif
+
+        if (!again && !bridge_has_pending_data(bridge)) {
+            break;
+        }
+    }
+}
+
+/* ========== Worker Thread ========== */
+
+/**
+ * Line timer expired: run the line's passes
+ */
+static void ml_line_timer(void *arg)
+{
+    ml_line_t *line = (ml_line_t *)arg;
+
+    ml_service_line(line->home, line);
+    bridge_timers_update(&line->bridge, ml_now_ms());
+}
+
+/**
+ * Periodic sweep: serial retry, connect progress, reconnected descriptors
+ */
+static void ml_worker_sweep(void *arg)
+{
+    ml_worker_t *worker = (ml_worker_t *)arg;
+    multiline_ctx_t *ml = worker->owner;
+
+    for (int i = 0; i < ml->line_count; i++) {
+        ml_line_t *line = &ml->lines[i];
+        if (line->worker != worker->index) {
+            continue;
+        }
+        ml_service_line(worker, line);
+        ml_sync_line(worker, line);
+        bridge_timers_update(&line->bridge, ml_now_ms());
+    }
+
+    timerwheel_schedule(&worker->wheel, &worker->sweep_timer, ml_now_ms() + ML_TICK_MS);
+}
+
+/**
+ * Epoll worker thread
+ */
+static void *ml_worker_thread_func(void *arg)
+{
+    ml_worker_t *worker = (ml_worker_t *)arg;
+    multiline_ctx_t *ml = worker->owner;
+    struct epoll_event events[ML_MAX_EVENTS];
+
+    MB_LOG_INFO("[Worker %d] Multi-line worker started", worker->index);
+
+    /* The wheel is only touched from this thread */
+    timerwheel_init(&worker->wheel, ml_now_ms());
+    for (int i = 0; i < ml->line_count; i++) {
+        ml_line_t *line = &ml->lines[i];
+        if (line->worker == worker->index) {
+            bridge_timers_attach(&line->bridge, &worker->wheel, ml_line_timer, line);
+        }
+    }
+    timerwheel_timer_init(&worker->sweep_timer, ml_worker_sweep, worker);
+    timerwheel_schedule(&worker->wheel, &worker->sweep_timer, ml_now_ms());
+
+    while (ml->running) {
+        timerwheel_arm_timerfd(&worker->wheel, worker->timer_fd);
+
+        int n = epoll_wait(worker->epoll_fd, events, ML_MAX_EVENTS, -1);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            MB_LOG_ERROR("[Worker %d] epoll_wait failed: %s", worker->index, strerror(errno));
+            usleep(ML_TICK_MS * 1000);
+            continue;
+        }
+
+        worker->wakeups++;
+
+        /* Lines with pending I/O */
+        for (int i = 0; i < n; i++) {
+            ml_line_t *line = (ml_line_t *)events[i].data.ptr;
+            if (line == NULL) {
+                uint64_t count;
+                ssize_t ret = read(worker->timer_fd, &count, sizeof(count));
+                (void)ret;
+                continue;
+            }
+            ml_service_line(worker, line);
+            bridge_timers_update(&line->bridge, ml_now_ms());
+        }
+
+        /* Expired line timers and the sweep */
+        timerwheel_advance(&worker->wheel, ml_now_ms());
+    }
+
+    for (int i = 0; i < ml->line_count; i++) {
+        if (ml->lines[i].worker == worker->index) {
+            bridge_timers_detach(&ml->lines[i].bridge);
+        }
+    }
+
+    MB_LOG_INFO("[Worker %d] Multi-line worker exiting", worker->index);
+    return NULL;
+}
+
+/* ========== Public API ========== */
+
+/**
+ * Initialize multi-line context
+ */
+int multiline_init(multiline_ctx_t *ml, config_t *cfg)
+{
+    if (ml == NULL || !config_is_multiline(cfg)) {
+        return ERROR_INVALID_ARG;
+    }
+
+    memset(ml, 0, sizeof(multiline_ctx_t));
+    ml->config = cfg;
+
+    ml->lines = calloc(cfg->line_count, sizeof(ml_line_t));
+    if (ml->lines == NULL) {
+        MB_LOG_ERROR("Failed to allocate %d lines", cfg->line_count);
+        return ERROR_GENERAL;
+    }
+    ml->line_count = cfg->line_count;
+
+    /* Worker count: LINE_WORKERS, or one per CPU but never more than lines */
+    int workers = cfg->line_workers;
+    if (workers <= 0) {
+        workers = MIN(ml->line_count, get_nprocs());
+    }
+    workers = MAX(1, MIN(workers, MIN(ml->line_count, ML_MAX_WORKERS)));
+    ml->worker_count = workers;
+
+    for (int i = 0; i < ml->line_count; i++) {
+        ml_line_t *line = &ml->lines[i];
+
+        bridge_init(&line->bridge, &cfg->lines[i]);
+        line->bridge.use_worker_pool = true;
+        line->bridge.poll_timeout_ms = 0;   /* Workers never block in a poll pass */
+
+        line->worker = i % ml->worker_count;
+        line->home = &ml->workers[line->worker];
+        line->serial_fd = -1;
+        line->telnet_fd = -1;
+        line->start_result = ERROR_GENERAL;
+    }
+
+    for (int i = 0; i < ml->worker_count; i++) {
+        ml->workers[i].index = i;
+        ml->workers[i].owner = ml;
+        ml->workers[i].epoll_fd = -1;
+        ml->workers[i].timer_fd = -1;
+    }
+
+    MB_LOG_INFO("Multi-line context initialized: %d lines, %d workers",
+               ml->line_count, ml->worker_count);
+    return SUCCESS;
+}
+
+/**
+ * Bring up one line (runs on a temporary thread)
+ */
+static void *ml_line_start_thread_func(void *arg)
+{
+    ml_line_t *line = (ml_line_t *)arg;
+
+    line->start_result = bridge_start(&line->bridge);
+    return NULL;
+}
+
+/**
+ * Placement of a worker: the serial thread settings, with workers spread
+ * one CPU each, round-robin, over CPU_AFFINITY_WORKERS
+ */
+static void ml_worker_spec(const multiline_ctx_t *ml, int index, rtsched_spec_t *spec)
+{
+    cpu_set_t cpus;
+
+    rtsched_spec_from_config(ml->config, RTSCHED_SERIAL, spec);
+    if (rtsched_parse_cpus(ml->config->cpu_affinity_workers, &cpus) != SUCCESS) {
+        return;
+    }
+
+    int count = CPU_COUNT(&cpus);
+    if (count == 0) {
+        return;
+    }
+
+    int nth = index % count;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &cpus) && nth-- == 0) {
+            CPU_ZERO(&spec->cpus);
+            CPU_SET(cpu, &spec->cpus);
+            break;
+        }
+    }
+}
+
+/**
+ * Start all lines and the worker pool
+ */
+int multiline_start(multiline_ctx_t *ml)
+{
+    if (ml == NULL || ml->lines == NULL) {
+        return ERROR_INVALID_ARG;
+    }
+
+    /* Each line waits on its own modem during initialization, so start them in parallel */
+    pthread_t *starters = calloc(ml->line_count, sizeof(pthread_t));
+    bool *started = calloc(ml->line_count, sizeof(bool));
+    if (starters == NULL || started == NULL) {
+        free(starters);
+        free(started);
+        return ERROR_GENERAL;
+    }
+
+    for (int i = 0; i < ml->line_count; i++) {
+        if (pthread_create(&starters[i], NULL, ml_line_start_thread_func, &ml->lines[i]) == 0) {
+            started[i] = true;
+        } else {
+            ml_line_start_thread_func(&ml->lines[i]);
+        }
+    }
+    for (int i = 0; i < ml->line_count; i++) {
+        if (started[i]) {
+            pthread_join(starters[i], NULL);
+        }
+    }
+    free(starters);
+    free(started);
+
+    int active = 0;
+    for (int i = 0; i < ml->line_count; i++) {
+        if (ml->lines[i].start_result == SUCCESS) {
+            active++;
+        } else {
+            MB_LOG_ERROR("[line.%d] Failed to start bridge", ml->lines[i].bridge.line_id);
+        }
+    }
+    if (active == 0) {
+        MB_LOG_ERROR("No line could be started");
+        return ERROR_GENERAL;
+    }
+
+    ml->running = true;
+
+    for (int i = 0; i < ml->worker_count; i++) {
+        ml_worker_t *worker = &ml->workers[i];
+
+        worker->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        worker->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (worker->epoll_fd < 0 || worker->timer_fd < 0) {
+            MB_LOG_ERROR("[Worker %d] Failed to create epoll/timerfd: %s", i, strerror(errno));
+            multiline_stop(ml);
+            return ERROR_GENERAL;
+        }
+
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.ptr = NULL;
+        if (epoll_ctl(worker->epoll_fd, EPOLL_CTL_ADD, worker->timer_fd, &ev) < 0) {
+            MB_LOG_ERROR("[Worker %d] Failed to register timerfd: %s", i, strerror(errno));
+            multiline_stop(ml);
+            return ERROR_GENERAL;
+        }
+
+        char name[32];
+        rtsched_spec_t spec;
+        ml_worker_spec(ml, i, &spec);
+        snprintf(name, sizeof(name), "Worker %d", i);
+        int ret = rtsched_thread_create(&worker->thread, &spec, name, ml_worker_thread_func, worker);
+        if (ret != 0) {
+            MB_LOG_ERROR("[Worker %d] Failed to create thread: %s", i, strerror(ret));
+            multiline_stop(ml);
+            return ERROR_GENERAL;
+        }
+        worker->thread_started = true;
+
+        /* The worker is the serial thread of its lines */
+        rtsched_status_t status;
+        char placement[128];
+        rtsched_query(worker->thread, &status);
+        rtsched_format(&status, placement, sizeof(placement));
+        MB_LOG_INFO("[Worker %d] Running on %s", i, placement);
+        for (int j = 0; j < ml->line_count; j++) {
+            if (ml->lines[j].worker == i) {
+                ml->lines[j].bridge.thread_sched[RTSCHED_SERIAL] = status;
+            }
+        }
+    }
+
+    MB_LOG_INFO("Multi-line mode started: %d/%d lines active, %d workers",
+               active, ml->line_count, ml->worker_count);
+    return SUCCESS;
+}
+
+/**
+ * Supervisor pass
+ */
+int multiline_run(multiline_ctx_t *ml)
+{
+    if (ml == NULL) {
+        return ERROR_INVALID_ARG;
+    }
+
+    if (!ml->running) {
+        return ERROR_GENERAL;
+    }
+
+    usleep(100000);  /* 100ms - allows responsive signal handling */
+
+    for (int i = 0; i < ml->line_count; i++) {
+        if (ml->lines[i].start_result == SUCCESS) {
+            bridge_check_serial_retry(&ml->lines[i].bridge);
+        }
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * Stop multi-line mode
+ */
+int multiline_stop(multiline_ctx_t *ml)
+{
+    if (ml == NULL) {
+        return ERROR_INVALID_ARG;
+    }
+
+    MB_LOG_INFO("Stopping multi-line mode");
+
+    /* Workers first, so no poll pass races with bridge teardown */
+    ml->running = false;
+    for (int i = 0; i < ml->worker_count; i++) {
+        if (ml->workers[i].thread_started) {
+            pthread_join(ml->workers[i].thread, NULL);
+            ml->workers[i].thread_started = false;
+        }
+    }
+
+    multiline_print_stats(ml);
+
+    for (int i = 0; i < ml->line_count; i++) {
+        if (ml->lines[i].start_result == SUCCESS) {
+            bridge_stop(&ml->lines[i].bridge);
+            ml->lines[i].start_result = ERROR_GENERAL;
+        }
+    }
+
+    for (int i = 0; i < ml->worker_count; i++) {
+        if (ml->workers[i].epoll_fd >= 0) {
+            close(ml->workers[i].epoll_fd);
+            ml->workers[i].epoll_fd = -1;
+        }
+        if (ml->workers[i].timer_fd >= 0) {
+            close(ml->workers[i].timer_fd);
+            ml->workers[i].timer_fd = -1;
+        }
+    }
+
+    free(ml->lines);
+    ml->lines = NULL;
+    ml->line_count = 0;
+
+    MB_LOG_INFO("Multi-line mode stopped");
+    return SUCCESS;
+}
+
+/**
+ * Print multi-line statistics
+ */
+void multiline_print_stats(multiline_ctx_t *ml)
+{
+    if (ml == NULL) {
+        return;
+    }
+
+    MB_LOG_INFO("=== Multi-line Statistics ===");
+    for (int i = 0; i < ml->line_count; i++) {
+        bridge_ctx_t *bridge = &ml->lines[i].bridge;
+        MB_LOG_INFO("[line.%d] %s: serial %s, worker %d, %llu bytes serial->telnet, %llu bytes telnet->serial",
+                   bridge->line_id, bridge->config->serial_port,
+                   bridge->serial_ready ? "ready" : "unavailable", ml->lines[i].worker,
+                   (unsigned long long)bridge->bytes_serial_to_telnet,
+                   (unsigned long long)bridge->bytes_telnet_to_serial);
+    }
+    for (int i = 0; i < ml->worker_count; i++) {
+        MB_LOG_INFO("[Worker %d] %llu wakeups, %llu line dispatches", i,
+                   (unsigned long long)ml->workers[i].wakeups,
+                   (unsigned long long)ml->workers[i].dispatches);
+    }
+    MB_LOG_INFO("=============================");
+}
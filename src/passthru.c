@@ -0,0 +1,228 @@
+/*
+ * passthru.c - Kernel splice() data plane for transparent lines
+ */
+
+#include "passthru.h"
+
+static const char *const passthru_dir_names[] = {
+    [PASSTHRU_TO_TELNET] = "serial -> telnet",
+    [PASSTHRU_TO_SERIAL] = "telnet -> serial"
+};
+
+/**
+ * Initialize a data plane
+ */
+void passthru_init(passthru_t *pt, bool enabled)
+{
+    if (pt == NULL) {
+        return;
+    }
+
+    memset(pt, 0, sizeof(*pt));
+    pt->enabled = enabled;
+    for (int d = 0; d < PASSTHRU_DIR_COUNT; d++) {
+        pt->dir[d].pipe_fd[0] = -1;
+        pt->dir[d].pipe_fd[1] = -1;
+    }
+}
+
+/**
+ * Close the pipes
+ */
+void passthru_close(passthru_t *pt)
+{
+    if (pt == NULL) {
+        return;
+    }
+
+    for (int d = 0; d < PASSTHRU_DIR_COUNT; d++) {
+        passthru_dir_t *dir = &pt->dir[d];
+        for (int i = 0; i < 2; i++) {
+            if (dir->pipe_fd[i] >= 0) {
+                close(dir->pipe_fd[i]);
+                dir->pipe_fd[i] = -1;
+            }
+        }
+        dir->pending = 0;
+        dir->engaged = false;
+    }
+}
+
+/**
+ * Map a splice() failure: EINVAL means the fd type cannot splice (e.g. a
+ * tty driver without splice support), which sends the direction back to
+ * userspace for good
+ */
+static int passthru_fail(passthru_dir_t *dir, passthru_dir_id_t id, const char *side)
+{
+    if (errno == EINVAL || errno == ENOSYS) {
+        MB_LOG_WARNING("splice() not supported for the %s of %s, using userspace copies",
+                      side, passthru_dir_names[id]);
+        dir->unsupported = true;
+        return ERROR_SYSTEM;
+    }
+
+    MB_LOG_ERROR("splice() %s of %s failed: %s", side, passthru_dir_names[id], strerror(errno));
+    return ERROR_IO;
+}
+
+/**
+ * Move a direction to the kernel
+ */
+bool passthru_engage(passthru_t *pt, passthru_dir_id_t id)
+{
+    if (pt == NULL || !pt->enabled) {
+        return false;
+    }
+
+    passthru_dir_t *dir = &pt->dir[id];
+    if (dir->engaged) {
+        return true;
+    }
+    if (dir->unsupported) {
+        return false;
+    }
+
+    if (dir->pipe_fd[0] < 0 && pipe2(dir->pipe_fd, O_NONBLOCK | O_CLOEXEC) < 0) {
+        MB_LOG_WARNING("Failed to create %s splice pipe: %s", passthru_dir_names[id], strerror(errno));
+        dir->pipe_fd[0] = -1;
+        dir->pipe_fd[1] = -1;
+        dir->unsupported = true;
+        return false;
+    }
+
+    dir->engaged = true;
+    dir->engagements++;
+    MB_LOG_INFO("Splice passthrough on: %s", passthru_dir_names[id]);
+    return true;
+}
+
+/**
+ * Return a direction to userspace
+ */
+size_t passthru_release(passthru_t *pt, passthru_dir_id_t id, unsigned char *buf, size_t size)
+{
+    if (pt == NULL) {
+        return 0;
+    }
+
+    passthru_dir_t *dir = &pt->dir[id];
+    if (!dir->engaged) {
+        return 0;
+    }
+
+    size_t got = 0;
+    while (dir->pending > 0 && got < size) {
+        ssize_t n = read(dir->pipe_fd[0], buf + got, MIN(dir->pending, size - got));
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        got += (size_t)n;
+        dir->pending -= (size_t)n;
+    }
+    if (dir->pending > 0) {
+        MB_LOG_WARNING("Splice passthrough: dropped %zu bytes of %s", dir->pending,
+                      passthru_dir_names[id]);
+        dir->pending = 0;
+    }
+
+    dir->engaged = false;
+    MB_LOG_INFO("Splice passthrough off: %s (%llu bytes spliced)", passthru_dir_names[id],
+                (unsigned long long)dir->bytes);
+    return got;
+}
+
+/**
+ * Splice from a source fd into the direction's pipe
+ */
+ssize_t passthru_fill(passthru_t *pt, passthru_dir_id_t id, int in_fd, size_t max)
+{
+    if (pt == NULL || in_fd < 0 || !pt->dir[id].engaged) {
+        return ERROR_INVALID_ARG;
+    }
+
+    passthru_dir_t *dir = &pt->dir[id];
+    if (dir->pending > 0 || max == 0) {
+        return 0;
+    }
+
+    ssize_t n = splice(in_fd, NULL, dir->pipe_fd[1], NULL, max, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    if (n == 0) {
+        return ERROR_CONNECTION;
+    }
+    if (n < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+            return 0;
+        }
+        return passthru_fail(dir, id, "source");
+    }
+
+    dir->pending = (size_t)n;
+    return n;
+}
+
+/**
+ * Splice bytes waiting in the direction's pipe to a destination fd
+ */
+int passthru_drain(passthru_t *pt, passthru_dir_id_t id, int out_fd)
+{
+    if (pt == NULL || out_fd < 0 || !pt->dir[id].engaged) {
+        return ERROR_INVALID_ARG;
+    }
+
+    passthru_dir_t *dir = &pt->dir[id];
+    while (dir->pending > 0) {
+        ssize_t n = splice(dir->pipe_fd[0], NULL, out_fd, NULL, dir->pending,
+                           SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            return passthru_fail(dir, id, "destination");
+        }
+        if (n == 0) {
+            break;
+        }
+        passthru_drained(pt, id, (size_t)n);
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * Account bytes written out of the pipe by another module
+ */
+void passthru_drained(passthru_t *pt, passthru_dir_id_t id, size_t n)
+{
+    if (pt == NULL) {
+        return;
+    }
+
+    passthru_dir_t *dir = &pt->dir[id];
+    n = MIN(n, dir->pending);
+    dir->pending -= n;
+    dir->bytes += n;
+}
+
+/**
+ * Check for bytes waiting in any pipe
+ */
+bool passthru_pending(const passthru_t *pt)
+{
+    if (pt == NULL) {
+        return false;
+    }
+
+    for (int d = 0; d < PASSTHRU_DIR_COUNT; d++) {
+        if (pt->dir[d].pending > 0) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,541 @@
+/*
+ * resolver.c - Cached host name resolution for telnet connects
+ */
+
+#include "resolver.h"
+#include <pthread.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <sys/eventfd.h>
+
+/* One cached name */
+typedef struct {
+    char host[SMALL_BUFFER_SIZE];   /* "" = free slot */
+    int port;
+    bool valid;                     /* result holds addresses */
+    bool failed;                    /* Last lookup failed (negative entry) */
+    bool queued;                    /* Waiting for the resolver thread */
+    bool in_flight;                 /* Being resolved (not evictable) */
+    time_t expires;                 /* Monotonic seconds */
+    time_t last_used;
+    int waiters[RESOLVER_MAX_WAITERS];  /* Eventfds to signal when the lookup lands */
+    int waiter_count;
+    resolver_result_t result;
+} resolver_entry_t;
+
+static resolver_entry_t resolver_cache[RESOLVER_CACHE_SIZE];
+static pthread_mutex_t resolver_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t resolver_work_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t resolver_done_cond = PTHREAD_COND_INITIALIZER;
+static int resolver_ttl = DEFAULT_DNS_CACHE_TTL;
+
+static pthread_t resolver_thread;
+static bool resolver_running = false;
+
+/**
+ * Monotonic clock in seconds
+ */
+static time_t resolver_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec;
+}
+
+/**
+ * Resolve a name with getaddrinfo(), interleaving address families
+ * The first family returned (the system's preference per RFC 6724) leads,
+ * so a happy-eyeballs connect tries it first and the other family next.
+ * @return 0 on success, getaddrinfo() error code on failure
+ */
+static int resolver_getaddrinfo(const char *host, int port, resolver_result_t *result)
+{
+    struct addrinfo hints;
+    struct addrinfo *list = NULL;
+    struct addrinfo *primary[RESOLVER_MAX_ADDRS];
+    struct addrinfo *secondary[RESOLVER_MAX_ADDRS];
+    int primary_count = 0;
+    int secondary_count = 0;
+    char service[16];
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_ADDRCONFIG | AI_NUMERICSERV;
+    snprintf(service, sizeof(service), "%d", port);
+
+    int rc = getaddrinfo(host, service, &hints, &list);
+    if (rc != 0) {
+        return rc;
+    }
+
+    for (struct addrinfo *ai = list; ai != NULL; ai = ai->ai_next) {
+        if (ai->ai_addrlen > sizeof(struct sockaddr_storage)) {
+            continue;
+        }
+        if (ai->ai_family == list->ai_family) {
+            if (primary_count < RESOLVER_MAX_ADDRS) {
+                primary[primary_count++] = ai;
+            }
+        } else if (secondary_count < RESOLVER_MAX_ADDRS) {
+            secondary[secondary_count++] = ai;
+        }
+    }
+
+    result->count = 0;
+    for (int i = 0; result->count < RESOLVER_MAX_ADDRS &&
+                    (i < primary_count || i < secondary_count); i++) {
+        struct addrinfo *pick[2] = {
+            (i < primary_count) ? primary[i] : NULL,
+            (i < secondary_count) ? secondary[i] : NULL
+        };
+        for (int j = 0; j < 2 && result->count < RESOLVER_MAX_ADDRS; j++) {
+            if (pick[j] == NULL) {
+                continue;
+            }
+            memcpy(&result->addrs[result->count], pick[j]->ai_addr, pick[j]->ai_addrlen);
+            result->addr_len[result->count] = pick[j]->ai_addrlen;
+            result->count++;
+        }
+    }
+
+    freeaddrinfo(list);
+    return (result->count > 0) ? 0 : EAI_NONAME;
+}
+
+/**
+ * Find the cache entry of a name (call with resolver_mutex held)
+ */
+static resolver_entry_t *resolver_find(const char *host, int port)
+{
+    for (int i = 0; i < RESOLVER_CACHE_SIZE; i++) {
+        resolver_entry_t *e = &resolver_cache[i];
+        if (e->host[0] != '\0' && e->port == port && strcmp(e->host, host) == 0) {
+            return e;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Claim a slot for a name, evicting the least recently used idle entry
+ * (call with resolver_mutex held)
+ * @return Entry, or NULL if every slot is being resolved
+ */
+static resolver_entry_t *resolver_claim(const char *host, int port)
+{
+    resolver_entry_t *victim = NULL;
+
+    for (int i = 0; i < RESOLVER_CACHE_SIZE; i++) {
+        resolver_entry_t *e = &resolver_cache[i];
+        if (e->host[0] == '\0') {
+            victim = e;
+            break;
+        }
+        if (!e->in_flight && !e->queued &&
+            (victim == NULL || e->last_used < victim->last_used)) {
+            victim = e;
+        }
+    }
+
+    if (victim != NULL) {
+        memset(victim, 0, sizeof(*victim));
+        SAFE_STRNCPY(victim->host, host, sizeof(victim->host));
+        victim->port = port;
+        victim->last_used = resolver_now();
+    }
+
+    return victim;
+}
+
+/**
+ * Store a lookup result (call with resolver_mutex held)
+ */
+static void resolver_store(resolver_entry_t *e, int rc, const resolver_result_t *result)
+{
+    time_t now = resolver_now();
+
+    if (rc == 0) {
+        e->result = *result;
+        e->valid = true;
+        e->failed = false;
+        /* Without a cache the answer still serves the connects waiting for it */
+        e->expires = now + MAX(resolver_ttl, RESOLVER_SHARE_TTL);
+        MB_LOG_DEBUG("Resolved %s: %d address(es), cached for %d s",
+                     e->host, result->count, resolver_ttl);
+    } else {
+        e->valid = false;
+        e->failed = true;
+        e->expires = now + RESOLVER_NEGATIVE_TTL;
+    }
+}
+
+/**
+ * Queue a background refresh of an entry (call with resolver_mutex held)
+ */
+static void resolver_queue(resolver_entry_t *e)
+{
+    if (!resolver_running || e->queued || e->in_flight) {
+        return;
+    }
+
+    e->queued = true;
+    pthread_cond_signal(&resolver_work_cond);
+}
+
+/**
+ * Register an eventfd to signal when an entry's lookup lands
+ * (call with resolver_mutex held; a full list leaves the caller polling)
+ */
+static void resolver_add_waiter(resolver_entry_t *e, int notify_fd)
+{
+    if (notify_fd < 0) {
+        return;
+    }
+
+    for (int i = 0; i < e->waiter_count; i++) {
+        if (e->waiters[i] == notify_fd) {
+            return;
+        }
+    }
+    if (e->waiter_count < RESOLVER_MAX_WAITERS) {
+        e->waiters[e->waiter_count++] = notify_fd;
+    }
+}
+
+/**
+ * Wake every connect waiting on an entry (call with resolver_mutex held)
+ */
+static void resolver_wake_waiters(resolver_entry_t *e)
+{
+    for (int i = 0; i < e->waiter_count; i++) {
+        if (eventfd_write(e->waiters[i], 1) < 0) {
+            MB_LOG_WARNING("Failed to wake DNS waiter (fd %d): %s", e->waiters[i], strerror(errno));
+        }
+    }
+    e->waiter_count = 0;
+}
+
+/**
+ * Check for a numeric IPv4/IPv6 address (resolves without DNS)
+ */
+static bool resolver_is_numeric(const char *host)
+{
+    struct in6_addr numeric;
+
+    return inet_pton(AF_INET, host, &numeric) == 1 || inet_pton(AF_INET6, host, &numeric) == 1;
+}
+
+/**
+ * Resolver thread: resolves queued entries one at a time
+ */
+static void *resolver_thread_func(void *arg)
+{
+    (void)arg;
+
+    pthread_mutex_lock(&resolver_mutex);
+    while (resolver_running) {
+        resolver_entry_t *e = NULL;
+        for (int i = 0; i < RESOLVER_CACHE_SIZE; i++) {
+            if (resolver_cache[i].queued) {
+                e = &resolver_cache[i];
+                break;
+            }
+        }
+
+        if (e == NULL) {
+            pthread_cond_wait(&resolver_work_cond, &resolver_mutex);
+            continue;
+        }
+
+        char host[SMALL_BUFFER_SIZE];
+        int port = e->port;
+        resolver_result_t result;
+
+        SAFE_STRNCPY(host, e->host, sizeof(host));
+        e->queued = false;
+        e->in_flight = true;
+
+        pthread_mutex_unlock(&resolver_mutex);
+        int rc = resolver_getaddrinfo(host, port, &result);
+        pthread_mutex_lock(&resolver_mutex);
+
+        if (rc != 0) {
+            MB_LOG_WARNING("Background lookup of %s failed: %s", host, gai_strerror(rc));
+        }
+        resolver_store(e, rc, &result);
+        e->in_flight = false;
+        resolver_wake_waiters(e);
+        pthread_cond_broadcast(&resolver_done_cond);
+    }
+    pthread_mutex_unlock(&resolver_mutex);
+
+    return NULL;
+}
+
+/**
+ * Set the cache TTL and start the background resolver thread
+ */
+int resolver_init(int ttl_sec)
+{
+    pthread_mutex_lock(&resolver_mutex);
+    resolver_ttl = MAX(ttl_sec, 0);
+    if (resolver_running) {
+        pthread_mutex_unlock(&resolver_mutex);
+        return SUCCESS;
+    }
+
+    resolver_running = true;
+    if (pthread_create(&resolver_thread, NULL, resolver_thread_func, NULL) != 0) {
+        resolver_running = false;
+        pthread_mutex_unlock(&resolver_mutex);
+        MB_LOG_ERROR("Failed to start resolver thread");
+        return ERROR_GENERAL;
+    }
+    pthread_mutex_unlock(&resolver_mutex);
+
+    if (resolver_ttl > 0) {
+        MB_LOG_INFO("DNS cache enabled (TTL %d s)", resolver_ttl);
+    } else {
+        MB_LOG_INFO("DNS cache disabled (lookups still run off the I/O threads)");
+    }
+    return SUCCESS;
+}
+
+/**
+ * Stop the resolver thread and drop the cache
+ */
+void resolver_shutdown(void)
+{
+    pthread_mutex_lock(&resolver_mutex);
+    bool started = resolver_running;
+    resolver_running = false;
+    pthread_cond_broadcast(&resolver_work_cond);
+    pthread_mutex_unlock(&resolver_mutex);
+
+    if (started) {
+        pthread_join(resolver_thread, NULL);
+    }
+
+    pthread_mutex_lock(&resolver_mutex);
+    memset(resolver_cache, 0, sizeof(resolver_cache));
+    pthread_mutex_unlock(&resolver_mutex);
+}
+
+/**
+ * Resolve a name in the background unless a fresh entry is cached
+ */
+void resolver_prefetch(const char *host, int port)
+{
+    if (host == NULL || host[0] == '\0') {
+        return;
+    }
+
+    pthread_mutex_lock(&resolver_mutex);
+    if (resolver_running && resolver_ttl > 0) {
+        resolver_entry_t *e = resolver_find(host, port);
+        if (e == NULL) {
+            e = resolver_claim(host, port);
+        }
+        if (e != NULL && ((!e->valid && !e->failed) || resolver_now() >= e->expires)) {
+            resolver_queue(e);
+        }
+    }
+    pthread_mutex_unlock(&resolver_mutex);
+}
+
+/**
+ * Check whether resolver_lookup() would return without waiting on DNS
+ */
+bool resolver_ready(const char *host, int port)
+{
+    if (host == NULL) {
+        return false;
+    }
+    if (resolver_is_numeric(host)) {
+        return true;
+    }
+
+    pthread_mutex_lock(&resolver_mutex);
+    resolver_entry_t *e = (resolver_ttl > 0) ? resolver_find(host, port) : NULL;
+    bool ready = (e != NULL && e->valid && !e->in_flight && !e->queued);
+    pthread_mutex_unlock(&resolver_mutex);
+
+    return ready;
+}
+
+/**
+ * Get the addresses of a name
+ */
+int resolver_lookup(const char *host, int port, resolver_result_t *result)
+{
+    if (host == NULL || result == NULL) {
+        return ERROR_INVALID_ARG;
+    }
+
+    pthread_mutex_lock(&resolver_mutex);
+
+    if (resolver_ttl > 0) {
+        resolver_entry_t *e = resolver_find(host, port);
+
+        /* A lookup the resolver thread started is about to land */
+        while (e != NULL && (e->in_flight || e->queued) && resolver_running) {
+            pthread_cond_wait(&resolver_done_cond, &resolver_mutex);
+            e = resolver_find(host, port);
+        }
+
+        if (e != NULL && (e->valid || e->failed)) {
+            bool fresh = resolver_now() < e->expires;
+            e->last_used = resolver_now();
+
+            if (e->valid) {
+                *result = e->result;
+                if (!fresh) {
+                    /* Serve stale once, refresh off this thread */
+                    resolver_queue(e);
+                }
+                pthread_mutex_unlock(&resolver_mutex);
+                MB_LOG_DEBUG("DNS cache %s for %s", fresh ? "hit" : "stale hit", host);
+                return SUCCESS;
+            }
+            if (fresh) {
+                pthread_mutex_unlock(&resolver_mutex);
+                MB_LOG_ERROR("Failed to resolve host: %s (cached)", host);
+                return ERROR_CONNECTION;
+            }
+        }
+    }
+
+    pthread_mutex_unlock(&resolver_mutex);
+
+    /* Miss: resolve on this thread */
+    int rc = resolver_getaddrinfo(host, port, result);
+
+    pthread_mutex_lock(&resolver_mutex);
+    if (resolver_ttl > 0) {
+        resolver_entry_t *e = resolver_find(host, port);
+        if (e == NULL) {
+            e = resolver_claim(host, port);
+        }
+        if (e != NULL && !e->in_flight) {
+            resolver_store(e, rc, result);
+        }
+    }
+    pthread_mutex_unlock(&resolver_mutex);
+
+    if (rc != 0) {
+        MB_LOG_ERROR("Failed to resolve host: %s (%s)", host, gai_strerror(rc));
+        return ERROR_CONNECTION;
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * Get the addresses of a name without waiting on DNS
+ */
+int resolver_lookup_async(const char *host, int port, resolver_result_t *result, int notify_fd)
+{
+    if (host == NULL || result == NULL) {
+        return ERROR_INVALID_ARG;
+    }
+
+    /* No DNS involved */
+    if (resolver_is_numeric(host)) {
+        int rc = resolver_getaddrinfo(host, port, result);
+        if (rc != 0) {
+            MB_LOG_ERROR("Failed to use address %s (%s)", host, gai_strerror(rc));
+            return ERROR_CONNECTION;
+        }
+        return SUCCESS;
+    }
+
+    pthread_mutex_lock(&resolver_mutex);
+
+    if (!resolver_running) {
+        pthread_mutex_unlock(&resolver_mutex);
+        return resolver_lookup(host, port, result);
+    }
+
+    time_t now = resolver_now();
+    resolver_entry_t *e = resolver_find(host, port);
+
+    if (e != NULL && e->valid && (now < e->expires || resolver_ttl > 0)) {
+        bool fresh = now < e->expires;
+        *result = e->result;
+        e->last_used = now;
+        if (!fresh) {
+            /* Serve stale once, refresh off this thread */
+            resolver_queue(e);
+        }
+        pthread_mutex_unlock(&resolver_mutex);
+        MB_LOG_DEBUG("DNS cache %s for %s", fresh ? "hit" : "stale hit", host);
+        return SUCCESS;
+    }
+
+    if (e != NULL && e->failed && now < e->expires && !e->queued && !e->in_flight) {
+        pthread_mutex_unlock(&resolver_mutex);
+        MB_LOG_ERROR("Failed to resolve host: %s (cached)", host);
+        return ERROR_CONNECTION;
+    }
+
+    /* Miss: the resolver thread looks it up and wakes the caller */
+    if (e == NULL) {
+        e = resolver_claim(host, port);
+    }
+    if (e != NULL) {
+        e->last_used = now;
+        resolver_add_waiter(e, notify_fd);
+        resolver_queue(e);
+    }
+    pthread_mutex_unlock(&resolver_mutex);
+
+    MB_LOG_DEBUG("DNS lookup of %s queued to the resolver thread", host);
+    return RESOLVER_PENDING;
+}
+
+/**
+ * Stop signalling an eventfd passed to resolver_lookup_async()
+ */
+void resolver_cancel(int notify_fd)
+{
+    if (notify_fd < 0) {
+        return;
+    }
+
+    pthread_mutex_lock(&resolver_mutex);
+    for (int i = 0; i < RESOLVER_CACHE_SIZE; i++) {
+        resolver_entry_t *e = &resolver_cache[i];
+        for (int w = 0; w < e->waiter_count; w++) {
+            if (e->waiters[w] == notify_fd) {
+                e->waiters[w] = e->waiters[--e->waiter_count];
+                break;
+            }
+        }
+    }
+    pthread_mutex_unlock(&resolver_mutex);
+}
+
+/**
+ * Format an address for logging
+ */
+const char *resolver_format_addr(const struct sockaddr_storage *addr, char *buf, size_t len)
+{
+    char text[INET6_ADDRSTRLEN];
+
+    if (addr->ss_family == AF_INET6) {
+        const struct sockaddr_in6 *sin6 = (const struct sockaddr_in6 *)addr;
+        inet_ntop(AF_INET6, &sin6->sin6_addr, text, sizeof(text));
+        snprintf(buf, len, "[%s]", text);
+    } else if (addr->ss_family == AF_INET) {
+        const struct sockaddr_in *sin = (const struct sockaddr_in *)addr;
+        inet_ntop(AF_INET, &sin->sin_addr, text, sizeof(text));
+        snprintf(buf, len, "%s", text);
+    } else {
+        snprintf(buf, len, "(family %d)", addr->ss_family);
+    }
+
+    return buf;
+}
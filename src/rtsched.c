@@ -0,0 +1,374 @@
+/*
+ * rtsched.c - Thread placement, real-time priority and memory locking
+ */
+
+#include "rtsched.h"
+#include <sys/mman.h>
+#include <strings.h>
+
+static bool rtsched_locked = false;
+
+/* Start arguments passed through to the new thread */
+typedef struct {
+    void *(*fn)(void *);
+    void *arg;
+    bool prefault;
+} rtsched_start_t;
+
+/**
+ * Parse a CPU list
+ */
+int rtsched_parse_cpus(const char *list, cpu_set_t *cpus)
+{
+    if (list == NULL || cpus == NULL) {
+        return ERROR_INVALID_ARG;
+    }
+
+    CPU_ZERO(cpus);
+
+    const char *p = list;
+    while (*p == ' ' || *p == '\t') {
+        p++;
+    }
+    if (*p == '\0') {
+        return SUCCESS;
+    }
+
+    while (*p != '\0') {
+        char *end;
+        long first = strtol(p, &end, 10);
+        if (end == p || first < 0 || first >= CPU_SETSIZE) {
+            return ERROR_CONFIG;
+        }
+        long last = first;
+        p = end;
+        if (*p == '-') {
+            p++;
+            last = strtol(p, &end, 10);
+            if (end == p || last < first || last >= CPU_SETSIZE) {
+                return ERROR_CONFIG;
+            }
+            p = end;
+        }
+        for (long cpu = first; cpu <= last; cpu++) {
+            CPU_SET((int)cpu, cpus);
+        }
+
+        while (*p == ' ' || *p == '\t') {
+            p++;
+        }
+        if (*p == ',') {
+            p++;
+            while (*p == ' ' || *p == '\t') {
+                p++;
+            }
+            if (*p == '\0') {
+                return ERROR_CONFIG;
+            }
+        } else if (*p != '\0') {
+            return ERROR_CONFIG;
+        }
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * Parse a scheduling policy name
+ */
+int rtsched_parse_policy(const char *name, int *policy)
+{
+    if (name == NULL || policy == NULL) {
+        return ERROR_INVALID_ARG;
+    }
+
+    if (strncasecmp(name, "SCHED_", 6) == 0) {
+        name += 6;
+    }
+
+    if (strcasecmp(name, "OTHER") == 0 || strcasecmp(name, "NORMAL") == 0) {
+        *policy = SCHED_OTHER;
+    } else if (strcasecmp(name, "FIFO") == 0) {
+        *policy = SCHED_FIFO;
+    } else if (strcasecmp(name, "RR") == 0) {
+        *policy = SCHED_RR;
+    } else {
+        return ERROR_CONFIG;
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * Name of a scheduling policy
+ */
+const char *rtsched_policy_name(int policy)
+{
+    switch (policy) {
+        case SCHED_OTHER:   return "SCHED_OTHER";
+        case SCHED_FIFO:    return "SCHED_FIFO";
+        case SCHED_RR:      return "SCHED_RR";
+#ifdef SCHED_BATCH
+        case SCHED_BATCH:   return "SCHED_BATCH";
+#endif
+#ifdef SCHED_IDLE
+        case SCHED_IDLE:    return "SCHED_IDLE";
+#endif
+        default:            return "unknown";
+    }
+}
+
+/**
+ * Build the placement of a thread role from the configuration
+ */
+void rtsched_spec_from_config(const config_t *cfg, rtsched_role_t role, rtsched_spec_t *spec)
+{
+    if (spec == NULL) {
+        return;
+    }
+
+    memset(spec, 0, sizeof(*spec));
+    CPU_ZERO(&spec->cpus);
+    spec->policy = SCHED_OTHER;
+    if (cfg == NULL) {
+        return;
+    }
+
+    const char *cpus = "";
+    switch (role) {
+        case RTSCHED_SERIAL:
+            cpus = cfg->cpu_affinity_serial;
+            spec->policy = cfg->serial_sched_policy;
+            spec->priority = cfg->serial_sched_priority;
+            if (spec->policy != SCHED_OTHER && spec->priority == 0) {
+                spec->priority = RTSCHED_DEFAULT_PRIORITY;
+            }
+            break;
+        case RTSCHED_TELNET:
+            cpus = cfg->cpu_affinity_telnet;
+            break;
+        case RTSCHED_LEVEL3:
+            cpus = cfg->cpu_affinity_level3;
+            break;
+        default:
+            break;
+    }
+
+    /* Lists were checked when the configuration was read */
+    if (rtsched_parse_cpus(cpus, &spec->cpus) != SUCCESS) {
+        CPU_ZERO(&spec->cpus);
+    }
+    spec->memlock = cfg->memlock;
+}
+
+/**
+ * Touch the stack pages the thread will use, so later calls do not fault
+ */
+static __attribute__((noinline)) void rtsched_prefault_stack(void)
+{
+    volatile unsigned char stack[RTSCHED_STACK_PREFAULT];
+    long page = sysconf(_SC_PAGESIZE);
+
+    if (page <= 0) {
+        page = 4096;
+    }
+    for (size_t i = 0; i < sizeof(stack); i += (size_t)page) {
+        stack[i] = 0;
+    }
+}
+
+/**
+ * Thread entry: prefault the stack, then run the thread function
+ */
+static void *rtsched_thread_start(void *arg)
+{
+    rtsched_start_t start = *(rtsched_start_t *)arg;
+    free(arg);
+
+    if (start.prefault) {
+        rtsched_prefault_stack();
+    }
+    return start.fn(start.arg);
+}
+
+/**
+ * Create a thread with a placement
+ */
+int rtsched_thread_create(pthread_t *thread, const rtsched_spec_t *spec, const char *name,
+                          void *(*fn)(void *), void *arg)
+{
+    if (thread == NULL || fn == NULL) {
+        return EINVAL;
+    }
+    if (spec == NULL) {
+        return pthread_create(thread, NULL, fn, arg);
+    }
+
+    rtsched_start_t *start = malloc(sizeof(*start));
+    if (start == NULL) {
+        return ENOMEM;
+    }
+    start->fn = fn;
+    start->arg = arg;
+    start->prefault = spec->memlock;
+
+    bool pin = CPU_COUNT(&spec->cpus) > 0;
+    bool realtime = (spec->policy == SCHED_FIFO || spec->policy == SCHED_RR);
+    int ret;
+
+    for (;;) {
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+
+        if (spec->memlock) {
+            /* Locked memory is charged for the whole stack once touched */
+            pthread_attr_setstacksize(&attr, RTSCHED_STACK_SIZE);
+        }
+        if (pin) {
+            pthread_attr_setaffinity_np(&attr, sizeof(spec->cpus), &spec->cpus);
+        }
+        if (realtime) {
+            struct sched_param param = { .sched_priority = spec->priority };
+            pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+            pthread_attr_setschedpolicy(&attr, spec->policy);
+            pthread_attr_setschedparam(&attr, &param);
+        }
+
+        ret = pthread_create(thread, &attr, rtsched_thread_start, start);
+        pthread_attr_destroy(&attr);
+
+        if (ret == EPERM && realtime) {
+            MB_LOG_WARNING("%s thread: %s needs CAP_SYS_NICE or RLIMIT_RTPRIO, using SCHED_OTHER",
+                          name, rtsched_policy_name(spec->policy));
+            realtime = false;
+            continue;
+        }
+        if (ret == EINVAL && pin) {
+            MB_LOG_WARNING("%s thread: CPU affinity names no usable CPU, not pinned", name);
+            pin = false;
+            continue;
+        }
+        break;
+    }
+
+    if (ret != 0) {
+        free(start);
+        return ret;
+    }
+
+    /* Some C libraries drop an affinity the kernel refuses without failing */
+    cpu_set_t cpus;
+    if (pin && pthread_getaffinity_np(*thread, sizeof(cpus), &cpus) == 0 &&
+        !CPU_EQUAL(&cpus, &spec->cpus)) {
+        MB_LOG_WARNING("%s thread: CPU affinity only partly applied (offline CPUs?)", name);
+    }
+    return 0;
+}
+
+/**
+ * Read the placement a thread actually has
+ */
+void rtsched_query(pthread_t thread, rtsched_status_t *status)
+{
+    if (status == NULL) {
+        return;
+    }
+
+    struct sched_param param;
+
+    memset(status, 0, sizeof(*status));
+    CPU_ZERO(&status->cpus);
+    if (pthread_getaffinity_np(thread, sizeof(status->cpus), &status->cpus) != 0 ||
+        pthread_getschedparam(thread, &status->policy, &param) != 0) {
+        return;
+    }
+    status->priority = param.sched_priority;
+    status->valid = true;
+}
+
+/**
+ * Format an effective placement
+ */
+void rtsched_format(const rtsched_status_t *status, char *buf, size_t size)
+{
+    if (buf == NULL || size == 0) {
+        return;
+    }
+    buf[0] = '\0';
+    if (status == NULL || !status->valid) {
+        snprintf(buf, size, "not running");
+        return;
+    }
+
+    size_t used = 0;
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    int count = CPU_COUNT(&status->cpus);
+
+    if (online > 0 && count >= online) {
+        used = (size_t)snprintf(buf, size, "any CPU");
+    } else {
+        used = (size_t)snprintf(buf, size, "CPU%s ", count == 1 ? "" : "s");
+        bool first = true;
+        for (int cpu = 0; cpu < CPU_SETSIZE && used < size; cpu++) {
+            if (!CPU_ISSET(cpu, &status->cpus)) {
+                continue;
+            }
+            int last = cpu;
+            while (last + 1 < CPU_SETSIZE && CPU_ISSET(last + 1, &status->cpus)) {
+                last++;
+            }
+            if (last == cpu) {
+                used += (size_t)snprintf(buf + used, size - used, "%s%d", first ? "" : ",", cpu);
+            } else {
+                used += (size_t)snprintf(buf + used, size - used, "%s%d-%d", first ? "" : ",", cpu, last);
+            }
+            first = false;
+            cpu = last;
+        }
+    }
+
+    if (used < size) {
+        if (status->policy == SCHED_FIFO || status->policy == SCHED_RR) {
+            snprintf(buf + used, size - used, ", %s %d", rtsched_policy_name(status->policy),
+                     status->priority);
+        } else {
+            snprintf(buf + used, size - used, ", %s", rtsched_policy_name(status->policy));
+        }
+    }
+}
+
+/**
+ * Lock the process memory
+ */
+int rtsched_lock_memory(void)
+{
+    int ret = -1;
+
+#ifdef MCL_ONFAULT
+    ret = mlockall(MCL_CURRENT | MCL_FUTURE | MCL_ONFAULT);
+    if (ret < 0 && errno == EINVAL) {
+        /* Kernel before 4.4 */
+        ret = mlockall(MCL_CURRENT | MCL_FUTURE);
+    }
+#else
+    ret = mlockall(MCL_CURRENT | MCL_FUTURE);
+#endif
+
+    if (ret < 0) {
+        MB_LOG_WARNING("MEMLOCK: mlockall() failed: %s (raise RLIMIT_MEMLOCK or grant CAP_IPC_LOCK)",
+                      strerror(errno));
+        return ERROR_SYSTEM;
+    }
+
+    rtsched_locked = true;
+    MB_LOG_INFO("MEMLOCK: process memory locked");
+    return SUCCESS;
+}
+
+/**
+ * Check whether rtsched_lock_memory() succeeded
+ */
+bool rtsched_memory_locked(void)
+{
+    return rtsched_locked;
+}
@@ -3,9 +3,62 @@
  */
 
 #include "serial.h"
+#include "bufpool.h"
+#include "trace.h"
 #include <sys/ioctl.h>
 #include <sys/epoll.h>
+#include <linux/serial.h>
+#include <limits.h>
+#include <strings.h>
 #include <time.h>
+#include <pthread.h>
+
+#define SERIAL_TX_WAIT_MAX_MS   100     /* Re-check interval while TX is flow-blocked */
+
+static ssize_t serial_tx_pump_locked(serial_port_t *port);
+static void serial_tx_queue_open(serial_port_t *port, size_t size);
+static void serial_tx_queue_close(serial_port_t *port);
+static void serial_tx_queue_discard(serial_port_t *port);
+static void serial_tx_pace_reset_locked(serial_port_t *port, int bps);
+static void serial_tx_pace_refill_locked(serial_port_t *port);
+static void serial_untune_latency(serial_port_t *port);
+
+/* Receive profiles, by rising line rate (see serial_set_rx_profile()) */
+static const serial_rx_profile_t serial_rx_profiles[] = {
+    [RX_PROFILE_LOW]    = { "low",    2400,    1, 0, 64 },
+    [RX_PROFILE_MEDIUM] = { "medium", 19200,   1, 0, 512 },
+    [RX_PROFILE_HIGH]   = { "high",   INT_MAX, 1, 0, BUFFER_SIZE }
+};
+
+/**
+ * Monotonic clock in milliseconds
+ */
+static long long serial_monotonic_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ * Monotonic clock in nanoseconds (TX pacer)
+ */
+static uint64_t serial_monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * Sleep for a TX wait (blocking helpers only)
+ */
+static void serial_sleep_ms(int ms)
+{
+    struct timespec ts = { .tv_sec = ms / 1000, .tv_nsec = (long)(ms % 1000) * 1000000 };
+    while (nanosleep(&ts, &ts) < 0 && errno == EINTR) {
+    }
+}
 
 /**
  * Initialize serial port structure
@@ -20,6 +73,11 @@ void serial_init(serial_port_t *port)
     port->fd = -1;
     port->epoll_fd = -1;
     port->is_open = false;
+    port->latency_timer_ms = -1;
+    port->latency_timer_orig = -1;
+    port->probe_rtt_us = -1;
+    pthread_mutex_init(&port->txq.lock, NULL);
+    latency_tags_init(&port->txq.tags, NULL);
 
     /* Initialize Level 3 configuration */
     serial_init_level3_config(port);
@@ -125,6 +183,16 @@ int serial_open(serial_port_t *port, const char *device, const config_t *cfg)
 
     port->baudrate = cfg->baudrate;
     port->is_open = true;
+    port->line_pos = 0;
+    port->line_len = 0;
+
+    /* TX queue sized like the line's other buffers */
+    serial_tx_queue_open(port, serial_buffer_size_for_speed(cfg->baudrate_value, BUFFER_SIZE));
+
+    /* Receive latency: driver and USB adapter first, then the read profile */
+    port->rx_mode = cfg->serial_rx_profile;
+    serial_tune_latency(port, cfg->serial_low_latency, cfg->serial_latency_timer);
+    serial_set_rx_profile(port, cfg->baudrate_value);
 
     MB_LOG_INFO("Serial port opened successfully: %s (locked, blocking mode, epoll_fd=%d)",
                 device, port->epoll_fd);
@@ -153,6 +221,9 @@ int serial_close(serial_port_t *port)
         MB_LOG_WARNING("Failed to drop DTR");
     }
 
+    /* Give the adapter its latency settings back */
+    serial_untune_latency(port);
+
     /* Restore original terminal settings */
     if (tcsetattr(port->fd, TCSANOW, &port->oldtio) < 0) {
         MB_LOG_WARNING("Failed to restore terminal settings: %s", strerror(errno));
@@ -166,10 +237,12 @@ int serial_close(serial_port_t *port)
         port->epoll_fd = -1;
     }
 
-    /* Close file descriptor */
+    /* Close file descriptor (queued TX data is discarded, as the driver's) */
     close(port->fd);
     port->fd = -1;
     port->is_open = false;
+    port->rx_profile = NULL;
+    serial_tx_queue_close(port);
 
     /* NOTE: Port unlocking should be done by caller AFTER serial_close() */
     /* This matches modem_sample pattern where unlock_port() is called in cleanup */
@@ -346,6 +419,15 @@ int serial_set_baudrate(serial_port_t *port, speed_t baudrate)
  *   < 0: Error (ERROR_INVALID_ARG, ERROR_IO)
  */
 ssize_t serial_read(serial_port_t *port, void *buffer, size_t size)
+{
+    return serial_read_timeout(port, buffer, size, 100);  /* 100ms timeout */
+}
+
+/**
+ * Read data from serial port with caller-supplied epoll timeout
+ * timeout_ms = 0 polls without waiting (used by the multi-line workers)
+ */
+ssize_t serial_read_timeout(serial_port_t *port, void *buffer, size_t size, int timeout_ms)
 {
     struct epoll_event events[1];
     int nfds;
@@ -359,8 +441,17 @@ ssize_t serial_read(serial_port_t *port, void *buffer, size_t size)
         return ERROR_IO;
     }
 
-    /* Wait for read event with 100ms timeout */
-    nfds = epoll_wait(port->epoll_fd, events, 1, 100);  /* 100ms timeout */
+    /* Refill the driver FIFO and wake up again when it needs more */
+    if (serial_tx_pending(port) > 0) {
+        serial_tx_pump(port);
+        int tx_ms = serial_tx_next_timeout_ms(port);
+        if (tx_ms >= 0 && (timeout_ms < 0 || tx_ms < timeout_ms)) {
+            timeout_ms = tx_ms;
+        }
+    }
+
+    /* Wait for read event */
+    nfds = epoll_wait(port->epoll_fd, events, 1, timeout_ms);
 
     if (nfds < 0) {
         /* epoll_wait() error */
@@ -368,6 +459,9 @@ ssize_t serial_read(serial_port_t *port, void *buffer, size_t size)
         return ERROR_IO;
     } else if (nfds == 0) {
         /* Timeout - no data available */
+        if (serial_tx_pending(port) > 0) {
+            serial_tx_pump(port);
+        }
         return 0;
     }
 
@@ -398,11 +492,15 @@ ssize_t serial_read(serial_port_t *port, void *buffer, size_t size)
         }
 
         if (n > 0) {
-            MB_LOG_DEBUG("Serial read: %zd bytes", n);
-            hexdump("RX", buffer, n);
+            MB_TRACE_DATA(TRACE_SERIAL_RX, n, 0, buffer, n);
 
             /* Handle software flow control characters */
             serial_handle_flow_control(port, (const char *)buffer, n);
+
+            /* XON may have released queued TX data */
+            if (serial_tx_pending(port) > 0) {
+                serial_tx_pump(port);
+            }
         }
 
         return n;
@@ -417,7 +515,17 @@ ssize_t serial_read(serial_port_t *port, void *buffer, size_t size)
  */
 ssize_t serial_write(serial_port_t *port, const void *buffer, size_t size)
 {
-    ssize_t n;
+    return serial_write_stamped(port, buffer, size, NULL);
+}
+
+/**
+ * Write a stamped chunk to serial port
+ */
+ssize_t serial_write_stamped(serial_port_t *port, const void *buffer, size_t size,
+                             const latency_stamp_t *stamp)
+{
+    serial_tx_queue_t *txq;
+    size_t accepted;
 
     if (port == NULL) {
         MB_LOG_ERROR("serial_write: port is NULL");
@@ -437,42 +545,66 @@ ssize_t serial_write(serial_port_t *port, const void *buffer, size_t size)
         return ERROR_IO;
     }
 
-    /* Check flow control before writing */
-    if (serial_is_tx_blocked(port)) {
-        MB_LOG_DEBUG("Serial write blocked by flow control");
-        return 0;  /* Indicate no bytes written due to flow control */
+    txq = &port->txq;
+    if (txq->data == NULL) {
+        /* No queue storage: write straight to the driver */
+        if (serial_is_tx_blocked(port)) {
+            MB_LOG_DEBUG("Serial write blocked by flow control");
+            return 0;
+        }
+        ssize_t n = write(port->fd, buffer, size);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return 0;
+            }
+            MB_LOG_ERROR("Serial write error: %s", strerror(errno));
+            return ERROR_IO;
+        }
+        return n;
     }
 
     MB_LOG_DEBUG("Serial write: %zu bytes to fd=%d", size, port->fd);
-    hexdump("TX", buffer, size);
 
-    n = write(port->fd, buffer, size);
-    if (n < 0) {
-        if (errno == EAGAIN || errno == EWOULDBLOCK) {
-            /* Would block (shouldn't happen often on serial ports) */
-            return 0;
-        }
-        MB_LOG_ERROR("Serial write error: %s", strerror(errno));
-        return ERROR_IO;
+    pthread_mutex_lock(&txq->lock);
+
+    /* Settle the pacer first so idle time before this write is not counted busy */
+    serial_tx_pace_refill_locked(port);
+
+    /* Append as much as fits; the caller keeps the rest (backpressure) */
+    accepted = MIN(size, txq->capacity - (txq->head - txq->tail));
+    size_t offset = txq->head & (txq->capacity - 1);
+    size_t first = MIN(accepted, txq->capacity - offset);
+    memcpy(txq->data + offset, buffer, first);
+    memcpy(txq->data, (const unsigned char *)buffer + first, accepted - first);
+    txq->head += accepted;
+    txq->high_water = MAX(txq->high_water, txq->head - txq->tail);
+    latency_tags_push(&txq->tags, accepted, (stamp != NULL) ? stamp->ingress_ns : 0,
+                      METRICS_STAGE_PROCESS, (stamp != NULL) ? stamp->handoff_ns : 0);
+    if (accepted < size) {
+        txq->full_events++;
     }
 
-    /* Wait for data to be transmitted */
-    tcdrain(port->fd);
+    ssize_t ret = serial_tx_pump_locked(port);
+    size_t queued = txq->head - txq->tail;
+
+    pthread_mutex_unlock(&txq->lock);
 
-    return n;
+    MB_TRACE_DATA(TRACE_SERIAL_TX, accepted, queued, buffer, accepted);
+
+    if (ret < 0) {
+        return ret;
+    }
+    return (ssize_t)accepted;
 }
 
 /**
- * Write data to serial port using epoll for write readiness
- * Enhanced for timestamp transmission with partial write handling
+ * Write data to serial port, waiting for TX queue space
  */
 ssize_t serial_write_with_epoll(serial_port_t *port, const void *buffer, size_t size, int timeout_ms)
 {
-    struct epoll_event ev, events[1];
-    int nfds;
-    ssize_t total_written = 0;
-    ssize_t n;
     const unsigned char *data = (const unsigned char *)buffer;
+    ssize_t total_written = 0;
+    long long deadline;
 
     if (port == NULL) {
         MB_LOG_ERROR("serial_write_with_epoll: port is NULL");
@@ -482,87 +614,38 @@ ssize_t serial_write_with_epoll(serial_port_t *port, const void *buffer, size_t
         MB_LOG_ERROR("serial_write_with_epoll: buffer is NULL");
         return ERROR_INVALID_ARG;
     }
-    if (port->fd < 0) {
-        MB_LOG_ERROR("serial_write_with_epoll: invalid fd=%d", port->fd);
-        return ERROR_INVALID_ARG;
-    }
-
-    if (!port->is_open || port->epoll_fd < 0) {
-        MB_LOG_ERROR("serial_write_with_epoll: port is not open or epoll_fd invalid");
-        return ERROR_IO;
-    }
 
     MB_LOG_DEBUG("Serial write with epoll: %zu bytes to fd=%d (timeout=%dms)", size, port->fd, timeout_ms);
 
-    /* Temporarily modify epoll to monitor EPOLLOUT */
-    ev.events = EPOLLIN | EPOLLOUT | EPOLLERR | EPOLLHUP;
-    ev.data.fd = port->fd;
-
-    if (epoll_ctl(port->epoll_fd, EPOLL_CTL_MOD, port->fd, &ev) < 0) {
-        MB_LOG_ERROR("epoll_ctl(MOD for EPOLLOUT) failed: %s", strerror(errno));
-        return ERROR_IO;
-    }
+    deadline = (timeout_ms < 0) ? -1 : serial_monotonic_ms() + timeout_ms;
 
-    /* Write loop with partial write handling */
     while (total_written < (ssize_t)size) {
-        /* Wait for write readiness */
-        nfds = epoll_wait(port->epoll_fd, events, 1, timeout_ms);
-
-        if (nfds < 0) {
-            MB_LOG_ERROR("epoll_wait() failed: %s", strerror(errno));
-            /* Restore epoll to read-only before returning */
-            ev.events = EPOLLIN | EPOLLERR | EPOLLHUP;
-            epoll_ctl(port->epoll_fd, EPOLL_CTL_MOD, port->fd, &ev);
-            return ERROR_IO;
-        } else if (nfds == 0) {
-            /* Timeout */
+        ssize_t n = serial_write(port, data + total_written, size - total_written);
+        if (n < 0) {
+            return (total_written > 0) ? total_written : n;
+        }
+        total_written += n;
+        if (total_written == (ssize_t)size) {
+            break;
+        }
+
+        /* Queue full: wait for the driver to drain */
+        long long now = serial_monotonic_ms();
+        if (deadline >= 0 && now >= deadline) {
             MB_LOG_WARNING("Write timeout after %d bytes", (int)total_written);
-            /* Restore epoll to read-only before returning */
-            ev.events = EPOLLIN | EPOLLERR | EPOLLHUP;
-            epoll_ctl(port->epoll_fd, EPOLL_CTL_MOD, port->fd, &ev);
             return (total_written > 0) ? total_written : ERROR_TIMEOUT;
         }
-
-        /* Check for error or hangup events */
-        if (events[0].events & (EPOLLERR | EPOLLHUP)) {
-            MB_LOG_ERROR("Serial port error or hangup during write (events=0x%x)", events[0].events);
-            /* Restore epoll to read-only before returning */
-            ev.events = EPOLLIN | EPOLLERR | EPOLLHUP;
-            epoll_ctl(port->epoll_fd, EPOLL_CTL_MOD, port->fd, &ev);
-            return ERROR_IO;
+        int wait_ms = serial_tx_next_timeout_ms(port);
+        if (wait_ms < 0 || wait_ms > SERIAL_TX_WAIT_MAX_MS) {
+            wait_ms = SERIAL_TX_WAIT_MAX_MS;  /* Blocked by XOFF/CTS: re-check */
         }
-
-        /* Write data if EPOLLOUT is set */
-        if (events[0].events & EPOLLOUT) {
-            n = write(port->fd, data + total_written, size - total_written);
-
-            if (n < 0) {
-                if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                    /* Would block - continue epoll loop */
-                    continue;
-                }
-                MB_LOG_ERROR("Serial write error: %s", strerror(errno));
-                /* Restore epoll to read-only before returning */
-                ev.events = EPOLLIN | EPOLLERR | EPOLLHUP;
-                epoll_ctl(port->epoll_fd, EPOLL_CTL_MOD, port->fd, &ev);
-                return ERROR_IO;
-            }
-
-            total_written += n;
-            MB_LOG_DEBUG("Wrote %zd bytes (%zd/%zu total)", n, total_written, size);
+        wait_ms = MAX(wait_ms, 1);
+        if (deadline >= 0) {
+            wait_ms = (int)MIN((long long)wait_ms, deadline - now);
         }
+        serial_sleep_ms(wait_ms);
     }
 
-    /* Restore epoll to read-only mode */
-    ev.events = EPOLLIN | EPOLLERR | EPOLLHUP;
-    if (epoll_ctl(port->epoll_fd, EPOLL_CTL_MOD, port->fd, &ev) < 0) {
-        MB_LOG_WARNING("epoll_ctl(MOD restore to read-only) failed: %s", strerror(errno));
-        /* Not fatal - write succeeded */
-    }
-
-    /* Wait for data to be transmitted */
-    tcdrain(port->fd);
-
     MB_LOG_DEBUG("Serial write with epoll completed: %zd bytes", total_written);
     return total_written;
 }
@@ -580,6 +663,11 @@ int serial_flush(serial_port_t *port, int queue_selector)
         return ERROR_IO;
     }
 
+    /* Output flushes also drop bytes still waiting in the TX queue */
+    if (queue_selector == TCOFLUSH || queue_selector == TCIOFLUSH) {
+        serial_tx_queue_discard(port);
+    }
+
     if (tcflush(port->fd, queue_selector) < 0) {
         MB_LOG_ERROR("Failed to flush serial buffers: %s", strerror(errno));
         return ERROR_IO;
@@ -743,8 +831,21 @@ bool serial_is_open(serial_port_t *port)
  * Extended functions from modem_sample
  * ======================================================================== */
 
-/* Global state for port locking */
-static char g_lock_file[256] = {0};
+/* Global state for port locking (one slot per locked device, multi-line mode) */
+#define SERIAL_MAX_LOCKS 64
+static char g_lock_files[SERIAL_MAX_LOCKS][256];
+static pthread_mutex_t g_lock_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Build UUCP lock file path for a device (/dev/ttyUSB0 -> /var/lock/LCK..ttyUSB0)
+ */
+static void serial_lock_path(const char *device, char *path, size_t size)
+{
+    const char *devname = strrchr(device, '/');
+
+    devname = devname ? devname + 1 : device;
+    snprintf(path, size, "/var/lock/LCK..%s", devname);
+}
 
 /**
  * Read a line from serial port (until \r or \n)
@@ -752,17 +853,48 @@ static char g_lock_file[256] = {0};
  */
 ssize_t serial_read_line(serial_port_t *port, char *buffer, size_t size, int timeout_sec)
 {
-    static char read_buffer[512];     /* Internal buffer for accumulating data */
-    static size_t buf_pos = 0;        /* Current position in read_buffer */
-    static size_t buf_len = 0;        /* Amount of data in read_buffer */
+    return serial_read_line_ms(port, buffer, size, timeout_sec * 1000);
+}
 
-    char chunk[128];                  /* Temporary buffer for reading chunks */
-    time_t start_time, current_time;
-    int remaining_timeout;
-    ssize_t rc;
-    size_t i;
+/**
+ * Take one line out of the port's line buffer (-1 if it holds no complete line)
+ */
+static ssize_t serial_line_take(serial_port_t *port, char *buffer, size_t size)
+{
+    for (size_t i = port->line_pos; i < port->line_len; i++) {
+        char c = port->line_buf[i];
+        if (c != '\n' && c != '\r') {
+            continue;
+        }
+
+        size_t copy_len = MIN(i - port->line_pos, size - 1);
+        memcpy(buffer, &port->line_buf[port->line_pos], copy_len);
+        buffer[copy_len] = '\0';
+
+        /* Skip the terminator and any CR/LF that follows it */
+        port->line_pos = i + 1;
+        while (port->line_pos < port->line_len &&
+               (port->line_buf[port->line_pos] == '\r' || port->line_buf[port->line_pos] == '\n')) {
+            port->line_pos++;
+        }
+        if (port->line_pos >= port->line_len) {
+            port->line_pos = 0;
+            port->line_len = 0;
+        }
+
+        MB_LOG_DEBUG("serial_read_line: read line (%zu bytes): %s", copy_len, buffer);
+        return (ssize_t)copy_len;
+    }
 
-    if (port == NULL || buffer == NULL || size <= 0) {
+    return -1;
+}
+
+/**
+ * Read a line from serial port with a millisecond timeout
+ */
+ssize_t serial_read_line_ms(serial_port_t *port, char *buffer, size_t size, int timeout_ms)
+{
+    if (port == NULL || buffer == NULL || size == 0) {
         return ERROR_INVALID_ARG;
     }
 
@@ -770,138 +902,74 @@ ssize_t serial_read_line(serial_port_t *port, char *buffer, size_t size, int tim
         return ERROR_IO;
     }
 
-    start_time = time(NULL);
+    long long deadline = serial_monotonic_ms() + timeout_ms;
     buffer[0] = '\0';
 
-    while (1) {
-        /* First, check if we have a complete line in the buffer */
-        for (i = buf_pos; i < buf_len; i++) {
-            char c = read_buffer[i];
-
-            /* Check for line terminators */
-            if (c == '\n' || c == '\r') {
-                /* Found line terminator - copy line to output buffer */
-                size_t copy_len = i - buf_pos;
-                if (copy_len > size - 1) {
-                    copy_len = size - 1;
-                }
-
-                if (copy_len > 0) {
-                    memcpy(buffer, &read_buffer[buf_pos], copy_len);
-                }
-                buffer[copy_len] = '\0';
-
-                /* Skip the line terminator(s) */
-                buf_pos = i + 1;
-
-                /* Skip additional CR/LF if present */
-                while (buf_pos < buf_len &&
-                       (read_buffer[buf_pos] == '\r' || read_buffer[buf_pos] == '\n')) {
-                    buf_pos++;
-                }
-
-                /* If we consumed all buffered data, reset buffer */
-                if (buf_pos >= buf_len) {
-                    buf_pos = 0;
-                    buf_len = 0;
-                }
-
-                MB_LOG_DEBUG("serial_read_line: read line (%zu bytes): %s", copy_len, buffer);
-                return (ssize_t)copy_len;
-            }
-        }
-
-        /* No complete line found - need to read more data */
-        current_time = time(NULL);
-        remaining_timeout = timeout_sec - (current_time - start_time);
-
-        if (remaining_timeout <= 0) {
-            /* Timeout - return any partial data we have */
-            if (buf_len > buf_pos) {
-                size_t copy_len = buf_len - buf_pos;
-                if (copy_len > size - 1) {
-                    copy_len = size - 1;
-                }
-                memcpy(buffer, &read_buffer[buf_pos], copy_len);
-                buffer[copy_len] = '\0';
-                buf_pos = 0;
-                buf_len = 0;
-                MB_LOG_DEBUG("serial_read_line: timeout with partial data (%zu bytes)", copy_len);
-                return ERROR_TIMEOUT;
-            }
-            MB_LOG_DEBUG("serial_read_line: timeout");
-            return ERROR_TIMEOUT;
+    for (;;) {
+        ssize_t line = serial_line_take(port, buffer, size);
+        if (line >= 0) {
+            return line;
         }
 
-        /* Compact buffer if needed (move remaining data to beginning) */
-        if (buf_pos > 0) {
-            if (buf_len > buf_pos) {
-                memmove(read_buffer, &read_buffer[buf_pos], buf_len - buf_pos);
-                buf_len -= buf_pos;
-            } else {
-                buf_len = 0;
-            }
-            buf_pos = 0;
+        /* Compact: move the partial line to the front */
+        if (port->line_pos > 0) {
+            memmove(port->line_buf, &port->line_buf[port->line_pos], port->line_len - port->line_pos);
+            port->line_len -= port->line_pos;
+            port->line_pos = 0;
         }
 
-        /* Check if buffer is full without finding line terminator */
-        if (buf_len >= sizeof(read_buffer) - 1) {
-            /* Buffer overflow - return what we have and reset */
-            size_t copy_len = (buf_len > size - 1) ? size - 1 : buf_len;
-            memcpy(buffer, read_buffer, copy_len);
+        /* Full without a terminator: return what we have */
+        if (port->line_len >= sizeof(port->line_buf)) {
+            size_t copy_len = MIN(port->line_len, size - 1);
+            memcpy(buffer, port->line_buf, copy_len);
             buffer[copy_len] = '\0';
-            buf_pos = 0;
-            buf_len = 0;
+            port->line_len = 0;
             MB_LOG_WARNING("serial_read_line: buffer overflow, returning %zu bytes", copy_len);
             return (ssize_t)copy_len;
         }
 
-        /* Read more data using select() for timeout */
-        fd_set readfds;
-        struct timeval tv;
-
-        FD_ZERO(&readfds);
-        FD_SET(port->fd, &readfds);
-
-        tv.tv_sec = (remaining_timeout > 1) ? 1 : remaining_timeout;
-        tv.tv_usec = 0;
-
-        int sel = select(port->fd + 1, &readfds, NULL, NULL, &tv);
-
-        if (sel < 0) {
-            MB_LOG_ERROR("select() failed: %s", strerror(errno));
-            return ERROR_IO;
-        } else if (sel == 0) {
-            /* Timeout on this select - continue loop to check overall timeout */
-            continue;
+        int remaining = (int)(deadline - serial_monotonic_ms());
+        if (remaining <= 0) {
+            /* Timeout - hand back any partial data */
+            if (port->line_len > 0) {
+                size_t copy_len = MIN(port->line_len, size - 1);
+                memcpy(buffer, port->line_buf, copy_len);
+                buffer[copy_len] = '\0';
+                port->line_len = 0;
+                MB_LOG_DEBUG("serial_read_line: timeout with partial data (%zu bytes)", copy_len);
+            } else {
+                MB_LOG_DEBUG("serial_read_line: timeout");
+            }
+            return ERROR_TIMEOUT;
         }
 
-        /* Data available - read chunk */
-        rc = read(port->fd, chunk, sizeof(chunk) - 1);
-
+        /* Wait on the port's epoll (this also drains queued TX data) */
+        ssize_t rc = serial_read_timeout(port, &port->line_buf[port->line_len],
+                                         sizeof(port->line_buf) - port->line_len, remaining);
         if (rc < 0) {
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                /* Shouldn't happen since select said readable, but handle anyway */
-                continue;
-            }
-            MB_LOG_ERROR("read() failed: %s", strerror(errno));
             return ERROR_IO;
-        } else if (rc > 0) {
-            /* Got some data - append to buffer */
-            size_t space_left = sizeof(read_buffer) - buf_len;
-            size_t copy_len = ((size_t)rc > space_left) ? space_left : (size_t)rc;
-
-            if (copy_len > 0) {
-                memcpy(&read_buffer[buf_len], chunk, copy_len);
-                buf_len += copy_len;
-            }
-
-            /* Continue loop to check if we now have a complete line */
         }
+        port->line_len += (size_t)rc;
+    }
+}
+
+/**
+ * Take the bytes serial_read_line() has buffered but not returned
+ */
+size_t serial_line_flush(serial_port_t *port, char *buffer, size_t size)
+{
+    if (port == NULL) {
+        return 0;
     }
 
-    /* Should never reach here */
-    return ERROR_IO;
+    size_t pending = port->line_len - port->line_pos;
+    if (buffer != NULL && size > 0) {
+        pending = MIN(pending, size);
+        memcpy(buffer, &port->line_buf[port->line_pos], pending);
+    }
+    port->line_pos = 0;
+    port->line_len = 0;
+    return pending;
 }
 
 /**
@@ -912,38 +980,53 @@ int serial_lock_port(const char *device)
 {
     FILE *fp;
     pid_t pid;
-    const char *devname;
+    char lock_file[256];
+    int slot = -1;
 
     if (device == NULL) {
         return ERROR_INVALID_ARG;
     }
 
-    /* Extract device name (ttyUSB0 from /dev/ttyUSB0) */
-    devname = strrchr(device, '/');
-    if (devname) {
-        devname++;
-    } else {
-        devname = device;
+    /* Create lock file path */
+    serial_lock_path(device, lock_file, sizeof(lock_file));
+
+    pthread_mutex_lock(&g_lock_mutex);
+
+    /* Find a free slot; refuse a device this process already holds */
+    for (int i = 0; i < SERIAL_MAX_LOCKS; i++) {
+        if (g_lock_files[i][0] == '\0') {
+            if (slot < 0) {
+                slot = i;
+            }
+        } else if (strcmp(g_lock_files[i], lock_file) == 0) {
+            pthread_mutex_unlock(&g_lock_mutex);
+            MB_LOG_ERROR("Port already locked by this process: %s", device);
+            return ERROR_IO;
+        }
     }
 
-    /* Create lock file path */
-    snprintf(g_lock_file, sizeof(g_lock_file), "/var/lock/LCK..%s", devname);
+    if (slot < 0) {
+        pthread_mutex_unlock(&g_lock_mutex);
+        MB_LOG_ERROR("Too many locked serial ports (max %d)", SERIAL_MAX_LOCKS);
+        return ERROR_IO;
+    }
 
     /* Check if lock file exists */
-    if (access(g_lock_file, F_OK) == 0) {
+    if (access(lock_file, F_OK) == 0) {
         /* Read PID from lock file */
-        fp = fopen(g_lock_file, "r");
+        fp = fopen(lock_file, "r");
         if (fp) {
             if (fscanf(fp, "%d", &pid) == 1) {
                 /* Check if process is still running */
                 if (kill(pid, 0) == 0) {
                     fclose(fp);
+                    pthread_mutex_unlock(&g_lock_mutex);
                     MB_LOG_ERROR("Port locked by process %d", pid);
                     return ERROR_IO;
                 } else {
                     /* Stale lock - remove it */
                     MB_LOG_INFO("Removing stale lock file (PID %d not running)", pid);
-                    unlink(g_lock_file);
+                    unlink(lock_file);
                 }
             }
             fclose(fp);
@@ -951,34 +1034,68 @@ int serial_lock_port(const char *device)
     }
 
     /* Create lock file */
-    fp = fopen(g_lock_file, "w");
+    fp = fopen(lock_file, "w");
     if (!fp) {
         /* If we can't create lock file (no permissions), just warn and continue */
-        MB_LOG_WARNING("Cannot create lock file %s: %s", g_lock_file, strerror(errno));
+        pthread_mutex_unlock(&g_lock_mutex);
+        MB_LOG_WARNING("Cannot create lock file %s: %s", lock_file, strerror(errno));
         MB_LOG_WARNING("Continuing without port locking...");
-        g_lock_file[0] = '\0';
         return SUCCESS;
     }
 
     fprintf(fp, "%10d\n", getpid());
     fclose(fp);
 
-    MB_LOG_INFO("Port locked: %s", g_lock_file);
+    memcpy(g_lock_files[slot], lock_file, sizeof(g_lock_files[slot]));
+    pthread_mutex_unlock(&g_lock_mutex);
+
+    MB_LOG_INFO("Port locked: %s", lock_file);
     return SUCCESS;
 }
 
+/**
+ * Unlock a single serial port
+ */
+void serial_unlock_device(const char *device)
+{
+    char lock_file[256];
+
+    if (device == NULL) {
+        return;
+    }
+
+    serial_lock_path(device, lock_file, sizeof(lock_file));
+
+    pthread_mutex_lock(&g_lock_mutex);
+    for (int i = 0; i < SERIAL_MAX_LOCKS; i++) {
+        if (strcmp(g_lock_files[i], lock_file) == 0) {
+            if (unlink(g_lock_files[i]) == 0) {
+                MB_LOG_INFO("Port unlocked: %s", g_lock_files[i]);
+            }
+            g_lock_files[i][0] = '\0';
+            break;
+        }
+    }
+    pthread_mutex_unlock(&g_lock_mutex);
+}
+
 /**
  * Unlock serial port
  * Based on modem_sample/serial_port.c:unlock_port()
+ * Releases every lock held by this process
  */
 void serial_unlock_port(void)
 {
-    if (g_lock_file[0] != '\0') {
-        if (unlink(g_lock_file) == 0) {
-            MB_LOG_INFO("Port unlocked: %s", g_lock_file);
+    pthread_mutex_lock(&g_lock_mutex);
+    for (int i = 0; i < SERIAL_MAX_LOCKS; i++) {
+        if (g_lock_files[i][0] != '\0') {
+            if (unlink(g_lock_files[i]) == 0) {
+                MB_LOG_INFO("Port unlocked: %s", g_lock_files[i]);
+            }
+            g_lock_files[i][0] = '\0';
         }
-        g_lock_file[0] = '\0';
     }
+    pthread_mutex_unlock(&g_lock_mutex);
 }
 
 /**
@@ -1250,13 +1367,13 @@ ssize_t serial_write_buffered(serial_port_t *port, const void *buffer, size_t si
         }
     }
 
-    /* Transmit data in chunks */
+    /* Transmit data in chunks through the TX queue; pacing comes from the
+     * driver FIFO fill, so there are no fixed delays between chunks */
     while (remaining > 0) {
         /* Calculate chunk size */
         chunk_size = (remaining > TX_CHUNK_SIZE) ? TX_CHUNK_SIZE : remaining;
 
-        /* Send chunk using robust write */
-        rc = serial_write_robust(port, data + total_sent, chunk_size);
+        rc = serial_write_with_epoll(port, data + total_sent, chunk_size, -1);
 
         if (rc < 0) {
             MB_LOG_ERROR("Chunk transmission failed at offset %zd: %s",
@@ -1281,17 +1398,13 @@ ssize_t serial_write_buffered(serial_port_t *port, const void *buffer, size_t si
                         total_sent, size, (100.0 * total_sent) / size);
         }
 
-        /* Delay between chunks to prevent buffer overflow (modem_sample pattern) */
-        if (remaining > 0) {
-            usleep(TX_CHUNK_DELAY_US);  /* 10ms delay */
-        }
-
         /* Check carrier periodically */
         if (total_sent % (TX_CHUNK_SIZE * 4) == 0) {
             if (serial_check_carrier(port, &carrier) == SUCCESS) {
                 if (!carrier) {
                     MB_LOG_ERROR("Carrier lost during transmission at %zd bytes",
                                 total_sent);
+                    serial_tx_queue_discard(port);
 
                     if (total_sent > 0) {
                         return total_sent;  /* Return partial success */
@@ -1306,8 +1419,8 @@ ssize_t serial_write_buffered(serial_port_t *port, const void *buffer, size_t si
     MB_LOG_INFO("Buffered transmission completed: %zd bytes sent successfully",
                 total_sent);
 
-    /* Final tcdrain to ensure all data is transmitted */
-    tcdrain(port->fd);
+    /* Wait until everything has left the UART */
+    serial_tx_drain(port, -1);
 
     return total_sent;
 }
@@ -1654,78 +1767,358 @@ int serial_send_xoff(serial_port_t *port)
 }
 
 /**
- * Get optimal buffer size for current speed and flow control
+ * Numeric line rate for a termios speed (0 if unknown)
  */
-size_t serial_get_optimal_buffer_size(serial_port_t *port, bool is_tx)
+static int serial_speed_t_to_baudrate(speed_t speed)
 {
-    if (port == NULL) {
-        return 1024;  /* Safe default */
+    switch (speed) {
+        case B300:    return 300;
+        case B1200:   return 1200;
+        case B2400:   return 2400;
+        case B4800:   return 4800;
+        case B9600:   return 9600;
+        case B19200:  return 19200;
+        case B38400:  return 38400;
+        case B57600:  return 57600;
+        case B115200: return 115200;
+        case B230400: return 230400;
+        default:      return 0;
     }
+}
 
-    size_t base_size = is_tx ? port->l3_config.tx_buffer_size : port->l3_config.rx_buffer_size;
+/* ========================================================================
+ * Receive Latency Tuning
+ * ======================================================================== */
 
-    /* Adjust for low-speed optimizations */
-    if (port->l3_config.low_speed_optimization) {
-        return base_size;  /* Already adjusted for low speed */
-    }
+/**
+ * Find the sysfs latency_timer of a USB serial adapter
+ * @return SUCCESS if the attribute exists (path set)
+ */
+static int serial_latency_timer_find(const char *device, char *path, size_t size)
+{
+    char real[PATH_MAX];
 
-    /* Adjust based on current baudrate */
-    if (port->baudrate <= B1200) {
-        return 512;   /* Very small for 1200 bps */
-    } else if (port->baudrate <= B2400) {
-        return 1024;  /* Small for 2400 bps */
-    } else if (port->baudrate <= B9600) {
-        return 2048;  /* Medium for 9600 bps */
-    } else {
-        return base_size;  /* Full size for higher speeds */
+    /* Follow /dev/serial/by-id links to the ttyUSBn node */
+    if (realpath(device, real) == NULL) {
+        return ERROR_IO;
     }
+    const char *name = strrchr(real, '/');
+    name = (name != NULL) ? name + 1 : real;
+
+    snprintf(path, size, "/sys/class/tty/%.64s/device/latency_timer", name);
+    return access(path, F_OK) == 0 ? SUCCESS : ERROR_IO;
 }
 
 /**
- * Calculate transmission delay for current baudrate
+ * Read a sysfs latency_timer (-1 on error)
  */
-useconds_t serial_calculate_tx_delay(serial_port_t *port, size_t bytes)
+static int serial_latency_timer_read(const char *path)
 {
-    if (port == NULL || port->baudrate == 0) {
-        return 1000;  /* 1ms default */
-    }
+    FILE *fp = fopen(path, "r");
+    int value = -1;
 
-    /* Calculate bits to transmit (8 data bits + 1 start bit + 1 stop bit = 10 bits per byte) */
-    double bits_per_byte = 10.0;
-    double total_bits = bytes * bits_per_byte;
-    double baudrate = (double)port->baudrate;
-    
-    /* Calculate transmission time in microseconds */
-    double delay_us = (total_bits / baudrate) * 1000000.0;
-    
-    /* Add safety margin (20% extra) */
-    delay_us *= 1.2;
-    
-    /* Add minimum delay for system overhead */
-    if (delay_us < 500) {
-        delay_us = 500;  /* Minimum 0.5ms */
+    if (fp == NULL) {
+        return -1;
     }
-    
-    /* Cap maximum delay */
-    if (delay_us > 5000000) {
-        delay_us = 5000000;  /* Maximum 5 seconds */
+    if (fscanf(fp, "%d", &value) != 1) {
+        value = -1;
     }
-    
-    return (useconds_t)delay_us;
+    fclose(fp);
+    return value;
 }
 
-/* ========================================================================
- * Level 1 Dynamic Baudrate Adjustment Functions (modem_sample integration)
- * ======================================================================== */
-
 /**
- * Dynamically adjust serial port speed based on modem connection
- * Based on modem_sample/serial_port.c:adjust_serial_speed()
+ * Write a sysfs latency_timer
  */
-int serial_adjust_baudrate_dynamically(serial_port_t *port, int target_speed)
+static int serial_latency_timer_write(const char *path, int ms)
 {
-    speed_t new_speed;
-    int rc;
+    FILE *fp = fopen(path, "w");
+
+    if (fp == NULL) {
+        return ERROR_IO;
+    }
+    int ok = fprintf(fp, "%d\n", ms) > 0;
+    if (fclose(fp) != 0) {
+        ok = 0;
+    }
+    return ok ? SUCCESS : ERROR_IO;
+}
+
+/**
+ * Set or clear ASYNC_LOW_LATENCY
+ * @param changed Set to true if the flag was changed (may be NULL)
+ * @return SUCCESS, ERROR_IO if TIOCSSERIAL failed, ERROR_GENERAL if the
+ *         driver has no serial_struct (not a UART-like port)
+ */
+static int serial_set_async_low_latency(serial_port_t *port, bool enable, bool *changed)
+{
+    struct serial_struct ss;
+
+    if (changed != NULL) {
+        *changed = false;
+    }
+    if (ioctl(port->fd, TIOCGSERIAL, &ss) < 0) {
+        return ERROR_GENERAL;
+    }
+    if (((ss.flags & ASYNC_LOW_LATENCY) != 0) == enable) {
+        return SUCCESS;
+    }
+    if (changed != NULL) {
+        *changed = true;
+    }
+
+    if (enable) {
+        ss.flags |= ASYNC_LOW_LATENCY;
+    } else {
+        ss.flags &= ~ASYNC_LOW_LATENCY;
+    }
+    return ioctl(port->fd, TIOCSSERIAL, &ss) < 0 ? ERROR_IO : SUCCESS;
+}
+
+/**
+ * Cut the receive latency of the port
+ */
+int serial_tune_latency(serial_port_t *port, bool low_latency, int latency_timer_ms)
+{
+    int ret = SUCCESS;
+
+    if (port == NULL || port->fd < 0) {
+        return ERROR_INVALID_ARG;
+    }
+
+    if (low_latency) {
+        bool changed;
+        int rc = serial_set_async_low_latency(port, true, &changed);
+        if (rc == SUCCESS) {
+            port->low_latency = true;
+            port->low_latency_set = changed;
+            MB_LOG_DEBUG("%s: ASYNC_LOW_LATENCY set", port->device);
+        } else if (rc == ERROR_IO) {
+            MB_LOG_WARNING("%s: cannot set ASYNC_LOW_LATENCY: %s", port->device, strerror(errno));
+            ret = ERROR_IO;
+        } else {
+            MB_LOG_DEBUG("%s: no TIOCGSERIAL, ASYNC_LOW_LATENCY not available", port->device);
+        }
+    }
+
+    /* FTDI-style adapters hold partly filled packets for latency_timer ms */
+    if (serial_latency_timer_find(port->device, port->latency_timer_path,
+                                  sizeof(port->latency_timer_path)) != SUCCESS) {
+        port->latency_timer_path[0] = '\0';
+        port->latency_timer_ms = -1;
+        MB_LOG_DEBUG("%s: no USB latency_timer (not an FTDI-style adapter)", port->device);
+        return ret;
+    }
+
+    port->latency_timer_ms = serial_latency_timer_read(port->latency_timer_path);
+    if (latency_timer_ms > 0 && port->latency_timer_ms != latency_timer_ms) {
+        int before = port->latency_timer_ms;
+        if (serial_latency_timer_write(port->latency_timer_path, latency_timer_ms) == SUCCESS) {
+            port->latency_timer_orig = before;
+            port->latency_timer_ms = latency_timer_ms;
+            MB_LOG_INFO("%s: USB latency_timer %d -> %d ms", port->device, before, latency_timer_ms);
+        } else {
+            MB_LOG_WARNING("%s: cannot write %s: %s (latency_timer stays %d ms)",
+                          port->device, port->latency_timer_path, strerror(errno), before);
+            ret = ERROR_IO;
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * Put back the latency settings changed by serial_tune_latency()
+ */
+static void serial_untune_latency(serial_port_t *port)
+{
+    if (port->low_latency_set) {
+        serial_set_async_low_latency(port, false, NULL);
+        port->low_latency_set = false;
+    }
+    port->low_latency = false;
+
+    if (port->latency_timer_orig > 0 && port->latency_timer_path[0] != '\0') {
+        if (serial_latency_timer_write(port->latency_timer_path, port->latency_timer_orig) != SUCCESS) {
+            MB_LOG_WARNING("%s: cannot restore latency_timer to %d ms", port->device,
+                          port->latency_timer_orig);
+        }
+        port->latency_timer_orig = -1;
+    }
+    port->latency_timer_ms = -1;
+}
+
+/**
+ * Apply the receive profile for a line rate
+ */
+int serial_set_rx_profile(serial_port_t *port, int bps)
+{
+    if (port == NULL || port->fd < 0) {
+        return ERROR_INVALID_ARG;
+    }
+
+    rx_profile_t id = port->rx_mode;
+    if (id == RX_PROFILE_AUTO) {
+        id = RX_PROFILE_LOW;
+        while (id < RX_PROFILE_HIGH && bps > serial_rx_profiles[id].max_bps) {
+            id++;
+        }
+    }
+
+    const serial_rx_profile_t *profile = &serial_rx_profiles[id];
+    if (port->rx_profile == profile) {
+        return SUCCESS;
+    }
+
+    if (port->newtio.c_cc[VMIN] != profile->vmin || port->newtio.c_cc[VTIME] != profile->vtime) {
+        struct termios tio = port->newtio;
+        tio.c_cc[VMIN] = profile->vmin;
+        tio.c_cc[VTIME] = profile->vtime;
+        if (tcsetattr(port->fd, TCSANOW, &tio) < 0) {
+            MB_LOG_ERROR("Failed to apply receive profile %s: %s", profile->name, strerror(errno));
+            return ERROR_IO;
+        }
+        port->newtio = tio;
+    }
+
+    port->rx_profile = profile;
+    MB_LOG_INFO("%s: receive profile %s at %d bps (VMIN=%d VTIME=%d, %zu-byte reads)",
+                port->device, profile->name, bps, profile->vmin, profile->vtime, profile->read_size);
+    return SUCCESS;
+}
+
+/**
+ * Bytes to read per pass under the current receive profile
+ */
+size_t serial_rx_read_size(const serial_port_t *port, size_t buffer_size)
+{
+    if (port == NULL || port->rx_profile == NULL) {
+        return buffer_size;
+    }
+    return MIN(buffer_size, port->rx_profile->read_size);
+}
+
+/**
+ * Parse a SERIAL_RX_PROFILE name
+ */
+int serial_parse_rx_profile(const char *name, rx_profile_t *profile)
+{
+    if (name == NULL || profile == NULL) {
+        return ERROR_INVALID_ARG;
+    }
+
+    if (strcasecmp(name, "auto") == 0) {
+        *profile = RX_PROFILE_AUTO;
+        return SUCCESS;
+    }
+    for (int id = RX_PROFILE_LOW; id <= RX_PROFILE_HIGH; id++) {
+        if (strcasecmp(name, serial_rx_profiles[id].name) == 0) {
+            *profile = (rx_profile_t)id;
+            return SUCCESS;
+        }
+    }
+    return ERROR_CONFIG;
+}
+
+/**
+ * Name of a SERIAL_RX_PROFILE setting
+ */
+const char *serial_rx_profile_name(rx_profile_t profile)
+{
+    if (profile < RX_PROFILE_LOW || profile > RX_PROFILE_HIGH) {
+        return "auto";
+    }
+    return serial_rx_profiles[profile].name;
+}
+
+/**
+ * Buffer size for a line rate
+ */
+size_t serial_buffer_size_for_speed(int bps, size_t base_size)
+{
+    if (bps <= 0) {
+        return base_size;  /* Unknown rate */
+    }
+
+    if (bps <= 1200) {
+        return 512;   /* Very small for 1200 bps */
+    } else if (bps <= 2400) {
+        return 1024;  /* Small for 2400 bps */
+    } else if (bps <= 9600) {
+        return 2048;  /* Medium for 9600 bps */
+    } else {
+        /* Full size, or half a second of line data for fast lines (8N1) */
+        return MAX(base_size, (size_t)bps / 20);
+    }
+}
+
+/**
+ * Get optimal buffer size for current speed and flow control
+ */
+size_t serial_get_optimal_buffer_size(serial_port_t *port, bool is_tx)
+{
+    if (port == NULL) {
+        return 1024;  /* Safe default */
+    }
+
+    size_t base_size = is_tx ? port->l3_config.tx_buffer_size : port->l3_config.rx_buffer_size;
+
+    /* Adjust for low-speed optimizations */
+    if (port->l3_config.low_speed_optimization) {
+        return base_size;  /* Already adjusted for low speed */
+    }
+
+    /* Adjust based on current baudrate */
+    return serial_buffer_size_for_speed(serial_speed_t_to_baudrate(port->baudrate), base_size);
+}
+
+/**
+ * Calculate transmission delay for current baudrate
+ */
+useconds_t serial_calculate_tx_delay(serial_port_t *port, size_t bytes)
+{
+    /* port->baudrate holds a termios B* constant, not bits per second */
+    int bps = (port != NULL) ? serial_speed_t_to_baudrate(port->baudrate) : 0;
+    if (bps <= 0) {
+        return 1000;  /* 1ms default */
+    }
+
+    /* Calculate bits to transmit (8 data bits + 1 start bit + 1 stop bit = 10 bits per byte) */
+    double bits_per_byte = 10.0;
+    double total_bits = bytes * bits_per_byte;
+    double baudrate = (double)bps;
+    
+    /* Calculate transmission time in microseconds */
+    double delay_us = (total_bits / baudrate) * 1000000.0;
+    
+    /* Add safety margin (20% extra) */
+    delay_us *= 1.2;
+    
+    /* Add minimum delay for system overhead */
+    if (delay_us < 500) {
+        delay_us = 500;  /* Minimum 0.5ms */
+    }
+    
+    /* Cap maximum delay */
+    if (delay_us > 5000000) {
+        delay_us = 5000000;  /* Maximum 5 seconds */
+    }
+    
+    return (useconds_t)delay_us;
+}
+
+/* ========================================================================
+ * Level 1 Dynamic Baudrate Adjustment Functions (modem_sample integration)
+ * ======================================================================== */
+
+/**
+ * Dynamically adjust serial port speed based on modem connection
+ * Based on modem_sample/serial_port.c:adjust_serial_speed()
+ */
+int serial_adjust_baudrate_dynamically(serial_port_t *port, int target_speed)
+{
+    speed_t new_speed;
+    int rc;
 
     if (port == NULL || port->fd < 0) {
         MB_LOG_ERROR("Invalid serial port for dynamic adjustment");
@@ -1872,3 +2265,448 @@ bool serial_check_available(serial_port_t *port)
 
     return (rc > 0 && FD_ISSET(port->fd, &readfds));
 }
+
+/* ========================================================================
+ * Asynchronous TX Queue
+ * ======================================================================== */
+
+/**
+ * Allocate the TX queue for an opened port
+ */
+static void serial_tx_queue_open(serial_port_t *port, size_t size)
+{
+    serial_tx_queue_t *txq = &port->txq;
+
+    pthread_mutex_lock(&txq->lock);
+    if (txq->data == NULL) {
+        txq->data = bufpool_alloc(size, &txq->capacity);
+        if (txq->data == NULL) {
+            MB_LOG_WARNING("No TX queue for %s, writing directly to the driver", port->device);
+            txq->capacity = 0;
+        }
+    }
+    txq->head = 0;
+    txq->tail = 0;
+    latency_tags_reset(&txq->tags);
+    serial_tx_pace_reset_locked(port, 0);
+    pthread_mutex_unlock(&txq->lock);
+}
+
+/**
+ * Release the TX queue of a closed port
+ */
+static void serial_tx_queue_close(serial_port_t *port)
+{
+    serial_tx_queue_t *txq = &port->txq;
+
+    pthread_mutex_lock(&txq->lock);
+    bufpool_free(txq->data, txq->capacity);
+    txq->data = NULL;
+    txq->capacity = 0;
+    txq->head = 0;
+    txq->tail = 0;
+    latency_tags_reset(&txq->tags);
+    pthread_mutex_unlock(&txq->lock);
+}
+
+/**
+ * Drop bytes that have not reached the driver yet
+ */
+static void serial_tx_queue_discard(serial_port_t *port)
+{
+    pthread_mutex_lock(&port->txq.lock);
+    port->txq.tail = port->txq.head;
+    latency_tags_reset(&port->txq.tags);
+    pthread_mutex_unlock(&port->txq.lock);
+}
+
+/**
+ * Bytes currently queued in the driver (0 if TIOCOUTQ is unsupported)
+ */
+static size_t serial_tx_driver_fill(serial_port_t *port)
+{
+    int outq = 0;
+
+    if (ioctl(port->fd, TIOCOUTQ, &outq) < 0 || outq < 0) {
+        return 0;
+    }
+    return (size_t)outq;
+}
+
+/**
+ * Driver FIFO fill to maintain: SERIAL_TX_FIFO_US of line time
+ */
+static size_t serial_tx_target_fill(serial_port_t *port)
+{
+    useconds_t per_kb = serial_calculate_tx_delay(port, 1024);
+    size_t fill = (size_t)SERIAL_TX_FIFO_US * 1024 / MAX(per_kb, 1);
+
+    return MAX((size_t)SERIAL_TX_MIN_FILL, MIN(fill, (size_t)SERIAL_TX_MAX_FILL));
+}
+
+/**
+ * Bits on the line per character for the current termios framing
+ */
+static int serial_tx_frame_bits(serial_port_t *port)
+{
+    tcflag_t cflag = port->newtio.c_cflag;
+    int data_bits;
+
+    switch (cflag & CSIZE) {
+        case CS5: data_bits = 5; break;
+        case CS6: data_bits = 6; break;
+        case CS7: data_bits = 7; break;
+        default:  data_bits = 8; break;
+    }
+
+    return 1 + data_bits + ((cflag & PARENB) ? 1 : 0) + ((cflag & CSTOPB) ? 2 : 1);
+}
+
+/**
+ * Check whether the token bucket limits TX (a carrier rate is set)
+ */
+static bool serial_tx_paced(serial_port_t *port)
+{
+    return port->txq.pace_bps > 0;
+}
+
+/**
+ * Start pacing at a new rate with a full bucket (caller holds txq.lock)
+ */
+static void serial_tx_pace_reset_locked(serial_port_t *port, int bps)
+{
+    serial_tx_queue_t *txq = &port->txq;
+    int rate = (bps > 0) ? bps : serial_speed_t_to_baudrate(port->baudrate);
+
+    txq->pace_bps = MAX(bps, 0);
+    txq->pace_bits = serial_tx_frame_bits(port);
+    txq->pace_char_ns = (rate > 0) ? (uint64_t)txq->pace_bits * 1000000000ULL / (uint64_t)rate : 0;
+    txq->pace_burst_ns = MAX((uint64_t)SERIAL_TX_PACE_BURST_US * 1000,
+                             (uint64_t)SERIAL_TX_PACE_MIN_BURST * txq->pace_char_ns);
+    txq->pace_credit_ns = txq->pace_burst_ns;
+    txq->pace_last_ns = serial_monotonic_ns();
+    txq->pace_busy_ns = 0;
+    txq->pace_bytes_base = txq->bytes_sent;
+}
+
+/**
+ * Add the tokens earned since the last refill (caller holds txq.lock)
+ */
+static void serial_tx_pace_refill_locked(serial_port_t *port)
+{
+    serial_tx_queue_t *txq = &port->txq;
+    uint64_t now = serial_monotonic_ns();
+    uint64_t elapsed = now - txq->pace_last_ns;
+
+    txq->pace_last_ns = now;
+    if (txq->head != txq->tail) {
+        txq->pace_busy_ns += elapsed;
+    }
+    txq->pace_credit_ns = MIN(txq->pace_credit_ns + elapsed, txq->pace_burst_ns);
+}
+
+/**
+ * Nanoseconds until the bucket holds enough tokens for the next write
+ * (caller holds txq.lock; 0 = send now)
+ */
+static uint64_t serial_tx_pace_wait_ns_locked(serial_port_t *port)
+{
+    serial_tx_queue_t *txq = &port->txq;
+
+    if (!serial_tx_paced(port) || txq->head == txq->tail) {
+        return 0;
+    }
+
+    serial_tx_pace_refill_locked(port);
+
+    /* Batch writes: wait for half a burst (or what is queued, if less) */
+    uint64_t chars = MIN((uint64_t)(txq->head - txq->tail),
+                         MAX(txq->pace_burst_ns / txq->pace_char_ns / 2, 1));
+    uint64_t need = chars * txq->pace_char_ns;
+
+    return (txq->pace_credit_ns >= need) ? 0 : need - txq->pace_credit_ns;
+}
+
+/**
+ * Hand queued bytes to the driver (caller holds txq.lock)
+ * Writes at most the room left below the target fill, so the blocking-mode
+ * descriptor never waits inside write().
+ */
+static ssize_t serial_tx_pump_locked(serial_port_t *port)
+{
+    serial_tx_queue_t *txq = &port->txq;
+    ssize_t total = 0;
+
+    if (txq->data == NULL || txq->head == txq->tail || port->fd < 0 ||
+        serial_is_tx_blocked(port)) {
+        return 0;
+    }
+
+    size_t target = serial_tx_target_fill(port);
+    size_t outq = serial_tx_driver_fill(port);
+    if (outq >= target) {
+        return 0;
+    }
+    size_t room = target - outq;
+
+    /* Token bucket: never hand the driver more than the carrier can take */
+    bool paced = serial_tx_paced(port);
+    serial_tx_pace_refill_locked(port);
+    if (paced) {
+        room = MIN(room, (size_t)(txq->pace_credit_ns / txq->pace_char_ns));
+    }
+
+    while (room > 0 && txq->head != txq->tail) {
+        size_t offset = txq->tail & (txq->capacity - 1);
+        size_t chunk = MIN(MIN(room, txq->head - txq->tail), txq->capacity - offset);
+
+        ssize_t n = write(port->fd, txq->data + offset, chunk);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            MB_LOG_ERROR("Serial write error: %s", strerror(errno));
+            return ERROR_IO;
+        }
+
+        txq->tail += (size_t)n;
+        txq->bytes_sent += (uint64_t)n;
+        /* The chunk's last byte leaves the UART after everything queued ahead of it */
+        latency_tags_pop(&txq->tags, (size_t)n, METRICS_STAGE_OUTPUT, true,
+                         (uint64_t)(outq + (size_t)total + (size_t)n) * txq->pace_char_ns);
+        if (paced) {
+            txq->pace_credit_ns -= MIN((uint64_t)n * txq->pace_char_ns, txq->pace_credit_ns);
+        }
+        total += n;
+        room -= (size_t)n;
+        if ((size_t)n < chunk) {
+            break;
+        }
+    }
+
+    return total;
+}
+
+/**
+ * Move queued TX bytes into the driver up to the target FIFO fill
+ */
+ssize_t serial_tx_pump(serial_port_t *port)
+{
+    if (port == NULL) {
+        return ERROR_INVALID_ARG;
+    }
+
+    pthread_mutex_lock(&port->txq.lock);
+    ssize_t ret = serial_tx_pump_locked(port);
+    pthread_mutex_unlock(&port->txq.lock);
+
+    return ret;
+}
+
+/**
+ * Bytes accepted by serial_write() but not yet handed to the driver
+ */
+size_t serial_tx_pending(serial_port_t *port)
+{
+    if (port == NULL) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&port->txq.lock);
+    size_t pending = port->txq.head - port->txq.tail;
+    pthread_mutex_unlock(&port->txq.lock);
+
+    return pending;
+}
+
+/**
+ * Bytes the driver can take now without a long blocking write
+ */
+size_t serial_tx_driver_room(serial_port_t *port)
+{
+    if (port == NULL || port->fd < 0) {
+        return 0;
+    }
+
+    size_t target = serial_tx_target_fill(port);
+    size_t fill = serial_tx_driver_fill(port);
+
+    return (fill < target) ? target - fill : 0;
+}
+
+/**
+ * Free space in the TX queue
+ */
+size_t serial_tx_space(serial_port_t *port)
+{
+    if (port == NULL) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&port->txq.lock);
+    size_t space = SIZE_MAX;
+    if (port->txq.data != NULL) {
+        size_t queued = port->txq.head - port->txq.tail;
+        space = port->txq.capacity - queued;
+
+        /* Paced: offer only SERIAL_TX_PACE_QUEUE_US of line time */
+        if (serial_tx_paced(port)) {
+            size_t window = MAX((size_t)SERIAL_TX_MIN_FILL,
+                                (size_t)((uint64_t)SERIAL_TX_PACE_QUEUE_US * 1000 / port->txq.pace_char_ns));
+            space = (queued >= window) ? 0 : MIN(space, window - queued);
+        }
+    }
+    pthread_mutex_unlock(&port->txq.lock);
+
+    return space;
+}
+
+/**
+ * Milliseconds until the TX queue needs another pump
+ */
+int serial_tx_next_timeout_ms(serial_port_t *port)
+{
+    if (port == NULL || port->fd < 0 || serial_tx_pending(port) == 0 ||
+        serial_is_tx_blocked(port)) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&port->txq.lock);
+    uint64_t pace_ns = serial_tx_pace_wait_ns_locked(port);
+    pthread_mutex_unlock(&port->txq.lock);
+    int pace_ms = (int)((pace_ns + 999999) / 1000000);
+
+    size_t target = serial_tx_target_fill(port);
+    size_t outq = serial_tx_driver_fill(port);
+    if (outq < target) {
+        return pace_ms;
+    }
+
+    /* Come back when the FIFO has drained to half the target */
+    useconds_t us = serial_calculate_tx_delay(port, outq - target / 2);
+    return MAX((int)((us + 999) / 1000), pace_ms);
+}
+
+/**
+ * Pace the TX queue at the modem's carrier rate
+ */
+void serial_tx_set_line_rate(serial_port_t *port, int bps)
+{
+    if (port == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&port->txq.lock);
+    serial_tx_pace_reset_locked(port, bps);
+    bool paced = serial_tx_paced(port);
+    pthread_mutex_unlock(&port->txq.lock);
+
+    if (paced) {
+        MB_LOG_INFO("Serial TX paced at %d bps (%d bits/char, %llu us burst)",
+                    bps, port->txq.pace_bits,
+                    (unsigned long long)(port->txq.pace_burst_ns / 1000));
+    }
+}
+
+/**
+ * Feed TX queue stages to a direction's histograms
+ */
+void serial_set_latency_metrics(serial_port_t *port, metrics_direction_t *metrics)
+{
+    if (port == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&port->txq.lock);
+    port->txq.tags.metrics = metrics;
+    pthread_mutex_unlock(&port->txq.lock);
+}
+
+/**
+ * Achieved vs. theoretical line utilization since the rate was set
+ */
+int serial_tx_get_pace_stats(serial_port_t *port, serial_tx_pace_stats_t *stats)
+{
+    if (port == NULL || stats == NULL) {
+        return ERROR_INVALID_ARG;
+    }
+
+    memset(stats, 0, sizeof(serial_tx_pace_stats_t));
+
+    pthread_mutex_lock(&port->txq.lock);
+    serial_tx_pace_refill_locked(port);
+    serial_tx_queue_t *txq = &port->txq;
+    stats->bits_per_char = txq->pace_bits;
+    stats->paced = serial_tx_paced(port);
+    stats->bytes = txq->bytes_sent - txq->pace_bytes_base;
+    stats->busy_sec = (double)txq->pace_busy_ns / 1e9;
+    if (txq->pace_char_ns > 0) {
+        stats->line_bps = (txq->pace_bps > 0) ? txq->pace_bps :
+                          (int)((uint64_t)txq->pace_bits * 1000000000ULL / txq->pace_char_ns);
+        stats->theoretical_cps = 1e9 / (double)txq->pace_char_ns;
+    }
+    pthread_mutex_unlock(&port->txq.lock);
+
+    /* Bytes sent on an empty queue go out in the burst and take no busy
+     * time, so short busy periods can read above the line rate */
+    if (stats->busy_sec >= 0.001 && stats->theoretical_cps > 0.0) {
+        stats->achieved_cps = (double)stats->bytes / stats->busy_sec;
+        stats->utilization_pct = MIN(100.0, stats->achieved_cps * 100.0 / stats->theoretical_cps);
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * Check whether all written data has left the UART
+ */
+bool serial_tx_complete(serial_port_t *port)
+{
+    if (port == NULL || port->fd < 0) {
+        return true;
+    }
+
+    return serial_tx_pending(port) == 0 && serial_tx_driver_fill(port) == 0;
+}
+
+/**
+ * Wait until all written data has left the UART
+ */
+int serial_tx_drain(serial_port_t *port, int timeout_ms)
+{
+    if (port == NULL || port->fd < 0 || !port->is_open) {
+        return ERROR_INVALID_ARG;
+    }
+
+    long long deadline = (timeout_ms < 0) ? -1 : serial_monotonic_ms() + timeout_ms;
+
+    while (serial_tx_pending(port) > 0) {
+        ssize_t ret = serial_tx_pump(port);
+        if (ret < 0) {
+            return (int)ret;
+        }
+        if (serial_tx_pending(port) == 0) {
+            break;
+        }
+
+        long long now = serial_monotonic_ms();
+        if (deadline >= 0 && now >= deadline) {
+            return ERROR_TIMEOUT;
+        }
+        int wait_ms = serial_tx_next_timeout_ms(port);
+        if (wait_ms < 0 || wait_ms > SERIAL_TX_WAIT_MAX_MS) {
+            wait_ms = SERIAL_TX_WAIT_MAX_MS;
+        }
+        if (deadline >= 0) {
+            wait_ms = (int)MIN((long long)wait_ms, deadline - now);
+        }
+        serial_sleep_ms(MAX(wait_ms, 1));
+    }
+
+    /* Queue handed over: let the driver finish the last bytes */
+    tcdrain(port->fd);
+    return SUCCESS;
+}
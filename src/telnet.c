@@ -4,7 +4,15 @@
 
 #include "telnet.h"
 #include "datalog.h"
+#include "util.h"
 #include <time.h>
+#include <poll.h>
+#include <netinet/tcp.h>
+#include <sys/uio.h>
+#include <sys/eventfd.h>
+#ifdef ENABLE_MCCP
+#include <zlib.h>
+#endif
 
 /* Level 2 only: No bridge dependency for isolation */
 
@@ -12,6 +20,60 @@
 static bool is_utf8_start(unsigned char byte);
 static int utf8_sequence_length(unsigned char byte);
 
+static void telnet_update_mode(telnet_t *tn);
+static bool telnet_compress_supported(const telnet_t *tn);
+
+/* Negotiation transcript of one server (shared by every line) */
+typedef struct {
+    char host[SMALL_BUFFER_SIZE];
+    int port;                       /* 0 = slot unused */
+    unsigned long long used;        /* Last use (for eviction) */
+    telnet_optset_t local;          /* Options the server had us enable */
+    telnet_optset_t remote;         /* Options the server enabled */
+    bool ttype;                     /* Server asked for TERMINAL-TYPE */
+} telnet_negcache_entry_t;
+
+static telnet_negcache_entry_t telnet_negcache[TELNET_NEGCACHE_SIZE];
+static unsigned long long telnet_negcache_clock = 0;
+static pthread_mutex_t telnet_negcache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Longest UTF-8 sequence utf8_sequence_length() can report */
+#define TELNET_UTF8_MAX_SEQ 4
+
+/**
+ * Forget the negotiated options of the previous session
+ */
+static void telnet_reset_options(telnet_t *tn)
+{
+    memset(&tn->local_options, 0, sizeof(tn->local_options));
+    memset(&tn->remote_options, 0, sizeof(tn->remote_options));
+
+    /* Set default options we support */
+    telnet_opt_set(&tn->local_options, TELOPT_BINARY, true);
+    telnet_opt_set(&tn->local_options, TELOPT_SGA, true);
+
+    tn->binary_local = false;
+    tn->binary_remote = false;
+    tn->echo_local = false;
+    tn->echo_remote = false;
+    tn->sga_local = false;
+    tn->sga_remote = false;
+    tn->linemode_active = false;
+    tn->linemode_edit = false;
+    tn->binary_mode = false;
+    tn->echo_mode = false;
+    tn->sga_mode = false;
+
+    /* Default to line mode until server requests character mode */
+    tn->linemode = true;
+
+    /* New transcript */
+    tn->neg_seen = false;
+    memset(&tn->neg_local, 0, sizeof(tn->neg_local));
+    memset(&tn->neg_remote, 0, sizeof(tn->neg_remote));
+    tn->neg_ttype = false;
+}
+
 /**
  * Initialize telnet structure
  */
@@ -24,20 +86,17 @@ void telnet_init(telnet_t *tn)
     memset(tn, 0, sizeof(telnet_t));
     tn->fd = -1;
     tn->epoll_fd = -1;
+    tn->race_fd = -1;
     tn->is_connected = false;
     tn->is_connecting = false;
+    tn->is_resolving = false;
     tn->state = TELNET_STATE_DATA;
+    dialdir_lease_init(&tn->lease, NULL);
+    tn->connect_timeout_ms = TELNET_CONNECT_TIMEOUT_MS;
 
-    /* Initialize option tracking */
-    memset(tn->local_options, 0, sizeof(tn->local_options));
-    memset(tn->remote_options, 0, sizeof(tn->remote_options));
-
-    /* Set default options we support */
-    tn->local_options[TELOPT_BINARY] = true;
-    tn->local_options[TELOPT_SGA] = true;
-
-    /* Default to line mode until server requests character mode */
-    tn->linemode = true;
+    /* Initialize option tracking (cached negotiation sent on connect) */
+    telnet_reset_options(tn);
+    tn->fast_start = true;
 
     /* Set default terminal type */
     SAFE_STRNCPY(tn->terminal_type, "ANSI", sizeof(tn->terminal_type));
@@ -51,11 +110,25 @@ void telnet_init(telnet_t *tn)
     tn->has_error = false;
     tn->event_count = 0;
 
-    /* Initialize buffers */
+    /* Initialize buffers (allocated on first use) */
+    tn->buffer_size = BUFFER_SIZE;
+    tn->read_buf = NULL;
     tn->read_pos = 0;
     tn->read_len = 0;
-    tn->write_pos = 0;
-    tn->write_len = 0;
+
+    /* Telnet protocol on */
+    tn->raw_tcp = false;
+
+    /* MCCP2 accepted if the server offers it (inflater allocated on first use) */
+    tn->compress_enabled = true;
+    tn->compress_active = false;
+    tn->zstream = NULL;
+    tn->zin_buf = NULL;
+
+    /* Output queue (segments allocated on first write, no coalescing until a line rate is set) */
+    pthread_mutex_init(&tn->out_lock, NULL);
+    tn->cork_us = 0;
+    latency_tags_init(&tn->out_tags, NULL);
 
     /* Initialize connection health monitoring */
     tn->last_activity = time(NULL);
@@ -74,75 +147,639 @@ void telnet_init(telnet_t *tn)
     MB_LOG_DEBUG("Telnet initialized with epoll support, keep-alive, and error handling");
 }
 
+/* ========== Output Queue ========== */
+
 /**
- * Connect to telnet server
+ * Monotonic clock in microseconds
  */
-int telnet_connect(telnet_t *tn, const char *host, int port)
+static long long telnet_monotonic_us(void)
 {
-    struct sockaddr_in server_addr;
-    struct hostent *he;
+    struct timespec ts;
 
-    if (tn == NULL || host == NULL) {
-        MB_LOG_ERROR("Invalid arguments to telnet_connect");
-        return ERROR_INVALID_ARG;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/**
+ * Bytes the output queue can still take (call with out_lock held)
+ */
+static size_t telnet_outq_space(const telnet_t *tn)
+{
+    size_t segment = bufpool_class_size(tn->buffer_size);
+    size_t space = (size_t)(TELNET_OUTQ_SEGMENTS - tn->out_count) * segment;
+
+    if (tn->out_count > 0) {
+        const telnet_segment_t *last =
+            &tn->out_seg[(tn->out_first + tn->out_count - 1) % TELNET_OUTQ_SEGMENTS];
+        space += last->size - last->tail;
     }
 
-    if (tn->is_connected) {
-        MB_LOG_WARNING("Already connected, disconnecting first");
-        telnet_disconnect(tn);
+    return space;
+}
+
+/**
+ * Append to the output queue, adding segments as needed (call with out_lock held)
+ * @param stamp Ingress stamp of the data (NULL = untagged)
+ * @return Bytes appended (less than len when the queue is full)
+ */
+static size_t telnet_outq_append(telnet_t *tn, const void *data, size_t len,
+                                 const latency_stamp_t *stamp)
+{
+    const unsigned char *src = data;
+    size_t done = 0;
+
+    while (done < len) {
+        telnet_segment_t *seg = NULL;
+        if (tn->out_count > 0) {
+            seg = &tn->out_seg[(tn->out_first + tn->out_count - 1) % TELNET_OUTQ_SEGMENTS];
+        }
+
+        if (seg == NULL || seg->tail == seg->size) {
+            if (tn->out_count == TELNET_OUTQ_SEGMENTS) {
+                break;
+            }
+            seg = &tn->out_seg[(tn->out_first + tn->out_count) % TELNET_OUTQ_SEGMENTS];
+            if (seg->data == NULL) {
+                seg->data = bufpool_alloc(tn->buffer_size, &seg->size);
+                if (seg->data == NULL) {
+                    MB_LOG_ERROR("Failed to allocate telnet output segment (%zu bytes)",
+                                tn->buffer_size);
+                    break;
+                }
+            }
+            seg->head = 0;
+            seg->tail = 0;
+            tn->out_count++;
+        }
+
+        size_t n = MIN(len - done, seg->size - seg->tail);
+        memcpy(seg->data + seg->tail, src + done, n);
+        seg->tail += n;
+        done += n;
     }
 
-    MB_LOG_INFO("Connecting to telnet server: %s:%d", host, port);
+    if (done > 0 && tn->out_bytes == 0) {
+        tn->out_since_us = telnet_monotonic_us();
+    }
+    tn->out_bytes += done;
+    latency_tags_push(&tn->out_tags, done, (stamp != NULL) ? stamp->ingress_ns : 0,
+                      METRICS_STAGE_PROCESS, (stamp != NULL) ? stamp->handoff_ns : 0);
 
-    /* Create socket */
-    tn->fd = socket(AF_INET, SOCK_STREAM, 0);
-    if (tn->fd < 0) {
-        MB_LOG_ERROR("Failed to create socket: %s", strerror(errno));
-        return ERROR_CONNECTION;
+    return done;
+}
+
+/**
+ * Check whether queued output should be sent now (call with out_lock held)
+ */
+static bool telnet_outq_due(const telnet_t *tn, long long now_us)
+{
+    return tn->out_urgent || tn->out_blocked || tn->cork_us == 0 ||
+           tn->out_bytes >= TELNET_CORK_BYTES ||
+           now_us - tn->out_since_us >= tn->cork_us;
+}
+
+/**
+ * Send the output queue with sendmsg() until it is empty or the socket is
+ * full (call with out_lock held)
+ */
+static int telnet_outq_send(telnet_t *tn)
+{
+    while (tn->out_bytes > 0) {
+        struct iovec iov[TELNET_OUTQ_SEGMENTS];
+        struct msghdr msg;
+        int iov_count = 0;
+
+        for (int i = 0; i < tn->out_count; i++) {
+            telnet_segment_t *seg = &tn->out_seg[(tn->out_first + i) % TELNET_OUTQ_SEGMENTS];
+            if (seg->tail > seg->head) {
+                iov[iov_count].iov_base = seg->data + seg->head;
+                iov[iov_count].iov_len = seg->tail - seg->head;
+                iov_count++;
+            }
+        }
+
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = iov_count;
+
+        ssize_t sent = sendmsg(tn->fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                MB_LOG_DEBUG("Write would block, %zu bytes remain queued", tn->out_bytes);
+                tn->out_blocked = true;
+                return SUCCESS;
+            }
+            MB_LOG_ERROR("Failed to send queued data: %s", strerror(errno));
+            return ERROR_IO;
+        }
+
+        telnet_update_activity(tn);
+        tn->out_bytes -= (size_t)sent;
+        latency_tags_pop(&tn->out_tags, (size_t)sent, METRICS_STAGE_OUTPUT, true, 0);
+        bool partial = (tn->out_bytes > 0);
+
+        /* Retire sent segments; the last one is kept for the next write */
+        size_t left = (size_t)sent;
+        while (tn->out_count > 0) {
+            telnet_segment_t *seg = &tn->out_seg[tn->out_first];
+            size_t n = MIN(left, seg->tail - seg->head);
+            seg->head += n;
+            left -= n;
+            if (seg->head < seg->tail) {
+                break;
+            }
+            if (tn->out_count == 1) {
+                seg->head = 0;
+                seg->tail = 0;
+                tn->out_count = 0;
+                break;
+            }
+            bufpool_free(seg->data, seg->size);
+            memset(seg, 0, sizeof(*seg));
+            tn->out_first = (tn->out_first + 1) % TELNET_OUTQ_SEGMENTS;
+            tn->out_count--;
+        }
+
+        if (partial) {
+            /* Short write: the socket buffer is full */
+            tn->out_blocked = true;
+            return SUCCESS;
+        }
     }
 
-    /* Set non-blocking mode */
-    int flags = fcntl(tn->fd, F_GETFL, 0);
-    if (flags >= 0) {
-        fcntl(tn->fd, F_SETFL, flags | O_NONBLOCK);
+    tn->out_blocked = false;
+    tn->out_urgent = false;
+    return SUCCESS;
+}
+
+/**
+ * Drop queued output and return its segments to the slab
+ */
+static void telnet_outq_reset(telnet_t *tn)
+{
+    pthread_mutex_lock(&tn->out_lock);
+    for (int i = 0; i < TELNET_OUTQ_SEGMENTS; i++) {
+        bufpool_free(tn->out_seg[i].data, tn->out_seg[i].size);
+        memset(&tn->out_seg[i], 0, sizeof(tn->out_seg[i]));
+    }
+    tn->out_first = 0;
+    tn->out_count = 0;
+    tn->out_bytes = 0;
+    tn->out_since_us = 0;
+    tn->out_urgent = false;
+    tn->out_blocked = false;
+    latency_tags_reset(&tn->out_tags);
+    pthread_mutex_unlock(&tn->out_lock);
+}
+
+/**
+ * Queue a protocol message (IAC sequence) and send it without coalescing
+ */
+static int telnet_send_control(telnet_t *tn, const unsigned char *buf, size_t len)
+{
+    pthread_mutex_lock(&tn->out_lock);
+    if (telnet_outq_space(tn) < len) {
+        pthread_mutex_unlock(&tn->out_lock);
+        MB_LOG_WARNING("Write queue full, dropping %zu-byte telnet command", len);
+        return ERROR_BUFFER_FULL;
     }
 
-    /* Resolve hostname */
-    he = gethostbyname(host);
-    if (he == NULL) {
-        MB_LOG_ERROR("Failed to resolve host: %s", host);
-        close(tn->fd);
-        tn->fd = -1;
+    telnet_outq_append(tn, buf, len, NULL);
+    tn->out_urgent = true;
+    int ret = telnet_outq_send(tn);
+    pthread_mutex_unlock(&tn->out_lock);
+
+    return ret;
+}
+
+/**
+ * Monotonic clock in milliseconds
+ */
+static long long telnet_monotonic_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/* ========== Negotiation Fast Start ========== */
+
+/**
+ * Find the transcript of a server (negcache lock held)
+ * @return Slot, or -1 if the server is not cached
+ */
+static int telnet_negcache_find(const char *host, int port)
+{
+    for (int i = 0; i < TELNET_NEGCACHE_SIZE; i++) {
+        if (telnet_negcache[i].port == port && strcmp(telnet_negcache[i].host, host) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Remember what the server of the ending session negotiated
+ */
+static void telnet_negcache_store(const telnet_t *tn)
+{
+    if (!tn->neg_seen || tn->raw_tcp || tn->port <= 0) {
+        return;
+    }
+
+    pthread_mutex_lock(&telnet_negcache_lock);
+    int slot = telnet_negcache_find(tn->host, tn->port);
+    if (slot < 0) {
+        /* Free slot, else the least recently used one */
+        slot = 0;
+        for (int i = 0; i < TELNET_NEGCACHE_SIZE; i++) {
+            if (telnet_negcache[i].port == 0) {
+                slot = i;
+                break;
+            }
+            if (telnet_negcache[i].used < telnet_negcache[slot].used) {
+                slot = i;
+            }
+        }
+    }
+
+    telnet_negcache_entry_t *entry = &telnet_negcache[slot];
+    _Static_assert(sizeof(entry->host) == sizeof(tn->host), "host buffers differ");
+    memcpy(entry->host, tn->host, sizeof(entry->host));
+    entry->port = tn->port;
+    entry->used = ++telnet_negcache_clock;
+    entry->local = tn->neg_local;
+    entry->remote = tn->neg_remote;
+    entry->ttype = tn->neg_ttype;
+    pthread_mutex_unlock(&telnet_negcache_lock);
+}
+
+/**
+ * Copy the transcript of a server
+ * @return true if the server is cached
+ */
+static bool telnet_negcache_lookup(const char *host, int port, telnet_negcache_entry_t *out)
+{
+    pthread_mutex_lock(&telnet_negcache_lock);
+    int slot = telnet_negcache_find(host, port);
+    if (slot >= 0) {
+        telnet_negcache[slot].used = ++telnet_negcache_clock;
+        *out = telnet_negcache[slot];
+    }
+    pthread_mutex_unlock(&telnet_negcache_lock);
+
+    return slot >= 0;
+}
+
+/**
+ * Turn on the mode flag of an option that is now enabled
+ * @param remote true for an option the server performs (WILL), false for one we do (DO)
+ */
+static void telnet_option_on(telnet_t *tn, bool remote, unsigned char option)
+{
+    bool *flag = NULL;
+    const char *name = NULL;
+
+    if (remote) {
+        switch (option) {
+            case TELOPT_BINARY: flag = &tn->binary_remote; name = "Remote BINARY mode"; break;
+            case TELOPT_SGA:    flag = &tn->sga_remote;    name = "Remote SGA";         break;
+            case TELOPT_ECHO:   flag = &tn->echo_remote;   name = "Remote ECHO";        break;
+            default:            break;
+        }
+    } else {
+        switch (option) {
+            case TELOPT_BINARY:   flag = &tn->binary_local;    name = "Local BINARY mode"; break;
+            case TELOPT_SGA:      flag = &tn->sga_local;       name = "Local SGA";         break;
+            case TELOPT_LINEMODE: flag = &tn->linemode_active; name = "LINEMODE";          break;
+            default:              break;
+        }
+    }
+
+    if (flag != NULL && !*flag) {
+        *flag = true;
+        MB_LOG_INFO("%s enabled", name);
+    }
+}
+
+/**
+ * Append IAC <command> <option>
+ */
+static size_t telnet_put_negotiate(unsigned char *buf, size_t len, unsigned char command,
+                                   unsigned char option)
+{
+    buf[len++] = TELNET_IAC;
+    buf[len++] = command;
+    buf[len++] = option;
+    return len;
+}
+
+/**
+ * Send the opening negotiation in one packet
+ * Without a transcript the options we want are offered and the server's
+ * requests are answered as they come. With one, exactly what this server
+ * agreed to last time is sent up front (its DO/WILL answered before it
+ * asks, TERMINAL-TYPE included) and taken as on, so the session starts
+ * without waiting a round trip per option. A server that now disagrees
+ * answers WONT/DONT and the normal negotiation takes over.
+ */
+static void telnet_send_greeting(telnet_t *tn)
+{
+    static const unsigned char offer[][2] = {
+        { TELNET_WILL, TELOPT_BINARY },
+        { TELNET_WILL, TELOPT_SGA },
+        { TELNET_DO,   TELOPT_SGA },
+        { TELNET_DO,   TELOPT_ECHO },
+        { TELNET_WILL, TELOPT_TTYPE },
+        { TELNET_WILL, TELOPT_LINEMODE },
+    };
+    unsigned char buf[SMALL_BUFFER_SIZE];
+    size_t len = 0;
+    telnet_negcache_entry_t cached;
+
+    if (!tn->fast_start || !telnet_negcache_lookup(tn->host, tn->port, &cached)) {
+        for (size_t i = 0; i < sizeof(offer) / sizeof(offer[0]); i++) {
+            len = telnet_put_negotiate(buf, len, offer[i][0], offer[i][1]);
+        }
+    } else {
+        /* Transcripts only hold options we support: at most a few entries */
+        for (int option = 0; option < 256; option++) {
+            if (telnet_opt_test(&cached.local, (unsigned char)option)) {
+                len = telnet_put_negotiate(buf, len, TELNET_WILL, (unsigned char)option);
+                telnet_opt_set(&tn->local_options, (unsigned char)option, true);
+                telnet_option_on(tn, false, (unsigned char)option);
+            }
+            if (telnet_opt_test(&cached.remote, (unsigned char)option) &&
+                (option != TELOPT_COMPRESS2 || telnet_compress_supported(tn))) {
+                len = telnet_put_negotiate(buf, len, TELNET_DO, (unsigned char)option);
+                telnet_opt_set(&tn->remote_options, (unsigned char)option, true);
+                telnet_option_on(tn, true, (unsigned char)option);
+            }
+        }
+
+        size_t term_len = strlen(tn->terminal_type);
+        if (cached.ttype && len + term_len + 6 <= sizeof(buf)) {
+            buf[len++] = TELNET_IAC;
+            buf[len++] = TELNET_SB;
+            buf[len++] = TELOPT_TTYPE;
+            buf[len++] = TTYPE_IS;
+            memcpy(buf + len, tn->terminal_type, term_len);
+            len += term_len;
+            buf[len++] = TELNET_IAC;
+            buf[len++] = TELNET_SE;
+        }
+
+        telnet_update_mode(tn);
+        MB_LOG_INFO("Telnet fast start for %s:%d: cached negotiation sent (%zu bytes)",
+                   tn->host, tn->port, len);
+    }
+
+    if (len == 0) {
+        return;
+    }
+
+    /* Log internal protocol negotiation */
+    if (tn->datalog != NULL) {
+        datalog_write((datalog_t *)tn->datalog, DATALOG_DIR_INTERNAL, buf, len);
+    }
+    telnet_send_control(tn, buf, len);
+}
+
+/**
+ * Send the initial option negotiations once the socket is connected
+ */
+static void telnet_connect_complete(telnet_t *tn)
+{
+    int one = 1;
+
+    tn->is_connected = true;
+    tn->is_connecting = false;
+    dialdir_report(&tn->lease, true);
+
+    /* The output queue coalesces small writes itself (see telnet_flush_writes) */
+    if (setsockopt(tn->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)) < 0) {
+        MB_LOG_WARNING("Failed to set TCP_NODELAY: %s", strerror(errno));
+    }
+
+    if (tn->raw_tcp) {
+        return;
+    }
+
+    telnet_send_greeting(tn);
+}
+
+/**
+ * Start a non-blocking connect to the next candidate address
+ * Addresses that fail immediately are skipped.
+ * @param connected Set when connect() completed at once
+ * @return Socket, or -1 when no candidate is left
+ */
+static int telnet_start_attempt(telnet_t *tn, bool *connected)
+{
+    char text[INET6_ADDRSTRLEN + 2];
+
+    while (tn->next_candidate < tn->candidates.count) {
+        int i = tn->next_candidate++;
+        const struct sockaddr_storage *addr = &tn->candidates.addrs[i];
+
+        resolver_format_addr(addr, text, sizeof(text));
+
+        int fd = socket(addr->ss_family, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        if (fd < 0) {
+            MB_LOG_WARNING("Failed to create socket for %s: %s", text, strerror(errno));
+            continue;
+        }
+
+        tn->attempt_ms = telnet_monotonic_ms();
+        if (connect(fd, (const struct sockaddr *)addr, tn->candidates.addr_len[i]) == 0) {
+            MB_LOG_INFO("Connected to %s port %d immediately", text, tn->port);
+            *connected = true;
+            return fd;
+        }
+        if (errno == EINPROGRESS) {
+            MB_LOG_INFO("Connecting to %s port %d (address %d of %d)",
+                       text, tn->port, i + 1, tn->candidates.count);
+            *connected = false;
+            return fd;
+        }
+
+        MB_LOG_WARNING("Failed to connect to %s: %s", text, strerror(errno));
+        close(fd);
+    }
+
+    return -1;
+}
+
+/**
+ * Add a connect attempt to the telnet epoll set
+ */
+static void telnet_epoll_add(telnet_t *tn, int fd)
+{
+    struct epoll_event ev;
+
+    if (tn->epoll_fd < 0) {
+        return;
+    }
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN | EPOLLOUT | EPOLLET;
+    ev.data.fd = fd;
+    if (epoll_ctl(tn->epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        MB_LOG_WARNING("Failed to add socket to epoll: %s", strerror(errno));
+    }
+}
+
+/**
+ * Start the next attempt, either replacing the failed primary or racing it
+ * @return SUCCESS when an attempt is running or connected, ERROR_CONNECTION otherwise
+ */
+static int telnet_next_attempt(telnet_t *tn, bool race)
+{
+    bool connected = false;
+    int fd = telnet_start_attempt(tn, &connected);
+
+    if (fd < 0) {
         return ERROR_CONNECTION;
     }
 
-    /* Setup server address */
-    memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_port = htons(port);
-    memcpy(&server_addr.sin_addr, he->h_addr_list[0], he->h_length);
+    if (race && !connected) {
+        tn->race_fd = fd;
+    } else {
+        /* Replaces the failed primary, or beats a slow one outright */
+        close(tn->fd);
+        tn->fd = fd;
+    }
+    telnet_epoll_add(tn, fd);
 
-    /* Connect to server */
-    if (connect(tn->fd, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0) {
-        if (errno != EINPROGRESS) {
-            MB_LOG_ERROR("Failed to connect: %s", strerror(errno));
+    if (connected) {
+        telnet_connect_complete(tn);
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * Check a connect attempt without blocking
+ * @param error Receives the socket error of a failed attempt
+ * @return 1 connected, 0 in progress, -1 failed
+ */
+static int telnet_attempt_status(int fd, int *error)
+{
+    struct pollfd pfd = { .fd = fd, .events = POLLOUT };
+    socklen_t len = sizeof(*error);
+
+    if (poll(&pfd, 1, 0) <= 0) {
+        return 0;
+    }
+
+    *error = 0;
+    if (getsockopt(fd, SOL_SOCKET, SO_ERROR, error, &len) < 0) {
+        *error = errno;
+        return -1;
+    }
+
+    return (*error == 0) ? 1 : -1;
+}
+
+static int telnet_failover(telnet_t *tn);
+static int telnet_open_socket(telnet_t *tn);
+static int telnet_resolve_progress(telnet_t *tn);
+
+/**
+ * Advance a non-blocking connect (happy eyeballs, RFC 8305)
+ * A slow attempt is raced by the next address (normally the other address
+ * family) after TELNET_ATTEMPT_DELAY_MS; the first socket to connect wins.
+ * A failed attempt is replaced by the next address right away.
+ */
+static int telnet_connect_progress(telnet_t *tn)
+{
+    if (tn->is_resolving) {
+        return telnet_resolve_progress(tn);
+    }
+
+    int error = 0;
+    int status = telnet_attempt_status(tn->fd, &error);
+
+    if (status == 0 && tn->race_fd >= 0) {
+        int race_error = 0;
+        int race_status = telnet_attempt_status(tn->race_fd, &race_error);
+
+        if (race_status > 0) {
             close(tn->fd);
-            tn->fd = -1;
-            return ERROR_CONNECTION;
+            tn->fd = tn->race_fd;
+            tn->race_fd = -1;
+            status = 1;
+        } else if (race_status < 0) {
+            MB_LOG_WARNING("Connect attempt failed: %s", strerror(race_error));
+            close(tn->race_fd);
+            tn->race_fd = -1;
         }
-        /* Connection in progress for non-blocking socket */
-        tn->is_connecting = true;
-        MB_LOG_INFO("Non-blocking connection in progress");
-    } else {
-        /* Connection completed immediately */
-        tn->is_connecting = false;
-        tn->is_connected = true;
-        MB_LOG_INFO("Connected to telnet server immediately");
     }
 
-    /* Save connection info */
-    SAFE_STRNCPY(tn->host, host, sizeof(tn->host));
-    tn->port = port;
+    if (status > 0) {
+        if (tn->race_fd >= 0) {
+            close(tn->race_fd);
+            tn->race_fd = -1;
+        }
+        telnet_connect_complete(tn);
+        MB_LOG_INFO("Non-blocking connection completed successfully");
+        return SUCCESS;
+    }
+
+    if (status < 0) {
+        if (tn->race_fd >= 0) {
+            /* The racing attempt carries on alone */
+            MB_LOG_WARNING("Connect attempt failed: %s", strerror(error));
+            close(tn->fd);
+            tn->fd = tn->race_fd;
+            tn->race_fd = -1;
+            return SUCCESS;
+        }
+        if (telnet_next_attempt(tn, false) != SUCCESS) {
+            /* Last address: the failed socket is closed by telnet_disconnect() */
+            MB_LOG_ERROR("Connection failed: %s", strerror(error));
+            return telnet_failover(tn);
+        }
+        return SUCCESS;
+    }
+
+    long long now = telnet_monotonic_ms();
+    if (tn->connect_timeout_ms > 0 && now - tn->connect_start_ms >= tn->connect_timeout_ms) {
+        MB_LOG_ERROR("Connection to %s:%d timed out after %d ms", tn->host, tn->port,
+                    tn->connect_timeout_ms);
+        return telnet_failover(tn);
+    }
+
+    /* Still in progress: let the next address race a slow attempt */
+    if (tn->race_fd < 0 && tn->next_candidate < tn->candidates.count &&
+        now - tn->attempt_ms >= TELNET_ATTEMPT_DELAY_MS) {
+        telnet_next_attempt(tn, true);
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * Start the first connect attempt to the resolved candidates
+ */
+static int telnet_open_socket(telnet_t *tn)
+{
+    bool connected = false;
+
+    /* Start the first attempt (non-blocking) */
+    tn->next_candidate = 0;
+    tn->race_fd = -1;
+    tn->fd = telnet_start_attempt(tn, &connected);
+    if (tn->fd < 0) {
+        MB_LOG_ERROR("Failed to connect to %s:%d: no reachable address", tn->host, tn->port);
+        tn->is_connecting = false;
+        return ERROR_CONNECTION;
+    }
+    tn->is_connecting = !connected;
 
     /* Initialize epoll for event-driven I/O */
     if (telnet_init_epoll(tn) != SUCCESS) {
@@ -155,18 +792,194 @@ int telnet_connect(telnet_t *tn, const char *host, int port)
     }
 
     /* Send initial option negotiations only if already connected */
-    if (tn->is_connected) {
-        telnet_send_negotiate(tn, TELNET_WILL, TELOPT_BINARY);
-        telnet_send_negotiate(tn, TELNET_WILL, TELOPT_SGA);
-        telnet_send_negotiate(tn, TELNET_DO, TELOPT_SGA);
-        telnet_send_negotiate(tn, TELNET_DO, TELOPT_ECHO);
-        telnet_send_negotiate(tn, TELNET_WILL, TELOPT_TTYPE);
-        telnet_send_negotiate(tn, TELNET_WILL, TELOPT_LINEMODE);
+    if (connected) {
+        telnet_connect_complete(tn);
+    } else {
+        MB_LOG_INFO("Non-blocking connection in progress");
     }
 
     return SUCCESS;
 }
 
+/**
+ * Collect a lookup running on the resolver thread and start connecting
+ * While resolving, fd is the eventfd the resolver thread signals; the
+ * lookup counts against the connect timeout.
+ */
+static int telnet_resolve_progress(telnet_t *tn)
+{
+    int wake_fd = tn->fd;
+    int epoll_fd = tn->epoll_fd;
+    eventfd_t wakeups;
+
+    /* Nothing to drain when called on a timeout */
+    (void)eventfd_read(wake_fd, &wakeups);
+
+    int ret = resolver_lookup_async(tn->host, tn->port, &tn->candidates, wake_fd);
+    if (ret == RESOLVER_PENDING) {
+        long long now = telnet_monotonic_ms();
+        if (tn->connect_timeout_ms > 0 && now - tn->connect_start_ms >= tn->connect_timeout_ms) {
+            MB_LOG_ERROR("Lookup of %s timed out after %d ms", tn->host, tn->connect_timeout_ms);
+            return telnet_failover(tn);
+        }
+        return SUCCESS;
+    }
+    if (ret != SUCCESS) {
+        return telnet_failover(tn);
+    }
+
+    /* The socket replaces the eventfd (opened first, so the fd number
+     * changes and event loops re-register it) */
+    MB_LOG_DEBUG("Resolved %s after %lld ms", tn->host, telnet_monotonic_ms() - tn->connect_start_ms);
+    resolver_cancel(wake_fd);
+    tn->is_resolving = false;
+    tn->epoll_fd = -1;
+    ret = telnet_open_socket(tn);
+    close(epoll_fd);
+    close(wake_fd);
+
+    if (ret != SUCCESS) {
+        return telnet_failover(tn);
+    }
+    return SUCCESS;
+}
+
+/**
+ * Resolve a host and start the first connect attempt
+ * A name not in the DNS cache is resolved on the resolver thread; the
+ * connect then finishes from telnet_process_events() when it lands.
+ */
+static int telnet_open(telnet_t *tn, const char *host, int port)
+{
+    MB_LOG_INFO("Connecting to telnet server: %s:%d", host, port);
+
+    /* Save connection info */
+    SAFE_STRNCPY(tn->host, host, sizeof(tn->host));
+    tn->port = port;
+    telnet_reset_options(tn);
+    tn->race_fd = -1;
+    tn->connect_start_ms = telnet_monotonic_ms();
+
+    /* Resolve hostname (cached; IPv4 and IPv6) */
+    int wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wake_fd < 0) {
+        MB_LOG_WARNING("Failed to create resolver eventfd: %s", strerror(errno));
+        if (resolver_lookup(host, port, &tn->candidates) != SUCCESS) {
+            return ERROR_CONNECTION;
+        }
+        return telnet_open_socket(tn);
+    }
+
+    int ret = resolver_lookup_async(host, port, &tn->candidates, wake_fd);
+    if (ret == RESOLVER_PENDING) {
+        /* The eventfd stands in for the socket until the answer lands */
+        tn->fd = wake_fd;
+        tn->is_resolving = true;
+        tn->is_connecting = true;
+        if (telnet_init_epoll(tn) != SUCCESS) {
+            MB_LOG_ERROR("Failed to initialize epoll");
+            resolver_cancel(wake_fd);
+            close(wake_fd);
+            tn->fd = -1;
+            tn->is_resolving = false;
+            tn->is_connecting = false;
+            return ERROR_IO;
+        }
+        MB_LOG_INFO("Resolving %s on the resolver thread", host);
+        return SUCCESS;
+    }
+
+    close(wake_fd);
+    if (ret != SUCCESS) {
+        return ERROR_CONNECTION;
+    }
+
+    return telnet_open_socket(tn);
+}
+
+/**
+ * Connect to the best backend of the leased target not tried yet
+ * Backends that fail at once are marked down and skipped.
+ */
+static int telnet_connect_backend(telnet_t *tn)
+{
+    const dialdir_backend_t *backend;
+
+    while ((backend = dialdir_acquire(&tn->lease)) != NULL) {
+        int ret = telnet_open(tn, backend->host, backend->port);
+        if (ret == SUCCESS) {
+            return SUCCESS;
+        }
+        dialdir_report(&tn->lease, false);
+        dialdir_release(&tn->lease);
+    }
+
+    MB_LOG_ERROR("[dial.%s] no backend could be reached", tn->lease.target->name);
+    return ERROR_CONNECTION;
+}
+
+/**
+ * Give up on the current connect; a directory connect moves on to the next backend
+ */
+static int telnet_failover(telnet_t *tn)
+{
+    if (tn->lease.target == NULL) {
+        tn->is_connected = false;
+        tn->is_connecting = false;
+        return ERROR_CONNECTION;
+    }
+
+    dialdir_report(&tn->lease, false);
+    telnet_disconnect(tn);
+    return telnet_connect_backend(tn);
+}
+
+/**
+ * Connect to telnet server
+ */
+int telnet_connect(telnet_t *tn, const char *host, int port)
+{
+    if (tn == NULL || host == NULL) {
+        MB_LOG_ERROR("Invalid arguments to telnet_connect");
+        return ERROR_INVALID_ARG;
+    }
+
+    if (tn->fd >= 0) {
+        if (tn->is_connected) {
+            MB_LOG_WARNING("Already connected, disconnecting first");
+        }
+        telnet_disconnect(tn);
+    }
+    dialdir_release(&tn->lease);
+    dialdir_lease_init(&tn->lease, NULL);
+
+    return telnet_open(tn, host, port);
+}
+
+/**
+ * Connect to a dialing directory target
+ */
+int telnet_connect_target(telnet_t *tn, dialdir_target_t *target)
+{
+    if (tn == NULL || target == NULL) {
+        MB_LOG_ERROR("Invalid arguments to telnet_connect_target");
+        return ERROR_INVALID_ARG;
+    }
+
+    if (tn->fd >= 0) {
+        if (tn->is_connected) {
+            MB_LOG_WARNING("Already connected, disconnecting first");
+        }
+        telnet_disconnect(tn);
+    }
+    dialdir_release(&tn->lease);
+    dialdir_lease_init(&tn->lease, target);
+
+    MB_LOG_INFO("Dialing [dial.%s] (%d backend(s), %s)", target->name, target->count,
+               config_dial_policy_name(target->policy));
+    return telnet_connect_backend(tn);
+}
+
 /**
  * Disconnect from telnet server
  */
@@ -176,12 +989,18 @@ int telnet_disconnect(telnet_t *tn)
         return ERROR_INVALID_ARG;
     }
 
+    /* The session no longer counts against its backend */
+    dialdir_release(&tn->lease);
+
     if (tn->fd < 0) {
         return SUCCESS;  /* Already disconnected */
     }
 
     MB_LOG_INFO("Disconnecting from telnet server: %s:%d", tn->host, tn->port);
 
+    /* The next connect to this server starts from what it negotiated */
+    telnet_negcache_store(tn);
+
     /* Close epoll instance */
     if (tn->epoll_fd >= 0) {
         close(tn->epoll_fd);
@@ -189,9 +1008,18 @@ int telnet_disconnect(telnet_t *tn)
         MB_LOG_DEBUG("Epoll instance closed");
     }
 
-    /* Close socket */
+    /* Close socket (and a racing connect attempt); a pending lookup must
+     * not signal the fd once it is reused */
+    if (tn->is_resolving) {
+        resolver_cancel(tn->fd);
+        tn->is_resolving = false;
+    }
     close(tn->fd);
     tn->fd = -1;
+    if (tn->race_fd >= 0) {
+        close(tn->race_fd);
+        tn->race_fd = -1;
+    }
 
     /* Reset connection state */
     tn->is_connected = false;
@@ -204,12 +1032,16 @@ int telnet_disconnect(telnet_t *tn)
     /* Reset protocol state */
     tn->state = TELNET_STATE_DATA;
     tn->sb_len = 0;
+    tn->overflow_warned = false;
 
-    /* Reset buffers */
+    /* Reset buffers (unsent output is discarded) */
     tn->read_pos = 0;
     tn->read_len = 0;
-    tn->write_pos = 0;
-    tn->write_len = 0;
+    tn->compress_active = false;
+    tn->compress_out_full = false;
+    tn->zin_pos = 0;
+    tn->zin_len = 0;
+    telnet_outq_reset(tn);
 
     MB_LOG_INFO("Telnet disconnected");
 
@@ -232,14 +1064,7 @@ int telnet_send_command(telnet_t *tn, unsigned char command)
 
     MB_LOG_DEBUG("Sending IAC command: %d", command);
 
-    if (send(tn->fd, buf, 2, 0) < 0) {
-        if (errno != EAGAIN && errno != EWOULDBLOCK) {
-            MB_LOG_ERROR("Failed to send IAC command: %s", strerror(errno));
-            return ERROR_IO;
-        }
-    }
-
-    return SUCCESS;
+    return telnet_send_control(tn, buf, 2);
 }
 
 /**
@@ -264,14 +1089,7 @@ int telnet_send_negotiate(telnet_t *tn, unsigned char command, unsigned char opt
         datalog_write((datalog_t *)tn->datalog, DATALOG_DIR_INTERNAL, buf, 3);
     }
 
-    if (send(tn->fd, buf, 3, 0) < 0) {
-        if (errno != EAGAIN && errno != EWOULDBLOCK) {
-            MB_LOG_ERROR("Failed to send negotiation: %s", strerror(errno));
-            return ERROR_IO;
-        }
-    }
-
-    return SUCCESS;
+    return telnet_send_control(tn, buf, 3);
 }
 
 /**
@@ -312,6 +1130,85 @@ static void telnet_update_mode(telnet_t *tn)
     }
 }
 
+/* ========== MCCP2 Compression ========== */
+
+/**
+ * Check whether MCCP2 may be accepted (built with zlib, TELNET_COMPRESS on)
+ */
+static bool telnet_compress_supported(const telnet_t *tn)
+{
+#ifdef ENABLE_MCCP
+    return tn->compress_enabled;
+#else
+    (void)tn;
+    return false;
+#endif
+}
+
+#ifdef ENABLE_MCCP
+/**
+ * Start inflating the server stream (IAC SB COMPRESS2 IAC SE received)
+ * The input buffer and the inflate state are kept for the next stream.
+ */
+static int telnet_mccp_start(telnet_t *tn)
+{
+    if (tn->zin_buf == NULL) {
+        tn->zin_buf = bufpool_alloc(MAX(tn->buffer_size, BUFFER_SIZE), &tn->zin_buf_size);
+        if (tn->zin_buf == NULL) {
+            MB_LOG_ERROR("Failed to allocate MCCP2 input buffer");
+            return ERROR_GENERAL;
+        }
+        tn->zin_pos = 0;
+        tn->zin_len = 0;
+    }
+
+    if (tn->zstream == NULL) {
+        z_stream *zs = calloc(1, sizeof(z_stream));
+        if (zs == NULL || inflateInit(zs) != Z_OK) {
+            MB_LOG_ERROR("Failed to initialize MCCP2 inflater");
+            free(zs);
+            return ERROR_GENERAL;
+        }
+        tn->zstream = zs;
+    } else if (inflateReset(tn->zstream) != Z_OK) {
+        MB_LOG_ERROR("Failed to reset MCCP2 inflater");
+        return ERROR_GENERAL;
+    }
+
+    tn->compress_active = true;
+    tn->compress_out_full = false;
+    MB_LOG_INFO("MCCP2 compression started by server");
+
+    return SUCCESS;
+}
+#endif
+
+/**
+ * Hand bytes that arrived with the plain stream over to the inflater
+ * They are inserted at offset 'at' of the compressed bytes not yet read.
+ */
+static void telnet_mccp_unread(telnet_t *tn, const unsigned char *data, size_t len, size_t at)
+{
+    size_t unread = tn->zin_len - tn->zin_pos;
+
+    if (tn->zin_buf == NULL || len == 0) {
+        return;
+    }
+
+    if (len > tn->zin_buf_size - unread) {
+        MB_LOG_ERROR("MCCP2 input buffer full - %zu compressed bytes lost",
+                     len - (tn->zin_buf_size - unread));
+        len = tn->zin_buf_size - unread;
+    }
+
+    memmove(tn->zin_buf, tn->zin_buf + tn->zin_pos, unread);
+    memmove(tn->zin_buf + at + len, tn->zin_buf + at, unread - at);
+    memcpy(tn->zin_buf + at, data, len);
+    tn->zin_pos = 0;
+    tn->zin_len = unread + len;
+    tn->compress_bytes_in += len;
+}
+
 /**
  * Handle received option negotiation (RFC 855 compliant with loop prevention)
  */
@@ -322,30 +1219,28 @@ int telnet_handle_negotiate(telnet_t *tn, unsigned char command, unsigned char o
     }
 
     MB_LOG_DEBUG("Received IAC negotiation: cmd=%d opt=%d", command, option);
+    tn->neg_seen = true;
 
     switch (command) {
         case TELNET_WILL:
             /* Server will use option - only respond if state changes (RFC 855) */
-            if (option == TELOPT_BINARY || option == TELOPT_SGA || option == TELOPT_ECHO) {
-                if (!tn->remote_options[option]) {  /* State change check */
-                    tn->remote_options[option] = true;
+            if (option == TELOPT_BINARY || option == TELOPT_SGA || option == TELOPT_ECHO ||
+                (option == TELOPT_COMPRESS2 && telnet_compress_supported(tn))) {
+                if (!telnet_opt_test(&tn->remote_options, option)) {  /* State change check */
+                    telnet_opt_set(&tn->remote_options, option, true);
                     telnet_send_negotiate(tn, TELNET_DO, option);
+                    telnet_option_on(tn, true, option);
 
-                    if (option == TELOPT_BINARY) {
-                        tn->binary_remote = true;
-                        MB_LOG_INFO("Remote BINARY mode enabled");
-                    } else if (option == TELOPT_SGA) {
-                        tn->sga_remote = true;
-                        MB_LOG_INFO("Remote SGA enabled");
-                    } else if (option == TELOPT_ECHO) {
-                        tn->echo_remote = true;
-                        MB_LOG_INFO("Remote ECHO enabled");
+                    if (option == TELOPT_COMPRESS2) {
+                        MB_LOG_INFO("COMPRESS2 (MCCP2) accepted");
+                        /* Server starts the stream with SB COMPRESS2 */
                     }
                 }
+                telnet_opt_set(&tn->neg_remote, option, true);
             } else {
                 /* Reject unsupported options (only if not already rejected) */
-                if (tn->remote_options[option]) {
-                    tn->remote_options[option] = false;
+                if (telnet_opt_test(&tn->remote_options, option)) {
+                    telnet_opt_set(&tn->remote_options, option, false);
                     telnet_send_negotiate(tn, TELNET_DONT, option);
                 }
             }
@@ -354,8 +1249,9 @@ int telnet_handle_negotiate(telnet_t *tn, unsigned char command, unsigned char o
 
         case TELNET_WONT:
             /* Server won't use option - only respond if state changes */
-            if (tn->remote_options[option]) {
-                tn->remote_options[option] = false;
+            telnet_opt_set(&tn->neg_remote, option, false);
+            if (telnet_opt_test(&tn->remote_options, option)) {
+                telnet_opt_set(&tn->remote_options, option, false);
                 telnet_send_negotiate(tn, TELNET_DONT, option);
 
                 if (option == TELOPT_BINARY) {
@@ -376,29 +1272,22 @@ int telnet_handle_negotiate(telnet_t *tn, unsigned char command, unsigned char o
             /* Server wants us to use option - only respond if state changes */
             if (option == TELOPT_BINARY || option == TELOPT_SGA ||
                 option == TELOPT_TTYPE || option == TELOPT_LINEMODE) {
-                if (!tn->local_options[option]) {  /* State change check */
-                    tn->local_options[option] = true;
+                if (!telnet_opt_test(&tn->local_options, option)) {  /* State change check */
+                    telnet_opt_set(&tn->local_options, option, true);
                     telnet_send_negotiate(tn, TELNET_WILL, option);
 
-                    if (option == TELOPT_BINARY) {
-                        tn->binary_local = true;
-                        MB_LOG_INFO("Local BINARY mode enabled");
-                    } else if (option == TELOPT_SGA) {
-                        tn->sga_local = true;
-                        MB_LOG_INFO("Local SGA enabled");
-                    } else if (option == TELOPT_TTYPE) {
+                    if (option == TELOPT_TTYPE) {
                         MB_LOG_INFO("TERMINAL-TYPE negotiation accepted");
                         /* Server will send SB TTYPE SEND to request type */
-                    } else if (option == TELOPT_LINEMODE) {
-                        tn->linemode_active = true;
-                        MB_LOG_INFO("LINEMODE negotiation accepted");
-                        /* Server may send MODE subnegotiation */
                     }
                 }
+                /* BINARY and SGA are offered without asking: the DO answers the offer */
+                telnet_option_on(tn, false, option);
+                telnet_opt_set(&tn->neg_local, option, true);
             } else {
                 /* Reject unsupported options (only if not already rejected) */
-                if (tn->local_options[option]) {
-                    tn->local_options[option] = false;
+                if (telnet_opt_test(&tn->local_options, option)) {
+                    telnet_opt_set(&tn->local_options, option, false);
                     telnet_send_negotiate(tn, TELNET_WONT, option);
                 }
             }
@@ -407,8 +1296,9 @@ int telnet_handle_negotiate(telnet_t *tn, unsigned char command, unsigned char o
 
         case TELNET_DONT:
             /* Server doesn't want us to use option - only respond if state changes */
-            if (tn->local_options[option]) {
-                tn->local_options[option] = false;
+            telnet_opt_set(&tn->neg_local, option, false);
+            if (telnet_opt_test(&tn->local_options, option)) {
+                telnet_opt_set(&tn->local_options, option, false);
                 telnet_send_negotiate(tn, TELNET_WONT, option);
 
                 if (option == TELOPT_BINARY) {
@@ -467,14 +1357,7 @@ static int telnet_send_subnegotiation(telnet_t *tn, const unsigned char *data, s
         datalog_write((datalog_t *)tn->datalog, DATALOG_DIR_INTERNAL, buf, pos);
     }
 
-    if (send(tn->fd, buf, pos, 0) < 0) {
-        if (errno != EAGAIN && errno != EWOULDBLOCK) {
-            MB_LOG_ERROR("Failed to send subnegotiation: %s", strerror(errno));
-            return ERROR_IO;
-        }
-    }
-
-    return SUCCESS;
+    return telnet_send_control(tn, buf, pos);
 }
 
 /**
@@ -495,6 +1378,7 @@ int telnet_handle_subnegotiation(telnet_t *tn)
             /* TERMINAL-TYPE subnegotiation (RFC 1091) */
             if (tn->sb_len >= 2 && tn->sb_buffer[1] == TTYPE_SEND) {
                 /* Server requests terminal type - send IS response */
+                tn->neg_ttype = true;
                 unsigned char response[68];  /* 1 (option) + 1 (IS) + 64 (terminal type) + 2 safety */
                 size_t term_len = strlen(tn->terminal_type);
 
@@ -546,6 +1430,18 @@ int telnet_handle_subnegotiation(telnet_t *tn)
             }
             break;
 
+#ifdef ENABLE_MCCP
+        case TELOPT_COMPRESS2:
+            /* MCCP2: everything after IAC SE is one zlib stream */
+            if (telnet_opt_test(&tn->remote_options, TELOPT_COMPRESS2) && !tn->compress_active &&
+                telnet_mccp_start(tn) != SUCCESS) {
+                /* The rest of the session cannot be read */
+                MB_LOG_ERROR("Cannot inflate MCCP2 stream - dropping connection");
+                tn->is_connected = false;
+            }
+            break;
+#endif
+
         default:
             /* Unknown option - just log and ignore */
             MB_LOG_DEBUG("Ignoring subnegotiation for unsupported option %d", option);
@@ -555,6 +1451,74 @@ int telnet_handle_subnegotiation(telnet_t *tn)
     return SUCCESS;
 }
 
+/**
+ * Allocate the non-blocking I/O buffers from the shared slab
+ */
+static int telnet_alloc_buffers(telnet_t *tn)
+{
+    if (tn->read_buf != NULL) {
+        return SUCCESS;
+    }
+
+    tn->read_buf = bufpool_alloc(tn->buffer_size, &tn->read_buf_size);
+    if (tn->read_buf == NULL) {
+        MB_LOG_ERROR("Failed to allocate telnet read buffer (%zu bytes)", tn->buffer_size);
+        return ERROR_GENERAL;
+    }
+
+    MB_LOG_DEBUG("Telnet read buffer: %zu bytes", tn->read_buf_size);
+    return SUCCESS;
+}
+
+/**
+ * Set the size of the non-blocking I/O buffers
+ */
+void telnet_set_buffer_size(telnet_t *tn, size_t size)
+{
+    if (tn == NULL) {
+        return;
+    }
+
+    tn->buffer_size = (size > 0) ? size : BUFFER_SIZE;
+
+    /* Nothing pending: drop the old buffers so the new size applies */
+    if (tn->read_len == 0 && tn->out_bytes == 0) {
+        telnet_release_buffers(tn);
+    }
+}
+
+/**
+ * Release the non-blocking I/O buffers
+ */
+void telnet_release_buffers(telnet_t *tn)
+{
+    if (tn == NULL) {
+        return;
+    }
+
+    bufpool_free(tn->read_buf, tn->read_buf_size);
+    tn->read_buf = NULL;
+    tn->read_buf_size = 0;
+    tn->read_pos = 0;
+    tn->read_len = 0;
+
+    bufpool_free(tn->zin_buf, tn->zin_buf_size);
+    tn->zin_buf = NULL;
+    tn->zin_buf_size = 0;
+    tn->zin_pos = 0;
+    tn->zin_len = 0;
+    tn->compress_active = false;
+#ifdef ENABLE_MCCP
+    if (tn->zstream != NULL) {
+        inflateEnd(tn->zstream);
+        free(tn->zstream);
+        tn->zstream = NULL;
+    }
+#endif
+
+    telnet_outq_reset(tn);
+}
+
 /**
  * Process incoming data from telnet server (enhanced with UTF-8 safety)
  */
@@ -562,15 +1526,49 @@ int telnet_process_input(telnet_t *tn, const unsigned char *input, size_t input_
                          unsigned char *output, size_t output_size, size_t *output_len)
 {
     size_t out_pos = 0;
-    static bool overflow_warned = false;
 
     if (tn == NULL || input == NULL || output == NULL || output_len == NULL) {
         return ERROR_INVALID_ARG;
     }
 
+    /* In-place compaction: out_pos never passes i, and a sequence split at
+     * the end of this chunk continues in the next one of the same stream */
+    bool in_place = (output == input);
+
     *output_len = 0;
 
+    if (tn->raw_tcp) {
+        /* Plain TCP peer: every byte is data */
+        size_t copy_len = MIN(input_len, output_size);
+        if (!in_place) {
+            memmove(output, input, copy_len);
+        }
+        *output_len = copy_len;
+        return SUCCESS;
+    }
+
     for (size_t i = 0; i < input_len; i++) {
+        if (tn->state == TELNET_STATE_DATA) {
+            /* Fast path: move the run up to the next IAC in one go. Bytes
+             * within a UTF-8 sequence of the output end (and a full output)
+             * are left to the per-byte checks below. */
+            size_t room = (out_pos < output_size) ? output_size - out_pos : 0;
+            if (!in_place) {
+                room = (room > TELNET_UTF8_MAX_SEQ - 1) ? room - (TELNET_UTF8_MAX_SEQ - 1) : 0;
+            }
+            size_t span = input_len - i;
+            size_t run = util_find_byte(input + i, span < room ? span : room, TELNET_IAC);
+
+            if (run > 0) {
+                memmove(output + out_pos, input + i, run);
+                out_pos += run;
+                i += run;
+                if (i == input_len) {
+                    break;
+                }
+            }
+        }
+
         unsigned char c = input[i];
 
         switch (tn->state) {
@@ -581,7 +1579,8 @@ int telnet_process_input(telnet_t *tn, const unsigned char *input, size_t input_
                     /* Regular data with UTF-8 safety check */
                     if (out_pos < output_size) {
                         /* Check if this character would split a UTF-8 sequence at buffer boundary */
-                        if (is_utf8_start(c) && (out_pos + utf8_sequence_length(c) > output_size)) {
+                        if (!in_place && is_utf8_start(c) &&
+                            (out_pos + utf8_sequence_length(c) > output_size)) {
                             /* Would split UTF-8 sequence - stop processing to prevent corruption */
                             MB_LOG_DEBUG("Stopping near buffer boundary to protect UTF-8 sequence (seq_len=%d, space=%zu)",
                                        utf8_sequence_length(c), output_size - out_pos);
@@ -590,9 +1589,9 @@ int telnet_process_input(telnet_t *tn, const unsigned char *input, size_t input_
                         output[out_pos++] = c;
                     } else {
                         /* Buffer full - log warning once */
-                        if (!overflow_warned) {
+                        if (!tn->overflow_warned) {
                             MB_LOG_WARNING("Telnet input buffer full - data may be truncated (multibyte chars may break)");
-                            overflow_warned = true;
+                            tn->overflow_warned = true;
                         }
                         break;  /* Stop processing on buffer full */
                     }
@@ -700,9 +1699,17 @@ int telnet_process_input(telnet_t *tn, const unsigned char *input, size_t input_
             case TELNET_STATE_SB_IAC:
                 if (c == TELNET_SE) {
                     /* End of subnegotiation */
+                    bool was_compressed = tn->compress_active;
                     telnet_handle_subnegotiation(tn);
                     tn->sb_len = 0;
                     tn->state = TELNET_STATE_DATA;
+
+                    if (tn->compress_active && !was_compressed) {
+                        /* MCCP2 started: the rest of this input is compressed,
+                         * telnet_recv() returns it inflated */
+                        telnet_mccp_unread(tn, input + i + 1, input_len - i - 1, 0);
+                        i = input_len;
+                    }
                 } else if (c == TELNET_IAC) {
                     /* Escaped IAC in subnegotiation */
                     if (tn->sb_len < sizeof(tn->sb_buffer)) {
@@ -735,53 +1742,70 @@ int telnet_process_input(telnet_t *tn, const unsigned char *input, size_t input_
 }
 
 /**
- * Prepare data for sending to telnet server (escape IAC bytes)
+ * Escape IAC bytes (0xFF -> 0xFF 0xFF) as far as the output allows
  */
-int telnet_prepare_output(telnet_t *tn, const unsigned char *input, size_t input_len,
-                          unsigned char *output, size_t output_size, size_t *output_len)
+size_t telnet_escape_iac(const unsigned char *input, size_t input_len,
+                         unsigned char *output, size_t output_size, size_t *output_len)
 {
     size_t out_pos = 0;
+    size_t i = 0;
 
-    if (tn == NULL || input == NULL || output == NULL || output_len == NULL) {
-        return ERROR_INVALID_ARG;
-    }
+    while (i < input_len) {
+        /* Copy the run up to the next IAC, then double the IAC */
+        size_t room = output_size - out_pos;
+        size_t span = input_len - i;
+        size_t run = util_find_byte(input + i, span < room ? span : room, TELNET_IAC);
 
-    *output_len = 0;
+        memcpy(output + out_pos, input + i, run);
+        out_pos += run;
+        i += run;
 
-    size_t i;
-    for (i = 0; i < input_len; i++) {
-        unsigned char c = input[i];
+        if (i == input_len || input[i] != TELNET_IAC) {
+            /* Input consumed, or output buffer full */
+            break;
+        }
 
-        if (c == TELNET_IAC) {
-            /* Escape IAC by doubling it */
-            if (out_pos + 1 < output_size) {
-                output[out_pos++] = TELNET_IAC;
-                output[out_pos++] = TELNET_IAC;
-            } else {
-                /* Output buffer full */
-                break;
-            }
+        if (out_pos + 1 < output_size) {
+            output[out_pos++] = TELNET_IAC;
+            output[out_pos++] = TELNET_IAC;
+            i++;
         } else {
-            /* Regular character */
-            if (out_pos < output_size) {
-                output[out_pos++] = c;
-            } else {
-                /* Output buffer full */
-                break;
-            }
+            /* Output buffer full */
+            break;
         }
     }
 
     *output_len = out_pos;
+    return i;
+}
+
+/**
+ * Prepare data for sending to telnet server (escape IAC bytes)
+ */
+int telnet_prepare_output(telnet_t *tn, const unsigned char *input, size_t input_len,
+                          unsigned char *output, size_t output_size, size_t *output_len)
+{
+    if (tn == NULL || input == NULL || output == NULL || output_len == NULL) {
+        return ERROR_INVALID_ARG;
+    }
+
+    size_t taken;
+    if (tn->raw_tcp) {
+        taken = MIN(input_len, output_size);
+        memcpy(output, input, taken);
+        *output_len = taken;
+    } else {
+        taken = telnet_escape_iac(input, input_len, output, output_size, output_len);
+    }
 
     /* Warn if not all input was processed */
-    if (i < input_len) {
+    if (taken < input_len) {
         MB_LOG_WARNING("Telnet output buffer full - %zu of %zu bytes not processed (multibyte chars may break)",
-                      input_len - i, input_len);
+                      input_len - taken, input_len);
     }
 
-    if (out_pos > 0) {
-        MB_LOG_DEBUG("Telnet prepared %zu bytes -> %zu bytes", input_len, out_pos);
+    if (*output_len > 0) {
+        MB_LOG_DEBUG("Telnet prepared %zu bytes -> %zu bytes", input_len, *output_len);
     }
 
     return SUCCESS;
@@ -792,8 +1816,14 @@ int telnet_prepare_output(telnet_t *tn, const unsigned char *input, size_t input
  */
 ssize_t telnet_send(telnet_t *tn, const void *data, size_t len)
 {
-    ssize_t sent;
+    return telnet_send_stamped(tn, data, len, NULL);
+}
 
+/**
+ * Send a stamped chunk to telnet server
+ */
+ssize_t telnet_send_stamped(telnet_t *tn, const void *data, size_t len, const latency_stamp_t *stamp)
+{
     if (tn == NULL || data == NULL || tn->fd < 0) {
         return ERROR_INVALID_ARG;
     }
@@ -804,31 +1834,45 @@ ssize_t telnet_send(telnet_t *tn, const void *data, size_t len)
 
     MB_LOG_DEBUG("Telnet sending %zu bytes", len);
 
-    sent = send(tn->fd, data, len, 0);
-    if (sent < 0) {
-        if (errno == EAGAIN || errno == EWOULDBLOCK) {
-            /* Would block */
-            return 0;
-        }
-        MB_LOG_ERROR("Telnet send error: %s", strerror(errno));
-        return ERROR_IO;
-    }
+    pthread_mutex_lock(&tn->out_lock);
+    size_t accepted = telnet_outq_append(tn, data, len, stamp);
+    int ret = telnet_outq_due(tn, telnet_monotonic_us()) ? telnet_outq_send(tn) : SUCCESS;
+    pthread_mutex_unlock(&tn->out_lock);
 
-    if (sent > 0) {
-        telnet_update_activity(tn);  /* Update activity on successful send */
+    if (ret != SUCCESS) {
+        return ret;
     }
 
-    return sent;
+    return (ssize_t)accepted;
 }
 
 /**
- * Receive data from telnet server
+ * Bytes telnet_send() can accept right now
  */
-ssize_t telnet_recv(telnet_t *tn, void *buffer, size_t size)
+size_t telnet_send_space(telnet_t *tn)
 {
-    ssize_t n;
+    if (tn == NULL) {
+        return 0;
+    }
 
-    if (tn == NULL || buffer == NULL || tn->fd < 0) {
+    pthread_mutex_lock(&tn->out_lock);
+    size_t space = (size_t)(TELNET_OUTQ_SEGMENTS - tn->out_count) * tn->buffer_size;
+    if (tn->out_count > 0) {
+        const telnet_segment_t *seg =
+            &tn->out_seg[(tn->out_first + tn->out_count - 1) % TELNET_OUTQ_SEGMENTS];
+        space += seg->size - seg->tail;
+    }
+    pthread_mutex_unlock(&tn->out_lock);
+
+    return space;
+}
+
+/**
+ * Send bytes waiting in a pipe straight to the socket (SPLICE_PASSTHROUGH)
+ */
+ssize_t telnet_send_splice(telnet_t *tn, int pipe_fd, size_t len)
+{
+    if (tn == NULL || pipe_fd < 0 || tn->fd < 0) {
         return ERROR_INVALID_ARG;
     }
 
@@ -836,7 +1880,30 @@ ssize_t telnet_recv(telnet_t *tn, void *buffer, size_t size)
         return ERROR_CONNECTION;
     }
 
-    n = recv(tn->fd, buffer, size, 0);
+    pthread_mutex_lock(&tn->out_lock);
+    ssize_t sent = 0;
+    if (tn->out_bytes == 0 && len > 0) {
+        sent = splice(pipe_fd, NULL, tn->fd, NULL, len, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    }
+    pthread_mutex_unlock(&tn->out_lock);
+
+    if (sent < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+            return 0;
+        }
+        MB_LOG_ERROR("Failed to splice data to the socket: %s", strerror(errno));
+        return ERROR_IO;
+    }
+
+    return sent;
+}
+
+/**
+ * Receive from the socket
+ */
+static ssize_t telnet_recv_socket(telnet_t *tn, void *buffer, size_t size)
+{
+    ssize_t n = recv(tn->fd, buffer, size, 0);
     if (n < 0) {
         if (errno == EAGAIN || errno == EWOULDBLOCK) {
             /* No data available */
@@ -862,6 +1929,121 @@ ssize_t telnet_recv(telnet_t *tn, void *buffer, size_t size)
     return n;
 }
 
+#ifdef ENABLE_MCCP
+/**
+ * Receive through the MCCP2 inflater
+ * The socket is read only once the compressed input is used up. Bytes left
+ * over after the end of the zlib stream are plain telnet data again.
+ */
+static ssize_t telnet_mccp_recv(telnet_t *tn, unsigned char *buffer, size_t size)
+{
+    z_stream *zs = tn->zstream;
+    size_t out = 0;
+
+    while (out < size) {
+        if (tn->zin_pos == tn->zin_len) {
+            if (!tn->compress_active) {
+                break;  /* Plain again: the next call reads the socket directly */
+            }
+            ssize_t n = telnet_recv_socket(tn, tn->zin_buf, tn->zin_buf_size);
+            if (n <= 0) {
+                if (n < 0 && out == 0) {
+                    return n;
+                }
+                break;
+            }
+            tn->zin_pos = 0;
+            tn->zin_len = (size_t)n;
+            tn->compress_bytes_in += (size_t)n;
+        }
+
+        size_t avail = tn->zin_len - tn->zin_pos;
+        if (!tn->compress_active) {
+            size_t n = MIN(avail, size - out);
+            memcpy(buffer + out, tn->zin_buf + tn->zin_pos, n);
+            tn->zin_pos += n;
+            out += n;
+            continue;
+        }
+
+        zs->next_in = tn->zin_buf + tn->zin_pos;
+        zs->avail_in = (uInt)avail;
+        zs->next_out = buffer + out;
+        zs->avail_out = (uInt)(size - out);
+
+        int ret = inflate(zs, Z_SYNC_FLUSH);
+        size_t made = (size - out) - zs->avail_out;
+        tn->zin_pos += avail - zs->avail_in;
+        tn->compress_bytes_out += made;
+        out += made;
+
+        if (ret == Z_STREAM_END) {
+            tn->compress_active = false;
+            MB_LOG_INFO("MCCP2 compression ended by server");
+        } else if (ret == Z_BUF_ERROR) {
+            break;      /* No progress possible */
+        } else if (ret != Z_OK) {
+            MB_LOG_ERROR("MCCP2 inflate failed: %s", zs->msg != NULL ? zs->msg : "corrupt stream");
+            tn->compress_active = false;
+            tn->zin_pos = 0;
+            tn->zin_len = 0;
+            return ERROR_IO;
+        }
+    }
+
+    tn->compress_out_full = (out == size);
+    return (ssize_t)out;
+}
+#endif
+
+/**
+ * Receive data from telnet server
+ */
+ssize_t telnet_recv(telnet_t *tn, void *buffer, size_t size)
+{
+    if (tn == NULL || buffer == NULL || tn->fd < 0) {
+        return ERROR_INVALID_ARG;
+    }
+
+    if (!tn->is_connected) {
+        return ERROR_CONNECTION;
+    }
+
+#ifdef ENABLE_MCCP
+    if (tn->compress_active || tn->zin_pos < tn->zin_len) {
+        return telnet_mccp_recv(tn, buffer, size);
+    }
+#endif
+
+    return telnet_recv_socket(tn, buffer, size);
+}
+
+/**
+ * Check whether telnet_recv() has input that is not in the socket
+ */
+bool telnet_recv_pending(telnet_t *tn)
+{
+    if (tn == NULL) {
+        return false;
+    }
+
+    return tn->zin_pos < tn->zin_len || (tn->compress_active && tn->compress_out_full);
+}
+
+/**
+ * Get MCCP2 compression counters
+ */
+int telnet_get_compress_stats(telnet_t *tn, uint64_t *compressed, uint64_t *inflated)
+{
+    if (tn == NULL || compressed == NULL || inflated == NULL) {
+        return ERROR_INVALID_ARG;
+    }
+
+    *compressed = tn->compress_bytes_in;
+    *inflated = tn->compress_bytes_out;
+    return SUCCESS;
+}
+
 /**
  * Get file descriptor for select/poll
  */
@@ -950,8 +2132,6 @@ int telnet_init_epoll(telnet_t *tn)
     /* Initialize buffers */
     tn->read_pos = 0;
     tn->read_len = 0;
-    tn->write_pos = 0;
-    tn->write_len = 0;
 
     MB_LOG_INFO("Epoll initialized for telnet connection (fd=%d, epoll_fd=%d)", tn->fd, tn->epoll_fd);
     return SUCCESS;
@@ -1009,36 +2189,8 @@ int telnet_process_events(telnet_t *tn, int timeout_ms)
     }
 
     /* Handle connection completion for non-blocking connect */
-    if (tn->is_connecting && tn->can_write) {
-        int error = 0;
-        socklen_t len = sizeof(error);
-        if (getsockopt(tn->fd, SOL_SOCKET, SO_ERROR, &error, &len) < 0) {
-            MB_LOG_ERROR("Failed to get socket error: %s", strerror(errno));
-            tn->is_connected = false;
-            tn->is_connecting = false;
-            return ERROR_CONNECTION;
-        }
-
-        if (error == 0) {
-            /* Connection successful */
-            tn->is_connected = true;
-            tn->is_connecting = false;
-            MB_LOG_INFO("Non-blocking connection completed successfully");
-
-            /* Send initial option negotiations */
-            telnet_send_negotiate(tn, TELNET_WILL, TELOPT_BINARY);
-            telnet_send_negotiate(tn, TELNET_WILL, TELOPT_SGA);
-            telnet_send_negotiate(tn, TELNET_DO, TELOPT_SGA);
-            telnet_send_negotiate(tn, TELNET_DO, TELOPT_ECHO);
-            telnet_send_negotiate(tn, TELNET_WILL, TELOPT_TTYPE);
-            telnet_send_negotiate(tn, TELNET_WILL, TELOPT_LINEMODE);
-        } else {
-            /* Connection failed */
-            MB_LOG_ERROR("Connection failed: %s", strerror(error));
-            tn->is_connected = false;
-            tn->is_connecting = false;
-            return ERROR_CONNECTION;
-        }
+    if (tn->is_connecting) {
+        return telnet_connect_progress(tn);
     }
 
     return SUCCESS;
@@ -1084,6 +2236,14 @@ bool telnet_has_error(telnet_t *tn)
  * Queue data for writing to telnet connection (non-blocking)
  */
 int telnet_queue_write(telnet_t *tn, const void *data, size_t len)
+{
+    return telnet_queue_write_stamped(tn, data, len, NULL);
+}
+
+/**
+ * Queue a stamped chunk for writing to telnet connection (non-blocking)
+ */
+int telnet_queue_write_stamped(telnet_t *tn, const void *data, size_t len, const latency_stamp_t *stamp)
 {
     if (tn == NULL || data == NULL || tn->fd < 0) {
         return ERROR_INVALID_ARG;
@@ -1097,26 +2257,25 @@ int telnet_queue_write(telnet_t *tn, const void *data, size_t len)
         return SUCCESS;
     }
 
-    /* Check available space in write buffer */
-    size_t available_space = sizeof(tn->write_buf) - tn->write_len;
+    pthread_mutex_lock(&tn->out_lock);
+    size_t available_space = telnet_outq_space(tn);
     if (len > available_space) {
-        MB_LOG_WARNING("Write buffer full: %zu bytes needed, %zu available (dropping data)",
+        pthread_mutex_unlock(&tn->out_lock);
+        MB_LOG_WARNING("Write queue full: %zu bytes needed, %zu available (dropping data)",
                       len, available_space);
         return ERROR_BUFFER_FULL;
     }
 
-    /* Copy data to write buffer */
-    memcpy(tn->write_buf + tn->write_len, data, len);
-    tn->write_len += len;
-
-    MB_LOG_DEBUG("Queued %zu bytes for telnet write (buffer now has %zu bytes)",
-                len, tn->write_len);
+    telnet_outq_append(tn, data, len, stamp);
+    MB_LOG_DEBUG("Queued %zu bytes for telnet write (queue now has %zu bytes)",
+                len, tn->out_bytes);
+    pthread_mutex_unlock(&tn->out_lock);
 
     return SUCCESS;
 }
 
 /**
- * Process pending write data for telnet connection (enhanced with partial send handling)
+ * Send queued data whose coalescing window has ended
  */
 int telnet_flush_writes(telnet_t *tn)
 {
@@ -1124,49 +2283,94 @@ int telnet_flush_writes(telnet_t *tn)
         return ERROR_INVALID_ARG;
     }
 
-    if (!tn->can_write || tn->write_len == 0) {
-        return SUCCESS;  /* Nothing to write or not ready */
+    pthread_mutex_lock(&tn->out_lock);
+    int ret = SUCCESS;
+    if (tn->out_bytes > 0 && telnet_outq_due(tn, telnet_monotonic_us())) {
+        ret = telnet_outq_send(tn);
     }
+    pthread_mutex_unlock(&tn->out_lock);
 
-    /* Write pending data from write buffer */
-    size_t remaining = tn->write_len - tn->write_pos;
-    ssize_t sent = send(tn->fd, tn->write_buf + tn->write_pos, remaining, MSG_NOSIGNAL);
+    return ret;
+}
 
-    if (sent < 0) {
-        if (errno == EAGAIN || errno == EWOULDBLOCK) {
-            /* Would block, try again later */
-            MB_LOG_DEBUG("Write would block, %zu bytes remain pending", remaining);
-            return SUCCESS;
+/**
+ * Milliseconds until telnet_flush_writes() has data to send
+ */
+int telnet_write_timeout_ms(telnet_t *tn)
+{
+    int timeout = -1;
+
+    if (tn == NULL) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&tn->out_lock);
+    if (tn->out_bytes > 0 && !tn->out_blocked) {
+        long long now = telnet_monotonic_us();
+        if (telnet_outq_due(tn, now)) {
+            timeout = 0;
+        } else {
+            long long left = tn->out_since_us + tn->cork_us - now;
+            timeout = (int)((left + 999) / 1000);
         }
-        MB_LOG_ERROR("Failed to send pending data: %s", strerror(errno));
-        return ERROR_IO;
     }
+    pthread_mutex_unlock(&tn->out_lock);
 
-    tn->write_pos += sent;
-    MB_LOG_DEBUG("Sent %zd of %zu pending bytes, total sent: %zu", sent, remaining, tn->write_pos);
+    return timeout;
+}
 
-    /* Update activity on successful send */
-    if (sent > 0) {
-        telnet_update_activity(tn);
+/**
+ * Check whether queued output waits for the socket to become writable
+ */
+bool telnet_write_blocked(telnet_t *tn)
+{
+    if (tn == NULL) {
+        return false;
     }
 
-    /* Clear buffer if all data sent */
-    if (tn->write_pos >= tn->write_len) {
-        tn->write_pos = 0;
-        tn->write_len = 0;
-        MB_LOG_DEBUG("All pending data sent, write buffer cleared");
-    } else {
-        /* Move remaining data to beginning of buffer for better memory usage */
-        if (tn->write_pos > 0) {
-            size_t remaining_data = tn->write_len - tn->write_pos;
-            memmove(tn->write_buf, tn->write_buf + tn->write_pos, remaining_data);
-            tn->write_len = remaining_data;
-            tn->write_pos = 0;
-            MB_LOG_DEBUG("Compacted write buffer: %zu bytes remaining", remaining_data);
-        }
+    pthread_mutex_lock(&tn->out_lock);
+    bool blocked = tn->out_blocked && tn->out_bytes > 0;
+    pthread_mutex_unlock(&tn->out_lock);
+
+    return blocked;
+}
+
+/**
+ * Size the output coalescing window for the line rate
+ * TELNET_CORK_CHARS character times (10 bits each): 12.5 ms at 2400 bps,
+ * 0.5 ms at 57600 bps, capped at TELNET_CORK_MAX_US for slow lines.
+ */
+void telnet_set_line_rate(telnet_t *tn, int bps)
+{
+    if (tn == NULL) {
+        return;
     }
 
-    return SUCCESS;
+    unsigned int cork_us = 0;
+    if (bps > 0) {
+        cork_us = (unsigned int)MIN(1000000ULL * 10 * TELNET_CORK_CHARS / (unsigned int)bps,
+                                    (unsigned long long)TELNET_CORK_MAX_US);
+    }
+
+    pthread_mutex_lock(&tn->out_lock);
+    tn->cork_us = cork_us;
+    pthread_mutex_unlock(&tn->out_lock);
+
+    MB_LOG_DEBUG("Telnet output coalescing window: %u us (%d bps)", cork_us, bps);
+}
+
+/**
+ * Feed output-queue stages to a direction's histograms
+ */
+void telnet_set_latency_metrics(telnet_t *tn, metrics_direction_t *metrics)
+{
+    if (tn == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&tn->out_lock);
+    tn->out_tags.metrics = metrics;
+    pthread_mutex_unlock(&tn->out_lock);
 }
 
 /**
@@ -1180,27 +2384,25 @@ int telnet_process_reads(telnet_t *tn, unsigned char *output, size_t output_size
 
     *output_len = 0;
 
-    if (!tn->can_read) {
+    if (!tn->can_read && !telnet_recv_pending(tn)) {
         return SUCCESS;  /* No data to read */
     }
 
-    /* Read data into read buffer */
-    ssize_t received = recv(tn->fd, tn->read_buf + tn->read_len,
-                           sizeof(tn->read_buf) - tn->read_len, 0);
+    if (telnet_alloc_buffers(tn) != SUCCESS) {
+        return ERROR_GENERAL;
+    }
+
+    /* Read data into read buffer (inflated while MCCP2 is active) */
+    ssize_t received = telnet_recv(tn, tn->read_buf + tn->read_len,
+                                   tn->read_buf_size - tn->read_len);
 
     if (received < 0) {
-        if (errno == EAGAIN || errno == EWOULDBLOCK) {
-            /* No more data available */
-            return SUCCESS;
-        }
-        MB_LOG_ERROR("Failed to receive data: %s", strerror(errno));
+        MB_LOG_ERROR("Failed to receive data: %zd", received);
         return ERROR_IO;
     }
 
     if (received == 0) {
-        /* Connection closed */
-        MB_LOG_INFO("Telnet connection closed by server");
-        tn->is_connected = false;
+        /* No more data available, or connection closed */
         return SUCCESS;
     }
 
@@ -1219,6 +2421,8 @@ int telnet_process_reads(telnet_t *tn, unsigned char *output, size_t output_size
             chunk_size = BUFFER_SIZE / 2;
         }
 
+        bool was_compressed = tn->compress_active;
+        size_t zin_unread = tn->zin_len - tn->zin_pos;
         int result = telnet_process_input(tn, tn->read_buf + tn->read_pos, chunk_size,
                                         clean_output, sizeof(clean_output), &clean_len);
         if (result != SUCCESS) {
@@ -1228,6 +2432,14 @@ int telnet_process_reads(telnet_t *tn, unsigned char *output, size_t output_size
 
         tn->read_pos += chunk_size;
 
+        if (tn->compress_active && !was_compressed) {
+            /* MCCP2 started in this chunk: the rest of the read buffer
+             * follows the part of the chunk handed to the inflater */
+            telnet_mccp_unread(tn, tn->read_buf + tn->read_pos, tn->read_len - tn->read_pos,
+                               tn->zin_len - tn->zin_pos - zin_unread);
+            tn->read_pos = tn->read_len;
+        }
+
         /* Copy clean data to output if there's space */
         if (total_processed + clean_len <= output_size) {
             memcpy(output + total_processed, clean_output, clean_len);
@@ -1311,8 +2523,8 @@ int telnet_check_connection_health(telnet_t *tn)
         return ERROR_CONNECTION;
     }
 
-    /* Send keep-alive ping if needed */
-    if (now - tn->last_ping >= tn->ping_interval) {
+    /* Send keep-alive ping if needed (a raw TCP peer would see the NOP as data) */
+    if (!tn->raw_tcp && now - tn->last_ping >= tn->ping_interval) {
         MB_LOG_DEBUG("Sending telnet keep-alive ping");
 
         /* Send NOP as keep-alive (RFC 854) */
@@ -43,8 +43,6 @@ static void *telnet_thread_func(void *arg)
     while (!ctx->should_stop) {
         /* Connect if not connected */
         bool is_connected = telnet_is_connected(&ctx->telnet);
-        printf("[TELNET-THREAD-DEBUG] Loop iteration: is_connected=%d\n", is_connected);
-        fflush(stdout);
 
         if (!is_connected) {
             printf("[TELNET-THREAD-DEBUG] Not connected, checking if should reconnect...\n");
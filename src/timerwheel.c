@@ -0,0 +1,269 @@
+/*
+ * timerwheel.c - Hierarchical timer wheel for event-loop threads
+ */
+
+#include "timerwheel.h"
+#include <sys/timerfd.h>
+
+#define TIMERWHEEL_MASK         (TIMERWHEEL_SLOTS - 1)
+#define TIMERWHEEL_SPAN(level)  (1LL << (TIMERWHEEL_BITS * (level)))
+
+/**
+ * Put a timer into the slot matching its distance from the next tick
+ */
+static void timerwheel_link(timerwheel_t *tw, timerwheel_timer_t *timer)
+{
+    long long tick = tw->now_ms + 1;
+    long long when = MAX(timer->expires_ms, tick);
+    long long delta = when - tick;
+    int level = 0;
+
+    while (level < TIMERWHEEL_LEVELS - 1 && delta >= TIMERWHEEL_SPAN(level + 1)) {
+        level++;
+    }
+    if (delta >= TIMERWHEEL_SPAN(TIMERWHEEL_LEVELS)) {
+        /* Beyond the top level: park in its furthest slot */
+        when = tick + TIMERWHEEL_SPAN(TIMERWHEEL_LEVELS) - 1;
+    }
+
+    int slot = (int)((when >> (TIMERWHEEL_BITS * level)) & TIMERWHEEL_MASK);
+    timerwheel_timer_t **head = &tw->slots[level][slot];
+
+    timer->level = level;
+    timer->slot = slot;
+    timer->next = *head;
+    if (*head != NULL) {
+        (*head)->pprev = &timer->next;
+    }
+    timer->pprev = head;
+    *head = timer;
+    tw->occupied[level] |= 1ULL << slot;
+}
+
+/**
+ * Take a timer out of its slot
+ */
+static void timerwheel_unlink(timerwheel_t *tw, timerwheel_timer_t *timer)
+{
+    *timer->pprev = timer->next;
+    if (timer->next != NULL) {
+        timer->next->pprev = timer->pprev;
+    }
+    if (tw->slots[timer->level][timer->slot] == NULL) {
+        tw->occupied[timer->level] &= ~(1ULL << timer->slot);
+    }
+    timer->next = NULL;
+    timer->pprev = NULL;
+}
+
+/**
+ * Move the timers of the higher-level slots that start at t down a level
+ * (called with now_ms = t - 1)
+ */
+static void timerwheel_cascade(timerwheel_t *tw, long long t)
+{
+    for (int level = 1; level < TIMERWHEEL_LEVELS; level++) {
+        int slot = (int)((t >> (TIMERWHEEL_BITS * level)) & TIMERWHEEL_MASK);
+        timerwheel_timer_t *list = tw->slots[level][slot];
+
+        tw->slots[level][slot] = NULL;
+        tw->occupied[level] &= ~(1ULL << slot);
+        while (list != NULL) {
+            timerwheel_timer_t *next = list->next;
+            timerwheel_link(tw, list);
+            list = next;
+        }
+
+        if (slot != 0) {
+            break;
+        }
+    }
+}
+
+/**
+ * Initialize an empty wheel
+ */
+void timerwheel_init(timerwheel_t *tw, long long now_ms)
+{
+    if (tw == NULL) {
+        return;
+    }
+
+    memset(tw, 0, sizeof(timerwheel_t));
+    tw->now_ms = now_ms;
+}
+
+/**
+ * Initialize a timer (not scheduled)
+ */
+void timerwheel_timer_init(timerwheel_timer_t *timer, timerwheel_callback_t callback, void *arg)
+{
+    if (timer == NULL) {
+        return;
+    }
+
+    memset(timer, 0, sizeof(timerwheel_timer_t));
+    timer->callback = callback;
+    timer->arg = arg;
+}
+
+/**
+ * Schedule a timer, or move it if it is already scheduled
+ */
+void timerwheel_schedule(timerwheel_t *tw, timerwheel_timer_t *timer, long long expires_ms)
+{
+    if (tw == NULL || timer == NULL) {
+        return;
+    }
+
+    if (timer->pprev != NULL) {
+        if (timer->expires_ms == expires_ms) {
+            return;
+        }
+        timerwheel_unlink(tw, timer);
+        tw->count--;
+    }
+
+    timer->expires_ms = expires_ms;
+    timerwheel_link(tw, timer);
+    tw->count++;
+}
+
+/**
+ * Cancel a timer
+ */
+void timerwheel_cancel(timerwheel_t *tw, timerwheel_timer_t *timer)
+{
+    if (tw == NULL || timer == NULL || timer->pprev == NULL) {
+        return;
+    }
+
+    timerwheel_unlink(tw, timer);
+    tw->count--;
+}
+
+/**
+ * Check whether a timer is scheduled
+ */
+bool timerwheel_pending(const timerwheel_timer_t *timer)
+{
+    return timer != NULL && timer->pprev != NULL;
+}
+
+/**
+ * Run every timer that expired up to now_ms
+ */
+int timerwheel_advance(timerwheel_t *tw, long long now_ms)
+{
+    int fired = 0;
+
+    if (tw == NULL) {
+        return 0;
+    }
+
+    while (tw->now_ms < now_ms) {
+        if (tw->count == 0) {
+            tw->now_ms = now_ms;
+            break;
+        }
+
+        long long t = tw->now_ms + 1;
+        if ((t & TIMERWHEEL_MASK) == 0) {
+            timerwheel_cascade(tw, t);
+        }
+        tw->now_ms = t;
+
+        /* Callbacks may add timers to this slot for a later turn: only
+         * timers that are due are taken, one at a time */
+        int slot = (int)(t & TIMERWHEEL_MASK);
+        for (;;) {
+            timerwheel_timer_t *timer = tw->slots[0][slot];
+            while (timer != NULL && timer->expires_ms > t) {
+                timer = timer->next;
+            }
+            if (timer == NULL) {
+                break;
+            }
+            timerwheel_unlink(tw, timer);
+            tw->count--;
+            timer->callback(timer->arg);
+            fired++;
+        }
+
+        /* Nothing on level 0: skip to the next cascade */
+        if (tw->occupied[0] == 0) {
+            tw->now_ms = MIN(now_ms, t | TIMERWHEEL_MASK);
+        }
+    }
+
+    if (tw->armed_ms != 0 && tw->armed_ms <= now_ms) {
+        tw->armed_ms = 0;   /* The timerfd has fired and is disarmed */
+    }
+
+    return fired;
+}
+
+/**
+ * Earliest time the wheel needs to be advanced
+ */
+long long timerwheel_next_ms(const timerwheel_t *tw)
+{
+    long long next = -1;
+
+    if (tw == NULL || tw->count == 0) {
+        return -1;
+    }
+
+    for (int level = 0; level < TIMERWHEEL_LEVELS; level++) {
+        uint64_t bits = tw->occupied[level];
+        if (bits == 0) {
+            continue;
+        }
+
+        /* Rotate so that bit 0 is the slot after the current one */
+        int shift = TIMERWHEEL_BITS * level;
+        long long base = tw->now_ms >> shift;
+        int rot = (int)((base + 1) & TIMERWHEEL_MASK);
+        if (rot != 0) {
+            bits = (bits >> rot) | (bits << (TIMERWHEEL_SLOTS - rot));
+        }
+
+        long long when = (base + 1 + __builtin_ctzll(bits)) << shift;
+        if (next < 0 || when < next) {
+            next = when;
+        }
+    }
+
+    return next;
+}
+
+/**
+ * Program a timerfd for timerwheel_next_ms()
+ */
+int timerwheel_arm_timerfd(timerwheel_t *tw, int timer_fd)
+{
+    struct itimerspec its;
+
+    if (tw == NULL || timer_fd < 0) {
+        return ERROR_INVALID_ARG;
+    }
+
+    long long next = timerwheel_next_ms(tw);
+    long long deadline = (next < 0) ? 0 : MAX(next, 1);
+    if (deadline == tw->armed_ms) {
+        return SUCCESS;
+    }
+
+    /* it_value of zero disarms */
+    memset(&its, 0, sizeof(its));
+    its.it_value.tv_sec = deadline / 1000;
+    its.it_value.tv_nsec = (deadline % 1000) * 1000000;
+
+    if (timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &its, NULL) < 0) {
+        MB_LOG_WARNING("timerfd_settime failed: %s", strerror(errno));
+        return ERROR_IO;
+    }
+
+    tw->armed_ms = deadline;
+    return SUCCESS;
+}
@@ -0,0 +1,408 @@
+/*
+ * trace.c - Binary tracepoints for ModemBridge data paths
+ */
+
+#include "trace.h"
+#include <inttypes.h>
+#include <pthread.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+
+#define TRACE_RING_MASK         (TRACE_RING_RECORDS - 1)
+#define TRACE_RING_ALIGN        64      /* Cache line */
+
+_Static_assert((TRACE_RING_RECORDS & TRACE_RING_MASK) == 0,
+               "TRACE_RING_RECORDS must be a power of two");
+
+/* Per-thread ring: the owning thread produces, the drain thread consumes */
+typedef struct trace_ring_s {
+    trace_record_t records[TRACE_RING_RECORDS];
+    _Atomic uint32_t head;              /* Next slot to write (owner) */
+    _Atomic uint32_t tail;              /* Next slot to drain (drainer) */
+    atomic_ulong dropped;               /* Records lost to a full ring */
+    atomic_bool orphaned;               /* Owner thread has exited */
+    uint32_t thread_id;
+    struct trace_ring_s *next;
+} trace_ring_t;
+
+atomic_int g_trace_enabled = 0;
+
+static const char *trace_point_names[TRACE_POINT_COUNT] = {
+    [TRACE_SERIAL_RX]         = "serial_rx",
+    [TRACE_SERIAL_TX]         = "serial_tx",
+    [TRACE_SERIAL_READ]       = "serial_read",
+    [TRACE_BRIDGE_FORWARD]    = "bridge_forward",
+    [TRACE_BRIDGE_DROP]       = "bridge_drop",
+    [TRACE_MODEM_ONLINE_DATA] = "modem_online_data",
+    [TRACE_TIMESTAMP_SEND]    = "timestamp_send",
+    [TRACE_L3_FORWARD]        = "l3_forward",
+    [TRACE_L3_INACTIVE]       = "l3_inactive",
+    [TRACE_L3_STATE]          = "l3_state",
+    [TRACE_L3_DCD]            = "l3_dcd",
+    [TRACE_L3_LINE]           = "l3_line",
+    [TRACE_L3_ECHO]           = "l3_echo",
+    [TRACE_MODEM_HW_MESSAGE]  = "modem_hw_message",
+    [TRACE_XFER_MODE]         = "xfer_mode",
+};
+
+static atomic_bool trace_ready = false;
+static atomic_bool trace_running = false;
+static pthread_mutex_t trace_list_mutex = PTHREAD_MUTEX_INITIALIZER;
+static trace_ring_t *trace_rings = NULL;
+static pthread_t trace_thread;
+static pthread_key_t trace_key;
+static int trace_wake_fd = -1;
+static FILE *trace_file = NULL;
+static char trace_path[SMALL_BUFFER_SIZE];
+static unsigned long trace_dropped_logged = 0;
+
+static __thread trace_ring_t *trace_local = NULL;
+
+/**
+ * Thread exit hook: hand the ring over to the drain thread
+ */
+static void trace_ring_release(void *arg)
+{
+    trace_ring_t *ring = (trace_ring_t *)arg;
+
+    atomic_store_explicit(&ring->orphaned, true, memory_order_release);
+}
+
+/**
+ * Allocate and register the calling thread's ring
+ */
+static trace_ring_t *trace_ring_attach(void)
+{
+    trace_ring_t *ring = aligned_alloc(TRACE_RING_ALIGN, sizeof(trace_ring_t));
+
+    if (ring == NULL) {
+        return NULL;
+    }
+    memset(ring, 0, sizeof(*ring));
+    ring->thread_id = (uint32_t)syscall(SYS_gettid);
+
+    pthread_mutex_lock(&trace_list_mutex);
+    ring->next = trace_rings;
+    trace_rings = ring;
+    pthread_mutex_unlock(&trace_list_mutex);
+
+    pthread_setspecific(trace_key, ring);
+    trace_local = ring;
+    return ring;
+}
+
+/**
+ * Append a record to the calling thread's ring
+ */
+void trace_emit(trace_point_t point, uint64_t arg0, uint64_t arg1,
+                const void *data, size_t len)
+{
+    trace_ring_t *ring = trace_local;
+    struct timespec ts;
+
+    if (!atomic_load_explicit(&trace_ready, memory_order_acquire)) {
+        return;
+    }
+    if (ring == NULL && (ring = trace_ring_attach()) == NULL) {
+        return;
+    }
+
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+    if (head - tail >= TRACE_RING_RECORDS) {
+        atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    trace_record_t *rec = &ring->records[head & TRACE_RING_MASK];
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    rec->timestamp_ns = (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+    rec->point = (uint16_t)point;
+    rec->thread_id = ring->thread_id;
+    rec->arg0 = arg0;
+    rec->arg1 = arg1;
+    rec->data_len = (uint16_t)MIN(len, (size_t)TRACE_DATA_MAX);
+    if (rec->data_len > 0) {
+        memcpy(rec->data, data, rec->data_len);
+    }
+
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+/**
+ * Open the trace file on first use (caller holds trace_list_mutex)
+ */
+static bool trace_file_open(void)
+{
+    if (trace_file != NULL) {
+        return true;
+    }
+
+    trace_file = fopen(trace_path, "ab");
+    if (trace_file == NULL) {
+        MB_LOG_ERROR("Failed to open trace file %s: %s", trace_path, strerror(errno));
+        return false;
+    }
+    if (ftell(trace_file) == 0) {
+        fwrite(TRACE_FILE_MAGIC, 1, TRACE_FILE_MAGIC_LEN, trace_file);
+    }
+    return true;
+}
+
+/**
+ * Copy every ring to the trace file and reap rings of exited threads
+ */
+static void trace_drain_all(void)
+{
+    unsigned long dropped = 0;
+    bool wrote = false;
+
+    pthread_mutex_lock(&trace_list_mutex);
+
+    trace_ring_t **link = &trace_rings;
+    while (*link != NULL) {
+        trace_ring_t *ring = *link;
+        bool orphaned = atomic_load_explicit(&ring->orphaned, memory_order_acquire);
+        uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+        while (tail != head && trace_file_open()) {
+            uint32_t index = tail & TRACE_RING_MASK;
+            uint32_t count = MIN(head - tail, TRACE_RING_RECORDS - index);
+
+            fwrite(&ring->records[index], sizeof(trace_record_t), count, trace_file);
+            tail += count;
+            wrote = true;
+        }
+        /* Records are discarded if the file cannot be opened */
+        atomic_store_explicit(&ring->tail, head, memory_order_release);
+
+        dropped += atomic_load_explicit(&ring->dropped, memory_order_relaxed);
+
+        if (orphaned) {
+            *link = ring->next;
+            free(ring);
+        } else {
+            link = &ring->next;
+        }
+    }
+
+    if (wrote) {
+        fflush(trace_file);
+    }
+
+    pthread_mutex_unlock(&trace_list_mutex);
+
+    if (dropped > trace_dropped_logged) {
+        MB_LOG_WARNING("Trace rings full: %lu records dropped", dropped - trace_dropped_logged);
+        trace_dropped_logged = dropped;
+    }
+}
+
+/**
+ * Drain thread: sleeps until enabled, then drains every TRACE_DRAIN_MS
+ */
+static void *trace_thread_func(void *arg)
+{
+    int last_enabled = atomic_load(&g_trace_enabled);
+
+    (void)arg;
+
+    while (atomic_load(&trace_running)) {
+        int enabled = atomic_load(&g_trace_enabled);
+        struct pollfd pfd = { .fd = trace_wake_fd, .events = POLLIN, .revents = 0 };
+
+        if (poll(&pfd, 1, enabled ? TRACE_DRAIN_MS : -1) > 0) {
+            uint64_t value;
+            if (read(trace_wake_fd, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+                MB_LOG_DEBUG("Trace wakeup read failed: %s", strerror(errno));
+            }
+        }
+
+        enabled = atomic_load(&g_trace_enabled);
+        if (enabled != last_enabled) {
+            MB_LOG_INFO("Tracing %s (%s)", enabled ? "enabled" : "disabled", trace_path);
+            last_enabled = enabled;
+        }
+
+        trace_drain_all();
+    }
+
+    return NULL;
+}
+
+/**
+ * Start the drain thread
+ */
+int trace_init(const char *path, bool enabled)
+{
+    if (atomic_load(&trace_ready)) {
+        return SUCCESS;
+    }
+
+    SAFE_STRNCPY(trace_path, (path != NULL && path[0] != '\0') ? path : DEFAULT_TRACE_FILE,
+                 sizeof(trace_path));
+
+    if (pthread_key_create(&trace_key, trace_ring_release) != 0) {
+        MB_LOG_ERROR("Failed to create trace thread key");
+        return ERROR_THREAD;
+    }
+
+    trace_wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (trace_wake_fd < 0) {
+        MB_LOG_ERROR("Failed to create trace eventfd: %s", strerror(errno));
+        pthread_key_delete(trace_key);
+        return ERROR_SYSTEM;
+    }
+
+    atomic_store(&g_trace_enabled, enabled ? 1 : 0);
+    atomic_store(&trace_running, true);
+    atomic_store_explicit(&trace_ready, true, memory_order_release);
+
+    if (pthread_create(&trace_thread, NULL, trace_thread_func, NULL) != 0) {
+        MB_LOG_ERROR("Failed to create trace drain thread");
+        atomic_store(&trace_ready, false);
+        atomic_store(&trace_running, false);
+        atomic_store(&g_trace_enabled, 0);
+        close(trace_wake_fd);
+        trace_wake_fd = -1;
+        pthread_key_delete(trace_key);
+        return ERROR_THREAD;
+    }
+
+    MB_LOG_INFO("Tracepoints ready (%s, %s; toggle with SIGUSR2)",
+                trace_path, enabled ? "enabled" : "disabled");
+    return SUCCESS;
+}
+
+/**
+ * Drain remaining records, stop the drain thread and free the rings
+ */
+void trace_shutdown(void)
+{
+    uint64_t one = 1;
+
+    if (!atomic_load(&trace_ready)) {
+        return;
+    }
+
+    atomic_store(&g_trace_enabled, 0);
+    atomic_store(&trace_ready, false);
+    atomic_store(&trace_running, false);
+    if (write(trace_wake_fd, &one, sizeof(one)) < 0) {
+        MB_LOG_DEBUG("Trace wakeup write failed: %s", strerror(errno));
+    }
+    pthread_join(trace_thread, NULL);
+
+    /* Remaining threads have exited or stopped tracing: drain and free all */
+    pthread_mutex_lock(&trace_list_mutex);
+    for (trace_ring_t *ring = trace_rings; ring != NULL; ring = ring->next) {
+        atomic_store(&ring->orphaned, true);
+    }
+    pthread_mutex_unlock(&trace_list_mutex);
+    trace_drain_all();
+    trace_local = NULL;
+
+    if (trace_file != NULL) {
+        fclose(trace_file);
+        trace_file = NULL;
+    }
+    close(trace_wake_fd);
+    trace_wake_fd = -1;
+    pthread_key_delete(trace_key);
+}
+
+/**
+ * Toggle tracing (async-signal-safe)
+ */
+void trace_toggle(void)
+{
+    uint64_t one = 1;
+
+    atomic_fetch_xor(&g_trace_enabled, 1);
+    if (trace_wake_fd >= 0) {
+        /* Wake the drain thread so it starts its drain interval */
+        ssize_t ret = write(trace_wake_fd, &one, sizeof(one));
+        (void)ret;
+    }
+}
+
+/**
+ * Name of a tracepoint
+ */
+const char *trace_point_name(unsigned int point)
+{
+    if (point >= TRACE_POINT_COUNT || trace_point_names[point] == NULL) {
+        return "unknown";
+    }
+    return trace_point_names[point];
+}
+
+/**
+ * Print a trace file as text
+ */
+int trace_dump(const char *path, FILE *out)
+{
+    char magic[TRACE_FILE_MAGIC_LEN];
+    trace_record_t rec;
+    uint64_t first_ns = 0;
+    size_t count = 0;
+    FILE *fp;
+
+    if (path == NULL || out == NULL) {
+        return ERROR_INVALID_ARG;
+    }
+
+    fp = fopen(path, "rb");
+    if (fp == NULL) {
+        fprintf(stderr, "Cannot open trace file %s: %s\n", path, strerror(errno));
+        return ERROR_IO;
+    }
+
+    if (fread(magic, 1, sizeof(magic), fp) != sizeof(magic) ||
+        memcmp(magic, TRACE_FILE_MAGIC, TRACE_FILE_MAGIC_LEN) != 0) {
+        fprintf(stderr, "%s is not a ModemBridge trace file\n", path);
+        fclose(fp);
+        return ERROR_INVALID_ARG;
+    }
+
+    /* Records are grouped per thread and drain pass, not sorted: find the origin first */
+    while (fread(&rec, sizeof(rec), 1, fp) == 1) {
+        if (count++ == 0 || rec.timestamp_ns < first_ns) {
+            first_ns = rec.timestamp_ns;
+        }
+    }
+    fseek(fp, TRACE_FILE_MAGIC_LEN, SEEK_SET);
+    count = 0;
+
+    while (fread(&rec, sizeof(rec), 1, fp) == 1) {
+        count++;
+
+        fprintf(out, "%14.6f %7u %-18s %10" PRIu64 " %10" PRIu64,
+                (double)(rec.timestamp_ns - first_ns) / 1e9,
+                rec.thread_id, trace_point_name(rec.point), rec.arg0, rec.arg1);
+
+        if (rec.data_len > 0) {
+            size_t len = MIN((size_t)rec.data_len, (size_t)TRACE_DATA_MAX);
+
+            fputs("  ", out);
+            for (size_t i = 0; i < len; i++) {
+                fprintf(out, "%02x", rec.data[i]);
+            }
+            fputs("  |", out);
+            for (size_t i = 0; i < len; i++) {
+                fputc((rec.data[i] >= 0x20 && rec.data[i] < 0x7f) ? rec.data[i] : '.', out);
+            }
+            fputc('|', out);
+        }
+        fputc('\n', out);
+    }
+
+    fclose(fp);
+    fprintf(out, "%zu records\n", count);
+    return SUCCESS;
+}
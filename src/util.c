@@ -7,6 +7,12 @@
 #include "util.h"
 #include "common.h"
 
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 static uint64_t get_current_time_ms(void)
 {
     struct timeval tv;
@@ -358,4 +364,60 @@ void util_stats_print(util_stats_t *stats, const char *operation_name)
            (double)stats->successful_operations / stats->total_operations * 100.0 : 0.0);
     printf("  Total Bytes: %lu\n", stats->total_bytes);
     printf("  Average Latency: %.2f ms\n", stats->average_latency_ms);
-}
\ No newline at end of file
+}
+
+/* Byte scanning
+ * Returns the offset of the first occurrence of byte in data, or len if
+ * there is none. The vector width is picked at compile time; scalar code
+ * only handles the tail shorter than one vector. */
+size_t util_find_byte(const unsigned char *data, size_t len, unsigned char byte)
+{
+    size_t i = 0;
+
+    if (!data) return len;
+
+#if defined(__AVX2__)
+    const __m256i needle32 = _mm256_set1_epi8((char)byte);
+    for (; i + 32 <= len; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(data + i));
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, needle32));
+        if (mask != 0) {
+            return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i needle16 = _mm_set1_epi8((char)byte);
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(data + i));
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(v, needle16));
+        if (mask != 0) {
+            return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+#elif defined(__ARM_NEON)
+    const uint8x16_t needle16 = vdupq_n_u8(byte);
+    for (; i + 16 <= len; i += 16) {
+        uint8x16_t eq = vceqq_u8(vld1q_u8(data + i), needle16);
+        /* Narrow each 0x00/0xFF lane to a nibble: 64-bit mask, 4 bits per byte */
+        uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(
+            vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+        if (mask != 0) {
+            return i + (size_t)(__builtin_ctzll(mask) >> 2);
+        }
+    }
+#else
+    {
+        const unsigned char *hit = memchr(data, byte, len);
+        return hit ? (size_t)(hit - data) : len;
+    }
+#endif
+
+    for (; i < len; i++) {
+        if (data[i] == byte) {
+            return i;
+        }
+    }
+
+    return len;
+}
@@ -0,0 +1,331 @@
+/*
+ * xfer.c - File transfer detection for the binary fast path
+ */
+
+#include "xfer.h"
+#include "util.h"
+#include "trace.h"
+
+#define XFER_SOH        0x01    /* XMODEM 128-byte block */
+#define XFER_STX        0x02    /* XMODEM-1K / YMODEM 1024-byte block */
+#define XFER_EOT        0x04
+#define XFER_ACK        0x06
+#define XFER_NAK        0x15
+#define XFER_CAN        0x18
+#define XFER_ZDLE       XFER_CAN
+
+/* ZMODEM frame types */
+#define XFER_ZRQINIT    0
+#define XFER_ZRINIT     1
+#define XFER_ZFIN       8
+
+static const char *const xfer_protocol_names[] = {
+    [XFER_NONE]          = "none",
+    [XFER_XMODEM]        = "XMODEM",
+    [XFER_ZMODEM]        = "ZMODEM",
+    [XFER_TELNET_BINARY] = "telnet binary"
+};
+
+/**
+ * Initialize a detector
+ */
+void xfer_init(xfer_detect_t *xf, bool enabled, bool telnet_binary)
+{
+    if (xf == NULL) {
+        return;
+    }
+
+    memset(xf, 0, sizeof(*xf));
+    xf->enabled = enabled;
+    xf->telnet_binary = telnet_binary;
+    atomic_init(&xf->protocol, XFER_NONE);
+    atomic_init(&xf->sender, XFER_FROM_MODEM);
+    atomic_init(&xf->last_ms, 0);
+    atomic_init(&xf->transfers, 0);
+    for (int d = 0; d < XFER_DIR_COUNT; d++) {
+        atomic_init(&xf->side[d].handshake_ms, 0);
+        atomic_init(&xf->side[d].zfin, false);
+        atomic_init(&xf->side[d].eot, false);
+    }
+}
+
+/**
+ * Name of a transfer protocol
+ */
+const char *xfer_protocol_name(xfer_protocol_t protocol)
+{
+    if ((unsigned int)protocol >= ARRAY_SIZE(xfer_protocol_names)) {
+        return "unknown";
+    }
+    return xfer_protocol_names[protocol];
+}
+
+/**
+ * Switch to raw mode from XFER_NONE (unless another thread changed it first)
+ */
+static void xfer_enter(xfer_detect_t *xf, xfer_protocol_t protocol, xfer_dir_t dir, long long now_ms)
+{
+    int expected = XFER_NONE;
+
+    if (!atomic_compare_exchange_strong(&xf->protocol, &expected, protocol)) {
+        return;
+    }
+
+    for (int d = 0; d < XFER_DIR_COUNT; d++) {
+        atomic_store(&xf->side[d].zfin, false);
+        atomic_store(&xf->side[d].eot, false);
+    }
+    atomic_store(&xf->sender, dir);
+    atomic_store(&xf->last_ms, now_ms);
+    atomic_fetch_add(&xf->transfers, 1);
+    MB_TRACE(TRACE_XFER_MODE, protocol, dir);
+    MB_LOG_INFO("File transfer started: %s (%s), raw mode on", xfer_protocol_name(protocol),
+                dir == XFER_FROM_MODEM ? "terminal sends" : "server sends");
+}
+
+/**
+ * Leave raw mode if protocol is still the one in progress
+ */
+static void xfer_leave(xfer_detect_t *xf, xfer_protocol_t protocol, const char *reason)
+{
+    int expected = protocol;
+
+    if (atomic_compare_exchange_strong(&xf->protocol, &expected, XFER_NONE)) {
+        MB_TRACE(TRACE_XFER_MODE, XFER_NONE, protocol);
+        MB_LOG_INFO("File transfer ended: %s (%s), raw mode off", xfer_protocol_name(protocol), reason);
+    }
+}
+
+/**
+ * Leave raw mode and forget handshakes of a previous session
+ */
+void xfer_reset(xfer_detect_t *xf)
+{
+    if (xf == NULL) {
+        return;
+    }
+
+    atomic_store(&xf->protocol, XFER_NONE);
+    for (int d = 0; d < XFER_DIR_COUNT; d++) {
+        atomic_store(&xf->side[d].handshake_ms, 0);
+        atomic_store(&xf->side[d].zfin, false);
+        atomic_store(&xf->side[d].eot, false);
+    }
+}
+
+/**
+ * Type of a ZMODEM hex header ("*" ZDLE "B0" type digit) with ZDLE at p
+ * @return Frame type 0-9, -1 if no complete header starts there
+ */
+static int xfer_zhex_type(const unsigned char *buf, size_t len, size_t p)
+{
+    if (p == 0 || p + 3 >= len) {
+        return -1;
+    }
+    if (buf[p - 1] != '*' || buf[p + 1] != 'B' || buf[p + 2] != '0' ||
+        buf[p + 3] < '0' || buf[p + 3] > '9') {
+        return -1;
+    }
+    return buf[p + 3] - '0';
+}
+
+/**
+ * Find ZMODEM hex headers and CAN runs in one chunk
+ * Only ZDLE (CAN) positions are examined. Headers split across chunks are
+ * found in the carried tail followed by the start of this chunk.
+ * @param side Scan state of the direction
+ * @param data Chunk
+ * @param len Chunk length (> 0)
+ * @param max_can Receives the longest CAN run, counting one carried over
+ * @return Bit mask of the frame types seen
+ */
+static unsigned int xfer_scan_zmodem(xfer_side_t *side, const unsigned char *data, size_t len,
+                                     size_t *max_can)
+{
+    unsigned int types = 0;
+    int type;
+
+    /* Headers across the chunk boundary */
+    unsigned char win[2 * XFER_TAIL];
+    size_t head = MIN(len, XFER_TAIL);
+    memcpy(win, side->tail, side->tail_len);
+    memcpy(win + side->tail_len, data, head);
+    size_t win_len = side->tail_len + head;
+
+    for (size_t p = 1; p <= side->tail_len && p < win_len; p++) {
+        if (win[p] == XFER_ZDLE && (type = xfer_zhex_type(win, win_len, p)) >= 0) {
+            types |= 1u << type;
+        }
+    }
+
+    /* Headers and CAN runs within the chunk */
+    size_t best = 0;
+    size_t run = side->can_run;
+    size_t p = util_find_byte(data, len, XFER_ZDLE);
+    if (p != 0) {
+        run = 0;
+    }
+    while (p < len) {
+        size_t q = p;
+        while (q < len && data[q] == XFER_ZDLE) {
+            q++;
+        }
+        run += q - p;
+        best = MAX(best, run);
+
+        if ((type = xfer_zhex_type(data, len, p)) >= 0) {
+            types |= 1u << type;
+        }
+        if (q == len) {
+            break;
+        }
+        run = 0;
+        p = q + util_find_byte(data + q, len - q, XFER_ZDLE);
+    }
+    side->can_run = (data[len - 1] == XFER_ZDLE) ? run : 0;
+
+    /* Keep the last bytes for the next chunk */
+    if (len >= XFER_TAIL) {
+        memcpy(side->tail, data + len - XFER_TAIL, XFER_TAIL);
+        side->tail_len = XFER_TAIL;
+    } else {
+        size_t keep = MIN(win_len, XFER_TAIL);
+        memmove(side->tail, win + win_len - keep, keep);
+        side->tail_len = keep;
+    }
+
+    *max_can = best;
+    return types;
+}
+
+/**
+ * Count CAN bytes ending a chunk; all-CAN chunks extend the carried run
+ * @return true if the chunk is nothing but CAN
+ */
+static bool xfer_track_can(xfer_side_t *side, const unsigned char *data, size_t len)
+{
+    size_t n = 0;
+
+    while (n < len && data[len - 1 - n] == XFER_CAN) {
+        n++;
+    }
+    side->can_run = (n == len) ? side->can_run + n : n;
+    side->tail_len = 0;     /* Not a ZMODEM stream: nothing to carry */
+
+    return n == len;
+}
+
+/**
+ * Scan one chunk before it is queued for the other side
+ */
+bool xfer_scan(xfer_detect_t *xf, xfer_dir_t dir, const unsigned char *data, size_t len,
+               long long now_ms)
+{
+    if (xf == NULL || !xf->enabled || data == NULL || len == 0) {
+        return false;
+    }
+
+    xfer_side_t *side = &xf->side[dir];
+    xfer_side_t *other = &xf->side[dir == XFER_FROM_MODEM ? XFER_FROM_TELNET : XFER_FROM_MODEM];
+    xfer_protocol_t protocol = (xfer_protocol_t)atomic_load(&xf->protocol);
+    unsigned char last = data[len - 1];
+    size_t max_can;
+
+    switch (protocol) {
+        case XFER_NONE: {
+            unsigned int types = xfer_scan_zmodem(side, data, len, &max_can);
+            if (types & ((1u << XFER_ZRQINIT) | (1u << XFER_ZRINIT))) {
+                xfer_enter(xf, XFER_ZMODEM, dir, now_ms);
+                return true;
+            }
+
+            /* XMODEM block (number, then its complement) answering the
+             * receiver's NAK or 'C' */
+            long long handshake = atomic_load(&other->handshake_ms);
+            if (len >= 3 && (data[0] == XFER_SOH || data[0] == XFER_STX) &&
+                (unsigned char)(data[1] ^ data[2]) == 0xFF &&
+                handshake > 0 && now_ms - handshake <= XFER_HANDSHAKE_MS) {
+                xfer_enter(xf, XFER_XMODEM, dir, now_ms);
+                return true;
+            }
+
+            if (last == XFER_NAK || last == 'C' || last == XFER_ACK) {
+                atomic_store(&side->handshake_ms, now_ms);
+            }
+            return false;
+        }
+
+        case XFER_ZMODEM: {
+            atomic_store(&xf->last_ms, now_ms);
+            unsigned int types = xfer_scan_zmodem(side, data, len, &max_can);
+            if (max_can >= XFER_ZMODEM_ABORT) {
+                xfer_leave(xf, protocol, "cancelled");
+            } else if (types & (1u << XFER_ZFIN)) {
+                atomic_store(&side->zfin, true);
+                if (atomic_load(&other->zfin)) {
+                    xfer_leave(xf, protocol, "ZFIN both ways");
+                }
+            }
+            return true;
+        }
+
+        case XFER_XMODEM:
+            atomic_store(&xf->last_ms, now_ms);
+            if (xfer_track_can(side, data, len) && side->can_run >= 2) {
+                xfer_leave(xf, protocol, "cancelled");
+            } else if ((int)dir == atomic_load(&xf->sender)) {
+                if (len == 1 && last == XFER_EOT) {
+                    atomic_store(&side->eot, true);
+                }
+            } else if (last == XFER_ACK && atomic_load(&other->eot)) {
+                xfer_leave(xf, protocol, "EOT acknowledged");
+            }
+            if (last == XFER_NAK || last == 'C' || last == XFER_ACK) {
+                atomic_store(&side->handshake_ms, now_ms);
+            }
+            return true;
+
+        case XFER_TELNET_BINARY:
+        default:
+            return true;
+    }
+}
+
+/**
+ * Follow the TELOPT_BINARY state
+ */
+void xfer_set_binary(xfer_detect_t *xf, bool both)
+{
+    if (xf == NULL || !xf->enabled || !xf->telnet_binary) {
+        return;
+    }
+
+    int protocol = atomic_load(&xf->protocol);
+    if (both && protocol == XFER_NONE) {
+        xfer_enter(xf, XFER_TELNET_BINARY, XFER_FROM_TELNET, 0);
+    } else if (!both && protocol == XFER_TELNET_BINARY) {
+        xfer_leave(xf, XFER_TELNET_BINARY, "binary option off");
+    }
+}
+
+/**
+ * Check for raw mode, ending it when the transfer went idle
+ */
+bool xfer_active(xfer_detect_t *xf, long long now_ms)
+{
+    if (xf == NULL) {
+        return false;
+    }
+
+    xfer_protocol_t protocol = (xfer_protocol_t)atomic_load(&xf->protocol);
+    if (protocol == XFER_NONE) {
+        return false;
+    }
+
+    if (protocol != XFER_TELNET_BINARY && now_ms - atomic_load(&xf->last_ms) > XFER_IDLE_MS) {
+        xfer_leave(xf, protocol, "idle");
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,704 @@
+/*
+ * level3_test.c - Self-tests for the Level 3 buffer and allocator code
+ *
+ * Exercises the concurrent pieces of level3.c that the bridge only hits
+ * under load, with real threads, so a regression fails the build instead
+ * of corrupting a session.
+ *
+ * Tests:
+ *   pool          l3_memory_pool_t: alignment, exhaustion, out-of-order
+ *                 free and reuse, double/foreign free rejection
+ *   pool_mt       l3_memory_pool_t: threads allocating, stamping and
+ *                 freeing blocks at once; any overlap shows as a torn stamp
+ *   dbuf_pool     l3_double_buffer_t draws its chunks from its pool
+ *   dbuf_takeover l3_double_buffer_t: a partial chunk left by an idle
+ *                 producer reaches the consumer; reserve/commit and
+ *                 peek/consume spans
+ *   dbuf_mt       l3_double_buffer_t: producer and consumer threads move a
+ *                 numbered byte stream through write and reserve/commit,
+ *                 read and peek/consume, with producer pauses that force
+ *                 takeovers; every byte must arrive once and in order
+ *   ring_resize   l3_enhanced_double_buffer_t: writes and reads across the
+ *                 end of the memfd ring, grow and shrink while the data
+ *                 straddles the end (deferred) and while it does not
+ *
+ * Build: make check (builds and runs) or make build/mb_test
+ * Usage: build/mb_test [test,...]     exit status 0 when every check passes
+ */
+
+#include "common.h"
+#include "level3.h"
+#include <pthread.h>
+#include <sched.h>
+
+#ifndef ENABLE_LEVEL3
+#error "level3_test needs a Level 3 build"
+#endif
+
+/* Check bookkeeping */
+static int g_checks;
+static int g_failures;
+static FILE *g_report;              /* Report stream (stdout is silenced) */
+
+#define CHECK(cond) do { \
+        g_checks++; \
+        if (!(cond)) { \
+            g_failures++; \
+            fprintf(g_report, "  FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        } \
+    } while (0)
+
+/* ========== l3_memory_pool_t ========== */
+
+#define POOL_TEST_BLOCKS    16
+#define POOL_TEST_BLOCK     200         /* Rounded up to L3_POOL_ALIGN */
+
+static void test_pool(void)
+{
+    l3_memory_pool_t pool;
+    unsigned char *blocks[POOL_TEST_BLOCKS];
+
+    CHECK(l3_memory_pool_init(&pool, POOL_TEST_BLOCKS * 256, POOL_TEST_BLOCK) == L3_SUCCESS);
+    CHECK(pool.block_size == 256);
+    CHECK(pool.total_blocks == POOL_TEST_BLOCKS);
+
+    /* Every block is aligned, inside the pool and distinct */
+    for (int i = 0; i < POOL_TEST_BLOCKS; i++) {
+        blocks[i] = l3_memory_pool_alloc(&pool);
+        CHECK(blocks[i] != NULL);
+        CHECK(((uintptr_t)blocks[i] % L3_POOL_ALIGN) == 0);
+        CHECK(blocks[i] >= pool.pool_memory &&
+              blocks[i] + pool.block_size <= pool.pool_memory + pool.pool_size);
+        memset(blocks[i], i, pool.block_size);
+    }
+    for (int i = 0; i < POOL_TEST_BLOCKS; i++) {
+        for (int j = i + 1; j < POOL_TEST_BLOCKS; j++) {
+            CHECK(blocks[i] != blocks[j]);
+        }
+    }
+
+    /* Exhausted: refused and counted */
+    CHECK(l3_memory_pool_alloc(&pool) == NULL);
+    CHECK(atomic_load(&pool.alloc_failures) == 1);
+    CHECK(atomic_load(&pool.high_water) == POOL_TEST_BLOCKS);
+
+    /* Free every other block out of order; the survivors keep their bytes */
+    for (int i = POOL_TEST_BLOCKS - 2; i >= 0; i -= 2) {
+        CHECK(l3_memory_pool_free(&pool, blocks[i]) == L3_SUCCESS);
+    }
+    CHECK(atomic_load(&pool.allocated_blocks) == POOL_TEST_BLOCKS / 2);
+    l3_memory_pool_update_metrics(&pool);
+    CHECK(pool.free_blocks == POOL_TEST_BLOCKS / 2);
+    CHECK(pool.free_list_length == POOL_TEST_BLOCKS / 2);
+    CHECK(pool.largest_free_block == pool.block_size);
+
+    /* Reallocation hands back exactly the freed blocks */
+    for (int i = 0; i < POOL_TEST_BLOCKS; i += 2) {
+        unsigned char *block = l3_memory_pool_alloc(&pool);
+        bool was_freed = false;
+        for (int j = 0; j < POOL_TEST_BLOCKS; j += 2) {
+            was_freed = was_freed || block == blocks[j];
+        }
+        CHECK(was_freed);
+        memset(block, 0xEE, pool.block_size);
+    }
+    for (int i = 1; i < POOL_TEST_BLOCKS; i += 2) {
+        bool intact = true;
+        for (size_t k = 0; k < pool.block_size; k++) {
+            intact = intact && blocks[i][k] == (unsigned char)i;
+        }
+        CHECK(intact);
+    }
+
+    /* Double, foreign and interior frees are refused and change nothing */
+    CHECK(l3_memory_pool_free(&pool, blocks[1]) == L3_SUCCESS);
+    CHECK(l3_memory_pool_free(&pool, blocks[1]) == L3_ERROR_INVALID_PARAM);
+    unsigned char foreign[64];
+    CHECK(l3_memory_pool_free(&pool, foreign) == L3_ERROR_INVALID_PARAM);
+    CHECK(l3_memory_pool_free(&pool, blocks[3] + 8) == L3_ERROR_INVALID_PARAM);
+    CHECK(atomic_load(&pool.allocated_blocks) == POOL_TEST_BLOCKS - 1);
+    CHECK(atomic_load(&pool.free_count) == POOL_TEST_BLOCKS / 2 + 1);
+
+    /* The freed block comes back once, not twice */
+    CHECK(l3_memory_pool_alloc(&pool) == blocks[1]);
+    CHECK(l3_memory_pool_alloc(&pool) == NULL);
+
+    l3_memory_pool_cleanup(&pool);
+    CHECK(pool.pool_memory == NULL);
+}
+
+#define POOL_MT_THREADS     4
+#define POOL_MT_ROUNDS      200000
+#define POOL_MT_HOLD        3           /* Blocks each thread holds at once */
+#define POOL_MT_BLOCKS      (POOL_MT_THREADS * POOL_MT_HOLD - 2)   /* Some allocs must fail */
+
+typedef struct {
+    l3_memory_pool_t *pool;
+    unsigned id;
+    uint64_t torn;                  /* Blocks whose stamp changed under us */
+    uint64_t bad_frees;
+} pool_mt_worker_t;
+
+static void *pool_mt_worker(void *arg)
+{
+    pool_mt_worker_t *w = arg;
+    l3_memory_pool_t *pool = w->pool;
+    unsigned char *held[POOL_MT_HOLD] = { NULL };
+
+    for (unsigned round = 0; round < POOL_MT_ROUNDS; round++) {
+        unsigned slot = round % POOL_MT_HOLD;
+
+        if (held[slot] != NULL) {
+            /* Still carries our stamp: nobody else was handed this block */
+            uint32_t stamp = (w->id << 24) | (round - POOL_MT_HOLD);
+            uint32_t seen[2];
+            memcpy(&seen[0], held[slot], sizeof(seen[0]));
+            memcpy(&seen[1], held[slot] + pool->block_size - sizeof(seen[1]), sizeof(seen[1]));
+            if (seen[0] != stamp || seen[1] != stamp) {
+                w->torn++;
+            }
+            if (l3_memory_pool_free(pool, held[slot]) != L3_SUCCESS) {
+                w->bad_frees++;
+            }
+            held[slot] = NULL;
+        }
+
+        unsigned char *block = l3_memory_pool_alloc(pool);
+        if (block != NULL) {
+            uint32_t stamp = (w->id << 24) | round;
+            memcpy(block, &stamp, sizeof(stamp));
+            memcpy(block + pool->block_size - sizeof(stamp), &stamp, sizeof(stamp));
+            held[slot] = block;
+        }
+    }
+
+    for (unsigned slot = 0; slot < POOL_MT_HOLD; slot++) {
+        if (held[slot] != NULL && l3_memory_pool_free(pool, held[slot]) != L3_SUCCESS) {
+            w->bad_frees++;
+        }
+    }
+    return NULL;
+}
+
+static void test_pool_mt(void)
+{
+    l3_memory_pool_t pool;
+    pthread_t threads[POOL_MT_THREADS];
+    pool_mt_worker_t workers[POOL_MT_THREADS];
+
+    CHECK(l3_memory_pool_init(&pool, POOL_MT_BLOCKS * L3_POOL_ALIGN, L3_POOL_ALIGN) == L3_SUCCESS);
+
+    for (unsigned i = 0; i < POOL_MT_THREADS; i++) {
+        workers[i] = (pool_mt_worker_t){ .pool = &pool, .id = i + 1 };
+        CHECK(pthread_create(&threads[i], NULL, pool_mt_worker, &workers[i]) == 0);
+    }
+
+    uint64_t torn = 0;
+    uint64_t bad_frees = 0;
+    for (unsigned i = 0; i < POOL_MT_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+        torn += workers[i].torn;
+        bad_frees += workers[i].bad_frees;
+    }
+
+    CHECK(torn == 0);
+    CHECK(bad_frees == 0);
+    CHECK(atomic_load(&pool.allocated_blocks) == 0);
+    CHECK(atomic_load(&pool.allocation_count) == atomic_load(&pool.free_count));
+    CHECK(atomic_load(&pool.allocation_count) + atomic_load(&pool.alloc_failures) ==
+          (uint64_t)POOL_MT_THREADS * POOL_MT_ROUNDS);
+    CHECK(atomic_load(&pool.high_water) <= POOL_MT_BLOCKS);
+
+    /* The free list still links every block exactly once */
+    unsigned char *blocks[POOL_MT_BLOCKS];
+    for (int i = 0; i < POOL_MT_BLOCKS; i++) {
+        blocks[i] = l3_memory_pool_alloc(&pool);
+        CHECK(blocks[i] != NULL);
+        for (int j = 0; j < i; j++) {
+            CHECK(blocks[i] != blocks[j]);
+        }
+    }
+    CHECK(l3_memory_pool_alloc(&pool) == NULL);
+    for (int i = 0; i < POOL_MT_BLOCKS; i++) {
+        CHECK(l3_memory_pool_free(&pool, blocks[i]) == L3_SUCCESS);
+    }
+
+    fprintf(g_report, "  %llu allocations, %llu refused, peak %zu of %d blocks\n",
+            (unsigned long long)atomic_load(&pool.allocation_count),
+            (unsigned long long)atomic_load(&pool.alloc_failures),
+            atomic_load(&pool.high_water), POOL_MT_BLOCKS);
+    l3_memory_pool_cleanup(&pool);
+}
+
+/* ========== l3_double_buffer_t ========== */
+
+static void test_dbuf_pool(void)
+{
+    l3_double_buffer_t dbuf;
+    l3_buffer_metrics_t metrics;
+
+    CHECK(l3_double_buffer_init(&dbuf, 1000) == L3_SUCCESS);
+    CHECK(dbuf.capacity >= 1000);
+    CHECK(dbuf.pool.total_blocks == L3_DOUBLE_BUFFER_CHUNKS);
+
+    CHECK(l3_double_buffer_get_metrics(&dbuf, &metrics) == L3_SUCCESS);
+    CHECK(metrics.pool_blocks_in_use == L3_DOUBLE_BUFFER_CHUNKS);
+    CHECK(metrics.pool_high_water == L3_DOUBLE_BUFFER_CHUNKS);
+    CHECK(metrics.current_usage == 0);
+
+    unsigned char data[300];
+    memset(data, 'x', sizeof(data));
+    CHECK(l3_double_buffer_write(&dbuf, data, sizeof(data)) == sizeof(data));
+    CHECK(l3_double_buffer_get_metrics(&dbuf, &metrics) == L3_SUCCESS);
+    CHECK(metrics.current_usage == sizeof(data));
+
+    /* Destroy returns every chunk and releases the pool */
+    l3_double_buffer_destroy(&dbuf);
+    CHECK(dbuf.pool.pool_memory == NULL);
+    CHECK(l3_double_buffer_get_metrics(&dbuf, &metrics) == L3_ERROR_INVALID_PARAM);
+}
+
+static void test_dbuf_takeover(void)
+{
+    l3_double_buffer_t dbuf;
+    unsigned char out[64];
+
+    CHECK(l3_double_buffer_init(&dbuf, 256) == L3_SUCCESS);
+
+    /* A partial chunk is not handed off: the first empty read marks the
+     * producer as possibly busy, the second takes the chunk over */
+    CHECK(l3_double_buffer_write(&dbuf, (const unsigned char *)"0123456789", 10) == 10);
+    CHECK(dbuf.handoffs == 1);          /* Ready slot was free: published at once */
+    CHECK(l3_double_buffer_read(&dbuf, out, sizeof(out)) == 10);
+    CHECK(memcmp(out, "0123456789", 10) == 0);
+
+    CHECK(l3_double_buffer_write(&dbuf, (const unsigned char *)"abc", 3) == 3);
+    CHECK(l3_double_buffer_write(&dbuf, (const unsigned char *)"def", 3) == 3);
+    CHECK(l3_double_buffer_available(&dbuf) == 6);
+
+    /* Not while the producer holds its chunk (inside reserve/commit) */
+    size_t granted = 0;
+    CHECK(l3_double_buffer_reserve(&dbuf, 10, &granted) != NULL);
+    CHECK(l3_double_buffer_read(&dbuf, out, sizeof(out)) == 3);     /* "abc" was published */
+    CHECK(memcmp(out, "abc", 3) == 0);
+    CHECK(l3_double_buffer_read(&dbuf, out, sizeof(out)) == 0);     /* "def" held by producer */
+    CHECK(dbuf.takeovers == 0);
+    l3_double_buffer_commit(&dbuf, 0);
+
+    CHECK(l3_double_buffer_read(&dbuf, out, sizeof(out)) == 3);     /* Producer idle: taken over */
+    CHECK(memcmp(out, "def", 3) == 0);
+    CHECK(dbuf.takeovers == 1);
+    CHECK(l3_double_buffer_available(&dbuf) == 0);
+
+    /* The producer keeps going on the chunk it got back */
+    CHECK(l3_double_buffer_write(&dbuf, (const unsigned char *)"jkl", 3) == 3);
+    CHECK(l3_double_buffer_read(&dbuf, out, sizeof(out)) == 3);
+    CHECK(memcmp(out, "jkl", 3) == 0);
+
+    /* Reserve/commit fills in place; a partial commit counts only what was written */
+    unsigned char *span = l3_double_buffer_reserve(&dbuf, 100, &granted);
+    CHECK(span != NULL && granted == 100);
+    memset(span, 'r', granted);
+    l3_double_buffer_commit(&dbuf, 40);
+    CHECK(l3_double_buffer_available(&dbuf) == 40);
+    span = l3_double_buffer_reserve(&dbuf, 1000, &granted);
+    CHECK(span != NULL && granted > 0 && granted <= dbuf.capacity);
+    l3_double_buffer_commit(&dbuf, 0);
+    CHECK(l3_double_buffer_available(&dbuf) == 40);
+
+    /* Peek/consume drains the same bytes without copying */
+    size_t len = 0;
+    const unsigned char *peek = l3_double_buffer_peek(&dbuf, &len);
+    CHECK(peek != NULL && len == 40);
+    CHECK(peek[0] == 'r' && peek[39] == 'r');
+    l3_double_buffer_consume(&dbuf, 15);
+    peek = l3_double_buffer_peek(&dbuf, &len);
+    CHECK(len == 25);
+    l3_double_buffer_consume(&dbuf, len);
+    CHECK(l3_double_buffer_available(&dbuf) == 0);
+
+    /* Full: the producer's chunk and the ready chunk, no more */
+    unsigned char fill[512];
+    memset(fill, 'f', sizeof(fill));
+    size_t accepted = 0;
+    for (int i = 0; i < 8; i++) {
+        accepted += l3_double_buffer_write(&dbuf, fill, sizeof(fill));
+    }
+    CHECK(accepted == dbuf.capacity * 2);
+    CHECK(l3_double_buffer_free(&dbuf) == 0);
+    CHECK(dbuf.bytes_dropped > 0);
+
+    l3_double_buffer_destroy(&dbuf);
+}
+
+#define DBUF_MT_CAPACITY    4096
+#define DBUF_MT_BYTES       (32u * 1024 * 1024)
+#define DBUF_MT_PAUSE_EVERY (256u * 1024)      /* Producer goes idle with a partial chunk */
+#define DBUF_MT_TIMEOUT_S   30
+
+/* Byte n of the stream (period 251 so it never lines up with chunk sizes) */
+static inline unsigned char dbuf_mt_byte(size_t n)
+{
+    return (unsigned char)(n % 251);
+}
+
+typedef struct {
+    l3_double_buffer_t *dbuf;
+    atomic_bool stop;               /* Consumer gave up (timeout) */
+    size_t reserved_bytes;          /* Bytes the producer sent through reserve/commit */
+    size_t peeked_bytes;            /* Bytes the consumer took through peek/consume */
+    size_t received;
+    size_t first_bad;               /* Offset of the first wrong byte (SIZE_MAX = none) */
+} dbuf_mt_state_t;
+
+static void *dbuf_mt_producer(void *arg)
+{
+    dbuf_mt_state_t *st = arg;
+    l3_double_buffer_t *dbuf = st->dbuf;
+    unsigned char buf[1500];
+    size_t sent = 0;
+    size_t next_pause = DBUF_MT_PAUSE_EVERY;
+    unsigned seed = 1;
+
+    while (sent < DBUF_MT_BYTES && !atomic_load(&st->stop)) {
+        seed = seed * 1103515245u + 12345u;
+        size_t want = MIN(1 + (seed >> 16) % sizeof(buf), DBUF_MT_BYTES - sent);
+        size_t done = 0;
+
+        if (seed & 0x80000000u) {
+            /* Zero-copy path */
+            size_t granted = 0;
+            unsigned char *span = l3_double_buffer_reserve(dbuf, want, &granted);
+            for (size_t i = 0; i < granted; i++) {
+                span[i] = dbuf_mt_byte(sent + i);
+            }
+            l3_double_buffer_commit(dbuf, granted);
+            done = granted;
+            st->reserved_bytes += granted;
+        } else {
+            /* Copy path, sized to the free space so a full buffer is not an overflow */
+            want = MIN(want, l3_double_buffer_free(dbuf));
+            for (size_t i = 0; i < want; i++) {
+                buf[i] = dbuf_mt_byte(sent + i);
+            }
+            done = want > 0 ? l3_double_buffer_write(dbuf, buf, want) : 0;
+        }
+
+        sent += done;
+        if (done == 0) {
+            sched_yield();
+        }
+
+        /* Go quiet with whatever is in the current chunk */
+        if (sent >= next_pause) {
+            next_pause += DBUF_MT_PAUSE_EVERY;
+            usleep(200);
+        }
+    }
+    return NULL;
+}
+
+static void *dbuf_mt_consumer(void *arg)
+{
+    dbuf_mt_state_t *st = arg;
+    l3_double_buffer_t *dbuf = st->dbuf;
+    unsigned char buf[2048];
+    time_t deadline = time(NULL) + DBUF_MT_TIMEOUT_S;
+    unsigned turn = 0;
+
+    st->first_bad = SIZE_MAX;
+    while (st->received < DBUF_MT_BYTES) {
+        size_t len = 0;
+        const unsigned char *data;
+
+        if (turn++ & 1) {
+            data = l3_double_buffer_peek(dbuf, &len);
+            len = MIN(len, 777);
+        } else {
+            len = l3_double_buffer_read(dbuf, buf, sizeof(buf));
+            data = buf;
+        }
+
+        for (size_t i = 0; i < len && st->first_bad == SIZE_MAX; i++) {
+            if (data[i] != dbuf_mt_byte(st->received + i)) {
+                st->first_bad = st->received + i;
+            }
+        }
+        if (data != buf && len > 0) {
+            l3_double_buffer_consume(dbuf, len);
+            st->peeked_bytes += len;
+        }
+        st->received += len;
+
+        if (len == 0) {
+            if (time(NULL) > deadline) {
+                atomic_store(&st->stop, true);
+                break;
+            }
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void test_dbuf_mt(void)
+{
+    l3_double_buffer_t dbuf;
+    dbuf_mt_state_t st = { .dbuf = &dbuf };
+    pthread_t producer, consumer;
+
+    CHECK(l3_double_buffer_init(&dbuf, DBUF_MT_CAPACITY) == L3_SUCCESS);
+    atomic_init(&st.stop, false);
+
+    CHECK(pthread_create(&consumer, NULL, dbuf_mt_consumer, &st) == 0);
+    CHECK(pthread_create(&producer, NULL, dbuf_mt_producer, &st) == 0);
+    pthread_join(producer, NULL);
+    pthread_join(consumer, NULL);
+
+    CHECK(!atomic_load(&st.stop));
+    CHECK(st.received == DBUF_MT_BYTES);
+    CHECK(st.first_bad == SIZE_MAX);
+    CHECK(l3_double_buffer_available(&dbuf) == 0);
+    CHECK(atomic_load(&dbuf.bytes_written) == DBUF_MT_BYTES);
+    CHECK(dbuf.bytes_dropped == 0);
+    CHECK(dbuf.handoffs > 0);
+    CHECK(dbuf.takeovers > 0);
+    CHECK(st.reserved_bytes > 0 && st.reserved_bytes < DBUF_MT_BYTES);
+    CHECK(st.peeked_bytes > 0 && st.peeked_bytes < DBUF_MT_BYTES);
+
+    fprintf(g_report, "  %u bytes, %llu handoffs, %llu takeovers, %zu via reserve, %zu via peek\n",
+            DBUF_MT_BYTES, (unsigned long long)dbuf.handoffs,
+            (unsigned long long)dbuf.takeovers, st.reserved_bytes, st.peeked_bytes);
+    if (st.first_bad != SIZE_MAX) {
+        fprintf(g_report, "  first wrong byte at offset %zu\n", st.first_bad);
+    }
+    l3_double_buffer_destroy(&dbuf);
+}
+
+/* ========== l3_enhanced_double_buffer_t ========== */
+
+/* Stream bookkeeping for the ring tests */
+typedef struct {
+    l3_enhanced_double_buffer_t *ebuf;
+    size_t sent;
+    size_t received;
+    bool intact;                    /* Every byte read so far was the expected one */
+} ring_stream_t;
+
+static size_t ring_put(ring_stream_t *rs, size_t len)
+{
+    unsigned char buf[4 * 4096];
+    size_t done = 0;
+
+    while (done < len) {
+        size_t n = MIN(len - done, sizeof(buf));
+        for (size_t i = 0; i < n; i++) {
+            buf[i] = dbuf_mt_byte(rs->sent + i);
+        }
+        size_t wrote = l3_enhanced_double_buffer_write(rs->ebuf, buf, n);
+        rs->sent += wrote;
+        done += wrote;
+        if (wrote < n) {
+            break;
+        }
+    }
+    return done;
+}
+
+static size_t ring_take(ring_stream_t *rs, size_t len)
+{
+    unsigned char buf[4 * 4096];
+    size_t done = 0;
+
+    while (done < len) {
+        size_t got = l3_enhanced_double_buffer_read(rs->ebuf, buf, MIN(len - done, sizeof(buf)));
+        for (size_t i = 0; i < got; i++) {
+            rs->intact = rs->intact && buf[i] == dbuf_mt_byte(rs->received + i);
+        }
+        rs->received += got;
+        done += got;
+        if (got == 0) {
+            break;
+        }
+    }
+    return done;
+}
+
+/* Both copies of the mapping show the same bytes */
+static bool ring_mirrored(const l3_enhanced_double_buffer_t *ebuf)
+{
+    return memcmp(ebuf->data, ebuf->data + ebuf->buffer_size, ebuf->buffer_size) == 0;
+}
+
+static void test_ring_resize(void)
+{
+    l3_enhanced_double_buffer_t ebuf;
+    ring_stream_t rs = { .ebuf = &ebuf, .intact = true };
+    l3_buffer_metrics_t metrics;
+    size_t q = (size_t)sysconf(_SC_PAGESIZE) / 4;   /* Quarter page */
+
+    CHECK(l3_enhanced_double_buffer_init(&ebuf, 8 * q, 4 * q, 32 * q) == L3_SUCCESS);
+    CHECK(ebuf.buffer_size == 8 * q);
+
+    /* Only explicit resizes, and no watermark drops: this is about the mapping */
+    ebuf.config.adaptive_sizing_enabled = false;
+    ebuf.config.backpressure_enabled = false;
+
+    /* Wrap: the second write runs across the end of the ring in one span */
+    CHECK(ring_put(&rs, 6 * q) == 6 * q);
+    CHECK(ring_take(&rs, 6 * q) == 6 * q);
+    CHECK(ring_put(&rs, 4 * q) == 4 * q);
+    CHECK(ebuf.read_pos == 6 * q && ebuf.read_pos + ebuf.used > ebuf.buffer_size);
+    CHECK(ring_mirrored(&ebuf));
+    CHECK(ring_take(&rs, 4 * q) == 4 * q);
+    CHECK(ebuf.read_pos == 2 * q);
+    CHECK(rs.intact);
+
+    /* Grow while queued data straddles the end: deferred, nothing moves */
+    CHECK(ring_put(&rs, 7 * q) == 7 * q);                  /* [2q, 9q) */
+    CHECK(l3_resize_buffer(&ebuf, 16 * q) == L3_SUCCESS);
+    CHECK(ebuf.buffer_size == 8 * q);
+    CHECK(ebuf.pending_resize == 16 * q);
+    CHECK(ebuf.read_pos == 2 * q);
+    CHECK(l3_get_buffer_metrics(&ebuf, &metrics) == L3_SUCCESS);
+    CHECK(metrics.resize_deferred == 1);
+    CHECK(metrics.resize_events == 0);
+
+    /* Still a working 8q ring while the resize waits */
+    CHECK(ring_put(&rs, 4 * q) == q);                      /* Full */
+    CHECK(ring_take(&rs, 2 * q) == 2 * q);                 /* [4q, 12q) still straddles */
+    CHECK(ebuf.pending_resize == 16 * q);
+    CHECK(ebuf.buffer_size == 8 * q);
+
+    /* Reading past the end lets the grow complete, bytes in place */
+    CHECK(ring_take(&rs, 4 * q) == 4 * q);                 /* [0, 2q) */
+    CHECK(ebuf.pending_resize == 0);
+    CHECK(ebuf.buffer_size == 16 * q);
+    CHECK(ebuf.read_pos == 0 && ebuf.used == 2 * q);
+    CHECK(ring_mirrored(&ebuf));
+    CHECK(l3_get_buffer_metrics(&ebuf, &metrics) == L3_SUCCESS);
+    CHECK(metrics.resize_events == 1);
+    CHECK(metrics.resize_deferred == 1);
+    CHECK(metrics.resize_failures == 0);
+    CHECK(metrics.max_resize_latency_us >= metrics.last_resize_latency_us);
+    CHECK(ring_take(&rs, 2 * q) == 2 * q);
+    CHECK(rs.intact);
+    CHECK(rs.received == rs.sent);
+
+    /* The larger ring fills and wraps */
+    CHECK(ring_put(&rs, 13 * q) == 13 * q);
+    CHECK(ring_take(&rs, 12 * q) == 12 * q);
+    CHECK(ring_put(&rs, 16 * q) == 15 * q);                /* [14q, 30q) */
+    CHECK(ring_mirrored(&ebuf));
+    CHECK(ring_take(&rs, 16 * q) == 16 * q);
+    CHECK(rs.intact);
+
+    /* Shrink with the data clear of the cut: immediate */
+    CHECK(ring_put(&rs, 4 * q) == 4 * q);
+    CHECK(ring_take(&rs, 4 * q) == 4 * q);
+    CHECK(ring_put(&rs, q) == q);                          /* [2q, 3q) */
+    CHECK(l3_resize_buffer(&ebuf, 4 * q) == L3_SUCCESS);
+    CHECK(ebuf.buffer_size == 4 * q && ebuf.pending_resize == 0);
+    CHECK(l3_get_buffer_metrics(&ebuf, &metrics) == L3_SUCCESS);
+    CHECK(metrics.resize_events == 2);
+    CHECK(metrics.resize_deferred == 1);
+    CHECK(ring_take(&rs, q) == q);
+    CHECK(rs.intact);
+
+    /* An empty ring resizes at once (and restarts at offset 0) */
+    CHECK(l3_resize_buffer(&ebuf, 16 * q) == L3_SUCCESS);
+    CHECK(ebuf.buffer_size == 16 * q && ebuf.read_pos == 0);
+
+    /* Shrink while data straddles the new end: deferred until it is read */
+    CHECK(ring_put(&rs, 10 * q) == 10 * q);
+    CHECK(ring_take(&rs, 6 * q) == 6 * q);                 /* [6q, 10q) */
+    CHECK(l3_resize_buffer(&ebuf, 8 * q) == L3_SUCCESS);
+    CHECK(ebuf.buffer_size == 16 * q);
+    CHECK(l3_get_buffer_metrics(&ebuf, &metrics) == L3_SUCCESS);
+    CHECK(metrics.resize_deferred == 2);
+    CHECK(metrics.resize_events == 3);
+    CHECK(ring_take(&rs, q) == q);                         /* [7q, 10q) still in the way */
+    CHECK(ebuf.buffer_size == 16 * q);
+    CHECK(ring_take(&rs, 3 * q) == 3 * q);
+    CHECK(ebuf.buffer_size == 8 * q);
+    CHECK(l3_get_buffer_metrics(&ebuf, &metrics) == L3_SUCCESS);
+    CHECK(metrics.resize_events == 4);
+    CHECK(metrics.resize_deferred == 2);
+    CHECK(metrics.resize_failures == 0);
+
+    /* And the shrunk ring still wraps correctly */
+    CHECK(ring_put(&rs, 6 * q) == 6 * q);
+    CHECK(ring_take(&rs, 4 * q) == 4 * q);
+    CHECK(ring_put(&rs, 4 * q) == 4 * q);                  /* [4q, 10q) */
+    CHECK(ring_mirrored(&ebuf));
+    CHECK(ring_take(&rs, 8 * q) == 6 * q);
+    CHECK(rs.intact);
+    CHECK(rs.received == rs.sent);
+
+    l3_enhanced_double_buffer_cleanup(&ebuf);
+    CHECK(ebuf.data == NULL && ebuf.memfd == -1);
+}
+
+/* ========== Driver ========== */
+
+typedef struct {
+    const char *name;
+    void (*run)(void);
+} l3_test_t;
+
+static const l3_test_t tests[] = {
+    { "pool",       test_pool },
+    { "pool_mt",    test_pool_mt },
+    { "dbuf_pool",  test_dbuf_pool },
+    { "dbuf_takeover", test_dbuf_takeover },
+    { "dbuf_mt",    test_dbuf_mt },
+    { "ring_resize", test_ring_resize },
+};
+
+static bool selected(const char *only, const char *name)
+{
+    if (only == NULL) {
+        return true;
+    }
+
+    size_t len = strlen(name);
+    for (const char *p = only; (p = strstr(p, name)) != NULL; p += len) {
+        if ((p == only || p[-1] == ',') && (p[len] == '\0' || p[len] == ',')) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *only = argc > 1 ? argv[1] : NULL;
+
+    /* The Level 3 code logs to stdout; keep the report readable */
+    g_report = fdopen(dup(STDOUT_FILENO), "w");
+    int devnull = open("/dev/null", O_WRONLY);
+    if (g_report == NULL || devnull < 0) {
+        return EXIT_FAILURE;
+    }
+    setvbuf(g_report, NULL, _IOLBF, 0);
+    fflush(stdout);
+    dup2(devnull, STDOUT_FILENO);
+    close(devnull);
+
+    int failed_tests = 0;
+    int run = 0;
+    for (size_t i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+        if (!selected(only, tests[i].name)) {
+            continue;
+        }
+        int failures = g_failures;
+        fprintf(g_report, "%s\n", tests[i].name);
+        tests[i].run();
+        fprintf(g_report, "  %s\n", g_failures == failures ? "ok" : "FAILED");
+        failed_tests += g_failures != failures;
+        run++;
+    }
+
+    fprintf(g_report, "%d tests, %d checks, %d failed\n", run, g_checks, g_failures);
+    return (run > 0 && failed_tests == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,799 @@
+/*
+ * micro_bench.c - Microbenchmarks for the ModemBridge byte-processing kernels
+ *
+ * Times the per-byte hot paths on synthetic corpora, so a change to one
+ * kernel can be measured in isolation and compared between builds.
+ *
+ * Kernels:
+ *   cbuf          cbuf_write() until full, then cbuf_read() until empty
+ *   ts_cbuf       ts_cbuf_write()/ts_cbuf_read(), same pattern
+ *   telnet_in     telnet_process_input() (IAC parsing, telnet->serial)
+ *   telnet_out    telnet_prepare_output() (IAC escaping, serial->telnet)
+ *   ansi          ansi_filter_modem_to_telnet()
+ *   hayes         l3_filter_hayes_commands() in online mode (Level 3 builds)
+ *   dbuf          l3_double_buffer_write()/read(), same pattern (Level 3 builds)
+ *   datalog       datalog_write() (producer side; binary log in $TMPDIR)
+ *
+ * Corpora (generated, same bytes on every run):
+ *   ascii         plain text lines with CRLF
+ *   ansi          BBS screens: cursor moves, SGR colour runs, CP437 box art
+ *   iac           text with escaped 0xFF (IAC IAC), IAC GA and IAC NOP
+ *   binary        uniformly random bytes (file transfer payload)
+ *
+ * Method: the process is pinned to one CPU, each kernel/corpus pair gets
+ * warm-up passes, then timed passes feed the corpus in fixed-size chunks.
+ * The median pass gives ns/byte and cycles/byte (TSC reference cycles on
+ * x86, not reported elsewhere); the fastest pass is reported as well.
+ *
+ * Results go to a JSON file with one result object per line. Given a
+ * previous file (-C), each result is also shown relative to it.
+ *
+ * Build: make bench (builds and runs) or make build/mb_bench
+ * Usage: build/mb_bench [-c cpu] [-k chunk] [-m KiB] [-r runs] [-w warmup]
+ *                       [-s kernel,...] [-l label] [-o out.json] [-C base.json]
+ */
+
+#include "common.h"
+#include "config.h"
+#include "telnet.h"
+#include "bridge.h"
+#include "datalog.h"
+#ifdef ENABLE_LEVEL3
+#include "level3.h"
+#include "hayes.h"
+#endif
+#include <getopt.h>
+#include <sched.h>
+#include <sys/utsname.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAVE_TSC  1
+#endif
+
+#ifndef ENABLE_LEVEL2
+#error "micro_bench needs a Level 2 or Level 3 build (telnet support)"
+#endif
+
+#define BENCH_MAX_RUNS      1000
+#define BENCH_RING_SIZE     16384   /* Buffer kernels: ring / chunk capacity */
+#define BENCH_MAX_RESULTS   64
+
+/* One synthetic corpus */
+typedef struct {
+    const char *name;
+    unsigned char *data;
+    size_t len;
+} bench_corpus_t;
+
+/* State shared by the kernels (each uses its own part) */
+typedef struct {
+    unsigned char *out;
+    size_t out_size;
+    unsigned char *drain;           /* Read side of the buffer kernels */
+    circular_buffer_t cbuf;
+    ts_circular_buffer_t ts_cbuf;
+    telnet_t telnet;
+    ansi_state_t ansi;
+#ifdef ENABLE_LEVEL3
+    hayes_filter_context_t hayes;
+    l3_double_buffer_t dbuf;
+#endif
+    datalog_t datalog;
+    char datalog_path[256];
+    uint64_t dropped;               /* Records datalog_write() lost in the last pass */
+    uint64_t dropped_base;
+} bench_state_t;
+
+/* One kernel */
+typedef struct {
+    const char *name;
+    int (*setup)(bench_state_t *st);
+    size_t (*run)(bench_state_t *st, const unsigned char *in, size_t len);
+    void (*finish)(bench_state_t *st);      /* End of a pass (NULL = nothing) */
+    void (*teardown)(bench_state_t *st);
+} bench_kernel_t;
+
+/* One kernel/corpus result */
+typedef struct {
+    const char *kernel;
+    const char *corpus;
+    size_t bytes;                   /* Corpus bytes per pass */
+    size_t out_bytes;               /* Kernel output per pass */
+    double ns_per_byte;             /* Median pass */
+    double ns_per_byte_min;         /* Fastest pass */
+    double cycles_per_byte;         /* Median pass, < 0 if no TSC */
+    uint64_t dropped;
+} bench_result_t;
+
+/* Options */
+static size_t g_chunk = 512;
+static size_t g_corpus_kib = 1024;
+static int g_runs = 15;
+static int g_warmup = 3;
+static int g_cpu = -1;              /* -1 = the CPU we start on */
+static const char *g_label = "";
+static const char *g_only = NULL;
+static FILE *g_report;              /* Report stream (stdout is silenced) */
+
+/* ========== Helpers ========== */
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t cycles(void)
+{
+#ifdef BENCH_HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+static uint64_t median_u64(uint64_t *v, int n)
+{
+    qsort(v, (size_t)n, sizeof(*v), cmp_u64);
+    return (n % 2) ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2;
+}
+
+static bool selected(const char *name)
+{
+    if (g_only == NULL) {
+        return true;
+    }
+
+    size_t len = strlen(name);
+    for (const char *p = g_only; (p = strstr(p, name)) != NULL; p += len) {
+        if ((p == g_only || p[-1] == ',') && (p[len] == '\0' || p[len] == ',')) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* ========== Corpora ========== */
+
+static uint64_t g_rng = 0x9E3779B97F4A7C15ULL;
+
+static uint32_t rnd(void)
+{
+    /* xorshift64*: fixed seed, so every build sees the same bytes */
+    g_rng ^= g_rng >> 12;
+    g_rng ^= g_rng << 25;
+    g_rng ^= g_rng >> 27;
+    return (uint32_t)((g_rng * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+static const char *const corpus_words[] = {
+    "the", "modem", "line", "carrier", "connect", "board", "message", "file",
+    "area", "sysop", "download", "upload", "welcome", "caller", "node", "time",
+    "left", "menu", "select", "option", "press", "return", "continue", "bytes"
+};
+
+static void put(bench_corpus_t *c, size_t cap, const void *p, size_t n)
+{
+    n = MIN(n, cap - c->len);
+    memcpy(c->data + c->len, p, n);
+    c->len += n;
+}
+
+static void put_str(bench_corpus_t *c, size_t cap, const char *s)
+{
+    put(c, cap, s, strlen(s));
+}
+
+static void put_words(bench_corpus_t *c, size_t cap, int count)
+{
+    for (int i = 0; i < count; i++) {
+        put_str(c, cap, corpus_words[rnd() % ARRAY_SIZE(corpus_words)]);
+        put_str(c, cap, (i + 1 < count) ? " " : "");
+    }
+}
+
+static void corpus_ascii(bench_corpus_t *c, size_t cap)
+{
+    while (c->len < cap) {
+        put_words(c, cap, 4 + (int)(rnd() % 10));
+        put_str(c, cap, ".\r\n");
+    }
+}
+
+static void corpus_ansi(bench_corpus_t *c, size_t cap)
+{
+    static const unsigned char box[] = { 0xB0, 0xB1, 0xB2, 0xC4, 0xCD, 0xB3, 0xBA, 0xDB };
+    char seq[32];
+
+    while (c->len < cap) {
+        if (rnd() % 64 == 0) {
+            put_str(c, cap, "\x1b[2J\x1b[H");
+        }
+        snprintf(seq, sizeof(seq), "\x1b[%u;%uH", 1 + rnd() % 24, 1 + rnd() % 60);
+        put_str(c, cap, seq);
+        for (int run = (int)(1 + rnd() % 4); run > 0; run--) {
+            snprintf(seq, sizeof(seq), "\x1b[%u;%u;%um", rnd() % 2, 30 + rnd() % 8, 40 + rnd() % 8);
+            put_str(c, cap, seq);
+            if (rnd() % 2) {
+                for (int i = (int)(2 + rnd() % 12); i > 0; i--) {
+                    put(c, cap, &box[rnd() % sizeof(box)], 1);
+                }
+            } else {
+                put_words(c, cap, 1 + (int)(rnd() % 3));
+            }
+        }
+        put_str(c, cap, "\x1b[0m\r\n");
+    }
+}
+
+static void corpus_iac(bench_corpus_t *c, size_t cap)
+{
+    static const unsigned char iac_iac[] = { 0xFF, 0xFF };
+    static const unsigned char iac_ga[] = { 0xFF, 0xF9 };
+    static const unsigned char iac_nop[] = { 0xFF, 0xF1 };
+
+    while (c->len < cap) {
+        for (int i = (int)(8 + rnd() % 24); i > 0; i--) {
+            uint32_t r = rnd() % 8;
+            if (r == 0) {
+                put(c, cap, iac_iac, sizeof(iac_iac));
+            } else {
+                unsigned char ch = (unsigned char)(0x20 + rnd() % 0x5F);
+                put(c, cap, &ch, 1);
+            }
+        }
+        put_str(c, cap, "\r\n");
+        put(c, cap, (rnd() % 2) ? iac_ga : iac_nop, 2);
+    }
+}
+
+static void corpus_binary(bench_corpus_t *c, size_t cap)
+{
+    while (c->len < cap) {
+        uint32_t r = rnd();
+        put(c, cap, &r, sizeof(r));
+    }
+}
+
+static void corpus_build(bench_corpus_t *c, const char *name, size_t cap,
+                         void (*gen)(bench_corpus_t *, size_t))
+{
+    c->name = name;
+    c->data = malloc(cap);
+    c->len = 0;
+    if (c->data == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+    gen(c, cap);
+}
+
+/* ========== Kernels ========== */
+
+static int setup_cbuf(bench_state_t *st)
+{
+    return cbuf_init(&st->cbuf, BENCH_RING_SIZE);
+}
+
+static void drain_cbuf(bench_state_t *st)
+{
+    while (cbuf_read(&st->cbuf, st->drain, g_chunk) > 0) {
+    }
+}
+
+static size_t run_cbuf(bench_state_t *st, const unsigned char *in, size_t len)
+{
+    size_t n = cbuf_write(&st->cbuf, in, len);
+
+    if (n < len) {
+        drain_cbuf(st);
+        n += cbuf_write(&st->cbuf, in + n, len - n);
+    }
+    return n;
+}
+
+static void teardown_cbuf(bench_state_t *st)
+{
+    cbuf_destroy(&st->cbuf);
+}
+
+static int setup_ts_cbuf(bench_state_t *st)
+{
+    return ts_cbuf_init(&st->ts_cbuf, BENCH_RING_SIZE);
+}
+
+static void drain_ts_cbuf(bench_state_t *st)
+{
+    while (ts_cbuf_read(&st->ts_cbuf, st->drain, g_chunk) > 0) {
+    }
+}
+
+static size_t run_ts_cbuf(bench_state_t *st, const unsigned char *in, size_t len)
+{
+    size_t n = ts_cbuf_write(&st->ts_cbuf, in, len);
+
+    if (n < len) {
+        drain_ts_cbuf(st);
+        n += ts_cbuf_write(&st->ts_cbuf, in + n, len - n);
+    }
+    return n;
+}
+
+static void teardown_ts_cbuf(bench_state_t *st)
+{
+    ts_cbuf_destroy(&st->ts_cbuf);
+}
+
+static int setup_telnet(bench_state_t *st)
+{
+    telnet_init(&st->telnet);
+    return SUCCESS;
+}
+
+static size_t run_telnet_in(bench_state_t *st, const unsigned char *in, size_t len)
+{
+    size_t out_len = 0;
+
+    telnet_process_input(&st->telnet, in, len, st->out, st->out_size, &out_len);
+    return out_len;
+}
+
+static size_t run_telnet_out(bench_state_t *st, const unsigned char *in, size_t len)
+{
+    size_t out_len = 0;
+
+    telnet_prepare_output(&st->telnet, in, len, st->out, st->out_size, &out_len);
+    return out_len;
+}
+
+static int setup_ansi(bench_state_t *st)
+{
+    st->ansi = ANSI_STATE_NORMAL;
+    return SUCCESS;
+}
+
+static size_t run_ansi(bench_state_t *st, const unsigned char *in, size_t len)
+{
+    size_t out_len = 0;
+
+    ansi_filter_modem_to_telnet(in, len, st->out, st->out_size, &out_len, &st->ansi);
+    return out_len;
+}
+
+#ifdef ENABLE_LEVEL3
+static int setup_hayes(bench_state_t *st)
+{
+    /* Online mode, as on a connected line */
+    memset(&st->hayes, 0, sizeof(st->hayes));
+    st->hayes.state = HAYES_STATE_NORMAL;
+    st->hayes.in_online_mode = true;
+    hayes_escape_reset(&st->hayes.escape, l3_get_timestamp_ms());
+    return SUCCESS;
+}
+
+static size_t run_hayes(bench_state_t *st, const unsigned char *in, size_t len)
+{
+    size_t out_len = 0;
+
+    l3_filter_hayes_commands(&st->hayes, in, len, st->out, st->out_size, &out_len,
+                             l3_get_timestamp_ms());
+    return out_len;
+}
+
+static int setup_dbuf(bench_state_t *st)
+{
+    return l3_double_buffer_init(&st->dbuf, BENCH_RING_SIZE) == L3_SUCCESS ? SUCCESS : ERROR_GENERAL;
+}
+
+static void drain_dbuf(bench_state_t *st)
+{
+    while (l3_double_buffer_read(&st->dbuf, st->drain, g_chunk) > 0) {
+    }
+}
+
+static size_t run_dbuf(bench_state_t *st, const unsigned char *in, size_t len)
+{
+    size_t n = l3_double_buffer_write(&st->dbuf, in, len);
+
+    if (n < len) {
+        drain_dbuf(st);
+        n += l3_double_buffer_write(&st->dbuf, in + n, len - n);
+    }
+    return n;
+}
+
+static void teardown_dbuf(bench_state_t *st)
+{
+    l3_double_buffer_destroy(&st->dbuf);
+}
+#endif
+
+static int setup_datalog(bench_state_t *st)
+{
+    const char *dir = getenv("TMPDIR");
+
+    snprintf(st->datalog_path, sizeof(st->datalog_path), "%s/mb_bench.%d.log",
+             (dir != NULL && dir[0] != '\0') ? dir : "/tmp", (int)getpid());
+
+    datalog_init(&st->datalog);
+    datalog_configure(&st->datalog, DATALOG_FORMAT_BINARY, DATALOG_FLUSH_SIZE,
+                      DATALOG_DEFAULT_FLUSH_MS, DATALOG_DEFAULT_FLUSH_BYTES);
+    datalog_set_enabled(&st->datalog, true);
+    if (datalog_open(&st->datalog, st->datalog_path) != SUCCESS) {
+        return ERROR_IO;
+    }
+    st->dropped_base = atomic_load(&st->datalog.dropped);
+    return SUCCESS;
+}
+
+static size_t run_datalog(bench_state_t *st, const unsigned char *in, size_t len)
+{
+    datalog_write(&st->datalog, DATALOG_DIR_FROM_MODEM, in, len);
+    return len;
+}
+
+/* Let the writer empty the queue so every pass starts alike */
+static void finish_datalog(bench_state_t *st)
+{
+    uint64_t deadline = now_ns() + 5000000000ULL;
+
+    while (atomic_load(&st->datalog.dequeue_pos) != atomic_load(&st->datalog.enqueue_pos) &&
+           now_ns() < deadline) {
+        usleep(100);
+    }
+
+    uint64_t dropped = atomic_load(&st->datalog.dropped);
+    st->dropped = dropped - st->dropped_base;
+    st->dropped_base = dropped;
+}
+
+static void teardown_datalog(bench_state_t *st)
+{
+    datalog_close(&st->datalog);
+    unlink(st->datalog_path);
+}
+
+static const bench_kernel_t bench_kernels[] = {
+    { "cbuf",       setup_cbuf,     run_cbuf,       drain_cbuf,     teardown_cbuf },
+    { "ts_cbuf",    setup_ts_cbuf,  run_ts_cbuf,    drain_ts_cbuf,  teardown_ts_cbuf },
+    { "telnet_in",  setup_telnet,   run_telnet_in,  NULL,           NULL },
+    { "telnet_out", setup_telnet,   run_telnet_out, NULL,           NULL },
+    { "ansi",       setup_ansi,     run_ansi,       NULL,           NULL },
+#ifdef ENABLE_LEVEL3
+    { "hayes",      setup_hayes,    run_hayes,      NULL,           NULL },
+    { "dbuf",       setup_dbuf,     run_dbuf,       drain_dbuf,     teardown_dbuf },
+#endif
+    { "datalog",    setup_datalog,  run_datalog,    finish_datalog, teardown_datalog },
+};
+
+/* ========== Measurement ========== */
+
+static size_t run_pass(const bench_kernel_t *k, bench_state_t *st, const bench_corpus_t *c)
+{
+    size_t out = 0;
+
+    for (size_t off = 0; off < c->len; off += g_chunk) {
+        out += k->run(st, c->data + off, MIN(g_chunk, c->len - off));
+    }
+    return out;
+}
+
+static int measure(const bench_kernel_t *k, bench_state_t *st, const bench_corpus_t *c,
+                   bench_result_t *res)
+{
+    static uint64_t ns[BENCH_MAX_RUNS], cyc[BENCH_MAX_RUNS];
+
+    memset(res, 0, sizeof(*res));
+    res->kernel = k->name;
+    res->corpus = c->name;
+    res->bytes = c->len;
+
+    if (k->setup(st) != SUCCESS) {
+        fprintf(g_report, "%s: setup failed\n", k->name);
+        return ERROR_GENERAL;
+    }
+
+    for (int i = 0; i < g_warmup; i++) {
+        run_pass(k, st, c);
+        if (k->finish != NULL) {
+            k->finish(st);
+        }
+    }
+
+    for (int i = 0; i < g_runs; i++) {
+        uint64_t t0 = now_ns();
+        uint64_t c0 = cycles();
+        res->out_bytes = run_pass(k, st, c);
+        cyc[i] = cycles() - c0;
+        ns[i] = now_ns() - t0;
+
+        /* Buffer drains belong to the pass; the datalog writer does not */
+        if (k->finish != NULL) {
+            k->finish(st);
+            if (k->run != run_datalog) {
+                ns[i] = now_ns() - t0;
+            }
+            res->dropped += st->dropped;
+            st->dropped = 0;
+        }
+    }
+
+    if (k->teardown != NULL) {
+        k->teardown(st);
+    }
+
+    uint64_t min_ns = ns[0];
+    for (int i = 1; i < g_runs; i++) {
+        min_ns = MIN(min_ns, ns[i]);
+    }
+    res->ns_per_byte = (double)median_u64(ns, g_runs) / (double)c->len;
+    res->ns_per_byte_min = (double)min_ns / (double)c->len;
+#ifdef BENCH_HAVE_TSC
+    res->cycles_per_byte = (double)median_u64(cyc, g_runs) / (double)c->len;
+#else
+    res->cycles_per_byte = -1.0;
+#endif
+    return SUCCESS;
+}
+
+/* ========== Reporting ========== */
+
+/* ns/byte of kernel/corpus in a previous result file, < 0 if absent */
+static double baseline_lookup(const char *path, const char *kernel, const char *corpus)
+{
+    FILE *in = (path != NULL) ? fopen(path, "r") : NULL;
+    char line[LINE_BUFFER_SIZE], k[64], c[64];
+    double value = -1.0, v;
+
+    if (in == NULL) {
+        return -1.0;
+    }
+    while (fgets(line, sizeof(line), in) != NULL) {
+        if (sscanf(line, " {\"kernel\": \"%63[^\"]\", \"corpus\": \"%63[^\"]\", %*[^n]ns_per_byte\": %lf",
+                   k, c, &v) == 3 && strcmp(k, kernel) == 0 && strcmp(c, corpus) == 0) {
+            value = v;
+            break;
+        }
+    }
+    fclose(in);
+    return value;
+}
+
+static void cpu_model(char *buf, size_t size)
+{
+    FILE *in = fopen("/proc/cpuinfo", "r");
+    char line[LINE_BUFFER_SIZE];
+
+    snprintf(buf, size, "unknown");
+    if (in == NULL) {
+        return;
+    }
+    while (fgets(line, sizeof(line), in) != NULL) {
+        char *colon = strchr(line, ':');
+        if (colon != NULL && strncmp(line, "model name", 10) == 0) {
+            colon++;
+            while (*colon == ' ') {
+                colon++;
+            }
+            colon[strcspn(colon, "\n")] = '\0';
+            snprintf(buf, size, "%s", colon);
+            break;
+        }
+    }
+    fclose(in);
+}
+
+/* Copy s without the characters JSON would need escaped */
+static const char *json_safe(const char *s, char *buf, size_t size)
+{
+    size_t n = 0;
+
+    for (; *s != '\0' && n + 1 < size; s++) {
+        if (*s != '"' && *s != '\\' && (unsigned char)*s >= 0x20) {
+            buf[n++] = *s;
+        }
+    }
+    buf[n] = '\0';
+    return buf;
+}
+
+static int write_json(const char *path, const bench_result_t *res, size_t count, int cpu)
+{
+    FILE *out = fopen(path, "w");
+    char model[128], safe[256];
+    struct utsname uts;
+    time_t now = time(NULL);
+    char date[32];
+
+    if (out == NULL) {
+        fprintf(g_report, "Cannot write %s: %s\n", path, strerror(errno));
+        return ERROR_IO;
+    }
+
+    cpu_model(model, sizeof(model));
+    uname(&uts);
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"label\": \"%s\",\n", json_safe(g_label, safe, sizeof(safe)));
+    fprintf(out, "  \"date\": \"%s\",\n", date);
+#ifdef ENABLE_LEVEL3
+    fprintf(out, "  \"build\": \"level3\",\n");
+#else
+    fprintf(out, "  \"build\": \"level2\",\n");
+#endif
+    fprintf(out, "  \"compiler\": \"%s\",\n", json_safe(__VERSION__, safe, sizeof(safe)));
+    fprintf(out, "  \"host\": \"%s %s\",\n", json_safe(uts.sysname, safe, sizeof(safe)), uts.release);
+    fprintf(out, "  \"cpu_model\": \"%s\",\n", json_safe(model, safe, sizeof(safe)));
+    fprintf(out, "  \"cpu\": %d,\n", cpu);
+    fprintf(out, "  \"chunk\": %zu,\n", g_chunk);
+    fprintf(out, "  \"runs\": %d,\n", g_runs);
+    fprintf(out, "  \"warmup\": %d,\n", g_warmup);
+    fprintf(out, "  \"results\": [\n");
+    for (size_t i = 0; i < count; i++) {
+        const bench_result_t *r = &res[i];
+        fprintf(out, "    {\"kernel\": \"%s\", \"corpus\": \"%s\", \"bytes\": %zu, \"out_bytes\": %zu, "
+                "\"ns_per_byte\": %.4f, \"ns_per_byte_min\": %.4f, ",
+                r->kernel, r->corpus, r->bytes, r->out_bytes, r->ns_per_byte, r->ns_per_byte_min);
+        if (r->cycles_per_byte >= 0) {
+            fprintf(out, "\"cycles_per_byte\": %.4f, ", r->cycles_per_byte);
+        } else {
+            fprintf(out, "\"cycles_per_byte\": null, ");
+        }
+        fprintf(out, "\"mb_per_s\": %.1f, \"dropped\": %llu}%s\n",
+                1000.0 / r->ns_per_byte, (unsigned long long)r->dropped,
+                (i + 1 < count) ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+
+    fclose(out);
+    return SUCCESS;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  -c CPU      Pin to this CPU (default: the CPU it starts on)\n"
+            "  -k BYTES    Chunk size per kernel call (default %zu)\n"
+            "  -m KIB      Corpus size (default %zu)\n"
+            "  -r RUNS     Timed passes per kernel/corpus (default %d)\n"
+            "  -w PASSES   Warm-up passes (default %d)\n"
+            "  -s LIST     Kernels to run (default all)\n"
+            "  -l LABEL    Build label stored in the JSON output\n"
+            "  -o FILE     Write results as JSON\n"
+            "  -C FILE     Compare with a previous JSON result file\n",
+            prog, g_chunk, g_corpus_kib, g_runs, g_warmup);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *json_path = NULL;
+    const char *base_path = NULL;
+    int c;
+
+    while ((c = getopt(argc, argv, "c:k:m:r:w:s:l:o:C:h")) != -1) {
+        switch (c) {
+            case 'c': g_cpu = atoi(optarg); break;
+            case 'k': g_chunk = (size_t)atol(optarg); break;
+            case 'm': g_corpus_kib = (size_t)atol(optarg); break;
+            case 'r': g_runs = atoi(optarg); break;
+            case 'w': g_warmup = atoi(optarg); break;
+            case 's': g_only = optarg; break;
+            case 'l': g_label = optarg; break;
+            case 'o': json_path = optarg; break;
+            case 'C': base_path = optarg; break;
+            default:
+                usage(argv[0]);
+                return (c == 'h') ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+    if (g_chunk == 0 || g_chunk > UINT16_MAX || g_corpus_kib == 0 ||
+        g_runs < 1 || g_runs > BENCH_MAX_RUNS || g_warmup < 0) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    /* Pin before anything is allocated or timed */
+    if (g_cpu < 0) {
+        g_cpu = sched_getcpu();
+    }
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(g_cpu, &cpus);
+    if (sched_setaffinity(0, sizeof(cpus), &cpus) < 0) {
+        fprintf(stderr, "Cannot pin to CPU %d: %s (timing will be noisier)\n", g_cpu, strerror(errno));
+        g_cpu = -1;
+    }
+
+    /* The bridge code is chatty on stdout; keep the report readable */
+    g_report = fdopen(dup(STDOUT_FILENO), "w");
+    int devnull = open("/dev/null", O_WRONLY);
+    if (g_report == NULL || devnull < 0) {
+        return EXIT_FAILURE;
+    }
+    fflush(stdout);
+    dup2(devnull, STDOUT_FILENO);
+    close(devnull);
+
+    bench_corpus_t corpora[4];
+    size_t cap = g_corpus_kib * 1024;
+    corpus_build(&corpora[0], "ascii", cap, corpus_ascii);
+    corpus_build(&corpora[1], "ansi", cap, corpus_ansi);
+    corpus_build(&corpora[2], "iac", cap, corpus_iac);
+    corpus_build(&corpora[3], "binary", cap, corpus_binary);
+
+    static bench_state_t st;
+    st.out_size = g_chunk * 2;      /* IAC escaping at most doubles a chunk */
+    st.out = malloc(st.out_size);
+    st.drain = malloc(g_chunk);
+    if (st.out == NULL || st.drain == NULL) {
+        return EXIT_FAILURE;
+    }
+
+    fprintf(g_report, "CPU %d, chunk %zu bytes, corpus %zu KiB, %d runs after %d warm-up\n\n",
+            g_cpu, g_chunk, g_corpus_kib, g_runs, g_warmup);
+    fprintf(g_report, "%-12s %-8s %10s %10s %10s %10s%s\n", "kernel", "corpus", "ns/byte",
+            "min", "cyc/byte", "MB/s", base_path != NULL ? "   vs base" : "");
+
+    static bench_result_t results[BENCH_MAX_RESULTS];
+    size_t count = 0;
+    int status = EXIT_SUCCESS;
+
+    for (size_t k = 0; k < ARRAY_SIZE(bench_kernels); k++) {
+        if (!selected(bench_kernels[k].name)) {
+            continue;
+        }
+        for (size_t i = 0; i < ARRAY_SIZE(corpora) && count < BENCH_MAX_RESULTS; i++) {
+            bench_result_t *r = &results[count];
+            if (measure(&bench_kernels[k], &st, &corpora[i], r) != SUCCESS) {
+                status = EXIT_FAILURE;
+                break;
+            }
+            count++;
+
+            fprintf(g_report, "%-12s %-8s %10.3f %10.3f ", r->kernel, r->corpus,
+                    r->ns_per_byte, r->ns_per_byte_min);
+            if (r->cycles_per_byte >= 0) {
+                fprintf(g_report, "%10.3f", r->cycles_per_byte);
+            } else {
+                fprintf(g_report, "%10s", "-");
+            }
+            fprintf(g_report, " %10.1f", 1000.0 / r->ns_per_byte);
+            double base = baseline_lookup(base_path, r->kernel, r->corpus);
+            if (base > 0) {
+                fprintf(g_report, "   %+6.1f%%", (r->ns_per_byte / base - 1.0) * 100.0);
+            }
+            if (r->dropped > 0) {
+                fprintf(g_report, "   (%llu records dropped)", (unsigned long long)r->dropped);
+            }
+            fprintf(g_report, "\n");
+            fflush(g_report);
+        }
+    }
+
+    if (json_path != NULL && count > 0) {
+        if (write_json(json_path, results, count, g_cpu) == SUCCESS) {
+            fprintf(g_report, "\nResults: %s\n", json_path);
+        } else {
+            status = EXIT_FAILURE;
+        }
+    }
+
+    for (size_t i = 0; i < ARRAY_SIZE(corpora); i++) {
+        free(corpora[i].data);
+    }
+    free(st.out);
+    free(st.drain);
+    fclose(g_report);
+    return status;
+}
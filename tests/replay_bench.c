@@ -0,0 +1,850 @@
+/*
+ * replay_bench.c - Session capture/replay benchmark for ModemBridge
+ *
+ * Replays a captured session through the byte pipeline without modem
+ * hardware, so throughput and latency regressions show up before a
+ * build goes onto the modem bank.
+ *
+ * Capture: run modembridge with DATA_LOG_ENABLED=1 (DATA_LOG_FORMAT=binary
+ * keeps the microsecond record timing; text logs are accepted too).
+ * from_modem records feed the serial->telnet direction, from_telnet
+ * records the telnet->serial direction.
+ *
+ * Stages:
+ *   telnet  telnet_process_input() + ANSI passthrough (telnet->serial)
+ *   ansi    ansi_filter_modem_to_telnet() (serial->telnet), checked byte
+ *           for byte against a per-byte reference of the same state machine
+ *   l3      l3_pipeline_process() in both directions (Level 3 builds)
+ *   e2e     pty-backed fake modem answers RING/ATA for modem_wait_for_ring()
+ *           and modem_answer_call(), then the real serial and telnet thread
+ *           passes move the capture between the pty and a socketpair
+ *           (needs the serial thread, i.e. a Level 3 build)
+ *
+ * Pacing: full speed (default), simulated line rate (-b BAUD, 8N1), or the
+ * captured record timing (-t). In-process stages always run at full speed
+ * and apply the pacing model to their measured service times.
+ *
+ * Build: make replay
+ * Usage: build/mb_replay [-b baud] [-t] [-n repeat] [-s telnet,ansi,l3,e2e] capture.log
+ */
+
+#include "common.h"
+#include "config.h"
+#include "serial.h"
+#include "modem.h"
+#include "telnet.h"
+#include "bridge.h"
+#include "datalog.h"
+#ifdef ENABLE_LEVEL3
+#include "level3.h"
+#endif
+#include <fcntl.h>
+#include <getopt.h>
+#include <poll.h>
+#include <sys/socket.h>
+
+#ifndef ENABLE_LEVEL2
+#error "replay_bench needs a Level 2 or Level 3 build (telnet support)"
+#endif
+
+#define REPLAY_IDLE_MS      500     /* End a phase after this long without output */
+#define HIST_SUB_BITS       4       /* 16 sub-buckets per power of two (~6% resolution) */
+#define HIST_BUCKETS        (64 << HIST_SUB_BITS)
+
+/* One captured record */
+typedef struct {
+    uint64_t ts_us;                 /* Capture timestamp */
+    size_t off;                     /* Offset in stream data */
+    size_t len;
+} replay_chunk_t;
+
+/* One direction of a capture */
+typedef struct {
+    unsigned char *data;
+    size_t len, cap;
+    replay_chunk_t *chunks;
+    size_t count, chunk_cap;
+} replay_stream_t;
+
+/* Log-linear latency histogram (ns) */
+typedef struct {
+    uint64_t counts[HIST_BUCKETS];
+    uint64_t total;
+} replay_hist_t;
+
+/* Stage result */
+typedef struct {
+    const char *name;
+    size_t bytes_in;
+    size_t bytes_out;
+    double seconds;                 /* Busy (in-process) or wall time (e2e) */
+    double cpu_ms;
+    replay_hist_t hist;
+} replay_result_t;
+
+/* Options */
+static int g_baud = 0;              /* 0 = full speed */
+static bool g_capture_timing = false;
+static FILE *g_report;              /* Report stream (stdout is silenced) */
+
+/* ========== Helpers ========== */
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t clock_ns(clockid_t clk)
+{
+    struct timespec ts;
+
+    clock_gettime(clk, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void hist_add(replay_hist_t *h, uint64_t v, uint64_t count)
+{
+    size_t idx;
+
+    if (v < (1u << HIST_SUB_BITS)) {
+        idx = (size_t)v;
+    } else {
+        int e = 63 - __builtin_clzll(v);
+        idx = ((size_t)(e - HIST_SUB_BITS + 1) << HIST_SUB_BITS) |
+              (size_t)((v >> (e - HIST_SUB_BITS)) & ((1u << HIST_SUB_BITS) - 1));
+    }
+
+    h->counts[MIN(idx, (size_t)HIST_BUCKETS - 1)] += count;
+    h->total += count;
+}
+
+/* Lower bound of the bucket holding quantile q */
+static uint64_t hist_quantile(const replay_hist_t *h, double q)
+{
+    uint64_t want = (uint64_t)(q * (double)h->total);
+    uint64_t seen = 0;
+
+    for (size_t idx = 0; idx < HIST_BUCKETS; idx++) {
+        seen += h->counts[idx];
+        if (h->total > 0 && seen > want) {
+            if (idx < (1u << HIST_SUB_BITS)) {
+                return idx;
+            }
+            size_t e = (idx >> HIST_SUB_BITS) + HIST_SUB_BITS - 1;
+            uint64_t sub = idx & ((1u << HIST_SUB_BITS) - 1);
+            return (1ULL << e) | (sub << (e - HIST_SUB_BITS));
+        }
+    }
+
+    return 0;
+}
+
+/* ========== Capture Loading ========== */
+
+static void stream_append(replay_stream_t *s, uint64_t ts_us, const unsigned char *data,
+                          size_t len, bool extend)
+{
+    if (s->len + len > s->cap) {
+        s->cap = MAX(s->cap * 2, s->len + len + 65536);
+        s->data = realloc(s->data, s->cap);
+    }
+    memcpy(s->data + s->len, data, len);
+
+    if (extend && s->count > 0) {
+        s->chunks[s->count - 1].len += len;
+    } else {
+        if (s->count == s->chunk_cap) {
+            s->chunk_cap = MAX(s->chunk_cap * 2, 1024);
+            s->chunks = realloc(s->chunks, s->chunk_cap * sizeof(replay_chunk_t));
+        }
+        s->chunks[s->count++] = (replay_chunk_t){ ts_us, s->len, len };
+    }
+
+    s->len += len;
+}
+
+static int load_binary(const char *path, replay_stream_t *s2t, replay_stream_t *t2s)
+{
+    FILE *in = datalog_open_binary(path);
+    datalog_record_hdr_t hdr;
+    char label[DATALOG_LABEL_MAX];
+    static unsigned char data[UINT16_MAX];
+    int ret;
+
+    if (in == NULL) {
+        return ERROR_IO;
+    }
+
+    while ((ret = datalog_read_record(in, &hdr, label, data)) > 0) {
+        if (hdr.type != DATALOG_REC_DATA) {
+            continue;
+        }
+        if (hdr.direction == DATALOG_DIR_FROM_MODEM) {
+            stream_append(s2t, hdr.timestamp_us, data, hdr.length, false);
+        } else if (hdr.direction == DATALOG_DIR_FROM_TELNET) {
+            stream_append(t2s, hdr.timestamp_us, data, hdr.length, false);
+        }
+    }
+
+    fclose(in);
+    return ret < 0 ? ERROR_IO : SUCCESS;
+}
+
+/*
+ * Text logs: "[YYYY-mm-dd HH:MM:SS][direction] hex... | ascii"
+ * A full 16-byte line continues the record of the previous line.
+ */
+static int load_text(const char *path, replay_stream_t *s2t, replay_stream_t *t2s)
+{
+    FILE *in = fopen(path, "r");
+    char line[LINE_BUFFER_SIZE];
+    replay_stream_t *open_stream = NULL;
+
+    if (in == NULL) {
+        return ERROR_IO;
+    }
+
+    while (fgets(line, sizeof(line), in) != NULL) {
+        struct tm tm_info;
+        unsigned char bytes[16];
+        size_t count = 0;
+
+        memset(&tm_info, 0, sizeof(tm_info));
+        char *p = (line[0] == '[') ? strptime(line + 1, "%Y-%m-%d %H:%M:%S", &tm_info) : NULL;
+        if (p == NULL || strncmp(p, "][", 2) != 0) {
+            open_stream = NULL;
+            continue;
+        }
+
+        p += 2;
+        replay_stream_t *s = NULL;
+        if (strncmp(p, "from_modem]", 11) == 0) {
+            s = s2t;
+        } else if (strncmp(p, "from_telnet]", 12) == 0) {
+            s = t2s;
+        }
+        p = strchr(p, ']');
+        if (s == NULL || p == NULL) {
+            open_stream = NULL;
+            continue;
+        }
+
+        for (p++; count < sizeof(bytes); ) {
+            unsigned int v;
+            int used;
+            while (*p == ' ') {
+                p++;
+            }
+            if (*p == '|' || sscanf(p, "%2x%n", &v, &used) != 1) {
+                break;
+            }
+            bytes[count++] = (unsigned char)v;
+            p += used;
+        }
+
+        tm_info.tm_isdst = -1;
+        uint64_t ts_us = (uint64_t)mktime(&tm_info) * 1000000ULL;
+        stream_append(s, ts_us, bytes, count, open_stream == s);
+        open_stream = (count == sizeof(bytes)) ? s : NULL;
+    }
+
+    fclose(in);
+    return SUCCESS;
+}
+
+/* Append the stream to itself so short captures give stable numbers */
+static void stream_repeat(replay_stream_t *s, int times)
+{
+    size_t base_count = s->count;
+    uint64_t span = (base_count > 0) ?
+        s->chunks[base_count - 1].ts_us - s->chunks[0].ts_us + 1000 : 0;
+
+    for (int r = 1; r < times; r++) {
+        for (size_t c = 0; c < base_count; c++) {
+            replay_chunk_t ch = s->chunks[c];
+            stream_append(s, ch.ts_us + span * (uint64_t)r, s->data + ch.off, ch.len, false);
+        }
+    }
+}
+
+/* ========== Pacing Model ========== */
+
+/* Time (relative to t0) at which byte i of the stream has fully arrived */
+static uint64_t scheduled_ns(const replay_stream_t *s, size_t chunk, size_t byte)
+{
+    if (g_baud > 0) {
+        return (uint64_t)(byte + 1) * 10ULL * 1000000000ULL / (uint64_t)g_baud;
+    }
+    if (g_capture_timing) {
+        return (s->chunks[chunk].ts_us - s->chunks[0].ts_us) * 1000ULL;
+    }
+    return 0;
+}
+
+static bool paced(void)
+{
+    return g_baud > 0 || g_capture_timing;
+}
+
+/* ========== In-process Stages ========== */
+
+typedef size_t (*replay_filter_fn)(void *state, const unsigned char *in, size_t len,
+                                   unsigned char *out, size_t out_size);
+
+static size_t filter_telnet(void *state, const unsigned char *in, size_t len,
+                            unsigned char *out, size_t out_size)
+{
+    size_t processed_len = 0, output_len = 0;
+
+    telnet_process_input((telnet_t *)state, in, len, out, out_size, &processed_len);
+    ansi_passthrough_telnet_to_modem(out, processed_len, out, out_size, &output_len);
+    return output_len;
+}
+
+static size_t filter_ansi(void *state, const unsigned char *in, size_t len,
+                          unsigned char *out, size_t out_size)
+{
+    size_t output_len = 0;
+
+    ansi_filter_modem_to_telnet(in, len, out, out_size, &output_len, (ansi_state_t *)state);
+    return output_len;
+}
+
+/* One byte at a time, one switch per byte: the engine the table replaced */
+static size_t filter_ansi_reference(void *state, const unsigned char *in, size_t len,
+                                    unsigned char *out, size_t out_size)
+{
+    ansi_state_t *st = (ansi_state_t *)state;
+    size_t out_pos = 0;
+
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = in[i];
+        bool param = (c >= 0x30 && c <= 0x3F);
+
+        switch (*st) {
+            case ANSI_STATE_NORMAL:
+                if (c == 0x1B) {
+                    *st = ANSI_STATE_ESC;
+                } else if (out_pos < out_size) {
+                    out[out_pos++] = c;
+                }
+                break;
+            case ANSI_STATE_ESC:
+                *st = (c == '[') ? ANSI_STATE_CSI : ANSI_STATE_NORMAL;
+                break;
+            case ANSI_STATE_CSI:
+            case ANSI_STATE_CSI_PARAM:
+                *st = param ? ANSI_STATE_CSI_PARAM : ANSI_STATE_NORMAL;
+                break;
+            default:
+                *st = ANSI_STATE_NORMAL;
+                break;
+        }
+    }
+    return out_pos;
+}
+
+/*
+ * Run both ANSI engines over the stream and compare their output.
+ * Returns the offset of the first differing output byte, or -1.
+ */
+static long ansi_compare(const replay_stream_t *s)
+{
+    static unsigned char out_a[UINT16_MAX], out_b[UINT16_MAX];
+    ansi_state_t st_a = ANSI_STATE_NORMAL, st_b = ANSI_STATE_NORMAL;
+    long offset = 0;
+
+    for (size_t c = 0; c < s->count; c++) {
+        const replay_chunk_t *ch = &s->chunks[c];
+        size_t len_a = filter_ansi(&st_a, s->data + ch->off, ch->len, out_a, sizeof(out_a));
+        size_t len_b = filter_ansi_reference(&st_b, s->data + ch->off, ch->len, out_b, sizeof(out_b));
+
+        for (size_t i = 0; i < MAX(len_a, len_b); i++) {
+            if (i >= len_a || i >= len_b || out_a[i] != out_b[i]) {
+                return offset + (long)i;
+            }
+        }
+        if (st_a != st_b) {
+            return offset + (long)len_a;
+        }
+        offset += (long)len_a;
+    }
+    return -1;
+}
+
+#ifdef ENABLE_LEVEL3
+static size_t filter_l3(void *state, const unsigned char *in, size_t len,
+                        unsigned char *out, size_t out_size)
+{
+    size_t output_len = 0;
+
+    l3_pipeline_process((l3_pipeline_t *)state, in, len, out, out_size, &output_len);
+    return output_len;
+}
+#endif
+
+/*
+ * Run a filter over every chunk at full speed on a simulated timeline:
+ * a chunk starts when it has arrived and the previous one is done.
+ */
+static void run_inprocess(replay_result_t *res, const replay_stream_t *s,
+                          replay_filter_fn fn, void *state)
+{
+    static unsigned char out[UINT16_MAX * 2];
+    uint64_t sim_clock = 0, busy = 0;
+    uint64_t cpu_start = clock_ns(CLOCK_THREAD_CPUTIME_ID);
+
+    for (size_t c = 0; c < s->count; c++) {
+        const replay_chunk_t *ch = &s->chunks[c];
+        uint64_t ready = scheduled_ns(s, c, ch->off + ch->len - 1);
+        uint64_t start = MAX(ready, sim_clock);
+
+        uint64_t t0 = now_ns();
+        res->bytes_out += fn(state, s->data + ch->off, ch->len, out, sizeof(out));
+        uint64_t service = now_ns() - t0;
+
+        busy += service;
+        sim_clock = start + service;
+
+        if (g_baud > 0) {
+            for (size_t i = 0; i < ch->len; i++) {
+                hist_add(&res->hist, sim_clock - scheduled_ns(s, c, ch->off + i), 1);
+            }
+        } else {
+            hist_add(&res->hist, sim_clock - (paced() ? scheduled_ns(s, c, 0) : start), ch->len);
+        }
+    }
+
+    res->bytes_in = s->len;
+    res->seconds = busy / 1e9;
+    res->cpu_ms = (clock_ns(CLOCK_THREAD_CPUTIME_ID) - cpu_start) / 1e6;
+}
+
+/* ========== End-to-end (pty fake modem + socketpair) ========== */
+#ifdef BRIDGE_HAS_SERIAL_POLL
+
+static void sleep_until_ns(uint64_t deadline)
+{
+    struct timespec ts = {
+        .tv_sec = (time_t)(deadline / 1000000000ULL),
+        .tv_nsec = (long)(deadline % 1000000000ULL)
+    };
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+    }
+}
+
+typedef struct {
+    config_t cfg;
+    bridge_ctx_t bridge;
+    int master_fd;                  /* Fake modem side of the pty */
+    int remote_fd;                  /* Fake telnet server side of the socketpair */
+    pthread_t serial_thread;
+    pthread_t telnet_thread;
+    clockid_t serial_cpu, telnet_cpu;
+} replay_e2e_t;
+
+/* Feeder thread arguments */
+typedef struct {
+    const replay_stream_t *stream;
+    int fd;
+    uint64_t t0;
+    uint64_t *written_ns;           /* Per chunk: time the write started */
+    volatile bool done;
+} replay_feeder_t;
+
+static void write_all(int fd, const unsigned char *data, size_t len)
+{
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN) {
+                struct pollfd pfd = { .fd = fd, .events = POLLOUT };
+                poll(&pfd, 1, 100);
+                continue;
+            }
+            return;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+}
+
+/* Fake modem: RING twice, then answer ATA with CONNECT, OK to anything else */
+static void *fake_modem_answer(void *arg)
+{
+    replay_e2e_t *e = (replay_e2e_t *)arg;
+    char buf[256];
+    size_t len = 0;
+
+    for (int i = 0; i < 2; i++) {
+        usleep(100000);
+        write_all(e->master_fd, (const unsigned char *)"\r\nRING\r\n", 8);
+    }
+
+    uint64_t deadline = now_ns() + 10ULL * 1000000000ULL;
+    while (now_ns() < deadline) {
+        struct pollfd pfd = { .fd = e->master_fd, .events = POLLIN };
+        if (poll(&pfd, 1, 100) <= 0) {
+            continue;
+        }
+        ssize_t n = read(e->master_fd, buf + len, sizeof(buf) - 1 - len);
+        if (n <= 0) {
+            continue;
+        }
+        len += (size_t)n;
+        buf[len] = '\0';
+
+        char *cr = strchr(buf, '\r');
+        if (cr == NULL) {
+            if (len == sizeof(buf) - 1) {
+                len = 0;
+            }
+            continue;
+        }
+
+        if (strstr(buf, "ATA") != NULL) {
+            char reply[64];
+            int rlen = snprintf(reply, sizeof(reply), "\r\nCONNECT %d\r\n",
+                                e->cfg.baudrate_value);
+            write_all(e->master_fd, (const unsigned char *)reply, (size_t)rlen);
+            return NULL;
+        }
+        write_all(e->master_fd, (const unsigned char *)"\r\nOK\r\n", 6);
+        len = 0;
+    }
+
+    return NULL;
+}
+
+static void *feeder_func(void *arg)
+{
+    replay_feeder_t *f = (replay_feeder_t *)arg;
+    const replay_stream_t *s = f->stream;
+
+    for (size_t c = 0; c < s->count; c++) {
+        const replay_chunk_t *ch = &s->chunks[c];
+        if (paced()) {
+            sleep_until_ns(f->t0 + scheduled_ns(s, c, ch->off + ch->len - 1));
+        }
+        f->written_ns[c] = now_ns();
+        write_all(f->fd, s->data + ch->off, ch->len);
+    }
+
+    f->done = true;
+    return NULL;
+}
+
+static int e2e_setup(replay_e2e_t *e)
+{
+    int sv[2];
+    int speed = -1;
+    pthread_t answer;
+
+    memset(e, 0, sizeof(*e));
+    e->master_fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (e->master_fd < 0 || grantpt(e->master_fd) < 0 || unlockpt(e->master_fd) < 0) {
+        fprintf(g_report, "e2e: cannot create pty: %s\n", strerror(errno));
+        return ERROR_IO;
+    }
+
+    config_init(&e->cfg);
+    SAFE_STRNCPY(e->cfg.serial_port, ptsname(e->master_fd), sizeof(e->cfg.serial_port));
+    e->cfg.echo_enabled = false;
+    e->cfg.data_log_enabled = false;
+
+    bridge_init(&e->bridge, &e->cfg);
+    if (serial_open(&e->bridge.serial, e->cfg.serial_port, &e->cfg) != SUCCESS) {
+        fprintf(g_report, "e2e: cannot open %s\n", e->cfg.serial_port);
+        return ERROR_IO;
+    }
+    modem_init(&e->bridge.modem, &e->bridge.serial);
+
+    /* Call setup through the real modem_sample-style helpers */
+    pthread_create(&answer, NULL, fake_modem_answer, e);
+    int ret = modem_wait_for_ring(&e->bridge.modem, 10, &speed);
+    if (ret == SUCCESS) {
+        ret = modem_answer_call(&e->bridge.modem, &speed);
+    }
+    pthread_join(answer, NULL);
+    if (ret != SUCCESS) {
+        fprintf(g_report, "e2e: fake modem handshake failed (%d)\n", ret);
+        return ret;
+    }
+    modem_go_online(&e->bridge.modem);
+
+    /* Telnet server side: a socketpair stands in for the BBS */
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) < 0) {
+        fprintf(g_report, "e2e: socketpair failed: %s\n", strerror(errno));
+        return ERROR_IO;
+    }
+    fcntl(sv[0], F_SETFL, fcntl(sv[0], F_GETFL) | O_NONBLOCK);
+    e->bridge.telnet.fd = sv[0];
+    e->bridge.telnet.is_connected = true;
+    e->remote_fd = sv[1];
+
+    e->bridge.serial_ready = true;
+    e->bridge.modem_ready = true;
+    e->bridge.serial_health_checked = true;
+    e->bridge.state = STATE_CONNECTED;
+    e->bridge.thread_running = true;
+
+    pthread_create(&e->serial_thread, NULL, serial_modem_thread_func, &e->bridge);
+    pthread_create(&e->telnet_thread, NULL, telnet_thread_func, &e->bridge);
+    pthread_getcpuclockid(e->serial_thread, &e->serial_cpu);
+    pthread_getcpuclockid(e->telnet_thread, &e->telnet_cpu);
+
+    return SUCCESS;
+}
+
+static void e2e_teardown(replay_e2e_t *e)
+{
+    if (e->bridge.thread_running) {
+        e->bridge.thread_running = false;
+        pthread_join(e->serial_thread, NULL);
+        pthread_join(e->telnet_thread, NULL);
+    }
+    if (e->bridge.telnet.fd >= 0) {
+        close(e->bridge.telnet.fd);
+        e->bridge.telnet.fd = -1;
+    }
+    if (e->remote_fd > 0) {
+        close(e->remote_fd);
+    }
+    serial_close(&e->bridge.serial);
+    if (e->master_fd >= 0) {
+        close(e->master_fd);
+    }
+}
+
+/*
+ * Push one stream in at in_fd and collect at out_fd. Output byte k is
+ * matched to input byte k * bytes_in / bytes_out, which is exact unless
+ * the filters drop or expand bytes.
+ */
+static void run_e2e(replay_e2e_t *e, replay_result_t *res, const replay_stream_t *s,
+                    int in_fd, int out_fd)
+{
+    static unsigned char buf[65536];
+    size_t event_cap = 4096, events = 0;
+    struct { uint64_t t; size_t n; } *ev = malloc(event_cap * sizeof(*ev));
+    replay_feeder_t feeder = {
+        .stream = s, .fd = in_fd, .written_ns = calloc(s->count + 1, sizeof(uint64_t))
+    };
+    pthread_t feeder_thread;
+
+    uint64_t cpu_start = clock_ns(e->serial_cpu) + clock_ns(e->telnet_cpu);
+    feeder.t0 = now_ns();
+    pthread_create(&feeder_thread, NULL, feeder_func, &feeder);
+
+    uint64_t last_out = feeder.t0;
+    for (;;) {
+        struct pollfd pfd = { .fd = out_fd, .events = POLLIN };
+        if (poll(&pfd, 1, 50) > 0) {
+            ssize_t n = read(out_fd, buf, sizeof(buf));
+            if (n > 0) {
+                if (events == event_cap) {
+                    event_cap *= 2;
+                    ev = realloc(ev, event_cap * sizeof(*ev));
+                }
+                last_out = now_ns();
+                ev[events].t = last_out;
+                ev[events].n = (size_t)n;
+                events++;
+                res->bytes_out += (size_t)n;
+                continue;
+            }
+        }
+        if (feeder.done && now_ns() - MAX(last_out, feeder.written_ns[s->count - 1]) >
+                           REPLAY_IDLE_MS * 1000000ULL) {
+            break;
+        }
+    }
+
+    pthread_join(feeder_thread, NULL);
+    res->cpu_ms = (clock_ns(e->serial_cpu) + clock_ns(e->telnet_cpu) - cpu_start) / 1e6;
+    res->bytes_in = s->len;
+    res->seconds = (last_out - feeder.t0) / 1e9;
+
+    /* Per-byte latency against the input byte each output byte maps to */
+    size_t out_pos = 0, chunk = 0;
+    for (size_t i = 0; i < events && res->bytes_out > 0; i++) {
+        for (size_t k = 0; k < ev[i].n; k++, out_pos++) {
+            size_t in_byte = (size_t)((unsigned __int128)out_pos * s->len / res->bytes_out);
+            while (chunk + 1 < s->count && s->chunks[chunk + 1].off <= in_byte) {
+                chunk++;
+            }
+            uint64_t arrived = feeder.written_ns[chunk];
+            if (g_baud > 0) {
+                arrived = feeder.t0 + scheduled_ns(s, chunk, in_byte);
+            }
+            hist_add(&res->hist, ev[i].t > arrived ? ev[i].t - arrived : 0, 1);
+        }
+    }
+
+    free(feeder.written_ns);
+    free(ev);
+}
+
+#endif /* BRIDGE_HAS_SERIAL_POLL */
+
+/* ========== Report ========== */
+
+static void print_result(const replay_result_t *r)
+{
+    double rate = r->seconds > 0 ? r->bytes_in / r->seconds : 0.0;
+
+    fprintf(g_report, "%-22s %10zu %10zu %14.0f %10.1f %10.1f %9.1f\n",
+            r->name, r->bytes_in, r->bytes_out, rate,
+            hist_quantile(&r->hist, 0.50) / 1000.0,
+            hist_quantile(&r->hist, 0.99) / 1000.0, r->cpu_ms);
+}
+
+static void print_usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [options] capture.log\n"
+            "  -b BAUD    Simulate line rate (8N1), default: full speed\n"
+            "  -t         Replay with captured record timing (binary captures)\n"
+            "  -n N       Repeat the capture N times\n"
+            "  -s LIST    Stages: telnet,ansi,l3,e2e (default: all)\n", prog);
+}
+
+int main(int argc, char *argv[])
+{
+    replay_stream_t s2t = {0}, t2s = {0};
+    const char *stages = "telnet,ansi,l3,e2e";
+    int repeat = 1;
+    int c;
+
+    while ((c = getopt(argc, argv, "b:tn:s:h")) != -1) {
+        switch (c) {
+            case 'b': g_baud = atoi(optarg); break;
+            case 't': g_capture_timing = true; break;
+            case 'n': repeat = MAX(atoi(optarg), 1); break;
+            case 's': stages = optarg; break;
+            default:
+                print_usage(argv[0]);
+                return c == 'h' ? 0 : 1;
+        }
+    }
+    if (optind >= argc) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    int ret = load_binary(argv[optind], &s2t, &t2s);
+    if (ret != SUCCESS && errno == EINVAL) {
+        ret = load_text(argv[optind], &s2t, &t2s);
+    }
+    if (ret != SUCCESS) {
+        fprintf(stderr, "Cannot load capture %s: %s\n", argv[optind], strerror(errno));
+        return 1;
+    }
+    stream_repeat(&s2t, repeat);
+    stream_repeat(&t2s, repeat);
+
+    /* The bridge code is chatty on stdout; keep the report readable */
+    g_report = fdopen(dup(STDOUT_FILENO), "w");
+    int devnull = open("/dev/null", O_WRONLY);
+    if (g_report == NULL || devnull < 0) {
+        return 1;
+    }
+    fflush(stdout);
+    dup2(devnull, STDOUT_FILENO);
+    close(devnull);
+    openlog("mb_replay", LOG_PID, LOG_USER);
+    setlogmask(LOG_UPTO(LOG_WARNING));
+
+    fprintf(g_report, "Capture: %s (serial->telnet %zu bytes/%zu records, telnet->serial %zu bytes/%zu records)\n",
+            argv[optind], s2t.len, s2t.count, t2s.len, t2s.count);
+    if (g_baud > 0) {
+        fprintf(g_report, "Pacing:  %d bps (8N1)\n\n", g_baud);
+    } else {
+        fprintf(g_report, "Pacing:  %s\n\n", g_capture_timing ? "captured timing" : "full speed");
+    }
+    fprintf(g_report, "%-22s %10s %10s %14s %10s %10s %9s\n",
+            "stage", "bytes_in", "bytes_out", "bytes/s", "p50_us", "p99_us", "cpu_ms");
+
+    if (strstr(stages, "telnet") != NULL && t2s.count > 0) {
+        telnet_t tn;
+        replay_result_t r = { .name = "telnet t2s" };
+        telnet_init(&tn);
+        run_inprocess(&r, &t2s, filter_telnet, &tn);
+        print_result(&r);
+    }
+
+    if (strstr(stages, "ansi") != NULL && s2t.count > 0) {
+        ansi_state_t st = ANSI_STATE_NORMAL;
+        replay_result_t r = { .name = "ansi s2t" };
+        replay_result_t ref = { .name = "ansi s2t (reference)" };
+
+        run_inprocess(&r, &s2t, filter_ansi, &st);
+        print_result(&r);
+        st = ANSI_STATE_NORMAL;
+        run_inprocess(&ref, &s2t, filter_ansi_reference, &st);
+        print_result(&ref);
+
+        long diff = ansi_compare(&s2t);
+        if (diff >= 0) {
+            fprintf(g_report, "ansi: output differs from reference at byte %ld\n", diff);
+            fclose(g_report);
+            return 1;
+        }
+    }
+
+#ifdef ENABLE_LEVEL3
+    if (strstr(stages, "l3") != NULL) {
+        static l3_pipeline_t pipe;
+        if (s2t.count > 0) {
+            replay_result_t r = { .name = "l3 s2t" };
+            l3_pipeline_init(&pipe, L3_PIPELINE_SERIAL_TO_TELNET, "replay-s2t", 0);
+            pipe.filter_state.hayes_ctx.in_online_mode = true;
+            run_inprocess(&r, &s2t, filter_l3, &pipe);
+            print_result(&r);
+            l3_double_buffer_destroy(&pipe.buffers);
+        }
+        if (t2s.count > 0) {
+            replay_result_t r = { .name = "l3 t2s" };
+            l3_pipeline_init(&pipe, L3_PIPELINE_TELNET_TO_SERIAL, "replay-t2s", 0);
+            run_inprocess(&r, &t2s, filter_l3, &pipe);
+            print_result(&r);
+            l3_double_buffer_destroy(&pipe.buffers);
+        }
+    }
+#endif
+
+    ret = SUCCESS;
+#ifdef BRIDGE_HAS_SERIAL_POLL
+    if (strstr(stages, "e2e") != NULL) {
+        static replay_e2e_t e;
+        ret = e2e_setup(&e);
+        if (ret == SUCCESS) {
+            if (s2t.count > 0) {
+                replay_result_t r = { .name = "e2e s2t (pty->sock)" };
+                run_e2e(&e, &r, &s2t, e.master_fd, e.remote_fd);
+                print_result(&r);
+            }
+            if (t2s.count > 0) {
+                replay_result_t r = { .name = "e2e t2s (sock->pty)" };
+                run_e2e(&e, &r, &t2s, e.remote_fd, e.master_fd);
+                print_result(&r);
+            }
+        }
+        e2e_teardown(&e);
+    }
+#else
+    if (strstr(stages, "e2e") != NULL) {
+        fprintf(g_report, "e2e: needs the serial thread (Level 3 build)\n");
+    }
+#endif
+
+    fclose(g_report);
+    return ret == SUCCESS ? 0 : 1;
+}